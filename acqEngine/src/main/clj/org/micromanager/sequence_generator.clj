@@ -218,24 +218,6 @@
 (defn sequence-fits-stage? [z-drive n-slices]
   (<= n-slices (.getStageSequenceMaxLength mmc z-drive)))
 
-(defn event-triggerable
-  "Returns true if an event can be added to a burst."
-  [burst event]
-  (let [n (count burst)
-        e1 (peek burst)
-        e2 event
-        channels (map :channel (conj burst event))
-        props (map :properties channels)]
-    (and
-      (channels-sequenceable (make-property-sequences props) channels)
-      (or (= (e1 :slice) (e2 :slice))
-          (when-let [z-drive (. mmc getFocusDevice)]
-            (and
-              (stage-sequenceable?)
-              (sequence-fits-stage? z-drive (inc n))
-              (<= (Math/abs (- (e1 :slice) (e2 :slice))) MAX-Z-TRIGGER-DIST)
-              (<= (e1 :slice-index) (e2 :slice-index))))))))
-  
 (defn burst-valid
   "Returns true if a pair of events can be included in the 
    same burst."
@@ -259,39 +241,162 @@
                    (not (all-equal? slices)))
           {:slices (when (-> events first :slice) slices)})))))
 
+(defn make-sequence-limits
+  "Returns a function that gives the maximum sequence length of a
+   [device property] pair, or nil if the property is not sequenceable.
+   The core is queried only once per property."
+  []
+  (let [cache (atom {})]
+    (fn [[d p :as k]]
+      (if (contains? @cache k)
+        (get @cache k)
+        (let [limit (when (core isPropertySequenceable d p)
+                      (core getPropertySequenceMaxLength d p))]
+          (swap! cache assoc k limit)
+          limit)))))
+
+(defn make-stage-limit
+  "Returns a delay holding the maximum sequence length of the focus
+   drive, or nil if it can't be sequenced."
+  []
+  (delay
+    (when (stage-sequenceable?)
+      (.getStageSequenceMaxLength mmc (.getFocusDevice mmc)))))
+
+(defn append-burst-properties
+  "Append the channel properties of the event at index n of a burst to the
+   running property sequences. Each sequence keeps its values (as a
+   transient vector, nil where a channel lacks the property), its first
+   value, and whether all values so far are equal."
+  [prop-states n properties]
+  (reduce
+    (fn [states k]
+      (let [v (get properties k)]
+        (assoc states k
+          (if-let [s (get states k)]
+            {:values (conj! (:values s) v)
+             :first (:first s)
+             :equal (and (:equal s) (= v (:first s)))}
+            {:values (conj! (transient (vec (repeat n nil))) v)
+             :first (when (zero? n) v)
+             :equal (or (zero? n) (nil? v))}))))
+    prop-states
+    (distinct (concat (keys prop-states) (keys properties)))))
+
+(defn burst-properties-triggerable?
+  "Returns true if all property sequences of a burst of n events can still
+   be triggered after appending the given channel properties."
+  [prop-states n properties limit-of]
+  (every?
+    (fn [k]
+      (let [v (get properties k)
+            s (get prop-states k)
+            equal (if s
+                    (and (:equal s) (= v (:first s)))
+                    (or (zero? n) (nil? v)))]
+        (or equal
+            (when-let [limit (limit-of k)]
+              (<= (inc n) limit)))))
+    (distinct (concat (keys prop-states) (keys properties)))))
+
+(defn start-burst
+  "Create the running state of a burst beginning with event."
+  [event]
+  {:events (transient [event])
+   :last event
+   :n 1
+   :properties (append-burst-properties {} 0 (-> event :channel :properties))
+   :exposure (-> event :channel :exposure)
+   :slices (transient [(:slice event)])
+   :first-slice (:slice event)
+   :slices-equal true})
+
+(defn burst-accepts?
+  "Returns true if an event can be added to a burst, given the running
+   burst state."
+  [state e2 limit-of stage-limit]
+  (let [n (:n state)
+        e1 (:last state)]
+    (and
+      (= (-> e2 :channel :exposure) (:exposure state))
+      (burst-properties-triggerable?
+        (:properties state) n (-> e2 :channel :properties) limit-of)
+      (or (= (e1 :slice) (e2 :slice))
+          (when-let [max-length @stage-limit]
+            (and
+              (<= (inc n) max-length)
+              (<= (Math/abs (- (e1 :slice) (e2 :slice))) MAX-Z-TRIGGER-DIST)
+              (<= (e1 :slice-index) (e2 :slice-index))))))))
+
+(defn add-burst-event
+  "Add an event to the running burst state."
+  [state event]
+  (let [n (:n state)
+        slice (:slice event)]
+    (assoc state
+      :events (conj! (:events state) event)
+      :last event
+      :n (inc n)
+      :properties (append-burst-properties
+                    (:properties state) n (-> event :channel :properties))
+      :slices (conj! (:slices state) slice)
+      :slices-equal (and (:slices-equal state)
+                         (= slice (:first-slice state))))))
+
+(defn burst-triggers
+  "Make the trigger sequences of a finished burst from its running state
+   (equivalent to make-triggers on the burst events)."
+  [state limit-of]
+  (merge
+    {:properties (into (sorted-map)
+                   (for [[k s] (:properties state)
+                         :when (and (not (:equal s)) (limit-of k))]
+                     [k (persistent! (:values s))]))}
+    (when-not (:slices-equal state)
+      {:slices (when (:first-slice state)
+                 (persistent! (:slices state)))})))
+
 (defn accumulate-burst-event
   "Accumulate a series of events into a burst as long
-   as possible. Returns a vector containing the burst 
-   event sequence followed by a sequence of events that
-   couldn't be included in the burst." 
-  [events]
+   as possible. Returns a vector containing the running
+   burst state followed by a sequence of events that
+   couldn't be included in the burst. Each event is
+   checked against the running state only, so building
+   a burst takes time linear in its length."
+  [events limit-of stage-limit]
   (loop [remaining-events (next events)
-         burst [(first events)]]
-    (let [e1 (last burst)
+         state (start-burst (first events))]
+    (let [e1 (:last state)
           e2 (first remaining-events)]
-      (if (and e1
+      (if (and e2
                (burst-valid e1 e2)
-               (event-triggerable burst e2))
+               (burst-accepts? state e2 limit-of stage-limit))
         (recur (next remaining-events)
-               (conj burst e2))
-        [burst remaining-events]))))
-      
+               (add-burst-event state e2))
+        [state remaining-events]))))
+
 (defn make-bursts
-  "Lazily convert a sequence of events into bursts, when possible."
-  [events]
-  (lazy-seq
-    (let [[burst later] (accumulate-burst-event events)]
-      (when burst
-        (cons
-          (if (< 1 (count burst))
-            (assoc (first burst)
-                   :task :burst
-                   :burst-data burst
-                   :burst-length (count burst)
-                   :trigger-sequence (make-triggers burst))
-            (assoc (first burst) :task :snap))
-          (when later
-            (make-bursts later)))))))
+  "Lazily convert a sequence of events into bursts, when possible.
+   Sequence limits of properties and focus drive are queried once
+   per call."
+  ([events]
+    (make-bursts events (make-sequence-limits) (make-stage-limit)))
+  ([events limit-of stage-limit]
+    (lazy-seq
+      (when (seq events)
+        (let [[state later] (accumulate-burst-event
+                              events limit-of stage-limit)
+              burst (persistent! (:events state))]
+          (cons
+            (if (< 1 (count burst))
+              (assoc (first burst)
+                     :task :burst
+                     :burst-data burst
+                     :burst-length (count burst)
+                     :trigger-sequence (burst-triggers state limit-of))
+              (assoc (first burst) :task :snap))
+            (when later
+              (make-bursts later limit-of stage-limit))))))))
 
 (defn add-next-task-tags
   "Attach a :next-frame-index entry to each event map."
@@ -0,0 +1,162 @@
+(ns org.micromanager.test.sequence-generator
+  (:use [clojure.test]
+        [org.micromanager.sequence-generator])
+  (:require [org.micromanager.mm :as mm])
+  (:import (java.util Random)))
+
+;; A stand-in for the core, answering only the queries needed to
+;; generate bursts. Calls are dispatched by reflection, just like
+;; the calls on the real CMMCore.
+
+(definterface FakeCore
+  (^String getFocusDevice [])
+  (^boolean isStageSequenceable [^String z-drive])
+  (^long getStageSequenceMaxLength [^String z-drive])
+  (^boolean isPropertySequenceable [^String d ^String p])
+  (^long getPropertySequenceMaxLength [^String d ^String p])
+  (^Object logMessage [^String msg ^boolean debug]))
+
+(defn fake-core
+  "Make a fake core. property-limits maps [device property] to the
+   maximum sequence length of sequenceable properties. queries counts
+   the property limit queries."
+  [stage-limit property-limits queries]
+  (reify FakeCore
+    (getFocusDevice [_] (if stage-limit "Z" ""))
+    (isStageSequenceable [_ z-drive] (boolean stage-limit))
+    (getStageSequenceMaxLength [_ z-drive] (or stage-limit 0))
+    (isPropertySequenceable [_ d p]
+      (swap! queries update-in [[d p]] (fnil inc 0))
+      (contains? property-limits [d p]))
+    (getPropertySequenceMaxLength [_ d p]
+      (get property-limits [d p] 0))
+    (logMessage [_ msg debug] nil)))
+
+(defmacro with-fake-core [stage-limit property-limits queries & body]
+  `(with-redefs [mm/mmc (fake-core ~stage-limit ~property-limits ~queries)]
+     ~@body))
+
+;; The burst builder as it was before it kept a running burst state,
+;; used as the reference implementation.
+
+(defn reference-event-triggerable
+  [burst event]
+  (let [n (count burst)
+        e1 (peek burst)
+        e2 event
+        channels (map :channel (conj burst event))
+        props (map :properties channels)]
+    (and
+      (channels-sequenceable (make-property-sequences props) channels)
+      (or (= (e1 :slice) (e2 :slice))
+          (when-let [z-drive (.getFocusDevice mm/mmc)]
+            (and
+              (stage-sequenceable?)
+              (sequence-fits-stage? z-drive (inc n))
+              (<= (Math/abs (- (e1 :slice) (e2 :slice))) MAX-Z-TRIGGER-DIST)
+              (<= (e1 :slice-index) (e2 :slice-index))))))))
+
+(defn reference-accumulate-burst-event
+  [events]
+  (loop [remaining-events (next events)
+         burst [(first events)]]
+    (let [e1 (last burst)
+          e2 (first remaining-events)]
+      (if (and e1
+               (burst-valid e1 e2)
+               (reference-event-triggerable burst e2))
+        (recur (next remaining-events)
+               (conj burst e2))
+        [burst remaining-events]))))
+
+(defn reference-make-bursts
+  [events]
+  (lazy-seq
+    (let [[burst later] (reference-accumulate-burst-event events)]
+      (when burst
+        (cons
+          (if (< 1 (count burst))
+            (assoc (first burst)
+                   :task :burst
+                   :burst-data burst
+                   :burst-length (count burst)
+                   :trigger-sequence (make-triggers burst))
+            (assoc (first burst) :task :snap))
+          (when later
+            (reference-make-bursts later)))))))
+
+;; Random event sequences
+
+(def property-limits {["Wheel" "Label"] 8
+                      ["LED" "Intensity"] 5})
+
+(def test-channels
+  [{:exposure 10 :properties {["Wheel" "Label"] "DAPI"
+                              ["LED" "Intensity"] 10}}
+   {:exposure 10 :properties {["Wheel" "Label"] "FITC"
+                              ["LED" "Intensity"] 20}}
+   {:exposure 10 :properties {["Wheel" "Label"] "DAPI"
+                              ["Shutter" "State"] 1}}
+   {:exposure 10 :properties {["Wheel" "Label"] "Cy5"}}
+   {:exposure 20 :properties {["Wheel" "Label"] "Cy5"}}
+   nil])
+
+(defn random-events [^Random rng n]
+  (loop [i 0 slice-index 0 events (transient [])]
+    (if (< i n)
+      (let [slice-index (if (< (.nextInt rng 10) 7)
+                          slice-index
+                          (max 0 (+ slice-index (dec (.nextInt rng 4)))))
+            channel (get test-channels (.nextInt rng (count test-channels)))]
+        (recur (inc i)
+               slice-index
+               (conj! events
+                      {:frame-index i
+                       :position (if (< (.nextInt rng 50) 1) 1 0)
+                       :exposure (if channel (:exposure channel) 10)
+                       :channel channel
+                       :slice (* 2.0 slice-index)
+                       :slice-index slice-index
+                       :wait-time-ms (when (< (.nextInt rng 20) 1) 1000)
+                       :autofocus (< (.nextInt rng 100) 1)})))
+      (persistent! events))))
+
+(deftest bursts-match-reference
+  (doseq [seed (range 50)
+          stage-limit [nil 4 50]]
+    (let [events (random-events (Random. seed) 200)]
+      (with-fake-core stage-limit property-limits (atom {})
+        (is (= (doall (reference-make-bursts events))
+               (doall (make-bursts events)))
+            (str "seed " seed ", stage limit " stage-limit))))))
+
+(deftest property-limits-queried-once
+  (let [queries (atom {})
+        events (random-events (Random. 1) 2000)]
+    (with-fake-core 50 property-limits queries
+      (doall (make-bursts events)))
+    (is (every? #(= 1 %) (vals @queries)))))
+
+(defn sequenced-events
+  "Hardware-sequenced z-stack with alternating channels, as a single
+   burst candidate."
+  [n]
+  (for [i (range n)]
+    (let [slice-index (quot i 2)]
+      {:frame-index 0
+       :position 0
+       :exposure 10
+       :channel (get test-channels (mod i 2))
+       :slice (* 0.1 slice-index)
+       :slice-index slice-index})))
+
+(deftest generate-100k-event-bursts
+  (let [n 100000
+        limits {["Wheel" "Label"] n ["LED" "Intensity"] n}
+        events (doall (sequenced-events n))
+        bursts (with-fake-core n limits (atom {})
+                 (doall (make-bursts events)))]
+    (is (= 1 (count bursts)))
+    (is (= n (:burst-length (first bursts))))
+    (is (= n (count (get-in (first bursts)
+                            [:trigger-sequence :slices]))))))
@@ -58,7 +58,6 @@ import java.util.HashMap;
 import java.util.Iterator;
 import java.util.List;
 import java.util.Map;
-import org.apache.commons.math3.exception.NumberIsTooLargeException;
 import org.apache.commons.math3.exception.TooManyEvaluationsException;
 import org.micromanager.internal.MMStudio;
 import org.micromanager.internal.utils.ReportingUtils;
@@ -80,6 +79,8 @@ public class ParticlePairLister {
    private final Double registrationError_;
    private final Boolean showHistogram_;
    private final Boolean bootstrap_;
+   // bootstrap results are reproducible for the same data
+   private static final long BOOTSTRAP_SEED = 1;
 
 
    public static class Builder {
@@ -813,62 +814,19 @@ public class ParticlePairLister {
                   //       / (dMu * dMu);
                   //double fisherStdDev = 1 / Math.sqrt(info);
 
-                  double muEstimate = 0.0;
-                  double stdDevEstimate = 0.0;
-                  boolean bootstrapSucceeded = false;
-                  if (bootstrap_) {
+                  // 95% confidence interval of mu and sigma, from 1000
+                  // resamples fitted concurrently, starting from the fit above
+                  double[][] bootstrapIntervals = null;
+                  if (bootstrap_ && sigma > 0.0) {
                      ij.IJ.showStatus("Bootstrap analysis running");
-                     int counter = 0;
-                     int errorCounter = 0;
-                     final int nrRuns = 1000;
-                     final int maxNrErrors = 10;
-                     List<Double> mus = new ArrayList<Double>();
-                     double[] bootsTrapResult;
-                     while (counter < nrRuns && errorCounter < maxNrErrors) {
-                        List bootstrapList = ListUtils.listToListForBootstrap(vectorDistances);
-                        try {
-                           bootsTrapResult = p2dLeastSquareFit(bootstrapList, maxDistanceNm_);
-                           mus.add(bootsTrapResult[0]);
-                           counter++;
-                           if (counter % 25 == 0) {
-                              ij.IJ.showProgress(counter, nrRuns);
-                           }
-                        } catch (FittingException fe) {
-                           String msg = "ID: " + dc.getSpotData(row).id_
-                                 + ", Failed to fit p2d function";
-                           MMStudio.getInstance().alerts().postAlert("P2D fit error",
-                                 null, msg);
-                           if (row == rows_[rows_.length - 1]) {
-                              ReportingUtils.showError(msg);
-                           }
-                           errorCounter++;
-                        } catch (TooManyEvaluationsException tmee) {
-                           String msg = "ID: " + dc.getSpotData(row).id_
-                                 + ", Too many evaluations while fitting";
-                           MMStudio.getInstance().alerts().postAlert("P2D fit error",
-                                 null, msg);
-                           if (row == rows_[rows_.length - 1]) {
-                              ReportingUtils.showError(msg);
-                           }
-                           errorCounter++;
-                        } catch (NumberIsTooLargeException nitle) {
-                           String msg = "ID: " + dc.getSpotData(row).id_
-                                 + ", Internal error during bootystrapping";
-                           MMStudio.getInstance().alerts().postAlert("P2D fit error",
-                                 null, msg);
-                           if (row == rows_[rows_.length - 1]) {
-                              ReportingUtils.showError(msg);
-                           }
-                           errorCounter++;
-                        }
-                     }
-                     if (errorCounter >= 100) {
+                     P2DFitter bootstrapFitter = new P2DFitter(
+                           ListUtils.toArray(vectorDistances), null, true, true, maxDistanceNm_);
+                     bootstrapFitter.setStartParams(mu, sigma);
+                     try {
+                        bootstrapIntervals = bootstrapFitter.bootstrap(1000, 0.95, BOOTSTRAP_SEED);
+                     } catch (FittingException fe) {
                         MMStudio.getInstance().alerts().postAlert("Boostrapping error",
-                              null, "Bootstrap analysis failed due to too many errors");
-                     } else {
-                        muEstimate = ListUtils.listAvg(mus);
-                        stdDevEstimate = ListUtils.listStdDev(mus, muEstimate);
-                        bootstrapSucceeded = true;
+                              null, "ID: " + dc.getSpotData(row).id_ + ", " + fe.getMessage());
                      }
                   }
 
@@ -905,9 +863,11 @@ public class ParticlePairLister {
                   rt3.addValue("mu", mu);
                   //rt3.addValue("stdDev", fisherStdDev);
                   rt3.addValue("sigma", sigma);
-                  if (bootstrapSucceeded) {
-                     rt3.addValue("bootstrap Mu", muEstimate);
-                     rt3.addValue("bootstrap StdDev", stdDevEstimate);
+                  if (bootstrapIntervals != null) {
+                     rt3.addValue("bootstrap Mu low", bootstrapIntervals[0][0]);
+                     rt3.addValue("bootstrap Mu high", bootstrapIntervals[0][1]);
+                     rt3.addValue("bootstrap Sigma low", bootstrapIntervals[1][0]);
+                     rt3.addValue("bootstrap Sigma high", bootstrapIntervals[1][1]);
                   }
 
                   rt3.show("P2D Summary");
@@ -27,14 +27,26 @@
 
 package edu.ucsf.valelab.gaussianfit.fitting;
 
+import java.util.Arrays;
+import java.util.List;
+import java.util.Objects;
+import java.util.Random;
+import java.util.stream.Collectors;
+import java.util.stream.IntStream;
 import org.apache.commons.math3.analysis.MultivariateFunction;
+import org.apache.commons.math3.analysis.MultivariateVectorFunction;
+import org.apache.commons.math3.exception.MathIllegalStateException;
 import org.apache.commons.math3.exception.TooManyEvaluationsException;
 import org.apache.commons.math3.optim.InitialGuess;
 import org.apache.commons.math3.optim.MaxEval;
+import org.apache.commons.math3.optim.MaxIter;
 import org.apache.commons.math3.optim.PointValuePair;
+import org.apache.commons.math3.optim.SimpleValueChecker;
 import org.apache.commons.math3.optim.nonlinear.scalar.GoalType;
 import org.apache.commons.math3.optim.nonlinear.scalar.MultivariateFunctionMappingAdapter;
 import org.apache.commons.math3.optim.nonlinear.scalar.ObjectiveFunction;
+import org.apache.commons.math3.optim.nonlinear.scalar.ObjectiveFunctionGradient;
+import org.apache.commons.math3.optim.nonlinear.scalar.gradient.NonLinearConjugateGradientOptimizer;
 import org.apache.commons.math3.optim.nonlinear.scalar.noderiv.NelderMeadSimplex;
 import org.apache.commons.math3.optim.nonlinear.scalar.noderiv.SimplexOptimizer;
 
@@ -44,6 +56,10 @@ import org.apache.commons.math3.optim.nonlinear.scalar.noderiv.SimplexOptimizer;
  * Class that uses the apache commons math3 library to fit a maximum likelihood function for the
  * probability density function of the distribution of measured distances.
  *
+ * <p>By default, the log likelihood and its analytic gradient are calculated in parallel
+ * (see P2DLikelihood) and maximized with a non-linear conjugate gradient optimizer. The
+ * original Nelder-Mead simplex fit is used as a fall back, and is available as solveSimplex().
+ *
  * @author nico
  */
 
@@ -280,6 +296,87 @@ public class P2DFitter {
    private final boolean useIndividualSigmas_;
    private double muGuess_ = 0.0;
    private double sigmaGuess_ = 10.0;
+   private boolean parallel_ = true;
+
+
+   /**
+    * Mean log likelihood as a function of unbounded parameters.  mu is either scaled by the
+    * sigma estimate, or - when the approximation is used, which requires mu &gt; 0 - log
+    * transformed.  sigma is always log transformed.  The value and the gradient are calculated
+    * together, and cached for the last point since the optimizer asks for both.
+    */
+   private class GradientObjective {
+
+      private final P2DLikelihood likelihood_;
+      private final boolean fitMuParam_;
+      private final boolean fitSigmaParam_;
+      private final boolean logMu_;
+      private final double scale_;
+      private double[] lastPoint_ = null;
+      private double[] lastResult_ = null;
+
+      GradientObjective(boolean useApproximation) {
+         likelihood_ = new P2DLikelihood(points_, useIndividualSigmas_ ? sigmas_ : null,
+               useApproximation);
+         likelihood_.setParallel(parallel_);
+         fitMuParam_ = useIndividualSigmas_ || fitMu_;
+         fitSigmaParam_ = !useIndividualSigmas_ && fitSigma_;
+         logMu_ = useIndividualSigmas_ && useApproximation;
+         scale_ = sigmaGuess_ > 0.0 ? sigmaGuess_ : 1.0;
+      }
+
+      double[] initialGuess() {
+         double[] guess = new double[(fitMuParam_ ? 1 : 0) + (fitSigmaParam_ ? 1 : 0)];
+         if (fitMuParam_) {
+            // mu == 0 is a stationary point of the likelihood, do not start there
+            double mu = Math.max(muGuess_, 0.1 * scale_);
+            guess[0] = logMu_ ? Math.log(mu) : mu / scale_;
+         }
+         if (fitSigmaParam_) {
+            guess[guess.length - 1] = Math.log(sigmaGuess_);
+         }
+         return guess;
+      }
+
+      double mu(double[] point) {
+         if (!fitMuParam_) {
+            return muGuess_;
+         }
+         return logMu_ ? Math.exp(point[0]) : point[0] * scale_;
+      }
+
+      double sigma(double[] point) {
+         return fitSigmaParam_ ? Math.exp(point[point.length - 1]) : sigmaGuess_;
+      }
+
+      private double[] evaluate(double[] point) {
+         if (lastPoint_ == null || !Arrays.equals(point, lastPoint_)) {
+            double mu = mu(point);
+            double sigma = sigma(point);
+            double[] vg = likelihood_.valueAndGradient(mu, sigma);
+            double n = likelihood_.size();
+            double[] result = new double[point.length + 1];
+            result[0] = vg[0] / n;
+            if (fitMuParam_) {
+               result[1] = (logMu_ ? mu : scale_) * vg[1] / n;
+            }
+            if (fitSigmaParam_) {
+               result[result.length - 1] = sigma * vg[2] / n;
+            }
+            lastPoint_ = point.clone();
+            lastResult_ = result;
+         }
+         return lastResult_;
+      }
+
+      MultivariateFunction value() {
+         return (double[] point) -> evaluate(point)[0];
+      }
+
+      MultivariateVectorFunction gradient() {
+         return (double[] point) -> Arrays.copyOfRange(evaluate(point), 1, point.length + 1);
+      }
+   }
 
 
    /**
@@ -318,6 +415,15 @@ public class P2DFitter {
       sigmaGuess_ = sigma;
    }
 
+   /**
+    * Whether or not the likelihood is calculated in parallel (default true).
+    *
+    * @param parallel when false, all work is done on the calling thread
+    */
+   public void setParallel(boolean parallel) {
+      parallel_ = parallel;
+   }
+
    /**
     * Given a stepsize, generate an array with distances between 0 and upperBound
     *
@@ -361,17 +467,79 @@ public class P2DFitter {
     * @return likelihood for the input distances
     */
    public double[] logLikelihood(double[] estimators, double[] distances) {
-      double[] localEstimators = estimators.clone();
-      P2DFunc myP2DFunc = new P2DFunc(points_, fitSigma_, sigmaGuess_);
+      double sigma = fitSigma_ ? estimators[1] : sigmaGuess_;
+      P2DLikelihood likelihood = new P2DLikelihood(points_);
+      likelihood.setParallel(parallel_);
       double[] output = new double[distances.length];
       for (int i = 0; i < output.length; i++) {
-         localEstimators[0] = distances[i];
-         output[i] = myP2DFunc.value(localEstimators);
+         output[i] = likelihood.value(distances[i], sigma);
       }
       return output;
    }
 
+   /**
+    * Fits the P2D function to the data.
+    *
+    * @return mu when individual sigmas are used, mu and sigma when mu is fitted, and sigma
+    *         when only sigma is fitted.
+    * @throws FittingException when the fit fails
+    */
    public double[] solve() throws FittingException {
+      if (useIndividualSigmas_ || fitMu_ || fitSigma_) {
+         try {
+            double[] result = solveGradient();
+            if (withinBounds(result)) {
+               return result;
+            }
+         } catch (MathIllegalStateException mise) {
+            // includes TooManyEvaluationsException, fall back to the simplex
+         }
+      }
+      return solveSimplex();
+   }
+
+   private double[] solveGradient() {
+      boolean useApproximation = useIndividualSigmas_ && sigmaGuess_ < muGuess_ / 2;
+      GradientObjective objective = new GradientObjective(useApproximation);
+      NonLinearConjugateGradientOptimizer optimizer = new NonLinearConjugateGradientOptimizer(
+            NonLinearConjugateGradientOptimizer.Formula.POLAK_RIBIERE,
+            new SimpleValueChecker(1e-10, 1e-12), 1e-8, 1e-10, 0.1);
+      PointValuePair solution = optimizer.optimize(
+            new ObjectiveFunction(objective.value()),
+            new ObjectiveFunctionGradient(objective.gradient()),
+            new MaxEval(10000),
+            new MaxIter(1000),
+            GoalType.MAXIMIZE,
+            new InitialGuess(objective.initialGuess()));
+      double[] point = solution.getPoint();
+      // p2d is symmetric in mu
+      double mu = Math.abs(objective.mu(point));
+      double sigma = objective.sigma(point);
+      if (useIndividualSigmas_) {
+         return new double[]{mu};
+      } else if (fitMu_) {
+         return new double[]{mu, sigma};
+      }
+      return new double[]{sigma};
+   }
+
+   private boolean withinBounds(double[] result) {
+      for (double value : result) {
+         if (Double.isNaN(value) || value < 0.0 || value > upperBound_) {
+            return false;
+         }
+      }
+      return true;
+   }
+
+   /**
+    * Fits the P2D function to the data using the Nelder-Mead simplex on the non-log-stable
+    * likelihood functions.  Much slower than solve() for large data sets.
+    *
+    * @return same as solve()
+    * @throws FittingException when the fit fails
+    */
+   public double[] solveSimplex() throws FittingException {
       SimplexOptimizer optimizer = new SimplexOptimizer(1e-9, 1e-12);
 
       if (useIndividualSigmas_) {
@@ -443,7 +611,63 @@ public class P2DFitter {
       return result;
    }
 
+   /**
+    * Estimates confidence intervals of the fitted parameters by bootstrapping: the data are
+    * resampled with replacement and refitted nrRuns times.  Runs are executed concurrently.
+    *
+    * @param nrRuns     number of bootstrap samples
+    * @param confidence confidence level, for instance 0.95
+    * @param seed       seed for the random resampling, runs are reproducible for a given seed
+    * @return for each parameter returned by solve() an array with the lower and upper limit of
+    *         the confidence interval
+    * @throws FittingException when more than half of the runs failed to fit
+    */
+   public double[][] bootstrap(final int nrRuns, final double confidence, final long seed)
+         throws FittingException {
+      List<double[]> results = IntStream.range(0, nrRuns).parallel()
+            .mapToObj(run -> bootstrapRun(new Random(seed + run)))
+            .filter(Objects::nonNull)
+            .collect(Collectors.toList());
+      if (results.isEmpty() || results.size() < nrRuns / 2) {
+         throw new FittingException("Bootstrap failed, " + (nrRuns - results.size())
+               + " out of " + nrRuns + " fits failed");
+      }
+      int nrParams = results.get(0).length;
+      double alpha = (1.0 - confidence) / 2.0;
+      double[][] intervals = new double[nrParams][2];
+      double[] values = new double[results.size()];
+      for (int p = 0; p < nrParams; p++) {
+         for (int i = 0; i < values.length; i++) {
+            values[i] = results.get(i)[p];
+         }
+         Arrays.sort(values);
+         int lower = (int) Math.floor(alpha * (values.length - 1));
+         int upper = (int) Math.ceil((1.0 - alpha) * (values.length - 1));
+         intervals[p][0] = values[lower];
+         intervals[p][1] = values[upper];
+      }
+      return intervals;
+   }
 
-}
-
+   private double[] bootstrapRun(Random random) {
+      double[] points = new double[points_.length];
+      double[] sigmas = useIndividualSigmas_ ? new double[points_.length] : null;
+      for (int i = 0; i < points.length; i++) {
+         int j = random.nextInt(points_.length);
+         points[i] = points_[j];
+         if (sigmas != null) {
+            sigmas[i] = sigmas_[j];
+         }
+      }
+      P2DFitter fitter = new P2DFitter(points, sigmas, fitMu_, fitSigma_, upperBound_);
+      fitter.setStartParams(muGuess_, sigmaGuess_);
+      // runs are already executed in parallel
+      fitter.setParallel(false);
+      try {
+         return fitter.solve();
+      } catch (FittingException fe) {
+         return null;
+      }
+   }
 
+}
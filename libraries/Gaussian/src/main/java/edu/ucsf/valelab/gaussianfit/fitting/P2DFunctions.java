@@ -61,6 +61,35 @@ public class P2DFunctions {
       return first * second * third;
    }
 
+   /**
+    * Natural logarithm of p2d(r, mu, sigma), calculated without intermediate over- or
+    * underflow, so that it remains accurate when mu &gt;&gt; sigma.
+    *
+    * @param r
+    * @param mu
+    * @param sigma
+    * @return log(p2d(r, mu, sigma))
+    */
+   public static double logP2d(double r, double mu, double sigma) {
+      double sigma2 = sigma * sigma;
+      double z = Math.abs(r * mu / sigma2);
+      return Math.log(r / sigma2) - (mu * mu + r * r) / (2 * sigma2)
+            + z + Math.log(Besseli.bessi0Scaled(z));
+   }
+
+   /**
+    * Natural logarithm of p2dApproximation(r, mu, sigma).
+    *
+    * @param r
+    * @param mu
+    * @param sigma
+    * @return log(p2dApproximation(r, mu, sigma))
+    */
+   public static double logP2dApproximation(double r, double mu, double sigma) {
+      return 0.5 * Math.log(r / (2 * Math.PI * sigma * mu))
+            - (r - mu) * (r - mu) / (2 * sigma * sigma);
+   }
+
    /**
     * Used when r > sigma.
     *
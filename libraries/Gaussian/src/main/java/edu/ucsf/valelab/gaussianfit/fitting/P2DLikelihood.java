@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2015-2017, Regents the University of California
+ * Author: Nico Stuurman
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+package edu.ucsf.valelab.gaussianfit.fitting;
+
+import edu.ucsf.valelab.gaussianfit.utils.Besseli;
+import java.util.stream.IntStream;
+
+/**
+ * Log-likelihood of a set of measured distances under the P2D distribution, together with its
+ * analytic gradient with respect to mu and sigma.
+ *
+ * <p>The sum over the data points is split in chunks that are evaluated in parallel. Chunks
+ * are always summed in the same order, so results do not depend on thread scheduling.
+ *
+ * @author nico
+ */
+public class P2DLikelihood {
+
+   /**
+    * Number of points evaluated per task.
+    */
+   public static final int CHUNK_SIZE = 16384;
+
+   private final double[] points_;
+   private final double[] sigmas_;
+   private final boolean useApproximation_;
+   private boolean parallel_ = true;
+
+   /**
+    * Likelihood for points sharing a single sigma.
+    *
+    * @param points measured distances
+    */
+   public P2DLikelihood(final double[] points) {
+      this(points, null, false);
+   }
+
+   /**
+    * Likelihood for points that each have their own sigma.
+    *
+    * @param points           measured distances
+    * @param sigmas           sigma for each point, or null to use a single sigma for all points
+    * @param useApproximation use p2dApproximation instead of p2d.  Only used with individual
+    *                         sigmas.
+    */
+   public P2DLikelihood(final double[] points, final double[] sigmas,
+                        final boolean useApproximation) {
+      if (sigmas != null && sigmas.length != points.length) {
+         throw new IllegalArgumentException("Number of sigmas differs from number of points");
+      }
+      points_ = points;
+      sigmas_ = sigmas;
+      useApproximation_ = sigmas != null && useApproximation;
+   }
+
+   /**
+    * Whether or not to evaluate chunks in parallel (default true).  Switch off when the
+    * caller itself runs many likelihoods in parallel.
+    *
+    * @param parallel true to use the common fork-join pool
+    */
+   public void setParallel(boolean parallel) {
+      parallel_ = parallel;
+   }
+
+   public int size() {
+      return points_.length;
+   }
+
+   /**
+    * Calculates the log likelihood and its gradient.
+    *
+    * @param mu    distance between the two spots
+    * @param sigma sigma of the distribution.  Ignored when individual sigmas are used.
+    * @return array with sum(log(p2d)), d/dmu and d/dsigma of that sum.  The last is zero when
+    *         individual sigmas are used.
+    */
+   public double[] valueAndGradient(final double mu, final double sigma) {
+      int nrChunks = (points_.length + CHUNK_SIZE - 1) / CHUNK_SIZE;
+      IntStream chunks = IntStream.range(0, nrChunks);
+      if (parallel_ && nrChunks > 1) {
+         chunks = chunks.parallel();
+      }
+      double[][] partials = chunks.mapToObj(c -> chunk(c * CHUNK_SIZE,
+            Math.min(points_.length, (c + 1) * CHUNK_SIZE), mu, sigma))
+            .toArray(double[][]::new);
+      double[] result = new double[3];
+      for (double[] partial : partials) {
+         result[0] += partial[0];
+         result[1] += partial[1];
+         result[2] += partial[2];
+      }
+      return result;
+   }
+
+   /**
+    * Calculates the log likelihood only.
+    *
+    * @param mu    distance between the two spots
+    * @param sigma sigma of the distribution.  Ignored when individual sigmas are used.
+    * @return sum(log(p2d))
+    */
+   public double value(final double mu, final double sigma) {
+      return valueAndGradient(mu, sigma)[0];
+   }
+
+   private double[] chunk(int from, int to, double mu, double sigma) {
+      double value = 0.0;
+      double dMu = 0.0;
+      double dSigma = 0.0;
+      if (sigmas_ == null) {
+         double sigma2 = sigma * sigma;
+         double sigma3 = sigma2 * sigma;
+         double mu2 = mu * mu;
+         double logSigma2 = Math.log(sigma2);
+         for (int i = from; i < to; i++) {
+            double r = points_[i];
+            double z = r * mu / sigma2;
+            double az = Math.abs(z);
+            double i0 = Besseli.bessi0Scaled(az);
+            // I1(z) / I0(z), I1 is odd
+            double ratio = Math.signum(z) * Besseli.bessi1Scaled(az) / i0;
+            double r2 = r * r;
+            value += Math.log(r) - logSigma2 - (mu2 + r2) / (2 * sigma2) + az + Math.log(i0);
+            dMu += (r * ratio - mu) / sigma2;
+            dSigma += -2.0 / sigma + (mu2 + r2 - 2 * r * mu * ratio) / sigma3;
+         }
+      } else if (useApproximation_) {
+         for (int i = from; i < to; i++) {
+            double r = points_[i];
+            double s = sigmas_[i];
+            value += P2DFunctions.logP2dApproximation(r, mu, s);
+            dMu += -0.5 / mu + (r - mu) / (s * s);
+         }
+      } else {
+         for (int i = from; i < to; i++) {
+            double r = points_[i];
+            double sigma2 = sigmas_[i] * sigmas_[i];
+            double z = r * mu / sigma2;
+            double az = Math.abs(z);
+            double i0 = Besseli.bessi0Scaled(az);
+            double ratio = Math.signum(z) * Besseli.bessi1Scaled(az) / i0;
+            value += Math.log(r / sigma2) - (mu * mu + r * r) / (2 * sigma2)
+                  + az + Math.log(i0);
+            dMu += (r * ratio - mu) / sigma2;
+         }
+      }
+      return new double[] {value, dMu, dSigma};
+   }
+
+}
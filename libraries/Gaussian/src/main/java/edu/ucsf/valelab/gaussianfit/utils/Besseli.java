@@ -62,6 +62,38 @@ public class Besseli {
       return answer;
    }
 
+   /**
+    * Exponentially scaled modified Bessel function of order zero: exp(-|x|) I0(x).
+    * Does not overflow for large x.
+    */
+   public static final double bessi0Scaled(double x) {
+      double ax = Math.abs(x);
+      if (ax < 3.75) {
+         return bessi0(x) * Math.exp(-ax);
+      }
+      double y = 3.75 / ax;
+      double answer = 0.39894228 + y * (0.1328592e-1 + y * (0.225319e-2
+            + y * (-0.157565e-2 + y * (0.916281e-2 + y * (-0.2057706e-1
+            + y * (0.2635537e-1 + y * (-0.1647633e-1 + y * 0.392377e-2)))))));
+      return answer / Math.sqrt(ax);
+   }
+
+   /**
+    * Exponentially scaled modified Bessel function of order one: exp(-|x|) I1(|x|).
+    * Does not overflow for large x.
+    */
+   public static final double bessi1Scaled(double x) {
+      double ax = Math.abs(x);
+      if (ax < 3.75) {
+         return bessi1(ax) * Math.exp(-ax);
+      }
+      double y = 3.75 / ax;
+      double answer = 0.2282967e-1 + y * (-0.2895312e-1 + y * (0.1787654e-1 - y * 0.420059e-2));
+      answer = 0.39894228 + y * (-0.3988024e-1 + y * (-0.362018e-2 + y * (0.163801e-2 + y * (
+            -0.1031555e-1 + y * answer))));
+      return answer / Math.sqrt(ax);
+   }
+
    public static final double bessi(int n, double x) {
       if (n == 0) {
          return bessi0(x);
@@ -0,0 +1,146 @@
+package edu.ucsf.valelab.gaussianfit.fitting;
+
+import java.util.Random;
+import org.junit.Assert;
+import org.junit.Ignore;
+import org.junit.Test;
+
+/**
+ * Checks that the P2D maximum likelihood fit recovers mu and sigma from synthetic distances.
+ *
+ * @author nico
+ */
+public class P2DFitterTest {
+
+   /**
+    * Distances between two spots mu apart, each coordinate of the distance vector having
+    * Gaussian noise with standard deviation sigma.  These follow the P2D distribution.
+    */
+   private static double[] syntheticDistances(int n, double mu, double sigma, long seed) {
+      Random random = new Random(seed);
+      double[] distances = new double[n];
+      for (int i = 0; i < n; i++) {
+         double x = mu + sigma * random.nextGaussian();
+         double y = sigma * random.nextGaussian();
+         distances[i] = Math.sqrt(x * x + y * y);
+      }
+      return distances;
+   }
+
+   @Test
+   public void testGradientMatchesFiniteDifferences() {
+      double[] points = syntheticDistances(50000, 20.0, 8.0, 1);
+      P2DLikelihood likelihood = new P2DLikelihood(points);
+      double mu = 17.0;
+      double sigma = 9.0;
+      double h = 1e-5;
+      double[] vg = likelihood.valueAndGradient(mu, sigma);
+      double dMu = (likelihood.value(mu + h, sigma) - likelihood.value(mu - h, sigma)) / (2 * h);
+      double dSigma = (likelihood.value(mu, sigma + h) - likelihood.value(mu, sigma - h))
+            / (2 * h);
+      Assert.assertEquals(dMu, vg[1], 1e-4 * Math.abs(dMu) + 1e-3);
+      Assert.assertEquals(dSigma, vg[2], 1e-4 * Math.abs(dSigma) + 1e-3);
+
+      // log likelihood agrees with the original, non-log implementation
+      double sum = 0.0;
+      for (double point : points) {
+         sum += Math.log(P2DFunctions.p2d(point, mu, sigma));
+      }
+      Assert.assertEquals(sum, vg[0], 1e-9 * Math.abs(sum));
+   }
+
+   @Test
+   public void testParallelEqualsSerial() {
+      double[] points = syntheticDistances(100000, 30.0, 10.0, 2);
+      P2DLikelihood likelihood = new P2DLikelihood(points);
+      double[] parallel = likelihood.valueAndGradient(25.0, 11.0);
+      likelihood.setParallel(false);
+      Assert.assertArrayEquals(likelihood.valueAndGradient(25.0, 11.0), parallel, 0.0);
+   }
+
+   @Test
+   public void testRecoversMuAndSigma() throws FittingException {
+      double mu = 30.0;
+      double sigma = 10.0;
+      double[] points = syntheticDistances(20000, mu, sigma, 3);
+      P2DFitter fitter = new P2DFitter(points, null, true, true, 200.0);
+      fitter.setStartParams(20.0, 15.0);
+      double[] result = fitter.solve();
+      Assert.assertEquals(mu, result[0], 0.5);
+      Assert.assertEquals(sigma, result[1], 0.3);
+   }
+
+   @Test
+   public void testRecoversSigmaWithFixedMu() throws FittingException {
+      double[] points = syntheticDistances(20000, 40.0, 12.0, 4);
+      P2DFitter fitter = new P2DFitter(points, null, false, true, 200.0);
+      fitter.setStartParams(40.0, 5.0);
+      double[] result = fitter.solve();
+      Assert.assertEquals(1, result.length);
+      Assert.assertEquals(12.0, result[0], 0.3);
+   }
+
+   @Test
+   public void testRecoversMuWithIndividualSigmas() throws FittingException {
+      double mu = 50.0;
+      double[] points = syntheticDistances(20000, mu, 8.0, 5);
+      double[] sigmas = new double[points.length];
+      java.util.Arrays.fill(sigmas, 8.0);
+      P2DFitter fitter = new P2DFitter(points, sigmas, true, false, 200.0);
+      // sigma < mu / 2, uses the approximation
+      fitter.setStartParams(40.0, 8.0);
+      Assert.assertEquals(mu, fitter.solve()[0], 0.5);
+   }
+
+   @Test
+   public void testBootstrapContainsTrueValues() throws FittingException {
+      double mu = 25.0;
+      double sigma = 10.0;
+      double[] points = syntheticDistances(5000, mu, sigma, 6);
+      P2DFitter fitter = new P2DFitter(points, null, true, true, 200.0);
+      fitter.setStartParams(20.0, 12.0);
+      double[][] intervals = fitter.bootstrap(100, 0.99, 42);
+      Assert.assertTrue(intervals[0][0] < mu && mu < intervals[0][1]);
+      Assert.assertTrue(intervals[1][0] < sigma && sigma < intervals[1][1]);
+   }
+
+   @Test
+   public void testGradientAgreesWithSimplex() throws FittingException {
+      double[] points = syntheticDistances(20000, 30.0, 10.0, 7);
+      P2DFitter fitter = new P2DFitter(points, null, true, true, 200.0);
+      fitter.setStartParams(20.0, 15.0);
+      double[] gradientResult = fitter.solve();
+      double[] simplexResult = fitter.solveSimplex();
+      Assert.assertEquals(simplexResult[0], gradientResult[0], 0.05);
+      Assert.assertEquals(simplexResult[1], gradientResult[1], 0.05);
+   }
+
+   /**
+    * Fits a million points with the gradient fit.  Not part of the default run; compare
+    * the time reported by JUnit with {@link #benchmarkSimplex()}.
+    */
+   @Ignore("Benchmark, run manually")
+   @Test
+   public void benchmarkGradient() throws FittingException {
+      double[] points = syntheticDistances(1000000, 30.0, 10.0, 8);
+      P2DFitter fitter = new P2DFitter(points, null, true, true, 200.0);
+      fitter.setStartParams(20.0, 15.0);
+      double[] result = fitter.solve();
+      Assert.assertEquals(30.0, result[0], 0.1);
+      Assert.assertEquals(10.0, result[1], 0.1);
+   }
+
+   /**
+    * Fits a million points with the simplex fit.  Not part of the default run.
+    */
+   @Ignore("Benchmark, run manually")
+   @Test
+   public void benchmarkSimplex() throws FittingException {
+      double[] points = syntheticDistances(1000000, 30.0, 10.0, 8);
+      P2DFitter fitter = new P2DFitter(points, null, true, true, 200.0);
+      fitter.setStartParams(20.0, 15.0);
+      double[] result = fitter.solveSimplex();
+      Assert.assertEquals(30.0, result[0], 0.1);
+      Assert.assertEquals(10.0, result[1], 0.1);
+   }
+}
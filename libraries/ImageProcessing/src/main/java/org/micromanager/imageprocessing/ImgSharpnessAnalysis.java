@@ -48,7 +48,7 @@ public class ImgSharpnessAnalysis {
    public enum Method {
       Edges, StdDev, Mean,
       NormalizedVariance, SharpEdges, Redondo, Volath, Volath5,
-      MedianEdges, Tenengrad, FFTBandpass;
+      MedianEdges, Tenengrad, FFTBandpass, Brenner, VollathF4;
 
       public static String[] getNames() {
          return Arrays.stream(Method.class.getEnumConstants()).map(Enum::name)
@@ -113,6 +113,10 @@ public class ImgSharpnessAnalysis {
             return computeTenengrad(proc);
          case FFTBandpass:
             return computeFFTBandpass(proc, fftLowerCutoff_, fftUpperCutoff_);
+         case Brenner:
+            return computeBrenner(proc);
+         case VollathF4:
+            return computeVollathF4(proc);
          default:
             throw new AssertionError(method_.name());
       }
@@ -261,6 +265,35 @@ public class ImgSharpnessAnalysis {
    }
 
 
+   /**
+    * Brenner's gradient: sum of squared differences between pixels two
+    * columns apart.
+    *
+    * <p>Brenner JF et al., "An automated microscope for cytologic research",
+    * J Histochem Cytochem 24(1), 100-111 (1976).
+    */
+   public static double computeBrenner(ImageProcessor proc) {
+      return SharpnessMetrics.compute(rawPixels(proc), proc.getWidth(), proc.getHeight(),
+            null, SharpnessMetrics.Metric.Brenner);
+   }
+
+   /**
+    * Vollath's F4: the autocorrelation at a shift of one pixel minus that at
+    * a shift of two pixels (see computeVolath, which skips the first column).
+    */
+   public static double computeVollathF4(ImageProcessor proc) {
+      return SharpnessMetrics.compute(rawPixels(proc), proc.getWidth(), proc.getHeight(),
+            null, SharpnessMetrics.Metric.VollathF4);
+   }
+
+   private static Object rawPixels(ImageProcessor proc) {
+      Object pixels = proc.getPixels();
+      if (pixels instanceof byte[] || pixels instanceof short[] || pixels instanceof float[]) {
+         return pixels;
+      }
+      return proc.convertToFloat().getPixels();
+   }
+
    /**
     * Modified version of the algorithm used by the AutoFocus JAF(H&P) code in Micro-Manager's
     * Autofocus.java by Pakpoom Subsoontorn & Hernan Garcia. Looks for diagonal edges in both
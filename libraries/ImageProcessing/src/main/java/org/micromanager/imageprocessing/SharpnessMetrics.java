@@ -0,0 +1,341 @@
+package org.micromanager.imageprocessing;
+
+import ij.process.FloatProcessor;
+import java.awt.Rectangle;
+import java.util.EnumMap;
+import java.util.EnumSet;
+import java.util.Set;
+import java.util.stream.IntStream;
+
+/**
+ * Focus metrics computed directly on raw pixel arrays.
+ *
+ * <p>All requested spatial metrics are accumulated in a single pass over the
+ * pixels of a region, which is split into horizontal bands that are processed
+ * in parallel for large regions. Partial sums are combined in band order, so
+ * the result does not depend on the number of threads.
+ *
+ * <p>Pixel arrays may be byte[] (8 bit, unsigned), short[] (16 bit, unsigned)
+ * or float[], as returned by Image.getRawPixels() and ImageProcessor.getPixels().
+ */
+public final class SharpnessMetrics {
+
+   public enum Metric {
+      /** Sum of squared differences between pixels two columns apart. */
+      Brenner,
+      /** Sum of squared Sobel gradient magnitudes over interior pixels. */
+      Tenengrad,
+      /** Population variance divided by the mean intensity. */
+      NormalizedVariance,
+      /** Vollath's F4 autocorrelation. */
+      VollathF4,
+      /** Mean power in a band of spatial frequencies, as in ImgSharpnessAnalysis. */
+      FFTBandEnergy;
+
+      /**
+       * Returns the metric equivalent to an ImgSharpnessAnalysis method, or
+       * null if the method is not computed by this class.
+       */
+      public static Metric forMethod(ImgSharpnessAnalysis.Method method) {
+         switch (method) {
+            case Brenner:
+               return Brenner;
+            case VollathF4:
+               return VollathF4;
+            case FFTBandpass:
+               return FFTBandEnergy;
+            default:
+               return null;
+         }
+      }
+   }
+
+   public static final double DEFAULT_FFT_LOWER_CUTOFF = 2.5;
+   public static final double DEFAULT_FFT_UPPER_CUTOFF = 14;
+
+   // Rows per band; also the unit of parallel work
+   private static final int BAND_HEIGHT = 64;
+   // Regions with fewer pixels are processed on the calling thread
+   private static final long PARALLEL_MIN_PIXELS = 1 << 18;
+
+   private SharpnessMetrics() {
+   }
+
+   /**
+    * Partial sums over a band of rows. Intensity moments are taken relative
+    * to a shift, close to the mean, to keep the variance accurate.
+    */
+   private static final class Sums {
+      double sum;
+      double sumSq;
+      double brenner;
+      double tenengrad;
+      double vollath1;
+      double vollath2;
+
+      void add(Sums other) {
+         sum += other.sum;
+         sumSq += other.sumSq;
+         brenner += other.brenner;
+         tenengrad += other.tenengrad;
+         vollath1 += other.vollath1;
+         vollath2 += other.vollath2;
+      }
+   }
+
+   /**
+    * Computes a single metric.
+    *
+    * @param pixels raw pixels of the whole image
+    * @param width width of the image
+    * @param height height of the image
+    * @param roi region to evaluate, or null for the whole image
+    * @param metric metric to compute
+    * @return value of the metric
+    */
+   public static double compute(Object pixels, int width, int height, Rectangle roi,
+                                Metric metric) {
+      return compute(pixels, width, height, roi, EnumSet.of(metric)).get(metric);
+   }
+
+   /**
+    * Computes a set of metrics, with the default FFT band.
+    *
+    * @see #compute(Object, int, int, Rectangle, Set, double, double)
+    */
+   public static EnumMap<Metric, Double> compute(Object pixels, int width, int height,
+                                                 Rectangle roi, Set<Metric> metrics) {
+      return compute(pixels, width, height, roi, metrics,
+            DEFAULT_FFT_LOWER_CUTOFF, DEFAULT_FFT_UPPER_CUTOFF);
+   }
+
+   /**
+    * Computes a set of metrics. All metrics except FFTBandEnergy are computed
+    * in one pass over the pixels; FFTBandEnergy needs a copy of the region to
+    * transform.
+    *
+    * @param pixels raw pixels of the whole image
+    * @param width width of the image
+    * @param height height of the image
+    * @param roi region to evaluate, or null for the whole image; clipped to
+    *            the image
+    * @param metrics metrics to compute
+    * @param fftLowerCutoff lower end of the FFT band, in percent of the
+    *                       Nyquist frequency
+    * @param fftUpperCutoff upper end of the FFT band, in percent of the
+    *                       Nyquist frequency
+    * @return the value of each requested metric
+    */
+   public static EnumMap<Metric, Double> compute(Object pixels, int width, int height,
+                                                 Rectangle roi, Set<Metric> metrics,
+                                                 double fftLowerCutoff,
+                                                 double fftUpperCutoff) {
+      final Rectangle r = clip(roi, width, height);
+      EnumMap<Metric, Double> result = new EnumMap<>(Metric.class);
+      EnumSet<Metric> spatial = EnumSet.copyOf(metrics);
+      spatial.remove(Metric.FFTBandEnergy);
+      if (!spatial.isEmpty()) {
+         final boolean tenengrad = spatial.contains(Metric.Tenengrad);
+         final double shift = pixel(pixels, r.y * width + r.x);
+         final int bands = (r.height + BAND_HEIGHT - 1) / BAND_HEIGHT;
+         IntStream indices = IntStream.range(0, bands);
+         if ((long) r.width * r.height >= PARALLEL_MIN_PIXELS) {
+            indices = indices.parallel();
+         }
+         Sums[] parts = indices.mapToObj(b -> accumulate(pixels, width, r,
+               b * BAND_HEIGHT, Math.min(r.height, (b + 1) * BAND_HEIGHT), shift,
+               tenengrad)).toArray(Sums[]::new);
+         Sums total = new Sums();
+         for (Sums part : parts) {
+            total.add(part);
+         }
+         for (Metric metric : spatial) {
+            result.put(metric, value(metric, total, (long) r.width * r.height, shift));
+         }
+      }
+      if (metrics.contains(Metric.FFTBandEnergy)) {
+         result.put(Metric.FFTBandEnergy, ImgSharpnessAnalysis.computeFFTBandpass(
+               crop(pixels, width, r), fftLowerCutoff, fftUpperCutoff));
+      }
+      return result;
+   }
+
+   /**
+    * Computes a metric for each tile of a grid covering the image. Tiles at
+    * the right and bottom edges may be smaller than tileSize.
+    *
+    * @param pixels raw pixels of the image
+    * @param width width of the image
+    * @param height height of the image
+    * @param tileSize edge length of the tiles, in pixels
+    * @param metric metric to compute
+    * @return values, row by row, for heatMapColumns x heatMapRows tiles
+    */
+   public static double[] heatMap(Object pixels, int width, int height, int tileSize,
+                                  Metric metric) {
+      if (tileSize < 3) {
+         throw new IllegalArgumentException("Tiles must be at least 3 pixels wide");
+      }
+      final int columns = heatMapColumns(width, tileSize);
+      final int rows = heatMapRows(height, tileSize);
+      final double[] result = new double[columns * rows];
+      IntStream indices = IntStream.range(0, result.length);
+      if ((long) width * height >= PARALLEL_MIN_PIXELS) {
+         indices = indices.parallel();
+      }
+      indices.forEach(i -> {
+         int x = (i % columns) * tileSize;
+         int y = (i / columns) * tileSize;
+         Rectangle tile = new Rectangle(x, y,
+               Math.min(tileSize, width - x), Math.min(tileSize, height - y));
+         result[i] = compute(pixels, width, height, tile, metric);
+      });
+      return result;
+   }
+
+   public static int heatMapColumns(int width, int tileSize) {
+      return (width + tileSize - 1) / tileSize;
+   }
+
+   public static int heatMapRows(int height, int tileSize) {
+      return (height + tileSize - 1) / tileSize;
+   }
+
+   private static Rectangle clip(Rectangle roi, int width, int height) {
+      Rectangle bounds = new Rectangle(0, 0, width, height);
+      Rectangle r = roi == null ? bounds : roi.intersection(bounds);
+      if (r.isEmpty()) {
+         throw new IllegalArgumentException("Region " + roi + " is outside of the image");
+      }
+      return r;
+   }
+
+   private static double value(Metric metric, Sums total, long count, double shift) {
+      switch (metric) {
+         case Brenner:
+            return total.brenner;
+         case Tenengrad:
+            return total.tenengrad;
+         case NormalizedVariance:
+            double meanShifted = total.sum / count;
+            double mean = meanShifted + shift;
+            if (mean == 0.0) {
+               return 0.0;
+            }
+            double variance = Math.max(0.0, total.sumSq / count - meanShifted * meanShifted);
+            return variance / mean;
+         case VollathF4:
+            return total.vollath1 - total.vollath2;
+         default:
+            throw new AssertionError(metric.name());
+      }
+   }
+
+   /**
+    * Accumulates the sums over rows [y0, y1) of the region, in region
+    * coordinates. The Sobel operator of Tenengrad also reads the rows just
+    * outside of the band, but only within the region.
+    */
+   private static Sums accumulate(Object pixels, int width, Rectangle r, int y0, int y1,
+                                  double shift, boolean tenengrad) {
+      final int w = r.width;
+      final int h = r.height;
+      double[] prev = new double[w];
+      double[] cur = new double[w];
+      double[] next = new double[w];
+      if (tenengrad && y0 > 0) {
+         readRow(pixels, (r.y + y0 - 1) * width + r.x, w, prev);
+      }
+      readRow(pixels, (r.y + y0) * width + r.x, w, cur);
+      Sums s = new Sums();
+      for (int y = y0; y < y1; y++) {
+         if (y + 1 < h && (tenengrad || y + 1 < y1)) {
+            readRow(pixels, (r.y + y + 1) * width + r.x, w, next);
+         }
+         double sum = 0.0;
+         double sumSq = 0.0;
+         double brenner = 0.0;
+         double vollath1 = 0.0;
+         double vollath2 = 0.0;
+         for (int x = 0; x < w; x++) {
+            final double p = cur[x];
+            final double d = p - shift;
+            sum += d;
+            sumSq += d * d;
+            if (x + 2 < w) {
+               final double p2 = cur[x + 2];
+               brenner += (p2 - p) * (p2 - p);
+               vollath2 += p * p2;
+            }
+            if (x + 1 < w) {
+               vollath1 += p * cur[x + 1];
+            }
+         }
+         s.sum += sum;
+         s.sumSq += sumSq;
+         s.brenner += brenner;
+         s.vollath1 += vollath1;
+         s.vollath2 += vollath2;
+         if (tenengrad && y > 0 && y + 1 < h) {
+            double ten = 0.0;
+            for (int x = 1; x + 1 < w; x++) {
+               final double gx = (prev[x + 1] + 2 * cur[x + 1] + next[x + 1])
+                     - (prev[x - 1] + 2 * cur[x - 1] + next[x - 1]);
+               final double gy = (next[x - 1] + 2 * next[x] + next[x + 1])
+                     - (prev[x - 1] + 2 * prev[x] + prev[x + 1]);
+               ten += gx * gx + gy * gy;
+            }
+            s.tenengrad += ten;
+         }
+         double[] tmp = prev;
+         prev = cur;
+         cur = next;
+         next = tmp;
+      }
+      return s;
+   }
+
+   private static double pixel(Object pixels, int index) {
+      if (pixels instanceof byte[]) {
+         return ((byte[]) pixels)[index] & 0xff;
+      } else if (pixels instanceof short[]) {
+         return ((short[]) pixels)[index] & 0xffff;
+      } else if (pixels instanceof float[]) {
+         return ((float[]) pixels)[index];
+      }
+      throw new IllegalArgumentException("Unsupported pixel type");
+   }
+
+   private static void readRow(Object pixels, int offset, int length, double[] dst) {
+      if (pixels instanceof byte[]) {
+         final byte[] p = (byte[]) pixels;
+         for (int i = 0; i < length; i++) {
+            dst[i] = p[offset + i] & 0xff;
+         }
+      } else if (pixels instanceof short[]) {
+         final short[] p = (short[]) pixels;
+         for (int i = 0; i < length; i++) {
+            dst[i] = p[offset + i] & 0xffff;
+         }
+      } else if (pixels instanceof float[]) {
+         final float[] p = (float[]) pixels;
+         for (int i = 0; i < length; i++) {
+            dst[i] = p[offset + i];
+         }
+      } else {
+         throw new IllegalArgumentException("Unsupported pixel type");
+      }
+   }
+
+   private static FloatProcessor crop(Object pixels, int width, Rectangle r) {
+      float[] region = new float[r.width * r.height];
+      double[] row = new double[r.width];
+      for (int y = 0; y < r.height; y++) {
+         readRow(pixels, (r.y + y) * width + r.x, r.width, row);
+         for (int x = 0; x < r.width; x++) {
+            region[y * r.width + x] = (float) row[x];
+         }
+      }
+      return new FloatProcessor(r.width, r.height, region);
+   }
+}
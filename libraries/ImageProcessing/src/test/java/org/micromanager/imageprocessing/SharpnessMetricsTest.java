@@ -0,0 +1,216 @@
+package org.micromanager.imageprocessing;
+
+import ij.plugin.filter.GaussianBlur;
+import ij.process.FloatProcessor;
+import ij.process.ImageProcessor;
+import java.awt.Rectangle;
+import java.util.EnumMap;
+import java.util.EnumSet;
+import java.util.Random;
+import org.junit.Assert;
+import org.junit.Test;
+
+public class SharpnessMetricsTest {
+
+   // Blur of the in-focus specimen, so that it has a finite resolution
+   private static final double SPECIMEN_SIGMA = 2.0;
+
+   /**
+    * Random specimen, defocused by a Gaussian blur of the given sigma (none
+    * if 0).
+    */
+   private static FloatProcessor texture(int width, int height, double sigma, long seed) {
+      Random rng = new Random(seed);
+      float[] pixels = new float[width * height];
+      for (int i = 0; i < pixels.length; i++) {
+         pixels[i] = 100 + 500 * rng.nextFloat();
+      }
+      FloatProcessor proc = new FloatProcessor(width, height, pixels);
+      new GaussianBlur().blurGaussian(proc, SPECIMEN_SIGMA, SPECIMEN_SIGMA, 0.0002);
+      if (sigma > 0) {
+         new GaussianBlur().blurGaussian(proc, sigma, sigma, 0.0002);
+      }
+      return proc;
+   }
+
+   // Straightforward implementations of the definitions, for comparison
+
+   private static double refBrenner(ImageProcessor p, Rectangle r) {
+      double sum = 0;
+      for (int y = r.y; y < r.y + r.height; y++) {
+         for (int x = r.x; x < r.x + r.width - 2; x++) {
+            double d = p.getPixelValue(x + 2, y) - p.getPixelValue(x, y);
+            sum += d * d;
+         }
+      }
+      return sum;
+   }
+
+   private static double refTenengrad(ImageProcessor p, Rectangle r) {
+      double sum = 0;
+      for (int y = r.y + 1; y < r.y + r.height - 1; y++) {
+         for (int x = r.x + 1; x < r.x + r.width - 1; x++) {
+            double gx = 0;
+            double gy = 0;
+            int[] kx = {-1, 0, 1, -2, 0, 2, -1, 0, 1};
+            int[] ky = {-1, -2, -1, 0, 0, 0, 1, 2, 1};
+            for (int j = -1; j <= 1; j++) {
+               for (int i = -1; i <= 1; i++) {
+                  double v = p.getPixelValue(x + i, y + j);
+                  gx += kx[(j + 1) * 3 + i + 1] * v;
+                  gy += ky[(j + 1) * 3 + i + 1] * v;
+               }
+            }
+            sum += gx * gx + gy * gy;
+         }
+      }
+      return sum;
+   }
+
+   private static double refNormalizedVariance(ImageProcessor p, Rectangle r) {
+      double mean = 0;
+      for (int y = r.y; y < r.y + r.height; y++) {
+         for (int x = r.x; x < r.x + r.width; x++) {
+            mean += p.getPixelValue(x, y);
+         }
+      }
+      mean /= r.width * r.height;
+      double variance = 0;
+      for (int y = r.y; y < r.y + r.height; y++) {
+         for (int x = r.x; x < r.x + r.width; x++) {
+            double d = p.getPixelValue(x, y) - mean;
+            variance += d * d;
+         }
+      }
+      variance /= r.width * r.height;
+      return variance / mean;
+   }
+
+   private static double refVollathF4(ImageProcessor p, Rectangle r) {
+      double sum1 = 0;
+      double sum2 = 0;
+      for (int y = r.y; y < r.y + r.height; y++) {
+         for (int x = r.x; x < r.x + r.width - 1; x++) {
+            sum1 += p.getPixelValue(x, y) * p.getPixelValue(x + 1, y);
+         }
+         for (int x = r.x; x < r.x + r.width - 2; x++) {
+            sum2 += p.getPixelValue(x, y) * p.getPixelValue(x + 2, y);
+         }
+      }
+      return sum1 - sum2;
+   }
+
+   private static double refFFTBandEnergy(ImageProcessor p, Rectangle r) {
+      ImageProcessor copy = p.duplicate().convertToFloat();
+      copy.setRoi(r);
+      return ImgSharpnessAnalysis.computeFFTBandpass(copy.crop(),
+            SharpnessMetrics.DEFAULT_FFT_LOWER_CUTOFF, SharpnessMetrics.DEFAULT_FFT_UPPER_CUTOFF);
+   }
+
+   private static void assertClose(String what, double expected, double actual) {
+      Assert.assertEquals(what, expected, actual, 1e-9 * Math.max(1.0, Math.abs(expected)));
+   }
+
+   private static void checkAgainstReference(ImageProcessor p, Rectangle r) {
+      EnumMap<SharpnessMetrics.Metric, Double> values = SharpnessMetrics.compute(
+            p.getPixels(), p.getWidth(), p.getHeight(), r,
+            EnumSet.allOf(SharpnessMetrics.Metric.class));
+      String what = p.getClass().getSimpleName() + " " + r;
+      assertClose(what, refBrenner(p, r), values.get(SharpnessMetrics.Metric.Brenner));
+      assertClose(what, refTenengrad(p, r), values.get(SharpnessMetrics.Metric.Tenengrad));
+      assertClose(what, refNormalizedVariance(p, r),
+            values.get(SharpnessMetrics.Metric.NormalizedVariance));
+      assertClose(what, refVollathF4(p, r), values.get(SharpnessMetrics.Metric.VollathF4));
+      assertClose(what, refFFTBandEnergy(p, r),
+            values.get(SharpnessMetrics.Metric.FFTBandEnergy));
+   }
+
+   @Test
+   public void metricsMatchReference() {
+      FloatProcessor source = texture(150, 131, 1.5, 1);
+      Rectangle[] regions = {new Rectangle(0, 0, 150, 131), new Rectangle(7, 9, 100, 70),
+            new Rectangle(0, 60, 150, 71), new Rectangle(140, 120, 10, 11)};
+      ImageProcessor[] procs = {source, source.convertToShort(false),
+            source.convertToByte(true)};
+      for (ImageProcessor p : procs) {
+         for (Rectangle r : regions) {
+            checkAgainstReference(p, r);
+         }
+      }
+   }
+
+   /**
+    * Large enough to be split over several threads and bands.
+    */
+   @Test
+   public void largeImageMatchesReference() {
+      ImageProcessor p = texture(700, 600, 2.0, 2).convertToShort(false);
+      checkAgainstReference(p, new Rectangle(0, 0, 700, 600));
+      EnumMap<SharpnessMetrics.Metric, Double> first = SharpnessMetrics.compute(p.getPixels(),
+            700, 600, null, EnumSet.allOf(SharpnessMetrics.Metric.class));
+      EnumMap<SharpnessMetrics.Metric, Double> second = SharpnessMetrics.compute(p.getPixels(),
+            700, 600, null, EnumSet.allOf(SharpnessMetrics.Metric.class));
+      Assert.assertEquals(first, second);
+   }
+
+   /**
+    * Every metric decreases as the same texture gets more blurred.
+    */
+   @Test
+   public void metricsDecreaseWithBlur() {
+      double[] sigmas = {0, 1, 2, 3};
+      for (SharpnessMetrics.Metric metric : SharpnessMetrics.Metric.values()) {
+         double previous = Double.POSITIVE_INFINITY;
+         for (double sigma : sigmas) {
+            FloatProcessor p = texture(256, 256, sigma, 3);
+            double value = SharpnessMetrics.compute(p.getPixels(), 256, 256, null, metric);
+            Assert.assertTrue(metric + " at sigma " + sigma, value < previous);
+            previous = value;
+         }
+      }
+   }
+
+   @Test
+   public void heatMapFindsSharpRegion() {
+      final int tile = 32;
+      FloatProcessor sharp = texture(256, 128, 0, 4);
+      FloatProcessor blurred = texture(256, 128, 4, 4);
+      // Left half sharp, right half blurred
+      for (int y = 0; y < 128; y++) {
+         for (int x = 128; x < 256; x++) {
+            sharp.setf(x, y, blurred.getf(x, y));
+         }
+      }
+      double[] map = SharpnessMetrics.heatMap(sharp.getPixels(), 256, 128, tile,
+            SharpnessMetrics.Metric.Brenner);
+      int columns = SharpnessMetrics.heatMapColumns(256, tile);
+      Assert.assertEquals(8, columns);
+      Assert.assertEquals(4, SharpnessMetrics.heatMapRows(128, tile));
+      for (int row = 0; row < 4; row++) {
+         for (int col = 0; col < columns; col++) {
+            double value = map[row * columns + col];
+            assertClose("tile " + col + "," + row, SharpnessMetrics.compute(sharp.getPixels(),
+                  256, 128, new Rectangle(col * tile, row * tile, tile, tile),
+                  SharpnessMetrics.Metric.Brenner), value);
+            if (col < 4) {
+               Assert.assertTrue(value > map[row * columns + 7]);
+            }
+         }
+      }
+      // Partial tiles at the edges
+      double[] partial = SharpnessMetrics.heatMap(sharp.getPixels(), 256, 128, 100,
+            SharpnessMetrics.Metric.Brenner);
+      Assert.assertEquals(3 * 2, partial.length);
+   }
+
+   @Test
+   public void analysisMethodsUseSharedKernels() {
+      ImageProcessor p = texture(90, 70, 1, 5).convertToShort(false);
+      ImgSharpnessAnalysis analysis = new ImgSharpnessAnalysis();
+      analysis.setComputationMethod(ImgSharpnessAnalysis.Method.Brenner);
+      assertClose("Brenner", refBrenner(p, new Rectangle(0, 0, 90, 70)), analysis.compute(p));
+      analysis.setComputationMethod(ImgSharpnessAnalysis.Method.VollathF4);
+      assertClose("VollathF4", refVollathF4(p, new Rectangle(0, 0, 90, 70)),
+            analysis.compute(p));
+   }
+}
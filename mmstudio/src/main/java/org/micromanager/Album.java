@@ -71,4 +71,15 @@ public interface Album {
     * @throws java.io.IOException these happen with disk-based stores
     */
    boolean addImages(Collection<Image> images) throws IOException;
+
+   /**
+    * Turns the current album into a permanent dataset on disk, without
+    * copying the images. The album is frozen, and the next image added
+    * starts a new album.
+    *
+    * @return directory of the dataset
+    * @throws java.io.IOException if there is no album, it is kept in RAM
+    *     only, or not all images could be written
+    */
+   String promoteToDataset() throws IOException;
 }
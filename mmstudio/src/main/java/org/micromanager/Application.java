@@ -40,6 +40,12 @@ public interface Application {
     * hardware (as understood by the Micro-Manager Core). This method will
     * poll each device in the system for its current state, which may take
     * significant time. Compare refreshGUIFromCache().
+    *
+    * <p>When called on the Event Dispatch Thread, the devices are polled in
+    * the background, and this method returns right away; the GUI is updated
+    * once polling finished. When called from any other thread, such as a
+    * script, this method returns once the devices were polled and the GUI
+    * was updated.
     */
    void refreshGUI();
 
@@ -0,0 +1,146 @@
+///////////////////////////////////////////////////////////////////////////////
+//PROJECT:       Micro-Manager
+//SUBSYSTEM:     mmstudio
+//-----------------------------------------------------------------------------
+//
+// COPYRIGHT:    University of California, San Francisco, 2024
+//
+// LICENSE:      This file is distributed under the BSD license.
+//               License text is included with the source distribution.
+//
+//               This file is distributed in the hope that it will be useful,
+//               but WITHOUT ANY WARRANTY; without even the implied warranty
+//               of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//               IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//               CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//               INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+package org.micromanager;
+
+/**
+ * Reads device properties periodically on a background thread, so that
+ * panels showing live device values do not access the hardware from the
+ * Event Dispatch Thread. You can access this class via
+ * Studio.propertyPoller() or Studio.getPropertyPoller().
+ *
+ * <p>Reads are shared: when several subscriptions to the same property are
+ * due at about the same time, the property is read once, and the reads of
+ * all properties of a device that are due are done together. No property
+ * is read more often than every {@link #MIN_PERIOD_MS}. While a device is
+ * busy, its properties are not read, and are retried at an increasing
+ * interval. While an acquisition is running, all properties are read less
+ * often, to leave the hardware to the acquisition.
+ */
+public interface PropertyPoller {
+
+   /**
+    * Shortest period at which a property is read.
+    */
+   long MIN_PERIOD_MS = 50;
+
+   /**
+    * Value of a property, as read at a given time.
+    */
+   final class Value {
+      private final String device_;
+      private final String property_;
+      private final String value_;
+      private final Exception error_;
+      private final long timeMs_;
+
+      public Value(String device, String property, String value, Exception error,
+                   long timeMs) {
+         device_ = device;
+         property_ = property;
+         value_ = value;
+         error_ = error;
+         timeMs_ = timeMs;
+      }
+
+      public String getDevice() {
+         return device_;
+      }
+
+      public String getProperty() {
+         return property_;
+      }
+
+      /**
+       * Returns the value, or null if it could not be read.
+       */
+      public String getValue() {
+         return value_;
+      }
+
+      /**
+       * Returns the error that occurred while reading, or null.
+       */
+      public Exception getError() {
+         return error_;
+      }
+
+      /**
+       * Returns when the value was read, as System.currentTimeMillis().
+       */
+      public long getTimeMs() {
+         return timeMs_;
+      }
+   }
+
+   /**
+    * Receives polled values.
+    */
+   interface Listener {
+      /**
+       * Called with each new value. Called on the poller thread, never on
+       * the Event Dispatch Thread; use SwingUtilities.invokeLater() to update
+       * the user interface. Should return quickly, as it delays the reads of
+       * other properties.
+       *
+       * @param value the value read
+       */
+      void propertyPolled(Value value);
+   }
+
+   /**
+    * Handle to a subscription.
+    */
+   interface Subscription {
+      /**
+       * Changes the period at which the property is read.
+       *
+       * @param periodMs period in milliseconds; shorter periods are rounded
+       *                 up to {@link #MIN_PERIOD_MS}
+       */
+      void setPeriodMs(long periodMs);
+
+      /**
+       * Does not read the property during the given time, for example when
+       * the device is known to be unresponsive.
+       *
+       * @param delayMs time in milliseconds before the next read
+       */
+      void postpone(long delayMs);
+
+      /**
+       * Stops reading the property for this subscription. The listener is
+       * not called after this method returns, unless it is being called
+       * at this very moment.
+       */
+      void cancel();
+   }
+
+   /**
+    * Starts reading a property periodically. The first read is done as soon
+    * as possible.
+    *
+    * @param device device label
+    * @param property property name
+    * @param periodMs period in milliseconds; shorter periods are rounded up
+    *                 to {@link #MIN_PERIOD_MS}
+    * @param listener receives the values
+    * @return handle to change or cancel the subscription
+    */
+   Subscription subscribe(String device, String property, long periodMs, Listener listener);
+}
@@ -334,4 +334,20 @@ public interface Studio {
     */
    PropertyManager getPropertyManager();
 
+   /**
+    * Provides access to the PropertyPoller, which reads device properties
+    * periodically on a background thread.
+    *
+    * @return PropertyPoller instance
+    */
+   PropertyPoller propertyPoller();
+
+   /**
+    * Provides access to the PropertyPoller. Identical to propertyPoller()
+    * except in name.
+    *
+    * @return PropertyPoller instance
+    */
+   PropertyPoller getPropertyPoller();
+
 }
@@ -0,0 +1,135 @@
+///////////////////////////////////////////////////////////////////////////////
+//PROJECT:       Micro-Manager
+//SUBSYSTEM:     Data API implementation
+//-----------------------------------------------------------------------------
+//
+// COPYRIGHT:    University of California, San Francisco, 2024
+//
+// LICENSE:      This file is distributed under the BSD license.
+//               License text is included with the source distribution.
+//
+//               This file is distributed in the hope that it will be useful,
+//               but WITHOUT ANY WARRANTY; without even the implied warranty
+//               of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//               IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//               CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//               INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+package org.micromanager.data.internal;
+
+import java.io.File;
+import java.io.IOException;
+import java.io.RandomAccessFile;
+import java.nio.channels.FileChannel;
+import java.nio.channels.FileLock;
+import java.nio.channels.OverlappingFileLockException;
+import org.apache.commons.io.FileUtils;
+import org.micromanager.internal.utils.ReportingUtils;
+
+/**
+ * Marks a temporary spill directory as in use, with an OS file lock on a
+ * lock file next to it ("dir.lock"). The lock is released by the OS when the
+ * application exits, so lock files that can be locked again belong to
+ * directories left behind by a crash, and {@link #sweep(File)} deletes them.
+ * Directories without a lock file, such as promoted datasets, are never
+ * swept.
+ */
+public final class SpillLock {
+   static final String SUFFIX = ".lock";
+
+   private final File file_;
+   private final RandomAccessFile raf_;
+   private final FileLock lock_;
+
+   private SpillLock(File file, RandomAccessFile raf, FileLock lock) {
+      file_ = file;
+      raf_ = raf;
+      lock_ = lock;
+   }
+
+   /**
+    * Locks a spill directory for the lifetime of this application, or until
+    * released.
+    *
+    * @param directory the spill directory; it need not exist yet
+    * @return the lock
+    * @throws IOException if the lock file cannot be created or locked
+    */
+   public static SpillLock acquire(File directory) throws IOException {
+      File file = new File(directory.getPath() + SUFFIX);
+      RandomAccessFile raf = new RandomAccessFile(file, "rw");
+      try {
+         FileLock lock = raf.getChannel().tryLock();
+         if (lock == null) {
+            throw new IOException("Spill directory is in use: " + directory);
+         }
+         return new SpillLock(file, raf, lock);
+      } catch (IOException | RuntimeException e) {
+         raf.close();
+         throw e;
+      }
+   }
+
+   /**
+    * Releases the lock and deletes the lock file, after which the directory
+    * is no longer swept. Call when the directory was deleted, or has become
+    * a permanent dataset.
+    */
+   public void release() {
+      try {
+         lock_.release();
+         raf_.close();
+      } catch (IOException e) {
+         ReportingUtils.logError(e, "Error releasing " + file_);
+      }
+      if (!file_.delete() && file_.exists()) {
+         ReportingUtils.logError("Unable to delete " + file_);
+      }
+   }
+
+   /**
+    * Deletes the spill directories in root whose lock is no longer held.
+    *
+    * @param root directory holding spill directories and their lock files
+    * @return number of directories deleted
+    */
+   public static int sweep(File root) {
+      File[] lockFiles = root.listFiles((dir, name) -> name.endsWith(SUFFIX));
+      if (lockFiles == null) {
+         return 0;
+      }
+      int swept = 0;
+      for (File lockFile : lockFiles) {
+         String path = lockFile.getPath();
+         File directory = new File(path.substring(0, path.length() - SUFFIX.length()));
+         try (RandomAccessFile raf = new RandomAccessFile(lockFile, "rw");
+              FileChannel channel = raf.getChannel()) {
+            FileLock lock;
+            try {
+               lock = channel.tryLock();
+            } catch (OverlappingFileLockException e) {
+               lock = null; // Held by this application
+            }
+            if (lock == null) {
+               continue;
+            }
+            try {
+               if (directory.exists()) {
+                  FileUtils.deleteDirectory(directory);
+                  swept++;
+               }
+            } finally {
+               lock.release();
+            }
+         } catch (IOException e) {
+            ReportingUtils.logError(e, "Unable to clean up " + directory);
+            continue;
+         }
+         if (!lockFile.delete()) {
+            ReportingUtils.logError("Unable to delete " + lockFile);
+         }
+      }
+      return swept;
+   }
+}
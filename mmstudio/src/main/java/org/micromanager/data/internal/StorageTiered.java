@@ -0,0 +1,417 @@
+///////////////////////////////////////////////////////////////////////////////
+//PROJECT:       Micro-Manager
+//SUBSYSTEM:     Data API implementation
+//-----------------------------------------------------------------------------
+//
+// COPYRIGHT:    University of California, San Francisco, 2024
+//
+// LICENSE:      This file is distributed under the BSD license.
+//               License text is included with the source distribution.
+//
+//               This file is distributed in the hope that it will be useful,
+//               but WITHOUT ANY WARRANTY; without even the implied warranty
+//               of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//               IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//               CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//               INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+package org.micromanager.data.internal;
+
+import com.google.common.eventbus.Subscribe;
+import java.io.File;
+import java.io.IOException;
+import java.util.ArrayList;
+import java.util.HashMap;
+import java.util.Iterator;
+import java.util.LinkedHashMap;
+import java.util.LinkedHashSet;
+import java.util.List;
+import java.util.Map;
+import java.util.Set;
+import java.util.TreeSet;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.TimeUnit;
+import org.apache.commons.io.FileUtils;
+import org.micromanager.data.Coords;
+import org.micromanager.data.DataProviderHasNewSummaryMetadataEvent;
+import org.micromanager.data.Datastore;
+import org.micromanager.data.Image;
+import org.micromanager.data.Storage;
+import org.micromanager.data.SummaryMetadata;
+import org.micromanager.internal.utils.ReportingUtils;
+import org.micromanager.internal.utils.ThreadFactoryFactory;
+
+/**
+ * Storage that keeps the most recent images in RAM, up to a byte budget, and
+ * spills all images to a disk-backed Datastore in the background.
+ *
+ * <p>Every image is written to the spill Datastore by a single background
+ * thread, so putImage does not wait for the disk. Once an image has been
+ * written it may be evicted from RAM, oldest first, to stay within the budget.
+ * Reads of evicted images go to the spill Datastore. putImage only blocks when
+ * the writer falls behind by more than the budget, which bounds memory use
+ * regardless of how many images are added.
+ *
+ * <p>If writing to the spill Datastore fails, spilling stops and all further
+ * images are kept in RAM, as in StorageRAM.
+ *
+ * <p>The spill Datastore is deleted on close, unless it was kept with
+ * {@link #promote()}.
+ */
+public final class StorageTiered implements Storage {
+   private final long ramBudgetBytes_;
+   private final Datastore spill_;
+   private final ExecutorService flusher_;
+
+   // All fields below are guarded by this
+   // Images in RAM, oldest first
+   private final LinkedHashMap<Coords, Image> ramImages_ = new LinkedHashMap<>();
+   // Images that have not been written to the spill store yet; when an image
+   // is replaced before it was written, only the latest one is listed
+   private final Map<Coords, Image> unflushed_ = new HashMap<>();
+   private final LinkedHashSet<Coords> coords_ = new LinkedHashSet<>();
+   private final Set<String> axesInUse_ = new TreeSet<>();
+   private Coords maxIndex_ = new DefaultCoords.Builder().build();
+   private SummaryMetadata summaryMetadata_ = (new DefaultSummaryMetadata.Builder()).build();
+   private boolean summaryForwarded_ = false;
+   private long ramBytes_ = 0;
+   private long unflushedBytes_ = 0;
+   private boolean spillFailed_ = false;
+   private boolean promoted_ = false;
+   private boolean closed_ = false;
+
+   /**
+    * Creates a tiered storage.
+    *
+    * @param store Datastore that "owns" this storage
+    * @param spill Datastore that will receive all images, normally disk-backed.
+    *              It should not be used by anyone else.
+    * @param ramBudgetBytes number of bytes of pixel data kept in RAM
+    */
+   public StorageTiered(DefaultDatastore store, Datastore spill, long ramBudgetBytes) {
+      spill_ = spill;
+      ramBudgetBytes_ = ramBudgetBytes;
+      flusher_ = Executors.newSingleThreadExecutor(
+            ThreadFactoryFactory.createThreadFactory("Storage spill"));
+      store.registerForEvents(this, 0);
+   }
+
+   private static long sizeOf(Image image) {
+      return (long) image.getWidth() * image.getHeight() * image.getBytesPerPixel();
+   }
+
+   @Override
+   public void putImage(Image image) throws IOException {
+      // Not under our lock, this may read from the spill store
+      Image imageExisting = getAnyImage();
+      if (imageExisting != null) {
+         ImageSizeChecker.checkImageSizes(image, imageExisting);
+      } else {
+         ImageSizeChecker.checkImageSizeInSummary(getSummaryMetadata(), image);
+      }
+      final boolean spill;
+      synchronized (this) {
+         // Apply back pressure when the writer can not keep up
+         while (unflushedBytes_ > ramBudgetBytes_ && !spillFailed_ && !closed_) {
+            try {
+               wait();
+            } catch (InterruptedException e) {
+               Thread.currentThread().interrupt();
+               throw new IOException("Interrupted while waiting for images to be written", e);
+            }
+         }
+         Coords coords = image.getCoords();
+         Image replaced = ramImages_.put(coords, image);
+         if (replaced != null) {
+            ramBytes_ -= sizeOf(replaced);
+         }
+         ramBytes_ += sizeOf(image);
+         coords_.add(coords);
+         for (String axis : coords.getAxes()) {
+            axesInUse_.add(axis);
+            if (maxIndex_.getIndex(axis) < coords.getIndex(axis)) {
+               maxIndex_ = maxIndex_.copyBuilder()
+                     .index(axis, coords.getIndex(axis))
+                     .build();
+            }
+         }
+         spill = !spillFailed_ && !closed_;
+         if (spill) {
+            Image pending = unflushed_.put(coords, image);
+            if (pending != null) {
+               unflushedBytes_ -= sizeOf(pending);
+            }
+            unflushedBytes_ += sizeOf(image);
+         }
+      }
+      if (spill) {
+         flusher_.submit(() -> flush(image));
+      }
+   }
+
+   /**
+    * Writes an image to the spill store, on the flusher thread.
+    */
+   private void flush(Image image) {
+      try {
+         SummaryMetadata summary = null;
+         synchronized (this) {
+            if (spillFailed_ || closed_) {
+               return;
+            }
+            if (!summaryForwarded_) {
+               // The summary arrives long before the first image, but through
+               // an asynchronous event, so it is passed on here rather than in
+               // onNewSummary.
+               summaryForwarded_ = true;
+               summary = summaryMetadata_;
+            }
+         }
+         if (summary != null) {
+            spill_.setSummaryMetadata(summary);
+         }
+         spill_.putImage(image);
+      } catch (IOException | RuntimeException e) {
+         ReportingUtils.logError(e, "Unable to spill images to disk, keeping them in RAM");
+         synchronized (this) {
+            spillFailed_ = true;
+            unflushed_.clear();
+            unflushedBytes_ = 0;
+            notifyAll();
+         }
+         return;
+      }
+      synchronized (this) {
+         // An image that was replaced while being written stays unflushed
+         if (unflushed_.remove(image.getCoords(), image)) {
+            unflushedBytes_ -= sizeOf(image);
+         }
+         evict();
+         notifyAll();
+      }
+   }
+
+   /**
+    * Drops the oldest images that have been written from RAM until we are
+    * within budget. Images are written in order, so we can stop at the first
+    * one that has not been written.
+    */
+   private void evict() {
+      Iterator<Map.Entry<Coords, Image>> it = ramImages_.entrySet().iterator();
+      while (ramBytes_ > ramBudgetBytes_ && it.hasNext()) {
+         Map.Entry<Coords, Image> entry = it.next();
+         if (unflushed_.containsKey(entry.getKey())) {
+            break;
+         }
+         ramBytes_ -= sizeOf(entry.getValue());
+         it.remove();
+      }
+   }
+
+   /**
+    * Waits until all images have been written to the spill store.
+    */
+   private synchronized void waitForFlush() throws IOException {
+      while (!unflushed_.isEmpty() && !spillFailed_ && !closed_) {
+         try {
+            wait();
+         } catch (InterruptedException e) {
+            Thread.currentThread().interrupt();
+            throw new IOException("Interrupted while waiting for images to be written", e);
+         }
+      }
+   }
+
+   /**
+    * Finishes writing and keeps the spill Datastore when this storage is
+    * closed, so that it becomes a permanent dataset. The images are not
+    * copied.
+    *
+    * @return directory of the spill Datastore
+    * @throws IOException if not all images could be written
+    */
+   public String promote() throws IOException {
+      waitForFlush();
+      synchronized (this) {
+         if (spillFailed_ || closed_) {
+            throw new IOException("Not all images could be written to "
+                  + spill_.getSavePath());
+         }
+         promoted_ = true;
+      }
+      spill_.freeze();
+      return spill_.getSavePath();
+   }
+
+   @Override
+   public void freeze() throws IOException {
+      // Writes to the spill store continue in the background; only promote()
+      // needs them to be finished.
+   }
+
+   @Override
+   public Image getImage(Coords coords) throws IOException {
+      synchronized (this) {
+         Image image = ramImages_.get(coords);
+         if (image != null) {
+            return image;
+         }
+         if (!coords_.contains(coords)) {
+            return null;
+         }
+      }
+      // Only images that were written are evicted, so the spill store has it
+      Image image = spill_.getImage(coords);
+      return image == null ? null : image.copyAtCoords(coords);
+   }
+
+   @Override
+   public Image getAnyImage() {
+      Coords coords;
+      synchronized (this) {
+         if (!ramImages_.isEmpty()) {
+            return ramImages_.values().iterator().next();
+         }
+         if (coords_.isEmpty()) {
+            return null;
+         }
+         coords = coords_.iterator().next();
+      }
+      try {
+         return getImage(coords);
+      } catch (IOException e) {
+         ReportingUtils.logError(e, "Failed to read image at " + coords);
+         return null;
+      }
+   }
+
+   @Override
+   public List<Image> getImagesMatching(Coords coords) throws IOException {
+      List<String> ignoredAxes = new ArrayList<>();
+      synchronized (this) {
+         for (String axis : axesInUse_) {
+            if (!coords.getAxes().contains(axis)) {
+               ignoredAxes.add(axis);
+            }
+         }
+      }
+      return getImagesIgnoringAxes(coords, ignoredAxes.toArray(new String[0]));
+   }
+
+   @Override
+   public List<Image> getImagesIgnoringAxes(Coords coords, String... ignoreTheseAxes)
+         throws IOException {
+      List<Coords> matches = new ArrayList<>();
+      synchronized (this) {
+         if (ignoreTheseAxes.length == 0) {
+            if (coords_.contains(coords)) {
+               matches.add(coords);
+            }
+         } else {
+            for (Coords c : coords_) {
+               if (c.copyRemovingAxes(ignoreTheseAxes).equals(coords)) {
+                  matches.add(c);
+               }
+            }
+         }
+      }
+      List<Image> result = new ArrayList<>(matches.size());
+      for (Coords c : matches) {
+         Image image = getImage(c);
+         if (image != null) {
+            result.add(image);
+         }
+      }
+      return result;
+   }
+
+   @Override
+   public synchronized Iterable<Coords> getUnorderedImageCoords() {
+      return new ArrayList<>(coords_);
+   }
+
+   @Override
+   public synchronized boolean hasImage(Coords coords) {
+      return coords_.contains(coords);
+   }
+
+   @Override
+   public synchronized int getMaxIndex(String axis) {
+      return maxIndex_.getIndex(axis);
+   }
+
+   @Override
+   public synchronized List<String> getAxes() {
+      return summaryMetadata_.getOrderedAxes();
+   }
+
+   @Override
+   public synchronized Coords getMaxIndices() {
+      return maxIndex_;
+   }
+
+   @Override
+   public synchronized SummaryMetadata getSummaryMetadata() {
+      return summaryMetadata_;
+   }
+
+   /**
+    * Receives the new summary through an event.
+    *
+    * @param event this gives use the summary metadata
+    */
+   @Subscribe
+   public synchronized void onNewSummary(DataProviderHasNewSummaryMetadataEvent event) {
+      summaryMetadata_ = event.getSummaryMetadata();
+   }
+
+   @Override
+   public synchronized int getNumImages() {
+      return coords_.size();
+   }
+
+   /**
+    * Returns the number of bytes of pixel data currently held in RAM.
+    */
+   synchronized long getRamBytes() {
+      return ramBytes_;
+   }
+
+   @Override
+   public void close() throws IOException {
+      final boolean promoted;
+      synchronized (this) {
+         if (closed_) {
+            return;
+         }
+         closed_ = true;
+         promoted = promoted_;
+         notifyAll();
+      }
+      flusher_.shutdownNow();
+      try {
+         flusher_.awaitTermination(10, TimeUnit.SECONDS);
+      } catch (InterruptedException e) {
+         Thread.currentThread().interrupt();
+      }
+      String spillPath = spill_.getSavePath();
+      try {
+         spill_.close();
+      } catch (IOException | RuntimeException e) {
+         ReportingUtils.logError(e, "Error closing spill store " + spillPath);
+      }
+      if (!promoted && spillPath != null) {
+         try {
+            FileUtils.deleteDirectory(new File(spillPath));
+         } catch (IOException e) {
+            ReportingUtils.logError(e, "Unable to delete " + spillPath);
+         }
+      }
+      synchronized (this) {
+         ramImages_.clear();
+         ramBytes_ = 0;
+      }
+   }
+}
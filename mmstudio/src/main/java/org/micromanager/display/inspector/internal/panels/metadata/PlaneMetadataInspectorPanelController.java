@@ -2,6 +2,8 @@ package org.micromanager.display.inspector.internal.panels.metadata;
 
 import com.google.common.base.Preconditions;
 import com.google.common.eventbus.Subscribe;
+import java.awt.Color;
+import java.awt.Component;
 import java.awt.Dimension;
 import java.awt.Insets;
 import java.awt.event.ActionEvent;
@@ -9,10 +11,9 @@ import java.awt.event.ActionListener;
 import java.io.IOException;
 import java.util.ArrayList;
 import java.util.Collections;
-import java.util.HashMap;
+import java.util.HashSet;
 import java.util.List;
-import java.util.Map;
-import java.util.TreeMap;
+import java.util.Set;
 import java.util.concurrent.ExecutorService;
 import java.util.concurrent.Executors;
 import javax.swing.BorderFactory;
@@ -27,11 +28,10 @@ import javax.swing.ScrollPaneConstants;
 import javax.swing.event.DocumentEvent;
 import javax.swing.event.DocumentListener;
 import javax.swing.table.AbstractTableModel;
+import javax.swing.table.DefaultTableCellRenderer;
 import net.miginfocom.layout.CC;
 import net.miginfocom.layout.LC;
 import net.miginfocom.swing.MigLayout;
-import org.micromanager.PropertyMap;
-import org.micromanager.PropertyMaps;
 import org.micromanager.data.Image;
 import org.micromanager.data.Metadata;
 import org.micromanager.data.internal.DefaultMetadata;
@@ -58,25 +58,27 @@ public final class PlaneMetadataInspectorPanelController extends AbstractInspect
    // Access: guarded by monitor on this
    private boolean displayChangedValuesOnly_;
 
-   private static boolean expanded_;
+   // Written on EDT, read from background executor
+   private volatile String searchFilter_ = "";
 
-   // Access: from background executor only; list must not be modified once set
-   private TreeMap<String, String> data_ = new TreeMap<String, String>();
+   private static boolean expanded_;
 
    // Access: from background executor only
-   private final Map<String, String> unchangingValues_ =
-         new HashMap<String, String>();
+   private final PlaneMetadataRows rows_ = new PlaneMetadataRows();
 
-   // Access: from background executor only
-   private boolean unchangingValuesInitialized_;
+   // Access: from background executor only; the rows last sent to the EDT
+   private List<PlaneMetadataRows.Row> sentRows_ = Collections.emptyList();
 
    // Access: from EDT only; list must not be modified once set
-   private List<Map.Entry<String, String>> displayData_ = Collections.emptyList();
+   private List<PlaneMetadataRows.Row> displayRows_ = Collections.emptyList();
+
+   // Access: from EDT only; keys that changed in the last shown plane
+   private Set<String> highlightedKeys_ = Collections.emptySet();
 
    private final AbstractTableModel tableModel_ = new AbstractTableModel() {
       @Override
       public int getRowCount() {
-         return displayData_.size();
+         return displayRows_.size();
       }
 
       @Override
@@ -98,12 +100,13 @@ public final class PlaneMetadataInspectorPanelController extends AbstractInspect
 
       @Override
       public Object getValueAt(int rowIndex, int columnIndex) {
-         Map.Entry<String, String> entry = displayData_.get(rowIndex);
+         PlaneMetadataRows.Row row = displayRows_.get(rowIndex);
          switch (columnIndex) {
             case 0:
-               return entry.getKey();
+               return row.getKey();
             case 1:
-               return entry.getValue();
+               // Only formatted once the row is painted
+               return row.getValue();
             default:
                throw new IndexOutOfBoundsException();
          }
@@ -135,6 +138,34 @@ public final class PlaneMetadataInspectorPanelController extends AbstractInspect
       table_.setAutoResizeMode(JTable.AUTO_RESIZE_LAST_COLUMN);
       table_.setFillsViewportHeight(true);
       table_.setPreferredScrollableViewportSize(new Dimension(240, 180));
+      table_.setDefaultRenderer(Object.class, new DefaultTableCellRenderer() {
+         private Color background_;
+         private Color changedBackground_;
+
+         @Override
+         public Component getTableCellRendererComponent(JTable table, Object value,
+               boolean isSelected, boolean hasFocus, int row, int column) {
+            Component component = super.getTableCellRendererComponent(
+                  table, value, isSelected, hasFocus, row, column);
+            if (!isSelected) {
+               boolean changed = row < displayRows_.size()
+                     && highlightedKeys_.contains(displayRows_.get(row).getKey());
+               component.setBackground(changed ? changedBackground(table.getBackground())
+                     : table.getBackground());
+            }
+            return component;
+         }
+
+         // Tint the background towards yellow, so that this works with dark themes too
+         private Color changedBackground(Color background) {
+            if (!background.equals(background_)) {
+               background_ = background;
+               changedBackground_ = new Color((background.getRed() + 255) / 2,
+                     (background.getGreen() + 200) / 2, background.getBlue() / 2);
+            }
+            return changedBackground_;
+         }
+      });
 
       scrollPane_ = new JScrollPane(table_,
             ScrollPaneConstants.VERTICAL_SCROLLBAR_AS_NEEDED,
@@ -143,6 +174,9 @@ public final class PlaneMetadataInspectorPanelController extends AbstractInspect
       panel_.add(scrollPane_, new CC().grow().push().wrap());
 
       changingOnlyCheckBox_ = new JCheckBox("Hide Constant Values");
+      changingOnlyCheckBox_.setToolTipText(
+            "Only show values that changed since the first image shown. "
+            + "Values that changed in the current image are highlighted.");
       changingOnlyCheckBox_.setSelected(displayChangedValuesOnly_);
       changingOnlyCheckBox_.addActionListener(new ActionListener() {
          @Override
@@ -167,17 +201,17 @@ public final class PlaneMetadataInspectorPanelController extends AbstractInspect
             new DocumentListener() {
                @Override
                public void changedUpdate(DocumentEvent e) {
-                  updateMetadata(metadata_, true);
+                  onSearchFilterChanged();
                }
 
                @Override
                public void insertUpdate(DocumentEvent e) {
-                  updateMetadata(metadata_, true);
+                  onSearchFilterChanged();
                }
 
                @Override
                public void removeUpdate(DocumentEvent e) {
-                  updateMetadata(metadata_, true);
+                  onSearchFilterChanged();
                }
             });
       panel_.add(searchFilterText_, "gapleft 3, gapbottom 10, growx");
@@ -190,6 +224,11 @@ public final class PlaneMetadataInspectorPanelController extends AbstractInspect
       panel_.add(clearFilterButton, "gapbottom 10, growy, aligny center, wrap");
    }
 
+   private void onSearchFilterChanged() {
+      searchFilter_ = searchFilterText_.getText().toLowerCase();
+      background_.submit(() -> updateMetadata(metadata_, true));
+   }
+
    @Override
    public String getTitle() {
       return "Image Plane Metadata";
@@ -220,8 +259,8 @@ public final class PlaneMetadataInspectorPanelController extends AbstractInspect
       background_.submit(() -> {
          // Note: This will initialize all state even if we receive an
          // event from the viewer before we get here.
-         unchangingValues_.clear();
-         unchangingValuesInitialized_ = false;
+         rows_.reset();
+         metadata_ = null;
          if (finalImages == null || finalImages.isEmpty()) {
             updateMetadata(null, true);
          } else {
@@ -260,92 +299,131 @@ public final class PlaneMetadataInspectorPanelController extends AbstractInspect
       return expanded_;
    }
 
+   /**
+    * Diffs the metadata against that of the previously shown plane, and
+    * hands the result to the EDT, which only repaints the rows that changed.
+    *
+    * @param metadata metadata of the plane shown, or null
+    * @param evenIfUnchanged also update when the plane is the same, because
+    *                        the filters changed
+    */
    private void updateMetadata(Metadata metadata, boolean evenIfUnchanged) {
       if (!evenIfUnchanged && metadata == metadata_) {
          return;
       }
-      metadata_ = metadata;
-
-      PropertyMap metadataMap = metadata == null
-            ? PropertyMaps.emptyPropertyMap() : ((DefaultMetadata) metadata).toPropertyMap();
-
-      final TreeMap<String, String> data = new TreeMap<>();
-      for (String key : metadataMap.keySet()) {
-         if ("ScopeData".equals(key)) {
-            PropertyMap scopeData = metadataMap.getPropertyMap(key, null);
-            for (String subkey : scopeData.keySet()) {
-               data.put("device:" + subkey, scopeData.getValueAsString(subkey, ""));
-            }
-         } else if ("UserData".equals(key)) {
-            PropertyMap userData = metadataMap.getPropertyMap(key, null);
-            for (String subkey : userData.keySet()) {
-               data.put("user:" + subkey, userData.getValueAsString(subkey, ""));
-            }
-         } else {
-            data.put(key, metadataMap.getValueAsString(key, ""));
-         }
+      if (metadata != metadata_) {
+         rows_.update(metadata == null
+               ? null : ((DefaultMetadata) metadata).toPropertyMap());
       }
+      metadata_ = metadata;
 
       boolean changedOnly;
       synchronized (this) {
          changedOnly = displayChangedValuesOnly_;
       }
-      final List<Map.Entry<String, String>> displayData;
-      final boolean search = !searchFilterText_.getText().equals("");
-      if (changedOnly) {
-         if (!unchangingValuesInitialized_) {
-            if (!data.isEmpty()) {
-               unchangingValues_.putAll(data);
-               unchangingValuesInitialized_ = true;
-            }
-            displayData = new ArrayList<>();
-            for (Map.Entry<String, String> entry : data.entrySet()) {
-               if (!search || entry.getKey().toLowerCase()
-                     .contains(searchFilterText_.getText().toLowerCase())) {
-                  displayData.add(entry);
-               }
-            }
-         } else {
-            displayData = new ArrayList<Map.Entry<String, String>>();
-            unchangingValues_.entrySet().retainAll(data.entrySet());
-            for (Map.Entry<String, String> entry : data.entrySet()) {
-               if (!unchangingValues_.containsKey(entry.getKey())) {
-                  if (!search || entry.getKey().toLowerCase()
-                        .contains(searchFilterText_.getText().toLowerCase())) {
-                     displayData.add(entry);
-                  }
-               }
-            }
-         }
+      final String filter = searchFilter_;
+      final List<PlaneMetadataRows.Row> rows = rows_.getRows();
+      final List<PlaneMetadataRows.Row> displayRows;
+      if (!changedOnly && filter.isEmpty()) {
+         displayRows = rows;
       } else {
-         displayData = new ArrayList<>();
-         for (Map.Entry<String, String> entry : data.entrySet()) {
-            if (!search || entry.getKey().toLowerCase()
-                  .contains(searchFilterText_.getText().toLowerCase())) {
-               displayData.add(entry);
+         displayRows = new ArrayList<>();
+         for (PlaneMetadataRows.Row row : rows) {
+            if ((!changedOnly || rows_.hasChanged(row.getKey()))
+                  && (filter.isEmpty() || row.keyContains(filter))) {
+               displayRows.add(row);
             }
          }
       }
 
-      data_ = data;
+      final boolean structureChanged = !sameKeys(sentRows_, displayRows);
+      sentRows_ = displayRows;
+      runnablePool_.invokeAsLateAsPossibleWithCoalescence(
+            new TableUpdate(displayRows, rows_.getChangedKeys(), structureChanged));
+   }
 
-      runnablePool_.invokeAsLateAsPossibleWithCoalescence(new CoalescentRunnable() {
-         @Override
-         public Class<?> getCoalescenceClass() {
-            return UpdateTag.class;
+   private static boolean sameKeys(List<PlaneMetadataRows.Row> a,
+                                   List<PlaneMetadataRows.Row> b) {
+      if (a == b) {
+         return true;
+      }
+      if (a.size() != b.size()) {
+         return false;
+      }
+      for (int i = 0; i < a.size(); i++) {
+         // Rows keep their key string when their value changes
+         if (!a.get(i).getKey().equals(b.get(i).getKey())) {
+            return false;
          }
+      }
+      return true;
+   }
 
-         @Override
-         public CoalescentRunnable coalesceWith(CoalescentRunnable later) {
-            return later;
+   /**
+    * Rows to be shown on the EDT. When updates are coalesced, the changed
+    * keys of all of them are repainted.
+    */
+   private final class TableUpdate implements CoalescentRunnable {
+      private final List<PlaneMetadataRows.Row> newRows_;
+      private final Set<String> changedKeys_;
+      private final boolean structureChanged_;
+
+      TableUpdate(List<PlaneMetadataRows.Row> rows, Set<String> changedKeys,
+                  boolean structureChanged) {
+         newRows_ = rows;
+         changedKeys_ = changedKeys;
+         structureChanged_ = structureChanged;
+      }
+
+      @Override
+      public Class<?> getCoalescenceClass() {
+         return UpdateTag.class;
+      }
+
+      @Override
+      public CoalescentRunnable coalesceWith(CoalescentRunnable another) {
+         TableUpdate later = (TableUpdate) another;
+         if (structureChanged_ || later.structureChanged_) {
+            // Everything is redrawn; the highlight is that of the latest plane
+            return new TableUpdate(later.newRows_, later.changedKeys_, true);
          }
+         Set<String> changedKeys = new HashSet<>(changedKeys_);
+         changedKeys.addAll(later.changedKeys_);
+         return new TableUpdate(later.newRows_, changedKeys, false);
+      }
 
-         @Override
-         public void run() {
-            displayData_ = displayData;
+      @Override
+      public void run() {
+         final Set<String> previouslyHighlighted = highlightedKeys_;
+         displayRows_ = newRows_;
+         highlightedKeys_ = changedKeys_;
+         if (structureChanged_) {
             tableModel_.fireTableDataChanged();
+            return;
          }
-      });
+         if (newRows_.isEmpty()
+               || (changedKeys_.isEmpty() && previouslyHighlighted.isEmpty())) {
+            return;
+         }
+         if (2 * (changedKeys_.size() + previouslyHighlighted.size()) > newRows_.size()) {
+            tableModel_.fireTableRowsUpdated(0, newRows_.size() - 1);
+            return;
+         }
+         // Repaint the changed rows, and the rows that are no longer highlighted,
+         // as few contiguous ranges
+         int first = -1;
+         for (int i = 0; i <= newRows_.size(); i++) {
+            boolean repaint = i < newRows_.size()
+                  && (changedKeys_.contains(newRows_.get(i).getKey())
+                  || previouslyHighlighted.contains(newRows_.get(i).getKey()));
+            if (repaint && first < 0) {
+               first = i;
+            } else if (!repaint && first >= 0) {
+               tableModel_.fireTableRowsUpdated(first, i - 1);
+               first = -1;
+            }
+         }
+      }
    }
 
    private final class UpdateTag {
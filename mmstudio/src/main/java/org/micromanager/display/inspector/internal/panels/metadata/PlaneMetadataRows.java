@@ -0,0 +1,270 @@
+package org.micromanager.display.inspector.internal.panels.metadata;
+
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.HashMap;
+import java.util.HashSet;
+import java.util.List;
+import java.util.Map;
+import java.util.Set;
+import org.micromanager.PropertyMap;
+import org.micromanager.PropertyMaps;
+import org.micromanager.internal.propertymap.DefaultPropertyMap;
+
+/**
+ * Flattened image plane metadata, as shown in the Image Plane Metadata panel,
+ * together with the key-level difference to the previously shown plane.
+ *
+ * <p>When consecutive planes have the same keys, which is the usual case
+ * during live view and acquisition, rows whose value did not change are
+ * carried over as is, and the rows do not need to be sorted again.
+ *
+ * <p>Not thread safe. Rows, and lists of rows, are never modified once
+ * handed out, except for caching their formatted value.
+ */
+final class PlaneMetadataRows {
+   private static final String SCOPE_DATA = "ScopeData";
+   private static final String USER_DATA = "UserData";
+
+   // Sections of the metadata, and the prefix of their keys in the table
+   private static final int TOP = 0;
+   private static final int SCOPE = 1;
+   private static final int USER = 2;
+   private static final String[] PREFIXES = {"", "device:", "user:"};
+
+   /**
+    * A row of the table. The value is only formatted when it is asked for,
+    * which the table only does for rows that are visible.
+    */
+   static final class Row {
+      private final int section_;
+      private final String name_;
+      private final String key_;
+      private final PropertyMap source_;
+      // Access: from background executor only
+      private String lowerCaseKey_;
+      // Access: from EDT only
+      private String value_;
+
+      private Row(int section, String name, String key, PropertyMap source) {
+         section_ = section;
+         name_ = name;
+         key_ = key;
+         source_ = source;
+      }
+
+      String getKey() {
+         return key_;
+      }
+
+      /**
+       * Tells whether the key contains the filter text, ignoring case.
+       *
+       * @param lowerCaseFilter filter text, in lower case
+       */
+      boolean keyContains(String lowerCaseFilter) {
+         if (lowerCaseKey_ == null) {
+            lowerCaseKey_ = key_.toLowerCase();
+         }
+         return lowerCaseKey_.contains(lowerCaseFilter);
+      }
+
+      String getValue() {
+         if (value_ == null) {
+            value_ = source_.getValueAsString(name_, "");
+         }
+         return value_;
+      }
+
+      boolean isFormatted() {
+         return value_ != null;
+      }
+   }
+
+   /**
+    * The rows for a plane, and which of them differ from the previous plane.
+    */
+   static final class Update {
+      private final List<Row> rows_;
+      private final Set<String> changedKeys_;
+      private final boolean keysChanged_;
+
+      private Update(List<Row> rows, Set<String> changedKeys, boolean keysChanged) {
+         rows_ = rows;
+         changedKeys_ = changedKeys;
+         keysChanged_ = keysChanged;
+      }
+
+      /**
+       * All rows, sorted by key.
+       */
+      List<Row> getRows() {
+         return rows_;
+      }
+
+      /**
+       * Keys that were added or whose value changed. Empty for the first
+       * plane after a reset.
+       */
+      Set<String> getChangedKeys() {
+         return changedKeys_;
+      }
+
+      /**
+       * Whether the set of keys differs from that of the previous plane.
+       */
+      boolean keysChanged() {
+         return keysChanged_;
+      }
+   }
+
+   private final PropertyMap[] sources_ = new PropertyMap[3];
+   @SuppressWarnings("unchecked")
+   private final Map<String, Row>[] rowsByName_ = new Map[] {
+         new HashMap<String, Row>(), new HashMap<String, Row>(), new HashMap<String, Row>()};
+   private List<Row> rows_ = Collections.emptyList();
+   private Set<String> changedKeys_ = Collections.emptySet();
+   // Keys whose value changed since the first plane after a reset
+   private final Set<String> everChangedKeys_ = new HashSet<>();
+   private boolean initialized_;
+
+   /**
+    * Forgets all planes seen so far, so that the next plane is compared to
+    * nothing and becomes the reference for {@link #hasChanged}.
+    */
+   void reset() {
+      for (int s = 0; s < sources_.length; s++) {
+         sources_[s] = null;
+         rowsByName_[s].clear();
+      }
+      rows_ = Collections.emptyList();
+      changedKeys_ = Collections.emptySet();
+      everChangedKeys_.clear();
+      initialized_ = false;
+   }
+
+   /**
+    * Returns the rows of the plane last passed to {@link #update}.
+    */
+   List<Row> getRows() {
+      return rows_;
+   }
+
+   /**
+    * Returns the keys that changed in the last call to {@link #update}.
+    */
+   Set<String> getChangedKeys() {
+      return changedKeys_;
+   }
+
+   /**
+    * Tells whether the value of a key differed, at any time since the first
+    * plane after a reset, from its value in that first plane.
+    *
+    * @param key row key
+    * @return true if the value is not constant
+    */
+   boolean hasChanged(String key) {
+      return !initialized_ || everChangedKeys_.contains(key);
+   }
+
+   /**
+    * Computes the rows for the metadata of a new plane.
+    *
+    * @param metadata metadata of the plane, as a property map
+    * @return the rows, and how they differ from the previous plane
+    */
+   Update update(PropertyMap metadata) {
+      if (metadata == null) {
+         metadata = PropertyMaps.emptyPropertyMap();
+      }
+      PropertyMap[] sources = new PropertyMap[3];
+      sources[TOP] = metadata;
+      sources[SCOPE] = metadata.containsPropertyMap(SCOPE_DATA)
+            ? metadata.getPropertyMap(SCOPE_DATA, null) : PropertyMaps.emptyPropertyMap();
+      sources[USER] = metadata.containsPropertyMap(USER_DATA)
+            ? metadata.getPropertyMap(USER_DATA, null) : PropertyMaps.emptyPropertyMap();
+
+      final Set<String> changed = new HashSet<>();
+      final List<Row> rows;
+      final boolean keysChanged = !sameKeys(sources);
+      if (keysChanged) {
+         rows = new ArrayList<>();
+         for (int s = 0; s < sources.length; s++) {
+            Map<String, Row> previous = rowsByName_[s];
+            Map<String, Row> current = new HashMap<>();
+            for (String name : sources[s].keySet()) {
+               if (s == TOP && (SCOPE_DATA.equals(name) || USER_DATA.equals(name))) {
+                  continue;
+               }
+               Row row = previous.get(name);
+               if (row == null || !DefaultPropertyMap.valuesEqual(
+                     row.source_, sources[s], name)) {
+                  String key = row == null ? PREFIXES[s] + name : row.key_;
+                  row = new Row(s, name, key, sources[s]);
+                  changed.add(key);
+               }
+               current.put(name, row);
+               rows.add(row);
+            }
+            rowsByName_[s] = current;
+         }
+         rows.sort((a, b) -> a.key_.compareTo(b.key_));
+      } else {
+         // Same keys, hence same order: only replace the rows that changed
+         rows = new ArrayList<>(rows_.size());
+         for (Row row : rows_) {
+            PropertyMap source = sources[row.section_];
+            if (source != sources_[row.section_] && !DefaultPropertyMap.valuesEqual(
+                  row.source_, source, row.name_)) {
+               row = new Row(row.section_, row.name_, row.key_, source);
+               rowsByName_[row.section_].put(row.name_, row);
+               changed.add(row.key_);
+            }
+            rows.add(row);
+         }
+      }
+      System.arraycopy(sources, 0, sources_, 0, sources.length);
+      rows_ = Collections.unmodifiableList(rows);
+
+      if (!initialized_) {
+         // The first plane is the reference, nothing has changed yet
+         changed.clear();
+         initialized_ = !rows.isEmpty();
+      } else {
+         everChangedKeys_.addAll(changed);
+      }
+      changedKeys_ = Collections.unmodifiableSet(changed);
+      return new Update(rows_, changedKeys_, keysChanged);
+   }
+
+   /**
+    * Whether the new plane has the same keys, in each section, as the
+    * previous one.
+    */
+   private boolean sameKeys(PropertyMap[] sources) {
+      if (sources_[TOP] == null) {
+         return false;
+      }
+      for (int s = 0; s < sources.length; s++) {
+         if (sources[s] == sources_[s]) {
+            continue;
+         }
+         Map<String, Row> previous = rowsByName_[s];
+         int size = 0;
+         for (String name : sources[s].keySet()) {
+            if (s == TOP && (SCOPE_DATA.equals(name) || USER_DATA.equals(name))) {
+               continue;
+            }
+            if (!previous.containsKey(name)) {
+               return false;
+            }
+            size++;
+         }
+         if (size != previous.size()) {
+            return false;
+         }
+      }
+      return true;
+   }
+}
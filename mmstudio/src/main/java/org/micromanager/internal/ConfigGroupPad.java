@@ -25,6 +25,7 @@ package org.micromanager.internal;
 
 import java.util.ArrayList;
 import java.util.HashMap;
+import java.util.Map;
 import javax.swing.JScrollPane;
 import javax.swing.JTable;
 import javax.swing.ListSelectionModel;
@@ -129,6 +130,19 @@ public final class ConfigGroupPad extends JScrollPane {
       }
    }
 
+   /**
+    * Shows the current presets of groups that changed.
+    *
+    * @param configs current preset of each group that changed, as reported by
+    *                the {@link SystemStateService}
+    */
+   public void applyConfigs(Map<String, String> configs) {
+      if (data_ != null) {
+         data_.applyConfigs(configs);
+         table_.repaint();
+      }
+   }
+
    /**
     * Returns the group selected by the user.
     *
@@ -167,7 +181,7 @@ public final class ConfigGroupPad extends JScrollPane {
          return "";
       } else {
          try {
-            return data_.core_.getCurrentConfig((String) data_.getValueAt(idx, 0));
+            return data_.core_.getCurrentConfigFromCache((String) data_.getValueAt(idx, 0));
          } catch (Exception e) {
             ReportingUtils.logError(e);
             return null;
@@ -192,7 +206,9 @@ public final class ConfigGroupPad extends JScrollPane {
 
       public StateTableData(CMMCore core) {
          core_ = core;
-         rebuildModel(false);
+         // The cache is up to date after loading a configuration, and is
+         // refreshed in the background afterwards
+         rebuildModel(true);
       }
 
       @Override
@@ -228,6 +244,7 @@ public final class ConfigGroupPad extends JScrollPane {
          StateItem item = groupList_.get(row);
          if (col == 1) {
             if (value != null && value.toString().length() > 0) {
+               boolean resumeWhenRefreshed = false;
                try {
                   studio_.live().setSuspended(true);
                   if (item.singleProp) {
@@ -253,29 +270,36 @@ public final class ConfigGroupPad extends JScrollPane {
                                  item.group, value.toString(), core_.getExposure()));
                   }
 
-                  // By updating the system cache here we are able to use it in 
-                  // `refreshStatus` and when updating the GUI rather than needing 
-                  // repeatedly query the same properties in both operations.
-                  studio_.core().updateSystemStateCache();
-                  refreshStatus();
-                  table_.repaint();
                   // This is a little superfluous, but it is nice that we
                   // are depending only on Studio, not MMStudio
                   // directly, so keep it that way.
                   if (studio_ instanceof MMStudio) {
-                     // But it appears to be important for performance that
-                     // we use the non-config-pad-updating version of
-                     // MMStudio.refreshGUI().
-                     MMStudio parentGUI = (MMStudio) studio_;
-                     parentGUI.uiManager().updateGUI(false, true);
+                     // The system cache is updated in the background, after
+                     // which changed presets are shown and the rest of the
+                     // GUI is updated from the cache, using the
+                     // non-config-pad-updating version of MMStudio.refreshGUI().
+                     final MMUIManager uiManager = ((MMStudio) studio_).uiManager();
+                     uiManager.systemState().refresh(() -> {
+                        uiManager.updateGUI(false, true);
+                        studio_.live().setSuspended(false);
+                     });
+                     resumeWhenRefreshed = true;
                   } else {
+                     // By updating the system cache here we are able to use it in
+                     // `refreshStatus` and when updating the GUI rather than needing
+                     // repeatedly query the same properties in both operations.
+                     studio_.core().updateSystemStateCache();
+                     refreshStatus();
+                     table_.repaint();
                      studio_.app().refreshGUIFromCache();
                   }
 
                } catch (Exception e) {
                   handleException(e);
                } finally {
-                  studio_.live().setSuspended(false);
+                  if (!resumeWhenRefreshed) {
+                     studio_.live().setSuspended(false);
+                  }
                }
             }
          }
@@ -387,6 +411,37 @@ public final class ConfigGroupPad extends JScrollPane {
          }
       }
 
+      /**
+       * Sets the presets of groups that changed; single property groups show
+       * the cached value of their property.
+       *
+       * @param configs current preset of each group that changed
+       */
+      public void applyConfigs(Map<String, String> configs) {
+         for (int row = 0; row < groupList_.size(); row++) {
+            StateItem item = groupList_.get(row);
+            String config = configs.get(item.group);
+            if (config == null) {
+               continue;
+            }
+            try {
+               if (item.singleProp) {
+                  item.config = core_.getPropertyFromCache(item.device, item.name);
+               } else {
+                  item.config = config;
+                  if (config.length() > 0) {
+                     item.descr = core_.getConfigData(item.group, config).getVerbose();
+                  } else {
+                     item.descr = "";
+                  }
+               }
+            } catch (Exception e) {
+               ReportingUtils.logError(e);
+            }
+            fireTableRowsUpdated(row, row);
+         }
+      }
+
       /**
        * TODO.
        *
@@ -23,8 +23,11 @@ package org.micromanager.internal;
 
 import com.google.common.eventbus.Subscribe;
 import java.awt.Color;
+import java.io.File;
 import java.io.IOException;
 import java.util.Collection;
+import java.util.Map;
+import java.util.concurrent.ConcurrentHashMap;
 import org.micromanager.Album;
 import org.micromanager.Studio;
 import org.micromanager.data.Coordinates;
@@ -36,28 +39,59 @@ import org.micromanager.data.Image;
 import org.micromanager.data.Pipeline;
 import org.micromanager.data.PipelineErrorException;
 import org.micromanager.data.SummaryMetadata;
+import org.micromanager.data.internal.DefaultDatastore;
 import org.micromanager.data.internal.PropertyKey;
+import org.micromanager.data.internal.SpillLock;
+import org.micromanager.data.internal.StorageTiered;
 import org.micromanager.display.DisplaySettings;
 import org.micromanager.display.DisplayWindow;
 import org.micromanager.display.internal.DefaultDisplaySettings;
 import org.micromanager.display.internal.RememberedDisplaySettings;
 import org.micromanager.display.internal.event.DataViewerWillCloseEvent;
 import org.micromanager.internal.utils.ReportingUtils;
+import org.micromanager.propertymap.MutablePropertyMapView;
 
 /**
  * Implementation of the Album interface.
+ *
+ * <p>The album keeps the most recent images in RAM, up to a budget, and
+ * spills all images to a temporary NDTiff dataset in the background, so that
+ * long sessions do not exhaust the heap. The budget (in MB) and the directory
+ * for the temporary datasets are read from the profile. Temporary datasets
+ * left behind by a crash are deleted at startup.
  */
 public final class DefaultAlbum implements Album {
+   private static final String RAM_BUDGET_MB = "RAM budget (MB)";
+   private static final String SPILL_DIRECTORY = "Spill directory";
+
    private final Studio studio_;
    private DisplayWindow display_;
    private Datastore store_;
+   private StorageTiered storage_;
    private Integer curTime_ = null;
    private Pipeline pipeline_;
    private final Object pipelineLock_ = new Object();
+   // Locks of the temporary datasets of albums that are still open
+   private final Map<Datastore, SpillLock> spillLocks_ = new ConcurrentHashMap<>();
 
    public DefaultAlbum(Studio studio) {
       studio_ = studio;
       studio_.displays().registerForEvents(this);
+      final File spillRoot = new File(getSpillRoot());
+      Thread sweeper = new Thread(() -> {
+         int swept = SpillLock.sweep(spillRoot);
+         if (swept > 0) {
+            studio_.logs().logMessage("Deleted " + swept
+                  + " stale album dataset(s) in " + spillRoot);
+         }
+      }, "Album cleanup");
+      sweeper.setDaemon(true);
+      sweeper.start();
+   }
+
+   private String getSpillRoot() {
+      return studio_.profile().getSettings(DefaultAlbum.class).getString(SPILL_DIRECTORY,
+            new File(System.getProperty("java.io.tmpdir"), "MMAlbum").getPath());
    }
 
    @Override
@@ -106,7 +140,7 @@ public final class DefaultAlbum implements Album {
       if (mustCreateNew) {
          // Need to create a new album.
 
-         store_ = studio_.data().createRAMDatastore();
+         store_ = createStore();
 
          try {
             SummaryMetadata.Builder smb = studio_.acquisitions()
@@ -189,6 +223,67 @@ public final class DefaultAlbum implements Album {
       return mustCreateNew;
    }
 
+   /**
+    * Creates the Datastore for a new album: tiered RAM/disk storage, or RAM
+    * only when the temporary dataset can not be created.
+    */
+   private Datastore createStore() {
+      MutablePropertyMapView settings = studio_.profile().getSettings(DefaultAlbum.class);
+      long maxMemoryMB = Runtime.getRuntime().maxMemory() / (1024 * 1024);
+      long budgetMB = settings.getLong(RAM_BUDGET_MB, Math.min(512L, maxMemoryMB / 4));
+      String spillRoot = getSpillRoot();
+      SpillLock lock = null;
+      try {
+         new File(spillRoot).mkdirs();
+         String spillDir = studio_.data().getUniqueSaveDirectory(
+               new File(spillRoot, "Album").getPath());
+         lock = SpillLock.acquire(new File(spillDir));
+         Datastore spill = studio_.data().createNDTIFFDatastore(spillDir);
+         DefaultDatastore store = new DefaultDatastore(studio_);
+         storage_ = new StorageTiered(store, spill, budgetMB * 1024 * 1024);
+         store.setStorage(storage_);
+         spillLocks_.put(store, lock);
+         return store;
+      } catch (IOException | RuntimeException e) {
+         if (lock != null) {
+            lock.release();
+         }
+         studio_.logs().logError(e, "Unable to create album spill directory in "
+               + spillRoot + ", keeping the album in RAM");
+         storage_ = null;
+         return studio_.data().createRAMDatastore();
+      }
+   }
+
+   /**
+    * Turns the current album into a permanent NDTiff dataset, without copying
+    * the images. The album is frozen; the next image added starts a new one.
+    * The dataset stays in the spill directory, and is no longer deleted.
+    *
+    * @return directory of the dataset
+    * @throws IOException if there is no album, it is kept in RAM only, or
+    *     not all images could be written
+    */
+   @Override
+   public String promoteToDataset() throws IOException {
+      Datastore store = store_;
+      StorageTiered storage = storage_;
+      if (store == null || storage == null) {
+         throw new IOException("The album is not backed by a dataset on disk");
+      }
+      synchronized (pipelineLock_) {
+         store.freeze();
+         String path = storage.promote();
+         SpillLock lock = spillLocks_.remove(store);
+         if (lock != null) {
+            lock.release();
+         }
+         store.setSavePath(path);
+         store.setName(new File(path).getName());
+         return path;
+      }
+   }
+
    /**
     * Creates Coords for the image to be added to the album.
     *
@@ -235,9 +330,16 @@ public final class DefaultAlbum implements Album {
     */
    @Subscribe
    public void onAlbumStoreClosing(DataViewerWillCloseEvent viewerWillCloseEvent) {
+      // Closing the store deletes its temporary dataset
+      SpillLock lock = spillLocks_.remove(
+            viewerWillCloseEvent.getDataViewer().getDataProvider());
+      if (lock != null) {
+         lock.release();
+      }
       if (viewerWillCloseEvent.getDataViewer().getDataProvider().equals(store_)) {
          saveDisplaySettings();
          store_ = null;
+         storage_ = null;
       }
    }
 
@@ -0,0 +1,341 @@
+///////////////////////////////////////////////////////////////////////////////
+//PROJECT:       Micro-Manager
+//SUBSYSTEM:     mmstudio
+//-----------------------------------------------------------------------------
+//
+// COPYRIGHT:    University of California, San Francisco, 2024
+//
+// LICENSE:      This file is distributed under the BSD license.
+//               License text is included with the source distribution.
+//
+//               This file is distributed in the hope that it will be useful,
+//               but WITHOUT ANY WARRANTY; without even the implied warranty
+//               of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//               IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//               CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//               INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+package org.micromanager.internal;
+
+import java.util.ArrayList;
+import java.util.HashMap;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.function.LongSupplier;
+import org.micromanager.PropertyPoller;
+import org.micromanager.Studio;
+import org.micromanager.internal.utils.ReportingUtils;
+
+/**
+ * Default implementation of the PropertyPoller API.
+ *
+ * <p>A single thread sleeps until the earliest subscription is due, and then
+ * polls all subscriptions that are due, grouped by device, together with
+ * those due within half the minimum period whose property is to be read
+ * anyway. Each device is asked once whether it is busy, and each of its
+ * properties is read once. A property read less than the minimum period ago
+ * is not read again; subscriptions that are due get the value of the last
+ * read instead, unless they already received it.
+ */
+public final class DefaultPropertyPoller implements PropertyPoller {
+
+   /**
+    * Access to the hardware, separated out for testing.
+    */
+   interface Hardware {
+      String getProperty(String device, String property) throws Exception;
+
+      boolean isBusy(String device) throws Exception;
+
+      boolean isAcquisitionRunning();
+   }
+
+   // Subscriptions due within this time are polled together
+   static final long BATCH_WINDOW_MS = MIN_PERIOD_MS / 2;
+   // Periods are multiplied by this while an acquisition is running
+   static final int ACQUISITION_SLOWDOWN = 4;
+   // Largest factor by which periods of a busy device are multiplied
+   static final int MAX_BUSY_BACKOFF = 16;
+
+   private final class DefaultSubscription implements Subscription {
+      private final String device_;
+      private final String property_;
+      private final Listener listener_;
+      // Guarded by DefaultPropertyPoller.this
+      private long periodMs_;
+      private long nextDueMs_;
+      private volatile boolean cancelled_ = false;
+      // Accessed from the polling thread only
+      private Value lastValue_;
+
+      private DefaultSubscription(String device, String property, long periodMs,
+                                  Listener listener, long nowMs) {
+         device_ = device;
+         property_ = property;
+         listener_ = listener;
+         periodMs_ = Math.max(MIN_PERIOD_MS, periodMs);
+         nextDueMs_ = nowMs;
+      }
+
+      @Override
+      public void setPeriodMs(long periodMs) {
+         synchronized (DefaultPropertyPoller.this) {
+            periodMs_ = Math.max(MIN_PERIOD_MS, periodMs);
+            nextDueMs_ = Math.min(nextDueMs_, clock_.getAsLong() + periodMs_);
+            DefaultPropertyPoller.this.notifyAll();
+         }
+      }
+
+      @Override
+      public void postpone(long delayMs) {
+         synchronized (DefaultPropertyPoller.this) {
+            nextDueMs_ = Math.max(nextDueMs_, clock_.getAsLong() + delayMs);
+            DefaultPropertyPoller.this.notifyAll();
+         }
+      }
+
+      @Override
+      public void cancel() {
+         synchronized (DefaultPropertyPoller.this) {
+            cancelled_ = true;
+            subscriptions_.remove(this);
+            DefaultPropertyPoller.this.notifyAll();
+         }
+      }
+   }
+
+   /**
+    * Last value read of a property.
+    */
+   private static final class Read {
+      private final Value value_;
+      private final long readMs_;
+
+      private Read(Value value, long readMs) {
+         value_ = value;
+         readMs_ = readMs;
+      }
+   }
+
+   private final Hardware hardware_;
+   private final LongSupplier clock_;
+   private final boolean threaded_;
+
+   // Guarded by this
+   private final List<DefaultSubscription> subscriptions_ = new ArrayList<>();
+   private final Map<String, Integer> busyBackoff_ = new HashMap<>();
+   private Thread thread_;
+   private boolean shutdown_ = false;
+
+   // Accessed from the polling thread only
+   private final Map<String, Map<String, Read>> lastReads_ = new HashMap<>();
+
+   /**
+    * Creates a poller that reads properties from the Core.
+    *
+    * @param studio the Studio
+    */
+   public DefaultPropertyPoller(final Studio studio) {
+      this(new Hardware() {
+         @Override
+         public String getProperty(String device, String property) throws Exception {
+            return studio.core().getProperty(device, property);
+         }
+
+         @Override
+         public boolean isBusy(String device) throws Exception {
+            return studio.core().deviceBusy(device);
+         }
+
+         @Override
+         public boolean isAcquisitionRunning() {
+            return studio.core().isSequenceRunning()
+                  || studio.acquisitions().isAcquisitionRunning();
+         }
+      }, () -> System.nanoTime() / 1000000L, true);
+   }
+
+   /**
+    * @param hardware access to the devices
+    * @param clock monotonic time in milliseconds
+    * @param threaded whether to poll on a thread; if false, polling is only
+    *                 done by calls to {@link #pollDue()}
+    */
+   DefaultPropertyPoller(Hardware hardware, LongSupplier clock, boolean threaded) {
+      hardware_ = hardware;
+      clock_ = clock;
+      threaded_ = threaded;
+   }
+
+   @Override
+   public synchronized Subscription subscribe(String device, String property, long periodMs,
+                                              Listener listener) {
+      if (shutdown_) {
+         throw new IllegalStateException("Property poller was shut down");
+      }
+      DefaultSubscription subscription = new DefaultSubscription(device, property,
+            periodMs, listener, clock_.getAsLong());
+      subscriptions_.add(subscription);
+      if (threaded_ && thread_ == null) {
+         thread_ = new Thread(this::run, "Property poller");
+         thread_.setDaemon(true);
+         thread_.start();
+      }
+      notifyAll();
+      return subscription;
+   }
+
+   /**
+    * Stops polling. Subscriptions are not called anymore, and no new
+    * subscriptions are accepted.
+    */
+   public synchronized void shutdown() {
+      shutdown_ = true;
+      for (DefaultSubscription subscription : subscriptions_) {
+         subscription.cancelled_ = true;
+      }
+      subscriptions_.clear();
+      notifyAll();
+   }
+
+   private void run() {
+      while (true) {
+         synchronized (this) {
+            while (!shutdown_) {
+               long now = clock_.getAsLong();
+               long next = getNextDueMs();
+               if (next <= now) {
+                  break;
+               }
+               try {
+                  wait(next == Long.MAX_VALUE ? 0 : next - now);
+               } catch (InterruptedException e) {
+                  return;
+               }
+            }
+            if (shutdown_) {
+               return;
+            }
+         }
+         try {
+            pollDue();
+         } catch (RuntimeException e) {
+            ReportingUtils.logError(e, "Error while polling device properties");
+         }
+      }
+   }
+
+   /**
+    * Returns when the earliest subscription is due, or Long.MAX_VALUE if
+    * there are no subscriptions.
+    */
+   synchronized long getNextDueMs() {
+      long next = Long.MAX_VALUE;
+      for (DefaultSubscription subscription : subscriptions_) {
+         next = Math.min(next, subscription.nextDueMs_);
+      }
+      return next;
+   }
+
+   /**
+    * Polls all subscriptions that are due, and schedules their next poll.
+    * Subscriptions that are due within the batching window are polled as
+    * well, if their property needs to be read anyway.
+    */
+   void pollDue() {
+      final long now = clock_.getAsLong();
+      Map<String, List<DefaultSubscription>> due = new LinkedHashMap<>();
+      boolean anyDue = false;
+      synchronized (this) {
+         for (DefaultSubscription subscription : subscriptions_) {
+            if (subscription.nextDueMs_ <= now
+                  || (subscription.nextDueMs_ <= now + BATCH_WINDOW_MS
+                  && needsRead(subscription.device_, subscription.property_, now))) {
+               anyDue |= subscription.nextDueMs_ <= now;
+               due.computeIfAbsent(subscription.device_, d -> new ArrayList<>())
+                     .add(subscription);
+            }
+         }
+      }
+      if (!anyDue) {
+         return;
+      }
+      int slowdown = hardware_.isAcquisitionRunning() ? ACQUISITION_SLOWDOWN : 1;
+      for (Map.Entry<String, List<DefaultSubscription>> entry : due.entrySet()) {
+         pollDevice(entry.getKey(), entry.getValue(), now, slowdown);
+      }
+   }
+
+   private boolean needsRead(String device, String property, long now) {
+      Map<String, Read> reads = lastReads_.get(device);
+      Read read = reads == null ? null : reads.get(property);
+      return read == null || now - read.readMs_ >= MIN_PERIOD_MS;
+   }
+
+   private void pollDevice(String device, List<DefaultSubscription> due, long now,
+                           int slowdown) {
+      boolean busy;
+      try {
+         busy = hardware_.isBusy(device);
+      } catch (Exception e) {
+         // Let the property reads report the problem
+         busy = false;
+      }
+      if (busy) {
+         synchronized (this) {
+            int backoff = Math.min(MAX_BUSY_BACKOFF, 2 * busyBackoff_.getOrDefault(device, 1));
+            busyBackoff_.put(device, backoff);
+            for (DefaultSubscription subscription : due) {
+               subscription.nextDueMs_ = now + subscription.periodMs_ * slowdown * backoff;
+            }
+         }
+         return;
+      }
+
+      Map<String, Read> reads = lastReads_.computeIfAbsent(device, d -> new HashMap<>());
+      Map<String, Value> values = new HashMap<>();
+      for (DefaultSubscription subscription : due) {
+         String property = subscription.property_;
+         if (values.containsKey(property)) {
+            continue;
+         }
+         if (needsRead(device, property, now)) {
+            reads.put(property, new Read(readProperty(device, property), now));
+         }
+         values.put(property, reads.get(property).value_);
+      }
+
+      synchronized (this) {
+         busyBackoff_.remove(device);
+         for (DefaultSubscription subscription : due) {
+            long period = subscription.periodMs_ * slowdown;
+            long next = subscription.nextDueMs_ + period;
+            subscription.nextDueMs_ = next <= now ? now + period : next;
+         }
+      }
+      for (DefaultSubscription subscription : due) {
+         Value value = values.get(subscription.property_);
+         // A value read for another subscription may have been delivered already
+         if (subscription.cancelled_ || value == subscription.lastValue_) {
+            continue;
+         }
+         subscription.lastValue_ = value;
+         try {
+            subscription.listener_.propertyPolled(value);
+         } catch (RuntimeException e) {
+            ReportingUtils.logError(e, "Error in property poller listener");
+         }
+      }
+   }
+
+   private Value readProperty(String device, String property) {
+      try {
+         String value = hardware_.getProperty(device, property);
+         return new Value(device, property, value, null, System.currentTimeMillis());
+      } catch (Exception e) {
+         return new Value(device, property, null, e, System.currentTimeMillis());
+      }
+   }
+}
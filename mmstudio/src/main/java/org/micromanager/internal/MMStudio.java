@@ -52,6 +52,7 @@ import org.micromanager.LogManager;
 import org.micromanager.PluginManager;
 import org.micromanager.PositionListManager;
 import org.micromanager.PropertyManager;
+import org.micromanager.PropertyPoller;
 import org.micromanager.ScriptController;
 import org.micromanager.ShutterManager;
 import org.micromanager.Studio;
@@ -81,7 +82,9 @@ import org.micromanager.events.internal.DefaultStartupCompleteEvent;
 import org.micromanager.events.internal.DefaultSystemConfigurationLoadedEvent;
 import org.micromanager.events.internal.InternalShutdownCommencingEvent;
 import org.micromanager.events.internal.MouseMovesStageStateChangeEvent;
+import org.micromanager.internal.diagnostics.DiagnosticBundleMonitor;
 import org.micromanager.internal.diagnostics.EDTHangLogger;
+import org.micromanager.internal.diagnostics.EDTStallProfiler;
 import org.micromanager.internal.diagnostics.ThreadExceptionLogger;
 import org.micromanager.internal.dialogs.AcqControlDlg;
 import org.micromanager.internal.dialogs.IJVersionCheckDlg;
@@ -138,6 +141,7 @@ public final class MMStudio implements Studio {
    private final DefaultApplication defaultApplication_;
    private final DefaultCompatibilityInterface compatibility_;
    private final PropertyManager propertyManager_;
+   private final DefaultPropertyPoller propertyPoller_;
 
    // Local Classes
    private final MMSettings settings_ = new MMSettings();
@@ -315,6 +319,8 @@ public final class MMStudio implements Studio {
 
       propertyManager_ = new DefaultPropertyManager();
 
+      propertyPoller_ = new DefaultPropertyPoller(studio_);
+
       initializeLogging(core_); // Tell Core to start logging
 
       // We need to be subscribed to the global event bus for plugin loading
@@ -416,6 +422,12 @@ public final class MMStudio implements Studio {
       // Use parameters that ensure a stack trace dump within 10 seconds of an
       // EDT hang (and _no_ dump on hangs under 5.5 seconds)
       EDTHangLogger.startDefault(core_, 4500, 1000);
+      // Profile shorter stalls for the Problem Report: sample at 200 Hz while
+      // an event takes over 100 ms, using at most 0.5% of the time.
+      EDTStallProfiler.startDefault(100, 200, 0.005);
+      // Write diagnostic bundles on EDT hangs, buffer overflows and
+      // exception bursts (and periodically, if set in the profile)
+      DiagnosticBundleMonitor.startDefault(this);
 
       // Move ImageJ window to place where it last was if possible or else (150,150) if not
       if (IJ.getInstance() != null) {
@@ -443,7 +455,12 @@ public final class MMStudio implements Studio {
       // loaded before creating the GUI, so we need to reissue the event.)
       events().post(new DefaultSystemConfigurationLoadedEvent());
       executeStartupScript();
-      ui_.updateGUI(true);
+      // Loading the configuration filled the system state cache, so the GUI
+      // shows the hardware state before plugins are told that startup
+      // completed. The hardware is read again in the background, which also
+      // tells the config pad about presets the startup script changed.
+      ui_.updateGUI(true, true);
+      ui_.systemState().refresh(null);
 
       // Give plugins a chance to initialize their state
       events().post(new DefaultStartupCompleteEvent());
@@ -716,6 +733,8 @@ public final class MMStudio implements Studio {
 
       ui_.cleanupOnClose();
 
+      propertyPoller_.shutdown();
+
       if (zmqServer_ != null) {
          zmqServer_.close();
       }
@@ -734,6 +753,8 @@ public final class MMStudio implements Studio {
 
       synchronized (shutdownLock_) {
          EDTHangLogger.stopDefault();
+         EDTStallProfiler.stopDefault();
+         DiagnosticBundleMonitor.stopDefault();
 
          try {
             if (core_ != null) {
@@ -1176,6 +1197,16 @@ public final class MMStudio implements Studio {
       return propertyManager_;
    }
 
+   @Override
+   public PropertyPoller propertyPoller() {
+      return propertyPoller_;
+   }
+
+   @Override
+   public PropertyPoller getPropertyPoller() {
+      return propertyPoller();
+   }
+
    public UiMovesStageManager getUiMovesStageManager() {
       return uiMovesStageManager_;
    }
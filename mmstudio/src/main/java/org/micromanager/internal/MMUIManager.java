@@ -24,7 +24,10 @@ package org.micromanager.internal;
 import java.awt.event.WindowEvent;
 import java.io.File;
 import java.io.IOException;
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.Executors;
 import javax.swing.JFrame;
+import javax.swing.SwingUtilities;
 import javax.swing.ToolTipManager;
 import mmcorej.MMCoreJ;
 import org.micromanager.PositionList;
@@ -37,6 +40,7 @@ import org.micromanager.internal.positionlist.MMPositionListDlg;
 import org.micromanager.internal.script.ScriptPanel;
 import org.micromanager.internal.utils.FileDialogs;
 import org.micromanager.internal.utils.ReportingUtils;
+import org.micromanager.internal.utils.ThreadFactoryFactory;
 
 
 /**
@@ -52,6 +56,7 @@ public class MMUIManager {
    private MainFrame frame_;
    private final MMStudio studio_;
    private MMPositionListDlg posListDlg_;
+   private final SystemStateService systemState_;
    private static final int TOOLTIP_DISPLAY_DURATION_MILLISECONDS = 15000;
    private static final int TOOLTIP_DISPLAY_INITIAL_DELAY_MILLISECONDS = 2000;
 
@@ -62,6 +67,13 @@ public class MMUIManager {
     */
    public MMUIManager(MMStudio studio) {
       studio_ = studio;
+      systemState_ = new SystemStateService(studio.core(), Executors.newSingleThreadExecutor(
+            ThreadFactoryFactory.createThreadFactory("System state")));
+      systemState_.addListener(configs -> {
+         if (frame_ != null && frame_.getConfigPad() != null) {
+            frame_.getConfigPad().applyConfigs(configs);
+         }
+      });
 
       //Initialize Tooltips
       ToolTipManager ttManager = ToolTipManager.sharedInstance();
@@ -228,6 +240,17 @@ public class MMUIManager {
       frame_.setVisible(true);
       ReportingUtils.setContainingFrame(frame_);
       frame_.initializeConfigPad();
+      studio_.events().registerForEvents(systemState_);
+   }
+
+   /**
+    * Returns the service that updates the system state cache in the
+    * background.
+    *
+    * @return the system state service
+    */
+   public SystemStateService systemState() {
+      return systemState_;
    }
 
    public MainFrame frame() {
@@ -264,20 +287,40 @@ public class MMUIManager {
     *
     * @param updateConfigPadStructure Whether or not to update the Config Pad.
     * @param fromCache                When true, use the cache in the core, otherwise, ask
-    *                                 the hardware (which will update the cache).
+    *                                 the hardware (which will update the cache). On the
+    *                                 EDT, the cache is then updated in the background,
+    *                                 and the GUI is updated once that finished. Other
+    *                                 threads wait until the GUI was updated.
     */
    public void updateGUI(boolean updateConfigPadStructure, boolean fromCache) {
+      if (!fromCache) {
+         if (SwingUtilities.isEventDispatchThread()) {
+            systemState_.refresh(() -> updateGUI(updateConfigPadStructure, true));
+            return;
+         }
+         // Scripts and plugins expect the hardware to have been read on return
+         final CountDownLatch updated = new CountDownLatch(1);
+         systemState_.refresh(() -> {
+            try {
+               updateGUI(updateConfigPadStructure, true);
+            } finally {
+               updated.countDown();
+            }
+         });
+         try {
+            updated.await();
+         } catch (InterruptedException e) {
+            Thread.currentThread().interrupt();
+         }
+         return;
+      }
       ReportingUtils.logMessage("Updating GUI; config pad = "
-            + updateConfigPadStructure + "; from cache = " + fromCache);
+            + updateConfigPadStructure);
       try {
          studio_.cache().refreshValues();
          studio_.getAutofocusManager().refresh();
 
          // The rest of this function uses the cached property values.
-         // If `fromCache` is false, start by updating all properties in the cache.
-         if (!fromCache) {
-            studio_.core().updateSystemStateCache();
-         }
 
          // camera settings
          if (studio_.cache().getCameraLabel().length() > 0) {
@@ -37,7 +37,6 @@ import javax.swing.border.BevelBorder;
 import javax.swing.table.TableColumn;
 import mmcorej.CMMCore;
 import mmcorej.DeviceType;
-import mmcorej.StrVector;
 import net.miginfocom.swing.MigLayout;
 import org.micromanager.Studio;
 import org.micromanager.events.PropertyChangedEvent;
@@ -240,35 +239,14 @@ public final class PropertyEditor extends JFrame {
          }
       }
 
-      public void update(String device, String propName, String newValue) {
-         PropertyItem item = getItem(device, propName);
-         if (item != null) {
-            item.value = newValue;
-            Integer row = propToRow_.get(item);
-            if (row != null) {
-               fireTableCellUpdated(row, propertyValueColumn_);
-            }
-         }
-      }
-
       @Override
       public void update(ShowFlags flags, String groupName, String presetName, boolean fromCache) {
          try {
-            StrVector devices = core_.getLoadedDevices();
             propList_.clear();
-
-            if (!fromCache) {
-               // Some properties may not be readable if we are
-               // mid-acquisition.
-               studio_.live().setSuspended(true);
-            }
-            for (int i = 0; i < devices.size(); i++) {
-               if (data_.showDevice(flags, devices.get(i))) {
-                  StrVector properties = core_.getDevicePropertyNames(devices.get(i));
-                  for (int j = 0; j < properties.size(); j++) {
-                     PropertyItem item = new PropertyItem();
-                     item.readFromCore(core_, devices.get(i), properties.get(j), fromCache);
-
+            updateModel(fromCache);
+            for (String device : model_.getDevices()) {
+               if (data_.showDevice(flags, device)) {
+                  for (PropertyItem item : model_.getItems(device)) {
                      if ((!item.readOnly || showReadOnly_) && !item.preInit) {
                         propList_.add(item);
                      }
@@ -277,15 +255,14 @@ public final class PropertyEditor extends JFrame {
             }
 
             updateRowVisibility(flags);
-
-            if (!fromCache) {
-               studio_.live().setSuspended(false);
-            }
          } catch (Exception e) {
             ReportingUtils.showError(e, "Error updating Device Property Browser");
          }
          this.fireTableStructureChanged();
 
+         if (!fromCache) {
+            readValuesInBackground();
+         }
       }
    }
 }
\ No newline at end of file
@@ -0,0 +1,292 @@
+///////////////////////////////////////////////////////////////////////////////
+//PROJECT:       Micro-Manager
+//SUBSYSTEM:     mmstudio
+//-----------------------------------------------------------------------------
+//
+// COPYRIGHT:    University of California, San Francisco, 2024
+//
+// LICENSE:      This file is distributed under the BSD license.
+//               License text is included with the source distribution.
+//
+//               This file is distributed in the hope that it will be useful,
+//               but WITHOUT ANY WARRANTY; without even the implied warranty
+//               of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//               IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//               CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//               INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+package org.micromanager.internal;
+
+import com.google.common.eventbus.Subscribe;
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.HashMap;
+import java.util.HashSet;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.Set;
+import java.util.concurrent.CopyOnWriteArrayList;
+import java.util.concurrent.Executor;
+import javax.swing.SwingUtilities;
+import mmcorej.CMMCore;
+import mmcorej.Configuration;
+import mmcorej.PropertySetting;
+import org.micromanager.events.PropertyChangedEvent;
+import org.micromanager.internal.utils.ReportingUtils;
+
+/**
+ * Keeps track of the current preset of each config group, reading the
+ * hardware only on a background thread.
+ *
+ * <p>A refresh updates the system state cache of the Core and then reads the
+ * current presets from the cache. When a device reports that a property
+ * changed, the Core updates the cache for that property, so only the groups
+ * that include the property are read again. Listeners are told on the EDT
+ * about groups whose preset changed. Requests that come in while the
+ * background thread is busy are combined.
+ */
+public final class SystemStateService {
+
+   /**
+    * Access to the Core, separated out for testing.
+    */
+   interface StateSource {
+      void updateSystemStateCache() throws Exception;
+
+      List<String> getConfigGroups() throws Exception;
+
+      /**
+       * Returns the properties used by the presets of the group, as keys
+       * made with {@link SystemStateService#key}.
+       */
+      Set<String> getGroupProperties(String group) throws Exception;
+
+      String getCurrentConfigFromCache(String group) throws Exception;
+
+      String getPropertyFromCache(String device, String property) throws Exception;
+   }
+
+   /**
+    * Receives changes, on the EDT.
+    */
+   public interface Listener {
+      /**
+       * @param configs current preset of each group that changed; groups
+       *                made of a single property without a matching preset
+       *                have an empty preset, and their property changed
+       */
+      void configsChanged(Map<String, String> configs);
+   }
+
+   private final StateSource source_;
+   private final Executor executor_;
+   private final List<Listener> listeners_ = new CopyOnWriteArrayList<>();
+
+   // Guarded by this
+   private boolean scheduled_ = false;
+   private boolean refreshPending_ = false;
+   private final Set<String> changedProperties_ = new HashSet<>();
+   private final List<Runnable> onRefreshed_ = new ArrayList<>();
+
+   // Accessed from the executor only
+   private Map<String, Set<String>> groupsByProperty_ = new HashMap<>();
+   private Map<String, String> singleProperties_ = new HashMap<>();
+   private Map<String, String> states_ = new HashMap<>();
+
+   private volatile Map<String, String> configs_ = Collections.emptyMap();
+
+   SystemStateService(final CMMCore core, Executor executor) {
+      this(new StateSource() {
+         @Override
+         public void updateSystemStateCache() {
+            core.updateSystemStateCache();
+         }
+
+         @Override
+         public List<String> getConfigGroups() {
+            List<String> groups = new ArrayList<>();
+            for (String group : core.getAvailableConfigGroups()) {
+               groups.add(group);
+            }
+            return groups;
+         }
+
+         @Override
+         public Set<String> getGroupProperties(String group) throws Exception {
+            Set<String> properties = new HashSet<>();
+            for (String preset : core.getAvailableConfigs(group)) {
+               Configuration config = core.getConfigData(group, preset);
+               for (int i = 0; i < config.size(); i++) {
+                  PropertySetting setting = config.getSetting(i);
+                  properties.add(key(setting.getDeviceLabel(), setting.getPropertyName()));
+               }
+            }
+            return properties;
+         }
+
+         @Override
+         public String getCurrentConfigFromCache(String group) throws Exception {
+            return core.getCurrentConfigFromCache(group);
+         }
+
+         @Override
+         public String getPropertyFromCache(String device, String property) throws Exception {
+            return core.getPropertyFromCache(device, property);
+         }
+      }, executor);
+   }
+
+   SystemStateService(StateSource source, Executor executor) {
+      source_ = source;
+      executor_ = executor;
+   }
+
+   // Device labels may contain dashes, but not tabs
+   static String key(String device, String property) {
+      return device + "\t" + property;
+   }
+
+   public void addListener(Listener listener) {
+      listeners_.add(listener);
+   }
+
+   public void removeListener(Listener listener) {
+      listeners_.remove(listener);
+   }
+
+   /**
+    * Returns the current preset of each group, as of the last refresh.
+    */
+   public Map<String, String> getConfigs() {
+      return configs_;
+   }
+
+   /**
+    * Updates the system state cache from the hardware, in the background.
+    *
+    * @param onRefreshed run on the EDT once the cache was updated and
+    *                    listeners were told about changes; may be null
+    */
+   public synchronized void refresh(Runnable onRefreshed) {
+      refreshPending_ = true;
+      if (onRefreshed != null) {
+         onRefreshed_.add(onRefreshed);
+      }
+      schedule();
+   }
+
+   /**
+    * Reads the groups that include the property again, from the cache.
+    */
+   public synchronized void propertyChanged(String device, String property) {
+      changedProperties_.add(key(device, property));
+      schedule();
+   }
+
+   @Subscribe
+   public void onPropertyChanged(PropertyChangedEvent event) {
+      propertyChanged(event.getDevice(), event.getProperty());
+   }
+
+   private void schedule() {
+      if (!scheduled_) {
+         scheduled_ = true;
+         executor_.execute(this::update);
+      }
+   }
+
+   private void update() {
+      while (true) {
+         boolean refresh;
+         Set<String> properties;
+         List<Runnable> onRefreshed;
+         synchronized (this) {
+            if (!refreshPending_ && changedProperties_.isEmpty()) {
+               scheduled_ = false;
+               return;
+            }
+            refresh = refreshPending_;
+            refreshPending_ = false;
+            properties = new HashSet<>(changedProperties_);
+            changedProperties_.clear();
+            onRefreshed = new ArrayList<>(onRefreshed_);
+            onRefreshed_.clear();
+         }
+         Map<String, String> changes = Collections.emptyMap();
+         try {
+            changes = refresh ? refreshAll() : refreshGroupsOf(properties);
+         } catch (Exception e) {
+            ReportingUtils.logError(e, "Failed to update system state");
+         }
+         if (!changes.isEmpty() || !onRefreshed.isEmpty()) {
+            final Map<String, String> changed = changes;
+            SwingUtilities.invokeLater(() -> {
+               if (!changed.isEmpty()) {
+                  for (Listener listener : listeners_) {
+                     listener.configsChanged(changed);
+                  }
+               }
+               for (Runnable runnable : onRefreshed) {
+                  runnable.run();
+               }
+            });
+         }
+      }
+   }
+
+   private Map<String, String> refreshAll() throws Exception {
+      source_.updateSystemStateCache();
+      Map<String, Set<String>> groupsByProperty = new HashMap<>();
+      Map<String, String> singleProperties = new HashMap<>();
+      List<String> groups = source_.getConfigGroups();
+      for (String group : groups) {
+         Set<String> properties = source_.getGroupProperties(group);
+         for (String property : properties) {
+            groupsByProperty.computeIfAbsent(property, k -> new HashSet<>()).add(group);
+         }
+         if (properties.size() == 1) {
+            singleProperties.put(group, properties.iterator().next());
+         }
+      }
+      groupsByProperty_ = groupsByProperty;
+      singleProperties_ = singleProperties;
+      states_.keySet().retainAll(groups);
+      return read(groups);
+   }
+
+   private Map<String, String> refreshGroupsOf(Set<String> properties) throws Exception {
+      Set<String> groups = new HashSet<>();
+      for (String property : properties) {
+         groups.addAll(groupsByProperty_.getOrDefault(property, Collections.emptySet()));
+      }
+      return read(groups);
+   }
+
+   // Reads the groups from the cache, and returns those that changed
+   private Map<String, String> read(Iterable<String> groups) throws Exception {
+      Map<String, String> changes = new LinkedHashMap<>();
+      for (String group : groups) {
+         String config = source_.getCurrentConfigFromCache(group);
+         String state = config;
+         String property = singleProperties_.get(group);
+         if (property != null) {
+            // Presets of single property groups can be any value
+            int split = property.indexOf('\t');
+            state += "\n" + source_.getPropertyFromCache(property.substring(0, split),
+                  property.substring(split + 1));
+         }
+         if (!state.equals(states_.put(group, state))) {
+            changes.put(group, config);
+         }
+      }
+      if (!changes.isEmpty() || configs_.size() != states_.size()) {
+         Map<String, String> configs = new HashMap<>(configs_);
+         configs.keySet().retainAll(states_.keySet());
+         configs.putAll(changes);
+         configs_ = Collections.unmodifiableMap(configs);
+      }
+      return changes;
+   }
+}
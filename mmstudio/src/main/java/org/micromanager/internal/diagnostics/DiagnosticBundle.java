@@ -0,0 +1,366 @@
+// COPYRIGHT:    University of California, San Francisco, 2024
+// LICENSE:      This file is distributed under the BSD license.
+//               License text is included with the source distribution.
+//               This file is distributed in the hope that it will be useful,
+//               but WITHOUT ANY WARRANTY; without even the implied warranty
+//               of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//               IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//               CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//               INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+package org.micromanager.internal.diagnostics;
+
+import java.io.BufferedOutputStream;
+import java.io.BufferedReader;
+import java.io.File;
+import java.io.FileOutputStream;
+import java.io.FilterOutputStream;
+import java.io.IOException;
+import java.io.InputStreamReader;
+import java.io.OutputStream;
+import java.io.RandomAccessFile;
+import java.io.Writer;
+import java.lang.management.LockInfo;
+import java.lang.management.ManagementFactory;
+import java.lang.management.MonitorInfo;
+import java.lang.management.ThreadInfo;
+import java.nio.channels.Channels;
+import java.nio.charset.StandardCharsets;
+import java.text.SimpleDateFormat;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.Comparator;
+import java.util.Date;
+import java.util.List;
+import java.util.function.Supplier;
+import java.util.zip.ZipEntry;
+import java.util.zip.ZipOutputStream;
+import org.micromanager.acquisition.SequenceSettings;
+import org.micromanager.data.ProcessorConfigurator;
+import org.micromanager.internal.MMStudio;
+import org.micromanager.internal.logging.LogFileManager;
+import org.micromanager.profile.internal.DefaultUserProfile;
+
+/**
+ * A zip archive of everything needed to diagnose a misbehaving system: the
+ * system information of the Problem Report, a full thread dump, the EDT stall
+ * profile, the hardware configuration, user profile, recent CoreLogs, the
+ * image processing pipeline and the acquisition settings.
+ *
+ * <p>Entries are compressed as they are written, so that the archive is
+ * never held in memory. Each entry is truncated to a maximum size (logs keep
+ * their end), and entries are truncated or left out so that the archive does
+ * not exceed its maximum size. All text goes through a {@link Redactor}.
+ * The archive ends with a manifest listing what was included.
+ */
+public final class DiagnosticBundle {
+   /**
+    * The content of an entry; separated out for testing.
+    */
+   interface Source {
+      /**
+       * @param out where to write; text beyond maxBytes is dropped
+       * @param maxBytes size the entry is truncated to, in bytes of UTF-8
+       */
+      void write(Writer out, long maxBytes) throws IOException;
+   }
+
+   static final String MANIFEST_NAME = "MANIFEST.txt";
+   // Room kept for the manifest and the zip directory
+   static final int MANIFEST_RESERVE = 16 * 1024;
+   // Zip headers of an entry, besides twice its name
+   private static final int ENTRY_OVERHEAD = 256;
+   private static final int MAX_LOG_FILES = 3;
+   // Longer lines are redacted in pieces
+   private static final int MAX_LINE_CHARS = 64 * 1024;
+
+   private final long maxEntryBytes_;
+   private final long maxArchiveBytes_;
+   private final Redactor redactor_;
+   private final List<String> names_ = new ArrayList<>();
+   private final List<Source> sources_ = new ArrayList<>();
+
+   /**
+    * @param maxEntryBytes maximum uncompressed size of each entry
+    * @param maxArchiveBytes maximum size of the archive, at least
+    *                        MANIFEST_RESERVE
+    * @param redactor applied to all text
+    */
+   public DiagnosticBundle(long maxEntryBytes, long maxArchiveBytes, Redactor redactor) {
+      if (maxArchiveBytes < MANIFEST_RESERVE) {
+         throw new IllegalArgumentException("Maximum archive size is too small");
+      }
+      maxEntryBytes_ = maxEntryBytes;
+      maxArchiveBytes_ = maxArchiveBytes;
+      redactor_ = redactor;
+   }
+
+   /**
+    * Creates a bundle of the running application.
+    *
+    * @param studio the application
+    * @param maxEntryBytes maximum uncompressed size of each entry
+    * @param maxArchiveBytes maximum size of the archive
+    */
+   public static DiagnosticBundle create(final MMStudio studio, long maxEntryBytes,
+                                         long maxArchiveBytes) {
+      DiagnosticBundle bundle = new DiagnosticBundle(maxEntryBytes, maxArchiveBytes,
+            Redactor.createDefault());
+      bundle.addText("SystemInfo.txt", () -> SystemInfo.getAllAsText(true));
+      bundle.add("Threads.txt", (out, max) -> writeThreadDump(out));
+      bundle.addText("EDTStallProfile.txt", EDTStallProfiler::getDefaultReport);
+      String config = studio.getSysConfigFile();
+      if (config != null && !config.isEmpty()) {
+         bundle.addFile("Config.cfg", new File(config), false);
+      }
+      if (studio.profile() instanceof DefaultUserProfile) {
+         bundle.addText("Profile.json",
+               () -> ((DefaultUserProfile) studio.profile()).toPropertyMap().toJSON());
+      }
+      bundle.add("Pipeline.txt", (out, max) -> {
+         for (ProcessorConfigurator configurator
+               : studio.data().getApplicationPipelineConfigurators(true)) {
+            out.write(configurator.getClass().getName() + "\n");
+            out.write(configurator.getSettings().toJSON() + "\n");
+         }
+      });
+      bundle.addText("AcquisitionSettings.json", () -> {
+         SequenceSettings settings = studio.acquisitions().getAcquisitionSettings();
+         return SequenceSettings.toJSONStream(settings);
+      });
+      File[] logs = LogFileManager.getLogFileDirectory().listFiles(
+            (dir, name) -> name.endsWith(".txt"));
+      if (logs != null) {
+         Arrays.sort(logs, Comparator.comparingLong(File::lastModified).reversed());
+         for (int i = 0; i < Math.min(MAX_LOG_FILES, logs.length); i++) {
+            bundle.addFile("logs/" + logs[i].getName(), logs[i], true);
+         }
+      }
+      return bundle;
+   }
+
+   void add(String name, Source source) {
+      names_.add(name);
+      sources_.add(source);
+   }
+
+   /**
+    * Adds text that is produced when the bundle is written.
+    */
+   public void addText(String name, Supplier<String> text) {
+      add(name, (out, max) -> out.write(String.valueOf(text.get())));
+   }
+
+   /**
+    * Adds a text file.
+    *
+    * @param tail when the file is too large, keep its end rather than its
+    *             beginning
+    */
+   public void addFile(String name, final File file, final boolean tail) {
+      add(name, (out, max) -> {
+         try (RandomAccessFile raf = new RandomAccessFile(file, "r")) {
+            boolean skipLine = false;
+            if (tail && raf.length() > max) {
+               // Leaves room for the note that the beginning is missing
+               raf.seek(raf.length() - Math.max(0, max - 64));
+               // Start at a whole line
+               skipLine = true;
+            }
+            BufferedReader reader = new BufferedReader(new InputStreamReader(
+                  Channels.newInputStream(raf.getChannel()), StandardCharsets.UTF_8));
+            if (skipLine) {
+               reader.readLine();
+               out.write("[Beginning of file left out]\n");
+            }
+            char[] buffer = new char[8192];
+            int n;
+            while ((n = reader.read(buffer)) > 0) {
+               out.write(buffer, 0, n);
+            }
+         }
+      });
+   }
+
+   /**
+    * Writes the bundle to a file.
+    *
+    * @param reason why the bundle was made, for the manifest
+    */
+   public void write(File file, String reason) throws IOException {
+      try (OutputStream out = new BufferedOutputStream(new FileOutputStream(file))) {
+         write(out, reason);
+      }
+   }
+
+   /**
+    * Writes the bundle as a zip archive; the stream is not closed.
+    *
+    * @param reason why the bundle was made, for the manifest
+    */
+   public void write(OutputStream out, String reason) throws IOException {
+      CountingStream counter = new CountingStream(out);
+      ZipOutputStream zip = new ZipOutputStream(counter, StandardCharsets.UTF_8);
+      StringBuilder manifest = new StringBuilder();
+      manifest.append("Diagnostic bundle\n")
+            .append("Date: ").append(new SimpleDateFormat("yyyy-MM-dd'T'HH:mm:ss.SSSZ")
+                  .format(new Date())).append('\n')
+            .append("Reason: ").append(reason).append("\n\n");
+      for (int i = 0; i < names_.size(); i++) {
+         String name = names_.get(i);
+         long room = maxArchiveBytes_ - MANIFEST_RESERVE - counter.count_
+               - ENTRY_OVERHEAD - 2L * name.getBytes(StandardCharsets.UTF_8).length;
+         // Deflate may grow incompressible data slightly
+         long budget = Math.min(maxEntryBytes_, room - room / 100);
+         if (budget <= 0) {
+            manifest.append(name).append(": left out, archive full\n");
+            continue;
+         }
+         zip.putNextEntry(new ZipEntry(name));
+         EntryWriter writer = new EntryWriter(zip, budget, redactor_);
+         String error = null;
+         try {
+            sources_.get(i).write(writer, budget);
+         } catch (IOException | RuntimeException e) {
+            if (writer.streamError_ != null) {
+               throw writer.streamError_;
+            }
+            error = e.toString();
+            writer.write("\n[Failed: " + e + "]\n");
+         }
+         writer.finish();
+         zip.closeEntry();
+         manifest.append(name).append(": ").append(writer.written_).append(" bytes");
+         if (writer.truncated_) {
+            manifest.append(", truncated");
+         }
+         if (error != null) {
+            manifest.append(", failed: ").append(error);
+         }
+         manifest.append('\n');
+      }
+      zip.putNextEntry(new ZipEntry(MANIFEST_NAME));
+      EntryWriter writer = new EntryWriter(zip, MANIFEST_RESERVE / 2, redactor_);
+      writer.write(manifest.toString());
+      writer.finish();
+      zip.closeEntry();
+      zip.finish();
+      zip.flush();
+   }
+
+   private static void writeThreadDump(Writer out) throws IOException {
+      ThreadInfo[] infos = ManagementFactory.getThreadMXBean().dumpAllThreads(true, true);
+      for (ThreadInfo info : infos) {
+         out.write("\"" + info.getThreadName() + "\" id " + info.getThreadId()
+               + " " + info.getThreadState());
+         if (info.getLockName() != null) {
+            out.write(" on " + info.getLockName());
+         }
+         if (info.getLockOwnerName() != null) {
+            out.write(" owned by \"" + info.getLockOwnerName() + "\" id "
+                  + info.getLockOwnerId());
+         }
+         out.write("\n");
+         StackTraceElement[] trace = info.getStackTrace();
+         MonitorInfo[] monitors = info.getLockedMonitors();
+         for (int i = 0; i < trace.length; i++) {
+            out.write("   at " + trace[i] + "\n");
+            for (MonitorInfo monitor : monitors) {
+               if (monitor.getLockedStackDepth() == i) {
+                  out.write("      locked " + monitor + "\n");
+               }
+            }
+         }
+         for (LockInfo lock : info.getLockedSynchronizers()) {
+            out.write("   holds " + lock + "\n");
+         }
+         out.write("\n");
+      }
+   }
+
+   // Counts the bytes written to the archive
+   private static final class CountingStream extends FilterOutputStream {
+      private long count_ = 0;
+
+      CountingStream(OutputStream out) {
+         super(out);
+      }
+
+      @Override
+      public void write(int b) throws IOException {
+         out.write(b);
+         count_++;
+      }
+
+      @Override
+      public void write(byte[] b, int off, int len) throws IOException {
+         out.write(b, off, len);
+         count_ += len;
+      }
+   }
+
+   // Redacts whole lines and truncates to a size in bytes; leaves the zip
+   // stream open
+   private static final class EntryWriter extends Writer {
+      private final OutputStream out_;
+      private final long maxBytes_;
+      private final Redactor redactor_;
+      private final StringBuilder line_ = new StringBuilder();
+      private long written_ = 0;
+      private boolean truncated_ = false;
+      private IOException streamError_;
+
+      EntryWriter(OutputStream out, long maxBytes, Redactor redactor) {
+         out_ = out;
+         maxBytes_ = maxBytes;
+         redactor_ = redactor;
+      }
+
+      @Override
+      public void write(char[] buffer, int offset, int length) throws IOException {
+         for (int i = offset; i < offset + length && !truncated_; i++) {
+            line_.append(buffer[i]);
+            if (buffer[i] == '\n' || line_.length() >= MAX_LINE_CHARS) {
+               writeLine();
+            }
+         }
+      }
+
+      private void writeLine() throws IOException {
+         byte[] bytes = redactor_.redact(line_.toString()).getBytes(StandardCharsets.UTF_8);
+         line_.setLength(0);
+         int length = bytes.length;
+         if (written_ + length > maxBytes_) {
+            // Cut the redacted line, at a character boundary
+            length = (int) (maxBytes_ - written_);
+            while (length > 0 && (bytes[length] & 0xC0) == 0x80) {
+               length--;
+            }
+            truncated_ = true;
+         }
+         try {
+            out_.write(bytes, 0, length);
+         } catch (IOException e) {
+            streamError_ = e;
+            throw e;
+         }
+         written_ += length;
+      }
+
+      void finish() throws IOException {
+         if (line_.length() > 0 && !truncated_) {
+            writeLine();
+         }
+      }
+
+      @Override
+      public void flush() {
+         // Lines are written as they end
+      }
+
+      @Override
+      public void close() {
+         // The zip stream stays open for the next entry
+      }
+   }
+}
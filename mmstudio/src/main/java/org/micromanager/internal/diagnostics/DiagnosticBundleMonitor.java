@@ -0,0 +1,294 @@
+// COPYRIGHT:    University of California, San Francisco, 2024
+// LICENSE:      This file is distributed under the BSD license.
+//               License text is included with the source distribution.
+//               This file is distributed in the hope that it will be useful,
+//               but WITHOUT ANY WARRANTY; without even the implied warranty
+//               of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//               IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//               CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//               INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+package org.micromanager.internal.diagnostics;
+
+import java.awt.EventQueue;
+import java.io.File;
+import java.io.IOException;
+import java.text.SimpleDateFormat;
+import java.util.ArrayDeque;
+import java.util.Arrays;
+import java.util.Comparator;
+import java.util.Date;
+import java.util.Deque;
+import java.util.Timer;
+import java.util.TimerTask;
+import java.util.function.LongSupplier;
+import java.util.function.Supplier;
+import mmcorej.CMMCore;
+import org.micromanager.PropertyMap;
+import org.micromanager.internal.MMStudio;
+import org.micromanager.internal.utils.JavaUtils;
+import org.micromanager.internal.utils.ReportingUtils;
+
+/**
+ * Writes diagnostic bundles periodically, and when something goes wrong: the
+ * EDT hangs, the circular buffer overflows, or a burst of uncaught exceptions
+ * occurs. Each condition produces one bundle when it starts; bundles made for
+ * any reason are at least a minimum interval apart. Only the most recent
+ * bundles are kept.
+ */
+public final class DiagnosticBundleMonitor {
+   /**
+    * What the monitor watches; separated out for testing.
+    */
+   interface Probes {
+      /**
+       * Returns how long the EDT has not responded, in milliseconds.
+       */
+      long getEDTLagMs();
+
+      boolean isBufferOverflowed();
+
+      /**
+       * Returns the number of uncaught exceptions so far.
+       */
+      long getExceptionCount();
+   }
+
+   /**
+    * Settings of the monitor, read from the user profile.
+    */
+   static final class Settings {
+      long periodMs = 0; // No periodic bundles
+      long hangMs = 5000;
+      int burstExceptions = 10;
+      long burstWindowMs = 60000;
+      long minIntervalMs = 10 * 60000;
+      int maxBundles = 10;
+      long maxEntryBytes = 8L * 1024 * 1024;
+      long maxArchiveBytes = 20L * 1024 * 1024;
+
+      static Settings fromPropertyMap(PropertyMap map) {
+         Settings settings = new Settings();
+         settings.periodMs = map.getLong("periodMinutes", 0) * 60000;
+         settings.hangMs = map.getLong("hangMs", settings.hangMs);
+         settings.burstExceptions = map.getInteger("burstExceptions",
+               settings.burstExceptions);
+         settings.minIntervalMs = map.getLong("minIntervalMinutes", 10) * 60000;
+         settings.maxBundles = map.getInteger("maxBundles", settings.maxBundles);
+         settings.maxArchiveBytes = map.getLong("maxArchiveMB", 20) * 1024 * 1024;
+         return settings;
+      }
+   }
+
+   static final String FILE_PREFIX = "DiagnosticBundle_";
+   private static final long CHECK_INTERVAL_MS = 1000;
+
+   private final Probes probes_;
+   private final Supplier<DiagnosticBundle> factory_;
+   private final File directory_;
+   private final Settings settings_;
+   private final LongSupplier clockMs_;
+   private Timer timer_;
+
+   // Accessed from check() only
+   private long lastBundleMs_ = Long.MIN_VALUE / 2;
+   private long lastPeriodicMs_;
+   private boolean hung_ = false;
+   private boolean overflowed_ = false;
+   private final Deque<long[]> exceptionCounts_ = new ArrayDeque<>();
+   private int bundleCount_ = 0;
+
+   private static DiagnosticBundleMonitor instance_;
+
+   /**
+    * Starts monitoring the application, with settings from the user profile.
+    */
+   public static synchronized void startDefault(final MMStudio studio) {
+      stopDefault();
+      final Settings settings = Settings.fromPropertyMap(
+            studio.profile().getSettings(DiagnosticBundleMonitor.class).toPropertyMap());
+      File directory = new File(JavaUtils.getApplicationDataPath(), "DiagnosticBundles");
+      instance_ = new DiagnosticBundleMonitor(new DefaultProbes(studio.core()),
+            () -> DiagnosticBundle.create(studio, settings.maxEntryBytes,
+                  settings.maxArchiveBytes),
+            directory, settings, System::currentTimeMillis);
+      instance_.start();
+   }
+
+   public static synchronized void stopDefault() {
+      if (instance_ != null) {
+         instance_.stop();
+         instance_ = null;
+      }
+   }
+
+   /**
+    * Writes a bundle now with the default monitor, regardless of the minimum
+    * interval.
+    *
+    * @return the bundle, or null if it could not be written
+    */
+   public static File writeDefault(String reason) {
+      DiagnosticBundleMonitor monitor;
+      synchronized (DiagnosticBundleMonitor.class) {
+         monitor = instance_;
+      }
+      return monitor == null ? null : monitor.write(reason);
+   }
+
+   DiagnosticBundleMonitor(Probes probes, Supplier<DiagnosticBundle> factory,
+                           File directory, Settings settings, LongSupplier clockMs) {
+      probes_ = probes;
+      factory_ = factory;
+      directory_ = directory;
+      settings_ = settings;
+      clockMs_ = clockMs;
+      lastPeriodicMs_ = clockMs.getAsLong();
+   }
+
+   private synchronized void start() {
+      timer_ = new Timer("Diagnostic bundle monitor", true);
+      timer_.schedule(new TimerTask() {
+         @Override
+         public void run() {
+            check();
+         }
+      }, CHECK_INTERVAL_MS, CHECK_INTERVAL_MS);
+   }
+
+   synchronized void stop() {
+      if (timer_ != null) {
+         timer_.cancel();
+         timer_ = null;
+      }
+   }
+
+   /**
+    * Checks the probes, and writes a bundle if a trigger fired.
+    */
+   synchronized void check() {
+      long now = clockMs_.getAsLong();
+      String reason = null;
+
+      boolean hung = probes_.getEDTLagMs() >= settings_.hangMs;
+      if (hung && !hung_) {
+         reason = "EDT hang";
+      }
+      hung_ = hung;
+
+      boolean overflowed = probes_.isBufferOverflowed();
+      if (overflowed && !overflowed_) {
+         reason = "buffer overflow";
+      }
+      overflowed_ = overflowed;
+
+      long exceptions = probes_.getExceptionCount();
+      while (!exceptionCounts_.isEmpty()
+            && exceptionCounts_.peekFirst()[0] < now - settings_.burstWindowMs) {
+         exceptionCounts_.removeFirst();
+      }
+      exceptionCounts_.addLast(new long[] {now, exceptions});
+      if (exceptions - exceptionCounts_.peekFirst()[1] >= settings_.burstExceptions) {
+         reason = "exception burst";
+         // Count the next burst from here
+         exceptionCounts_.clear();
+         exceptionCounts_.addLast(new long[] {now, exceptions});
+      }
+
+      if (reason == null && settings_.periodMs > 0
+            && now - lastPeriodicMs_ >= settings_.periodMs) {
+         reason = "periodic";
+         lastPeriodicMs_ = now;
+      }
+
+      if (reason != null) {
+         if (now - lastBundleMs_ < settings_.minIntervalMs) {
+            ReportingUtils.logMessage("Diagnostic bundle (" + reason
+                  + ") skipped: too soon after the last one");
+         } else {
+            lastBundleMs_ = now;
+            write(reason);
+         }
+      }
+   }
+
+   /**
+    * Writes a bundle, and deletes the oldest bundles beyond the maximum.
+    *
+    * @return the bundle, or null if it could not be written
+    */
+   synchronized File write(String reason) {
+      if (!directory_.isDirectory() && !directory_.mkdirs()) {
+         ReportingUtils.logError("Cannot create " + directory_);
+         return null;
+      }
+      // Bundles made within the same second get a sequence number
+      String name = FILE_PREFIX + new SimpleDateFormat("yyyyMMdd_HHmmss").format(
+            new Date(clockMs_.getAsLong())) + "_" + (bundleCount_++) + "_"
+            + reason.replaceAll("[^A-Za-z0-9]+", "-") + ".zip";
+      File file = new File(directory_, name);
+      try {
+         factory_.get().write(file, reason);
+         ReportingUtils.logMessage("Wrote diagnostic bundle " + file
+               + " (" + reason + ", " + file.length() + " bytes)");
+      } catch (IOException | RuntimeException e) {
+         ReportingUtils.logError(e, "Failed to write diagnostic bundle");
+         if (!file.delete()) {
+            file.deleteOnExit();
+         }
+         return null;
+      }
+      prune();
+      return file;
+   }
+
+   private void prune() {
+      File[] bundles = directory_.listFiles(
+            (dir, name) -> name.startsWith(FILE_PREFIX) && name.endsWith(".zip"));
+      if (bundles == null || bundles.length <= settings_.maxBundles) {
+         return;
+      }
+      Arrays.sort(bundles, Comparator.comparingLong(File::lastModified)
+            .thenComparing(File::getName));
+      for (int i = 0; i < bundles.length - settings_.maxBundles; i++) {
+         if (!bundles[i].delete()) {
+            ReportingUtils.logError("Cannot delete " + bundles[i]);
+         }
+      }
+   }
+
+   /**
+    * Watches the running application. The EDT is probed with a heartbeat
+    * event; it lags while a heartbeat is pending.
+    */
+   private static final class DefaultProbes implements Probes {
+      private final CMMCore core_;
+      private volatile long heartbeatPostedMs_ = -1;
+
+      DefaultProbes(CMMCore core) {
+         core_ = core;
+      }
+
+      @Override
+      public long getEDTLagMs() {
+         long now = System.currentTimeMillis();
+         long posted = heartbeatPostedMs_;
+         if (posted >= 0) {
+            return now - posted;
+         }
+         heartbeatPostedMs_ = now;
+         EventQueue.invokeLater(() -> heartbeatPostedMs_ = -1);
+         return 0;
+      }
+
+      @Override
+      public boolean isBufferOverflowed() {
+         return core_.isBufferOverflowed();
+      }
+
+      @Override
+      public long getExceptionCount() {
+         return ThreadExceptionLogger.getExceptionCount();
+      }
+   }
+}
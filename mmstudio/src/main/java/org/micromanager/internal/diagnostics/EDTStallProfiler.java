@@ -0,0 +1,416 @@
+package org.micromanager.internal.diagnostics;
+
+import java.awt.EventQueue;
+import java.io.IOException;
+import java.io.StringWriter;
+import java.io.Writer;
+import java.text.SimpleDateFormat;
+import java.util.ArrayDeque;
+import java.util.ArrayList;
+import java.util.Date;
+import java.util.Deque;
+import java.util.HashMap;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.concurrent.TimeUnit;
+import org.micromanager.internal.utils.ReportingUtils;
+
+/**
+ * Samples the stack of the event dispatch thread while it is stalled, to
+ * find out what the user interface spends its pauses on.
+ *
+ * <p>Like {@link EDTHangLogger}, this uses a heartbeat posted to the event
+ * queue: the EDT is stalled while a heartbeat waits longer than the
+ * threshold. Only then is the stack of the EDT sampled, at the sampling
+ * rate, so that the profiler costs almost nothing while the EDT is
+ * responsive. Samples are aggregated into collapsed stacks (the input
+ * format of flame graph tools), and each stall is attributed to the event
+ * or Runnable being dispatched.
+ *
+ * <p>The time spent on sampling, including the pause of the EDT while its
+ * stack is taken, is measured. When it exceeds the overhead budget, the
+ * sampling rate is lowered.
+ */
+public final class EDTStallProfiler {
+   private static final long NS_PER_MS = 1000 * 1000;
+   // Period over which the overhead is checked against the budget
+   private static final long OVERHEAD_WINDOW_NS = 1000 * NS_PER_MS;
+   // Distinct stacks kept; further stacks are counted as OTHER_STACK
+   static final int MAX_STACKS = 2000;
+   static final String OTHER_STACK = "[other]";
+   static final int MAX_RECENT_STALLS = 50;
+   static final String OUTSIDE_DISPATCH = "[outside event dispatch]";
+
+   private static final class Stall {
+      private final long startMs_;
+      private long durationNs_ = 0;
+      private int samples_ = 0;
+      private final Map<String, Integer> causes_ = new HashMap<>();
+      private String cause_;
+
+      private Stall(long startMs) {
+         startMs_ = startMs;
+      }
+   }
+
+   private static final class CauseStats {
+      private int stalls_ = 0;
+      private long totalNs_ = 0;
+      private long maxNs_ = 0;
+   }
+
+   private final long thresholdNs_;
+   private final long samplePeriodNs_;
+   private final double maxOverhead_;
+   private final Thread sampler_;
+   private volatile boolean running_ = true;
+
+   // Set on the EDT by the heartbeat
+   private volatile Thread edt_;
+
+   // Guarded by this
+   private boolean heartbeatPending_ = false;
+   private long heartbeatPostedNs_;
+   private Stall stall_;
+   private final Map<String, Integer> stacks_ = new HashMap<>();
+   private final Map<String, CauseStats> causes_ = new HashMap<>();
+   private final Deque<Stall> recent_ = new ArrayDeque<>();
+   private int totalSamples_ = 0;
+   private int totalStalls_ = 0;
+   private long stalledNs_ = 0;
+   private long currentPeriodNs_;
+   private final long startNs_;
+   private long overheadNs_ = 0;
+   private long windowStartNs_;
+   private long windowOverheadNs_ = 0;
+
+   private static EDTStallProfiler instance_;
+
+   public static synchronized void startDefault(long thresholdMs, int samplesPerSecond,
+                                                double maxOverhead) {
+      if (instance_ != null) {
+         stopDefault();
+      }
+      instance_ = new EDTStallProfiler(thresholdMs, samplesPerSecond, maxOverhead);
+   }
+
+   public static synchronized void stopDefault() {
+      if (instance_ != null) {
+         instance_.stop();
+         instance_ = null;
+      }
+   }
+
+   /**
+    * Returns the report of the default profiler, or null if it is not
+    * running.
+    */
+   public static synchronized String getDefaultReport() {
+      return instance_ == null ? null : instance_.getReport();
+   }
+
+   /**
+    * Starts profiling.
+    *
+    * @param thresholdMs time an event must take before it is sampled
+    * @param samplesPerSecond sampling rate during stalls
+    * @param maxOverhead fraction of time the profiler may spend sampling
+    */
+   public EDTStallProfiler(long thresholdMs, int samplesPerSecond, double maxOverhead) {
+      thresholdNs_ = Math.max(1, thresholdMs) * NS_PER_MS;
+      samplePeriodNs_ = TimeUnit.SECONDS.toNanos(1) / Math.max(1, samplesPerSecond);
+      maxOverhead_ = maxOverhead;
+      currentPeriodNs_ = samplePeriodNs_;
+      startNs_ = System.nanoTime();
+      windowStartNs_ = startNs_;
+      sampler_ = new Thread(this::run, "EDT stall profiler");
+      sampler_.setDaemon(true);
+      sampler_.start();
+   }
+
+   public void stop() {
+      running_ = false;
+      sampler_.interrupt();
+      try {
+         sampler_.join(1000);
+      } catch (InterruptedException e) {
+         Thread.currentThread().interrupt();
+      }
+   }
+
+   private void run() {
+      while (running_) {
+         long sleepNs = tick();
+         try {
+            TimeUnit.NANOSECONDS.sleep(sleepNs);
+         } catch (InterruptedException e) {
+            return;
+         }
+      }
+   }
+
+   /**
+    * Posts a heartbeat or samples the EDT.
+    *
+    * @return time until the next tick
+    */
+   private long tick() {
+      long start = System.nanoTime();
+      boolean sample;
+      synchronized (this) {
+         if (!heartbeatPending_) {
+            heartbeatPending_ = true;
+            heartbeatPostedNs_ = start;
+            EventQueue.invokeLater(this::heartbeat);
+         }
+         sample = start - heartbeatPostedNs_ >= thresholdNs_;
+      }
+      Thread edt = edt_;
+      if (sample && edt != null) {
+         // Taken outside the lock, so that the heartbeat is not held up
+         StackTraceElement[] trace = edt.getStackTrace();
+         synchronized (this) {
+            // Drop the sample if the EDT moved on while it was taken
+            if (heartbeatPending_ && heartbeatPostedNs_ <= start) {
+               addSample(trace);
+            }
+         }
+      }
+      long end = System.nanoTime();
+      synchronized (this) {
+         accountOverhead(end, end - start);
+         if (stall_ != null) {
+            return currentPeriodNs_;
+         }
+      }
+      // While the EDT is responsive, a coarser heartbeat suffices
+      return Math.max(currentPeriodNs_, thresholdNs_ / 4);
+   }
+
+   private void heartbeat() {
+      edt_ = Thread.currentThread();
+      long now = System.nanoTime();
+      synchronized (this) {
+         heartbeatPending_ = false;
+         if (stall_ != null) {
+            endStall(now - heartbeatPostedNs_);
+         }
+      }
+   }
+
+   // Guarded by this
+   private void addSample(StackTraceElement[] trace) {
+      if (stall_ == null) {
+         stall_ = new Stall(System.currentTimeMillis()
+               - TimeUnit.NANOSECONDS.toMillis(System.nanoTime() - heartbeatPostedNs_));
+      }
+      String cause = attribute(trace);
+      stall_.samples_++;
+      stall_.causes_.merge(cause, 1, Integer::sum);
+      totalSamples_++;
+      String stack = collapse(trace);
+      if (stacks_.containsKey(stack) || stacks_.size() < MAX_STACKS) {
+         stacks_.merge(stack, 1, Integer::sum);
+      } else {
+         stacks_.merge(OTHER_STACK, 1, Integer::sum);
+      }
+   }
+
+   // Guarded by this
+   private void endStall(long durationNs) {
+      Stall stall = stall_;
+      stall_ = null;
+      stall.durationNs_ = durationNs;
+      int most = 0;
+      for (Map.Entry<String, Integer> cause : stall.causes_.entrySet()) {
+         if (cause.getValue() > most) {
+            most = cause.getValue();
+            stall.cause_ = cause.getKey();
+         }
+      }
+      CauseStats stats = causes_.computeIfAbsent(stall.cause_, k -> new CauseStats());
+      stats.stalls_++;
+      stats.totalNs_ += durationNs;
+      stats.maxNs_ = Math.max(stats.maxNs_, durationNs);
+      totalStalls_++;
+      stalledNs_ += durationNs;
+      recent_.addLast(stall);
+      if (recent_.size() > MAX_RECENT_STALLS) {
+         recent_.removeFirst();
+      }
+   }
+
+   // Guarded by this
+   private void accountOverhead(long now, long spentNs) {
+      overheadNs_ += spentNs;
+      windowOverheadNs_ += spentNs;
+      long windowNs = now - windowStartNs_;
+      if (windowNs < OVERHEAD_WINDOW_NS) {
+         return;
+      }
+      double overhead = (double) windowOverheadNs_ / windowNs;
+      if (overhead > maxOverhead_ && currentPeriodNs_ < thresholdNs_) {
+         currentPeriodNs_ = Math.min(thresholdNs_, currentPeriodNs_ * 2);
+         ReportingUtils.logMessage("EDTStallProfiler: overhead "
+               + formatPercent(overhead) + "; sampling period raised to "
+               + TimeUnit.NANOSECONDS.toMicros(currentPeriodNs_) + " us");
+      } else if (overhead < maxOverhead_ / 4 && currentPeriodNs_ > samplePeriodNs_) {
+         currentPeriodNs_ = Math.max(samplePeriodNs_, currentPeriodNs_ / 2);
+      }
+      windowStartNs_ = now;
+      windowOverheadNs_ = 0;
+   }
+
+   private static boolean isPlatformClass(String className) {
+      return className.startsWith("java.") || className.startsWith("javax.")
+            || className.startsWith("sun.") || className.startsWith("jdk.")
+            || className.startsWith("com.sun.");
+   }
+
+   private static String frameName(StackTraceElement frame) {
+      return frame.getClassName() + "." + frame.getMethodName();
+   }
+
+   /**
+    * Names the event being dispatched in a stack of the EDT: the kind of
+    * dispatch (InvocationEvent for Runnables, otherwise the receiving AWT
+    * class), and the first application method it called.
+    */
+   static String attribute(StackTraceElement[] trace) {
+      // The innermost dispatch, as modal dialogs dispatch events themselves
+      int dispatch = -1;
+      for (int i = 0; i < trace.length; i++) {
+         if (trace[i].getClassName().equals("java.awt.EventQueue")
+               && trace[i].getMethodName().equals("dispatchEventImpl")) {
+            dispatch = i;
+            break;
+         }
+      }
+      if (dispatch < 1) {
+         return OUTSIDE_DISPATCH;
+      }
+      String kind = trace[dispatch - 1].getClassName();
+      kind = kind.substring(kind.lastIndexOf('.') + 1);
+      for (int i = dispatch - 1; i >= 0; i--) {
+         if (!isPlatformClass(trace[i].getClassName())) {
+            return kind + ": " + frameName(trace[i]);
+         }
+      }
+      return kind + ": " + frameName(trace[dispatch - 1]);
+   }
+
+   /**
+    * Formats a stack as a collapsed stack, outermost frame first.
+    */
+   static String collapse(StackTraceElement[] trace) {
+      StringBuilder sb = new StringBuilder();
+      for (int i = trace.length - 1; i >= 0; i--) {
+         sb.append(frameName(trace[i]).replace(';', ':').replace(' ', '_'));
+         if (i > 0) {
+            sb.append(';');
+         }
+      }
+      return sb.toString();
+   }
+
+   private static String formatPercent(double fraction) {
+      return String.format("%.3f%%", 100 * fraction);
+   }
+
+   private static long toMs(long ns) {
+      return TimeUnit.NANOSECONDS.toMillis(ns);
+   }
+
+   /**
+    * Writes the samples as collapsed stacks, one per line followed by its
+    * sample count, as read by flamegraph.pl and similar tools.
+    */
+   public void writeCollapsedStacks(Writer writer) throws IOException {
+      Map<String, Integer> stacks;
+      synchronized (this) {
+         stacks = new LinkedHashMap<>(stacks_);
+      }
+      List<Map.Entry<String, Integer>> entries = new ArrayList<>(stacks.entrySet());
+      entries.sort((a, b) -> b.getValue().compareTo(a.getValue()));
+      for (Map.Entry<String, Integer> entry : entries) {
+         writer.write(entry.getKey() + " " + entry.getValue() + "\n");
+      }
+   }
+
+   public synchronized int getStallCount() {
+      return totalStalls_;
+   }
+
+   public synchronized int getSampleCount() {
+      return totalSamples_;
+   }
+
+   /**
+    * Returns the fraction of time spent posting heartbeats and sampling.
+    */
+   public synchronized double getOverhead() {
+      long elapsed = System.nanoTime() - startNs_;
+      return elapsed > 0 ? (double) overheadNs_ / elapsed : 0.0;
+   }
+
+   /**
+    * Returns the number of stalls attributed to each cause.
+    */
+   public synchronized Map<String, Integer> getStallsByCause() {
+      Map<String, Integer> result = new HashMap<>();
+      for (Map.Entry<String, CauseStats> entry : causes_.entrySet()) {
+         result.put(entry.getKey(), entry.getValue().stalls_);
+      }
+      return result;
+   }
+
+   /**
+    * Returns a text report of the stalls and their causes, followed by the
+    * collapsed stacks.
+    */
+   public String getReport() {
+      StringBuilder sb = new StringBuilder();
+      synchronized (this) {
+         long elapsed = System.nanoTime() - startNs_;
+         sb.append("EDT stall profile: threshold ").append(toMs(thresholdNs_))
+               .append(" ms, sampling period ")
+               .append(TimeUnit.NANOSECONDS.toMicros(currentPeriodNs_)).append(" us (configured ")
+               .append(TimeUnit.NANOSECONDS.toMicros(samplePeriodNs_)).append(" us)\n");
+         sb.append("Profiled for ").append(TimeUnit.NANOSECONDS.toSeconds(elapsed))
+               .append(" s: ").append(totalStalls_).append(" stalls, ")
+               .append(toMs(stalledNs_)).append(" ms stalled, ")
+               .append(totalSamples_).append(" samples, overhead ")
+               .append(formatPercent(elapsed > 0 ? (double) overheadNs_ / elapsed : 0.0))
+               .append("\n");
+
+         sb.append("Stalls by cause (stalls, total ms, max ms):\n");
+         List<Map.Entry<String, CauseStats>> causes = new ArrayList<>(causes_.entrySet());
+         causes.sort((a, b) -> Long.compare(b.getValue().totalNs_, a.getValue().totalNs_));
+         for (Map.Entry<String, CauseStats> cause : causes) {
+            CauseStats stats = cause.getValue();
+            sb.append("  ").append(cause.getKey()).append(": ").append(stats.stalls_)
+                  .append(", ").append(toMs(stats.totalNs_))
+                  .append(", ").append(toMs(stats.maxNs_)).append("\n");
+         }
+
+         sb.append("Recent stalls:\n");
+         SimpleDateFormat format = new SimpleDateFormat("yyyy-MM-dd HH:mm:ss.SSS");
+         for (Stall stall : recent_) {
+            sb.append("  ").append(format.format(new Date(stall.startMs_))).append(" ")
+                  .append(toMs(stall.durationNs_)).append(" ms, ")
+                  .append(stall.samples_).append(" samples: ").append(stall.cause_)
+                  .append("\n");
+         }
+      }
+      sb.append("Collapsed stacks:\n");
+      StringWriter stacks = new StringWriter();
+      try {
+         writeCollapsedStacks(stacks);
+      } catch (IOException e) {
+         // Not thrown by StringWriter
+      }
+      sb.append(stacks);
+      return sb.toString();
+   }
+}
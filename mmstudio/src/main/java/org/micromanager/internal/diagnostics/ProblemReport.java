@@ -67,6 +67,7 @@ public final class ProblemReport {
    private String capturedLogContent_;
    private NamedTextFile endCfg_;
    private NamedTextFile hotSpotErrorLog_;
+   private String edtStallReport_;
 
    private Timer deferredSyncTimer_ = null;
 
@@ -278,6 +279,7 @@ public final class ProblemReport {
 
       endCfg_ = getCurrentConfigFile();
       syncEndingConfig();
+      edtStallReport_ = EDTStallProfiler.getDefaultReport();
    }
 
    /**
@@ -376,6 +378,14 @@ public final class ProblemReport {
       return hotSpotErrorLog_.getContent();
    }
 
+   boolean hasEDTStallReport() {
+      return edtStallReport_ != null;
+   }
+
+   String getEDTStallReport() {
+      return edtStallReport_;
+   }
+
    int getPid() {
       return metadata_.pid;
    }
@@ -13,12 +13,13 @@ package org.micromanager.internal.diagnostics;
 
 
 public final class ProblemReportFormatter {
-   static final String FORMAT_VERSION = "3";
+   static final String FORMAT_VERSION = "3.1";
    /*
     * Version history:
     * 2    Introduced versioning.
     * 2.1  Added Pid field.
     * 3    Removed personal info fields.
+    * 3.1  Added EDT Stall Profile section.
     */
 
    /**
@@ -49,6 +50,10 @@ public final class ProblemReportFormatter {
                report.getHotSpotErrorLogContent()));
       }
 
+      if (report.hasEDTStallReport()) {
+         sb.append(fileSection("EDT Stall Profile", report.getEDTStallReport()));
+      }
+
       sb.append("***** END OF PROBLEM REPORT *****");
       return sb.toString();
    }
@@ -0,0 +1,73 @@
+// COPYRIGHT:    University of California, San Francisco, 2024
+// LICENSE:      This file is distributed under the BSD license.
+//               License text is included with the source distribution.
+//               This file is distributed in the hope that it will be useful,
+//               but WITHOUT ANY WARRANTY; without even the implied warranty
+//               of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//               IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//               CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//               INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+package org.micromanager.internal.diagnostics;
+
+import java.util.ArrayList;
+import java.util.List;
+import java.util.regex.Matcher;
+import java.util.regex.Pattern;
+
+/**
+ * Removes sensitive text, such as user names in paths, from diagnostic
+ * bundles. Rules are regular expressions with replacements, applied to each
+ * line in order.
+ */
+public final class Redactor {
+   private final List<Pattern> patterns_ = new ArrayList<>();
+   private final List<String> replacements_ = new ArrayList<>();
+
+   /**
+    * Returns a redactor with rules for the home directory and user name, and
+    * for user directories on Windows, macOS and Linux.
+    */
+   public static Redactor createDefault() {
+      Redactor redactor = new Redactor();
+      String home = System.getProperty("user.home");
+      if (home != null && home.length() > 1) {
+         redactor.addLiteralRule(home, "<home>");
+         redactor.addLiteralRule(home.replace('\\', '/'), "<home>");
+      }
+      redactor.addRule("(?i)([A-Z]:[\\\\/](?:Users|Documents and Settings)[\\\\/])[^\\\\/\\s\"]+",
+            "$1<user>");
+      redactor.addRule("(/(?:Users|home)/)[^/\\s\"]+", "$1<user>");
+      String user = System.getProperty("user.name");
+      if (user != null && user.length() > 2) {
+         redactor.addRule("(?i)\\b" + Pattern.quote(user) + "\\b", "<user>");
+      }
+      return redactor;
+   }
+
+   /**
+    * Adds a rule.
+    *
+    * @param regex regular expression to match
+    * @param replacement replacement, which may refer to groups as $1
+    */
+   public void addRule(String regex, String replacement) {
+      patterns_.add(Pattern.compile(regex));
+      replacements_.add(replacement);
+   }
+
+   /**
+    * Adds a rule that replaces text as is.
+    */
+   public void addLiteralRule(String text, String replacement) {
+      patterns_.add(Pattern.compile(Pattern.quote(text)));
+      replacements_.add(Matcher.quoteReplacement(replacement));
+   }
+
+   public String redact(String line) {
+      for (int i = 0; i < patterns_.size(); i++) {
+         line = patterns_.get(i).matcher(line).replaceAll(replacements_.get(i));
+      }
+      return line;
+   }
+}
@@ -11,11 +11,13 @@
 
 package org.micromanager.internal.diagnostics;
 
+import java.util.concurrent.atomic.AtomicLong;
 import org.micromanager.internal.utils.ReportingUtils;
 
 
 public final class ThreadExceptionLogger implements Thread.UncaughtExceptionHandler {
    private static boolean setUp_ = false;
+   private static final AtomicLong exceptionCount_ = new AtomicLong();
 
    public static void setUp() {
       if (setUp_) {
@@ -34,6 +36,13 @@ public final class ThreadExceptionLogger implements Thread.UncaughtExceptionHand
       setUp_ = true;
    }
 
+   /**
+    * Returns the number of uncaught exceptions logged so far.
+    */
+   public static long getExceptionCount() {
+      return exceptionCount_.get();
+   }
+
    private final Thread.UncaughtExceptionHandler chainedHandler_;
 
    public ThreadExceptionLogger(Thread.UncaughtExceptionHandler chained) {
@@ -47,6 +56,7 @@ public final class ThreadExceptionLogger implements Thread.UncaughtExceptionHand
 
    @Override
    public void uncaughtException(Thread t, Throwable e) {
+      exceptionCount_.incrementAndGet();
       ReportingUtils.logMessage("Thread " + t.getId() + " (" + t.getName()
             + ") terminated with uncaught exception");
       logException(e);
@@ -57,6 +67,7 @@ public final class ThreadExceptionLogger implements Thread.UncaughtExceptionHand
 
    // This method is called reflectively via the sun.awt.exception.handler mechanism.
    public void handle(Throwable e) {
+      exceptionCount_.incrementAndGet();
       ReportingUtils.logMessage("Uncaught exception in AWT/Swing event dispatch thread:");
       logException(e);
    }
@@ -349,11 +349,8 @@ public abstract class ConfigDialog extends JDialog {
 
    @Subscribe
    public void onPropertyChanged(PropertyChangedEvent event) {
-      // avoid re-executing a refresh because of callbacks while we are
-      // updating
-      if (!data_.updating()) {
-         data_.update(true);
-      }
+      // only the row of the property changes
+      data_.update(event.getDevice(), event.getProperty(), event.getValue());
    }
 
 }
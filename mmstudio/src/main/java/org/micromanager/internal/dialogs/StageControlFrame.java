@@ -86,6 +86,8 @@ public final class StageControlFrame extends JFrame {
    private static final int MAX_NUM_Z_PANELS = 5;
    private static final int FRAME_X_DEFAULT_POS = 100;
    private static final int FRAME_Y_DEFAULT_POS = 100;
+   // Refresh interval of the estimated XY position while the stage moves
+   private static final int XY_ESTIMATE_INTERVAL_MS = 50;
 
    public static final String[] X_MOVEMENTS = new String[] {
          "SMALLMOVEMENT", "MEDIUMMOVEMENT", "LARGEMOVEMENT"
@@ -125,6 +127,8 @@ public final class StageControlFrame extends JFrame {
    private JCheckBox enableRefreshCB_;
    private JCheckBox snapAfterMoveCB_;
    private Timer timer_ = null;
+   private final javax.swing.Timer xyEstimateTimer_ = new javax.swing.Timer(
+         XY_ESTIMATE_INTERVAL_MS, e -> showEstimatedXYPosition());
    // Ordered small, medium, large.
    private final JFormattedTextField[] xStepTexts_;
    private final JFormattedTextField[] yStepTexts_;
@@ -785,6 +789,7 @@ public final class StageControlFrame extends JFrame {
 
    private void setRelativeXYStagePosition(double x, double y) {
       uiMovesStageManager_.getXYNavigator().moveSampleUm(x, y);
+      xyEstimateTimer_.start();
       if (settings_.getBoolean(SNAP, false)) {
          try {
             core_.waitForDevice(core_.getXYStageDevice());
@@ -820,6 +825,20 @@ public final class StageControlFrame extends JFrame {
       setXYPosLabel(pos.x, pos.y);
    }
 
+   /**
+    * Shows where the XY stage is estimated to be between position readbacks,
+    * until it stops moving.
+    */
+   private void showEstimatedXYPosition() {
+      Point2D estimate = uiMovesStageManager_.getXYNavigator()
+            .getEstimatedXYPosition(core_.getXYStageDevice());
+      if (estimate == null) {
+         xyEstimateTimer_.stop();
+         return;
+      }
+      setXYPosLabel(estimate.getX(), estimate.getY());
+   }
+
    private void setXYPosLabel(double x, double y) {
       xyPositionLabel_.setText(String.format(
             "<html>X: %s \u00b5m<br>Y: %s \u00b5m</html>", // micro-m, i.e. micron
@@ -955,6 +974,7 @@ public final class StageControlFrame extends JFrame {
          }
       }
       stopTimer();
+      xyEstimateTimer_.stop();
       super.dispose();
    }
 
@@ -24,13 +24,20 @@
 package org.micromanager.internal.graph;
 
 import java.awt.geom.Point2D;
+import java.util.function.Function;
 
 /**
  * XY graph data structure.
+ *
+ * <p>Holds either arrays set with setData, or a {@link GraphSeries} that
+ * points are appended to.
  */
 public final class GraphData {
    private double[] xVals_;
    private double[] yVals_;
+   private volatile GraphSeries series_;
+   // Incremented when the data are replaced
+   private volatile long version_ = 0;
 
    /**
     * Stores bounds. NOt sure why Rect could not be used instead.
@@ -75,78 +82,155 @@ public final class GraphData {
       }
    }
 
+   /**
+    * Creates data that points are appended to, keeping the given number of
+    * most recent points.
+    *
+    * @param capacity maximum number of points
+    */
+   public GraphData(int capacity) {
+      series_ = new GraphSeries(capacity);
+   }
+
+   /**
+    * Appends a point; only for data created with a capacity.
+    */
+   public void append(double x, double y) {
+      GraphSeries series = series_;
+      if (series == null) {
+         throw new IllegalStateException("GraphData was not created for appending");
+      }
+      series.append(x, y);
+   }
+
+   /**
+    * Returns the series points are appended to, or null if the data were set
+    * as arrays.
+    */
+   public GraphSeries getSeries() {
+      return series_;
+   }
+
+   long getVersion() {
+      return version_;
+   }
+
+   /**
+    * Reads the points; appends are held off until the reader returns.
+    */
+   <T> T read(Function<GraphDecimator.Points, T> reader) {
+      GraphSeries series = series_;
+      if (series != null) {
+         return series.read(reader);
+      }
+      // The arrays may be replaced while they are read
+      final double[] xVals = xVals_;
+      final double[] yVals = yVals_;
+      return reader.apply(new GraphDecimator.Points() {
+         @Override
+         public int size() {
+            return xVals.length;
+         }
+
+         @Override
+         public double getX(int index) {
+            return xVals[index];
+         }
+
+         @Override
+         public double getY(int index) {
+            return index < yVals.length ? yVals[index] : 0.0;
+         }
+      });
+   }
+
+   public double getX(int index) {
+      GraphSeries series = series_;
+      return series != null ? series.getX(index) : xVals_[index];
+   }
+
+   public double getY(int index) {
+      GraphSeries series = series_;
+      if (series != null) {
+         return series.getY(index);
+      }
+      return index < yVals_.length ? yVals_[index] : 0.0;
+   }
+
    public Bounds getBounds() {
+      return read(this::getBounds);
+   }
+
+   private Bounds getBounds(GraphDecimator.Points points) {
       Bounds b = new Bounds();
       b.xMax = Double.MIN_VALUE;
       b.xMin = Double.MAX_VALUE;
       b.yMax = Double.MIN_VALUE;
       b.yMin = Double.MAX_VALUE;
 
-      for (int i = 0; i < xVals_.length; i++) {
-         if (xVals_[i] > b.xMax) {
-            b.xMax = xVals_[i];
+      for (int i = 0; i < points.size(); i++) {
+         double x = points.getX(i);
+         if (x > b.xMax) {
+            b.xMax = x;
          }
-         if (xVals_[i] < b.xMin) {
-            b.xMin = xVals_[i];
+         if (x < b.xMin) {
+            b.xMin = x;
          }
-      }
-      for (int i = 0; i < yVals_.length; i++) {
-         if (yVals_[i] > b.yMax) {
-            b.yMax = yVals_[i];
+         double y = points.getY(i);
+         if (y > b.yMax) {
+            b.yMax = y;
          }
-         if (yVals_[i] < b.yMin) {
-            b.yMin = yVals_[i];
+         if (y < b.yMin) {
+            b.yMin = y;
          }
       }
       return b;
    }
 
    public int getSize() {
-      return xVals_.length;
+      GraphSeries series = series_;
+      return series != null ? series.size() : xVals_.length;
    }
 
    public Point2D.Double getPoint(int index) {
-      double x = xVals_[index];
-      double y;
-      if (index < yVals_.length) {
-         y = yVals_[index];
-      } else {
-         y = 0.0;
-      }
-      return new Point2D.Double(x, y);
+      return new Point2D.Double(getX(index), getY(index));
    }
 
    public void setData(double[] xVals, double[] yVals) {
+      series_ = null;
       xVals_ = xVals;
       yVals_ = yVals;
+      version_++;
 
       // TODO: adjust lengths
    }
 
    public void setData(double[] yVals) {
-      yVals_ = yVals;
-      xVals_ = new double[yVals.length];
-      for (int i = 0; i < xVals_.length; i++) {
-         xVals_[i] = i;
+      double[] xVals = new double[yVals.length];
+      for (int i = 0; i < xVals.length; i++) {
+         xVals[i] = i;
       }
+      setData(xVals, yVals);
    }
 
    public void setData(int[] yIntVals) {
-      yVals_ = new double[yIntVals.length];
-      xVals_ = new double[yIntVals.length];
+      double[] yVals = new double[yIntVals.length];
+      double[] xVals = new double[yIntVals.length];
       for (int i = 0; i < yIntVals.length; i++) {
-         yVals_[i] = yIntVals[i];
-         xVals_[i] = i;
+         yVals[i] = yIntVals[i];
+         xVals[i] = i;
       }
+      setData(xVals, yVals);
    }
 
    /**
     * Rescale the Y axis to a logarithmic scale.
     */
    public GraphData logScale() {
-      double[] newYs = new double[yVals_.length];
+      double[] newYs = new double[getSize()];
       for (int i = 0; i < newYs.length; ++i) {
-         newYs[i] = yVals_[i] > 0 ? 1000 * Math.log(yVals_[i]) : 0;
+         double y = getY(i);
+         newYs[i] = y > 0 ? 1000 * Math.log(y) : 0;
       }
       GraphData result = new GraphData();
       result.setData(newYs);
@@ -156,8 +240,8 @@ public final class GraphData {
    @Override
    public String toString() {
       StringBuilder result = new StringBuilder("<GraphData:\n");
-      for (int i = 0; i < xVals_.length; ++i) {
-         result.append(String.format("%d: %.2f,%.2f;\n", i, xVals_[i], yVals_[i]));
+      for (int i = 0; i < getSize(); ++i) {
+         result.append(String.format("%d: %.2f,%.2f;\n", i, getX(i), getY(i)));
       }
       return result.append(">").toString();
    }
@@ -0,0 +1,135 @@
+package org.micromanager.internal.graph;
+
+import java.util.Arrays;
+
+/**
+ * Reduces a series to at most four points per pixel column (M4 decimation):
+ * the first and last point in the column, and the points with the smallest
+ * and largest Y. A line through these points covers the same pixels as a
+ * line through all points, so long series can be drawn in time
+ * proportional to the width of the plot.
+ *
+ * <p>Consecutive points in the same column form a run; X need not
+ * increase, but series that go back and forth produce more runs.
+ */
+final class GraphDecimator {
+   /**
+    * Points of a series, by index.
+    */
+   interface Points {
+      int size();
+
+      double getX(int index);
+
+      double getY(int index);
+   }
+
+   /**
+    * Decimated points, in the order of the series.
+    */
+   static final class Result {
+      private double[] xs_ = new double[64];
+      private double[] ys_ = new double[64];
+      private int size_ = 0;
+
+      int size() {
+         return size_;
+      }
+
+      double getX(int index) {
+         return xs_[index];
+      }
+
+      double getY(int index) {
+         return ys_[index];
+      }
+
+      private void add(double x, double y) {
+         if (size_ == xs_.length) {
+            xs_ = Arrays.copyOf(xs_, 2 * size_);
+            ys_ = Arrays.copyOf(ys_, 2 * size_);
+         }
+         xs_[size_] = x;
+         ys_[size_] = y;
+         size_++;
+      }
+   }
+
+   private GraphDecimator() {
+   }
+
+   /**
+    * Decimates points to pixel columns. Points outside of the X range are
+    * counted to the first or last column, as they are drawn at the edge.
+    *
+    * @param points the series
+    * @param from index of the first point to include
+    * @param to index after the last point to include
+    * @param xMin X at the left edge of the first column
+    * @param xMax X at the right edge of the last column
+    * @param columns number of columns (pixels)
+    * @return decimated points
+    */
+   static Result decimate(Points points, int from, int to,
+                          double xMin, double xMax, int columns) {
+      Result result = new Result();
+      if (from >= to) {
+         return result;
+      }
+      double scale = columns / (xMax - xMin);
+      int column = Integer.MIN_VALUE;
+      int first = -1;
+      int min = -1;
+      int max = -1;
+      int last = -1;
+      double minY = 0.0;
+      double maxY = 0.0;
+      for (int i = from; i < to; i++) {
+         double y = points.getY(i);
+         int c = columnOf(points.getX(i), xMin, scale, columns);
+         if (c != column) {
+            if (first >= 0) {
+               emit(points, result, first, min, max, last);
+            }
+            column = c;
+            first = min = max = last = i;
+            minY = maxY = y;
+            continue;
+         }
+         last = i;
+         if (y < minY) {
+            minY = y;
+            min = i;
+         } else if (y > maxY) {
+            maxY = y;
+            max = i;
+         }
+      }
+      emit(points, result, first, min, max, last);
+      return result;
+   }
+
+   private static int columnOf(double x, double xMin, double scale, int columns) {
+      double c = Math.floor((x - xMin) * scale);
+      if (c < 0) {
+         return 0;
+      }
+      return c >= columns ? columns - 1 : (int) c;
+   }
+
+   private static void emit(Points points, Result result,
+                            int first, int min, int max, int last) {
+      result.add(points.getX(first), points.getY(first));
+      int low = Math.min(min, max);
+      int high = Math.max(min, max);
+      if (low != first) {
+         result.add(points.getX(low), points.getY(low));
+      }
+      if (high != low && high != first) {
+         result.add(points.getX(high), points.getY(high));
+      }
+      if (last != high && last != first) {
+         result.add(points.getX(last), points.getY(last));
+      }
+   }
+}
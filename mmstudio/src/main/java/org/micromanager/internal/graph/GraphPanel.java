@@ -33,7 +33,6 @@ import java.awt.Rectangle;
 import java.awt.RenderingHints;
 import java.awt.Stroke;
 import java.awt.geom.AffineTransform;
-import java.awt.geom.GeneralPath;
 import java.awt.geom.Line2D;
 import java.awt.geom.Point2D;
 import java.text.DecimalFormat;
@@ -61,6 +60,9 @@ public final class GraphPanel extends JPanel {
 
    private boolean fillTrace_ = false;
    private Color traceColor_ = Color.black;
+   // Incremented by setData, as the data may have changed in place
+   private long dataVersion_ = 0;
+   private final TraceRenderer renderer_ = new TraceRenderer(this::repaint);
 
    public GraphPanel() {
       data_ = new GraphData();
@@ -72,6 +74,7 @@ public final class GraphPanel extends JPanel {
 
    public void setData(GraphData d) {
       data_ = d;
+      dataVersion_++;
    }
 
    public void setLabels(String xLabel, String yLabel) {
@@ -140,6 +143,9 @@ public final class GraphPanel extends JPanel {
    /**
     * Draw graph traces.
     *
+    * <p>The trace is rendered into an image by a {@link TraceRenderer},
+    * in the background for long series.
+    *
     * @param g
     * @param box
     */
@@ -148,9 +154,6 @@ public final class GraphPanel extends JPanel {
          return;
       }
 
-      final Color oldColor = g.getColor();
-      g.setColor(traceColor_);
-
       // correct if Y range is zero
       if (bounds_.getRangeY() == 0.0) {
          if (bounds_.yMax > 0.0) {
@@ -165,37 +168,12 @@ public final class GraphPanel extends JPanel {
          return; // invalid range data
       }
 
-      // set scaling
-      float xUnit = (float) (box.width / bounds_.getRangeX());
-      float yUnit = (float) (box.height / bounds_.getRangeY());
-
-      GeneralPath trace = new GeneralPath(GeneralPath.WIND_EVEN_ODD, data_.getSize() + 1);
-      // we need to start and end at y=0 to avoid strange display issues
-      Point2D.Float pt0 = getDevicePoint(new Point2D.Float(0.0f, 0.0f), box, xUnit, yUnit);
-      trace.moveTo(pt0.x, pt0.y);
-      Point2D.Float pt1 = getDevicePoint(new Point2D.Float(1.0f, 0.0f), box, xUnit, yUnit);
-      float halfWidth = (pt1.x - pt0.x) / 2;
-      for (int i = 0; i < data_.getSize(); i++) {
-         // Convert from double to float.
-         Point2D.Double tmp = data_.getPoint(i);
-         Point2D.Float pt = getDevicePoint(
-               new Point2D.Float((float) tmp.x, (float) tmp.y),
-               box, xUnit, yUnit);
-         trace.lineTo(pt.x - halfWidth, pt.y);
-         trace.lineTo(pt.x + halfWidth, pt.y);
+      TraceRenderer.Trace trace = renderer_.update(new TraceRenderer.Request(data_,
+            dataVersion_, box.width, box.height, bounds_, fillTrace_, traceColor_));
+      if (trace != null) {
+         g.drawImage(trace.getImage(), box.x - TraceRenderer.PAD,
+               box.y - TraceRenderer.PAD, null);
       }
-      pt0 = getDevicePoint(new Point2D.Float((float) data_.getPoint(
-            data_.getSize() - 1).getX(), 0.0f),
-            box, xUnit, yUnit);
-      trace.lineTo(pt0.x, pt0.y);
-
-      if (fillTrace_) {
-         g.fill(trace);
-      } else {
-         g.draw(trace);
-      }
-
-      g.setColor(oldColor);
    }
 
    public void drawCursor(Graphics2D g, Rectangle box, float xPos) {
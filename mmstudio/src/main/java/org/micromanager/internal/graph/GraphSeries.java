@@ -0,0 +1,119 @@
+package org.micromanager.internal.graph;
+
+import java.util.function.Function;
+
+/**
+ * Append-only series of XY points, kept in a ring buffer: once the buffer is
+ * full, each appended point replaces the oldest one.
+ *
+ * <p>All methods are thread safe, so that points can be appended from any
+ * thread while the series is rendered on another.
+ */
+public final class GraphSeries {
+   private final double[] xs_;
+   private final double[] ys_;
+   // Guarded by this
+   private int start_ = 0;
+   private int size_ = 0;
+   private long appended_ = 0;
+
+   private final GraphDecimator.Points points_ = new GraphDecimator.Points() {
+      @Override
+      public int size() {
+         return size_;
+      }
+
+      @Override
+      public double getX(int index) {
+         return xs_[physical(index)];
+      }
+
+      @Override
+      public double getY(int index) {
+         return ys_[physical(index)];
+      }
+   };
+
+   /**
+    * @param capacity maximum number of points kept
+    */
+   public GraphSeries(int capacity) {
+      if (capacity < 1) {
+         throw new IllegalArgumentException("Capacity must be positive");
+      }
+      xs_ = new double[capacity];
+      ys_ = new double[capacity];
+   }
+
+   private int physical(int index) {
+      int i = start_ + index;
+      return i < xs_.length ? i : i - xs_.length;
+   }
+
+   public synchronized void append(double x, double y) {
+      int end = physical(size_ == xs_.length ? 0 : size_);
+      xs_[end] = x;
+      ys_[end] = y;
+      if (size_ == xs_.length) {
+         start_ = physical(1);
+      } else {
+         size_++;
+      }
+      appended_++;
+   }
+
+   public synchronized void appendAll(double[] xs, double[] ys) {
+      for (int i = 0; i < xs.length; i++) {
+         append(xs[i], ys[i]);
+      }
+   }
+
+   public synchronized void clear() {
+      start_ = 0;
+      size_ = 0;
+      appended_ = 0;
+   }
+
+   public int getCapacity() {
+      return xs_.length;
+   }
+
+   public synchronized int size() {
+      return size_;
+   }
+
+   /**
+    * Returns the number of points appended since the series was created or
+    * cleared, including those that were dropped.
+    */
+   public synchronized long getAppendCount() {
+      return appended_;
+   }
+
+   /**
+    * @param index index of the point, 0 being the oldest point kept
+    */
+   public synchronized double getX(int index) {
+      checkIndex(index);
+      return xs_[physical(index)];
+   }
+
+   public synchronized double getY(int index) {
+      checkIndex(index);
+      return ys_[physical(index)];
+   }
+
+   private void checkIndex(int index) {
+      if (index < 0 || index >= size_) {
+         throw new IndexOutOfBoundsException("Index " + index + ", size " + size_);
+      }
+   }
+
+   /**
+    * Reads the points while appends are held off; the Points must not be
+    * used after the reader returns.
+    */
+   synchronized <T> T read(Function<GraphDecimator.Points, T> reader) {
+      return reader.apply(points_);
+   }
+}
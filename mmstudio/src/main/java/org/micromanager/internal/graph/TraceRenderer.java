@@ -0,0 +1,294 @@
+package org.micromanager.internal.graph;
+
+import java.awt.BasicStroke;
+import java.awt.Color;
+import java.awt.Graphics2D;
+import java.awt.RenderingHints;
+import java.awt.geom.GeneralPath;
+import java.awt.image.BufferedImage;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.atomic.AtomicReference;
+
+/**
+ * Renders the trace of a {@link GraphPanel} into an image, which is drawn
+ * on each paint until the data or the view change.
+ *
+ * <p>Long series are rendered on a background thread, while the previous
+ * image is still shown, and are decimated to pixel columns with
+ * {@link GraphDecimator}. When points were only appended to a
+ * {@link GraphSeries} since the last render, only the new points are drawn
+ * onto the image.
+ */
+final class TraceRenderer {
+   // Series up to this size are rendered when painted, on the EDT
+   static final int SYNC_POINTS = 20000;
+   // Margin around the plot in the image, for the stroke
+   static final int PAD = 2;
+
+   private static final ExecutorService EXECUTOR = Executors.newSingleThreadExecutor(r -> {
+      Thread thread = new Thread(r, "Graph trace renderer");
+      thread.setDaemon(true);
+      return thread;
+   });
+
+   /**
+    * What a trace is rendered from: the data and the view.
+    */
+   static final class Request {
+      private final GraphData data_;
+      private final long version_;
+      private final int width_;
+      private final int height_;
+      private final double xMin_;
+      private final double xMax_;
+      private final double yMin_;
+      private final double yMax_;
+      private final boolean fill_;
+      private final Color color_;
+
+      /**
+       * @param version changes when the data have to be rendered again
+       *                although only points were appended
+       */
+      Request(GraphData data, long version, int width, int height,
+              GraphData.Bounds bounds, boolean fill, Color color) {
+         data_ = data;
+         version_ = version + data.getVersion();
+         width_ = width;
+         height_ = height;
+         xMin_ = bounds.xMin;
+         xMax_ = bounds.xMax;
+         yMin_ = bounds.yMin;
+         yMax_ = bounds.yMax;
+         fill_ = fill;
+         color_ = color;
+      }
+
+      private boolean isSameView(Request other) {
+         return data_ == other.data_ && version_ == other.version_
+               && width_ == other.width_ && height_ == other.height_
+               && xMin_ == other.xMin_ && xMax_ == other.xMax_
+               && yMin_ == other.yMin_ && yMax_ == other.yMax_
+               && fill_ == other.fill_ && color_.equals(other.color_);
+      }
+
+      private long getAppendCount() {
+         GraphSeries series = data_.getSeries();
+         return series != null ? series.getAppendCount() : data_.getSize();
+      }
+
+      private float toDeviceX(double x) {
+         double dx = (x - xMin_) * width_ / (xMax_ - xMin_);
+         return PAD + (float) Math.max(0.0, Math.min(width_, dx));
+      }
+
+      private float toDeviceY(double y) {
+         double dy = height_ - (y - yMin_) * height_ / (yMax_ - yMin_);
+         return PAD + (float) Math.max(0.0, Math.min(height_, dy));
+      }
+   }
+
+   /**
+    * A rendered trace.
+    */
+   static final class Trace {
+      private final Request request_;
+      private final BufferedImage image_;
+      private final long appended_;
+      private final long dropped_;
+      private final boolean decimated_;
+      private final double lastX_;
+      private final double lastY_;
+
+      private Trace(Request request, BufferedImage image, long appended, long dropped,
+                    boolean decimated, double lastX, double lastY) {
+         request_ = request;
+         image_ = image;
+         appended_ = appended;
+         dropped_ = dropped;
+         decimated_ = decimated;
+         lastX_ = lastX;
+         lastY_ = lastY;
+      }
+
+      /**
+       * Returns the image, with the plot box at (PAD, PAD).
+       */
+      BufferedImage getImage() {
+         return image_;
+      }
+
+      boolean isDecimated() {
+         return decimated_;
+      }
+
+      private boolean isCurrent(Request request) {
+         return request_.isSameView(request) && appended_ == request.getAppendCount();
+      }
+   }
+
+   private final Runnable onRendered_;
+   private volatile Trace trace_;
+   private final AtomicReference<Request> pending_ = new AtomicReference<>();
+
+   /**
+    * @param onRendered called on the rendering thread when a trace was
+    *                   rendered in the background
+    */
+   TraceRenderer(Runnable onRendered) {
+      onRendered_ = onRendered;
+   }
+
+   /**
+    * Returns the trace to draw for the request, rendering it if it is cheap
+    * to do so. Otherwise, the trace is rendered in the background, and the
+    * previous trace is returned if it has the same size.
+    *
+    * @return the trace, or null if there is none to draw yet
+    */
+   Trace update(Request request) {
+      if (request.width_ <= 0 || request.height_ <= 0) {
+         return null;
+      }
+      Trace trace = trace_;
+      if (trace != null && trace.isCurrent(request)) {
+         return trace;
+      }
+      if (request.data_.getSize() <= SYNC_POINTS) {
+         trace_ = render(request, trace);
+         return trace_;
+      }
+      if (pending_.getAndSet(request) == null) {
+         EXECUTOR.submit(this::renderPending);
+      }
+      if (trace != null && trace.request_.width_ == request.width_
+            && trace.request_.height_ == request.height_) {
+         return trace;
+      }
+      return null;
+   }
+
+   private void renderPending() {
+      Request request = pending_.getAndSet(null);
+      if (request == null) {
+         return;
+      }
+      trace_ = render(request, trace_);
+      onRendered_.run();
+   }
+
+   /**
+    * Renders a trace, drawing only the appended points onto the previous
+    * trace when possible.
+    *
+    * @param request what to render
+    * @param previous the last trace, or null
+    * @return the new trace
+    */
+   static Trace render(final Request request, final Trace previous) {
+      return request.data_.read(points -> {
+         int size = points.size();
+         GraphSeries series = request.data_.getSeries();
+         long appended = series != null ? series.getAppendCount() : size;
+         long dropped = appended - size;
+         if (size == 0) {
+            return new Trace(request, createImage(request), appended, dropped, false, 0, 0);
+         }
+         double lastX = points.getX(size - 1);
+         double lastY = points.getY(size - 1);
+         if (previous != null && previous.decimated_ && previous.request_.isSameView(request)
+               && previous.dropped_ == dropped && previous.appended_ < appended) {
+            int from = (int) (previous.appended_ - dropped);
+            drawTail(request, previous, points, from, size);
+            return new Trace(request, previous.image_, appended, dropped, true, lastX, lastY);
+         }
+         BufferedImage image = createImage(request);
+         boolean decimated = size > 2 * request.width_;
+         if (decimated) {
+            drawDecimated(request, image, points, size);
+         } else {
+            drawExact(request, image, points, size);
+         }
+         return new Trace(request, image, appended, dropped, decimated, lastX, lastY);
+      });
+   }
+
+   private static BufferedImage createImage(Request request) {
+      return new BufferedImage(request.width_ + 2 * PAD, request.height_ + 2 * PAD,
+            BufferedImage.TYPE_INT_ARGB);
+   }
+
+   private static void draw(Request request, BufferedImage image, GeneralPath path) {
+      Graphics2D g = image.createGraphics();
+      try {
+         g.setRenderingHint(RenderingHints.KEY_ANTIALIASING, RenderingHints.VALUE_ANTIALIAS_ON);
+         g.setStroke(new BasicStroke(2));
+         g.setColor(request.color_);
+         if (request.fill_) {
+            g.fill(path);
+         } else {
+            g.draw(path);
+         }
+      } finally {
+         g.dispose();
+      }
+   }
+
+   // Draws each point as a step one unit wide, from and to y = 0
+   private static void drawExact(Request request, BufferedImage image,
+                                 GraphDecimator.Points points, int size) {
+      GeneralPath path = new GeneralPath(GeneralPath.WIND_EVEN_ODD, 2 * size + 2);
+      float x0 = request.toDeviceX(0.0);
+      float y0 = request.toDeviceY(0.0);
+      path.moveTo(x0, y0);
+      float halfWidth = (request.toDeviceX(1.0) - x0) / 2;
+      for (int i = 0; i < size; i++) {
+         float x = request.toDeviceX(points.getX(i));
+         float y = request.toDeviceY(points.getY(i));
+         path.lineTo(x - halfWidth, y);
+         path.lineTo(x + halfWidth, y);
+      }
+      path.lineTo(request.toDeviceX(points.getX(size - 1)), y0);
+      draw(request, image, path);
+   }
+
+   // Steps are narrower than a pixel here, so points are connected directly
+   private static void drawDecimated(Request request, BufferedImage image,
+                                     GraphDecimator.Points points, int size) {
+      GraphDecimator.Result result = GraphDecimator.decimate(points, 0, size,
+            request.xMin_, request.xMax_, request.width_);
+      draw(request, image, toPath(request, result, result.getX(0), result.getY(0)));
+   }
+
+   private static void drawTail(Request request, Trace previous,
+                                GraphDecimator.Points points, int from, int size) {
+      GraphDecimator.Result result = GraphDecimator.decimate(points, from, size,
+            request.xMin_, request.xMax_, request.width_);
+      draw(request, previous.image_, toPath(request, result, previous.lastX_, previous.lastY_));
+   }
+
+   /**
+    * Builds the path from a start point through the decimated points; when
+    * filling, the path is closed along y = 0.
+    */
+   private static GeneralPath toPath(Request request, GraphDecimator.Result result,
+                                     double startX, double startY) {
+      GeneralPath path = new GeneralPath(GeneralPath.WIND_EVEN_ODD, result.size() + 3);
+      float y0 = request.toDeviceY(0.0);
+      if (request.fill_) {
+         path.moveTo(request.toDeviceX(startX), y0);
+         path.lineTo(request.toDeviceX(startX), request.toDeviceY(startY));
+      } else {
+         path.moveTo(request.toDeviceX(startX), request.toDeviceY(startY));
+      }
+      for (int i = 0; i < result.size(); i++) {
+         path.lineTo(request.toDeviceX(result.getX(i)), request.toDeviceY(result.getY(i)));
+      }
+      if (request.fill_) {
+         path.lineTo(request.toDeviceX(result.getX(result.size() - 1)), y0);
+         path.closePath();
+      }
+      return path;
+   }
+}
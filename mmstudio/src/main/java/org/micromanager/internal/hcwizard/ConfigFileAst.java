@@ -0,0 +1,536 @@
+///////////////////////////////////////////////////////////////////////////////
+//PROJECT:       Micro-Manager
+//SUBSYSTEM:     mmstudio
+//-----------------------------------------------------------------------------
+//
+// COPYRIGHT:    University of California, San Francisco, 2024
+//
+// LICENSE:      This file is distributed under the BSD license.
+//               License text is included with the source distribution.
+//
+//               This file is distributed in the hope that it will be useful,
+//               but WITHOUT ANY WARRANTY; without even the implied warranty
+//               of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//               IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//               CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//               INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+//
+
+package org.micromanager.internal.hcwizard;
+
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.HashMap;
+import java.util.List;
+import java.util.Map;
+
+/**
+ * Parsed representation of a Micro-Manager configuration file.
+ *
+ * <p>Every line of the file is kept, including comments, blank lines and
+ * commands the Configurator does not know about, together with its line
+ * terminator, so that {@link #toText()} reproduces the file exactly.
+ * Instances are created by {@link ConfigFileParser}.
+ */
+public final class ConfigFileAst {
+
+   /**
+    * Configuration file commands understood by the Configurator.
+    */
+   public enum Command {
+      DEVICE("Device", 4, 4),
+      PROPERTY("Property", 3, 4),
+      LABEL("Label", 4, 4),
+      IMAGE_SYNCHRO("ImageSynchro", 2, 2),
+      CONFIG_GROUP("ConfigGroup", 5, 6),
+      CONFIG_PIXEL_SIZE("ConfigPixelSize", 5, 5),
+      PIXEL_SIZE_UM("PixelSize_um", 3, 3),
+      PIXEL_SIZE_AFFINE("PixelSizeAffine", 8, 8),
+      DELAY("Delay", 3, 3),
+      FOCUS_DIRECTION("FocusDirection", 3, 3),
+      PARENT("Parent", 3, 3);
+
+      private static final Map<String, Command> BY_KEYWORD = new HashMap<>();
+
+      static {
+         for (Command c : values()) {
+            BY_KEYWORD.put(c.keyword_, c);
+         }
+      }
+
+      private final String keyword_;
+      private final int minTokens_;
+      private final int maxTokens_;
+
+      Command(String keyword, int minTokens, int maxTokens) {
+         keyword_ = keyword;
+         minTokens_ = minTokens;
+         maxTokens_ = maxTokens;
+      }
+
+      public String getKeyword() {
+         return keyword_;
+      }
+
+      /**
+       * Minimum number of comma separated tokens, including the keyword.
+       */
+      public int getMinTokens() {
+         return minTokens_;
+      }
+
+      /**
+       * Maximum number of comma separated tokens, including the keyword.
+       */
+      public int getMaxTokens() {
+         return maxTokens_;
+      }
+
+      /**
+       * Looks up a command by its keyword.
+       *
+       * @param keyword first token of a line
+       * @return the command, or null if the keyword is unknown
+       */
+      public static Command fromKeyword(String keyword) {
+         return BY_KEYWORD.get(keyword);
+      }
+   }
+
+   /**
+    * Kind of a line in the configuration file.
+    */
+   public enum LineKind {
+      BLANK,
+      COMMENT,
+      /** A known command, see {@link Line#getCommand()}. */
+      COMMAND,
+      /** A command that is not known to the Configurator. */
+      UNKNOWN_COMMAND
+   }
+
+   /**
+    * A comma separated token with its position in the line.
+    */
+   public static final class Token {
+      private final String text_;
+      private final int column_;
+
+      Token(String text, int column) {
+         text_ = text;
+         column_ = column;
+      }
+
+      public String getText() {
+         return text_;
+      }
+
+      /**
+       * Returns the 1-based column of the first character of the token.
+       */
+      public int getColumn() {
+         return column_;
+      }
+
+      @Override
+      public String toString() {
+         return text_;
+      }
+   }
+
+   /**
+    * One line of the configuration file.
+    */
+   public static final class Line {
+      private final int number_;
+      private final String text_;
+      private final String terminator_;
+      private final LineKind kind_;
+      private final Command command_;
+      private final List<Token> tokens_;
+      private final boolean preInit_;
+
+      Line(int number, String text, String terminator, LineKind kind,
+            Command command, List<Token> tokens, boolean preInit) {
+         number_ = number;
+         text_ = text;
+         terminator_ = terminator;
+         kind_ = kind;
+         command_ = command;
+         tokens_ = Collections.unmodifiableList(tokens);
+         preInit_ = preInit;
+      }
+
+      Line withTerminator(String terminator) {
+         return new Line(number_, text_, terminator, kind_, command_, tokens_, preInit_);
+      }
+
+      /**
+       * Returns the 1-based line number, 0 for lines that were not parsed
+       * from a file.
+       */
+      public int getNumber() {
+         return number_;
+      }
+
+      /**
+       * Returns the text of the line, without line terminator.
+       */
+      public String getText() {
+         return text_;
+      }
+
+      /**
+       * Returns the line terminator, empty for a last line without one.
+       */
+      public String getTerminator() {
+         return terminator_;
+      }
+
+      public LineKind getKind() {
+         return kind_;
+      }
+
+      /**
+       * Returns the command, or null if this is not a known command.
+       */
+      public Command getCommand() {
+         return command_;
+      }
+
+      /**
+       * Returns the comma separated tokens, keyword included. As with
+       * {@code String.split(",")}, trailing empty tokens are not included.
+       */
+      public List<Token> getTokens() {
+         return tokens_;
+      }
+
+      /**
+       * Returns the text of token i, or "" if the line has fewer tokens.
+       */
+      public String token(int i) {
+         return i < tokens_.size() ? tokens_.get(i).getText() : "";
+      }
+
+      /**
+       * Returns the column of token i, or 0 if the line has fewer tokens.
+       */
+      public int column(int i) {
+         return i < tokens_.size() ? tokens_.get(i).getColumn() : 0;
+      }
+
+      /**
+       * Returns true if this line comes before the core is initialized
+       * ("Property,Core,Initialize,1").
+       */
+      public boolean isPreInit() {
+         return preInit_;
+      }
+
+      /**
+       * Returns the tokens joined by commas; lines with the same canonical
+       * text define the same thing.
+       */
+      public String canonicalText() {
+         StringBuilder sb = new StringBuilder();
+         for (int i = 0; i < tokens_.size(); i++) {
+            if (i > 0) {
+               sb.append(',');
+            }
+            sb.append(tokens_.get(i).getText());
+         }
+         return sb.toString();
+      }
+
+      boolean isInitialize() {
+         return command_ == Command.PROPERTY
+               && ConfigFileParser.CORE_DEVICE.equals(token(1))
+               && ConfigFileParser.CORE_INITIALIZE.equals(token(2));
+      }
+
+      /**
+       * Keys identifying the section of the file this line belongs to, most
+       * specific first.
+       */
+      List<String> sectionKeys() {
+         List<String> keys = new ArrayList<>();
+         if (command_ == null) {
+            return keys;
+         }
+         switch (command_) {
+            case DEVICE:
+               keys.add("Device");
+               break;
+            case PROPERTY:
+               if (isInitialize() && preInit_) {
+                  // "Property,Core,Initialize,0" comes before the devices, so
+                  // it cannot anchor pre-init properties
+                  keys.add("Reset");
+                  break;
+               }
+               String phase = preInit_ ? "Property:pre" : "Property:post";
+               if (isInitialize() && !preInit_) {
+                  keys.add("Initialize");
+               }
+               keys.add(phase + ":" + token(1));
+               keys.add(phase);
+               break;
+            case PARENT:
+               keys.add("Parent");
+               break;
+            case DELAY:
+               keys.add("Delay");
+               break;
+            case FOCUS_DIRECTION:
+               keys.add("FocusDirection");
+               break;
+            case IMAGE_SYNCHRO:
+               keys.add("ImageSynchro");
+               break;
+            case LABEL:
+               keys.add("Label:" + token(1));
+               keys.add("Label");
+               break;
+            case CONFIG_GROUP:
+               keys.add("ConfigGroup:" + token(1) + ":" + token(2));
+               keys.add("ConfigGroup:" + token(1));
+               keys.add("ConfigGroup");
+               break;
+            case CONFIG_PIXEL_SIZE:
+            case PIXEL_SIZE_UM:
+            case PIXEL_SIZE_AFFINE:
+               keys.add("PixelSize:" + token(1));
+               keys.add("PixelSize");
+               break;
+            default:
+               break;
+         }
+         return keys;
+      }
+
+      /**
+       * Keys of the lines after which a new line of this kind can be
+       * inserted, in order of preference. Follows the section order of
+       * MicroscopeModel.saveToFile().
+       */
+      List<String> anchorKeys() {
+         List<String> keys = new ArrayList<>();
+         if (command_ == null) {
+            return keys;
+         }
+         switch (command_) {
+            case DEVICE:
+               keys.add("Device");
+               keys.add("Reset");
+               break;
+            case PROPERTY:
+               if (preInit_) {
+                  keys.add("Property:pre:" + token(1));
+                  keys.add("Property:pre");
+                  keys.add("Device");
+               } else {
+                  keys.add("Property:post:" + token(1));
+                  keys.add("Property:post");
+               }
+               break;
+            case PARENT:
+               keys.add("Parent");
+               keys.add("Property:pre");
+               keys.add("Device");
+               break;
+            case DELAY:
+               keys.add("Delay");
+               keys.add("Initialize");
+               break;
+            case FOCUS_DIRECTION:
+               keys.add("FocusDirection");
+               keys.add("Delay");
+               keys.add("Initialize");
+               break;
+            case IMAGE_SYNCHRO:
+               keys.add("ImageSynchro");
+               keys.add("Property:post");
+               break;
+            case LABEL:
+               keys.add("Label:" + token(1));
+               keys.add("Label");
+               keys.add("ImageSynchro");
+               keys.add("Property:post");
+               break;
+            case CONFIG_GROUP:
+               keys.addAll(sectionKeys());
+               keys.add("Label");
+               keys.add("Property:post");
+               break;
+            case CONFIG_PIXEL_SIZE:
+            case PIXEL_SIZE_UM:
+            case PIXEL_SIZE_AFFINE:
+               keys.addAll(sectionKeys());
+               keys.add("ConfigGroup");
+               keys.add("Label");
+               keys.add("Property:post");
+               break;
+            default:
+               break;
+         }
+         return keys;
+      }
+   }
+
+   private final List<Line> lines_;
+   private final List<ConfigFileError> errors_;
+
+   ConfigFileAst(List<Line> lines, List<ConfigFileError> errors) {
+      lines_ = Collections.unmodifiableList(lines);
+      errors_ = Collections.unmodifiableList(errors);
+   }
+
+   public List<Line> getLines() {
+      return lines_;
+   }
+
+   /**
+    * Returns the syntax errors found while parsing, in line order.
+    */
+   public List<ConfigFileError> getErrors() {
+      return errors_;
+   }
+
+   /**
+    * Reproduces the parsed file, byte for byte.
+    */
+   public String toText() {
+      StringBuilder sb = new StringBuilder();
+      for (Line line : lines_) {
+         sb.append(line.getText()).append(line.getTerminator());
+      }
+      return sb.toString();
+   }
+
+   /**
+    * Merges a newly generated configuration into this (original) file.
+    *
+    * <p>Command lines of the original that also occur in the generated file
+    * are kept in place, together with all comments, blank lines and unknown
+    * commands. Commands that no longer occur are dropped, along with comment
+    * lines directly preceding a run of dropped commands. Commands that are
+    * new are inserted after the last line of the same section (for example
+    * after the other settings of the same preset). If a new command has no
+    * matching section in the original, the generated file is returned as is.
+    *
+    * @param generated configuration as written by the Configurator
+    * @return text of the merged configuration file
+    */
+   public String merge(ConfigFileAst generated) {
+      Map<String, Integer> remaining = new HashMap<>();
+      for (Line line : generated.lines_) {
+         if (line.getKind() == LineKind.COMMAND) {
+            remaining.merge(line.canonicalText(), 1, Integer::sum);
+         }
+      }
+
+      // Keep the original lines that are still valid. Lines are handled in
+      // blocks of comments followed by commands.
+      List<Line> output = new ArrayList<>();
+      List<Line> comments = new ArrayList<>();
+      List<Line> commands = new ArrayList<>();
+      int nrCommands = 0;
+      for (Line line : lines_) {
+         boolean isCommand = line.getKind() == LineKind.COMMAND
+               || line.getKind() == LineKind.UNKNOWN_COMMAND;
+         if (!isCommand && nrCommands > 0) {
+            flushBlock(output, comments, commands, nrCommands);
+            nrCommands = 0;
+         }
+         if (line.getKind() == LineKind.COMMENT) {
+            comments.add(line);
+         } else if (line.getKind() == LineKind.BLANK) {
+            output.addAll(comments);
+            comments.clear();
+            output.add(line);
+         } else {
+            nrCommands++;
+            if (line.getKind() == LineKind.UNKNOWN_COMMAND) {
+               commands.add(line);
+            } else {
+               Integer count = remaining.get(line.canonicalText());
+               if (count != null && count > 0) {
+                  remaining.put(line.canonicalText(), count - 1);
+                  commands.add(line);
+               }
+            }
+         }
+      }
+      flushBlock(output, comments, commands, nrCommands);
+
+      // Insert the new lines
+      String defaultTerminator = "\n";
+      for (Line line : lines_) {
+         if (!line.getTerminator().isEmpty()) {
+            defaultTerminator = line.getTerminator();
+            break;
+         }
+      }
+      List<List<String>> outputKeys = new ArrayList<>();
+      for (Line line : output) {
+         outputKeys.add(line.sectionKeys());
+      }
+      for (Line line : generated.lines_) {
+         if (line.getKind() != LineKind.COMMAND) {
+            continue;
+         }
+         Integer count = remaining.get(line.canonicalText());
+         if (count == null || count == 0) {
+            continue;
+         }
+         remaining.put(line.canonicalText(), count - 1);
+         int anchor = -1;
+         for (String key : line.anchorKeys()) {
+            for (int i = output.size() - 1; i >= 0 && anchor < 0; i--) {
+               if (outputKeys.get(i).contains(key)) {
+                  anchor = i;
+               }
+            }
+            if (anchor >= 0) {
+               break;
+            }
+         }
+         if (anchor < 0) {
+            return generated.toText();
+         }
+         Line anchorLine = output.get(anchor);
+         String terminator = anchorLine.getTerminator();
+         if (terminator.isEmpty()) {
+            // the anchor was the last line of the file
+            output.set(anchor, anchorLine.withTerminator(defaultTerminator));
+         }
+         Line inserted = line.withTerminator(terminator);
+         output.add(anchor + 1, inserted);
+         outputKeys.add(anchor + 1, inserted.sectionKeys());
+      }
+
+      StringBuilder sb = new StringBuilder();
+      for (Line line : output) {
+         sb.append(line.getText()).append(line.getTerminator());
+      }
+      return sb.toString();
+   }
+
+   /**
+    * Adds a block of comments and the commands following them to the output.
+    * If all commands of the block were dropped, the comment directly above
+    * them (typically naming the device or preset) is dropped as well.
+    */
+   private static void flushBlock(List<Line> output, List<Line> comments,
+         List<Line> commands, int nrCommands) {
+      if (nrCommands > 0 && commands.isEmpty() && !comments.isEmpty()) {
+         comments.remove(comments.size() - 1);
+      }
+      output.addAll(comments);
+      output.addAll(commands);
+      comments.clear();
+      commands.clear();
+   }
+}
@@ -0,0 +1,84 @@
+///////////////////////////////////////////////////////////////////////////////
+//PROJECT:       Micro-Manager
+//SUBSYSTEM:     mmstudio
+//-----------------------------------------------------------------------------
+//
+// COPYRIGHT:    University of California, San Francisco, 2024
+//
+// LICENSE:      This file is distributed under the BSD license.
+//               License text is included with the source distribution.
+//
+//               This file is distributed in the hope that it will be useful,
+//               but WITHOUT ANY WARRANTY; without even the implied warranty
+//               of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//               IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//               CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//               INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+//
+
+package org.micromanager.internal.hcwizard;
+
+import java.util.List;
+
+/**
+ * An error found while reading a configuration file, with its location.
+ */
+public final class ConfigFileError {
+   private final int line_;
+   private final int column_;
+   private final String message_;
+
+   /**
+    * Creates an error.
+    *
+    * @param line 1-based line number
+    * @param column 1-based column, 0 if the error applies to the whole line
+    * @param message description of the error
+    */
+   public ConfigFileError(int line, int column, String message) {
+      line_ = line;
+      column_ = column;
+      message_ = message;
+   }
+
+   public int getLine() {
+      return line_;
+   }
+
+   public int getColumn() {
+      return column_;
+   }
+
+   public String getMessage() {
+      return message_;
+   }
+
+   @Override
+   public String toString() {
+      if (column_ > 0) {
+         return "Line " + line_ + ", column " + column_ + ": " + message_;
+      }
+      return "Line " + line_ + ": " + message_;
+   }
+
+   /**
+    * Formats a list of errors for display, one per line.
+    *
+    * @param errors errors to format
+    * @param maxErrors maximum number of errors listed, the remainder is counted
+    * @return formatted errors
+    */
+   public static String format(List<ConfigFileError> errors, int maxErrors) {
+      StringBuilder sb = new StringBuilder();
+      sb.append(errors.size()).append(errors.size() == 1 ? " error" : " errors")
+            .append(" in configuration file:");
+      for (int i = 0; i < errors.size() && i < maxErrors; i++) {
+         sb.append("\n").append(errors.get(i));
+      }
+      if (errors.size() > maxErrors) {
+         sb.append("\n... and ").append(errors.size() - maxErrors).append(" more");
+      }
+      return sb.toString();
+   }
+}
@@ -0,0 +1,191 @@
+///////////////////////////////////////////////////////////////////////////////
+//PROJECT:       Micro-Manager
+//SUBSYSTEM:     mmstudio
+//-----------------------------------------------------------------------------
+//
+// COPYRIGHT:    University of California, San Francisco, 2024
+//
+// LICENSE:      This file is distributed under the BSD license.
+//               License text is included with the source distribution.
+//
+//               This file is distributed in the hope that it will be useful,
+//               but WITHOUT ANY WARRANTY; without even the implied warranty
+//               of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//               IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//               CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//               INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+//
+
+package org.micromanager.internal.hcwizard;
+
+import java.io.File;
+import java.io.IOException;
+import java.nio.charset.Charset;
+import java.nio.file.Files;
+import java.util.ArrayList;
+import java.util.List;
+
+/**
+ * Tokenizer and parser for Micro-Manager configuration files.
+ *
+ * <p>Parsing never stops at the first problem: all syntax errors (unknown
+ * number of parameters, malformed numbers) are collected in the returned
+ * {@link ConfigFileAst} together with their line and column. Checks that
+ * need the model, such as references to undefined devices, are done by
+ * {@link MicroscopeModel#loadFromFile(String)}.
+ */
+public final class ConfigFileParser {
+   // Same as MMCoreJ.getG_Keyword_CoreDevice() and
+   // MMCoreJ.getG_Keyword_CoreInitialize(), which are part of the file format
+   static final String CORE_DEVICE = "Core";
+   static final String CORE_INITIALIZE = "Initialize";
+
+   private ConfigFileParser() {
+   }
+
+   /**
+    * Reads and parses a configuration file, using the platform charset.
+    *
+    * @param file file to read
+    * @return parsed file
+    * @throws IOException if the file can not be read
+    */
+   public static ConfigFileAst parse(File file) throws IOException {
+      return parse(new String(Files.readAllBytes(file.toPath()),
+            Charset.defaultCharset()));
+   }
+
+   /**
+    * Parses the contents of a configuration file.
+    *
+    * @param text contents of the file
+    * @return parsed file
+    */
+   public static ConfigFileAst parse(String text) {
+      List<ConfigFileAst.Line> lines = new ArrayList<>();
+      List<ConfigFileError> errors = new ArrayList<>();
+      boolean preInit = true;
+      int start = 0;
+      int number = 1;
+      final int length = text.length();
+      while (start < length) {
+         int end = start;
+         while (end < length && text.charAt(end) != '\n' && text.charAt(end) != '\r') {
+            end++;
+         }
+         int next = end;
+         if (next < length) {
+            next += (text.charAt(next) == '\r' && next + 1 < length
+                  && text.charAt(next + 1) == '\n') ? 2 : 1;
+         }
+         String lineText = text.substring(start, end);
+         String terminator = text.substring(end, next);
+
+         ConfigFileAst.Line line = parseLine(number, lineText, terminator, preInit, errors);
+         if (line.isInitialize()) {
+            preInit = "0".equals(line.token(3));
+            line = new ConfigFileAst.Line(number, lineText, terminator, line.getKind(),
+                  line.getCommand(), line.getTokens(), preInit);
+         }
+         lines.add(line);
+         start = next;
+         number++;
+      }
+      return new ConfigFileAst(lines, errors);
+   }
+
+   private static ConfigFileAst.Line parseLine(int number, String text, String terminator,
+         boolean preInit, List<ConfigFileError> errors) {
+      String trimmed = text.trim();
+      if (trimmed.isEmpty()) {
+         return new ConfigFileAst.Line(number, text, terminator, ConfigFileAst.LineKind.BLANK,
+               null, new ArrayList<>(), preInit);
+      }
+      if (trimmed.startsWith("#")) {
+         return new ConfigFileAst.Line(number, text, terminator, ConfigFileAst.LineKind.COMMENT,
+               null, new ArrayList<>(), preInit);
+      }
+
+      List<ConfigFileAst.Token> tokens = tokenize(text);
+      ConfigFileAst.Command command = ConfigFileAst.Command.fromKeyword(tokens.get(0).getText());
+      if (command == null) {
+         return new ConfigFileAst.Line(number, text, terminator,
+               ConfigFileAst.LineKind.UNKNOWN_COMMAND, null, tokens, preInit);
+      }
+      ConfigFileAst.Line line = new ConfigFileAst.Line(number, text, terminator,
+            ConfigFileAst.LineKind.COMMAND, command, tokens, preInit);
+      validate(line, errors);
+      return line;
+   }
+
+   /**
+    * Splits a line at commas. Like {@code String.split(",")}, trailing empty
+    * tokens are removed, but at least one token is returned.
+    */
+   static List<ConfigFileAst.Token> tokenize(String text) {
+      List<ConfigFileAst.Token> tokens = new ArrayList<>();
+      int start = 0;
+      for (int i = 0; i <= text.length(); i++) {
+         if (i == text.length() || text.charAt(i) == ',') {
+            tokens.add(new ConfigFileAst.Token(text.substring(start, i), start + 1));
+            start = i + 1;
+         }
+      }
+      while (tokens.size() > 1 && tokens.get(tokens.size() - 1).getText().isEmpty()) {
+         tokens.remove(tokens.size() - 1);
+      }
+      return tokens;
+   }
+
+   private static void validate(ConfigFileAst.Line line, List<ConfigFileError> errors) {
+      ConfigFileAst.Command command = line.getCommand();
+      int nrTokens = line.getTokens().size();
+      if (nrTokens < command.getMinTokens() || nrTokens > command.getMaxTokens()) {
+         String required = command.getMinTokens() == command.getMaxTokens()
+               ? Integer.toString(command.getMinTokens())
+               : command.getMinTokens() + " or " + command.getMaxTokens();
+         errors.add(new ConfigFileError(line.getNumber(), 0,
+               "Invalid number of parameters for " + command.getKeyword() + " ("
+                     + required + " required, found " + nrTokens + "): " + line.getText()));
+         return;
+      }
+      switch (command) {
+         case LABEL:
+         case FOCUS_DIRECTION:
+            checkInteger(line, 2, errors);
+            break;
+         case DELAY:
+         case PIXEL_SIZE_UM:
+            checkDouble(line, 2, errors);
+            break;
+         case PIXEL_SIZE_AFFINE:
+            for (int i = 2; i < 8; i++) {
+               checkDouble(line, i, errors);
+            }
+            break;
+         default:
+            break;
+      }
+   }
+
+   private static void checkInteger(ConfigFileAst.Line line, int index,
+         List<ConfigFileError> errors) {
+      try {
+         Integer.parseInt(line.token(index));
+      } catch (NumberFormatException nfe) {
+         errors.add(new ConfigFileError(line.getNumber(), line.column(index),
+               "Expected an integer instead of \"" + line.token(index) + "\""));
+      }
+   }
+
+   private static void checkDouble(ConfigFileAst.Line line, int index,
+         List<ConfigFileError> errors) {
+      try {
+         Double.parseDouble(line.token(index));
+      } catch (NumberFormatException nfe) {
+         errors.add(new ConfigFileError(line.getNumber(), line.column(index),
+               "Expected a number instead of \"" + line.token(index) + "\""));
+      }
+   }
+}
@@ -24,6 +24,7 @@
 package org.micromanager.internal.hcwizard;
 
 import java.util.ArrayList;
+import java.util.HashMap;
 import java.util.Hashtable;
 import java.util.Vector;
 import mmcorej.CMMCore;
@@ -45,6 +46,8 @@ public final class Device {
    private final String adapterName_;
    private final String library_;
    private final ArrayList<PropertyItem> setupProperties_;
+   // setupProperties_ by name, the first of duplicates wins
+   private final HashMap<String, PropertyItem> setupPropertyIndex_ = new HashMap<>();
    private final String description_;
    private final Hashtable<Integer, Label> setupLabels_;
    private String name_;
@@ -247,6 +250,7 @@ public final class Device {
 
    public void addSetupProperty(PropertyItem prop) {
       setupProperties_.add(prop);
+      setupPropertyIndex_.putIfAbsent(prop.name, prop);
    }
 
    public void addSetupLabel(Label lab) {
@@ -392,12 +396,16 @@ public final class Device {
    }
 
    public PropertyItem findSetupProperty(String name) {
-      for (PropertyItem p : setupProperties_) {
-         if (p.name.contentEquals(new StringBuffer().append(name))) {
-            return p;
+      PropertyItem p = setupPropertyIndex_.get(name);
+      if (p != null && !p.name.equals(name)) {
+         // the property was renamed after it was added
+         setupPropertyIndex_.clear();
+         for (PropertyItem item : setupProperties_) {
+            setupPropertyIndex_.putIfAbsent(item.name, item);
          }
+         p = setupPropertyIndex_.get(name);
       }
-      return null;
+      return p;
    }
 
    public double getDelay() {
@@ -448,9 +456,10 @@ public final class Device {
 
    public void updateSetupProperties() {
       setupProperties_.clear();
+      setupPropertyIndex_.clear();
       for (PropertyItem propertyItem : properties_) {
-         setupProperties_
-               .add(new PropertyItem(propertyItem.name, propertyItem.value, propertyItem.preInit));
+         addSetupProperty(
+               new PropertyItem(propertyItem.name, propertyItem.value, propertyItem.preInit));
       }
    }
 
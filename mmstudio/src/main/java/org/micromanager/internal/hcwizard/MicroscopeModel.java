@@ -23,16 +23,19 @@
 
 package org.micromanager.internal.hcwizard;
 
-import java.io.BufferedReader;
 import java.io.BufferedWriter;
 import java.io.File;
-import java.io.FileReader;
 import java.io.FileWriter;
 import java.io.IOException;
+import java.io.StringWriter;
 import java.util.ArrayList;
 import java.util.Enumeration;
 import java.util.GregorianCalendar;
+import java.util.HashMap;
+import java.util.HashSet;
 import java.util.Hashtable;
+import java.util.List;
+import java.util.Set;
 import java.util.Vector;
 import java.util.concurrent.atomic.AtomicBoolean;
 import javax.swing.JOptionPane;
@@ -63,9 +66,19 @@ public final class MicroscopeModel {
    Hashtable<String, ConfigGroup> configGroups_;
    ConfigGroup pixelSizeGroup_;
    ArrayList<String> synchroDevices_;
+   // devices_ by name, kept in sync with devices_
+   private final HashMap<String, Device> deviceIndex_ = new HashMap<>();
+   // availableDevices_ by library and adapter name, rebuilt when
+   // availableDevices_ is replaced
+   private final HashMap<String, Device> availableDeviceIndex_ = new HashMap<>();
+   private final HashSet<String> availableLibraries_ = new HashSet<>();
+   private Device[] indexedAvailableDevices_ = null;
+   // file the model was loaded from, used to preserve its layout on saving
+   private ConfigFileAst configFileAst_ = null;
    // this device list is created WITHOUT automated peripheral device discovery
    public static final String DEVLIST_FILE_NAME = "MMDeviceList.txt";
    public static final String PIXEL_SIZE_GROUP = "PixelSizeGroup";
+   private static final int MAX_REPORTED_ERRORS = 50;
 
    public boolean creatingNew_ = false;
 
@@ -133,6 +146,7 @@ public final class MicroscopeModel {
       Device coreDev = new Device(MMCoreJ.getG_Keyword_CoreDevice(), "Default",
             "MMCore", "Core controller");
       devices_.add(coreDev);
+      deviceIndex_.put(coreDev.getName(), coreDev);
       addMissingProperties();
       addSystemConfigs();
    }
@@ -245,11 +259,10 @@ public final class MicroscopeModel {
          }
 
          // re-assign remaining available devices
-         availableDevices_ = new Device[devsTotal.size()];
-         for (int i = 0; i < devsTotal.size(); i++) {
-            availableDevices_[i] = devsTotal.get(i);
-            if (availableDevices_[i].isHub()) {
-               hubs.add(availableDevices_[i]);
+         availableDevices_ = devsTotal.toArray(new Device[devsTotal.size()]);
+         for (Device dev : availableDevices_) {
+            if (dev.isHub()) {
+               hubs.add(dev);
             }
          }
          availableHubs_ = new Device[hubs.size()];
@@ -546,203 +559,27 @@ public final class MicroscopeModel {
          throw new MMConfigFileException("Configuration file does not exist.");
       }
 
-      boolean initialized = false;
-
+      List<ConfigFileError> errors = new ArrayList<>();
       try {
-         // read metadata from file
-         BufferedReader input = null;
-         input = new BufferedReader(new FileReader(configFile));
-         String line = null;
-         while ((line = input.readLine()) != null) {
-            String[] tokens = line.split(",");
-            if (tokens.length == 0 || tokens[0].startsWith("#")) {
+         ConfigFileAst ast = ConfigFileParser.parse(configFile);
+         errors.addAll(ast.getErrors());
+         Set<Integer> invalidLines = new HashSet<>();
+         for (ConfigFileError error : ast.getErrors()) {
+            invalidLines.add(error.getLine());
+         }
+         for (ConfigFileAst.Line line : ast.getLines()) {
+            if (line.getCommand() == null || invalidLines.contains(line.getNumber())) {
                continue;
-
-               // ReportingUtils.logMessage(line);
-
             }
-            if (tokens[0].contentEquals(new StringBuffer().append(MMCoreJ
-                  .getG_CFGCommand_Device()))) {
-               // -------------------------------------------------------------
-               // "Device" command
-               // -------------------------------------------------------------
-               if (tokens.length != 4) {
-                  throw new MMConfigFileException(
-                        "Invalid number of parameters (4 required):\n" + line);
-
-               }
-               Device dev = new Device(tokens[1], tokens[2], tokens[3],
-                     getDeviceDescription(tokens[2], tokens[3]));
-               // ReportingUtils.logMessage("Adding: " + tokens[1] + "," +
-               // tokens[2] + "," + tokens[3]);
-               // get description
-               devices_.add(dev);
-            } else if (tokens[0].contentEquals(new StringBuffer()
-                  .append(MMCoreJ.getG_CFGCommand_Property()))) {
-
-               // -------------------------------------------------------------
-               // "PropertyItem" command
-               // -------------------------------------------------------------
-               if (!(tokens.length == 4 || tokens.length == 3)) {
-                  throw new MMConfigFileException(
-                        "Invalid number of parameters (4 required):\n" + line);
-
-               }
-               if (tokens.length == 3) {
-                  // resize tokens array to 4 elements
-                  String[] extTokens = new String[4];
-                  for (int i = 0; i < 3; i++) {
-                     extTokens[i] = tokens[i];
-
-                  }
-                  extTokens[3] = "";
-                  tokens = extTokens;
-               }
-
-               if (tokens[1].contentEquals(new StringBuffer().append(MMCoreJ
-                     .getG_Keyword_CoreDevice()))) {
-
-                  // core device processing
-                  // ----------------------
-                  if (tokens[2].contentEquals(new StringBuffer().append(MMCoreJ
-                        .getG_Keyword_CoreInitialize()))) {
-                     initialized = !tokens[3]
-                           .contentEquals(new StringBuffer().append("0"));
-                  } else {
-                     PropertyItem prop = new PropertyItem();
-                     prop.name = tokens[2];
-                     prop.value = tokens[3];
-                     addSetupProperty(tokens[1], prop);
-                  }
-
-               } else {
-                  PropertyItem prop = new PropertyItem();
-                  prop.preInit = !initialized;
-                  prop.name = tokens[2];
-                  prop.value = tokens[3];
-                  addSetupProperty(tokens[1], prop);
-               }
-            } else if (tokens[0].contentEquals(new StringBuffer()
-                  .append(MMCoreJ.getG_CFGCommand_Label()))) {
-               // -------------------------------------------------------------
-               // "Label" command
-               // -------------------------------------------------------------
-               if (tokens.length != 4) {
-                  throw new MMConfigFileException(
-                        "Invalid number of parameters (4 required):\n" + line);
-
-               }
-               Label lab = new Label(tokens[3], Integer.parseInt(tokens[2]));
-               addSetupLabel(tokens[1], lab);
-            } else if (tokens[0].contentEquals(new StringBuffer()
-                  .append(MMCoreJ.getG_CFGCommand_ImageSynchro()))) {
-               // -------------------------------------------------------------
-               // "ImageSynchro" commands
-               // -------------------------------------------------------------
-               if (tokens.length != 2) {
-                  throw new MMConfigFileException(
-                        "Invalid number of parameters (2 required):\n" + line);
-
-               }
-               synchroDevices_.add(tokens[1]);
-            } else if (tokens[0].contentEquals(new StringBuffer()
-                  .append(MMCoreJ.getG_CFGCommand_ConfigGroup()))) {
-               // -------------------------------------------------------------
-               // "ConfigGroup" commands
-               // -------------------------------------------------------------
-               if (!(tokens.length == 6 || tokens.length == 5)) {
-                  throw new MMConfigFileException(
-                        "Invalid number of parameters (6 required):\n" + line);
-
-               }
-               addConfigGroup(tokens[1]);
-               ConfigGroup cg = findConfigGroup(tokens[1]);
-               if (tokens.length == 6) {
-                  cg.addConfigSetting(tokens[2], tokens[3], tokens[4],
-                        tokens[5]);
-
-               } else {
-                  cg.addConfigSetting(tokens[2], tokens[3], tokens[4], "");
-
-               }
-            } else if (tokens[0].contentEquals(new StringBuffer()
-                  .append(MMCoreJ.getG_CFGCommand_ConfigPixelSize()))) {
-               // -------------------------------------------------------------
-               // "ConfigPixelSize" commands
-               // -------------------------------------------------------------
-               if (!(tokens.length == 5)) {
-                  throw new MMConfigFileException(
-                        "Invalid number of parameters (5 required):\n" + line);
-
-               }
-               pixelSizeGroup_.addConfigSetting(tokens[1], tokens[2],
-                     tokens[3], tokens[4]);
-
-            } else if (tokens[0].contentEquals(new StringBuffer()
-                  .append(MMCoreJ.getG_CFGCommand_PixelSize_um()))) {
-               // -------------------------------------------------------------
-               // "PixelSize" commands
-               // -------------------------------------------------------------
-               if (tokens.length == 3) {
-                  ConfigPreset cp = pixelSizeGroup_.findConfigPreset(tokens[1]);
-                  if (cp != null) {
-                     cp.setPixelSizeUm(Double.parseDouble(tokens[2]));
-                  }
-               }
-            } else if (tokens[0].contentEquals(new StringBuffer()
-                  .append(MMCoreJ.getG_CFGCommand_PixelSizeAffine()))) {
-               if (tokens.length == 8) {
-                  ConfigPreset cp = pixelSizeGroup_.findConfigPreset(tokens[1]);
-                  if (cp != null) {
-                     DoubleVector aft = new DoubleVector(6);
-                     for (int i = 0; i < 6; i++) {
-                        aft.set(i, Double.parseDouble(tokens[i + 2]));
-                     }
-                     cp.setAffineTransform(aft);
-                  } else {
-
-                     throw new MMConfigFileException(
-                           "Invalid number of parameters (3 or 8 required):\n" + line);
-                  }
-               }
-            } else if (tokens[0].contentEquals(new StringBuffer()
-                  .append(MMCoreJ.getG_CFGCommand_Delay()))) {
-               // -------------------------------------------------------------
-               // "Delay" commands
-               // -------------------------------------------------------------
-               if (tokens.length != 3) {
-                  throw new MMConfigFileException(
-                        "Invalid number of parameters (3 required):\n" + line);
-
-               }
-               Device dev = findDevice(tokens[1]);
-               if (dev != null) {
-                  dev.setDelay(Double.parseDouble(tokens[2]));
-
-               }
-            } else if (tokens[0].equals(MMCoreJ.getG_CFGCommand_FocusDirection())) {
-               if (tokens.length != 3) {
-                  throw new MMConfigFileException(
-                        "Invalid number of parameters (3 required):\n" + line);
-               }
-               Device dev = findDevice(tokens[1]);
-               if (dev != null) {
-                  dev.setFocusDirection(Integer.parseInt(tokens[2]));
-                  //Set type manually or else focus direction wont get resaved
-                  dev.setTypeByInt(DeviceType.StageDevice.swigValue());
-               }
-            } else if (tokens[0].contentEquals(
-                  new StringBuffer().append(MMCoreJ.getG_CFGCommand_ParentID()))) {
-               if (tokens.length != 3) {
-                  throw new MMConfigFileException(
-                        "Invalid number of parameters (3 required):\n" + line);
-               }
-               Device dev = findDevice(tokens[1]);
-               if (dev != null) {
-                  dev.setParentHub(tokens[2]);
-               }
+            try {
+               applyCommand(line, errors);
+            } catch (MMConfigFileException e) {
+               errors.add(new ConfigFileError(line.getNumber(), line.column(1),
+                     e.getMessage()));
             }
-
+         }
+         if (errors.isEmpty()) {
+            configFileAst_ = ast;
          }
       } catch (IOException e) {
          reset();
@@ -763,6 +600,104 @@ public final class MicroscopeModel {
             }
          }
       }
+      if (!errors.isEmpty()) {
+         throw new MMConfigFileException(ConfigFileError.format(errors, MAX_REPORTED_ERRORS));
+      }
+   }
+
+   /**
+    * Applies one syntactically valid command of a configuration file to the
+    * model. Problems that do not prevent reading the rest of the file are
+    * added to errors.
+    */
+   private void applyCommand(ConfigFileAst.Line line, List<ConfigFileError> errors)
+         throws MMConfigFileException {
+      switch (line.getCommand()) {
+         case DEVICE: {
+            Device dev = new Device(line.token(1), line.token(2), line.token(3),
+                  getDeviceDescription(line.token(2), line.token(3)));
+            devices_.add(dev);
+            deviceIndex_.put(dev.getName(), dev);
+            break;
+         }
+         case PROPERTY: {
+            if (line.isInitialize()) {
+               break;
+            }
+            PropertyItem prop = new PropertyItem();
+            // core properties are never pre-init
+            prop.preInit = line.isPreInit()
+                  && !line.token(1).equals(MMCoreJ.getG_Keyword_CoreDevice());
+            prop.name = line.token(2);
+            prop.value = line.token(3);
+            addSetupProperty(line.token(1), prop);
+            break;
+         }
+         case LABEL:
+            addSetupLabel(line.token(1),
+                  new Label(line.token(3), Integer.parseInt(line.token(2))));
+            break;
+         case IMAGE_SYNCHRO:
+            synchroDevices_.add(line.token(1));
+            break;
+         case CONFIG_GROUP: {
+            addConfigGroup(line.token(1));
+            ConfigGroup cg = findConfigGroup(line.token(1));
+            cg.addConfigSetting(line.token(2), line.token(3), line.token(4),
+                  line.token(5));
+            break;
+         }
+         case CONFIG_PIXEL_SIZE:
+            pixelSizeGroup_.addConfigSetting(line.token(1), line.token(2),
+                  line.token(3), line.token(4));
+            break;
+         case PIXEL_SIZE_UM: {
+            ConfigPreset cp = pixelSizeGroup_.findConfigPreset(line.token(1));
+            if (cp != null) {
+               cp.setPixelSizeUm(Double.parseDouble(line.token(2)));
+            }
+            break;
+         }
+         case PIXEL_SIZE_AFFINE: {
+            ConfigPreset cp = pixelSizeGroup_.findConfigPreset(line.token(1));
+            if (cp == null) {
+               errors.add(new ConfigFileError(line.getNumber(), line.column(1),
+                     "Pixel size preset " + line.token(1) + " not defined."));
+               break;
+            }
+            DoubleVector aft = new DoubleVector(6);
+            for (int i = 0; i < 6; i++) {
+               aft.set(i, Double.parseDouble(line.token(i + 2)));
+            }
+            cp.setAffineTransform(aft);
+            break;
+         }
+         case DELAY: {
+            Device dev = findDevice(line.token(1));
+            if (dev != null) {
+               dev.setDelay(Double.parseDouble(line.token(2)));
+            }
+            break;
+         }
+         case FOCUS_DIRECTION: {
+            Device dev = findDevice(line.token(1));
+            if (dev != null) {
+               dev.setFocusDirection(Integer.parseInt(line.token(2)));
+               //Set type manually or else focus direction wont get resaved
+               dev.setTypeByInt(DeviceType.StageDevice.swigValue());
+            }
+            break;
+         }
+         case PARENT: {
+            Device dev = findDevice(line.token(1));
+            if (dev != null) {
+               dev.setParentHub(line.token(2));
+            }
+            break;
+         }
+         default:
+            break;
+      }
    }
 
    public String getDeviceDescription(String library, String adapter) {
@@ -775,26 +710,28 @@ public final class MicroscopeModel {
    }
 
    private Device findAvailableDevice(String library, String adapter) {
-      for (Device device : availableDevices_) {
-         if (device.getLibrary().compareTo(library) == 0
-               && device.getAdapterName().compareTo(adapter) == 0) {
-            return device;
-
-         }
-
-      }
-      return null;
+      updateAvailableDeviceIndex();
+      return availableDeviceIndex_.get(library + "\u0000" + adapter);
    }
 
    private boolean isLibraryAvailable(String library) {
-      for (Device device : availableDevices_) {
-         if (device.getLibrary().compareTo(library) == 0) {
-            return true;
-
-         }
+      updateAvailableDeviceIndex();
+      return availableLibraries_.contains(library);
+   }
 
+   private void updateAvailableDeviceIndex() {
+      if (indexedAvailableDevices_ == availableDevices_) {
+         return;
       }
-      return false;
+      availableDeviceIndex_.clear();
+      availableLibraries_.clear();
+      for (Device device : availableDevices_) {
+         // the first match wins, as in the linear search this replaces
+         availableDeviceIndex_.putIfAbsent(
+               device.getLibrary() + "\u0000" + device.getAdapterName(), device);
+         availableLibraries_.add(device.getLibrary());
+      }
+      indexedAvailableDevices_ = availableDevices_;
    }
 
    private void addMissingProperties() {
@@ -850,9 +787,40 @@ public final class MicroscopeModel {
       }
    }
 
+   /**
+    * Saves the model. If the model was loaded from a file, comments, line
+    * order and unknown commands of that file are preserved, and only the
+    * lines that changed are updated.
+    *
+    * @param path file to write
+    * @throws MMConfigFileException if the file can not be written
+    */
    public void saveToFile(String path) throws MMConfigFileException {
+      String text = generateConfigText();
+      if (configFileAst_ != null) {
+         text = configFileAst_.merge(ConfigFileParser.parse(text));
+      }
+      try (BufferedWriter out = new BufferedWriter(new FileWriter(path))) {
+         out.write(text);
+      } catch (IOException e) {
+         throw new MMConfigFileException(e);
+      }
+      configFileAst_ = ConfigFileParser.parse(text);
+      fileName_ = path;
+      modified_ = false;
+   }
+
+   /**
+    * Writes the model in configuration file format, ignoring the file it
+    * was loaded from.
+    *
+    * @return contents of the configuration file
+    * @throws MMConfigFileException never in practice, writing to memory
+    */
+   String generateConfigText() throws MMConfigFileException {
+      StringWriter text = new StringWriter();
       try {
-         BufferedWriter out = new BufferedWriter(new FileWriter(path));
+         BufferedWriter out = new BufferedWriter(text);
 
          out.write("# Generated by Configurator on "
                + GregorianCalendar.getInstance().getTime());
@@ -1089,8 +1057,7 @@ public final class MicroscopeModel {
       } catch (IOException e) {
          throw new MMConfigFileException(e);
       }
-      fileName_ = path;
-      modified_ = false;
+      return text.toString();
    }
 
    /**
@@ -1184,12 +1151,15 @@ public final class MicroscopeModel {
 
    public void reset() {
       devices_.clear();
+      deviceIndex_.clear();
+      configFileAst_ = null;
       configGroups_.clear();
       synchroDevices_.clear();
       pixelSizeGroup_.clear();
       Device coreDev = new Device(MMCoreJ.getG_Keyword_CoreDevice(), "Default",
             "MMCore", "Core controller");
       devices_.add(coreDev);
+      deviceIndex_.put(coreDev.getName(), coreDev);
       addMissingProperties();
       addSystemConfigs();
       modified_ = true;
@@ -1257,6 +1227,7 @@ public final class MicroscopeModel {
 
          // remove device
          devices_.remove(dev);
+         deviceIndex_.remove(dev.getName());
 
          // if there is a port, check if it is in use by other devices
          if (!(port.length() == 0)) {
@@ -1277,15 +1248,31 @@ public final class MicroscopeModel {
    }
 
    Device findDevice(String devName) {
-      for (Device dev : devices_) {
-         if (dev.getName().contentEquals(new StringBuffer().append(devName))) {
-            return dev;
-
+      Device dev = deviceIndex_.get(devName);
+      if (dev != null && dev.getName().equals(devName)) {
+         return dev;
+      }
+      // The index is stale when a device was renamed (Device.setName) or
+      // added behind our back, so fall back to a scan of all devices
+      for (Device device : devices_) {
+         if (device.getName().equals(devName)) {
+            rebuildDeviceIndex();
+            return device;
          }
       }
+      if (dev != null) {
+         rebuildDeviceIndex();
+      }
       return null;
    }
 
+   private void rebuildDeviceIndex() {
+      deviceIndex_.clear();
+      for (Device dev : devices_) {
+         deviceIndex_.putIfAbsent(dev.getName(), dev);
+      }
+   }
+
    boolean hasAdapterName(String library, String adapterName) {
       for (Device dev : devices_) {
          if (dev.getAdapterName().contentEquals(adapterName)
@@ -1363,6 +1350,7 @@ public final class MicroscopeModel {
 
       }
       devices_.add(dev);
+      deviceIndex_.put(dev.getName(), dev);
       modified_ = true;
    }
 
@@ -1375,6 +1363,8 @@ public final class MicroscopeModel {
 
       }
       dev.setName(newName);
+      deviceIndex_.remove(oldName);
+      deviceIndex_.put(newName, dev);
       modified_ = true;
    }
 
@@ -90,6 +90,11 @@ public final class FileMenu {
             () -> studio_.displays().promptToCloseWindows());
       closeAllItem.setEnabled(enableCloseAll_);
 
+      Datastore album = studio_.album().getDatastore();
+      JMenuItem keepAlbumItem = GUIUtils.addMenuItem(
+            fileMenu, "Keep Album as Dataset", null, this::keepAlbum);
+      keepAlbumItem.setEnabled(album != null && !album.isFrozen());
+
 
       fileMenu.addSeparator();
 
@@ -126,6 +131,22 @@ public final class FileMenu {
    }
 
 
+   /**
+    * Makes the temporary dataset of the album permanent, so that the album
+    * does not need to be saved again.
+    */
+   private void keepAlbum() {
+      new Thread(() -> {
+         try {
+            String path = studio_.album().promoteToDataset();
+            updateFileHistory(path);
+            studio_.logs().showMessage("The album was kept as dataset " + path);
+         } catch (IOException ioe) {
+            studio_.logs().showError(ioe, "Unable to keep the album");
+         }
+      }).start();
+   }
+
    private void openSciFIO() {
       File file = FileDialogs.openFile(null,
             "Please select an image data set", FileDialogs.SCIFIO_DATA);
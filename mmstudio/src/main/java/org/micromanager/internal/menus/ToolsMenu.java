@@ -50,10 +50,8 @@ public final class ToolsMenu {
       JMenu toolsMenu = GUIUtils.createMenuInMenuBar(menuBar, "Tools");
 
       GUIUtils.addMenuItem(toolsMenu, "Refresh GUI",
-            "Refresh all GUI controls directly from the hardware", () -> {
-               core_.updateSystemStateCache();
-               mmStudio_.uiManager().updateGUI(true);
-            },
+            "Refresh all GUI controls directly from the hardware",
+            () -> mmStudio_.uiManager().updateGUI(true),
             "arrow_refresh.png");
 
       toolsMenu.addSeparator();
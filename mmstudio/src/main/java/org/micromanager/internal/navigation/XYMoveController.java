@@ -0,0 +1,327 @@
+package org.micromanager.internal.navigation;
+
+import java.awt.geom.Point2D;
+import java.util.concurrent.Executor;
+import org.micromanager.internal.utils.ReportingUtils;
+
+/**
+ * Moves one XY stage to targets that accumulate relative moves, as they
+ * come in from the mouse or keyboard.
+ *
+ * <p>Moves requested while the stage is moving are coalesced into a single
+ * absolute target. Stages that accept a new target while moving are sent
+ * the next target right away; others get it once they stopped. The
+ * position is read back at most once per readback interval while moving,
+ * and once after the stage stopped.
+ *
+ * <p>The latency and speed of the stage are estimated from the durations
+ * of completed moves, to estimate its position between readbacks.
+ */
+final class XYMoveController {
+   /**
+    * The stage, as used by the controller; separated out for testing.
+    */
+   interface Stage {
+      void setXYPosition(double x, double y) throws Exception;
+
+      boolean isBusy() throws Exception;
+
+      Point2D.Double getXYPosition() throws Exception;
+   }
+
+   /**
+    * Receives positions read back from the stage.
+    */
+   interface Listener {
+      void positionRead(double x, double y);
+   }
+
+   // Assumed until moves have been observed
+   static final double DEFAULT_LATENCY_MS = 20.0;
+   static final double DEFAULT_SPEED_UM_PER_MS = 5.0;
+
+   private final Stage stage_;
+   private final Executor executor_;
+   private final Listener listener_;
+   private final boolean retarget_;
+   private final long busyPollMs_;
+   private final long readbackIntervalNs_;
+   private final long timeoutNs_;
+   private final MotionModel model_ = new MotionModel();
+
+   // Guarded by this
+   private boolean running_ = false;
+   private Point2D.Double target_;
+   private double pendingX_ = 0.0;
+   private double pendingY_ = 0.0;
+   private Motion motion_;
+
+   /**
+    * @param stage the stage to move
+    * @param executor runs the moves; should be single threaded
+    * @param listener receives positions read from the stage
+    * @param retarget whether the stage accepts a new target while moving
+    * @param busyPollMs interval at which the stage is asked whether it is
+    *                   still moving; each query may go out over a serial port
+    * @param readbackIntervalMs minimum time between readbacks while moving
+    * @param timeoutMs time after which a move that has not ended is an error
+    */
+   XYMoveController(Stage stage, Executor executor, Listener listener,
+                    boolean retarget, long busyPollMs, long readbackIntervalMs,
+                    long timeoutMs) {
+      stage_ = stage;
+      executor_ = executor;
+      listener_ = listener;
+      retarget_ = retarget;
+      busyPollMs_ = Math.max(1, busyPollMs);
+      readbackIntervalNs_ = readbackIntervalMs * 1000000L;
+      timeoutNs_ = timeoutMs * 1000000L;
+   }
+
+   /**
+    * Adds a relative move to the target, and starts moving unless the stage
+    * is being moved already.
+    *
+    * @param xRel relative movement in X in microns
+    * @param yRel relative movement in Y in microns
+    */
+   synchronized void moveRelative(double xRel, double yRel) {
+      pendingX_ += xRel;
+      pendingY_ += yRel;
+      if (!running_) {
+         running_ = true;
+         executor_.execute(this::run);
+      }
+   }
+
+   /**
+    * Returns the estimated position of the stage, or null when it has not
+    * been moved through this controller.
+    */
+   synchronized Point2D.Double getEstimatedPosition() {
+      return motion_ == null ? null : motion_.positionAt(System.nanoTime());
+   }
+
+   /**
+    * Returns whether moves are being made, or are about to be.
+    */
+   synchronized boolean isMoving() {
+      return running_;
+   }
+
+   /**
+    * Returns the estimated latency, including settling, in milliseconds.
+    */
+   double getLatencyMs() {
+      return model_.getLatencyMs();
+   }
+
+   double getSpeedUmPerMs() {
+      return model_.getSpeedUmPerMs();
+   }
+
+   int getMoveCount() {
+      return model_.getCount();
+   }
+
+   // Takes the next target, or returns null (and stops running) if there is
+   // none; the stage position is read when starting from an unknown target
+   private Point2D.Double nextTarget() throws Exception {
+      synchronized (this) {
+         if (target_ != null) {
+            if (pendingX_ == 0.0 && pendingY_ == 0.0) {
+               return null;
+            }
+            return takePending();
+         }
+      }
+      Point2D.Double position = stage_.getXYPosition();
+      synchronized (this) {
+         target_ = position;
+         motion_ = new Motion(position, position, System.nanoTime(), 0.0, 1.0);
+         return takePending();
+      }
+   }
+
+   private Point2D.Double takePending() {
+      target_ = new Point2D.Double(target_.x + pendingX_, target_.y + pendingY_);
+      pendingX_ = 0.0;
+      pendingY_ = 0.0;
+      return target_;
+   }
+
+   private synchronized boolean hasPending() {
+      return pendingX_ != 0.0 || pendingY_ != 0.0;
+   }
+
+   private void run() {
+      try {
+         boolean moved = false;
+         while (true) {
+            Point2D.Double target = nextTarget();
+            if (target == null) {
+               synchronized (this) {
+                  if (!hasPending()) {
+                     // The next burst starts from a fresh readback, in case
+                     // the stage was moved otherwise in the meantime
+                     target_ = null;
+                     running_ = false;
+                     break;
+                  }
+               }
+               continue;
+            }
+            move(target);
+            moved = true;
+         }
+         if (moved) {
+            readBack();
+         }
+      } catch (Exception ex) {
+         synchronized (this) {
+            target_ = null;
+            pendingX_ = 0.0;
+            pendingY_ = 0.0;
+            running_ = false;
+         }
+         ReportingUtils.showError(ex.getMessage());
+      }
+   }
+
+   private void move(Point2D.Double target) throws Exception {
+      long start = System.nanoTime();
+      Point2D.Double from;
+      synchronized (this) {
+         from = motion_.positionAt(start);
+      }
+      double distance = Math.max(Math.abs(target.x - from.x), Math.abs(target.y - from.y));
+      stage_.setXYPosition(target.x, target.y);
+      synchronized (this) {
+         motion_ = new Motion(from, target, start, model_.getLatencyMs(),
+               model_.getSpeedUmPerMs());
+      }
+      long lastReadback = start;
+      while (stage_.isBusy()) {
+         long now = System.nanoTime();
+         if (retarget_ && hasPending()) {
+            // Not measured, as the move did not end
+            return;
+         }
+         if (now - start > timeoutNs_) {
+            throw new Exception("Timed out waiting for XY stage to stop moving");
+         }
+         if (now - lastReadback >= readbackIntervalNs_) {
+            Point2D.Double position = stage_.getXYPosition();
+            lastReadback = System.nanoTime();
+            synchronized (this) {
+               motion_ = motion_.from(position, lastReadback);
+            }
+            listener_.positionRead(position.x, position.y);
+         }
+         Thread.sleep(busyPollMs_);
+      }
+      model_.observe(distance, (System.nanoTime() - start) / 1e6);
+   }
+
+   private void readBack() throws Exception {
+      Point2D.Double position = stage_.getXYPosition();
+      synchronized (this) {
+         // Moves may have been requested after the stage stopped
+         if (target_ == null) {
+            motion_ = new Motion(position, position, System.nanoTime(), 0.0, 1.0);
+         }
+      }
+      listener_.positionRead(position.x, position.y);
+   }
+
+   /**
+    * A move in a straight line, at constant speed once the latency passed.
+    * Distances are the larger of the X and Y distance, as both axes move at
+    * the same time on most stages.
+    */
+   static final class Motion {
+      private final Point2D.Double from_;
+      private final Point2D.Double to_;
+      private final long startNs_;
+      private final double latencyMs_;
+      private final double speedUmPerMs_;
+
+      Motion(Point2D.Double from, Point2D.Double to, long startNs,
+             double latencyMs, double speedUmPerMs) {
+         from_ = from;
+         to_ = to;
+         startNs_ = startNs;
+         latencyMs_ = latencyMs;
+         speedUmPerMs_ = speedUmPerMs;
+      }
+
+      Point2D.Double positionAt(long nanos) {
+         double distance = Math.max(Math.abs(to_.x - from_.x), Math.abs(to_.y - from_.y));
+         double moved = ((nanos - startNs_) / 1e6 - latencyMs_) * speedUmPerMs_;
+         if (moved <= 0.0) {
+            return new Point2D.Double(from_.x, from_.y);
+         }
+         if (moved >= distance) {
+            return new Point2D.Double(to_.x, to_.y);
+         }
+         double f = moved / distance;
+         return new Point2D.Double(from_.x + f * (to_.x - from_.x),
+               from_.y + f * (to_.y - from_.y));
+      }
+
+      /**
+       * Returns the rest of this move, from a position read while moving.
+       */
+      Motion from(Point2D.Double position, long nanos) {
+         return new Motion(position, to_, nanos, 0.0, speedUmPerMs_);
+      }
+   }
+
+   /**
+    * Fits duration = latency + distance / speed to completed moves, by least
+    * squares with exponentially decaying weights, so that the estimate
+    * follows changes in stage settings.
+    */
+   static final class MotionModel {
+      private static final double DECAY = 0.9;
+      // Guarded by this
+      private double sumW_ = 0.0;
+      private double sumD_ = 0.0;
+      private double sumT_ = 0.0;
+      private double sumDD_ = 0.0;
+      private double sumDT_ = 0.0;
+      private int count_ = 0;
+      private double latencyMs_ = DEFAULT_LATENCY_MS;
+      private double speedUmPerMs_ = DEFAULT_SPEED_UM_PER_MS;
+
+      synchronized void observe(double distanceUm, double durationMs) {
+         sumW_ = DECAY * sumW_ + 1.0;
+         sumD_ = DECAY * sumD_ + distanceUm;
+         sumT_ = DECAY * sumT_ + durationMs;
+         sumDD_ = DECAY * sumDD_ + distanceUm * distanceUm;
+         sumDT_ = DECAY * sumDT_ + distanceUm * durationMs;
+         count_++;
+         double meanD = sumD_ / sumW_;
+         double meanT = sumT_ / sumW_;
+         double varD = sumDD_ / sumW_ - meanD * meanD;
+         double covDT = sumDT_ / sumW_ - meanD * meanT;
+         // The speed can only be fitted from moves of different lengths
+         if (varD > 1e-6 * (1.0 + meanD * meanD) && covDT > 0.0) {
+            speedUmPerMs_ = varD / covDT;
+         }
+         latencyMs_ = Math.max(0.0, meanT - meanD / speedUmPerMs_);
+      }
+
+      synchronized double getLatencyMs() {
+         return latencyMs_;
+      }
+
+      synchronized double getSpeedUmPerMs() {
+         return speedUmPerMs_;
+      }
+
+      synchronized int getCount() {
+         return count_;
+      }
+   }
+}
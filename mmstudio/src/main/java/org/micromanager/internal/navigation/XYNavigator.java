@@ -1,13 +1,10 @@
 package org.micromanager.internal.navigation;
 
-import com.google.common.util.concurrent.AtomicDouble;
 import java.awt.geom.AffineTransform;
 import java.awt.geom.Point2D;
 import java.util.HashMap;
 import java.util.Map;
-import java.util.concurrent.ExecutorService;
 import java.util.concurrent.Executors;
-import java.util.concurrent.Future;
 import javax.swing.JOptionPane;
 import mmcorej.MMCoreJ;
 import org.micromanager.Studio;
@@ -15,6 +12,7 @@ import org.micromanager.events.internal.DefaultXYStagePositionChangedEvent;
 import org.micromanager.internal.utils.AffineUtils;
 import org.micromanager.internal.utils.ReportingUtils;
 import org.micromanager.internal.utils.ThreadFactoryFactory;
+import org.micromanager.propertymap.MutablePropertyMapView;
 
 /**
  * Class that handles transformation between what the user sees on the screen
@@ -23,13 +21,22 @@ import org.micromanager.internal.utils.ThreadFactoryFactory;
  * @author Nico
  */
 public class XYNavigator {
+   // Profile key, followed by the stage label, for stages that accept a new
+   // target while moving
+   private static final String RETARGET_KEY_PREFIX = "retarget-";
+   // Profile key, followed by the stage label, for the interval at which the
+   // stage is asked whether it is still moving
+   private static final String BUSY_POLL_KEY_PREFIX = "busyPollMs-";
+   private static final long DEFAULT_BUSY_POLL_MS = 10;
+   private static final long READBACK_INTERVAL_MS = 100;
+
    protected Studio studio_;
    protected boolean mirrorX_;
    protected boolean mirrorY_;
    protected boolean transposeXY_;
    protected boolean correction_;
    protected AffineTransform affineTransform_;
-   private final Map<String, XYStageTask> xyStageMoverMap_;
+   private final Map<String, XYMoveController> xyStageMoverMap_;
 
    /**
     * Central interface to move the default XY stage in the direction
@@ -214,75 +221,84 @@ public class XYNavigator {
 
    /**
     * Moves the XYStage the desired distance in microns without corrections
-    * Creates an XYStageTask if the stage is unknown, otherwise
-    * adds the desired movement to the task.  If a task is still running,
-    * it will add the movement to its future movement task.
+    * Creates an XYMoveController if the stage is unknown, otherwise
+    * adds the desired movement to its target.  If the stage is still moving,
+    * the movement is combined with other requests into the next move.
     *
     * @param xyStage xyStage to be moved
     * @param xRel    x distance (in microns) to move the stage
     * @param yRel    y distance (in microns) to move the stage
     */
    public void moveXYStageUm(String xyStage, double xRel, double yRel) {
-      if (!xyStageMoverMap_.containsKey(xyStage)) {
-         xyStageMoverMap_.put(xyStage, new XYStageTask(xyStage));
-      }
-      // if a
-      xyStageMoverMap_.get(xyStage).setPosition(xRel, yRel);
+      getController(xyStage).moveRelative(xRel, yRel);
    }
 
    /**
-    * Helper class that executes stage movement, and pools movement requests
-    * if they come in while the stage is busy.
+    * Returns the position of the XY stage as estimated from the moves made
+    * through this navigator, for display while the stage is moving.
     *
-    * <p>This should reduce the number of commands send to the stage when the UI
-    * is firing requests faster than the stage can execute them.
+    * @param xyStage xyStage of interest
+    * @return estimated position in microns, or null if the stage is not
+    *     being moved by this navigator
     */
-   private class XYStageTask implements Runnable {
+   public Point2D getEstimatedXYPosition(String xyStage) {
+      XYMoveController controller;
+      synchronized (xyStageMoverMap_) {
+         controller = xyStageMoverMap_.get(xyStage);
+      }
+      if (controller == null || !controller.isMoving()) {
+         return null;
+      }
+      return controller.getEstimatedPosition();
+   }
+
+   private XYMoveController getController(final String xyStage) {
+      synchronized (xyStageMoverMap_) {
+         XYMoveController controller = xyStageMoverMap_.get(xyStage);
+         if (controller == null) {
+            MutablePropertyMapView settings = studio_.profile().getSettings(XYNavigator.class);
+            boolean retarget = settings.getBoolean(RETARGET_KEY_PREFIX + xyStage, false);
+            long busyPollMs = settings.getLong(BUSY_POLL_KEY_PREFIX + xyStage,
+                  DEFAULT_BUSY_POLL_MS);
+            controller = new XYMoveController(new CoreStage(xyStage),
+                  Executors.newSingleThreadExecutor(
+                        ThreadFactoryFactory.createThreadFactory("XYNavigator-" + xyStage)),
+                  (x, y) -> studio_.events().post(
+                        new DefaultXYStagePositionChangedEvent(xyStage, x, y)),
+                  retarget, busyPollMs, READBACK_INTERVAL_MS,
+                  studio_.core().getTimeoutMs());
+            xyStageMoverMap_.put(xyStage, controller);
+         }
+         return controller;
+      }
+   }
+
+   /**
+    * Moves an XY stage through the core.
+    */
+   private class CoreStage implements XYMoveController.Stage {
       private final String xyStage_;
-      private final ExecutorService executorService_;
-      private Future<?> future_;
-      AtomicDouble moveMemoryX_ = new AtomicDouble(0.0);
-      AtomicDouble moveMemoryY_ = new AtomicDouble(0.0);
 
-      public XYStageTask(String xyStage) {
+      CoreStage(String xyStage) {
          xyStage_ = xyStage;
-         executorService_ = Executors.newSingleThreadExecutor(
-               ThreadFactoryFactory.createThreadFactory("XYNavigator-" + xyStage));
       }
 
-      /**
-       * Sets the position of the XY stage. Uses the executorService to schedule the actual
-       * move of the hardware.
-       *
-       * @param xRel - relative movement in X in microns
-       * @param yRel - relative movement in Y in microns
-       */
-      public void setPosition(double xRel, double yRel) {
-         moveMemoryX_.addAndGet(xRel);
-         moveMemoryY_.addAndGet(yRel);
-         if (future_ == null || future_.isDone()) {
-            future_ = executorService_.submit(this);
-         }
+      @Override
+      public void setXYPosition(double x, double y) throws Exception {
+         studio_.core().setXYPosition(xyStage_, x, y);
       }
 
       @Override
-      public void run() {
-         // Move the stage
-         try {
-            while (moveMemoryX_.get() != 0 || moveMemoryY_.get() != 0.0) {
-               double xRel = moveMemoryX_.getAndSet(0.0);
-               double yRel = moveMemoryY_.getAndSet(0.0);
-               studio_.core().setRelativeXYPosition(xyStage_, xRel, yRel);
-               studio_.core().waitForDevice(xyStage_);
-               double[] xs = new double[1];
-               double[] ys = new double[1];
-               studio_.core().getXYPosition(xyStage_, xs, ys);
-               studio_.events().post(
-                     new DefaultXYStagePositionChangedEvent(xyStage_, xs[0], ys[0]));
-            }
-         } catch (Exception ex) {
-            ReportingUtils.showError(ex.getMessage());
-         }
+      public boolean isBusy() throws Exception {
+         return studio_.core().deviceBusy(xyStage_);
+      }
+
+      @Override
+      public Point2D.Double getXYPosition() throws Exception {
+         double[] xs = new double[1];
+         double[] ys = new double[1];
+         studio_.core().getXYPosition(xyStage_, xs, ys);
+         return new Point2D.Double(xs[0], ys[0]);
       }
    }
 
@@ -41,9 +41,12 @@ import org.micromanager.MultiStagePosition;
 import org.micromanager.PositionList;
 import org.micromanager.StagePosition;
 import org.micromanager.Studio;
+import org.micromanager.display.DisplayWindow;
 import org.micromanager.events.PixelSizeChangedEvent;
 import org.micromanager.events.ShutdownCommencingEvent;
 import org.micromanager.internal.positionlist.utils.TileCreator;
+import org.micromanager.internal.positionlist.utils.TileGrid;
+import org.micromanager.internal.positionlist.utils.TileOrder;
 import org.micromanager.internal.positionlist.utils.ZGenerator;
 import org.micromanager.internal.utils.NumberUtils;
 import org.micromanager.internal.utils.ReportingUtils;
@@ -72,10 +75,14 @@ public final class TileCreatorDlg extends JDialog {
    private final JLabel labelWidth_ = new JLabel();
    private final JLabel labelWidthUmPx_ = new JLabel();
    private static int numericPrefix_ = 0;
+   private final TileGridOverlay preview_ = new TileGridOverlay();
+   private DisplayWindow previewDisplay_;
+   private TileOrder tileOrder_;
 
    private static final String OVERLAP_PREF = "overlap";
    private static final String PREFIX_PREF = "prefix";
    private static final String GRID_SELECTED = "grid_selected";
+   private static final String ORDER_PREF = "order";
 
    /**
     * Create the dialog.
@@ -110,7 +117,7 @@ public final class TileCreatorDlg extends JDialog {
             getClass().getResource("/org/micromanager/icons/microscope.gif")));
       super.setLocation(300, 300);
       WindowPositioning.setUpLocationMemory(this, this.getClass(), null);
-      super.setSize(344, 280);
+      super.setSize(344, 305);
 
       final JButton goToLeftButton = new JButton();
       goToLeftButton.setFont(plainFont10);
@@ -273,6 +280,7 @@ public final class TileCreatorDlg extends JDialog {
             component.setEnabled(true);
          }
          settings.putBoolean(GRID_SELECTED, true);
+         updatePreview();
       });
       gridButton.setSelected(settings.getBoolean(GRID_SELECTED, true));
       super.getContentPane().add(gridButton);
@@ -285,6 +293,7 @@ public final class TileCreatorDlg extends JDialog {
             component.setEnabled(false);
          }
          settings.putBoolean(GRID_SELECTED, false);
+         updatePreview();
       });
       lineButton.setSelected(!settings.getBoolean(GRID_SELECTED, false));
       super.getContentPane().add(lineButton);
@@ -351,6 +360,26 @@ public final class TileCreatorDlg extends JDialog {
       prefixField.setText(settings.getString(PREFIX_PREF, "Pos"));
       super.getContentPane().add(prefixField);
 
+      final JLabel orderLabel = new JLabel();
+      orderLabel.setFont(plainFont10);
+      orderLabel.setText("Order");
+      orderLabel.setBounds(5, 219, 40, 14);
+      super.getContentPane().add(orderLabel);
+
+      tileOrder_ = settings.getStringAsEnum(ORDER_PREF, TileOrder.Type.class,
+            TileOrder.Type.SNAKE);
+      JComboBox<TileOrder.Type> orderCombo = new JComboBox<>(TileOrder.Type.values());
+      orderCombo.setSelectedItem(tileOrder_);
+      orderCombo.setFont(plainFont10);
+      orderCombo.addActionListener(arg0 -> {
+         TileOrder.Type order = (TileOrder.Type) orderCombo.getSelectedItem();
+         settings.putEnumAsString(ORDER_PREF, order);
+         tileOrder_ = order;
+         updatePreview();
+      });
+      orderCombo.setBounds(45, 216, 85, 20);
+      super.getContentPane().add(orderCombo);
+
       final JButton okButton = new JButton();
       okButton.setFont(plainFont10);
       okButton.setText("OK");
@@ -359,11 +388,11 @@ public final class TileCreatorDlg extends JDialog {
          settings.putString(PREFIX_PREF, prefixField.getText());
          addToPositionList();
       });
-      okButton.setBounds(20, 216, 93, 23);
+      okButton.setBounds(20, 244, 93, 23);
       super.getContentPane().add(okButton);
 
       final JButton cancelButton = new JButton();
-      cancelButton.setBounds(129, 216, 93, 23);
+      cancelButton.setBounds(129, 244, 93, 23);
       cancelButton.setFont(plainFont10);
       cancelButton.addActionListener(arg0 -> dispose());
       cancelButton.setText("Cancel");
@@ -371,19 +400,26 @@ public final class TileCreatorDlg extends JDialog {
       super.getContentPane().add(cancelButton);
 
       final JButton resetButton = new JButton();
-      resetButton.setBounds(234, 216, 93, 23);
+      resetButton.setBounds(234, 244, 93, 23);
       resetButton.setFont(plainFont10);
       resetButton.addActionListener(arg0 -> reset());
       resetButton.setText("Reset");
       super.getContentPane().add(resetButton);
 
       studio.events().registerForEvents(this);
+      updatePreview();
    }
 
    @Override
    public void dispose() {
       studio_.profile().getSettings(TileCreatorDlg.class).putString(
             OVERLAP_PREF, overlapField_.getText());
+      if (previewDisplay_ != null) {
+         if (!previewDisplay_.isClosed()) {
+            previewDisplay_.removeOverlay(preview_);
+         }
+         previewDisplay_ = null;
+      }
       positionListDlg_.activateAxisTable(true);
       super.dispose();
    }
@@ -437,6 +473,7 @@ public final class TileCreatorDlg extends JDialog {
 
       endPosition_[location] = msp;
       endPositionSet_[location] = true;
+      updatePreview();
 
       return msp;
 
@@ -471,6 +508,63 @@ public final class TileCreatorDlg extends JDialog {
       } catch (TileCreatorException tex) {
          // most likely zero pixel size no need to update
       }
+      updatePreview();
+   }
+
+   /**
+    * Shows the grid that would be created on the live view. Only the grid is
+    * computed, not the positions, and the overlay is only redrawn, so this is
+    * cheap enough to do on every change of the input.
+    */
+   private void updatePreview() {
+      DisplayWindow display = studio_.live().getDisplay();
+      if (display != previewDisplay_) {
+         if (previewDisplay_ != null && !previewDisplay_.isClosed()) {
+            previewDisplay_.removeOverlay(preview_);
+         }
+         previewDisplay_ = display;
+         if (display != null) {
+            display.addOverlay(preview_);
+         }
+      }
+      TileGrid grid = null;
+      String xyStage = positionListDlg_.get2DAxis();
+      boolean gridSelected = studio_.profile().getSettings(TileCreatorDlg.class)
+            .getBoolean(GRID_SELECTED, true);
+      if (display != null && xyStage != null && gridSelected) {
+         MultiStagePosition[] endPoints = getEndPoints();
+         double pixelSizeUm = 0.0;
+         try {
+            pixelSizeUm = NumberUtils.displayStringToDouble(pixelSizeField_.getText());
+         } catch (ParseException e) {
+            // no preview until the pixel size is valid
+         }
+         if (endPoints.length >= 2 && pixelSizeUm > 0.0) {
+            try {
+               grid = tileCreator_.createGrid(getOverlap(), overlapUnit_, endPoints,
+                     pixelSizeUm, xyStage, tileOrder_);
+            } catch (IllegalArgumentException iae) {
+               // incomplete or invalid input, nothing to show
+            }
+         }
+      }
+      if (grid != preview_.getGrid()) {
+         preview_.setGrid(grid);
+      }
+   }
+
+   /**
+    * Returns the corners that were set.
+    */
+   private MultiStagePosition[] getEndPoints() {
+      final PositionList endPoints = new PositionList();
+      for (MultiStagePosition multiStagePosition : endPosition_) {
+         // We don't want to send null positions to the tile creator.
+         if (multiStagePosition != null) {
+            endPoints.addPosition(multiStagePosition);
+         }
+      }
+      return endPoints.getPositions();
    }
 
    /**
@@ -589,6 +683,7 @@ public final class TileCreatorDlg extends JDialog {
                throw new IllegalStateException("Unexpected value: " + location);
          }
       }
+      updatePreview();
    }
 
    private double getPixelSizeUm() throws TileCreatorDlg.TileCreatorException {
@@ -643,15 +738,9 @@ public final class TileCreatorDlg extends JDialog {
       final PositionList endPoints = new PositionList();
       String prefix = settings.getString(PREFIX_PREF, "Pos");
       if (settings.getBoolean(GRID_SELECTED, true)) {
-         for (MultiStagePosition multiStagePosition : endPosition_) {
-            // We don't want to send null positions to the tile creator.
-            if (multiStagePosition != null) {
-               endPoints.addPosition(multiStagePosition);
-            }
-         }
          posList = tileCreator_.createTiles(overlap, overlapUnit_,
-               endPoints.getPositions(), pixelSizeUm, prefix + "-" + numericPrefix_,
-               xyStage, zStages, ZGenerator.Type.SHEPINTERPOLATE);
+               getEndPoints(), pixelSizeUm, prefix + "-" + numericPrefix_,
+               xyStage, zStages, ZGenerator.Type.SHEPINTERPOLATE, tileOrder_);
       } else {
          if (endPosition_[1] == null || endPosition_[3] == null) {
             studio_.logs().showError("Please set the left and right positions", this);
@@ -693,6 +782,7 @@ public final class TileCreatorDlg extends JDialog {
       double pxsz = core_.getPixelSizeUm();
       pixelSizeField_.setText(NumberUtils.doubleToDisplayString(pxsz));
       centeredFrames_ = 0;
+      updatePreview();
    }
 
    /**
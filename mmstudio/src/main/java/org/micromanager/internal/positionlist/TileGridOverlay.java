@@ -0,0 +1,187 @@
+///////////////////////////////////////////////////////////////////////////////
+//PROJECT:       Micro-Manager
+//SUBSYSTEM:     mmstudio
+//-----------------------------------------------------------------------------
+//
+// COPYRIGHT:    University of California, San Francisco, 2024
+//
+// LICENSE:      This file is distributed under the BSD license.
+//               License text is included with the source distribution.
+//
+//               This file is distributed in the hope that it will be useful,
+//               but WITHOUT ANY WARRANTY; without even the implied warranty
+//               of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//               IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//               CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//               INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+//
+
+
+package org.micromanager.internal.positionlist;
+
+import java.awt.BasicStroke;
+import java.awt.Color;
+import java.awt.Graphics2D;
+import java.awt.Rectangle;
+import java.awt.geom.AffineTransform;
+import java.awt.geom.Line2D;
+import java.awt.geom.NoninvertibleTransformException;
+import java.awt.geom.Point2D;
+import java.awt.geom.Rectangle2D;
+import java.util.List;
+import org.micromanager.data.Image;
+import org.micromanager.data.Metadata;
+import org.micromanager.display.DisplaySettings;
+import org.micromanager.display.overlay.AbstractOverlay;
+import org.micromanager.internal.positionlist.utils.TileGrid;
+
+/**
+ * Draws the outlines of the tiles of a TileGrid, and the path between them,
+ * on top of an image. Tiles are placed relative to the stage position and
+ * pixel size of the image, so the preview follows the stage.
+ *
+ * <p>Only the tiles within view are drawn; when there are too many of those
+ * to be distinguishable, only the outline of the grid is drawn.
+ */
+public final class TileGridOverlay extends AbstractOverlay {
+   private static final int MAX_DRAWN_TILES = 2500;
+   private static final Color TILE_COLOR = new Color(255, 200, 0, 160);
+   private static final Color PATH_COLOR = new Color(0, 200, 255, 160);
+   private static final Color FIRST_TILE_COLOR = new Color(0, 255, 0, 200);
+
+   private TileGrid grid_;
+
+   @Override
+   public String getTitle() {
+      return "Tile Grid Preview";
+   }
+
+   /**
+    * Sets the grid to be drawn, and redraws.
+    *
+    * @param grid grid to be drawn, or null to draw nothing
+    */
+   public void setGrid(TileGrid grid) {
+      grid_ = grid;
+      fireOverlayConfigurationChanged();
+   }
+
+   public TileGrid getGrid() {
+      return grid_;
+   }
+
+   @Override
+   public void paintOverlay(Graphics2D g, Rectangle screenRect,
+                            DisplaySettings displaySettings,
+                            List<Image> images, Image primaryImage,
+                            Rectangle2D.Float imageViewPort) {
+      final TileGrid grid = grid_;
+      if (grid == null || primaryImage == null) {
+         return;
+      }
+      AffineTransform stageToScreen = stageToScreen(primaryImage, screenRect, imageViewPort);
+      if (stageToScreen == null) {
+         return;
+      }
+      AffineTransform screenToStage;
+      try {
+         screenToStage = stageToScreen.createInverse();
+      } catch (NoninvertibleTransformException e) {
+         return;
+      }
+
+      // Part of the stage that is in view
+      Rectangle2D view = screenToStage.createTransformedShape(
+            new Rectangle(0, 0, screenRect.width, screenRect.height)).getBounds2D();
+      final double halfX = grid.getImageSizeXUm() / 2;
+      final double halfY = grid.getImageSizeYUm() / 2;
+      int minCol = (int) Math.max(0, Math.floor((view.getMinX() - halfX
+            - grid.getOriginXUm()) / grid.getTileSizeXUm()));
+      int maxCol = (int) Math.min(grid.getNrX() - 1, Math.ceil((view.getMaxX() + halfX
+            - grid.getOriginXUm()) / grid.getTileSizeXUm()));
+      int minRow = (int) Math.max(0, Math.floor((view.getMinY() - halfY
+            - grid.getOriginYUm()) / grid.getTileSizeYUm()));
+      int maxRow = (int) Math.min(grid.getNrY() - 1, Math.ceil((view.getMaxY() + halfY
+            - grid.getOriginYUm()) / grid.getTileSizeYUm()));
+      if (minCol > maxCol || minRow > maxRow) {
+         return;
+      }
+
+      Graphics2D g2 = (Graphics2D) g.create();
+      g2.setStroke(new BasicStroke(1.0f));
+      if ((long) (maxCol - minCol + 1) * (maxRow - minRow + 1) > MAX_DRAWN_TILES) {
+         g2.setColor(TILE_COLOR);
+         g2.draw(stageToScreen.createTransformedShape(new Rectangle2D.Double(
+               grid.getOriginXUm() - halfX, grid.getOriginYUm() - halfY,
+               (grid.getNrX() - 1) * grid.getTileSizeXUm() + grid.getImageSizeXUm(),
+               (grid.getNrY() - 1) * grid.getTileSizeYUm() + grid.getImageSizeYUm())));
+         g2.dispose();
+         return;
+      }
+
+      final int last = grid.size() - 1;
+      Point2D.Double from = new Point2D.Double();
+      Point2D.Double to = new Point2D.Double();
+      for (int row = minRow; row <= maxRow; row++) {
+         for (int col = minCol; col <= maxCol; col++) {
+            final int i = grid.getVisitIndex(col, row);
+            g2.setColor(i == 0 ? FIRST_TILE_COLOR : TILE_COLOR);
+            g2.draw(stageToScreen.createTransformedShape(new Rectangle2D.Double(
+                  grid.getX(i) - halfX, grid.getY(i) - halfY,
+                  grid.getImageSizeXUm(), grid.getImageSizeYUm())));
+            if (i < last) {
+               from.setLocation(grid.getX(i), grid.getY(i));
+               to.setLocation(grid.getX(i + 1), grid.getY(i + 1));
+               stageToScreen.transform(from, from);
+               stageToScreen.transform(to, to);
+               g2.setColor(PATH_COLOR);
+               g2.draw(new Line2D.Double(from, to));
+            }
+         }
+      }
+      g2.dispose();
+   }
+
+   /**
+    * Returns the transform from stage coordinates (microns) to screen
+    * coordinates, assuming the center of the image is at the stage position
+    * recorded in its metadata. Returns null if the image lacks the metadata
+    * needed.
+    */
+   private static AffineTransform stageToScreen(Image image, Rectangle screenRect,
+                                                Rectangle2D.Float imageViewPort) {
+      Metadata metadata = image.getMetadata();
+      Double xUm = metadata.getXPositionUm();
+      Double yUm = metadata.getYPositionUm();
+      if (xUm == null || yUm == null) {
+         return null;
+      }
+      AffineTransform pixelToStage = metadata.getPixelSizeAffine();
+      if (pixelToStage == null || pixelToStage.getDeterminant() == 0.0) {
+         Double pixelSizeUm = metadata.getPixelSizeUm();
+         if (pixelSizeUm == null || pixelSizeUm <= 0.0) {
+            return null;
+         }
+         pixelToStage = AffineTransform.getScaleInstance(pixelSizeUm, pixelSizeUm);
+      }
+      AffineTransform stageToPixel;
+      try {
+         // Only the linear part matters; offsets are relative to the image center
+         stageToPixel = new AffineTransform(pixelToStage.getScaleX(),
+               pixelToStage.getShearY(), pixelToStage.getShearX(),
+               pixelToStage.getScaleY(), 0.0, 0.0).createInverse();
+      } catch (NoninvertibleTransformException e) {
+         return null;
+      }
+
+      final double zoomRatio = imageViewPort.width / screenRect.width;
+      AffineTransform result = AffineTransform.getScaleInstance(
+            1.0 / zoomRatio, 1.0 / zoomRatio);
+      result.translate(-imageViewPort.x, -imageViewPort.y);
+      result.translate(image.getWidth() / 2.0, image.getHeight() / 2.0);
+      result.concatenate(stageToPixel);
+      result.translate(-xUm, -yUm);
+      return result;
+   }
+}
@@ -42,6 +42,7 @@ import org.micromanager.internal.utils.ReportingUtils;
 public final class TileCreator {
    private final CMMCore core_;
    private final Component dialog_;
+   private TileGrid lastGrid_;
 
    /**
     * Units used for the overlap.
@@ -75,20 +76,37 @@ public final class TileCreator {
                                    MultiStagePosition[] endPoints, double pixelSizeUm,
                                    String labelPrefix, String xyStage, StrVector zStages,
                                    ZGenerator.Type zType) {
-      // Make sure at least two corners were set
-      if (endPoints.length < 2) {
-         ReportingUtils.showError("At least two corners should be set", dialog_);
+      return createTiles(overlap, overlapUnit, endPoints, pixelSizeUm, labelPrefix,
+            xyStage, zStages, zType, TileOrder.Type.SNAKE);
+   }
+
+   /**
+    * Create the tile list based on user input, pixelsize, and imagesize,
+    * visiting the tiles in the given order.
+    *
+    * @param overlap Overlap desired by user.  This may be increased, but not decreased.
+    * @param overlapUnit Units used to specify desired overlap
+    * @param endPoints Array of MultiStagePositions (should be size 2-4) with corners.
+    * @param pixelSizeUm Pixel Size of the camera in Microns at the image plane.
+    * @param labelPrefix Label Prefix to be used for naming the positions.
+    * @param xyStage Name of the xyStage that will be used.
+    * @param zStages Name of the xStage that will be used (optional).
+    * @param zType ZGenerator to be used if we do Z positions.
+    * @param order Order in which the tiles will be visited.
+    * @return PositionList with annotated MultiStagePositions, or null if the
+    *          input was invalid.
+    */
+   public PositionList createTiles(double overlap, OverlapUnitEnum overlapUnit,
+                                   MultiStagePosition[] endPoints, double pixelSizeUm,
+                                   String labelPrefix, String xyStage, StrVector zStages,
+                                   ZGenerator.Type zType, TileOrder order) {
+      TileGrid grid;
+      try {
+         grid = createGrid(overlap, overlapUnit, endPoints, pixelSizeUm, xyStage, order);
+      } catch (IllegalArgumentException iae) {
+         ReportingUtils.showError(iae.getMessage(), dialog_);
          return null;
       }
-      //Make sure all Points have the same stage
-      for (int i = 1; i < endPoints.length; i++) {
-         if (!xyStage.equals(endPoints[i].getDefaultXYStage())) {
-            ReportingUtils
-                  .showError("All positions given to TileCreator must use the same xy stage",
-                          dialog_);
-            return null;
-         }
-      }
 
       ZGenerator zGen = null;
       if (zStages == null) {
@@ -107,109 +125,137 @@ public final class TileCreator {
                break;
          }
       }
+      String[] zStageNames = new String[(int) zStages.size()];
+      double[][] z = new double[zStageNames.length][];
+      for (int a = 0; a < zStageNames.length; a++) {
+         zStageNames[a] = zStages.get(a);
+         z[a] = grid.computeZ(zGen, zStageNames[a]);
+      }
 
+      PositionList posList = new PositionList();
+      posList.setPositions(createPositions(grid, overlapUnit, pixelSizeUm, labelPrefix,
+            xyStage, zStageNames, z));
+      return posList;
+   }
+
+   /**
+    * Computes the tile grid for the given user input, without creating any
+    * MultiStagePositions. This is cheap enough to be called whenever the input
+    * changes, e.g. to preview the grid. When the input results in the same
+    * grid as the previous call, that grid is returned again.
+    *
+    * @param overlap Overlap desired by user.  This may be increased, but not decreased.
+    * @param overlapUnit Units used to specify desired overlap
+    * @param endPoints Array of MultiStagePositions (should be size 2-4) with corners.
+    * @param pixelSizeUm Pixel Size of the camera in Microns at the image plane.
+    * @param xyStage Name of the xyStage that will be used.
+    * @param order Order in which the tiles will be visited.
+    * @return The tile grid
+    * @throws IllegalArgumentException if the input does not define a grid
+    */
+   public TileGrid createGrid(double overlap, OverlapUnitEnum overlapUnit,
+                              MultiStagePosition[] endPoints, double pixelSizeUm,
+                              String xyStage, TileOrder order) {
+      // Make sure at least two corners were set
+      if (endPoints.length < 2) {
+         throw new IllegalArgumentException("At least two corners should be set");
+      }
+      //Make sure all Points have the same stage
+      for (int i = 1; i < endPoints.length; i++) {
+         if (!xyStage.equals(endPoints[i].getDefaultXYStage())) {
+            throw new IllegalArgumentException(
+                  "All positions given to TileCreator must use the same xy stage");
+         }
+      }
 
       // Calculate a bounding rectangle around the defaultXYStage positions
       // TODO: develop method to deal with multiple axis
       StagePosition[] coords = boundingBox(endPoints, xyStage);
-      double maxX = coords[1].get2DPositionX();
-      double minX = coords[0].get2DPositionX();
-      double maxY = coords[1].get2DPositionY();
-      double minY = coords[0].get2DPositionY();
-
-      double[] ans = getImageSize(pixelSizeUm);
-      double imageSizeXUm = ans[0];
-      double imageSizeYUm = ans[1];
-
-      ans = getTileSize(overlap, overlapUnit, pixelSizeUm);
-      double tileSizeXUm = ans[0];
-      double tileSizeYUm = ans[1];
-
-      double overlapXUm = imageSizeXUm - tileSizeXUm;
-      double overlapYUm = imageSizeYUm - tileSizeYUm;
-
-      // bounding box size accounting for the fact that the edges of the image extend
-      // past the max/min values set.
-      double boundingXUm = maxX - minX + imageSizeXUm;
-      double boundingYUm = maxY - minY + imageSizeYUm;
-
-      // calculate number of images in X and Y
-      int nrImagesX = (int) Math.ceil((boundingXUm - overlapXUm) / tileSizeXUm);
-      int nrImagesY = (int) Math.ceil((boundingYUm - overlapYUm) / tileSizeYUm);
-
-      if (nrImagesX < 1 || nrImagesY < 1) {
-         ReportingUtils.showError("Zero or negative number of images requested. "
-               + "Is the overlap larger than the Image Width or Height?", dialog_);
-         return null;
+      double[] imageSize = getImageSize(pixelSizeUm);
+      double[] tileSize = getTileSize(overlap, overlapUnit, pixelSizeUm);
+      final double minX = coords[0].get2DPositionX();
+      final double minY = coords[0].get2DPositionY();
+      final double maxX = coords[1].get2DPositionX();
+      final double maxY = coords[1].get2DPositionY();
+      TileGrid grid = lastGrid_;
+      if (grid == null || !grid.isCreatedFrom(minX, minY, maxX, maxY,
+            imageSize[0], imageSize[1], tileSize[0], tileSize[1], order)) {
+         grid = TileGrid.create(minX, minY, maxX, maxY,
+               imageSize[0], imageSize[1], tileSize[0], tileSize[1], order);
+         lastGrid_ = grid;
       }
+      return grid;
+   }
 
-      double totalSizeXUm = nrImagesX * tileSizeXUm + overlapXUm;
-      double totalSizeYUm = nrImagesY * tileSizeYUm + overlapYUm;
+   /**
+    * Turns a tile grid into annotated MultiStagePositions, in visiting order.
+    * Positions are independent of each other, so large grids are converted
+    * in parallel.
+    */
+   static MultiStagePosition[] createPositions(TileGrid grid, OverlapUnitEnum overlapUnit,
+                                               double pixelSizeUm, String labelPrefix,
+                                               String xyStage, String[] zStages,
+                                               double[][] z) {
+      final double overlapXUm = grid.getOverlapXUm();
+      final double overlapYUm = grid.getOverlapYUm();
+      // The same for all tiles; formatted once, since the formatters are not thread safe
+      final String[] properties;
+      if (overlapUnit == OverlapUnitEnum.UM || overlapUnit == OverlapUnitEnum.PX) {
+         int overlapPix = (int) Math.floor(overlapXUm / pixelSizeUm);
+         properties = new String[] {
+               "OverlapUm", NumberUtils.doubleToCoreString(overlapXUm),
+               "OverlapPixels", NumberUtils.intToCoreString(overlapPix)};
+      } else { // overlapUnit_ == OverlapUnit.PERCENT
+         // overlapUmX != overlapUmY; store both
+         int overlapPixX = (int) Math.floor(overlapXUm / pixelSizeUm);
+         int overlapPixY = (int) Math.floor(overlapYUm / pixelSizeUm);
+         properties = new String[] {
+               "OverlapUmX", NumberUtils.doubleToCoreString(overlapXUm),
+               "OverlapUmY", NumberUtils.doubleToCoreString(overlapYUm),
+               "OverlapPixelsX", NumberUtils.intToCoreString(overlapPixX),
+               "OverlapPixelsY", NumberUtils.intToCoreString(overlapPixY)};
+      }
+      final MultiStagePosition[] positions = new MultiStagePosition[grid.size()];
+      TileGrid.indices(positions.length).forEach(i -> {
+         MultiStagePosition msp = new MultiStagePosition();
+         final int column = grid.getColumn(i);
+         final int row = grid.getRow(i);
 
-      // Since an evenly spaced grid will likely not perfectly fit the bounding box
-      // that was specified we use this offset so that our grid is still centered properly.
-      // This slightly widens the field that is scanned. Sometime this can result in setting
-      // a position that is outside of the stage's range of motion. This causes issues when
-      // it comes time to stitch.
-      // This approach could also result in damage if the user specified a region that is
-      // near something delicate and then this code expands that range. It may be good to
-      // try a different approach.
-      double offsetXUm = (totalSizeXUm - boundingXUm) / 2;
-      double offsetYUm = (totalSizeYUm - boundingYUm) / 2;
+         // Add XY position
+         // xyStage is not null; we've checked above.
+         msp.setDefaultXYStage(xyStage);
+         msp.add(StagePosition.create2D(xyStage, grid.getX(i), grid.getY(i)));
 
-      PositionList posList = new PositionList();
-      // todo handle mirrorX mirrorY
-      for (int y = 0; y < nrImagesY; y++) {
-         for (int x = 0; x < nrImagesX; x++) {
-            // on even rows go left to right, on odd rows right to left
-            int tmpX = x;
-            if ((y & 1) == 1) { //If y is odd then we will go backwards in x
-               tmpX = nrImagesX - x - 1;
-            }
-            MultiStagePosition msp = new MultiStagePosition();
-
-            // Add XY position
-            // xyStage is not null; we've checked above.
-            msp.setDefaultXYStage(xyStage);
-            double dx = minX - offsetXUm + (tmpX * tileSizeXUm);
-            double dy = minY - offsetYUm + (y * tileSizeYUm);
-            StagePosition spXY = StagePosition.create2D(xyStage, dx, dy);
-            msp.add(spXY);
-
-            // Add Z position
-            if (zGen != null) {
-               msp.setDefaultZStage(zStages.get(0));
-               //loop over Z coordinates and add the correct positions for any we are using
-               for (int a = 0; a < zStages.size(); a++) {
-                  StagePosition newSP = StagePosition.create1D(zStages.get(a),
-                        zGen.getZ(dx, dy, zStages.get(a)));
-                  msp.add(newSP);
-               }
+         // Add Z position
+         if (zStages.length > 0) {
+            msp.setDefaultZStage(zStages[0]);
+            //loop over Z coordinates and add the correct positions for any we are using
+            for (int a = 0; a < zStages.length; a++) {
+               msp.add(StagePosition.create1D(zStages[a], z[a][i]));
             }
+         }
 
-            // Add 'metadata'
-            msp.setLabel(labelPrefix + "-" + FMT_POS.format(tmpX) + "_" + FMT_POS.format(y));
-            msp.setGridCoordinates(y, tmpX);
-            msp.setProperty("Source", "TileCreator");
-
-            if (overlapUnit == OverlapUnitEnum.UM || overlapUnit == OverlapUnitEnum.PX) {
-               msp.setProperty("OverlapUm", NumberUtils.doubleToCoreString(overlapXUm));
-               int overlapPix = (int) Math.floor(overlapXUm / pixelSizeUm);
-
-               msp.setProperty("OverlapPixels", NumberUtils.intToCoreString(overlapPix));
-            } else { // overlapUnit_ == OverlapUnit.PERCENT
-               // overlapUmX != overlapUmY; store both
-               msp.setProperty("OverlapUmX", NumberUtils.doubleToCoreString(overlapXUm));
-               msp.setProperty("OverlapUmY", NumberUtils.doubleToCoreString(overlapYUm));
-               int overlapPixX = (int) Math.floor(overlapXUm / pixelSizeUm);
-               int overlapPixY = (int) Math.floor(overlapYUm / pixelSizeUm);
-               msp.setProperty("OverlapPixelsX", NumberUtils.intToCoreString(overlapPixX));
-               msp.setProperty("OverlapPixelsY", NumberUtils.intToCoreString(overlapPixY));
-            }
-            posList.addPosition(msp);
+         // Add 'metadata'
+         msp.setLabel(labelPrefix + "-" + formatPos(column) + "_" + formatPos(row));
+         msp.setGridCoordinates(row, column);
+         msp.setProperty("Source", "TileCreator");
+
+         for (int p = 0; p < properties.length; p += 2) {
+            msp.setProperty(properties[p], properties[p + 1]);
          }
+         positions[i] = msp;
+      });
+      return positions;
+   }
+
+   /**
+    * Same as FMT_POS.format(pos), but safe to use from several threads.
+    */
+   private static String formatPos(int pos) {
+      if (pos >= 100) {
+         return Integer.toString(pos);
       }
-      return posList;
+      return pos >= 10 ? "0" + pos : "00" + pos;
    }
 
    /**
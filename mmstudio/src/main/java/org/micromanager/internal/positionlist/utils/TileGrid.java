@@ -0,0 +1,285 @@
+///////////////////////////////////////////////////////////////////////////////
+//PROJECT:       Micro-Manager
+//SUBSYSTEM:     mmstudio
+//-----------------------------------------------------------------------------
+//
+// COPYRIGHT:    University of California, San Francisco, 2024
+//
+// LICENSE:      This file is distributed under the BSD license.
+//               License text is included with the source distribution.
+//
+//               This file is distributed in the hope that it will be useful,
+//               but WITHOUT ANY WARRANTY; without even the implied warranty
+//               of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//               IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//               CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//               INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+//
+
+
+package org.micromanager.internal.positionlist.utils;
+
+import java.util.stream.IntStream;
+
+/**
+ * Regular grid of tile positions, stored as parallel arrays rather than as
+ * MultiStagePositions, so that even very large grids are cheap to compute,
+ * to keep around and to draw.
+ *
+ * <p>Tiles are indexed in the order in which they are visited. Positions are
+ * the stage coordinates of the tile centers, in microns.
+ */
+public final class TileGrid {
+   // Below this many tiles, starting a parallel stream costs more than it saves
+   private static final int PARALLEL_THRESHOLD = 4096;
+
+   private final double[] bounds_;
+   private final TileOrder order_;
+   private final int nrX_;
+   private final int nrY_;
+   private final double originXUm_;
+   private final double originYUm_;
+   private final double imageSizeXUm_;
+   private final double imageSizeYUm_;
+   private final double tileSizeXUm_;
+   private final double tileSizeYUm_;
+   private final double[] x_;
+   private final double[] y_;
+   private final int[] column_;
+   private final int[] row_;
+   private final int[] visitIndex_;
+
+   private TileGrid(double[] bounds, int nrX, int nrY, double originXUm, double originYUm,
+                    double imageSizeXUm, double imageSizeYUm,
+                    double tileSizeXUm, double tileSizeYUm, TileOrder order) {
+      bounds_ = bounds;
+      order_ = order;
+      nrX_ = nrX;
+      nrY_ = nrY;
+      originXUm_ = originXUm;
+      originYUm_ = originYUm;
+      imageSizeXUm_ = imageSizeXUm;
+      imageSizeYUm_ = imageSizeYUm;
+      tileSizeXUm_ = tileSizeXUm;
+      tileSizeYUm_ = tileSizeYUm;
+
+      final int size = nrX * nrY;
+      final int[] gridIndices = order.order(nrX, nrY);
+      if (gridIndices.length != size) {
+         throw new IllegalArgumentException("Tile order does not match the grid size");
+      }
+      x_ = new double[size];
+      y_ = new double[size];
+      column_ = new int[size];
+      row_ = new int[size];
+      visitIndex_ = new int[size];
+      for (int i = 0; i < size; i++) {
+         visitIndex_[i] = -1;
+      }
+      indices(size).forEach(i -> {
+         final int gridIndex = gridIndices[i];
+         final int column = gridIndex % nrX;
+         final int row = gridIndex / nrX;
+         column_[i] = column;
+         row_[i] = row;
+         x_[i] = originXUm + column * tileSizeXUm;
+         y_[i] = originYUm + row * tileSizeYUm;
+         visitIndex_[gridIndex] = i;
+      });
+      for (int i = 0; i < size; i++) {
+         if (visitIndex_[i] < 0) {
+            throw new IllegalArgumentException("Tile order does not visit every tile once");
+         }
+      }
+   }
+
+   /**
+    * Computes the smallest grid with at least the requested overlap that
+    * covers a bounding box. The grid is centered on the bounding box, so it
+    * may extend a bit past it on all sides.
+    *
+    * @param minXUm Minimum X stage position to be imaged
+    * @param minYUm Minimum Y stage position to be imaged
+    * @param maxXUm Maximum X stage position to be imaged
+    * @param maxYUm Maximum Y stage position to be imaged
+    * @param imageSizeXUm Width of an image, in microns
+    * @param imageSizeYUm Height of an image, in microns
+    * @param tileSizeXUm Distance between neighboring tiles in X, i.e. the
+    *                    image width minus the overlap
+    * @param tileSizeYUm Distance between neighboring tiles in Y
+    * @param order Order in which the tiles are visited
+    * @return The grid
+    * @throws IllegalArgumentException when the overlap is not smaller than
+    *          the image, or the bounding box is empty
+    */
+   public static TileGrid create(double minXUm, double minYUm, double maxXUm, double maxYUm,
+                                 double imageSizeXUm, double imageSizeYUm,
+                                 double tileSizeXUm, double tileSizeYUm, TileOrder order) {
+      if (!(tileSizeXUm > 0.0) || !(tileSizeYUm > 0.0) || !(maxXUm >= minXUm)
+            || !(maxYUm >= minYUm)) {
+         throw new IllegalArgumentException("Zero or negative number of images requested. "
+               + "Is the overlap larger than the Image Width or Height?");
+      }
+      double overlapXUm = imageSizeXUm - tileSizeXUm;
+      double overlapYUm = imageSizeYUm - tileSizeYUm;
+
+      // bounding box size accounting for the fact that the edges of the image extend
+      // past the max/min values set.
+      double boundingXUm = maxXUm - minXUm + imageSizeXUm;
+      double boundingYUm = maxYUm - minYUm + imageSizeYUm;
+
+      // calculate number of images in X and Y
+      int nrImagesX = (int) Math.ceil((boundingXUm - overlapXUm) / tileSizeXUm);
+      int nrImagesY = (int) Math.ceil((boundingYUm - overlapYUm) / tileSizeYUm);
+      if (nrImagesX < 1 || nrImagesY < 1
+            || (long) nrImagesX * nrImagesY > Integer.MAX_VALUE - 8) {
+         throw new IllegalArgumentException("Unreasonable number of images requested: "
+               + nrImagesX + " x " + nrImagesY);
+      }
+
+      double totalSizeXUm = nrImagesX * tileSizeXUm + overlapXUm;
+      double totalSizeYUm = nrImagesY * tileSizeYUm + overlapYUm;
+
+      // Since an evenly spaced grid will likely not perfectly fit the bounding box
+      // that was specified we use this offset so that our grid is still centered properly.
+      // This slightly widens the field that is scanned.
+      double offsetXUm = (totalSizeXUm - boundingXUm) / 2;
+      double offsetYUm = (totalSizeYUm - boundingYUm) / 2;
+
+      return new TileGrid(new double[] {minXUm, minYUm, maxXUm, maxYUm},
+            nrImagesX, nrImagesY, minXUm - offsetXUm, minYUm - offsetYUm,
+            imageSizeXUm, imageSizeYUm, tileSizeXUm, tileSizeYUm, order);
+   }
+
+   /**
+    * Tells whether {@link #create} would return the same grid for the given
+    * parameters, so that callers can skip recomputing it.
+    *
+    * @return true if this grid was created from the same parameters
+    */
+   public boolean isCreatedFrom(double minXUm, double minYUm, double maxXUm, double maxYUm,
+                                double imageSizeXUm, double imageSizeYUm,
+                                double tileSizeXUm, double tileSizeYUm, TileOrder order) {
+      return bounds_[0] == minXUm && bounds_[1] == minYUm
+            && bounds_[2] == maxXUm && bounds_[3] == maxYUm
+            && imageSizeXUm_ == imageSizeXUm && imageSizeYUm_ == imageSizeYUm
+            && tileSizeXUm_ == tileSizeXUm && tileSizeYUm_ == tileSizeYUm
+            && order_ == order;
+   }
+
+   /**
+    * Returns a stream over [0, size), which is parallel when size is large.
+    */
+   static IntStream indices(int size) {
+      IntStream stream = IntStream.range(0, size);
+      return size >= PARALLEL_THRESHOLD ? stream.parallel() : stream;
+   }
+
+   /**
+    * Evaluates a ZGenerator at every tile. ZGenerators are immutable once
+    * created, so this is done in parallel for large grids.
+    *
+    * @param zGen ZGenerator to use
+    * @param zStage Name of the Z stage
+    * @return Z position of each tile, in visiting order
+    */
+   public double[] computeZ(ZGenerator zGen, String zStage) {
+      final double[] z = new double[size()];
+      indices(z.length).forEach(i -> z[i] = zGen.getZ(x_[i], y_[i], zStage));
+      return z;
+   }
+
+   public int size() {
+      return x_.length;
+   }
+
+   public int getNrX() {
+      return nrX_;
+   }
+
+   public int getNrY() {
+      return nrY_;
+   }
+
+   /**
+    * X stage position of the tile visited at the given index.
+    *
+    * @param i visit index
+    * @return position in microns
+    */
+   public double getX(int i) {
+      return x_[i];
+   }
+
+   /**
+    * Y stage position of the tile visited at the given index.
+    *
+    * @param i visit index
+    * @return position in microns
+    */
+   public double getY(int i) {
+      return y_[i];
+   }
+
+   public int getColumn(int i) {
+      return column_[i];
+   }
+
+   public int getRow(int i) {
+      return row_[i];
+   }
+
+   /**
+    * Returns when the tile in the given column and row is visited.
+    *
+    * @param column grid column
+    * @param row grid row
+    * @return visit index
+    */
+   public int getVisitIndex(int column, int row) {
+      return visitIndex_[row * nrX_ + column];
+   }
+
+   /**
+    * X stage position of the tiles in column 0.
+    *
+    * @return position in microns
+    */
+   public double getOriginXUm() {
+      return originXUm_;
+   }
+
+   /**
+    * Y stage position of the tiles in row 0.
+    *
+    * @return position in microns
+    */
+   public double getOriginYUm() {
+      return originYUm_;
+   }
+
+   public double getImageSizeXUm() {
+      return imageSizeXUm_;
+   }
+
+   public double getImageSizeYUm() {
+      return imageSizeYUm_;
+   }
+
+   public double getTileSizeXUm() {
+      return tileSizeXUm_;
+   }
+
+   public double getTileSizeYUm() {
+      return tileSizeYUm_;
+   }
+
+   public double getOverlapXUm() {
+      return imageSizeXUm_ - tileSizeXUm_;
+   }
+
+   public double getOverlapYUm() {
+      return imageSizeYUm_ - tileSizeYUm_;
+   }
+}
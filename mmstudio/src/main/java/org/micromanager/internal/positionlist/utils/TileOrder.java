@@ -0,0 +1,163 @@
+///////////////////////////////////////////////////////////////////////////////
+//PROJECT:       Micro-Manager
+//SUBSYSTEM:     mmstudio
+//-----------------------------------------------------------------------------
+//
+// COPYRIGHT:    University of California, San Francisco, 2024
+//
+// LICENSE:      This file is distributed under the BSD license.
+//               License text is included with the source distribution.
+//
+//               This file is distributed in the hope that it will be useful,
+//               but WITHOUT ANY WARRANTY; without even the implied warranty
+//               of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//               IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//               CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//               INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+//
+
+
+package org.micromanager.internal.positionlist.utils;
+
+/**
+ * Order in which the tiles of a grid are visited.
+ *
+ * <p>Tiles are identified by their grid index, {@code row * nrX + column}.
+ * Custom orders can be plugged into {@link TileCreator} by implementing this
+ * interface; the built-in orders are listed in {@link Type}.
+ */
+public interface TileOrder {
+
+   /**
+    * Built-in tile orders.
+    */
+   enum Type implements TileOrder {
+      /**
+       * Every row from left to right, rows from top to bottom.
+       */
+      RASTER("Raster") {
+         @Override
+         public int[] order(int nrX, int nrY) {
+            int[] order = new int[nrX * nrY];
+            for (int i = 0; i < order.length; i++) {
+               order[i] = i;
+            }
+            return order;
+         }
+      },
+      /**
+       * Even rows from left to right, odd rows from right to left, so that
+       * consecutive tiles are always neighbors.
+       */
+      SNAKE("Snake") {
+         @Override
+         public int[] order(int nrX, int nrY) {
+            int[] order = new int[nrX * nrY];
+            int i = 0;
+            for (int y = 0; y < nrY; y++) {
+               for (int x = 0; x < nrX; x++) {
+                  int column = (y & 1) == 1 ? nrX - x - 1 : x;
+                  order[i++] = y * nrX + column;
+               }
+            }
+            return order;
+         }
+      },
+      /**
+       * Generalized Hilbert curve, which works for any grid size. Tiles that
+       * are visited close together in time are also close together in space,
+       * and consecutive tiles are neighbors (diagonal neighbors in at most
+       * one place when the grid has an odd size).
+       */
+      HILBERT("Hilbert") {
+         @Override
+         public int[] order(int nrX, int nrY) {
+            int[] order = new int[nrX * nrY];
+            int[] count = new int[1];
+            if (nrX >= nrY) {
+               Type.hilbert(order, count, nrX, 0, 0, nrX, 0, 0, nrY);
+            } else {
+               Type.hilbert(order, count, nrX, 0, 0, 0, nrY, nrX, 0);
+            }
+            return order;
+         }
+      };
+
+      public final String description_;
+
+      Type(String description) {
+         description_ = description;
+      }
+
+      @Override
+      public String toString() {
+         return description_;
+      }
+
+      /**
+       * Fills the rectangle with corner (x, y), major axis (ax, ay) and minor
+       * axis (bx, by) by splitting it in two or three smaller rectangles,
+       * each of which is traversed in the same way.
+       */
+      private static void hilbert(int[] order, int[] count, int nrX,
+                                  int x, int y, int ax, int ay, int bx, int by) {
+         final int w = Math.abs(ax + ay);
+         final int h = Math.abs(bx + by);
+         final int dax = Integer.signum(ax);
+         final int day = Integer.signum(ay);
+         final int dbx = Integer.signum(bx);
+         final int dby = Integer.signum(by);
+         if (h == 1) {
+            for (int i = 0; i < w; i++) {
+               order[count[0]++] = y * nrX + x;
+               x += dax;
+               y += day;
+            }
+            return;
+         }
+         if (w == 1) {
+            for (int i = 0; i < h; i++) {
+               order[count[0]++] = y * nrX + x;
+               x += dbx;
+               y += dby;
+            }
+            return;
+         }
+         int ax2 = Math.floorDiv(ax, 2);
+         int ay2 = Math.floorDiv(ay, 2);
+         int bx2 = Math.floorDiv(bx, 2);
+         int by2 = Math.floorDiv(by, 2);
+         final int w2 = Math.abs(ax2 + ay2);
+         final int h2 = Math.abs(bx2 + by2);
+         if (2 * w > 3 * h) {
+            // long rectangle: split along the major axis only
+            if ((w2 & 1) == 1 && w > 2) {
+               ax2 += dax;
+               ay2 += day;
+            }
+            hilbert(order, count, nrX, x, y, ax2, ay2, bx, by);
+            hilbert(order, count, nrX, x + ax2, y + ay2, ax - ax2, ay - ay2, bx, by);
+         } else {
+            if ((h2 & 1) == 1 && h > 2) {
+               bx2 += dbx;
+               by2 += dby;
+            }
+            hilbert(order, count, nrX, x, y, bx2, by2, ax2, ay2);
+            hilbert(order, count, nrX, x + bx2, y + by2, ax, ay, bx - bx2, by - by2);
+            hilbert(order, count, nrX, x + (ax - dax) + (bx2 - dbx),
+                  y + (ay - day) + (by2 - dby), -bx2, -by2, -(ax - ax2), -(ay - ay2));
+         }
+      }
+   }
+
+   /**
+    * Returns the visiting order of a grid.
+    *
+    * @param nrX number of columns
+    * @param nrY number of rows
+    * @return array of length nrX * nrY, holding the grid index of each tile
+    *          in the order in which the tiles are visited
+    */
+   int[] order(int nrX, int nrY);
+}
@@ -81,30 +81,50 @@ public final class DefaultPropertyMap implements PropertyMap {
          return false;
       }
       for (String key : map_.keySet()) {
-         Object v1 = map_.get(key);
-         Object v2 = map2.get(key);
-         if (v1.equals(v2)) {
-            continue;
-         }
-         Class<?> cls = v1.getClass();
-         if (cls != v2.getClass() || !cls.isArray()) {
+         if (!valueEquals(map_.get(key), map2.get(key))) {
             return false;
          }
-         Class<?> ctype = cls.getComponentType();
-         if (!ctype.isPrimitive()) {
-            if (Arrays.equals((Object[]) v1, (Object[]) v2)) {
-               continue;
-            }
-            return false;
-         }
-         if (Primitive.valueOf(ctype).primitiveArrayEquals(v1, v2)) {
-            continue;
-         }
-         return false;
       }
       return true;
    }
 
+   // Not in API!
+   /**
+    * Tells whether two property maps hold the same value for a key, without
+    * converting the values.
+    *
+    * @param a first property map
+    * @param b second property map
+    * @param key key to compare
+    * @return true if the key is absent from both maps or has equal values
+    */
+   public static boolean valuesEqual(PropertyMap a, PropertyMap b, String key) {
+      if (!(a instanceof DefaultPropertyMap) || !(b instanceof DefaultPropertyMap)) {
+         throw new UnsupportedOperationException();
+      }
+      Object v1 = ((DefaultPropertyMap) a).map_.get(key);
+      Object v2 = ((DefaultPropertyMap) b).map_.get(key);
+      if (v1 == null || v2 == null) {
+         return v1 == v2;
+      }
+      return valueEquals(v1, v2);
+   }
+
+   private static boolean valueEquals(Object v1, Object v2) {
+      if (v1.equals(v2)) {
+         return true;
+      }
+      Class<?> cls = v1.getClass();
+      if (cls != v2.getClass() || !cls.isArray()) {
+         return false;
+      }
+      Class<?> ctype = cls.getComponentType();
+      if (!ctype.isPrimitive()) {
+         return Arrays.equals((Object[]) v1, (Object[]) v2);
+      }
+      return Primitive.valueOf(ctype).primitiveArrayEquals(v1, v2);
+   }
+
    @Override
    public int hashCode() {
       int hash = 5;
@@ -8,12 +8,18 @@ import org.micromanager.internal.utils.MMScriptException;
 
 /**
  * Executes Beanshell on user-supplied scripts.
+ *
+ * <p>Scripts run by evaluateAsync are run as {@link CompiledScript}s, which
+ * are parsed once and call a {@link ScriptProbe} before each statement. The
+ * probe stops the script at its next statement when a stop is requested,
+ * and profiles the lines of the script.
  */
 public final class BeanshellEngine implements ScriptingEngine {
    Interpreter interp_;
-   boolean running_ = false;
+   volatile boolean running_ = false;
    EvalThread evalThd_;
-   boolean stop_ = false;
+   volatile boolean stop_ = false;
+   private volatile ScriptProbe probe_;
    private final ScriptPanel panel_;
    private Interpreter interpOld_;
 
@@ -30,10 +36,15 @@ public final class BeanshellEngine implements ScriptingEngine {
 
       @Override
       public void run() {
-         stop_ = false;
          running_ = true;
          try {
-            interp_.eval(script_);
+            CompiledScript compiled = CompiledScript.compile(script_);
+            ScriptProbe probe = new ScriptProbe(compiled.getLineCount());
+            probe_ = probe;
+            if (stop_) {
+               probe.requestStop();
+            }
+            compiled.run(interp_, probe);
          } catch (TargetError e) {
             int lineNo = e.getErrorLineNumber();
             panel_.displayError(formatBeanshellError(e, lineNo), lineNo);
@@ -108,10 +119,17 @@ public final class BeanshellEngine implements ScriptingEngine {
          throw new MMScriptException("Another script execution in progress!");
       }
 
+      stop_ = false;
+      probe_ = null;
       evalThd_ = new EvalThread(script);
       evalThd_.start();
    }
 
+   @Override
+   public ScriptProbe getProfile() {
+      return probe_;
+   }
+
    @Override
    public void insertGlobalObject(String name, Object obj) throws MMScriptException {
       try {
@@ -125,12 +143,18 @@ public final class BeanshellEngine implements ScriptingEngine {
    @Override
    public void stopRequest(boolean shouldInterrupt) {
       if (evalThd_.isAlive()) {
+         // The script stops at its next statement; the thread is interrupted
+         // in case it waits, or killed if the script does not stop.
+         stop_ = true;
+         ScriptProbe probe = probe_;
+         if (probe != null) {
+            probe.requestStop();
+         }
          if (shouldInterrupt) {
             evalThd_.interrupt();
          } else {
             // HACK: kill the thread.
             evalThd_.stop();
-            stop_ = true;
          }
       }
    }
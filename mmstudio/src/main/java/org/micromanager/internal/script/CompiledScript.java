@@ -0,0 +1,245 @@
+package org.micromanager.internal.script;
+
+import bsh.CallStack;
+import bsh.EvalError;
+import bsh.Interpreter;
+import bsh.Parser;
+import bsh.SimpleNode;
+import bsh.Token;
+import bsh.TokenMgrError;
+import com.google.common.base.Charsets;
+import com.google.common.hash.Hashing;
+import java.io.StringReader;
+import java.util.ArrayList;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.TreeMap;
+import org.micromanager.internal.utils.ReportingUtils;
+
+/**
+ * A Beanshell script, parsed once and instrumented so that a
+ * {@link ScriptProbe} is called before each statement.
+ *
+ * <p>Beanshell has no hook that is called for each statement, so a call to
+ * the probe is inserted in the source text in front of the first statement
+ * on each line, in blocks and at the top level. The calls are inserted
+ * without line breaks, so that errors report the lines of the original
+ * script. Statements that are not in a block, such as the body of a loop
+ * without braces, are not instrumented.
+ *
+ * <p>Parsed scripts are cached by the hash of their text, as scripts are
+ * often run many times.
+ */
+final class CompiledScript {
+   // Name of the probe in the namespace of the interpreter
+   static final String PROBE_NAME = "__mmScriptProbe";
+   private static final String SOURCE_NAME = "script";
+   private static final int CACHE_SIZE = 32;
+   // Columns of the Beanshell parser count tabs to the next multiple of 8
+   private static final int TAB_SIZE = 8;
+
+   // Guarded by itself
+   private static final Map<String, CompiledScript> CACHE =
+         new LinkedHashMap<String, CompiledScript>(16, 0.75f, true) {
+            @Override
+            protected boolean removeEldestEntry(Map.Entry<String, CompiledScript> eldest) {
+               return size() > CACHE_SIZE;
+            }
+         };
+
+   private final List<SimpleNode> nodes_;
+   private final int lineCount_;
+   private final int probeCount_;
+
+   private CompiledScript(List<SimpleNode> nodes, int lineCount, int probeCount) {
+      nodes_ = nodes;
+      lineCount_ = lineCount;
+      probeCount_ = probeCount;
+   }
+
+   static String hash(String script) {
+      return Hashing.sha256().hashString(script, Charsets.UTF_8).toString();
+   }
+
+   /**
+    * Returns the parsed script, from the cache if it was parsed before.
+    *
+    * @throws EvalError if the script cannot be parsed
+    */
+   static CompiledScript compile(String script) throws EvalError {
+      String hash = hash(script);
+      synchronized (CACHE) {
+         CompiledScript compiled = CACHE.get(hash);
+         if (compiled != null) {
+            return compiled;
+         }
+      }
+      List<String> lines = splitLines(script);
+      Map<Integer, Integer> probes = new TreeMap<>();
+      List<SimpleNode> nodes = parse(script);
+      for (SimpleNode node : nodes) {
+         findStatements(node, true, lines, probes);
+      }
+      CompiledScript compiled;
+      try {
+         compiled = new CompiledScript(parse(instrument(lines, probes)),
+               lines.size(), probes.size());
+      } catch (EvalError e) {
+         // Should not happen; run the script without probes
+         ReportingUtils.logError(e, "Failed to instrument script");
+         compiled = new CompiledScript(nodes, lines.size(), 0);
+      }
+      synchronized (CACHE) {
+         CACHE.put(hash, compiled);
+      }
+      return compiled;
+   }
+
+   static void clearCache() {
+      synchronized (CACHE) {
+         CACHE.clear();
+      }
+   }
+
+   static int getCacheSize() {
+      synchronized (CACHE) {
+         return CACHE.size();
+      }
+   }
+
+   int getLineCount() {
+      return lineCount_;
+   }
+
+   int getProbeCount() {
+      return probeCount_;
+   }
+
+   private static List<SimpleNode> parse(String script) throws EvalError {
+      Parser parser = new Parser(new StringReader(script));
+      List<SimpleNode> nodes = new ArrayList<>();
+      try {
+         while (!parser.Line()) {
+            SimpleNode node = (SimpleNode) parser.popNode();
+            if (node != null) {
+               node.setSourceFile(SOURCE_NAME);
+               nodes.add(node);
+            }
+         }
+      } catch (TokenMgrError e) {
+         throw new EvalError("Token Parsing Error: " + e.getMessage(), null, null);
+      }
+      return nodes;
+   }
+
+   /**
+    * Collects the position of the first statement on each line: a map from
+    * line number to the offset of the statement in the line.
+    */
+   private static void findStatements(SimpleNode node, boolean isStatement,
+                                      List<String> lines, Map<Integer, Integer> probes) {
+      Token token = node.firstToken;
+      if (isStatement && token != null && token.beginLine <= lines.size()) {
+         String line = lines.get(token.beginLine - 1);
+         int offset = toOffset(line, token.beginColumn);
+         // Skip positions that do not map back to the text, as with unicode
+         // escapes
+         if (offset >= 0 && line.startsWith(token.image, offset)) {
+            Integer previous = probes.get(token.beginLine);
+            if (previous == null || offset < previous) {
+               probes.put(token.beginLine, offset);
+            }
+         }
+      }
+      // The body of a class is a block, but cannot hold statements
+      String type = node.getClass().getSimpleName();
+      boolean isBody = type.equals("BSHClassDeclaration")
+            || type.equals("BSHAllocationExpression");
+      for (int i = 0; i < node.jjtGetNumChildren(); i++) {
+         SimpleNode child = node.getChild(i);
+         findStatements(child, false, lines, probes);
+         if (!isBody && child.getClass().getSimpleName().equals("BSHBlock")) {
+            for (int j = 0; j < child.jjtGetNumChildren(); j++) {
+               findStatements(child.getChild(j), true, lines, probes);
+            }
+         }
+      }
+   }
+
+   // Converts a column of the parser (from 1) to an offset in the line
+   private static int toOffset(String line, int column) {
+      int col = 0;
+      for (int i = 0; i < line.length(); i++) {
+         if (col + 1 == column) {
+            return i;
+         }
+         col = line.charAt(i) == '\t' ? (col / TAB_SIZE + 1) * TAB_SIZE : col + 1;
+         if (col + 1 > column) {
+            return -1;
+         }
+      }
+      return -1;
+   }
+
+   private static List<String> splitLines(String script) {
+      List<String> lines = new ArrayList<>();
+      int start = 0;
+      for (int i = 0; i < script.length(); i++) {
+         char c = script.charAt(i);
+         if (c == '\n' || c == '\r') {
+            // Keep the line ending with the line
+            if (c == '\r' && i + 1 < script.length() && script.charAt(i + 1) == '\n') {
+               i++;
+            }
+            lines.add(script.substring(start, i + 1));
+            start = i + 1;
+         }
+      }
+      lines.add(script.substring(start));
+      return lines;
+   }
+
+   private static String instrument(List<String> lines, Map<Integer, Integer> probes) {
+      StringBuilder sb = new StringBuilder();
+      for (int i = 0; i < lines.size(); i++) {
+         String line = lines.get(i);
+         Integer offset = probes.get(i + 1);
+         if (offset == null) {
+            sb.append(line);
+         } else {
+            sb.append(line, 0, offset).append(PROBE_NAME).append(".hit(").append(i + 1)
+                  .append(");").append(line, offset, line.length());
+         }
+      }
+      return sb.toString();
+   }
+
+   /**
+    * Runs the script in the global namespace of the interpreter.
+    *
+    * @param interp interpreter holding the variables of the script
+    * @param probe probe to call before each statement
+    * @throws EvalError if the script fails, or throws
+    *         ScriptController.ScriptStoppedException (as target) when the
+    *         probe stopped it
+    */
+   void run(Interpreter interp, ScriptProbe probe) throws EvalError {
+      // Left in place after the script ends, for methods of the script that
+      // are called back later
+      interp.set(PROBE_NAME, probe);
+      probe.start();
+      try {
+         CallStack callstack = new CallStack(interp.getNameSpace());
+         for (SimpleNode node : nodes_) {
+            Object result = node.eval(callstack, interp);
+            // A return (or break) at the top level ends the script
+            if (result != null && result.getClass().getName().equals("bsh.ReturnControl")) {
+               break;
+            }
+         }
+      } finally {
+         probe.finish();
+      }
+   }
+}
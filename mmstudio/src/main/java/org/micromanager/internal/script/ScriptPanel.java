@@ -26,7 +26,9 @@ import bsh.Interpreter;
 import bsh.util.JConsole;
 import java.awt.Color;
 import java.awt.Dimension;
+import java.awt.Component;
 import java.awt.Font;
+import java.awt.Graphics;
 import java.awt.Insets;
 import java.awt.Toolkit;
 import java.awt.dnd.DropTarget;
@@ -47,6 +49,7 @@ import java.io.IOException;
 import java.util.ArrayList;
 import java.util.List;
 import javax.swing.BoxLayout;
+import javax.swing.Icon;
 import javax.swing.InputMap;
 import javax.swing.JButton;
 import javax.swing.JFrame;
@@ -75,6 +78,7 @@ import javax.swing.text.StyleConstants;
 import javax.swing.text.StyleContext;
 import org.fife.ui.rsyntaxtextarea.RSyntaxTextArea;
 import org.fife.ui.rsyntaxtextarea.SyntaxConstants;
+import org.fife.ui.rtextarea.Gutter;
 import org.fife.ui.rtextarea.RTextScrollPane;
 import org.fife.ui.rtextarea.SearchContext;
 import org.fife.ui.rtextarea.SearchEngine;
@@ -493,6 +497,8 @@ public final class ScriptPanel extends JFrame implements MouseListener, ScriptCo
       sp = new RTextScrollPane(scriptArea_);
       sp.setFocusTraversalKeysEnabled(false);
       sp.setLineNumbersEnabled(true);
+      // Shows the profile of the last run
+      sp.setIconRowHeaderEnabled(true);
 
       spTopRight.putConstraint(SpringLayout.EAST, sp, 0, SpringLayout.EAST, topRightPanel);
       spTopRight.putConstraint(SpringLayout.SOUTH, sp, -(buttonHeight + 2 * gap),
@@ -1005,6 +1011,7 @@ public final class ScriptPanel extends JFrame implements MouseListener, ScriptCo
          runButton_.setEnabled(false);
          stopButton_.setText("Interrupt");
          stopButton_.setEnabled(true);
+         sp.getGutter().removeAllTrackingIcons();
 
          interp_.evaluateAsync(scriptArea_.getText());
 
@@ -1018,6 +1025,8 @@ public final class ScriptPanel extends JFrame implements MouseListener, ScriptCo
             }
             runButton_.setEnabled(true);
             stopButton_.setEnabled(false);
+            final ScriptProbe profile = interp_.getProfile();
+            SwingUtilities.invokeLater(() -> showProfile(profile));
          });
          sentinel.start();
       } catch (MMScriptException e) {
@@ -1027,6 +1036,70 @@ public final class ScriptPanel extends JFrame implements MouseListener, ScriptCo
    }
 
 
+   /**
+    * Square in the gutter, colored from yellow to red by the share of the
+    * time spent on a line.
+    */
+   private static final class HeatIcon implements Icon {
+      private static final int SIZE = 10;
+      private final Color color_;
+
+      HeatIcon(float heat) {
+         color_ = new Color(255, Math.round(220 * (1 - heat)), 0);
+      }
+
+      @Override
+      public void paintIcon(Component c, Graphics g, int x, int y) {
+         g.setColor(color_);
+         g.fillRect(x + 1, y + 1, SIZE - 2, SIZE - 2);
+      }
+
+      @Override
+      public int getIconWidth() {
+         return SIZE;
+      }
+
+      @Override
+      public int getIconHeight() {
+         return SIZE;
+      }
+   }
+
+   /**
+    * Shows the time spent on each line of the script in the gutter, as a
+    * heat map; the tooltips give the number of hits and the time.
+    */
+   private void showProfile(ScriptProbe profile) {
+      Gutter gutter = sp.getGutter();
+      gutter.removeAllTrackingIcons();
+      if (profile == null) {
+         return;
+      }
+      long max = 0;
+      for (int line = 1; line <= profile.getLineCount(); line++) {
+         max = Math.max(max, profile.getNanos(line));
+      }
+      long total = profile.getTotalNanos();
+      if (max == 0) {
+         return;
+      }
+      for (int line = 1; line <= profile.getLineCount(); line++) {
+         int hits = profile.getHits(line);
+         if (hits == 0) {
+            continue;
+         }
+         long nanos = profile.getNanos(line);
+         String tip = String.format("%d hits, %.1f ms (%.1f%%)", hits,
+               nanos / 1e6, 100.0 * nanos / total);
+         try {
+            gutter.addLineTrackingIcon(line - 1, new HeatIcon((float) nanos / max), tip);
+         } catch (BadLocationException e) {
+            // The script was shortened since it was run
+            break;
+         }
+      }
+   }
+
    /**
     * Runs the content of the provided file.
     *
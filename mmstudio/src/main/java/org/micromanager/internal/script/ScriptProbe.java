@@ -0,0 +1,113 @@
+package org.micromanager.internal.script;
+
+import org.micromanager.ScriptController;
+
+/**
+ * Called by instrumented scripts before each statement; checks for a stop
+ * request and profiles the lines of the script.
+ *
+ * <p>The time until the next statement starts is counted for the line of a
+ * statement, so that the time of a line excludes that of the statements
+ * nested in it (such as the body of a loop). Only the thread running the
+ * script is profiled: methods of the script that are called back from other
+ * threads, or after the script ended, are not. Must be public, for
+ * Beanshell to call it.
+ */
+public final class ScriptProbe {
+   private final int[] hits_;
+   private final long[] nanos_;
+   private volatile boolean stopRequested_ = false;
+   private volatile Thread thread_;
+   private int lastLine_ = 0;
+   private long lastNs_;
+
+   /**
+    * @param lineCount number of lines in the script
+    */
+   ScriptProbe(int lineCount) {
+      hits_ = new int[lineCount + 1];
+      nanos_ = new long[lineCount + 1];
+   }
+
+   /**
+    * Records that the statement starting on the given line is run.
+    *
+    * @param line line number, starting at 1
+    * @throws ScriptController.ScriptStoppedException when a stop was
+    *         requested; thrown again at each statement, so that the script
+    *         stops even if it catches the exception
+    */
+   public void hit(int line) {
+      if (Thread.currentThread() != thread_) {
+         return;
+      }
+      long now = System.nanoTime();
+      if (lastLine_ > 0) {
+         nanos_[lastLine_] += now - lastNs_;
+      }
+      if (line > 0 && line < hits_.length) {
+         hits_[line]++;
+         lastLine_ = line;
+      } else {
+         lastLine_ = 0;
+      }
+      lastNs_ = now;
+      if (stopRequested_) {
+         throw new ScriptController.ScriptStoppedException("Script interrupted by the user!");
+      }
+   }
+
+   /**
+    * Starts profiling the calling thread.
+    */
+   void start() {
+      lastLine_ = 0;
+      thread_ = Thread.currentThread();
+   }
+
+   /**
+    * Counts the time of the last statement and stops profiling; called when
+    * the script ends.
+    */
+   void finish() {
+      if (lastLine_ > 0) {
+         nanos_[lastLine_] += System.nanoTime() - lastNs_;
+         lastLine_ = 0;
+      }
+      thread_ = null;
+   }
+
+   void requestStop() {
+      stopRequested_ = true;
+   }
+
+   boolean isStopRequested() {
+      return stopRequested_;
+   }
+
+   public int getLineCount() {
+      return hits_.length - 1;
+   }
+
+   /**
+    * Returns the number of times statements starting on a line were run.
+    */
+   public int getHits(int line) {
+      return hits_[line];
+   }
+
+   /**
+    * Returns the time spent on the statements starting on a line, in ns.
+    */
+   public long getNanos(int line) {
+      return nanos_[line];
+   }
+
+   public long getTotalNanos() {
+      long total = 0;
+      for (long nanos : nanos_) {
+         total += nanos;
+      }
+      return total;
+   }
+}
@@ -20,4 +20,9 @@ public interface ScriptingEngine {
    void setInterpreter(Interpreter interp);
 
    void resetInterpreter();
+
+   /**
+    * Returns the profile of the script last run by evaluateAsync, or null.
+    */
+   ScriptProbe getProfile();
 }
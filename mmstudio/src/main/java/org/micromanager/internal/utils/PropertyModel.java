@@ -0,0 +1,275 @@
+package org.micromanager.internal.utils;
+
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.HashMap;
+import java.util.IdentityHashMap;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.function.Consumer;
+import mmcorej.CMMCore;
+import mmcorej.DeviceType;
+import mmcorej.StrVector;
+
+/**
+ * Properties of the loaded devices, indexed by device and property name.
+ *
+ * <p>The structure of the properties (type, limits, allowed values) is read
+ * once, when the model is loaded. After that only values change: single
+ * values from property change notifications, all values from the cache of
+ * the Core, or values read from the devices in batches, which can be done
+ * off the EDT. A value read from a device is dropped when the property was
+ * notified of a change while the read was under way, as the notified value
+ * may be newer.
+ *
+ * <p>All methods are thread safe. PropertyItems are changed while holding
+ * the lock of the model.
+ */
+public final class PropertyModel {
+
+   /**
+    * Access to the Core, separated out for testing.
+    */
+   interface Core {
+      List<String> getLoadedDevices();
+
+      DeviceType getDeviceType(String device) throws Exception;
+
+      List<String> getPropertyNames(String device) throws Exception;
+
+      /**
+       * Returns the structure of a property, with its cached value.
+       */
+      PropertyItem describe(String device, String property);
+
+      String getPropertyFromCache(String device, String property) throws Exception;
+
+      String getProperty(String device, String property) throws Exception;
+   }
+
+   // Values read from the devices before they are stored and reported
+   static final int BATCH_SIZE = 50;
+
+   private final Core core_;
+   // Guarded by this
+   private final Map<String, Map<String, PropertyItem>> items_ = new LinkedHashMap<>();
+   private final Map<String, DeviceType> deviceTypes_ = new HashMap<>();
+   // Number of the last notification of each property, counting from the last load
+   private final Map<PropertyItem, Long> notified_ = new IdentityHashMap<>();
+   private long notifications_ = 0;
+   private boolean loaded_ = false;
+
+   /**
+    * Creates an empty model of the properties in the Core.
+    *
+    * @param core the Core
+    */
+   public PropertyModel(final CMMCore core) {
+      this(new Core() {
+         @Override
+         public List<String> getLoadedDevices() {
+            return toList(core.getLoadedDevices());
+         }
+
+         @Override
+         public DeviceType getDeviceType(String device) throws Exception {
+            return core.getDeviceType(device);
+         }
+
+         @Override
+         public List<String> getPropertyNames(String device) throws Exception {
+            return toList(core.getDevicePropertyNames(device));
+         }
+
+         @Override
+         public PropertyItem describe(String device, String property) {
+            PropertyItem item = new PropertyItem();
+            item.readFromCore(core, device, property, true);
+            return item;
+         }
+
+         @Override
+         public String getPropertyFromCache(String device, String property) throws Exception {
+            return core.getPropertyFromCache(device, property);
+         }
+
+         @Override
+         public String getProperty(String device, String property) throws Exception {
+            return core.getProperty(device, property);
+         }
+      });
+   }
+
+   PropertyModel(Core core) {
+      core_ = core;
+   }
+
+   private static List<String> toList(StrVector vector) {
+      List<String> result = new ArrayList<>((int) vector.size());
+      for (int i = 0; i < vector.size(); i++) {
+         result.add(vector.get(i));
+      }
+      return result;
+   }
+
+   /**
+    * Reads the structure of all properties, with their cached values.
+    * Replaces all PropertyItems.
+    */
+   public synchronized void load() {
+      items_.clear();
+      deviceTypes_.clear();
+      notified_.clear();
+      for (String device : core_.getLoadedDevices()) {
+         Map<String, PropertyItem> properties = new LinkedHashMap<>();
+         items_.put(device, properties);
+         try {
+            deviceTypes_.put(device, core_.getDeviceType(device));
+            for (String property : core_.getPropertyNames(device)) {
+               properties.put(property, core_.describe(device, property));
+            }
+         } catch (Exception e) {
+            ReportingUtils.logError(e, "Failed to read properties of " + device);
+         }
+      }
+      loaded_ = true;
+   }
+
+   /**
+    * Returns true when the model was not loaded, or when other devices were
+    * loaded since.
+    */
+   public synchronized boolean isStale() {
+      return !loaded_ || !core_.getLoadedDevices().equals(new ArrayList<>(items_.keySet()));
+   }
+
+   public synchronized List<String> getDevices() {
+      return new ArrayList<>(items_.keySet());
+   }
+
+   /**
+    * Returns the type of a device, or null if it is not known.
+    */
+   public synchronized DeviceType getDeviceType(String device) {
+      return deviceTypes_.get(device);
+   }
+
+   /**
+    * Returns the properties of a device, in the order of the Core.
+    */
+   public synchronized List<PropertyItem> getItems(String device) {
+      Map<String, PropertyItem> properties = items_.get(device);
+      if (properties == null) {
+         return Collections.emptyList();
+      }
+      return new ArrayList<>(properties.values());
+   }
+
+   /**
+    * Returns a property, or null if it is not known.
+    */
+   public synchronized PropertyItem getItem(String device, String property) {
+      Map<String, PropertyItem> properties = items_.get(device);
+      return properties == null ? null : properties.get(property);
+   }
+
+   public synchronized int size() {
+      int size = 0;
+      for (Map<String, PropertyItem> properties : items_.values()) {
+         size += properties.size();
+      }
+      return size;
+   }
+
+   /**
+    * Stores a value notified by the Core.
+    *
+    * @param device device label
+    * @param property property name
+    * @param coreValue new value, as formatted by the Core
+    * @return the property, if it is known and its value changed, or null
+    */
+   public synchronized PropertyItem propertyChanged(String device, String property,
+                                                    String coreValue) {
+      PropertyItem item = getItem(device, property);
+      if (item == null) {
+         return null;
+      }
+      notified_.put(item, ++notifications_);
+      return setValue(item, coreValue) ? item : null;
+   }
+
+   /**
+    * Stores the cached values of all properties.
+    *
+    * @return the properties whose value changed
+    */
+   public synchronized List<PropertyItem> updateFromCache() {
+      List<PropertyItem> changed = new ArrayList<>();
+      for (Map.Entry<String, Map<String, PropertyItem>> device : items_.entrySet()) {
+         for (PropertyItem item : device.getValue().values()) {
+            try {
+               if (setValue(item, core_.getPropertyFromCache(device.getKey(), item.name))) {
+                  changed.add(item);
+               }
+            } catch (Exception e) {
+               // Not in the cache; keep the last value
+            }
+         }
+      }
+      return changed;
+   }
+
+   /**
+    * Reads the values of the given properties from the devices, in batches
+    * of {@link #BATCH_SIZE}. The lock of the model is not held while reading,
+    * so notifications are not held up. Stops early when the thread is
+    * interrupted.
+    *
+    * @param items properties to read
+    * @param onBatch called after the values of a batch were stored, with the
+    *                properties whose value changed
+    */
+   public void readValues(List<PropertyItem> items, Consumer<List<PropertyItem>> onBatch) {
+      for (int start = 0; start < items.size(); start += BATCH_SIZE) {
+         if (Thread.currentThread().isInterrupted()) {
+            return;
+         }
+         List<PropertyItem> batch = items.subList(start,
+               Math.min(items.size(), start + BATCH_SIZE));
+         long readStart;
+         synchronized (this) {
+            readStart = notifications_;
+         }
+         String[] values = new String[batch.size()];
+         for (int i = 0; i < batch.size(); i++) {
+            PropertyItem item = batch.get(i);
+            try {
+               values[i] = core_.getProperty(item.device, item.name);
+            } catch (Exception e) {
+               ReportingUtils.logError(e, "Failed to read " + item.device + "-" + item.name);
+            }
+         }
+         List<PropertyItem> changed = new ArrayList<>();
+         synchronized (this) {
+            for (int i = 0; i < batch.size(); i++) {
+               PropertyItem item = batch.get(i);
+               if (values[i] != null && notified_.getOrDefault(item, 0L) <= readStart
+                     && setValue(item, values[i])) {
+                  changed.add(item);
+               }
+            }
+         }
+         if (!changed.isEmpty()) {
+            onBatch.accept(changed);
+         }
+      }
+   }
+
+   private static boolean setValue(PropertyItem item, String coreValue) {
+      String previous = item.value;
+      item.setValueFromCoreString(coreValue);
+      return previous == null ? item.value != null : !previous.equals(item.value);
+   }
+}
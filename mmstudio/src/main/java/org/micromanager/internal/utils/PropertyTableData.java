@@ -1,9 +1,16 @@
 package org.micromanager.internal.utils;
 
 import java.util.ArrayList;
+import java.util.Collections;
 import java.util.HashMap;
+import java.util.HashSet;
 import java.util.List;
 import java.util.Map;
+import java.util.Set;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.Future;
+import javax.swing.SwingUtilities;
 import javax.swing.table.AbstractTableModel;
 import mmcorej.CMMCore;
 import mmcorej.Configuration;
@@ -18,6 +25,12 @@ import org.micromanager.Studio;
 public class PropertyTableData extends AbstractTableModel implements MMPropertyTableModel {
 
    private static final long serialVersionUID = -5582899855072387637L;
+   // Reads property values from the devices, off the EDT
+   private static final ExecutorService VALUE_READER = Executors.newSingleThreadExecutor(r -> {
+      Thread thread = new Thread(r, "Property table value reader");
+      thread.setDaemon(true);
+      return thread;
+   });
    int propertyNameColumn_;
    protected int propertyValueColumn_;
    int propertyUsedColumn_;
@@ -34,7 +47,12 @@ public class PropertyTableData extends AbstractTableModel implements MMPropertyT
    public List<PropertyItem> propListVisible_ = new ArrayList<>();
    // The table data is stored in here.
    protected Map<PropertyItem, Integer> propToRow_ = new HashMap<>();
+   // Items of propList_, for lookups
+   protected Set<PropertyItem> propSet_ = new HashSet<>();
    protected CMMCore core_ = null;
+   // Structure and values of all properties; propList_ holds items of this model
+   protected final PropertyModel model_;
+   private Future<?> valueRead_;
    Configuration[] groupData_;
    PropertySetting[] groupSignature_;
    private volatile boolean updating_;
@@ -144,6 +162,7 @@ public class PropertyTableData extends AbstractTableModel implements MMPropertyT
       allowChangingProperties_ = allowChangingProperties;
       allowChangesOnlyWhenUsed_ = allowChangesOnlyWhenUsed;
       isPixelSizeConfig_ = isPixelSizeConfig;
+      model_ = new PropertyModel(core_);
    }
 
    protected PropertyTableData(Builder b) {
@@ -157,19 +176,37 @@ public class PropertyTableData extends AbstractTableModel implements MMPropertyT
       allowChangingProperties_ = b.allowChangingProperties_;
       allowChangesOnlyWhenUsed_ = b.allowChangesOnlyWhenUsed_;
       isPixelSizeConfig_ = b.isPixelSizeConfig_;
+      model_ = new PropertyModel(core_);
    }
 
    public List<PropertyItem> getProperties() {
       return propList_;
    }
 
+   /**
+    * Returns the listed property with the given device and name, or null.
+    */
    public PropertyItem getItem(String device, String propName) {
-      for (PropertyItem item : propList_) {
-         if ((item.device.contentEquals(device)) && (item.name.contentEquals(propName))) {
-            return item;
-         }
+      PropertyItem item = model_.getItem(device, propName);
+      if (item == null || !propSet_.contains(item)) {
+         return null;
+      }
+      return item;
+   }
+
+   /**
+    * Shows a changed property value, as notified by the Core. Only the row
+    * of the property is updated. Can be called from any thread.
+    *
+    * @param device device label
+    * @param propName property name
+    * @param coreValue new value, as formatted by the Core
+    */
+   public void update(String device, String propName, String coreValue) {
+      final PropertyItem item = model_.propertyChanged(device, propName, coreValue);
+      if (item != null) {
+         SwingUtilities.invokeLater(() -> fireRowsUpdated(Collections.singletonList(item)));
       }
-      return null; // Failed to find the item.
    }
 
    public boolean verifyPresetSignature() {
@@ -305,14 +342,13 @@ public class PropertyTableData extends AbstractTableModel implements MMPropertyT
       // when updating, we do need to keep track which properties have their
       // "Use" checkbox checked.  Otherwise, this information get lost, which
       // is annoying and confusing for the user
-      List<PropertyItem> usedItems = new ArrayList<>();
+      Set<String> usedItems = new HashSet<>();
       for (PropertyItem item : propListVisible_) {
          if (item.confInclude) {
-            usedItems.add(item);
+            usedItems.add(item.device + "-" + item.name);
          }
       }
 
-      StrVector devices = core_.getLoadedDevices();
       propList_.clear();
 
       Configuration cfg;
@@ -341,22 +377,14 @@ public class PropertyTableData extends AbstractTableModel implements MMPropertyT
 
          setUpdating(true);
 
-         for (int i = 0; i < devices.size(); i++) {
-            if (showDevice(flags, devices.get(i))) {
-               StrVector properties = core_.getDevicePropertyNames(devices.get(i));
-               for (int j = 0; j < properties.size(); j++) {
-                  PropertyItem item = new PropertyItem();
-                  if (!groupOnly_ || cfg.isPropertyIncluded(devices.get(i), properties.get(j))) {
-                     item.readFromCore(core_, devices.get(i), properties.get(j), fromCache);
+         updateModel(fromCache);
+         for (String device : model_.getDevices()) {
+            if (showDevice(flags, device)) {
+               for (PropertyItem item : model_.getItems(device)) {
+                  if (!groupOnly_ || cfg.isPropertyIncluded(item.device, item.name)) {
                      if ((!item.readOnly || showReadOnly_) && !item.preInit) {
-                        item.confInclude = cfg.isPropertyIncluded(item.device, item.name);
-                        for (PropertyItem usedItem : usedItems) {
-                           if (item.device.equals(usedItem.device)
-                                 && item.name.equals(usedItem.name)) {
-                              item.confInclude = true;
-                           }
-                        }
-
+                        item.confInclude = cfg.isPropertyIncluded(item.device, item.name)
+                              || usedItems.contains(item.device + "-" + item.name);
                         propList_.add(item);
                      }
                   }
@@ -376,10 +404,64 @@ public class PropertyTableData extends AbstractTableModel implements MMPropertyT
 
       this.fireTableStructureChanged();
 
+      if (!fromCache) {
+         readValuesInBackground();
+      }
+   }
+
+   /**
+    * Brings the model up to date. Its structure is only read again when
+    * other devices were loaded, or when not reading from the cache; values
+    * are taken from the cache of the Core.
+    */
+   protected void updateModel(boolean fromCache) {
+      cancelValueRead();
+      if (!fromCache || model_.isStale()) {
+         model_.load();
+      } else {
+         model_.updateFromCache();
+      }
+   }
+
+   /**
+    * Reads the values of the listed properties from the devices, on a
+    * background thread, and updates their rows as values arrive.
+    */
+   protected void readValuesInBackground() {
+      cancelValueRead();
+      final List<PropertyItem> items = new ArrayList<>(propList_);
+      valueRead_ = VALUE_READER.submit(() -> {
+         // Some properties may not be readable if we are mid-acquisition.
+         studio_.live().setSuspended(true);
+         try {
+            model_.readValues(items,
+                  changed -> SwingUtilities.invokeLater(() -> fireRowsUpdated(changed)));
+         } finally {
+            studio_.live().setSuspended(false);
+         }
+      });
+   }
+
+   private void cancelValueRead() {
+      if (valueRead_ != null) {
+         valueRead_.cancel(true);
+         valueRead_ = null;
+      }
+   }
+
+   private void fireRowsUpdated(List<PropertyItem> items) {
+      for (PropertyItem item : items) {
+         Integer row = propToRow_.get(item);
+         if (row != null) {
+            fireTableCellUpdated(row, propertyValueColumn_);
+         }
+      }
    }
 
    public void updateRowVisibility(ShowFlags flags) {
       propListVisible_.clear();
+      propSet_.clear();
+      propSet_.addAll(propList_);
 
       boolean showDevice;
 
@@ -414,11 +496,13 @@ public class PropertyTableData extends AbstractTableModel implements MMPropertyT
    }
 
    public Boolean showDevice(ShowFlags flags, String deviceName) {
-      DeviceType dType = null;
-      try {
-         dType = core_.getDeviceType(deviceName);
-      } catch (Exception e) {
-         handleException(e);
+      DeviceType dType = model_.getDeviceType(deviceName);
+      if (dType == null) {
+         try {
+            dType = core_.getDeviceType(deviceName);
+         } catch (Exception e) {
+            handleException(e);
+         }
       }
 
       Boolean showDevice;
@@ -175,7 +175,7 @@ public final class ShowFlagsPanel extends JPanel {
       showReadonlyCheckBox_.addActionListener((ActionEvent e) -> {
          // show/hide read-only properties
          data_.setShowReadOnly(showReadonlyCheckBox_.isSelected());
-         data_.update(false);
+         data_.update(true);
          data_.fireTableStructureChanged();
       });
       propertyTypePanel.add(showReadonlyCheckBox_, "wrap");
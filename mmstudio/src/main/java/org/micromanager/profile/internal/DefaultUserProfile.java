@@ -11,7 +11,10 @@ import static org.micromanager.PropertyMaps.emptyPropertyMap;
 import com.google.common.eventbus.EventBus;
 import com.google.common.eventbus.Subscribe;
 import java.io.IOException;
+import java.util.Map;
+import java.util.TreeMap;
 import java.util.UUID;
+import java.util.concurrent.ConcurrentHashMap;
 import org.micromanager.EventPublisher;
 import org.micromanager.PropertyMap;
 import org.micromanager.PropertyMaps;
@@ -28,14 +31,10 @@ import org.micromanager.propertymap.MutablePropertyMapView;
 public class DefaultUserProfile implements UserProfile, EventPublisher {
 
    /*
-    * TODO [Performance]
-    *
-    * It should be determined whether it is worth optimizing by using a mutable
-    * internal map. However, note that although we currently "copy" the entire
-    * map, each of the per-owner property maps are not copied unless modified.
-    * Let's see how many owners we end up seeing. If we do need to optimize,
-    * the mutable property map should also be thread safe, perhaps by using
-    * ConcurrentHashMap.
+    * Each owner has an immutable property map, replaced on every edit. Reads
+    * take the current map without locking; edits of different owners do not
+    * wait for each other. Edits are recorded in the journal, if any, in the
+    * order in which they were applied to each owner.
     */
 
    // TODO currently we store admin and uuid for the sole purpose of getting
@@ -43,10 +42,11 @@ public class DefaultUserProfile implements UserProfile, EventPublisher {
    private final UserProfileAdmin admin_;
    private final UUID uuid_;
 
-   private PropertyMap ownersAndProperties_;
-   private DefaultUserProfile fallbackProfile_;
+   private final Map<String, PropertyMap> owners_ = new ConcurrentHashMap<>();
+   private volatile DefaultUserProfile fallbackProfile_;
 
    private ProfileSaver saver_;
+   private volatile ProfileJournal journal_;
 
    private final EventBus bus_ =
          new EventBus(EventBusExceptionLogger.getInstance());
@@ -71,13 +71,24 @@ public class DefaultUserProfile implements UserProfile, EventPublisher {
                               PropertyMap settings) {
       admin_ = admin;
       uuid_ = profileUUID;
-      ownersAndProperties_ = settings;
+      for (String owner : settings.keySet()) {
+         if (settings.containsPropertyMap(owner)) {
+            owners_.put(owner, settings.getPropertyMap(owner, emptyPropertyMap()));
+         }
+      }
    }
 
    void setSaver(ProfileSaver saver) {
       saver_ = saver;
    }
 
+   /**
+    * Sets the journal that records all further edits.
+    */
+   void setJournal(ProfileJournal journal) {
+      journal_ = journal;
+   }
+
    /**
     * Stop autosaving and stop performing migrations.
     *
@@ -105,37 +116,44 @@ public class DefaultUserProfile implements UserProfile, EventPublisher {
    }
 
    public PropertyMap getSettingsWithoutFallback(Class<?> owner) {
-      return ownersAndProperties_.getPropertyMap(owner.getCanonicalName(),
-            emptyPropertyMap());
+      return owners_.getOrDefault(owner.getCanonicalName(), emptyPropertyMap());
    }
 
    // ALL reads are via this method
-   synchronized PropertyMap getProperties(Class<?> owner) {
+   PropertyMap getProperties(Class<?> owner) {
       // Chain the per-owner maps at the time of read access, to obtain an
       // up-to-date chained map.
-      return fallbackProfile_ == null
+      DefaultUserProfile fallback = fallbackProfile_;
+      return fallback == null
             ? getSettingsWithoutFallback(owner) :
             ((DefaultPropertyMap) getSettingsWithoutFallback(owner))
                   .createChainedView(
-                        fallbackProfile_.getSettingsWithoutFallback(owner));
+                        fallback.getSettingsWithoutFallback(owner));
    }
 
    // ALL modifications are via this method.
    // Note we do NOT include the fallback items!
-   synchronized void editProperty(Class<?> owner, Editor editor) {
-      String ownerKey = owner.getCanonicalName();
-      ownersAndProperties_ = ownersAndProperties_.copyBuilder()
-            .putPropertyMap(ownerKey,
-                  editor.edit(ownersAndProperties_.getPropertyMap(ownerKey,
-                        emptyPropertyMap())))
-            .build();
+   void editProperty(Class<?> owner, Editor editor) {
+      final ProfileJournal journal = journal_;
+      owners_.compute(owner.getCanonicalName(), (ownerKey, settings) -> {
+         PropertyMap edited = editor.edit(settings == null ? emptyPropertyMap() : settings);
+         if (journal != null) {
+            // Within compute(), so that edits of an owner are recorded in order
+            journal.append(ownerKey, edited);
+         }
+         return edited;
+      });
       bus_.post(UserProfileChangedEvent.create());
    }
 
    // This does not include the fallback preferences. Anybody who needs the
    // combination will have to merge the property maps for each owner.
-   public synchronized PropertyMap toPropertyMap() {
-      return ownersAndProperties_;
+   public PropertyMap toPropertyMap() {
+      PropertyMap.Builder builder = PropertyMaps.builder();
+      for (Map.Entry<String, PropertyMap> entry : new TreeMap<>(owners_).entrySet()) {
+         builder.putPropertyMap(entry.getKey(), entry.getValue());
+      }
+      return builder.build();
    }
 
    @Subscribe
@@ -166,8 +184,13 @@ public class DefaultUserProfile implements UserProfile, EventPublisher {
    }
 
    @Override
-   public synchronized void clearSettingsForAllClasses() {
-      ownersAndProperties_ = PropertyMaps.emptyPropertyMap();
+   public void clearSettingsForAllClasses() {
+      owners_.clear();
+      ProfileJournal journal = journal_;
+      if (journal != null) {
+         journal.appendClearAll();
+      }
+      bus_.post(UserProfileChangedEvent.create());
    }
 
 
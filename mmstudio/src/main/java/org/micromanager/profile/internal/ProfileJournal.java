@@ -0,0 +1,264 @@
+package org.micromanager.profile.internal;
+
+import com.google.common.base.Charsets;
+import java.io.BufferedInputStream;
+import java.io.ByteArrayOutputStream;
+import java.io.DataInputStream;
+import java.io.DataOutputStream;
+import java.io.File;
+import java.io.FileInputStream;
+import java.io.FileNotFoundException;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.io.RandomAccessFile;
+import java.nio.file.Files;
+import java.nio.file.StandardOpenOption;
+import java.util.ArrayList;
+import java.util.List;
+import java.util.zip.CRC32;
+import org.micromanager.PropertyMap;
+import org.micromanager.PropertyMaps;
+import org.micromanager.internal.utils.ReportingUtils;
+
+/**
+ * Append-only journal of the edits made to a user profile, kept next to the
+ * profile file.
+ *
+ * <p>Each record holds the complete settings of one owner after an edit.
+ * Replaying the journal over the last saved profile therefore restores the
+ * profile, whichever of the records the saved profile already includes.
+ *
+ * <p>Edits are queued in memory by {@link #append} and written by
+ * {@link #flush}, which writes all queued records with a single sync to
+ * disk (group commit). Compaction saves the whole profile and drops the
+ * records it includes: {@link #beginCompaction} moves the journal aside
+ * before the profile is taken, and {@link #endCompaction} deletes it once
+ * the profile was saved.
+ *
+ * <p>A record is written as its length, its CRC-32 and the owner and
+ * settings in UTF-8. Replay stops at the first incomplete or damaged record,
+ * as left by a crash during a write; {@link #repair} cuts such records off
+ * before new records are appended.
+ */
+final class ProfileJournal {
+   // Owner of the record that clears all settings; never an owner name
+   private static final String CLEAR_ALL = "";
+   // Records larger than this are taken to be damaged
+   private static final int MAX_RECORD_BYTES = 64 * 1024 * 1024;
+
+   private static final class Record {
+      private final String owner_;
+      private final PropertyMap settings_;
+
+      private Record(String owner, PropertyMap settings) {
+         owner_ = owner;
+         settings_ = settings;
+      }
+   }
+
+   private final File file_;
+   private final File compacting_;
+   // Guarded by this
+   private final List<Record> pending_ = new ArrayList<>();
+   // Held while accessing the files
+   private final Object io_ = new Object();
+
+   ProfileJournal(File file) {
+      file_ = file;
+      compacting_ = new File(file.getPath() + ".compacting");
+   }
+
+   /**
+    * Queues the settings of an owner after an edit.
+    *
+    * @return true if no other records were queued, so that a flush should
+    *         be scheduled
+    */
+   synchronized boolean append(String owner, PropertyMap settings) {
+      pending_.add(new Record(owner, settings));
+      return pending_.size() == 1;
+   }
+
+   /**
+    * Queues the removal of all settings.
+    *
+    * @return true if no other records were queued
+    */
+   synchronized boolean appendClearAll() {
+      return append(CLEAR_ALL, PropertyMaps.emptyPropertyMap());
+   }
+
+   /**
+    * Drops the queued records, when the profile is not to be written.
+    */
+   synchronized void discardPending() {
+      pending_.clear();
+   }
+
+   private synchronized List<Record> takePending() {
+      List<Record> records = new ArrayList<>(pending_);
+      pending_.clear();
+      return records;
+   }
+
+   /**
+    * Writes the queued records, and syncs them to disk.
+    */
+   void flush() throws IOException {
+      synchronized (io_) {
+         List<Record> records = takePending();
+         if (records.isEmpty()) {
+            return;
+         }
+         ByteArrayOutputStream bytes = new ByteArrayOutputStream();
+         DataOutputStream data = new DataOutputStream(bytes);
+         CRC32 crc = new CRC32();
+         for (Record record : records) {
+            byte[] payload = (record.owner_ + "\n" + record.settings_.toJSON())
+                  .getBytes(Charsets.UTF_8);
+            crc.reset();
+            crc.update(payload);
+            data.writeInt(payload.length);
+            data.writeInt((int) crc.getValue());
+            data.write(payload);
+         }
+         try (FileOutputStream out = new FileOutputStream(file_, true)) {
+            bytes.writeTo(out);
+            out.getChannel().force(false);
+         }
+      }
+   }
+
+   /**
+    * Moves the journal aside, before the profile is taken for saving. Later
+    * records go to a new journal.
+    */
+   void beginCompaction() throws IOException {
+      synchronized (io_) {
+         if (!file_.exists()) {
+            return;
+         }
+         if (compacting_.exists()) {
+            // The last compaction failed; keep its records
+            Files.write(compacting_.toPath(), Files.readAllBytes(file_.toPath()),
+                  StandardOpenOption.APPEND);
+            Files.delete(file_.toPath());
+         } else if (!file_.renameTo(compacting_)) {
+            throw new IOException("Failed to rename " + file_ + " to " + compacting_);
+         }
+      }
+   }
+
+   /**
+    * Deletes the journal that was moved aside, after the profile was saved.
+    */
+   void endCompaction() throws IOException {
+      synchronized (io_) {
+         Files.deleteIfExists(compacting_.toPath());
+      }
+   }
+
+   /**
+    * Deletes the journal, together with its profile.
+    */
+   void delete() throws IOException {
+      synchronized (io_) {
+         discardPending();
+         Files.deleteIfExists(compacting_.toPath());
+         Files.deleteIfExists(file_.toPath());
+      }
+   }
+
+   /**
+    * Applies the records in the journal to the given settings.
+    *
+    * @param settings the settings of the saved profile
+    * @return the settings after all complete records
+    */
+   PropertyMap replay(PropertyMap settings) {
+      synchronized (io_) {
+         return replay(replay(settings, compacting_).settings_, file_).settings_;
+      }
+   }
+
+   /**
+    * Cuts off incomplete or damaged records at the end of the journal, so
+    * that records appended later are replayed.
+    */
+   void repair() throws IOException {
+      synchronized (io_) {
+         for (File file : new File[] {compacting_, file_}) {
+            Replay replay = replay(PropertyMaps.emptyPropertyMap(), file);
+            if (replay.damaged_) {
+               try (RandomAccessFile raf = new RandomAccessFile(file, "rw")) {
+                  raf.setLength(replay.validBytes_);
+               }
+            }
+         }
+      }
+   }
+
+   private static final class Replay {
+      private final PropertyMap settings_;
+      private final long validBytes_;
+      private final boolean damaged_;
+
+      private Replay(PropertyMap settings, long validBytes, boolean damaged) {
+         settings_ = settings;
+         validBytes_ = validBytes;
+         damaged_ = damaged;
+      }
+   }
+
+   private static Replay replay(PropertyMap settings, File file) {
+      int count = 0;
+      long validBytes = 0;
+      boolean damaged = false;
+      try (DataInputStream in = new DataInputStream(
+            new BufferedInputStream(new FileInputStream(file)))) {
+         CRC32 crc = new CRC32();
+         while (true) {
+            int first = in.read();
+            if (first < 0) {
+               break;
+            }
+            // A partial length is damage, like any other partial record
+            int length = (first << 24) | (in.readUnsignedByte() << 16)
+                  | (in.readUnsignedByte() << 8) | in.readUnsignedByte();
+            if (length < 0 || length > MAX_RECORD_BYTES) {
+               throw new IOException("Invalid record length " + length);
+            }
+            int checksum = in.readInt();
+            byte[] payload = new byte[length];
+            in.readFully(payload);
+            crc.reset();
+            crc.update(payload);
+            if ((int) crc.getValue() != checksum) {
+               throw new IOException("Checksum mismatch");
+            }
+            String text = new String(payload, Charsets.UTF_8);
+            int split = text.indexOf('\n');
+            if (split < 0) {
+               throw new IOException("Invalid record");
+            }
+            String owner = text.substring(0, split);
+            if (owner.equals(CLEAR_ALL)) {
+               settings = PropertyMaps.emptyPropertyMap();
+            } else {
+               settings = settings.copyBuilder().putPropertyMap(owner,
+                     PropertyMaps.fromJSON(text.substring(split + 1))).build();
+            }
+            count++;
+            validBytes += 8 + length;
+         }
+      } catch (FileNotFoundException e) {
+         return new Replay(settings, 0, false);
+      } catch (IOException e) {
+         // Incomplete or damaged, as when writing was interrupted
+         damaged = true;
+         ReportingUtils.logMessage("Ignoring the end of user profile journal " + file
+               + " after " + count + " records: " + e.getMessage());
+      }
+      return new Replay(settings, validBytes, damaged);
+   }
+}
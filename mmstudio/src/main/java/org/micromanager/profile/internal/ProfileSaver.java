@@ -8,32 +8,76 @@ package org.micromanager.profile.internal;
 
 import com.google.common.base.Preconditions;
 import com.google.common.eventbus.Subscribe;
+import java.beans.ExceptionListener;
+import java.io.IOException;
 import java.util.concurrent.RejectedExecutionException;
 import java.util.concurrent.ScheduledExecutorService;
 import java.util.concurrent.ScheduledFuture;
 import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicBoolean;
 
 /**
+ * Saves a profile after it was modified.
+ *
+ * <p>Edits are recorded in the journal of the profile within
+ * {@link #GROUP_COMMIT_MS} milliseconds, with all edits made in the meantime
+ * written together. The whole profile is saved at most every
+ * {@link #getSaveIntervalSeconds()} seconds, after which the journal is
+ * emptied.
+ *
  * @author Mark A. Tsuchida
  */
 final class ProfileSaver {
+   /**
+    * Writes the whole profile to its file.
+    */
+   interface Writer {
+      /**
+       * Returns false when modifications are not to be stored on disk.
+       */
+      boolean isWritable();
+
+      void write() throws IOException;
+   }
+
+   // Delay between an edit and writing it to the journal
+   static final long GROUP_COMMIT_MS = 5;
+
    // Saver is created upon the first modification made to the profile
    private final ScheduledExecutorService saver_;
-   private ScheduledFuture<?> scheduledSave_;
+   private volatile ScheduledFuture<?> scheduledSave_;
+   private volatile ScheduledFuture<?> scheduledFlush_;
+   private final AtomicBoolean saveScheduled_ = new AtomicBoolean(false);
+   private final AtomicBoolean flushScheduled_ = new AtomicBoolean(false);
+   private volatile boolean modified_ = false;
 
-   private long saveIntervalSeconds_ = 30;
+   private volatile long saveIntervalSeconds_ = 30;
 
-   private final Runnable save_;
+   private final Writer writer_;
+   private final ProfileJournal journal_;
+   private final ExceptionListener errorHandler_;
 
-   public static ProfileSaver create(DefaultUserProfile profile,
-                                     Runnable save, ScheduledExecutorService saverExecutor) {
-      ProfileSaver instance = new ProfileSaver(save, saverExecutor);
+   /**
+    * @param profile the profile to save
+    * @param writer writes the whole profile
+    * @param journal journal of the profile, or null to only save the whole
+    *                profile
+    * @param errorHandler receives errors while saving; may be null
+    * @param saverExecutor executor to save on
+    */
+   public static ProfileSaver create(DefaultUserProfile profile, Writer writer,
+                                     ProfileJournal journal, ExceptionListener errorHandler,
+                                     ScheduledExecutorService saverExecutor) {
+      ProfileSaver instance = new ProfileSaver(writer, journal, errorHandler, saverExecutor);
       profile.registerForEvents(instance);
       return instance;
    }
 
-   private ProfileSaver(Runnable save, ScheduledExecutorService saverExecutor) {
-      save_ = save;
+   private ProfileSaver(Writer writer, ProfileJournal journal, ExceptionListener errorHandler,
+                        ScheduledExecutorService saverExecutor) {
+      writer_ = writer;
+      journal_ = journal;
+      errorHandler_ = errorHandler;
       saver_ = saverExecutor;
    }
 
@@ -47,35 +91,92 @@ final class ProfileSaver {
    }
 
    public synchronized void syncToDisk() {
-      if (scheduledSave_ == null) {
-         // Save not scheduled, i.e. profile hasn't been modified.
+      if (!modified_) {
+         // Profile hasn't been modified.
          return;
       }
-      save_.run();
+      save();
    }
 
    @Subscribe
    public void onEvent(UserProfileChangedEvent e) {
-      scheduleSave();
+      // Called on the thread of every edit; only schedules when not yet scheduled
+      modified_ = true;
+      if (journal_ != null && flushScheduled_.compareAndSet(false, true)) {
+         scheduleFlush();
+      }
+      if (saveScheduled_.compareAndSet(false, true)) {
+         scheduleSave();
+      }
    }
 
-   private synchronized void scheduleSave() {
-      if (scheduledSave_ != null) {
-         scheduledSave_.cancel(false);
+   private void scheduleFlush() {
+      try {
+         scheduledFlush_ = saver_.schedule(this::flush,
+               GROUP_COMMIT_MS, TimeUnit.MILLISECONDS);
+      } catch (RejectedExecutionException e) {
+         // Saving has been shut down; nothing to do
       }
+   }
+
+   private void scheduleSave() {
       try {
-         scheduledSave_ = saver_.schedule(save_,
+         scheduledSave_ = saver_.schedule(this::save,
                saveIntervalSeconds_, TimeUnit.SECONDS);
       } catch (RejectedExecutionException e) {
          // Saving has been shut down; nothing to do
       }
    }
 
+   private void flush() {
+      // Edits from now on schedule another flush
+      flushScheduled_.set(false);
+      try {
+         if (writer_.isWritable()) {
+            journal_.flush();
+         } else {
+            journal_.discardPending();
+         }
+      } catch (IOException e) {
+         // The edits are still saved with the whole profile
+         reportError(e);
+      }
+   }
+
+   private synchronized void save() {
+      saveScheduled_.set(false);
+      try {
+         if (journal_ == null || !writer_.isWritable()) {
+            writer_.write();
+            return;
+         }
+         journal_.beginCompaction();
+         writer_.write();
+         journal_.endCompaction();
+      } catch (IOException e) {
+         reportError(e);
+      }
+   }
+
+   private void reportError(Exception e) {
+      if (errorHandler_ != null) {
+         errorHandler_.exceptionThrown(e);
+      }
+   }
+
    public synchronized void stop() throws InterruptedException {
       syncToDisk();
       if (scheduledSave_ != null) {
          scheduledSave_.cancel(false);
          scheduledSave_ = null;
       }
+      if (scheduledFlush_ != null) {
+         scheduledFlush_.cancel(false);
+         scheduledFlush_ = null;
+      }
+      if (journal_ != null) {
+         // Saved with the whole profile
+         journal_.discardPending();
+      }
    }
-}
\ No newline at end of file
+}
@@ -58,6 +58,7 @@ public final class UserProfileAdmin {
    private static final String INDEX_FILE = "Index.json";
    private static final String OLD_INDEX_FILE = "Profiles.txt";
    private static final String WRITE_LOCK_FILE = "UserProfileWriteLock";
+   private static final String JOURNAL_SUFFIX = ".journal";
 
    private static final String OLD_DEFAULT_PROFILE_NAME = "Default user";
    private static final String DEFAULT_PROFILE_NAME = "Default User";
@@ -320,6 +321,12 @@ public final class UserProfileAdmin {
       for (IndexEntry entry : getIndex().getEntries()) {
          if (entry.getUUID().equals(uuid)) {
             final String filename = entry.getFilename();
+            ProfileJournal journal = null;
+            if (autosaving && !isReadOnlyMode()) {
+               journal = getJournal(filename);
+               journal.repair();
+            }
+            // Includes the edits in the journal, if any
             Profile profile = readFile(filename);
             final DefaultUserProfile uProfile = DefaultUserProfile.create(this,
                   uuid, profile.getSettings());
@@ -332,18 +339,22 @@ public final class UserProfileAdmin {
                uProfile.setSaver(
                      ProfileSaver.create(
                            uProfile,
-                           () -> {
-                              Profile profile1;
-                              profile1 = Profile.fromSettings(uProfile.toPropertyMap());
-                              try {
-                                 writeFile(filename, profile1, false);
-                              } catch (IOException e) {
-                                 if (errorHandler != null) {
-                                    errorHandler.exceptionThrown(e);
-                                 }
+                           new ProfileSaver.Writer() {
+                              @Override
+                              public boolean isWritable() {
+                                 return !isReadOnlyMode() && !isProfileReadOnly();
+                              }
+
+                              @Override
+                              public void write() throws IOException {
+                                 writeFile(filename,
+                                       Profile.fromSettings(uProfile.toPropertyMap()), false);
                               }
                            },
+                           journal,
+                           errorHandler,
                            saverExecutor_));
+               uProfile.setJournal(journal);
             }
             return uProfile;
          }
@@ -534,18 +545,25 @@ public final class UserProfileAdmin {
             return ret;
          }
       }
+      Profile saved;
       try {
-         return Profile.fromFilePmap(PropertyMaps.loadJSON(getModernFile(filename)));
+         saved = Profile.fromFilePmap(PropertyMaps.loadJSON(getModernFile(filename)));
       } catch (FileNotFoundException e) { // Not present is equivalent to empty
-         return new Profile();
+         saved = new Profile();
       } catch (IOException e) { // Present but in a bad state.  Try to restore from backup
          String backup = filename + "~";
          try {
-            return Profile.fromFilePmap(PropertyMaps.loadJSON(getModernFile(backup)));
+            saved = Profile.fromFilePmap(PropertyMaps.loadJSON(getModernFile(backup)));
          } catch (IOException ex) { // Not present is equivalent to empty
-            return new Profile();
+            saved = new Profile();
          }
       }
+      // Edits made after the profile was last saved
+      return Profile.fromSettings(getJournal(filename).replay(saved.getSettings()));
+   }
+
+   private static ProfileJournal getJournal(String filename) {
+      return new ProfileJournal(getModernFile(filename + JOURNAL_SUFFIX));
    }
 
    /**
@@ -581,6 +599,7 @@ public final class UserProfileAdmin {
          return;
       }
       getModernFile(filename).delete();
+      getJournal(filename).delete();
    }
 
    /**
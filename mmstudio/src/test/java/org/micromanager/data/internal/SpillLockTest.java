@@ -0,0 +1,42 @@
+package org.micromanager.data.internal;
+
+import java.io.File;
+import org.junit.Assert;
+import org.junit.Rule;
+import org.junit.Test;
+import org.junit.rules.TemporaryFolder;
+
+public class SpillLockTest {
+   @Rule
+   public TemporaryFolder folder_ = new TemporaryFolder();
+
+   private File createDataset(String name) throws Exception {
+      File directory = folder_.newFolder(name);
+      Assert.assertTrue(new File(directory, "data.tif").createNewFile());
+      return directory;
+   }
+
+   @Test
+   public void onlyDatasetsLeftBehindAreSwept() throws Exception {
+      File root = folder_.getRoot();
+      File open = createDataset("Album");
+      SpillLock lock = SpillLock.acquire(open);
+      // Lock file of an application that crashed: nobody holds the lock
+      File crashed = createDataset("Album_1");
+      Assert.assertTrue(new File(crashed.getPath() + SpillLock.SUFFIX).createNewFile());
+      // Promoted datasets have no lock file
+      File promoted = createDataset("Album_2");
+
+      Assert.assertEquals(1, SpillLock.sweep(root));
+      Assert.assertTrue(open.exists());
+      Assert.assertFalse(crashed.exists());
+      Assert.assertFalse(new File(crashed.getPath() + SpillLock.SUFFIX).exists());
+      Assert.assertTrue(promoted.exists());
+
+      // Once released, the lock file is gone and the dataset stays
+      lock.release();
+      Assert.assertFalse(new File(open.getPath() + SpillLock.SUFFIX).exists());
+      Assert.assertEquals(0, SpillLock.sweep(root));
+      Assert.assertTrue(open.exists());
+   }
+}
@@ -0,0 +1,236 @@
+package org.micromanager.data.internal;
+
+import java.io.IOException;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.HashSet;
+import java.util.List;
+import java.util.Set;
+import org.junit.Assert;
+import org.junit.Ignore;
+import org.junit.Test;
+import org.micromanager.data.Coordinates;
+import org.micromanager.data.Coords;
+import org.micromanager.data.Image;
+import org.micromanager.data.Storage;
+import org.micromanager.data.SummaryMetadata;
+
+public class StorageTieredTest {
+   private static final int WIDTH = 256;
+   private static final int HEIGHT = 256;
+   private static final long IMAGE_BYTES = WIDTH * HEIGHT * 2;
+
+   private static Image createImage(int t) {
+      short[] pixels = new short[WIDTH * HEIGHT];
+      Arrays.fill(pixels, (short) t);
+      return new DefaultImage(pixels, WIDTH, HEIGHT, 2, 1,
+            Coordinates.builder().t(t).build(), null);
+   }
+
+   /**
+    * Stand-in for a disk-backed storage. It only remembers which images it
+    * received, and recreates their pixels when they are read back, so it
+    * does not hold on to any pixel data.
+    */
+   private static final class SpillStorage implements Storage {
+      private final Set<Coords> coords_ = new HashSet<>();
+      private final long delayNs_;
+
+      SpillStorage(long delayNs) {
+         delayNs_ = delayNs;
+      }
+
+      @Override
+      public void freeze() {
+      }
+
+      @Override
+      public void putImage(Image image) {
+         long end = System.nanoTime() + delayNs_;
+         while (System.nanoTime() < end) {
+            Thread.yield();
+         }
+         synchronized (this) {
+            coords_.add(image.getCoords());
+         }
+      }
+
+      @Override
+      public synchronized Image getImage(Coords coords) {
+         return coords_.contains(coords) ? createImage(coords.getT()) : null;
+      }
+
+      @Override
+      public synchronized boolean hasImage(Coords coords) {
+         return coords_.contains(coords);
+      }
+
+      @Override
+      public Image getAnyImage() {
+         return null;
+      }
+
+      @Override
+      public synchronized Iterable<Coords> getUnorderedImageCoords() {
+         return new ArrayList<>(coords_);
+      }
+
+      @Override
+      public List<Image> getImagesMatching(Coords coords) {
+         return new ArrayList<>();
+      }
+
+      @Override
+      public List<Image> getImagesIgnoringAxes(Coords coords, String... ignoreTheseAxes) {
+         return new ArrayList<>();
+      }
+
+      @Override
+      public int getMaxIndex(String axis) {
+         return -1;
+      }
+
+      @Override
+      public List<String> getAxes() {
+         return new ArrayList<>();
+      }
+
+      @Override
+      public Coords getMaxIndices() {
+         return Coordinates.builder().build();
+      }
+
+      @Override
+      public SummaryMetadata getSummaryMetadata() {
+         return null;
+      }
+
+      @Override
+      public synchronized int getNumImages() {
+         return coords_.size();
+      }
+
+      @Override
+      public void close() {
+      }
+   }
+
+   private static DefaultDatastore createSpill(SpillStorage storage) {
+      // No Studio, so closing must not post the closing event
+      DefaultDatastore spill = new DefaultDatastore(null) {
+         @Override
+         public void close() throws IOException {
+            freeze();
+            storage.close();
+         }
+      };
+      spill.setStorage(storage);
+      return spill;
+   }
+
+   private static void checkPixels(Image image, int t) {
+      Assert.assertNotNull(image);
+      Assert.assertEquals(t, image.getCoords().getT());
+      short[] pixels = (short[]) image.getRawPixels();
+      Assert.assertEquals((short) t, pixels[0]);
+      Assert.assertEquals((short) t, pixels[pixels.length - 1]);
+   }
+
+   /**
+    * Adds nrImages images with the given RAM budget, and checks that RAM use
+    * stays within it while all images can still be read.
+    */
+   private static void snapsStayWithinBudget(int nrImages, long budget) throws IOException {
+      SpillStorage spillStorage = new SpillStorage(0);
+      DefaultDatastore store = new DefaultDatastore(null);
+      StorageTiered storage = new StorageTiered(store, createSpill(spillStorage), budget);
+      store.setStorage(storage);
+      store.setSummaryMetadata(new DefaultSummaryMetadata.Builder()
+            .axisOrder(Coords.T).build());
+
+      for (int t = 0; t < nrImages; t++) {
+         store.putImage(createImage(t));
+         // evicted up to the budget, plus at most a budget of unwritten images
+         Assert.assertTrue(storage.getRamBytes() <= 2 * budget + IMAGE_BYTES);
+      }
+      Assert.assertEquals(nrImages, store.getNumImages());
+      Assert.assertEquals(nrImages - 1, storage.getMaxIndex(Coords.T));
+
+      // Reads are transparent, whether the image is in RAM or spilled
+      for (int t : new int[] {0, 1, nrImages / 2, nrImages - 2, nrImages - 1}) {
+         checkPixels(store.getImage(Coordinates.builder().t(t).build()), t);
+      }
+      List<Image> matching = store.getImagesMatching(Coordinates.builder().t(17).build());
+      Assert.assertEquals(1, matching.size());
+      checkPixels(matching.get(0), 17);
+      Assert.assertNull(store.getImage(Coordinates.builder().t(nrImages).build()));
+
+      String path = storage.promote();
+      Assert.assertNull(path);
+      Assert.assertEquals(nrImages, spillStorage.getNumImages());
+      storage.close();
+   }
+
+   @Test
+   public void snapsStayWithinBudget() throws IOException {
+      snapsStayWithinBudget(500, 8 * IMAGE_BYTES);
+   }
+
+   /**
+    * Adds 10000 images, several times the test heap (256 MB), with a small
+    * RAM budget. Without spilling this runs out of memory. Not part of the
+    * default run.
+    */
+   @Ignore("Benchmark, run manually")
+   @Test
+   public void tenThousandSnapsStayWithinBudget() throws IOException {
+      snapsStayWithinBudget(10000, 16 * 1024 * 1024);
+   }
+
+   /**
+    * Putting an image at the same coords again replaces it, in RAM use too.
+    * DefaultDatastore refuses rewrites, so this goes to the storage directly,
+    * as rewritable datastores do.
+    */
+   @Test
+   public void replacedImagesAreCountedOnce() throws IOException {
+      SpillStorage spillStorage = new SpillStorage(0);
+      DefaultDatastore store = new DefaultDatastore(null);
+      StorageTiered storage = new StorageTiered(store, createSpill(spillStorage),
+            16 * IMAGE_BYTES);
+      store.setStorage(storage);
+
+      for (int i = 0; i < 10; i++) {
+         storage.putImage(createImage(3));
+      }
+      Assert.assertEquals(IMAGE_BYTES, storage.getRamBytes());
+      storage.promote();
+      Assert.assertEquals(IMAGE_BYTES, storage.getRamBytes());
+      Assert.assertEquals(1, storage.getNumImages());
+      checkPixels(storage.getImage(Coordinates.builder().t(3).build()), 3);
+      storage.close();
+   }
+
+   /**
+    * A slow spill store makes putImage wait, rather than let RAM use grow.
+    */
+   @Test
+   public void slowSpillAppliesBackPressure() throws IOException {
+      final long budget = 4 * IMAGE_BYTES;
+      SpillStorage spillStorage = new SpillStorage(2000000);
+      DefaultDatastore store = new DefaultDatastore(null);
+      StorageTiered storage = new StorageTiered(store, createSpill(spillStorage), budget);
+      store.setStorage(storage);
+
+      for (int t = 0; t < 50; t++) {
+         store.putImage(createImage(t));
+         Assert.assertTrue(storage.getRamBytes() <= 2 * budget + IMAGE_BYTES);
+      }
+      storage.promote();
+      Assert.assertEquals(50, spillStorage.getNumImages());
+      for (int t = 0; t < 50; t++) {
+         checkPixels(store.getImage(Coordinates.builder().t(t).build()), t);
+      }
+      storage.close();
+   }
+}
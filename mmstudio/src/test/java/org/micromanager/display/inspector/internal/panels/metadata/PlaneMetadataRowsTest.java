@@ -0,0 +1,189 @@
+package org.micromanager.display.inspector.internal.panels.metadata;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertFalse;
+import static org.junit.Assert.assertSame;
+import static org.junit.Assert.assertTrue;
+
+import java.util.Arrays;
+import java.util.Collections;
+import java.util.HashSet;
+import java.util.List;
+import java.util.Set;
+import org.junit.Ignore;
+import org.junit.Test;
+import org.micromanager.PropertyMap;
+import org.micromanager.PropertyMaps;
+
+public class PlaneMetadataRowsTest {
+   private static final int SCOPE_KEYS = 1900;
+   private static final int USER_KEYS = 90;
+
+   /**
+    * Builds the metadata of a plane with 2000 keys, of which the scope data
+    * values listed in changing have a value that depends on the frame.
+    */
+   private static PropertyMap createPlane(int frame, int[] changing) {
+      Set<Integer> changingSet = new HashSet<>();
+      for (int c : changing) {
+         changingSet.add(c);
+      }
+      PropertyMap.Builder scope = PropertyMaps.builder();
+      for (int i = 0; i < SCOPE_KEYS; i++) {
+         String value = changingSet.contains(i) ? "value " + frame : "constant " + i;
+         scope.putString(String.format("Device%03d-Property", i), value);
+      }
+      PropertyMap.Builder user = PropertyMaps.builder();
+      for (int i = 0; i < USER_KEYS; i++) {
+         user.putDouble("user" + i, i * 0.5);
+      }
+      PropertyMap.Builder plane = PropertyMaps.builder()
+            .putLong("ImageNumber", (long) frame)
+            .putDouble("ElapsedTime-ms", frame * 10.0)
+            .putString("Camera", "Camera")
+            .putDoubleList("PixelSizeAffine", 1.0, 0.0, 0.0, 0.0, 1.0, 0.0)
+            .putPropertyMap("ScopeData", scope.build())
+            .putPropertyMap("UserData", user.build());
+      for (int i = 0; i < 5; i++) {
+         plane.putInteger("Extra" + i, i);
+      }
+      return plane.build();
+   }
+
+   private static final int[] CHANGING = {0, 131, 262, 393, 524, 655, 786, 917, 1048, 1179};
+
+   @Test
+   public void firstPlaneHasNoChanges() {
+      PlaneMetadataRows rows = new PlaneMetadataRows();
+      PlaneMetadataRows.Update update = rows.update(createPlane(0, new int[0]));
+      assertEquals(SCOPE_KEYS + USER_KEYS + 9, update.getRows().size());
+      assertTrue(update.keysChanged());
+      assertTrue(update.getChangedKeys().isEmpty());
+      List<PlaneMetadataRows.Row> list = update.getRows();
+      for (int i = 1; i < list.size(); i++) {
+         assertTrue(list.get(i - 1).getKey().compareTo(list.get(i).getKey()) < 0);
+      }
+      assertEquals("constant 12", find(list, "device:Device012-Property").getValue());
+      assertEquals("1.0, 0.0, 0.0, 0.0, 1.0, 0.0",
+            find(list, "PixelSizeAffine").getValue());
+   }
+
+   private static PlaneMetadataRows.Row find(List<PlaneMetadataRows.Row> rows, String key) {
+      for (PlaneMetadataRows.Row row : rows) {
+         if (row.getKey().equals(key)) {
+            return row;
+         }
+      }
+      throw new AssertionError("No row " + key);
+   }
+
+   @Test
+   public void onlyChangedRowsAreReplaced() {
+      PlaneMetadataRows rows = new PlaneMetadataRows();
+      List<PlaneMetadataRows.Row> first = rows.update(createPlane(0, new int[] {3, 4})).getRows();
+      PlaneMetadataRows.Update update = rows.update(createPlane(1, new int[] {3, 4}));
+      assertFalse(update.keysChanged());
+      assertEquals(new HashSet<>(Arrays.asList("device:Device003-Property",
+            "device:Device004-Property", "ImageNumber", "ElapsedTime-ms")),
+            update.getChangedKeys());
+      List<PlaneMetadataRows.Row> second = update.getRows();
+      assertEquals(first.size(), second.size());
+      for (int i = 0; i < first.size(); i++) {
+         assertEquals(first.get(i).getKey(), second.get(i).getKey());
+         if (update.getChangedKeys().contains(first.get(i).getKey())) {
+            assertFalse(first.get(i) == second.get(i));
+         } else {
+            assertSame(first.get(i), second.get(i));
+         }
+      }
+      assertEquals("value 1", find(second, "device:Device003-Property").getValue());
+
+      // The constant-value filter comes out of the same diff
+      assertTrue(rows.hasChanged("device:Device003-Property"));
+      assertFalse(rows.hasChanged("device:Device005-Property"));
+      rows.update(createPlane(2, new int[] {5}));
+      assertTrue(rows.hasChanged("device:Device003-Property"));
+      assertTrue(rows.hasChanged("device:Device005-Property"));
+      assertFalse(rows.hasChanged("user:user1"));
+   }
+
+   @Test
+   public void addedAndRemovedKeysChangeStructure() {
+      PlaneMetadataRows rows = new PlaneMetadataRows();
+      rows.update(PropertyMaps.builder().putString("A", "1").putString("C", "3").build());
+      PlaneMetadataRows.Update update = rows.update(PropertyMaps.builder()
+            .putString("A", "1").putString("B", "2").build());
+      assertTrue(update.keysChanged());
+      assertEquals(Collections.singleton("B"), update.getChangedKeys());
+      assertEquals(2, update.getRows().size());
+      assertEquals("B", update.getRows().get(1).getKey());
+
+      rows.reset();
+      update = rows.update(null);
+      assertTrue(update.getRows().isEmpty());
+      assertTrue(rows.hasChanged("A"));
+   }
+
+   @Test
+   public void valuesAreFormattedLazily() {
+      PlaneMetadataRows rows = new PlaneMetadataRows();
+      List<PlaneMetadataRows.Row> list = rows.update(createPlane(0, CHANGING)).getRows();
+      for (PlaneMetadataRows.Row row : list) {
+         assertFalse(row.isFormatted());
+      }
+      // "Show" the first 20 rows; unchanged rows keep their formatted value
+      for (int i = 0; i < 20; i++) {
+         list.get(i).getValue();
+      }
+      PlaneMetadataRows.Update update = rows.update(createPlane(1, CHANGING));
+      for (int i = 0; i < update.getRows().size(); i++) {
+         PlaneMetadataRows.Row row = update.getRows().get(i);
+         boolean changed = update.getChangedKeys().contains(row.getKey());
+         assertEquals(i < 20 && !changed, row.isFormatted());
+      }
+   }
+
+   /**
+    * Diffs 2000-key metadata for the given number of frames, with 10 device
+    * properties and the frame counters changing every frame. Filtering and
+    * formatting of the visible rows, as done by the panel, are included.
+    */
+   private static void diffFrames(int frames) {
+      final int distinctPlanes = 50;
+      PropertyMap[] planes = new PropertyMap[distinctPlanes];
+      for (int i = 0; i < distinctPlanes; i++) {
+         planes[i] = createPlane(i, CHANGING);
+      }
+      PlaneMetadataRows rows = new PlaneMetadataRows();
+      int changedRows = 0;
+      for (int f = 0; f < frames; f++) {
+         PlaneMetadataRows.Update update = rows.update(planes[f % distinctPlanes]);
+         changedRows += update.getChangedKeys().size();
+         int shown = 0;
+         for (PlaneMetadataRows.Row row : update.getRows()) {
+            if (rows.hasChanged(row.getKey()) && row.keyContains("device")) {
+               if (shown++ < 30) {
+                  row.getValue();
+               }
+            }
+         }
+      }
+      // Every frame changes 10 scope values, ImageNumber and ElapsedTime-ms
+      assertEquals((frames - 1) * 12, changedRows);
+   }
+
+   @Test
+   public void everyFrameReportsItsChangedKeys() {
+      diffFrames(100);
+   }
+
+   /**
+    * Benchmark with 10 seconds worth of frames at 100 frames per second;
+    * not part of the default run.
+    */
+   @Ignore("Benchmark, run manually")
+   @Test
+   public void keepsUpWithHundredFramesPerSecond() {
+      diffFrames(1000);
+   }
+}
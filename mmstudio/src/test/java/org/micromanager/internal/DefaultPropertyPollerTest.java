@@ -0,0 +1,218 @@
+package org.micromanager.internal;
+
+import java.util.ArrayList;
+import java.util.HashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicBoolean;
+import javax.swing.SwingUtilities;
+import org.junit.Assert;
+import org.junit.Test;
+import org.micromanager.PropertyPoller;
+
+public class DefaultPropertyPollerTest {
+
+   /**
+    * Stand-in for the Core, counting the calls made to it.
+    */
+   private static final class MockCore implements DefaultPropertyPoller.Hardware {
+      private final Map<String, Integer> reads_ = new HashMap<>();
+      private final Map<String, Integer> busyChecks_ = new HashMap<>();
+      private final long[] clock_;
+      private long busyUntilMs_ = Long.MIN_VALUE;
+      private boolean acquisitionRunning_ = false;
+      private String failingProperty_ = null;
+
+      MockCore(long[] clock) {
+         clock_ = clock;
+      }
+
+      @Override
+      public synchronized String getProperty(String device, String property) throws Exception {
+         reads_.merge(device + "-" + property, 1, Integer::sum);
+         if (property.equals(failingProperty_)) {
+            throw new Exception("No response from " + device);
+         }
+         return device + "-" + property + "@" + clock_[0];
+      }
+
+      @Override
+      public synchronized boolean isBusy(String device) {
+         busyChecks_.merge(device, 1, Integer::sum);
+         return clock_[0] < busyUntilMs_;
+      }
+
+      @Override
+      public boolean isAcquisitionRunning() {
+         return acquisitionRunning_;
+      }
+
+      synchronized int getReads(String device, String property) {
+         return reads_.getOrDefault(device + "-" + property, 0);
+      }
+
+      synchronized int getBusyChecks(String device) {
+         return busyChecks_.getOrDefault(device, 0);
+      }
+   }
+
+   private static final class Recorder implements PropertyPoller.Listener {
+      private final List<PropertyPoller.Value> values_ = new ArrayList<>();
+
+      @Override
+      public synchronized void propertyPolled(PropertyPoller.Value value) {
+         values_.add(value);
+      }
+
+      synchronized List<PropertyPoller.Value> getValues() {
+         return new ArrayList<>(values_);
+      }
+   }
+
+   private static void runUntil(DefaultPropertyPoller poller, long[] clock, long endMs) {
+      for (; clock[0] <= endMs; clock[0] += 5) {
+         poller.pollDue();
+      }
+   }
+
+   @Test
+   public void readsAreCoalescedPerDevice() {
+      long[] clock = {0};
+      MockCore core = new MockCore(clock);
+      DefaultPropertyPoller poller = new DefaultPropertyPoller(core, () -> clock[0], false);
+      Recorder a = new Recorder();
+      Recorder b = new Recorder();
+      Recorder c = new Recorder();
+      Recorder d = new Recorder();
+      Recorder e = new Recorder();
+      poller.subscribe("Focus", "Offset", 100, a);
+      poller.subscribe("Focus", "Offset", 100, b);
+      poller.subscribe("Focus", "SNR", 100, c);
+      poller.subscribe("Stage", "Offset", 100, d);
+      // Due a little later, within the batching window
+      poller.subscribe("Focus", "Offset", 100, e).postpone(20);
+
+      poller.pollDue();
+      Assert.assertEquals(1, core.getReads("Focus", "Offset"));
+      Assert.assertEquals(1, core.getReads("Focus", "SNR"));
+      Assert.assertEquals(1, core.getReads("Stage", "Offset"));
+      Assert.assertEquals(1, core.getBusyChecks("Focus"));
+      Assert.assertEquals(1, core.getBusyChecks("Stage"));
+      Assert.assertEquals(1, a.getValues().size());
+      Assert.assertSame(a.getValues().get(0), b.getValues().get(0));
+      Assert.assertSame(a.getValues().get(0), e.getValues().get(0));
+      Assert.assertEquals("Focus-Offset@0", a.getValues().get(0).getValue());
+      Assert.assertEquals("Focus-SNR@0", c.getValues().get(0).getValue());
+      Assert.assertEquals("Stage-Offset@0", d.getValues().get(0).getValue());
+
+      // Nothing more until the period has elapsed
+      clock[0] = 60;
+      poller.pollDue();
+      Assert.assertEquals(1, core.getReads("Focus", "Offset"));
+      Assert.assertEquals(100, poller.getNextDueMs());
+   }
+
+   @Test
+   public void readsAreRateLimited() {
+      long[] clock = {0};
+      MockCore core = new MockCore(clock);
+      DefaultPropertyPoller poller = new DefaultPropertyPoller(core, () -> clock[0], false);
+      Recorder fast = new Recorder();
+      Recorder shifted = new Recorder();
+      poller.subscribe("Focus", "Offset", 10, fast);
+      poller.subscribe("Focus", "Offset", 60, shifted).postpone(30);
+
+      runUntil(poller, clock, 1000);
+      long maxReads = 1000 / PropertyPoller.MIN_PERIOD_MS + 1;
+      Assert.assertTrue(core.getReads("Focus", "Offset") <= maxReads);
+      Assert.assertTrue(core.getReads("Focus", "Offset") >= maxReads - 2);
+      Assert.assertTrue(fast.getValues().size() <= maxReads);
+      // The shifted subscription never causes a read within the minimum period
+      List<PropertyPoller.Value> values = fast.getValues();
+      for (int i = 1; i < values.size(); i++) {
+         Assert.assertNotSame(values.get(i - 1), values.get(i));
+      }
+      Assert.assertTrue(shifted.getValues().size() >= 1000 / 60 - 1);
+   }
+
+   @Test
+   public void busyDeviceIsBackedOff() {
+      long[] clock = {0};
+      MockCore core = new MockCore(clock);
+      core.busyUntilMs_ = 1000;
+      DefaultPropertyPoller poller = new DefaultPropertyPoller(core, () -> clock[0], false);
+      Recorder recorder = new Recorder();
+      poller.subscribe("Focus", "Offset", 100, recorder);
+
+      runUntil(poller, clock, 995);
+      // Checked at 0, 200 and 600; next at 1400
+      Assert.assertEquals(0, core.getReads("Focus", "Offset"));
+      Assert.assertEquals(3, core.getBusyChecks("Focus"));
+      Assert.assertTrue(recorder.getValues().isEmpty());
+
+      runUntil(poller, clock, 1595);
+      // Back to the normal period once not busy
+      Assert.assertEquals(2, core.getReads("Focus", "Offset"));
+      Assert.assertEquals(2, recorder.getValues().size());
+   }
+
+   @Test
+   public void acquisitionSlowsPolling() {
+      long[] clock = {0};
+      MockCore core = new MockCore(clock);
+      core.acquisitionRunning_ = true;
+      DefaultPropertyPoller poller = new DefaultPropertyPoller(core, () -> clock[0], false);
+      Recorder recorder = new Recorder();
+      poller.subscribe("Focus", "Offset", 100, recorder);
+
+      runUntil(poller, clock, 1995);
+      Assert.assertEquals(5, core.getReads("Focus", "Offset"));
+
+      core.acquisitionRunning_ = false;
+      runUntil(poller, clock, 2995);
+      Assert.assertEquals(15, core.getReads("Focus", "Offset"));
+   }
+
+   @Test
+   public void errorsAndCancel() {
+      long[] clock = {0};
+      MockCore core = new MockCore(clock);
+      core.failingProperty_ = "SNR";
+      DefaultPropertyPoller poller = new DefaultPropertyPoller(core, () -> clock[0], false);
+      Recorder recorder = new Recorder();
+      PropertyPoller.Subscription subscription =
+            poller.subscribe("Focus", "SNR", 100, recorder);
+
+      poller.pollDue();
+      PropertyPoller.Value value = recorder.getValues().get(0);
+      Assert.assertNull(value.getValue());
+      Assert.assertNotNull(value.getError());
+      Assert.assertEquals("Focus", value.getDevice());
+      Assert.assertEquals("SNR", value.getProperty());
+
+      subscription.cancel();
+      Assert.assertEquals(Long.MAX_VALUE, poller.getNextDueMs());
+      runUntil(poller, clock, 500);
+      Assert.assertEquals(1, recorder.getValues().size());
+      Assert.assertEquals(1, core.getReads("Focus", "SNR"));
+   }
+
+   @Test
+   public void listenersAreCalledOffTheEdt() throws InterruptedException {
+      long[] clock = {0};
+      MockCore core = new MockCore(clock);
+      DefaultPropertyPoller poller = new DefaultPropertyPoller(core,
+            () -> System.nanoTime() / 1000000L, true);
+      CountDownLatch latch = new CountDownLatch(3);
+      AtomicBoolean onEdt = new AtomicBoolean(false);
+      poller.subscribe("Focus", "Offset", 50, value -> {
+         onEdt.compareAndSet(false, SwingUtilities.isEventDispatchThread());
+         latch.countDown();
+      });
+      Assert.assertTrue(latch.await(5, TimeUnit.SECONDS));
+      Assert.assertFalse(onEdt.get());
+      poller.shutdown();
+   }
+}
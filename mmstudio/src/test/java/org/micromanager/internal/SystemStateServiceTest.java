@@ -0,0 +1,222 @@
+package org.micromanager.internal;
+
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.Collections;
+import java.util.HashMap;
+import java.util.HashSet;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.Set;
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicInteger;
+import javax.swing.SwingUtilities;
+import org.junit.After;
+import org.junit.Assert;
+import org.junit.Test;
+
+public class SystemStateServiceTest {
+
+   /**
+    * Stand-in for the Core, with a slow system state cache update.
+    */
+   private static final class MockCore implements SystemStateService.StateSource {
+      private final long latencyMs_;
+      private final Map<String, Set<String>> groups_ = new LinkedHashMap<>();
+      private final Map<String, String> configs_ = new HashMap<>();
+      private final Map<String, String> cache_ = new HashMap<>();
+      private final Map<String, Integer> reads_ = new HashMap<>();
+      private int updates_ = 0;
+
+      MockCore(long latencyMs) {
+         latencyMs_ = latencyMs;
+         groups_.put("Channel", new HashSet<>(Arrays.asList(
+               SystemStateService.key("Dichroic", "Label"),
+               SystemStateService.key("Emission", "Label"))));
+         groups_.put("Objective", Collections.singleton(
+               SystemStateService.key("Nosepiece", "Label")));
+         groups_.put("Power", Collections.singleton(
+               SystemStateService.key("Laser-1", "Power")));
+         configs_.put("Channel", "DAPI");
+         configs_.put("Objective", "10x");
+         configs_.put("Power", "");
+         cache_.put(SystemStateService.key("Laser-1", "Power"), "1.5");
+      }
+
+      @Override
+      public void updateSystemStateCache() throws Exception {
+         Thread.sleep(latencyMs_);
+         synchronized (this) {
+            updates_++;
+         }
+      }
+
+      @Override
+      public synchronized List<String> getConfigGroups() {
+         return new ArrayList<>(groups_.keySet());
+      }
+
+      @Override
+      public synchronized Set<String> getGroupProperties(String group) {
+         return groups_.get(group);
+      }
+
+      @Override
+      public synchronized String getCurrentConfigFromCache(String group) {
+         reads_.merge(group, 1, Integer::sum);
+         return configs_.get(group);
+      }
+
+      @Override
+      public synchronized String getPropertyFromCache(String device, String property) {
+         return cache_.get(SystemStateService.key(device, property));
+      }
+
+      synchronized void setConfig(String group, String config) {
+         configs_.put(group, config);
+      }
+
+      synchronized void setCachedProperty(String device, String property, String value) {
+         cache_.put(SystemStateService.key(device, property), value);
+      }
+
+      synchronized int getUpdates() {
+         return updates_;
+      }
+
+      synchronized int getReads(String group) {
+         return reads_.getOrDefault(group, 0);
+      }
+
+      synchronized void resetReads() {
+         reads_.clear();
+      }
+   }
+
+   private final ExecutorService executor_ = Executors.newSingleThreadExecutor();
+   private final List<Map<String, String>> changes_ = new ArrayList<>();
+   private volatile boolean offEdt_ = false;
+
+   private SystemStateService create(MockCore core) {
+      SystemStateService service = new SystemStateService(core, executor_);
+      service.addListener(configs -> {
+         offEdt_ |= !SwingUtilities.isEventDispatchThread();
+         changes_.add(configs);
+      });
+      return service;
+   }
+
+   // Waits for the background thread, and then for what it posted to the EDT
+   private void awaitIdle() throws Exception {
+      executor_.submit(() -> { }).get(10, TimeUnit.SECONDS);
+      SwingUtilities.invokeAndWait(() -> { });
+   }
+
+   @After
+   public void tearDown() {
+      executor_.shutdownNow();
+   }
+
+   @Test
+   public void refreshDoesNotBlockTheEdt() throws Exception {
+      MockCore core = new MockCore(500);
+      SystemStateService service = create(core);
+      final CountDownLatch refreshed = new CountDownLatch(1);
+      final AtomicInteger callbacksOffEdt = new AtomicInteger();
+      long start = System.nanoTime();
+      SwingUtilities.invokeAndWait(() -> service.refresh(() -> {
+         if (!SwingUtilities.isEventDispatchThread()) {
+            callbacksOffEdt.incrementAndGet();
+         }
+         refreshed.countDown();
+      }));
+      long requestMs = (System.nanoTime() - start) / 1000000;
+      Assert.assertTrue(String.valueOf(requestMs), requestMs < 100);
+
+      // The EDT keeps responding while the hardware is being read
+      long maxMs = 0;
+      int rounds = 0;
+      while (refreshed.getCount() > 0) {
+         long roundStart = System.nanoTime();
+         SwingUtilities.invokeAndWait(() -> { });
+         maxMs = Math.max(maxMs, (System.nanoTime() - roundStart) / 1000000);
+         rounds++;
+         Thread.sleep(10);
+      }
+      Assert.assertTrue(rounds > 10);
+      Assert.assertTrue(String.valueOf(maxMs), maxMs < 100);
+      Assert.assertEquals(0, callbacksOffEdt.get());
+      Assert.assertFalse(offEdt_);
+      Assert.assertEquals(1, changes_.size());
+      Assert.assertEquals(3, changes_.get(0).size());
+      Assert.assertEquals("DAPI", service.getConfigs().get("Channel"));
+   }
+
+   @Test
+   public void onlyChangedGroupsArePushed() throws Exception {
+      MockCore core = new MockCore(10);
+      SystemStateService service = create(core);
+      service.refresh(null);
+      awaitIdle();
+      changes_.clear();
+
+      core.setConfig("Channel", "GFP");
+      service.refresh(null);
+      awaitIdle();
+      Assert.assertEquals(1, changes_.size());
+      Assert.assertEquals(Collections.singletonMap("Channel", "GFP"), changes_.get(0));
+
+      // Nothing changed, so nothing is pushed
+      service.refresh(null);
+      awaitIdle();
+      Assert.assertEquals(1, changes_.size());
+      Assert.assertEquals("10x", service.getConfigs().get("Objective"));
+   }
+
+   @Test
+   public void propertyChangesReadOnlyTheirGroupsFromTheCache() throws Exception {
+      MockCore core = new MockCore(10);
+      SystemStateService service = create(core);
+      service.refresh(null);
+      awaitIdle();
+      changes_.clear();
+      core.resetReads();
+
+      // The preset stays empty, but the value of the single property changed
+      core.setCachedProperty("Laser-1", "Power", "2.5");
+      service.propertyChanged("Laser-1", "Power");
+      awaitIdle();
+      Assert.assertEquals(1, core.getUpdates());
+      Assert.assertEquals(1, core.getReads("Power"));
+      Assert.assertEquals(0, core.getReads("Channel"));
+      Assert.assertEquals(Collections.singletonList(Collections.singletonMap("Power", "")),
+            changes_);
+
+      core.setConfig("Channel", "Cy5");
+      service.propertyChanged("Emission", "Label");
+      service.propertyChanged("Camera", "Binning");
+      awaitIdle();
+      Assert.assertEquals(1, core.getReads("Channel"));
+      Assert.assertEquals(0, core.getReads("Objective"));
+      Assert.assertEquals("Cy5", service.getConfigs().get("Channel"));
+   }
+
+   @Test
+   public void requestsWhileBusyAreCombined() throws Exception {
+      MockCore core = new MockCore(200);
+      SystemStateService service = create(core);
+      final CountDownLatch refreshed = new CountDownLatch(5);
+      for (int i = 0; i < 5; i++) {
+         service.refresh(refreshed::countDown);
+         service.propertyChanged("Dichroic", "Label");
+         Thread.sleep(20);
+      }
+      Assert.assertTrue(refreshed.await(10, TimeUnit.SECONDS));
+      awaitIdle();
+      Assert.assertEquals(2, core.getUpdates());
+   }
+}
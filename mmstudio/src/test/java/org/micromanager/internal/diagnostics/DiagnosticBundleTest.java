@@ -0,0 +1,220 @@
+package org.micromanager.internal.diagnostics;
+
+import java.io.ByteArrayInputStream;
+import java.io.ByteArrayOutputStream;
+import java.io.File;
+import java.io.IOException;
+import java.io.InputStream;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.util.Base64;
+import java.util.LinkedHashMap;
+import java.util.Map;
+import java.util.Random;
+import java.util.zip.ZipEntry;
+import java.util.zip.ZipInputStream;
+import org.junit.Assert;
+import org.junit.Rule;
+import org.junit.Test;
+import org.junit.rules.TemporaryFolder;
+
+public class DiagnosticBundleTest {
+   @Rule
+   public TemporaryFolder folder_ = new TemporaryFolder();
+
+   private static Map<String, String> unzip(byte[] archive) throws IOException {
+      Map<String, String> entries = new LinkedHashMap<>();
+      try (ZipInputStream zip = new ZipInputStream(new ByteArrayInputStream(archive))) {
+         ZipEntry entry;
+         while ((entry = zip.getNextEntry()) != null) {
+            entries.put(entry.getName(), read(zip));
+         }
+      }
+      return entries;
+   }
+
+   private static String read(InputStream in) throws IOException {
+      ByteArrayOutputStream out = new ByteArrayOutputStream();
+      byte[] buffer = new byte[8192];
+      int n;
+      while ((n = in.read(buffer)) > 0) {
+         out.write(buffer, 0, n);
+      }
+      return new String(out.toByteArray(), StandardCharsets.UTF_8);
+   }
+
+   private static byte[] write(DiagnosticBundle bundle) throws IOException {
+      ByteArrayOutputStream out = new ByteArrayOutputStream();
+      bundle.write(out, "test");
+      return out.toByteArray();
+   }
+
+   private static Redactor redactor() {
+      Redactor redactor = new Redactor();
+      redactor.addRule("(/home/)[^/\\s\"]+", "$1<user>");
+      return redactor;
+   }
+
+   @Test
+   public void archiveHoldsEntriesAndManifest() throws Exception {
+      File config = folder_.newFile("MMConfig.cfg");
+      Files.write(config.toPath(), "Device,Camera,DemoCamera,DCam\n"
+            .getBytes(StandardCharsets.UTF_8));
+      DiagnosticBundle bundle = new DiagnosticBundle(1 << 20, 1 << 20, redactor());
+      bundle.addText("SystemInfo.txt", () -> "Java 1.8\nLoaded /home/alice/MMConfig.cfg\n");
+      bundle.addFile("Config.cfg", config, false);
+      bundle.add("Failing.txt", (out, max) -> {
+         out.write("partial\n");
+         throw new IOException("device not responding");
+      });
+      // Redaction sees whole lines, even when written a character at a time
+      bundle.add("Split.txt", (out, max) -> {
+         for (char c : "path=/home/bob/x\n".toCharArray()) {
+            out.write(c);
+         }
+      });
+
+      Map<String, String> entries = unzip(write(bundle));
+      Assert.assertEquals(5, entries.size());
+      Assert.assertEquals("Java 1.8\nLoaded /home/<user>/MMConfig.cfg\n",
+            entries.get("SystemInfo.txt"));
+      Assert.assertEquals("Device,Camera,DemoCamera,DCam\n", entries.get("Config.cfg"));
+      Assert.assertTrue(entries.get("Failing.txt").startsWith("partial\n\n[Failed: "));
+      Assert.assertEquals("path=/home/<user>/x\n", entries.get("Split.txt"));
+      String manifest = entries.get(DiagnosticBundle.MANIFEST_NAME);
+      Assert.assertTrue(manifest.contains("Reason: test"));
+      Assert.assertTrue(manifest.contains("Failing.txt: "));
+      Assert.assertTrue(manifest.contains("failed: java.io.IOException: device not responding"));
+   }
+
+   @Test
+   public void largeEntriesAreTruncatedAndLogsKeepTheirEnd() throws Exception {
+      File log = folder_.newFile("CoreLog.txt");
+      StringBuilder sb = new StringBuilder();
+      for (int i = 0; i < 10000; i++) {
+         sb.append("line ").append(i).append('\n');
+      }
+      Files.write(log.toPath(), sb.toString().getBytes(StandardCharsets.UTF_8));
+      DiagnosticBundle bundle = new DiagnosticBundle(1000, 1 << 20, redactor());
+      bundle.addFile("logs/CoreLog.txt", log, true);
+      bundle.addFile("Head.txt", log, false);
+      bundle.addText("Long.txt", () -> new String(new char[5000]).replace('\0', 'x'));
+
+      Map<String, String> entries = unzip(write(bundle));
+      String tail = entries.get("logs/CoreLog.txt");
+      Assert.assertTrue(tail.length() <= 1000);
+      Assert.assertTrue(tail.startsWith("[Beginning of file left out]\nline "));
+      Assert.assertTrue(tail.endsWith("line 9999\n"));
+      String head = entries.get("Head.txt");
+      Assert.assertTrue(head.length() <= 1000);
+      Assert.assertTrue(head.startsWith("line 0\nline 1\n"));
+      Assert.assertEquals(1000, entries.get("Long.txt").length());
+      Assert.assertTrue(entries.get(DiagnosticBundle.MANIFEST_NAME)
+            .contains("Long.txt: 1000 bytes, truncated"));
+   }
+
+   @Test
+   public void archiveStaysUnderItsMaximumSize() throws Exception {
+      final Random random = new Random(1);
+      long maxArchive = 200 * 1024;
+      DiagnosticBundle bundle = new DiagnosticBundle(100 * 1024, maxArchive, redactor());
+      for (int i = 0; i < 10; i++) {
+         // Random text hardly compresses
+         bundle.add("Noise" + i + ".txt", (out, max) -> {
+            byte[] bytes = new byte[60];
+            for (int line = 0; line < 2000; line++) {
+               random.nextBytes(bytes);
+               out.write(Base64.getEncoder().encodeToString(bytes) + "\n");
+            }
+         });
+      }
+      byte[] archive = write(bundle);
+      Assert.assertTrue(String.valueOf(archive.length), archive.length <= maxArchive);
+      Assert.assertTrue(archive.length > maxArchive / 2);
+
+      Map<String, String> entries = unzip(archive);
+      String manifest = entries.get(DiagnosticBundle.MANIFEST_NAME);
+      Assert.assertTrue(manifest.contains("Noise0.txt: "));
+      Assert.assertTrue(manifest.contains("Noise9.txt: left out, archive full"));
+      Assert.assertFalse(entries.containsKey("Noise9.txt"));
+   }
+
+   @Test
+   public void monitorWritesOneBundlePerTrigger() throws Exception {
+      final long[] clock = {1000000};
+      final long[] lag = {0};
+      final boolean[] overflowed = {false};
+      final long[] exceptions = {0};
+      DiagnosticBundleMonitor.Probes probes = new DiagnosticBundleMonitor.Probes() {
+         @Override
+         public long getEDTLagMs() {
+            return lag[0];
+         }
+
+         @Override
+         public boolean isBufferOverflowed() {
+            return overflowed[0];
+         }
+
+         @Override
+         public long getExceptionCount() {
+            return exceptions[0];
+         }
+      };
+      DiagnosticBundleMonitor.Settings settings = new DiagnosticBundleMonitor.Settings();
+      settings.periodMs = 3600000;
+      settings.hangMs = 5000;
+      settings.burstExceptions = 5;
+      settings.burstWindowMs = 10000;
+      settings.minIntervalMs = 60000;
+      settings.maxBundles = 3;
+      File directory = folder_.newFolder("bundles");
+      DiagnosticBundleMonitor monitor = new DiagnosticBundleMonitor(probes, () -> {
+         DiagnosticBundle bundle = new DiagnosticBundle(1024, 64 * 1024, redactor());
+         bundle.addText("Clock.txt", () -> String.valueOf(clock[0]));
+         return bundle;
+      }, directory, settings, () -> clock[0]);
+
+      monitor.check();
+      Assert.assertEquals(0, directory.list().length);
+
+      // A hang gives one bundle, however long it lasts
+      lag[0] = 6000;
+      monitor.check();
+      clock[0] += 1000;
+      monitor.check();
+      Assert.assertEquals(1, directory.list().length);
+      Assert.assertTrue(directory.list()[0].contains("EDT-hang"));
+
+      // Too soon after the hang
+      lag[0] = 0;
+      clock[0] += 1000;
+      overflowed[0] = true;
+      monitor.check();
+      Assert.assertEquals(1, directory.list().length);
+
+      // Exceptions spread out are not a burst
+      for (int i = 0; i < 10; i++) {
+         clock[0] += 60000;
+         exceptions[0]++;
+         monitor.check();
+      }
+      Assert.assertEquals(1, directory.list().length);
+      clock[0] += 1000;
+      exceptions[0] += 5;
+      monitor.check();
+      Assert.assertEquals(2, directory.list().length);
+
+      // Periodic bundles; only the last three are kept
+      for (int i = 0; i < 3; i++) {
+         clock[0] += 3600000;
+         monitor.check();
+      }
+      String[] names = directory.list();
+      Assert.assertEquals(3, names.length);
+      for (String name : names) {
+         Assert.assertTrue(name, name.startsWith(DiagnosticBundleMonitor.FILE_PREFIX));
+         Assert.assertTrue(name, name.contains("periodic"));
+      }
+   }
+}
@@ -0,0 +1,114 @@
+package org.micromanager.internal.diagnostics;
+
+import java.awt.EventQueue;
+import java.io.StringWriter;
+import java.util.Map;
+import org.junit.Assert;
+import org.junit.Test;
+
+public class EDTStallProfilerTest {
+
+   private static void sleep(long ms) {
+      try {
+         Thread.sleep(ms);
+      } catch (InterruptedException e) {
+         Thread.currentThread().interrupt();
+      }
+   }
+
+   private static void blockFor(long ms) {
+      sleep(ms);
+   }
+
+   private static final class SlowTask implements Runnable {
+      @Override
+      public void run() {
+         blockFor(400);
+      }
+   }
+
+   // Waits until the profiler has seen the end of all stalls
+   private static void settle() throws Exception {
+      EventQueue.invokeAndWait(() -> { });
+      sleep(100);
+      EventQueue.invokeAndWait(() -> { });
+   }
+
+   private static StackTraceElement frame(String className, String method) {
+      return new StackTraceElement(className, method, null, -1);
+   }
+
+   @Test
+   public void attributesToFirstApplicationFrame() {
+      StackTraceElement[] trace = {
+            frame("java.lang.Thread", "sleep"),
+            frame("org.example.Slow", "compute"),
+            frame("org.example.Slow$1", "run"),
+            frame("java.awt.event.InvocationEvent", "dispatch"),
+            frame("java.awt.EventQueue", "dispatchEventImpl"),
+            frame("java.awt.EventDispatchThread", "run"),
+      };
+      Assert.assertEquals("InvocationEvent: org.example.Slow$1.run",
+            EDTStallProfiler.attribute(trace));
+      Assert.assertEquals("java.awt.EventDispatchThread.run;"
+                  + "java.awt.EventQueue.dispatchEventImpl;"
+                  + "java.awt.event.InvocationEvent.dispatch;org.example.Slow$1.run;"
+                  + "org.example.Slow.compute;java.lang.Thread.sleep",
+            EDTStallProfiler.collapse(trace));
+
+      StackTraceElement[] platformOnly = {
+            frame("javax.swing.RepaintManager", "paint"),
+            frame("java.awt.Component", "dispatchEvent"),
+            frame("java.awt.EventQueue", "dispatchEventImpl"),
+      };
+      Assert.assertEquals("Component: java.awt.Component.dispatchEvent",
+            EDTStallProfiler.attribute(platformOnly));
+      Assert.assertEquals(EDTStallProfiler.OUTSIDE_DISPATCH,
+            EDTStallProfiler.attribute(new StackTraceElement[] {
+                  frame("org.example.Worker", "run")}));
+   }
+
+   @Test
+   public void blockingRunnablesAreProfiled() throws Exception {
+      EDTStallProfiler profiler = new EDTStallProfiler(100, 200, 0.05);
+      try {
+         // Let the heartbeat find the EDT
+         sleep(100);
+         settle();
+         // Short events are not stalls
+         for (int i = 0; i < 20; i++) {
+            EventQueue.invokeAndWait(() -> sleep(5));
+         }
+         settle();
+         Assert.assertEquals(0, profiler.getStallCount());
+         Assert.assertEquals(0, profiler.getSampleCount());
+
+         EventQueue.invokeAndWait(new SlowTask());
+         EventQueue.invokeAndWait(new SlowTask());
+         settle();
+
+         Assert.assertEquals(2, profiler.getStallCount());
+         // About 300 ms past the threshold each, at 200 Hz
+         Assert.assertTrue(profiler.getSampleCount() > 20);
+         Map<String, Integer> causes = profiler.getStallsByCause();
+         Assert.assertEquals(Integer.valueOf(2), causes.get(
+               "InvocationEvent: " + SlowTask.class.getName() + ".run"));
+
+         StringWriter stacks = new StringWriter();
+         profiler.writeCollapsedStacks(stacks);
+         String top = stacks.toString().split("\n")[0];
+         Assert.assertTrue(top, top.contains(SlowTask.class.getName() + ".run;"
+               + EDTStallProfilerTest.class.getName() + ".blockFor;"));
+         Assert.assertTrue(top, top.matches(".* \\d+"));
+
+         String report = profiler.getReport();
+         Assert.assertTrue(report, report.contains("2 stalls"));
+         Assert.assertTrue(report, report.contains(SlowTask.class.getName()));
+
+         Assert.assertTrue("Overhead " + profiler.getOverhead(),
+               profiler.getOverhead() < 0.05);
+      } finally {
+         profiler.stop();
+      }
+   }
+}
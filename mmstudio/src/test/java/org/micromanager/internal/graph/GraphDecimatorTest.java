@@ -0,0 +1,271 @@
+package org.micromanager.internal.graph;
+
+import java.awt.Color;
+import java.awt.image.BufferedImage;
+import java.util.Random;
+import org.junit.Assert;
+import org.junit.Ignore;
+import org.junit.Test;
+
+public class GraphDecimatorTest {
+
+   private static final class ArrayPoints implements GraphDecimator.Points {
+      private final double[] xs_;
+      private final double[] ys_;
+
+      ArrayPoints(double[] xs, double[] ys) {
+         xs_ = xs;
+         ys_ = ys;
+      }
+
+      @Override
+      public int size() {
+         return xs_.length;
+      }
+
+      @Override
+      public double getX(int index) {
+         return xs_[index];
+      }
+
+      @Override
+      public double getY(int index) {
+         return ys_[index];
+      }
+   }
+
+   // Deterministic noisy signal, computed rather than stored
+   private static final class SyntheticPoints implements GraphDecimator.Points {
+      private final int size_;
+
+      SyntheticPoints(int size) {
+         size_ = size;
+      }
+
+      @Override
+      public int size() {
+         return size_;
+      }
+
+      @Override
+      public double getX(int index) {
+         return index;
+      }
+
+      @Override
+      public double getY(int index) {
+         return Math.sin(index * 1e-5) + ((index * 2654435761L) & 1023) / 4096.0;
+      }
+   }
+
+   private static ArrayPoints randomWalk(int size, long seed) {
+      Random random = new Random(seed);
+      double[] xs = new double[size];
+      double[] ys = new double[size];
+      for (int i = 1; i < size; i++) {
+         xs[i] = xs[i - 1] + random.nextDouble();
+         ys[i] = ys[i - 1] + random.nextGaussian();
+      }
+      return new ArrayPoints(xs, ys);
+   }
+
+   private static int columnOf(double x, double xMin, double xMax, int columns) {
+      int c = (int) Math.floor((x - xMin) * columns / (xMax - xMin));
+      return Math.max(0, Math.min(columns - 1, c));
+   }
+
+   // First, last, min and max Y of each column
+   private static double[][] columnStats(GraphDecimator.Points points, int size,
+                                         double xMin, double xMax, int columns) {
+      double[][] stats = new double[columns][];
+      for (int i = 0; i < size; i++) {
+         double y = points.getY(i);
+         int c = columnOf(points.getX(i), xMin, xMax, columns);
+         if (stats[c] == null) {
+            stats[c] = new double[] {y, y, y, y};
+         } else {
+            stats[c][1] = y;
+            stats[c][2] = Math.min(stats[c][2], y);
+            stats[c][3] = Math.max(stats[c][3], y);
+         }
+      }
+      return stats;
+   }
+
+   private static GraphDecimator.Points toPoints(final GraphDecimator.Result result) {
+      return new GraphDecimator.Points() {
+         @Override
+         public int size() {
+            return result.size();
+         }
+
+         @Override
+         public double getX(int index) {
+            return result.getX(index);
+         }
+
+         @Override
+         public double getY(int index) {
+            return result.getY(index);
+         }
+      };
+   }
+
+   @Test
+   public void decimationKeepsColumnExtremes() {
+      ArrayPoints points = randomWalk(100000, 1);
+      double xMin = 0.0;
+      double xMax = points.getX(points.size() - 1);
+      int columns = 300;
+      GraphDecimator.Result result = GraphDecimator.decimate(points, 0, points.size(),
+            xMin, xMax, columns);
+      Assert.assertTrue(result.size() <= 4 * columns);
+      for (int i = 1; i < result.size(); i++) {
+         Assert.assertTrue(result.getX(i) >= result.getX(i - 1));
+      }
+      double[][] expected = columnStats(points, points.size(), xMin, xMax, columns);
+      double[][] actual = columnStats(toPoints(result), result.size(), xMin, xMax, columns);
+      for (int c = 0; c < columns; c++) {
+         Assert.assertArrayEquals("Column " + c, expected[c], actual[c], 0.0);
+      }
+   }
+
+   @Test
+   public void sparsePointsAreKept() {
+      ArrayPoints points = randomWalk(50, 2);
+      GraphDecimator.Result result = GraphDecimator.decimate(points, 0, points.size(),
+            0.0, points.getX(49) + 1.0, 10000);
+      Assert.assertEquals(50, result.size());
+      for (int i = 0; i < 50; i++) {
+         Assert.assertEquals(points.getX(i), result.getX(i), 0.0);
+         Assert.assertEquals(points.getY(i), result.getY(i), 0.0);
+      }
+   }
+
+   @Test
+   public void pointsOutsideTheRangeGoToTheEdges() {
+      double[] xs = {-5, -4, 0, 5, 9, 12, 15};
+      double[] ys = {3, -7, 1, 2, 4, 8, -1};
+      GraphDecimator.Result result = GraphDecimator.decimate(new ArrayPoints(xs, ys),
+            0, xs.length, 0.0, 10.0, 2);
+      // Column 0: -5, -4, 0 (first, min, last); column 1: 5, 12 (max), 15
+      Assert.assertEquals(6, result.size());
+      Assert.assertEquals(-7, result.getY(1), 0.0);
+      Assert.assertEquals(8, result.getY(4), 0.0);
+      Assert.assertEquals(15, result.getX(5), 0.0);
+   }
+
+   private static GraphData.Bounds bounds(GraphData data, double xMax, double yMin,
+                                          double yMax) {
+      GraphData.Bounds bounds = data.new Bounds();
+      bounds.xMax = xMax;
+      bounds.yMin = yMin;
+      bounds.yMax = yMax;
+      return bounds;
+   }
+
+   // Topmost and bottommost opaque row of each column
+   private static int[][] columnExtents(BufferedImage image) {
+      int[][] extents = new int[image.getWidth()][];
+      for (int x = 0; x < image.getWidth(); x++) {
+         for (int y = 0; y < image.getHeight(); y++) {
+            if ((image.getRGB(x, y) >>> 24) > 128) {
+               if (extents[x] == null) {
+                  extents[x] = new int[] {y, y};
+               }
+               extents[x][1] = y;
+            }
+         }
+      }
+      return extents;
+   }
+
+   @Test
+   public void appendedPointsAreRenderedOntoThePreviousTrace() {
+      GraphData data = new GraphData(1000000);
+      Random random = new Random(3);
+      double y = 0.0;
+      for (int i = 0; i < 100000; i++) {
+         y += random.nextGaussian();
+         data.append(i, y);
+      }
+      GraphData.Bounds bounds = bounds(data, 200000, -1000, 1000);
+      TraceRenderer.Trace first = TraceRenderer.render(new TraceRenderer.Request(data, 0,
+            400, 200, bounds, false, Color.black), null);
+      Assert.assertTrue(first.isDecimated());
+      for (int i = 100000; i < 200000; i++) {
+         y += random.nextGaussian();
+         data.append(i, y);
+      }
+      TraceRenderer.Request request = new TraceRenderer.Request(data, 0,
+            400, 200, bounds, false, Color.black);
+      TraceRenderer.Trace tail = TraceRenderer.render(request, first);
+      Assert.assertSame(first.getImage(), tail.getImage());
+      TraceRenderer.Trace full = TraceRenderer.render(request, null);
+      Assert.assertNotSame(first.getImage(), full.getImage());
+
+      int[][] expected = columnExtents(full.getImage());
+      int[][] actual = columnExtents(tail.getImage());
+      for (int x = 0; x < expected.length; x++) {
+         Assert.assertEquals("Column " + x, expected[x] == null, actual[x] == null);
+         if (expected[x] != null) {
+            Assert.assertEquals("Column " + x, expected[x][0], actual[x][0], 1);
+            Assert.assertEquals("Column " + x, expected[x][1], actual[x][1], 1);
+         }
+      }
+
+      // Changing the view renders everything again
+      TraceRenderer.Trace rescaled = TraceRenderer.render(new TraceRenderer.Request(data, 0,
+            400, 200, bounds(data, 300000, -1000, 1000), false, Color.black), tail);
+      Assert.assertNotSame(tail.getImage(), rescaled.getImage());
+   }
+
+   /**
+    * Decimates size points at once, then streams them in 100 updates into a
+    * series holding capacity points. The capacity must not be a multiple of
+    * the update size.
+    */
+   private static void decimateAndStream(int size, int capacity) {
+      final int columns = 1000;
+      final int step = size / 100;
+      GraphDecimator.Points points = new SyntheticPoints(size);
+      GraphDecimator.Result result = GraphDecimator.decimate(points, 0, size,
+            0.0, size, columns);
+      Assert.assertTrue(result.size() <= 4 * columns);
+      Assert.assertTrue(result.size() >= 2 * columns);
+
+      GraphData data = new GraphData(capacity);
+      GraphData.Bounds bounds = bounds(data, size, -2, 2);
+      TraceRenderer.Trace trace = null;
+      int tails = 0;
+      for (int i = 0; i < size; i++) {
+         data.append(points.getX(i), points.getY(i));
+         if ((i + 1) % step == 0) {
+            TraceRenderer.Trace next = TraceRenderer.render(new TraceRenderer.Request(data, 0,
+                  columns, 300, bounds, false, Color.black), trace);
+            if (trace != null && next.getImage() == trace.getImage()) {
+               tails++;
+            }
+            trace = next;
+         }
+      }
+      Assert.assertEquals(capacity, data.getSize());
+      // Until the ring buffer is full, only the appended points are rendered
+      Assert.assertEquals(capacity / step - 1, tails);
+   }
+
+   @Test
+   public void decimateAndStreamAMillionPoints() {
+      decimateAndStream(1000000, 1 << 17);
+   }
+
+   /**
+    * Benchmark with 10^7 points streamed into a series of 2^20 points; not
+    * part of the default run.
+    */
+   @Ignore("Benchmark, run manually")
+   @Test
+   public void benchmarkTenMillionPoints() {
+      decimateAndStream(10000000, 1 << 20);
+   }
+}
@@ -0,0 +1,214 @@
+package org.micromanager.internal.hcwizard;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertFalse;
+import static org.junit.Assert.assertNull;
+import static org.junit.Assert.assertTrue;
+
+import java.io.File;
+import java.io.IOException;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.util.Random;
+import org.junit.Assume;
+import org.junit.Test;
+
+public class ConfigFileParserTest {
+   private static final String[] DEMO_CONFIG_PATHS = {
+         "../bindist/any-platform/MMConfig_demo.cfg",
+         "bindist/any-platform/MMConfig_demo.cfg"};
+
+   private static final String SMALL_CONFIG = "# Generated\r\n"
+         + "\r\n"
+         + "Property,Core,Initialize,0\r\n"
+         + "# Devices\r\n"
+         + "Device,Camera,DemoCamera,DCam\r\n"
+         + "Device,Wheel,DemoCamera,DWheel\r\n"
+         + "Property,Camera,MaximumExposureMs,10000.0\r\n"
+         + "Property,Core,Initialize,1\r\n"
+         + "# Labels\r\n"
+         + "# Wheel\r\n"
+         + "Label,Wheel,0,DAPI\r\n"
+         + "Label,Wheel,1,FITC\r\n"
+         + "SomeFutureCommand,foo\r\n"
+         + "# Group: Channel\r\n"
+         + "ConfigGroup,Channel,DAPI,Wheel,Label,DAPI\r\n"
+         + "ConfigGroup,Channel,Empty,Wheel,Label,";
+
+   private static String readDemoConfig() throws IOException {
+      for (String path : DEMO_CONFIG_PATHS) {
+         File file = new File(path);
+         if (file.exists()) {
+            return new String(Files.readAllBytes(file.toPath()),
+                  StandardCharsets.UTF_8);
+         }
+      }
+      return null;
+   }
+
+   @Test
+   public void demoConfigRoundTrips() throws IOException {
+      String text = readDemoConfig();
+      Assume.assumeTrue(text != null);
+      ConfigFileAst ast = ConfigFileParser.parse(text);
+      assertTrue(ast.getErrors().toString(), ast.getErrors().isEmpty());
+      assertEquals(text, ast.toText());
+      assertEquals(text, ast.merge(ConfigFileParser.parse(text)));
+   }
+
+   @Test
+   public void smallConfigIsParsed() {
+      ConfigFileAst ast = ConfigFileParser.parse(SMALL_CONFIG);
+      assertTrue(ast.getErrors().isEmpty());
+      assertEquals(SMALL_CONFIG, ast.toText());
+      assertEquals(16, ast.getLines().size());
+
+      ConfigFileAst.Line device = ast.getLines().get(4);
+      assertEquals(ConfigFileAst.Command.DEVICE, device.getCommand());
+      assertEquals("\r\n", device.getTerminator());
+      assertEquals("DemoCamera", device.token(2));
+      assertEquals(15, device.column(2));
+      assertTrue(ast.getLines().get(6).isPreInit());
+      assertFalse(ast.getLines().get(7).isPreInit());
+      assertEquals(ConfigFileAst.LineKind.UNKNOWN_COMMAND,
+            ast.getLines().get(12).getKind());
+      assertNull(ast.getLines().get(12).getCommand());
+
+      // trailing empty tokens are dropped, as with String.split()
+      ConfigFileAst.Line last = ast.getLines().get(15);
+      assertEquals(5, last.getTokens().size());
+      assertEquals("", last.token(5));
+      assertEquals("", last.getTerminator());
+   }
+
+   @Test
+   public void allErrorsAreReported() {
+      String text = "Device,Camera,DemoCamera\n"
+            + "Label,Wheel,one,DAPI\n"
+            + "PixelSize_um,Res10x,1.0\n"
+            + "PixelSizeAffine,Res10x,1.0,0.0,x,0.0,1.0,0.0\n"
+            + "Delay,Camera,slow\n";
+      ConfigFileAst ast = ConfigFileParser.parse(text);
+      assertEquals(4, ast.getErrors().size());
+      assertEquals(1, ast.getErrors().get(0).getLine());
+      assertEquals(0, ast.getErrors().get(0).getColumn());
+      assertEquals(2, ast.getErrors().get(1).getLine());
+      assertEquals(13, ast.getErrors().get(1).getColumn());
+      assertEquals(4, ast.getErrors().get(2).getLine());
+      assertEquals(32, ast.getErrors().get(2).getColumn());
+      assertEquals(5, ast.getErrors().get(3).getLine());
+      assertEquals(14, ast.getErrors().get(3).getColumn());
+      assertEquals(text, ast.toText());
+   }
+
+   @Test
+   public void mutatedConfigsNeverThrow() throws IOException {
+      String text = readDemoConfig();
+      if (text == null) {
+         text = SMALL_CONFIG;
+      }
+      final String alphabet = ",,,#\r\n 0123abc.-";
+      Random rng = new Random(42);
+      for (int run = 0; run < 2000; run++) {
+         StringBuilder sb = new StringBuilder(text);
+         int nrMutations = 1 + rng.nextInt(20);
+         for (int i = 0; i < nrMutations; i++) {
+            int pos = rng.nextInt(sb.length() + 1);
+            switch (rng.nextInt(3)) {
+               case 0:
+                  sb.insert(pos, alphabet.charAt(rng.nextInt(alphabet.length())));
+                  break;
+               case 1:
+                  if (pos < sb.length()) {
+                     sb.deleteCharAt(pos);
+                  }
+                  break;
+               default:
+                  if (pos < sb.length()) {
+                     sb.setCharAt(pos, alphabet.charAt(rng.nextInt(alphabet.length())));
+                  }
+                  break;
+            }
+         }
+         String mutated = sb.toString();
+         ConfigFileAst ast = ConfigFileParser.parse(mutated);
+         assertEquals(mutated, ast.toText());
+         for (ConfigFileError error : ast.getErrors()) {
+            assertTrue(error.getLine() >= 1 && error.getLine() <= ast.getLines().size());
+            String line = ast.getLines().get(error.getLine() - 1).getText();
+            assertTrue(error.getColumn() >= 0 && error.getColumn() <= line.length() + 1);
+         }
+         // merging must not throw either
+         ast.merge(ConfigFileParser.parse(text));
+      }
+   }
+
+   @Test
+   public void mergeKeepsCommentsAndOrder() {
+      ConfigFileAst original = ConfigFileParser.parse(SMALL_CONFIG);
+      // generated files have a different layout and lose unknown commands
+      String generated = "# Generated by Configurator\n"
+            + "Property,Core,Initialize,0\n"
+            + "Device,Wheel,DemoCamera,DWheel\n"
+            + "Device,Camera,DemoCamera,DCam\n"
+            + "Property,Camera,MaximumExposureMs,10000.0\n"
+            + "Property,Core,Initialize,1\n"
+            + "# Wheel\n"
+            + "Label,Wheel,0,DAPI\n"
+            + "Label,Wheel,1,FITC\n"
+            + "ConfigGroup,Channel,DAPI,Wheel,Label,DAPI\n"
+            + "ConfigGroup,Channel,Empty,Wheel,Label\n";
+      assertEquals(SMALL_CONFIG, original.merge(ConfigFileParser.parse(generated)));
+   }
+
+   @Test
+   public void mergeUpdatesChangedLines() {
+      ConfigFileAst original = ConfigFileParser.parse(SMALL_CONFIG);
+      String generated = "Property,Core,Initialize,0\n"
+            + "Device,Camera,DemoCamera,DCam\n"
+            + "Property,Camera,MaximumExposureMs,10000.0\n"
+            + "Property,Core,Initialize,1\n"
+            + "Label,Camera,0,Unused\n"
+            + "ConfigGroup,Channel,Empty,Wheel,Label\n"
+            + "ConfigGroup,Channel,Empty,Camera,Binning,1\n";
+      String expected = "# Generated\r\n"
+            + "\r\n"
+            + "Property,Core,Initialize,0\r\n"
+            + "# Devices\r\n"
+            + "Device,Camera,DemoCamera,DCam\r\n"
+            + "Property,Camera,MaximumExposureMs,10000.0\r\n"
+            + "Property,Core,Initialize,1\r\n"
+            + "Label,Camera,0,Unused\r\n"
+            + "# Labels\r\n"
+            // kept, the unknown command below it survives
+            + "# Wheel\r\n"
+            + "SomeFutureCommand,foo\r\n"
+            + "# Group: Channel\r\n"
+            + "ConfigGroup,Channel,Empty,Wheel,Label,\r\n"
+            + "ConfigGroup,Channel,Empty,Camera,Binning,1";
+      assertEquals(expected, original.merge(ConfigFileParser.parse(generated)));
+   }
+
+   @Test
+   public void mergeAddsPreInitLinesAfterTheDevices() {
+      // No pre-init properties or hub references yet
+      ConfigFileAst original = ConfigFileParser.parse("Property,Core,Initialize,0\n"
+            + "Device,Hub,DemoCamera,DHub\n"
+            + "Device,Camera,DemoCamera,DCam\n"
+            + "Property,Core,Initialize,1\n");
+      String generated = "Property,Core,Initialize,0\n"
+            + "Device,Hub,DemoCamera,DHub\n"
+            + "Device,Camera,DemoCamera,DCam\n"
+            + "Property,Hub,Port,COM1\n"
+            + "Parent,Camera,Hub\n"
+            + "Property,Core,Initialize,1\n";
+      assertEquals(generated, original.merge(ConfigFileParser.parse(generated)));
+   }
+
+   @Test
+   public void mergeWithoutAnchorUsesGeneratedFile() {
+      ConfigFileAst original = ConfigFileParser.parse("# only a comment\n");
+      String generated = "Device,Camera,DemoCamera,DCam\n";
+      assertEquals(generated, original.merge(ConfigFileParser.parse(generated)));
+   }
+}
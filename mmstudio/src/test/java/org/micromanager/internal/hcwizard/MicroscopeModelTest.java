@@ -0,0 +1,43 @@
+package org.micromanager.internal.hcwizard;
+
+import static org.junit.Assert.assertNull;
+import static org.junit.Assert.assertSame;
+
+import org.junit.Assume;
+import org.junit.Test;
+
+public class MicroscopeModelTest {
+
+   private static MicroscopeModel createModel() {
+      try {
+         return new MicroscopeModel();
+      } catch (UnsatisfiedLinkError e) {
+         // The model needs the MMCoreJ native library
+         Assume.assumeNoException(e);
+         return null;
+      }
+   }
+
+   /**
+    * DeviceSetupDlg renames a loaded device with Device.setName, and then
+    * looks it up by its new name.
+    */
+   @Test
+   public void renamedDeviceIsFoundByItsNewName() throws Exception {
+      MicroscopeModel model = createModel();
+      Device camera = new Device("Camera", "DemoCamera", "DCam");
+      Device wheel = new Device("Wheel", "DemoCamera", "DWheel");
+      model.addDevice(camera);
+      model.addDevice(wheel);
+      assertSame(wheel, model.findDevice("Wheel"));
+
+      wheel.setName("Filters");
+      assertSame(wheel, model.findDevice("Filters"));
+      assertNull(model.findDevice("Wheel"));
+      assertSame(camera, model.findDevice("Camera"));
+
+      model.changeDeviceName("Camera", "Cam");
+      assertSame(camera, model.findDevice("Cam"));
+      assertNull(model.findDevice("Camera"));
+   }
+}
@@ -0,0 +1,192 @@
+package org.micromanager.internal.navigation;
+
+import java.awt.geom.Point2D;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicInteger;
+import org.junit.After;
+import org.junit.Assert;
+import org.junit.Test;
+
+public class XYMoveControllerTest {
+
+   /**
+    * Stage that starts moving after a latency, moves both axes at constant
+    * speed along a straight line, and is busy until it settled.
+    */
+   private static final class SimulatedStage implements XYMoveController.Stage {
+      private final double latencyMs_;
+      private final double speedUmPerMs_;
+      private final double settleMs_;
+      private XYMoveController.Motion motion_;
+      private long endNs_;
+      private int commands_ = 0;
+      private int commandsWhileBusy_ = 0;
+      private int readbacks_ = 0;
+      private int busyQueries_ = 0;
+
+      SimulatedStage(double latencyMs, double speedUmPerMs, double settleMs) {
+         latencyMs_ = latencyMs;
+         speedUmPerMs_ = speedUmPerMs;
+         settleMs_ = settleMs;
+         Point2D.Double origin = new Point2D.Double(100.0, 200.0);
+         motion_ = new XYMoveController.Motion(origin, origin, System.nanoTime(), 0.0, 1.0);
+         endNs_ = System.nanoTime();
+      }
+
+      @Override
+      public synchronized void setXYPosition(double x, double y) {
+         long now = System.nanoTime();
+         commands_++;
+         if (now < endNs_) {
+            commandsWhileBusy_++;
+         }
+         Point2D.Double from = motion_.positionAt(now);
+         motion_ = new XYMoveController.Motion(from, new Point2D.Double(x, y), now,
+               latencyMs_, speedUmPerMs_);
+         double distance = Math.max(Math.abs(x - from.x), Math.abs(y - from.y));
+         endNs_ = now + (long) ((latencyMs_ + distance / speedUmPerMs_ + settleMs_) * 1e6);
+      }
+
+      @Override
+      public synchronized boolean isBusy() {
+         busyQueries_++;
+         return System.nanoTime() < endNs_;
+      }
+
+      @Override
+      public synchronized Point2D.Double getXYPosition() {
+         readbacks_++;
+         return motion_.positionAt(System.nanoTime());
+      }
+   }
+
+   private final ExecutorService executor_ = Executors.newSingleThreadExecutor();
+   private final AtomicInteger reported_ = new AtomicInteger();
+   private volatile Point2D.Double lastReported_;
+
+   private XYMoveController create(SimulatedStage stage, boolean retarget) {
+      return new XYMoveController(stage, executor_, (x, y) -> {
+         reported_.incrementAndGet();
+         lastReported_ = new Point2D.Double(x, y);
+      }, retarget, 5, 50, 5000);
+   }
+
+   // Moves are run in a task on the executor, which ends once the stage is
+   // idle with no moves left
+   private void awaitIdle() throws Exception {
+      executor_.submit(() -> { }).get(10, TimeUnit.SECONDS);
+   }
+
+   @After
+   public void tearDown() {
+      executor_.shutdownNow();
+   }
+
+   @Test
+   public void movesAreCoalescedIntoAbsoluteTargets() throws Exception {
+      SimulatedStage stage = new SimulatedStage(20.0, 1.0, 10.0);
+      XYMoveController controller = create(stage, false);
+      for (int i = 0; i < 50; i++) {
+         controller.moveRelative(1.0, -1.0);
+         Thread.sleep(2);
+      }
+      awaitIdle();
+      Point2D.Double position = stage.getXYPosition();
+      Assert.assertEquals(150.0, position.x, 1e-9);
+      Assert.assertEquals(150.0, position.y, 1e-9);
+      Assert.assertEquals(position, lastReported_);
+      Assert.assertTrue(String.valueOf(stage.commands_), stage.commands_ < 10);
+      Assert.assertEquals(0, stage.commandsWhileBusy_);
+      Assert.assertEquals(position, controller.getEstimatedPosition());
+   }
+
+   @Test
+   public void targetsAreSentWhileMovingWhenSupported() throws Exception {
+      SimulatedStage stage = new SimulatedStage(10.0, 0.5, 200.0);
+      XYMoveController controller = create(stage, true);
+      for (int i = 0; i < 5; i++) {
+         controller.moveRelative(5.0, 0.0);
+         Thread.sleep(30);
+      }
+      awaitIdle();
+      // Targets went out before the stage settled from the previous move
+      Assert.assertTrue(stage.commandsWhileBusy_ > 0);
+      Assert.assertEquals(125.0, stage.getXYPosition().x, 1e-9);
+   }
+
+   @Test
+   public void motionModelFitsLatencyAndSpeed() {
+      XYMoveController.MotionModel model = new XYMoveController.MotionModel();
+      Assert.assertEquals(XYMoveController.DEFAULT_LATENCY_MS, model.getLatencyMs(), 0.0);
+      // A single distance can not tell latency from speed
+      model.observe(100.0, 80.0);
+      Assert.assertEquals(XYMoveController.DEFAULT_SPEED_UM_PER_MS,
+            model.getSpeedUmPerMs(), 0.0);
+      for (double distance : new double[] {20, 100, 60, 200, 40, 150}) {
+         model.observe(distance, 30.0 + distance / 2.0);
+      }
+      Assert.assertEquals(7, model.getCount());
+      Assert.assertEquals(30.0, model.getLatencyMs(), 1e-6);
+      Assert.assertEquals(2.0, model.getSpeedUmPerMs(), 1e-6);
+   }
+
+   private static void assertPosition(double x, double y, Point2D.Double actual) {
+      Assert.assertEquals(x, actual.x, 1e-9);
+      Assert.assertEquals(y, actual.y, 1e-9);
+   }
+
+   @Test
+   public void motionIsEstimatedFromLatencyAndSpeed() {
+      final long ms = 1000000L;
+      XYMoveController.Motion motion = new XYMoveController.Motion(
+            new Point2D.Double(0.0, 10.0), new Point2D.Double(400.0, 210.0),
+            1000 * ms, 40.0, 2.0);
+      assertPosition(0.0, 10.0, motion.positionAt(1020 * ms));
+      // 100 ms after the latency, at 2 um/ms along the larger axis
+      assertPosition(200.0, 110.0, motion.positionAt(1140 * ms));
+      assertPosition(400.0, 210.0, motion.positionAt(1500 * ms));
+
+      // After a readback, the rest of the move starts right away
+      XYMoveController.Motion rest = motion.from(new Point2D.Double(100.0, 60.0), 1200 * ms);
+      assertPosition(300.0, 160.0, rest.positionAt(1300 * ms));
+   }
+
+   @Test
+   public void latencyAndSpeedAreLearnedAndUsedForEstimates() throws Exception {
+      SimulatedStage stage = new SimulatedStage(30.0, 2.0, 10.0);
+      XYMoveController controller = create(stage, false);
+      double[] distances = {20, 100, 60, 200, 40, 150, 80, 120};
+      double sign = 1.0;
+      for (double distance : distances) {
+         controller.moveRelative(sign * distance, 0.0);
+         awaitIdle();
+         sign = -sign;
+      }
+      Assert.assertEquals(distances.length, controller.getMoveCount());
+      // Settling counts as latency
+      Assert.assertEquals(40.0, controller.getLatencyMs(), 10.0);
+      Assert.assertEquals(2.0, controller.getSpeedUmPerMs(), 0.3);
+
+      int readbacks = stage.readbacks_;
+      int busyQueries = stage.busyQueries_;
+      Point2D.Double start = stage.getXYPosition();
+      controller.moveRelative(400.0, 0.0);
+      Assert.assertTrue(controller.isMoving());
+      // The estimate follows the move, wherever it is
+      Point2D.Double estimate = controller.getEstimatedPosition();
+      Assert.assertTrue(estimate.x >= start.x && estimate.x <= start.x + 400.0);
+      Assert.assertEquals(start.y, estimate.y, 1e-9);
+      awaitIdle();
+      // A readback to start from, at most one per 50 ms during the 250 ms
+      // move, and a final one; the test made two
+      Assert.assertTrue(stage.readbacks_ - readbacks <= 1 + 300 / 50 + 1 + 2);
+      // The stage is not flooded with busy queries during the move
+      Assert.assertTrue(String.valueOf(stage.busyQueries_ - busyQueries),
+            stage.busyQueries_ - busyQueries <= 300 / 5);
+      Assert.assertFalse(controller.isMoving());
+      Assert.assertEquals(start.x + 400.0, stage.getXYPosition().x, 1e-9);
+      Assert.assertEquals(stage.getXYPosition(), controller.getEstimatedPosition());
+   }
+}
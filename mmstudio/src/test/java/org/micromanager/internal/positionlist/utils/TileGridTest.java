@@ -0,0 +1,185 @@
+package org.micromanager.internal.positionlist.utils;
+
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertNotNull;
+import static org.junit.Assert.assertTrue;
+
+import java.util.Random;
+import org.junit.Ignore;
+import org.junit.Test;
+import org.micromanager.MultiStagePosition;
+
+public class TileGridTest {
+   private static final double EPSILON = 1e-6;
+
+   /**
+    * The images of the tiles together cover the images that would be taken
+    * at the corners of the bounding box, without gaps, and the grid is the
+    * smallest one that does so.
+    */
+   @Test
+   public void gridCoversBoundingBox() {
+      Random random = new Random(1);
+      for (int n = 0; n < 1000; n++) {
+         double minX = (random.nextDouble() - 0.5) * 10000;
+         double minY = (random.nextDouble() - 0.5) * 10000;
+         double maxX = minX + random.nextDouble() * 3000;
+         double maxY = minY + random.nextDouble() * 3000;
+         double imageX = 50 + random.nextDouble() * 500;
+         double imageY = 50 + random.nextDouble() * 500;
+         double overlapX = random.nextDouble() * 0.9 * imageX;
+         double overlapY = random.nextDouble() * 0.9 * imageY;
+         TileGrid grid = TileGrid.create(minX, minY, maxX, maxY, imageX, imageY,
+               imageX - overlapX, imageY - overlapY, TileOrder.Type.SNAKE);
+
+         checkAxis(grid.getNrX(), minX, maxX, imageX, imageX - overlapX,
+               grid.getX(grid.getVisitIndex(0, 0)),
+               grid.getX(grid.getVisitIndex(grid.getNrX() - 1, 0)));
+         checkAxis(grid.getNrY(), minY, maxY, imageY, imageY - overlapY,
+               grid.getY(grid.getVisitIndex(0, 0)),
+               grid.getY(grid.getVisitIndex(0, grid.getNrY() - 1)));
+      }
+   }
+
+   private static void checkAxis(int nr, double min, double max, double image, double tile,
+                                 double first, double last) {
+      // every tile overlaps the next one by at least the requested overlap
+      assertTrue(image - tile >= -EPSILON);
+      assertEquals(first + (nr - 1) * tile, last, EPSILON);
+      // the images at the corners are covered
+      assertTrue(first <= min + EPSILON);
+      assertTrue(last >= max - EPSILON);
+      // centered on the bounding box
+      assertEquals((min + max) / 2, (first + last) / 2, EPSILON);
+      // one tile less would not cover the bounding box
+      if (nr > 1) {
+         assertTrue((nr - 2) * tile + image < max - min + image + EPSILON);
+      }
+   }
+
+   @Test
+   public void overlapIsKept() {
+      TileGrid grid = TileGrid.create(0, 0, 1000, 500, 200, 100, 180, 80,
+            TileOrder.Type.RASTER);
+      assertEquals(20.0, grid.getOverlapXUm(), EPSILON);
+      assertEquals(20.0, grid.getOverlapYUm(), EPSILON);
+      for (int i = 1; i < grid.size(); i++) {
+         if (grid.getRow(i) == grid.getRow(i - 1)) {
+            assertEquals(180.0, grid.getX(i) - grid.getX(i - 1), EPSILON);
+         } else {
+            assertEquals(80.0, grid.getY(i) - grid.getY(i - 1), EPSILON);
+         }
+      }
+   }
+
+   @Test(expected = IllegalArgumentException.class)
+   public void overlapLargerThanImageIsRejected() {
+      TileGrid.create(0, 0, 1000, 1000, 100, 100, -10, 90, TileOrder.Type.SNAKE);
+   }
+
+   @Test
+   public void ordersVisitEveryTileOnce() {
+      for (TileOrder.Type type : TileOrder.Type.values()) {
+         for (int nrX = 1; nrX < 24; nrX++) {
+            for (int nrY = 1; nrY < 24; nrY++) {
+               int[] order = type.order(nrX, nrY);
+               assertEquals(nrX * nrY, order.length);
+               boolean[] seen = new boolean[order.length];
+               for (int index : order) {
+                  assertTrue(!seen[index]);
+                  seen[index] = true;
+               }
+               if (type == TileOrder.Type.RASTER) {
+                  continue;
+               }
+               for (int i = 1; i < order.length; i++) {
+                  int dx = Math.abs(order[i] % nrX - order[i - 1] % nrX);
+                  int dy = Math.abs(order[i] / nrX - order[i - 1] / nrX);
+                  String msg = type + " " + nrX + "x" + nrY + " step " + i;
+                  if (type == TileOrder.Type.SNAKE || (nrX % 2 == 0 && nrY % 2 == 0)) {
+                     assertEquals(msg, 1, dx + dy);
+                  } else {
+                     assertTrue(msg, Math.max(dx, dy) == 1);
+                  }
+               }
+            }
+         }
+      }
+   }
+
+   /**
+    * The snake order reproduces the positions and labels TileCreator made
+    * before it was based on TileGrid.
+    */
+   @Test
+   public void snakeMatchesNestedLoops() {
+      final double minX = -123.4;
+      final double minY = 56.7;
+      TileGrid grid = TileGrid.create(minX, minY, 900, 700, 100, 80, 90, 70,
+            TileOrder.Type.SNAKE);
+      MultiStagePosition[] positions = TileCreator.createPositions(grid,
+            TileCreator.OverlapUnitEnum.UM, 0.5, "Pos", "XY", new String[0], new double[0][]);
+      double originX = grid.getOriginXUm();
+      double originY = grid.getOriginYUm();
+      int i = 0;
+      for (int y = 0; y < grid.getNrY(); y++) {
+         for (int x = 0; x < grid.getNrX(); x++) {
+            int tmpX = (y & 1) == 1 ? grid.getNrX() - x - 1 : x;
+            MultiStagePosition msp = positions[i++];
+            assertEquals(originX + tmpX * 90, msp.getX(), 0.0);
+            assertEquals(originY + y * 70, msp.getY(), 0.0);
+            assertEquals(String.format("Pos-%03d_%03d", tmpX, y), msp.getLabel());
+            assertEquals(tmpX, msp.getGridColumn());
+            assertEquals(y, msp.getGridRow());
+            assertEquals("TileCreator", msp.getProperty("Source"));
+            assertEquals("20", msp.getProperty("OverlapPixels"));
+         }
+      }
+   }
+
+   /**
+    * Generates grids of nrX by nrY tiles in each order, and the positions
+    * for them.
+    */
+   private static void createTilesInEveryOrder(int nrX, int nrY) {
+      for (TileOrder.Type type : TileOrder.Type.values()) {
+         TileGrid grid = TileGrid.create(0, 0, (nrX - 1) * 90, (nrY - 1) * 70,
+               100, 80, 90, 70, type);
+         assertEquals(nrX, grid.getNrX());
+         assertEquals(nrY, grid.getNrY());
+
+         double[] z = grid.computeZ(new ZGenerator() {
+            @Override
+            public double getZ(double x, double y, String zDevice) {
+               return x * 0.001 + y * 0.002;
+            }
+
+            @Override
+            public String getDescription() {
+               return "Plane";
+            }
+         }, "Z");
+         MultiStagePosition[] positions = TileCreator.createPositions(grid,
+               TileCreator.OverlapUnitEnum.PERCENT, 0.5, "Pos", "XY",
+               new String[] {"Z"}, new double[][] {z});
+         assertEquals(nrX * nrY, positions.length);
+         for (MultiStagePosition msp : positions) {
+            assertNotNull(msp);
+         }
+      }
+   }
+
+   @Test
+   public void thousandTiles() {
+      createTilesInEveryOrder(40, 25);
+   }
+
+   /**
+    * Benchmark with 100,000 tiles in each order; not part of the default run.
+    */
+   @Ignore("Benchmark, run manually")
+   @Test
+   public void hundredThousandTiles() {
+      createTilesInEveryOrder(400, 250);
+   }
+}
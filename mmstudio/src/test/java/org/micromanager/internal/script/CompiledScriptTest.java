@@ -0,0 +1,131 @@
+package org.micromanager.internal.script;
+
+import bsh.EvalError;
+import bsh.Interpreter;
+import bsh.TargetError;
+import java.util.concurrent.atomic.AtomicReference;
+import org.junit.Assert;
+import org.junit.Test;
+import org.micromanager.ScriptController;
+
+public class CompiledScriptTest {
+
+   private static ScriptProbe run(Interpreter interp, String script) throws EvalError {
+      CompiledScript compiled = CompiledScript.compile(script);
+      ScriptProbe probe = new ScriptProbe(compiled.getLineCount());
+      compiled.run(interp, probe);
+      return probe;
+   }
+
+   private static boolean wasStopped(Throwable error) {
+      for (Throwable t = error; t != null; t = t.getCause()) {
+         if (t instanceof ScriptController.ScriptStoppedException) {
+            return true;
+         }
+         if (t instanceof TargetError && ((TargetError) t).getTarget() != t
+               && wasStopped(((TargetError) t).getTarget())) {
+            return true;
+         }
+      }
+      return false;
+   }
+
+   @Test
+   public void parsedScriptsAreCached() throws Exception {
+      String script = "a = 1;\nb = a + 1;\n";
+      CompiledScript compiled = CompiledScript.compile(script);
+      Assert.assertSame(compiled, CompiledScript.compile(new String(script)));
+      Assert.assertNotSame(compiled, CompiledScript.compile(script + "c = 3;\n"));
+      Assert.assertEquals(3, compiled.getLineCount());
+      Assert.assertEquals(2, compiled.getProbeCount());
+
+      Interpreter interp = new Interpreter();
+      CompiledScript.compile(script).run(interp, new ScriptProbe(3));
+      CompiledScript.compile(script).run(interp, new ScriptProbe(3));
+      Assert.assertEquals(2, interp.get("b"));
+   }
+
+   @Test
+   public void linesAreProfiled() throws Exception {
+      Interpreter interp = new Interpreter();
+      ScriptProbe probe = run(interp, ""
+            + "x = 0;\n"
+            + "for (i = 0; i < 100; i++) {\n"
+            + "   x += i;\n"
+            + "   if (i % 10 == 0) { Thread.sleep(2); y = i; }\n"
+            + "}\n"
+            + "result = x;\n");
+      Assert.assertEquals(4950, interp.get("result"));
+      Assert.assertEquals(90, interp.get("y"));
+      Assert.assertEquals(1, probe.getHits(1));
+      Assert.assertEquals(1, probe.getHits(2));
+      Assert.assertEquals(100, probe.getHits(3));
+      // One probe for the line, in front of the if
+      Assert.assertEquals(100, probe.getHits(4));
+      Assert.assertEquals(0, probe.getHits(5));
+      Assert.assertEquals(1, probe.getHits(6));
+      // The sleeps dominate
+      Assert.assertTrue(probe.getNanos(4) >= 10 * 2000000L);
+      Assert.assertTrue(probe.getNanos(4) > probe.getNanos(3));
+   }
+
+   @Test
+   public void tabsAndErrorLinesMatchTheScript() throws Exception {
+      Interpreter interp = new Interpreter();
+      ScriptProbe probe = run(interp, "if (true) {\n\t\ta = \"\t\"; b = 2;\n\t}\n");
+      Assert.assertEquals("\t", interp.get("a"));
+      Assert.assertEquals(2, interp.get("b"));
+      Assert.assertEquals(1, probe.getHits(2));
+
+      try {
+         run(interp, "a = 1;\n\n\tnoSuchMethod();\n");
+         Assert.fail();
+      } catch (EvalError e) {
+         Assert.assertEquals(3, e.getErrorLineNumber());
+      }
+   }
+
+   @Test
+   public void stopRequestEndsLoop() throws Exception {
+      // The script catches the exception, which is thrown again at the next
+      // statement
+      final String script = ""
+            + "n = 0;\n"
+            + "while (true) {\n"
+            + "   try {\n"
+            + "      n++;\n"
+            + "   } catch (Throwable t) {\n"
+            + "      caught = true;\n"
+            + "   }\n"
+            + "}\n";
+      final Interpreter interp = new Interpreter();
+      final CompiledScript compiled = CompiledScript.compile(script);
+      final ScriptProbe probe = new ScriptProbe(compiled.getLineCount());
+      final AtomicReference<Throwable> error = new AtomicReference<>();
+      Thread thread = new Thread(() -> {
+         try {
+            compiled.run(interp, probe);
+         } catch (Throwable e) {
+            error.set(e);
+         }
+      });
+      thread.start();
+      Thread.sleep(200);
+      probe.requestStop();
+      thread.join(5000);
+      Assert.assertFalse(thread.isAlive());
+      Assert.assertTrue(String.valueOf(error.get()), wasStopped(error.get()));
+      Assert.assertTrue(probe.getHits(4) > 0);
+   }
+
+   @Test
+   public void methodsRunAfterTheScript() throws Exception {
+      final Interpreter interp = new Interpreter();
+      ScriptProbe probe = run(interp, "int f() {\n   return 1;\n}\n");
+      probe.requestStop();
+      // Not profiled nor stopped: the script has ended
+      interp.eval("z = f();");
+      Assert.assertEquals(1, interp.get("z"));
+      Assert.assertEquals(0, probe.getHits(2));
+   }
+}
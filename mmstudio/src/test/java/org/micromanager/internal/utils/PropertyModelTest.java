@@ -0,0 +1,204 @@
+package org.micromanager.internal.utils;
+
+import java.util.ArrayList;
+import java.util.List;
+import java.util.Map;
+import java.util.Random;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.atomic.AtomicInteger;
+import mmcorej.DeviceType;
+import org.junit.Assert;
+import org.junit.Test;
+
+public class PropertyModelTest {
+   private static final int DEVICES = 50;
+   private static final int PROPERTIES = 100;
+
+   /**
+    * Stand-in for the Core, holding the current value of each property.
+    */
+   private static final class FakeCore implements PropertyModel.Core {
+      private final List<String> devices_ = new ArrayList<>();
+      private final Map<String, String> values_ = new ConcurrentHashMap<>();
+      private final AtomicInteger describes_ = new AtomicInteger();
+      private final AtomicInteger reads_ = new AtomicInteger();
+
+      FakeCore() {
+         for (int d = 0; d < DEVICES; d++) {
+            devices_.add("Device" + d);
+            for (int p = 0; p < PROPERTIES; p++) {
+               values_.put(key("Device" + d, "Property" + p), "0");
+            }
+         }
+      }
+
+      private static String key(String device, String property) {
+         return device + "-" + property;
+      }
+
+      void set(String device, String property, String value) {
+         values_.put(key(device, property), value);
+      }
+
+      String get(String device, String property) {
+         return values_.get(key(device, property));
+      }
+
+      @Override
+      public synchronized List<String> getLoadedDevices() {
+         return new ArrayList<>(devices_);
+      }
+
+      @Override
+      public DeviceType getDeviceType(String device) {
+         return null;
+      }
+
+      @Override
+      public List<String> getPropertyNames(String device) {
+         List<String> names = new ArrayList<>();
+         for (int p = 0; p < PROPERTIES; p++) {
+            names.add("Property" + p);
+         }
+         return names;
+      }
+
+      @Override
+      public PropertyItem describe(String device, String property) {
+         describes_.incrementAndGet();
+         PropertyItem item = new PropertyItem(property, get(device, property));
+         item.device = device;
+         return item;
+      }
+
+      @Override
+      public String getPropertyFromCache(String device, String property) {
+         return get(device, property);
+      }
+
+      @Override
+      public String getProperty(String device, String property) {
+         reads_.incrementAndGet();
+         return get(device, property);
+      }
+   }
+
+   private static List<PropertyItem> allItems(PropertyModel model) {
+      List<PropertyItem> items = new ArrayList<>();
+      for (String device : model.getDevices()) {
+         items.addAll(model.getItems(device));
+      }
+      return items;
+   }
+
+   private static void assertMatchesCore(PropertyModel model, FakeCore core) {
+      for (PropertyItem item : allItems(model)) {
+         Assert.assertEquals(item.toString(), core.get(item.device, item.name), item.value);
+      }
+   }
+
+   @Test
+   public void structureIsLoadedOnce() {
+      FakeCore core = new FakeCore();
+      PropertyModel model = new PropertyModel(core);
+      Assert.assertTrue(model.isStale());
+      model.load();
+      Assert.assertFalse(model.isStale());
+      Assert.assertEquals(DEVICES * PROPERTIES, model.size());
+      Assert.assertEquals(DEVICES * PROPERTIES, core.describes_.get());
+
+      PropertyItem item = model.getItem("Device7", "Property42");
+      Assert.assertEquals("Device7", item.device);
+      Assert.assertEquals("Property42", item.name);
+      Assert.assertNull(model.getItem("Device7", "Missing"));
+
+      core.set("Device7", "Property42", "1");
+      core.set("Device8", "Property3", "2");
+      List<PropertyItem> changed = model.updateFromCache();
+      Assert.assertEquals(2, changed.size());
+      Assert.assertSame(item, changed.get(0));
+      Assert.assertEquals("1", item.value);
+      Assert.assertTrue(model.updateFromCache().isEmpty());
+      Assert.assertEquals(DEVICES * PROPERTIES, core.describes_.get());
+
+      synchronized (core) {
+         core.devices_.remove(0);
+      }
+      Assert.assertTrue(model.isStale());
+   }
+
+   @Test
+   public void notificationsUpdateSingleProperties() {
+      FakeCore core = new FakeCore();
+      PropertyModel model = new PropertyModel(core);
+      model.load();
+      PropertyItem item = model.getItem("Device3", "Property5");
+      Assert.assertSame(item, model.propertyChanged("Device3", "Property5", "7"));
+      Assert.assertEquals("7", item.value);
+      // Unchanged values and unknown properties are not reported
+      Assert.assertNull(model.propertyChanged("Device3", "Property5", "7"));
+      Assert.assertNull(model.propertyChanged("Unknown", "Property5", "7"));
+      Assert.assertEquals(0, core.reads_.get());
+   }
+
+   @Test
+   public void changeStormsDuringBackgroundReads() throws Exception {
+      final FakeCore core = new FakeCore();
+      final PropertyModel model = new PropertyModel(core);
+      model.load();
+      final List<PropertyItem> items = allItems(model);
+      final AtomicInteger batches = new AtomicInteger();
+
+      List<Thread> storms = new ArrayList<>();
+      for (int t = 0; t < 4; t++) {
+         final Random random = new Random(t);
+         final int thread = t;
+         storms.add(new Thread(() -> {
+            for (int i = 0; i < 20000; i++) {
+               String device = "Device" + random.nextInt(DEVICES);
+               String property = "Property" + random.nextInt(PROPERTIES);
+               String value = thread + ":" + i;
+               // The Core stores the value, then notifies
+               synchronized (core) {
+                  core.set(device, property, value);
+                  model.propertyChanged(device, property, value);
+               }
+            }
+         }));
+      }
+      Thread reader = new Thread(() -> {
+         for (int pass = 0; pass < 5; pass++) {
+            model.readValues(items, changed -> batches.incrementAndGet());
+         }
+      });
+      for (Thread storm : storms) {
+         storm.start();
+      }
+      reader.start();
+      for (Thread storm : storms) {
+         storm.join();
+      }
+      reader.join();
+
+      Assert.assertEquals(5 * items.size(), core.reads_.get());
+      Assert.assertTrue(batches.get() <= 5 * items.size() / PropertyModel.BATCH_SIZE);
+      assertMatchesCore(model, core);
+      // Nothing is pending; another read changes nothing
+      model.readValues(items, changed -> Assert.fail("Unexpected change " + changed));
+      assertMatchesCore(model, core);
+   }
+
+   @Test
+   public void interruptedReadStops() {
+      FakeCore core = new FakeCore();
+      PropertyModel model = new PropertyModel(core);
+      model.load();
+      Thread.currentThread().interrupt();
+      try {
+         model.readValues(allItems(model), changed -> { });
+      } finally {
+         Assert.assertTrue(Thread.interrupted());
+      }
+      Assert.assertEquals(0, core.reads_.get());
+   }
+}
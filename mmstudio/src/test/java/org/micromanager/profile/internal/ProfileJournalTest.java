@@ -0,0 +1,142 @@
+package org.micromanager.profile.internal;
+
+import java.io.File;
+import java.io.RandomAccessFile;
+import java.util.ArrayList;
+import java.util.List;
+import org.junit.Assert;
+import org.junit.Rule;
+import org.junit.Test;
+import org.junit.rules.TemporaryFolder;
+import org.micromanager.PropertyMap;
+import org.micromanager.PropertyMaps;
+
+public class ProfileJournalTest {
+   @Rule
+   public TemporaryFolder folder = new TemporaryFolder();
+
+   private static PropertyMap settings(String key, int value) {
+      return PropertyMaps.builder().putInteger(key, value).build();
+   }
+
+   private static PropertyMap profile(PropertyMap... owners) {
+      PropertyMap.Builder builder = PropertyMaps.builder();
+      for (int i = 0; i < owners.length; i++) {
+         builder.putPropertyMap("owner" + i, owners[i]);
+      }
+      return builder.build();
+   }
+
+   @Test
+   public void replayAppliesEditsInOrder() throws Exception {
+      File file = folder.newFile("profile.json.journal");
+      ProfileJournal journal = new ProfileJournal(file);
+      Assert.assertTrue(journal.append("owner0", settings("a", 1)));
+      Assert.assertFalse(journal.append("owner1", settings("b", 1)));
+      journal.flush();
+      Assert.assertTrue(journal.append("owner0", settings("a", 2)));
+      journal.flush();
+
+      PropertyMap saved = profile(settings("a", 0), settings("b", 0), settings("c", 0));
+      PropertyMap replayed = new ProfileJournal(file).replay(saved);
+      Assert.assertEquals(profile(settings("a", 2), settings("b", 1), settings("c", 0)),
+            replayed);
+
+      journal.appendClearAll();
+      journal.append("owner2", settings("c", 5));
+      journal.flush();
+      Assert.assertEquals(PropertyMaps.builder().putPropertyMap("owner2", settings("c", 5))
+            .build(), new ProfileJournal(file).replay(saved));
+   }
+
+   @Test
+   public void truncatedJournalIsRecovered() throws Exception {
+      File file = folder.newFile("profile.json.journal");
+      ProfileJournal journal = new ProfileJournal(file);
+      for (int i = 1; i <= 10; i++) {
+         journal.append("owner0", settings("a", i));
+         journal.flush();
+      }
+      // Crash while writing the last record
+      long length = file.length();
+      try (RandomAccessFile raf = new RandomAccessFile(file, "rw")) {
+         raf.setLength(length - 3);
+      }
+      PropertyMap saved = profile(settings("a", 0));
+      ProfileJournal recovered = new ProfileJournal(file);
+      Assert.assertEquals(profile(settings("a", 9)), recovered.replay(saved));
+
+      // Edits after the restart are replayed too
+      recovered.repair();
+      Assert.assertTrue(file.length() < length);
+      recovered.append("owner0", settings("a", 11));
+      recovered.flush();
+      Assert.assertEquals(profile(settings("a", 11)), new ProfileJournal(file).replay(saved));
+
+      // A partial length is cut off as well
+      try (RandomAccessFile raf = new RandomAccessFile(file, "rw")) {
+         raf.seek(raf.length());
+         raf.write(new byte[] {0, 0});
+      }
+      recovered.repair();
+      recovered.append("owner0", settings("a", 12));
+      recovered.flush();
+      Assert.assertEquals(profile(settings("a", 12)), new ProfileJournal(file).replay(saved));
+   }
+
+   @Test
+   public void compactionKeepsLaterEdits() throws Exception {
+      File file = new File(folder.getRoot(), "profile.json.journal");
+      ProfileJournal journal = new ProfileJournal(file);
+      journal.append("owner0", settings("a", 1));
+      journal.flush();
+      journal.beginCompaction();
+      // Edited while the profile is being saved
+      journal.append("owner1", settings("b", 1));
+      journal.flush();
+      PropertyMap saved = profile(settings("a", 0), settings("b", 0));
+      Assert.assertEquals(profile(settings("a", 1), settings("b", 1)),
+            new ProfileJournal(file).replay(saved));
+
+      // Saving failed; the next compaction keeps all records
+      journal.beginCompaction();
+      Assert.assertFalse(file.exists());
+      Assert.assertEquals(profile(settings("a", 1), settings("b", 1)),
+            new ProfileJournal(file).replay(saved));
+
+      journal.endCompaction();
+      Assert.assertEquals(saved, new ProfileJournal(file).replay(saved));
+   }
+
+   @Test
+   public void concurrentEditsAreAllRecorded() throws Exception {
+      File file = new File(folder.getRoot(), "profile.json.journal");
+      final ProfileJournal journal = new ProfileJournal(file);
+      final int edits = 500;
+      List<Thread> threads = new ArrayList<>();
+      for (int t = 0; t < 4; t++) {
+         final String owner = "owner" + t;
+         threads.add(new Thread(() -> {
+            for (int i = 1; i <= edits; i++) {
+               if (journal.append(owner, settings("a", i))) {
+                  try {
+                     journal.flush();
+                  } catch (Exception e) {
+                     throw new RuntimeException(e);
+                  }
+               }
+            }
+         }));
+      }
+      for (Thread thread : threads) {
+         thread.start();
+      }
+      for (Thread thread : threads) {
+         thread.join();
+      }
+      journal.flush();
+      PropertyMap replayed = new ProfileJournal(file).replay(PropertyMaps.emptyPropertyMap());
+      Assert.assertEquals(profile(settings("a", edits), settings("a", edits),
+            settings("a", edits), settings("a", edits)), replayed);
+   }
+}
@@ -2,14 +2,19 @@
 
 package org.micromanager.acquiremultipleregions;
 
+import com.google.common.eventbus.Subscribe;
 import java.awt.Font;
 import java.awt.event.ActionEvent;
 import java.io.File;
+import java.io.IOException;
 import java.nio.file.Files;
 import java.nio.file.Path;
 import java.nio.file.Paths;
 import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.Collections;
 import java.util.Comparator;
+import java.util.List;
 import java.util.regex.Matcher;
 import java.util.regex.Pattern;
 import javax.swing.AbstractListModel;
@@ -22,8 +27,12 @@ import org.micromanager.MultiStagePosition;
 import org.micromanager.PositionList;
 import org.micromanager.StagePosition;
 import org.micromanager.Studio;
+import org.micromanager.acquisition.AcquisitionStartedEvent;
 import org.micromanager.acquisition.SequenceSettings;
+import org.micromanager.data.Coords;
 import org.micromanager.data.Datastore;
+import org.micromanager.data.Image;
+import org.micromanager.data.SummaryMetadata;
 import org.micromanager.internal.positionlist.utils.TileCreator;
 import org.micromanager.internal.positionlist.utils.ZGenerator;
 import org.micromanager.internal.utils.FileDialogs;
@@ -42,6 +51,10 @@ public class AcquireMultipleRegionsForm extends javax.swing.JFrame {
    private final JTable axisTable_;
    private final AxisTableModel axisModel_;
    private final AxisList axisList_;
+   // Router for the images of the next acquisition that starts
+   private volatile RegionRouter pendingRouter_;
+   // Summary metadata of the running merged acquisition
+   private volatile SummaryMetadata mergedSummary_;
    public int userParameter1;
 
    /**
@@ -252,72 +265,210 @@ public class AcquireMultipleRegionsForm extends javax.swing.JFrame {
       }
    }
 
+   /**
+    * Acquires all regions in a single acquisition. The tiles of all regions
+    * are merged into one position list, ordered to reduce stage travel, and
+    * the images of each region are written to its own dataset by a
+    * RegionRouter. A region whose tiles can not be created, or whose
+    * dataset can not be written, does not stop the other regions.
+    */
    class AcqThread extends Thread {
       @Override
       public void run() {
-         for (int i = 0; i < rlm_.getSize(); i++) {
-            Region currRegion = rlm_.getRegion(i);
-            ZGenerator.Type zGenType = (ZGenerator.Type) zTypeDropdown.getSelectedItem();
-            String xyStage = mmc_.getXYStageDevice();
-            StrVector zStages = new StrVector();
-            for (int axNum = 0; axNum < axisList_.getNumberOfPositions(); axNum++) {
-               AxisData ad = axisList_.get(axNum);
-               if (ad.getUse()) {
-                  zStages.add(ad.getAxisName());
-               }
+         double pixelSizeUm = mmc_.getPixelSizeUm();
+         if (pixelSizeUm == 0.0) {
+            gui_.logs().showError("Pixel Size is 0. Must set pixel size.");
+            statusText.setText("Pixel Size is 0. Must set pixel size.");
+            return;
+         }
+         ZGenerator.Type zGenType = (ZGenerator.Type) zTypeDropdown.getSelectedItem();
+         String xyStage = mmc_.getXYStageDevice();
+         StrVector zStages = new StrVector();
+         for (int axNum = 0; axNum < axisList_.getNumberOfPositions(); axNum++) {
+            AxisData ad = axisList_.get(axNum);
+            if (ad.getUse()) {
+               zStages.add(ad.getAxisName());
             }
+         }
+         double overlap = Double.parseDouble(overlapText.getText());
+
+         final int numRegions = rlm_.getSize();
+         final List<Region> regions = new ArrayList<>();
+         final List<String> names = new ArrayList<>();
+         final List<List<MultiStagePosition>> tiles = new ArrayList<>();
+         List<String> failed = new ArrayList<>();
+         for (int i = 0; i < numRegions; i++) {
+            Region currRegion = rlm_.getRegion(i);
+            regions.add(currRegion);
+            names.add(currRegion.filename);
+            PositionList regionTiles = null;
             try {
-               statusText.setText("Acquiring region " + String.valueOf(i));
-               //turn on position list, turn off time lapse
-               SequenceSettings.Builder currSettingsB =
-                     gui_.acquisitions().getAcquisitionSettings().copyBuilder();
-               currSettingsB.usePositionList(true);
-               currSettingsB.numFrames(1);
-               gui_.acquisitions().setAcquisitionSettings(currSettingsB.build());
-               // TODO: ensure saving chooses the correct format. This logic
-               // became lost in the MM2.0 refactoring.
-               // gui_.compat().setImageSavingFormat(org.micromanager.acquisition.internal
-               // .TaggedImageStorageMultipageTiff.class);
-               // update positionlist with grid
-               // gui_.positions().setPositionList(currRegion.tileGrid(getXFieldSize(),
-               // getYFieldSize(), axisList_, zGenType_));
-
-               double overlap = Double.parseDouble(overlapText.getText());
-               double pixelSizeUm = mmc_.getPixelSizeUm();
-               if (pixelSizeUm == 0.0) {
-                  gui_.logs().showError("Pixel Size is 0. Must set pixel size.");
-                  statusText.setText("Pixel Size is 0. Must set pixel size.");
-                  return;
-               }
-               gui_.positions().setPositionList(
-                     tileCreator_.createTiles(
-                           overlap,
-                           TileCreator.OverlapUnitEnum.PERCENT,
-                           currRegion.positions.getPositions(),
-                           pixelSizeUm,
-                           "1",
-                           xyStage,
-                           zStages,
-                           zGenType
-                     )
-               );
-
-               gui_.app().refreshGUI();
-               Datastore store =
-                     gui_.acquisitions().runAcquisition(currRegion.filename, currRegion.directory);
+               regionTiles = tileCreator_.createTiles(
+                     overlap,
+                     TileCreator.OverlapUnitEnum.PERCENT,
+                     currRegion.positions.getPositions(),
+                     pixelSizeUm,
+                     "1",
+                     xyStage,
+                     zStages,
+                     zGenType);
+            } catch (Exception ex) {
+               ReportingUtils.logError(ex, MSG_PREFIX + "no tiles for " + currRegion.name());
+            }
+            if (regionTiles == null || regionTiles.getNumberOfPositions() == 0) {
+               failed.add(currRegion.name());
+               tiles.add(Collections.<MultiStagePosition>emptyList());
+            } else {
+               tiles.add(Arrays.asList(regionTiles.getPositions()));
+            }
+         }
+
+         double startX = 0.0;
+         double startY = 0.0;
+         try {
+            startX = mmc_.getXPosition();
+            startY = mmc_.getYPosition();
+         } catch (Exception ex) {
+            logMessage("Stage position unknown, planning from the origin");
+         }
+         RegionPlanner.Plan plan = RegionPlanner.plan(names, tiles, startX, startY);
+         if (plan.getPositions().isEmpty()) {
+            statusText.setText("No tiles to acquire");
+            return;
+         }
+         logMessage("Acquiring " + plan.getRegionOrder().size() + " regions, "
+               + Math.round(plan.getTransitUm()) + " um of travel between regions");
+         PositionList merged = new PositionList();
+         for (MultiStagePosition position : plan.getPositions()) {
+            merged.addPosition(position);
+         }
+
+         final SequenceSettings userSettings = gui_.acquisitions().getAcquisitionSettings();
+         // Images are saved by the router, per region, instead of by the acquisition
+         SequenceSettings settings = userSettings.copyBuilder()
+               .usePositionList(true)
+               .numFrames(1)
+               .save(false)
+               .shouldDisplayImages(false)
+               .build();
+         RegionRouter router = new RegionRouter(plan.getRegionOf(), plan.getIndexInRegion(),
+               numRegions, region -> openRegion(regions.get(region), tiles.get(region),
+                     userSettings.saveMode()));
+         pendingRouter_ = router;
+         gui_.events().registerForEvents(AcquireMultipleRegionsForm.this);
+         try {
+            statusText.setText("Acquiring " + plan.getRegionOrder().size() + " regions");
+            gui_.positions().setPositionList(merged);
+            gui_.app().refreshGUI();
+            Datastore store = gui_.acquisitions().runAcquisitionWithSettings(settings, true);
+            if (store != null) {
                store.freeze();
                gui_.displays().closeDisplaysFor(store);
                store.close();
-               gui_.positions().getPositionList()
-                     .save(Paths.get(store.getSavePath()).resolve("AMRposlist.pos").toFile());
-            } catch (Exception ex) {
-               handleError(ex);
             }
+         } catch (Exception ex) {
+            handleError(ex);
+         } finally {
+            pendingRouter_ = null;
+            gui_.events().unregisterForEvents(AcquireMultipleRegionsForm.this);
+         }
+         try {
+            router.finish();
+         } catch (InterruptedException ex) {
+            handleError(ex);
+         }
+         for (int i = 0; i < numRegions; i++) {
+            Exception error = router.getError(i);
+            if (error != null) {
+               ReportingUtils.logError(error, MSG_PREFIX + "failed to save "
+                     + regions.get(i).name() + "; " + router.getDiscarded(i)
+                     + " images not saved");
+               failed.add(regions.get(i).name());
+            }
+         }
+         if (failed.isEmpty()) {
+            statusText.setText("Acquisition finished");
+         } else {
+            statusText.setText("Acquisition finished; " + failed.size() + " region(s) failed");
+            gui_.logs().showError("These regions were not acquired or not saved:\n"
+                  + String.join("\n", failed));
          }
-         statusText.setText("Acquisition finished");
       }
    }
 
+   /**
+    * Replaces the storage of the merged acquisition, before its first image,
+    * so that its images are passed to the router instead of kept in memory.
+    *
+    * @param event signals the start of an acquisition
+    */
+   @Subscribe
+   public void onAcquisitionStarted(AcquisitionStartedEvent event) {
+      RegionRouter router = pendingRouter_;
+      if (router == null) {
+         return;
+      }
+      pendingRouter_ = null;
+      Datastore store = event.getDatastore();
+      mergedSummary_ = store.getSummaryMetadata();
+      store.setStorage(new RoutingStorage(router, mergedSummary_));
+   }
+
+   /**
+    * Creates the dataset of a region, in the directory of the region. Called
+    * on the writer thread of the router.
+    */
+   private RegionRouter.Sink openRegion(Region region, List<MultiStagePosition> tiles,
+                                        Datastore.SaveMode saveMode) throws IOException {
+      // Same naming as the acquisition engine: name_1, name_2, ...
+      File dir;
+      int index = 1;
+      do {
+         dir = new File(region.directory, region.filename + "_" + index++);
+      } while (dir.exists());
+      final File regionDir = dir;
+      final Datastore store;
+      switch (saveMode) {
+         case SINGLEPLANE_TIFF_SERIES:
+            store = gui_.data().createSinglePlaneTIFFSeriesDatastore(regionDir.getPath());
+            break;
+         case ND_TIFF:
+            store = gui_.data().createNDTIFFDatastore(regionDir.getPath());
+            break;
+         default:
+            store = gui_.data().createMultipageTIFFDatastore(regionDir.getPath(), true, false);
+            break;
+      }
+      store.setName(regionDir.getName());
+      SummaryMetadata.Builder summary = mergedSummary_.copyBuilder()
+            .prefix(regionDir.getName())
+            .directory(region.directory)
+            .stagePositions(tiles);
+      Coords intended = mergedSummary_.getIntendedDimensions();
+      if (intended != null) {
+         summary.intendedDimensions(
+               intended.copyBuilder().stagePosition(tiles.size()).build());
+      }
+      store.setSummaryMetadata(summary.build());
+      final PositionList regionPositions = new PositionList();
+      for (MultiStagePosition tile : tiles) {
+         regionPositions.addPosition(tile);
+      }
+      return new RegionRouter.Sink() {
+         @Override
+         public void putImage(Image image) throws IOException {
+            store.putImage(image);
+         }
+
+         @Override
+         public void close() throws IOException {
+            store.freeze();
+            store.close();
+            regionPositions.save(new File(regionDir, "AMRposlist.pos"));
+         }
+      };
+   }
+
 
    /*
      Convenience function for logging errors.
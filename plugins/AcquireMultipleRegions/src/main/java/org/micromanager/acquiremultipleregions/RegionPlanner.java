@@ -0,0 +1,250 @@
+package org.micromanager.acquiremultipleregions;
+
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.List;
+import org.micromanager.MultiStagePosition;
+
+/**
+ * Merges the tiles of several regions into a single position list, so that
+ * all regions can be acquired in one acquisition.
+ *
+ * <p>The tiles of each region are kept together, in their own order or in
+ * reverse, so that the path within a region stays as the tile creator laid
+ * it out. The regions are ordered to reduce the stage travel between them:
+ * starting at the current stage position, the nearest end of any remaining
+ * region is visited next, after which segments of the route are reversed
+ * as long as this shortens it (2-opt).
+ */
+final class RegionPlanner {
+
+   /**
+    * Property of each merged position holding the index of its region.
+    */
+   static final String REGION_PROPERTY = "AMRRegion";
+
+   // Upper bound on the improvement passes over the route
+   private static final int MAX_PASSES = 100;
+
+   /**
+    * Merged positions, and where each of them came from.
+    */
+   static final class Plan {
+      private final List<MultiStagePosition> positions_;
+      private final int[] regionOf_;
+      private final int[] indexInRegion_;
+      private final List<Integer> regionOrder_;
+      private final double transitUm_;
+
+      private Plan(List<MultiStagePosition> positions, int[] regionOf, int[] indexInRegion,
+                   List<Integer> regionOrder, double transitUm) {
+         positions_ = positions;
+         regionOf_ = regionOf;
+         indexInRegion_ = indexInRegion;
+         regionOrder_ = regionOrder;
+         transitUm_ = transitUm;
+      }
+
+      /**
+       * Positions of all regions, in acquisition order.
+       */
+      List<MultiStagePosition> getPositions() {
+         return positions_;
+      }
+
+      /**
+       * Region index of each merged position.
+       */
+      int[] getRegionOf() {
+         return regionOf_;
+      }
+
+      /**
+       * Index of each merged position within the tiles of its region.
+       */
+      int[] getIndexInRegion() {
+         return indexInRegion_;
+      }
+
+      /**
+       * Indices of the regions, in acquisition order.
+       */
+      List<Integer> getRegionOrder() {
+         return regionOrder_;
+      }
+
+      /**
+       * Distance traveled between regions, including the move to the first.
+       */
+      double getTransitUm() {
+         return transitUm_;
+      }
+   }
+
+   // A region, visited in tile order or in reverse
+   private static final class Leg {
+      private final int region_;
+      private final boolean reversed_;
+
+      private Leg(int region, boolean reversed) {
+         region_ = region;
+         reversed_ = reversed;
+      }
+
+      private Leg flipped() {
+         return new Leg(region_, !reversed_);
+      }
+   }
+
+   private final List<List<MultiStagePosition>> tiles_;
+   private final double startX_;
+   private final double startY_;
+
+   private RegionPlanner(List<List<MultiStagePosition>> tiles, double startX, double startY) {
+      tiles_ = tiles;
+      startX_ = startX;
+      startY_ = startY;
+   }
+
+   /**
+    * Plans the acquisition of the given regions.
+    *
+    * @param names name of each region, used to label its positions
+    * @param tiles tiles of each region; regions without tiles are left out
+    * @param startX current X position of the stage
+    * @param startY current Y position of the stage
+    * @return the plan
+    */
+   static Plan plan(List<String> names, List<List<MultiStagePosition>> tiles,
+                    double startX, double startY) {
+      RegionPlanner planner = new RegionPlanner(tiles, startX, startY);
+      List<Leg> route = planner.nearestNeighborRoute();
+      planner.improve(route);
+
+      List<MultiStagePosition> positions = new ArrayList<>();
+      List<Integer> regionOrder = new ArrayList<>();
+      int total = 0;
+      for (List<MultiStagePosition> regionTiles : tiles) {
+         total += regionTiles.size();
+      }
+      int[] regionOf = new int[total];
+      int[] indexInRegion = new int[total];
+      for (Leg leg : route) {
+         List<MultiStagePosition> regionTiles = tiles.get(leg.region_);
+         regionOrder.add(leg.region_);
+         for (int i = 0; i < regionTiles.size(); i++) {
+            int index = leg.reversed_ ? regionTiles.size() - 1 - i : i;
+            MultiStagePosition position = MultiStagePosition.newInstance(regionTiles.get(index));
+            position.setLabel(names.get(leg.region_) + "-" + position.getLabel());
+            position.setProperty(REGION_PROPERTY, Integer.toString(leg.region_));
+            regionOf[positions.size()] = leg.region_;
+            indexInRegion[positions.size()] = index;
+            positions.add(position);
+         }
+      }
+      return new Plan(positions, regionOf, indexInRegion,
+            Collections.unmodifiableList(regionOrder), planner.transit(route));
+   }
+
+   private List<Leg> nearestNeighborRoute() {
+      List<Leg> route = new ArrayList<>();
+      boolean[] visited = new boolean[tiles_.size()];
+      double x = startX_;
+      double y = startY_;
+      while (true) {
+         Leg next = null;
+         double nearest = Double.POSITIVE_INFINITY;
+         for (int region = 0; region < tiles_.size(); region++) {
+            if (visited[region] || tiles_.get(region).isEmpty()) {
+               continue;
+            }
+            for (boolean reversed : new boolean[] {false, true}) {
+               Leg leg = new Leg(region, reversed);
+               double distance = distance(x, y, entry(leg));
+               if (distance < nearest) {
+                  nearest = distance;
+                  next = leg;
+               }
+            }
+         }
+         if (next == null) {
+            return route;
+         }
+         visited[next.region_] = true;
+         route.add(next);
+         x = exit(next).getX();
+         y = exit(next).getY();
+      }
+   }
+
+   /**
+    * Reverses segments of the route while this shortens it. Reversing a
+    * segment also reverses the direction of each of its regions.
+    */
+   private void improve(List<Leg> route) {
+      for (int pass = 0; pass < MAX_PASSES; pass++) {
+         boolean improved = false;
+         for (int i = 0; i < route.size(); i++) {
+            for (int j = i; j < route.size(); j++) {
+               MultiStagePosition first = entry(route.get(i));
+               MultiStagePosition last = exit(route.get(j));
+               double before;
+               double after;
+               if (i == 0) {
+                  before = distance(startX_, startY_, first);
+                  after = distance(startX_, startY_, last);
+               } else {
+                  MultiStagePosition previous = exit(route.get(i - 1));
+                  before = distance(previous, first);
+                  after = distance(previous, last);
+               }
+               if (j + 1 < route.size()) {
+                  MultiStagePosition next = entry(route.get(j + 1));
+                  before += distance(last, next);
+                  after += distance(first, next);
+               }
+               if (after < before - 1e-9) {
+                  Collections.reverse(route.subList(i, j + 1));
+                  for (int k = i; k <= j; k++) {
+                     route.set(k, route.get(k).flipped());
+                  }
+                  improved = true;
+               }
+            }
+         }
+         if (!improved) {
+            return;
+         }
+      }
+   }
+
+   private double transit(List<Leg> route) {
+      double total = 0;
+      double x = startX_;
+      double y = startY_;
+      for (Leg leg : route) {
+         total += distance(x, y, entry(leg));
+         x = exit(leg).getX();
+         y = exit(leg).getY();
+      }
+      return total;
+   }
+
+   private MultiStagePosition entry(Leg leg) {
+      List<MultiStagePosition> regionTiles = tiles_.get(leg.region_);
+      return regionTiles.get(leg.reversed_ ? regionTiles.size() - 1 : 0);
+   }
+
+   private MultiStagePosition exit(Leg leg) {
+      List<MultiStagePosition> regionTiles = tiles_.get(leg.region_);
+      return regionTiles.get(leg.reversed_ ? 0 : regionTiles.size() - 1);
+   }
+
+   private static double distance(double x, double y, MultiStagePosition position) {
+      return Math.hypot(position.getX() - x, position.getY() - y);
+   }
+
+   private static double distance(MultiStagePosition a, MultiStagePosition b) {
+      return distance(a.getX(), a.getY(), b);
+   }
+}
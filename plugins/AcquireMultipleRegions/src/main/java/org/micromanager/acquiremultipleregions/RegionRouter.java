@@ -0,0 +1,188 @@
+package org.micromanager.acquiremultipleregions;
+
+import java.io.IOException;
+import java.util.concurrent.ArrayBlockingQueue;
+import java.util.concurrent.BlockingQueue;
+import org.micromanager.data.Coords;
+import org.micromanager.data.Image;
+
+/**
+ * Sends the images of a merged multi-region acquisition to the output of
+ * their region, on a single writer thread.
+ *
+ * <p>The stage position index of each image selects its region, and is
+ * replaced by the index of the tile within that region. The output of a
+ * region is opened when its first image arrives. When opening or writing
+ * to the output of a region fails, the remaining images of that region are
+ * discarded, and the other regions are written as usual.
+ */
+final class RegionRouter {
+
+   /**
+    * Output of a single region.
+    */
+   interface Sink {
+      /**
+       * Writes an image. Called on the writer thread only.
+       */
+      void putImage(Image image) throws IOException;
+
+      /**
+       * Called on the writer thread once all images of the region were written.
+       */
+      void close() throws IOException;
+   }
+
+   /**
+    * Opens the output of a region.
+    */
+   interface SinkFactory {
+      Sink open(int region) throws IOException;
+   }
+
+   // Images waiting to be written; putImage() blocks when full
+   static final int QUEUE_CAPACITY = 32;
+
+   private final int[] regionOf_;
+   private final int[] indexInRegion_;
+   private final SinkFactory factory_;
+   private final BlockingQueue<Object> queue_ = new ArrayBlockingQueue<>(QUEUE_CAPACITY);
+   private final Object end_ = new Object();
+   private final Thread thread_;
+
+   // Accessed from the writer thread only until it finished
+   private final Sink[] sinks_;
+   private final Exception[] errors_;
+   private final int[] written_;
+   private final int[] discarded_;
+   private int unrouted_ = 0;
+
+   /**
+    * Creates a router and starts its writer thread.
+    *
+    * @param regionOf region of each stage position of the merged acquisition
+    * @param indexInRegion index of each stage position within its region
+    * @param numRegions number of regions
+    * @param factory opens the output of each region
+    */
+   RegionRouter(int[] regionOf, int[] indexInRegion, int numRegions, SinkFactory factory) {
+      regionOf_ = regionOf.clone();
+      indexInRegion_ = indexInRegion.clone();
+      factory_ = factory;
+      sinks_ = new Sink[numRegions];
+      errors_ = new Exception[numRegions];
+      written_ = new int[numRegions];
+      discarded_ = new int[numRegions];
+      thread_ = new Thread(this::run, "AcquireMultipleRegions writer");
+      thread_.setDaemon(true);
+      thread_.start();
+   }
+
+   /**
+    * Queues an image for writing. Blocks while the queue is full.
+    */
+   void putImage(Image image) throws InterruptedException {
+      queue_.put(image);
+   }
+
+   /**
+    * Writes the images still queued, closes the outputs of all regions, and
+    * stops the writer thread.
+    */
+   void finish() throws InterruptedException {
+      queue_.put(end_);
+      thread_.join();
+   }
+
+   /**
+    * Returns the error that stopped the output of a region, or null.
+    * Only valid after finish().
+    */
+   Exception getError(int region) {
+      return errors_[region];
+   }
+
+   /**
+    * Returns the number of images written for a region. Only valid after
+    * finish().
+    */
+   int getWritten(int region) {
+      return written_[region];
+   }
+
+   /**
+    * Returns the number of images of a region that were not written
+    * because of an error. Only valid after finish().
+    */
+   int getDiscarded(int region) {
+      return discarded_[region];
+   }
+
+   /**
+    * Returns the number of images whose stage position is not part of any
+    * region. Only valid after finish().
+    */
+   int getUnrouted() {
+      return unrouted_;
+   }
+
+   private void run() {
+      while (true) {
+         Object item;
+         try {
+            item = queue_.take();
+         } catch (InterruptedException e) {
+            // Keep going; images are only discarded on errors
+            continue;
+         }
+         if (item == end_) {
+            break;
+         }
+         route((Image) item);
+      }
+      for (int region = 0; region < sinks_.length; region++) {
+         if (sinks_[region] != null) {
+            try {
+               sinks_[region].close();
+            } catch (IOException | RuntimeException e) {
+               if (errors_[region] == null) {
+                  errors_[region] = e;
+               }
+            }
+         }
+      }
+   }
+
+   private void route(Image image) {
+      Coords coords = image.getCoords();
+      int position = coords.getStagePosition();
+      if (position < 0 || position >= regionOf_.length) {
+         unrouted_++;
+         return;
+      }
+      int region = regionOf_[position];
+      if (errors_[region] != null) {
+         discarded_[region]++;
+         return;
+      }
+      try {
+         if (sinks_[region] == null) {
+            sinks_[region] = factory_.open(region);
+         }
+         sinks_[region].putImage(image.copyAtCoords(
+               coords.copyBuilder().stagePosition(indexInRegion_[position]).build()));
+         written_[region]++;
+      } catch (IOException | RuntimeException e) {
+         errors_[region] = e;
+         discarded_[region]++;
+         if (sinks_[region] != null) {
+            try {
+               sinks_[region].close();
+            } catch (IOException | RuntimeException ignored) {
+               // Report the first error
+            }
+            sinks_[region] = null;
+         }
+      }
+   }
+}
@@ -0,0 +1,125 @@
+package org.micromanager.acquiremultipleregions;
+
+import java.io.IOException;
+import java.io.InterruptedIOException;
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.HashSet;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.Set;
+import org.micromanager.data.Coordinates;
+import org.micromanager.data.Coords;
+import org.micromanager.data.Image;
+import org.micromanager.data.Storage;
+import org.micromanager.data.SummaryMetadata;
+
+/**
+ * Storage of the merged multi-region acquisition. Instead of keeping the
+ * images, it hands them to a RegionRouter, which writes them to the output
+ * of their region. Only the coordinates of the images are kept, and the last
+ * image, so that the Datastore can check for duplicates and report its
+ * extent.
+ */
+final class RoutingStorage implements Storage {
+   private final RegionRouter router_;
+   private final SummaryMetadata summary_;
+   // Guarded by this
+   private final Set<Coords> coords_ = new HashSet<>();
+   private final Map<String, Integer> maxIndices_ = new LinkedHashMap<>();
+   private Image lastImage_ = null;
+
+   RoutingStorage(RegionRouter router, SummaryMetadata summary) {
+      router_ = router;
+      summary_ = summary;
+   }
+
+   @Override
+   public void freeze() {
+   }
+
+   @Override
+   public void putImage(Image image) throws IOException {
+      synchronized (this) {
+         Coords coords = image.getCoords();
+         coords_.add(coords);
+         for (String axis : coords.getAxes()) {
+            maxIndices_.merge(axis, coords.getIndex(axis), Math::max);
+         }
+         lastImage_ = image;
+      }
+      try {
+         router_.putImage(image);
+      } catch (InterruptedException e) {
+         Thread.currentThread().interrupt();
+         throw new InterruptedIOException("Interrupted while queuing image for writing");
+      }
+   }
+
+   @Override
+   public Image getImage(Coords coords) {
+      return null;
+   }
+
+   @Override
+   public synchronized boolean hasImage(Coords coords) {
+      return coords_.contains(coords);
+   }
+
+   @Override
+   public synchronized Image getAnyImage() {
+      return lastImage_;
+   }
+
+   @Override
+   public synchronized Iterable<Coords> getUnorderedImageCoords() {
+      return new ArrayList<>(coords_);
+   }
+
+   @Override
+   public List<Image> getImagesMatching(Coords coords) {
+      return Collections.emptyList();
+   }
+
+   @Override
+   public List<Image> getImagesIgnoringAxes(Coords coords, String... ignoreTheseAxes) {
+      return Collections.emptyList();
+   }
+
+   @Override
+   public synchronized int getMaxIndex(String axis) {
+      return maxIndices_.getOrDefault(axis, -1);
+   }
+
+   @Override
+   public synchronized List<String> getAxes() {
+      if (summary_ != null && summary_.getOrderedAxes() != null) {
+         return summary_.getOrderedAxes();
+      }
+      return new ArrayList<>(maxIndices_.keySet());
+   }
+
+   @Override
+   public synchronized Coords getMaxIndices() {
+      Coords.Builder builder = Coordinates.builder();
+      for (Map.Entry<String, Integer> entry : maxIndices_.entrySet()) {
+         builder.index(entry.getKey(), entry.getValue());
+      }
+      return builder.build();
+   }
+
+   @Override
+   public SummaryMetadata getSummaryMetadata() {
+      return summary_;
+   }
+
+   @Override
+   public synchronized int getNumImages() {
+      return coords_.size();
+   }
+
+   @Override
+   public void close() {
+   }
+}
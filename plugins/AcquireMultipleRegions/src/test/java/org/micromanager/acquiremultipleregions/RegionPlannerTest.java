@@ -0,0 +1,138 @@
+package org.micromanager.acquiremultipleregions;
+
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.Collections;
+import java.util.List;
+import org.junit.Assert;
+import org.junit.Test;
+import org.micromanager.MultiStagePosition;
+
+public class RegionPlannerTest {
+   private static final String XY_STAGE = "XY";
+   private static final String Z_STAGE = "Z";
+
+   /**
+    * Stage as in the demo configuration: moves in straight lines and keeps
+    * track of the distance traveled.
+    */
+   private static final class SimulatedStage {
+      private double x_;
+      private double y_;
+      private double traveled_ = 0.0;
+
+      private SimulatedStage(double x, double y) {
+         x_ = x;
+         y_ = y;
+      }
+
+      private void moveTo(MultiStagePosition position) {
+         traveled_ += Math.hypot(position.getX() - x_, position.getY() - y_);
+         x_ = position.getX();
+         y_ = position.getY();
+      }
+   }
+
+   // Serpentine grid of nx by ny tiles, 100 um apart, starting at (x0, y0)
+   private static List<MultiStagePosition> grid(double x0, double y0, int nx, int ny) {
+      List<MultiStagePosition> tiles = new ArrayList<>();
+      for (int row = 0; row < ny; row++) {
+         for (int i = 0; i < nx; i++) {
+            int col = row % 2 == 0 ? i : nx - 1 - i;
+            MultiStagePosition tile = new MultiStagePosition(XY_STAGE,
+                  x0 + col * 100, y0 + row * 100, Z_STAGE, 0.0);
+            tile.setLabel("1-Pos" + tiles.size());
+            tiles.add(tile);
+         }
+      }
+      return tiles;
+   }
+
+   private static double travel(List<MultiStagePosition> positions) {
+      SimulatedStage stage = new SimulatedStage(0.0, 0.0);
+      for (MultiStagePosition position : positions) {
+         stage.moveTo(position);
+      }
+      return stage.traveled_;
+   }
+
+   private static List<String> names(int count) {
+      List<String> names = new ArrayList<>();
+      for (int i = 0; i < count; i++) {
+         names.add("region" + i);
+      }
+      return names;
+   }
+
+   @Test
+   public void scatteredRegionsTravelLess() {
+      // Regions listed in the order the user happened to mark them
+      List<List<MultiStagePosition>> tiles = Arrays.asList(
+            grid(20000, 0, 3, 3),
+            grid(0, 500, 3, 2),
+            grid(20000, 15000, 2, 2),
+            grid(5000, 0, 4, 3),
+            grid(0, 15000, 3, 3),
+            grid(10000, 8000, 2, 3));
+      List<MultiStagePosition> given = new ArrayList<>();
+      for (List<MultiStagePosition> regionTiles : tiles) {
+         given.addAll(regionTiles);
+      }
+      RegionPlanner.Plan plan = RegionPlanner.plan(names(tiles.size()), tiles, 0.0, 0.0);
+
+      Assert.assertEquals(given.size(), plan.getPositions().size());
+      double planned = travel(plan.getPositions());
+      Assert.assertTrue(planned + " >= " + travel(given), planned < travel(given));
+      Assert.assertEquals(6, plan.getRegionOrder().size());
+   }
+
+   @Test
+   public void tilesOfRegionStayTogether() {
+      List<List<MultiStagePosition>> tiles = Arrays.asList(
+            grid(10000, 10000, 3, 2), grid(0, 0, 2, 2), grid(10000, 0, 2, 3));
+      RegionPlanner.Plan plan = RegionPlanner.plan(names(3), tiles, 0.0, 0.0);
+      int[] regionOf = plan.getRegionOf();
+      int[] indexInRegion = plan.getIndexInRegion();
+      List<Integer> seen = new ArrayList<>();
+      for (int i = 0; i < regionOf.length; i++) {
+         if (seen.isEmpty() || seen.get(seen.size() - 1) != regionOf[i]) {
+            Assert.assertFalse("region " + regionOf[i] + " is split",
+                  seen.contains(regionOf[i]));
+            seen.add(regionOf[i]);
+         }
+         MultiStagePosition position = plan.getPositions().get(i);
+         MultiStagePosition tile = tiles.get(regionOf[i]).get(indexInRegion[i]);
+         Assert.assertEquals(tile.getX(), position.getX(), 0.0);
+         Assert.assertEquals(tile.getY(), position.getY(), 0.0);
+         Assert.assertEquals("region" + regionOf[i] + "-" + tile.getLabel(),
+               position.getLabel());
+         Assert.assertEquals(Integer.toString(regionOf[i]),
+               position.getProperty(RegionPlanner.REGION_PROPERTY));
+      }
+      Assert.assertEquals(seen, plan.getRegionOrder());
+      // The closest region is acquired first
+      Assert.assertEquals(1, (int) plan.getRegionOrder().get(0));
+      // The tiles of the user are left as they were
+      Assert.assertNull(tiles.get(0).get(0).getProperty(RegionPlanner.REGION_PROPERTY));
+   }
+
+   @Test
+   public void regionIsEnteredAtNearestEnd() {
+      // The last tile of this region is closest to the stage
+      List<MultiStagePosition> tiles = grid(0, 0, 4, 1);
+      RegionPlanner.Plan plan = RegionPlanner.plan(names(1),
+            Collections.singletonList(tiles), 1000.0, 0.0);
+      Assert.assertArrayEquals(new int[] {3, 2, 1, 0}, plan.getIndexInRegion());
+      Assert.assertEquals(700.0, plan.getTransitUm(), 1e-9);
+   }
+
+   @Test
+   public void emptyRegionsAreSkipped() {
+      List<List<MultiStagePosition>> tiles = Arrays.asList(
+            grid(0, 0, 2, 1), Collections.<MultiStagePosition>emptyList(), grid(500, 0, 1, 1));
+      RegionPlanner.Plan plan = RegionPlanner.plan(names(3), tiles, 0.0, 0.0);
+      Assert.assertEquals(Arrays.asList(0, 2), plan.getRegionOrder());
+      Assert.assertArrayEquals(new int[] {0, 0, 2}, plan.getRegionOf());
+      Assert.assertEquals(400.0, plan.getTransitUm(), 1e-9);
+   }
+}
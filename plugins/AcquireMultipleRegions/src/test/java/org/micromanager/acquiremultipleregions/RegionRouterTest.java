@@ -0,0 +1,141 @@
+package org.micromanager.acquiremultipleregions;
+
+import java.io.IOException;
+import java.util.ArrayList;
+import java.util.HashMap;
+import java.util.List;
+import java.util.Map;
+import org.junit.Assert;
+import org.junit.Test;
+import org.micromanager.data.Coordinates;
+import org.micromanager.data.Image;
+import org.micromanager.data.internal.DefaultImage;
+
+public class RegionRouterTest {
+   private static final int WIDTH = 8;
+   private static final int HEIGHT = 4;
+
+   // Merged acquisition: region 1 first, then region 0, then region 2
+   private static final int[] REGION_OF = {1, 1, 0, 0, 0, 2, 2};
+   private static final int[] INDEX_IN_REGION = {1, 0, 0, 1, 2, 0, 1};
+
+   private static final class CollectingSink implements RegionRouter.Sink {
+      private final List<Image> images_ = new ArrayList<>();
+      private boolean closed_ = false;
+
+      @Override
+      public void putImage(Image image) {
+         Assert.assertFalse(closed_);
+         images_.add(image);
+      }
+
+      @Override
+      public void close() {
+         closed_ = true;
+      }
+   }
+
+   private static final class FailingSink implements RegionRouter.Sink {
+      private final int failAt_;
+      private int count_ = 0;
+      private boolean closed_ = false;
+
+      private FailingSink(int failAt) {
+         failAt_ = failAt;
+      }
+
+      @Override
+      public void putImage(Image image) throws IOException {
+         if (count_++ == failAt_) {
+            throw new IOException("Disk full");
+         }
+      }
+
+      @Override
+      public void close() {
+         closed_ = true;
+      }
+   }
+
+   private static Image createImage(int position, int z) {
+      short[] pixels = new short[WIDTH * HEIGHT];
+      pixels[0] = (short) position;
+      return new DefaultImage(pixels, WIDTH, HEIGHT, 2, 1,
+            Coordinates.builder().stagePosition(position).z(z).build(), null);
+   }
+
+   private static void acquire(RegionRouter router) throws InterruptedException {
+      for (int position = 0; position < REGION_OF.length; position++) {
+         for (int z = 0; z < 2; z++) {
+            router.putImage(createImage(position, z));
+         }
+      }
+   }
+
+   @Test
+   public void imagesReachTheirRegion() throws Exception {
+      Map<Integer, CollectingSink> sinks = new HashMap<>();
+      RegionRouter router = new RegionRouter(REGION_OF, INDEX_IN_REGION, 3, region -> {
+         CollectingSink sink = new CollectingSink();
+         sinks.put(region, sink);
+         return sink;
+      });
+      acquire(router);
+      router.finish();
+
+      Assert.assertEquals(3, sinks.size());
+      Assert.assertEquals(6, router.getWritten(0));
+      Assert.assertEquals(0, router.getUnrouted());
+      for (int region = 0; region < 3; region++) {
+         CollectingSink sink = sinks.get(region);
+         Assert.assertNull(router.getError(region));
+         Assert.assertTrue(sink.closed_);
+         Assert.assertEquals(router.getWritten(region), sink.images_.size());
+         for (Image image : sink.images_) {
+            int position = ((short[]) image.getRawPixels())[0];
+            Assert.assertEquals(region, REGION_OF[position]);
+            Assert.assertEquals(INDEX_IN_REGION[position],
+                  image.getCoords().getStagePosition());
+         }
+      }
+      // Region 1 was acquired in reverse tile order
+      Assert.assertEquals(1, sinks.get(1).images_.get(0).getCoords().getStagePosition());
+   }
+
+   @Test
+   public void failingRegionDoesNotStopOthers() throws Exception {
+      Map<Integer, CollectingSink> sinks = new HashMap<>();
+      FailingSink failing = new FailingSink(2);
+      RegionRouter router = new RegionRouter(REGION_OF, INDEX_IN_REGION, 3, region -> {
+         if (region == 0) {
+            return failing;
+         }
+         if (region == 2) {
+            throw new IOException("Directory not writable");
+         }
+         CollectingSink sink = new CollectingSink();
+         sinks.put(region, sink);
+         return sink;
+      });
+      acquire(router);
+      // Not part of any region
+      router.putImage(createImage(REGION_OF.length, 0));
+      router.finish();
+
+      Assert.assertNull(router.getError(1));
+      Assert.assertEquals(4, router.getWritten(1));
+      Assert.assertEquals(4, sinks.get(1).images_.size());
+      Assert.assertTrue(sinks.get(1).closed_);
+
+      Assert.assertTrue(router.getError(0) instanceof IOException);
+      Assert.assertEquals(2, router.getWritten(0));
+      Assert.assertEquals(4, router.getDiscarded(0));
+      Assert.assertTrue(failing.closed_);
+
+      Assert.assertNotNull(router.getError(2));
+      Assert.assertEquals(0, router.getWritten(2));
+      Assert.assertEquals(4, router.getDiscarded(2));
+
+      Assert.assertEquals(1, router.getUnrouted());
+   }
+}
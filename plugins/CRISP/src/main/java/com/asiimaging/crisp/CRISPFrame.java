@@ -69,7 +69,7 @@ public class CRISPFrame extends JFrame {
 
       crisp = new CRISP(studio);
       zStage = new ZStage(studio);
-      timer = new CRISPTimer(crisp);
+      timer = new CRISPTimer(studio, crisp);
 
       // save/load user settings
       settings = new UserSettings(studio, crisp, timer, this);
@@ -8,6 +8,7 @@
 package com.asiimaging.crisp.panels;
 
 import com.asiimaging.devices.crisp.CRISP;
+import com.asiimaging.devices.crisp.PropName;
 import com.asiimaging.ui.Panel;
 import java.awt.Dimension;
 import java.util.Objects;
@@ -88,13 +89,11 @@ public class StatusPanel extends Panel {
       add(lblOffsetValue, "wrap");
    }
 
-   // NOTE: this method always takes about 250 ms!!!
-   // TODO: this method is slowing down the UI, fix it.
-
    /**
     * Updates the user interface with new values queried from CRISP.
-    * This method is called every tick of the polling task, except
-    * after CRISP enters the Log Cal state for several ticks.
+    * This method reads all values on the calling thread; while polling,
+    * the values are set by the {@link com.asiimaging.devices.crisp.CRISPTimer}
+    * as they are read in the background.
     */
    public void update() {
       setLabelText(lblStateValue, crisp.getState());
@@ -105,6 +104,43 @@ public class StatusPanel extends Panel {
       setLabelText(lblOffsetValue, crisp.getOffsetString());
    }
 
+   /**
+    * Shows a value read from CRISP. Must be called on the Event Dispatch Thread.
+    *
+    * @param property the property name
+    * @param text the value, or an empty String if it could not be read
+    */
+   public void setValue(final String property, final String text) {
+      switch (property) {
+         case PropName.CRISP_STATE:
+            setLabelText(lblStateValue, text);
+            break;
+         case PropName.DITHER_ERROR:
+            setLabelText(lblErrorValue, text);
+            break;
+         case PropName.SNR:
+            setLabelText(lblSNRValue, text);
+            break;
+         case PropName.LOG_AMP_AGC:
+            setLabelText(lblAGCValue, text);
+            break;
+         case PropName.SUM:
+            setLabelText(lblSumValue, text);
+            break;
+         default:
+            break;
+      }
+   }
+
+   /**
+    * Shows the autofocus offset. Must be called on the Event Dispatch Thread.
+    *
+    * @param text the offset, or an empty String if it could not be read
+    */
+   public void setOffset(final String text) {
+      setLabelText(lblOffsetValue, text);
+   }
+
    /**
     * Sets the JLabel text if the String is not empty.
     *
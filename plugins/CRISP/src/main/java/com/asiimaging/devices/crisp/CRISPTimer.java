@@ -8,25 +8,53 @@
 package com.asiimaging.devices.crisp;
 
 import com.asiimaging.crisp.panels.StatusPanel;
-import java.awt.event.ActionListener;
+import java.util.ArrayList;
+import java.util.List;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.RejectedExecutionException;
+import java.util.concurrent.atomic.AtomicBoolean;
+import javax.swing.SwingUtilities;
 import javax.swing.Timer;
+import org.micromanager.PropertyPoller;
+import org.micromanager.Studio;
 
 /**
- * A SwingTimer that helps update the ui with values queried from CRISP.
+ * Updates the ui with values queried from CRISP.
+ *
+ * <p>The values are read in the background by the shared property poller of
+ * Micro-Manager, so that a slow serial response does not freeze the ui.
  */
 public class CRISPTimer {
 
+   // the properties shown in the status panel
+   private static final String[] POLLED_PROPERTIES = {
+         PropName.CRISP_STATE,
+         PropName.DITHER_ERROR,
+         PropName.SNR,
+         PropName.LOG_AMP_AGC,
+         PropName.SUM
+   };
+
    private int pollRateMs;
    private int skipCounter;
    private int skipRefresh;
-   private ActionListener pollTask;
 
-   private Timer timer;
+   private Timer countdownTimer;
    private StatusPanel panel;
    private final CRISP crisp;
+   private final Studio studio;
+   private final List<PropertyPoller.Subscription> subscriptions;
+
+   // the offset is not a property, it is read on this thread while polling
+   private volatile ExecutorService offsetExecutor;
+   private final AtomicBoolean offsetPending;
 
-   public CRISPTimer(final CRISP crisp) {
+   public CRISPTimer(final Studio studio, final CRISP crisp) {
+      this.studio = studio;
       this.crisp = crisp;
+      subscriptions = new ArrayList<>();
+      offsetPending = new AtomicBoolean(false);
       skipCounter = 0;
       skipRefresh = 10; // this value changes based on pollRateMs
       pollRateMs = 250;
@@ -38,30 +66,66 @@ public class CRISPTimer {
    }
 
    /**
-    * Create the task to be run every tick of the timer.
+    * Set the panel to update, and create the timer that counts down
+    * while polling is skipped.
     *
     * @param panel the Panel to update
     */
    public void createTimerTask(final StatusPanel panel) {
       this.panel = panel;
-      createPollingTask();
-      timer = new Timer(pollRateMs, pollTask);
+      countdownTimer = new Timer(pollRateMs, event -> {
+         if (skipCounter > 0) {
+            skipCounter--;
+            panel.setStateLabelText("Calibrating..." + computeRemainingSeconds() + "s");
+         } else {
+            countdownTimer.stop();
+         }
+      });
    }
 
    /**
-    * Create the event handler that is called at the polling rate in milliseconds.
+    * Called on the property poller thread with each new value.
     *
-    * <p>The polling task runs on the Event Dispatch Thread.
+    * @param value the value read from CRISP
     */
-   private void createPollingTask() {
-      pollTask = event -> {
+   private void onValue(final PropertyPoller.Value value) {
+      final String text = value.getValue() == null ? "" : value.getValue();
+      // refresh the offset along with the state
+      if (value.getProperty().equals(PropName.CRISP_STATE)) {
+         requestOffset();
+      }
+      SwingUtilities.invokeLater(() -> {
          if (skipCounter > 0) {
-            skipCounter--;
-            panel.setStateLabelText("Calibrating..." + computeRemainingSeconds() + "s");
-         } else {
-            panel.update();
+            return;
          }
-      };
+         panel.setValue(value.getProperty(), text);
+      });
+   }
+
+   /**
+    * Reads the autofocus offset on the offset thread, unless a read is
+    * already pending, so that the poller thread is not blocked by it.
+    */
+   private void requestOffset() {
+      final ExecutorService executor = offsetExecutor;
+      if (executor == null || !offsetPending.compareAndSet(false, true)) {
+         return;
+      }
+      try {
+         executor.execute(() -> {
+            offsetPending.set(false);
+            final String offset = crisp.getOffsetString();
+            SwingUtilities.invokeLater(() -> {
+               if (skipCounter > 0) {
+                  return;
+               }
+               panel.setOffset(offset);
+            });
+         });
+      } catch (RejectedExecutionException e) {
+         // polling was stopped
+         offsetPending.set(false);
+      }
    }
 
    /**
@@ -78,23 +142,43 @@ public class CRISPTimer {
    }
 
    /**
-    * Start the Swing timer.
+    * Start polling.
     */
    public void start() {
-      timer.start();
+      if (!subscriptions.isEmpty()) {
+         return;
+      }
+      offsetExecutor = Executors.newSingleThreadExecutor(runnable -> {
+         final Thread thread = new Thread(runnable, "CRISP offset");
+         thread.setDaemon(true);
+         return thread;
+      });
+      for (final String property : POLLED_PROPERTIES) {
+         subscriptions.add(studio.propertyPoller().subscribe(
+               crisp.getDeviceName(), property, pollRateMs, this::onValue));
+      }
       if (crisp.isTiger()) {
          crisp.setRefreshPropertyValues(true);
       }
    }
 
    /**
-    * Stop the Swing timer.
+    * Stop polling.
     */
    public void stop() {
       if (crisp.isTiger()) {
          crisp.setRefreshPropertyValues(false);
       }
-      timer.stop();
+      for (final PropertyPoller.Subscription subscription : subscriptions) {
+         subscription.cancel();
+      }
+      subscriptions.clear();
+      if (offsetExecutor != null) {
+         offsetExecutor.shutdown();
+         offsetExecutor = null;
+      }
+      skipCounter = 0;
+      countdownTimer.stop();
    }
 
    /**
@@ -102,9 +186,12 @@ public class CRISPTimer {
     */
    public void onLogCal() {
       // controller becomes unresponsive during loG_cal => skip polling a few times
-      if (timer.isRunning()) {
+      if (!subscriptions.isEmpty()) {
          skipCounter = skipRefresh;
-         timer.restart();
+         for (final PropertyPoller.Subscription subscription : subscriptions) {
+            subscription.postpone((long) skipRefresh * pollRateMs);
+         }
+         countdownTimer.restart();
          panel.setStateLabelText("Calibrating..." + computeRemainingSeconds() + "s");
       }
    }
@@ -119,15 +206,17 @@ public class CRISPTimer {
    }
 
    /**
-    * Set the polling rate of the Swing timer.
+    * Set the polling rate.
     *
     * @param rate the polling rate in milliseconds
     */
    public void setPollRateMs(final int rate) {
       skipRefresh = Math.round(2500.0f / rate);
       pollRateMs = rate;
-      timer.setDelay(rate);
+      countdownTimer.setDelay(rate);
+      for (final PropertyPoller.Subscription subscription : subscriptions) {
+         subscription.setPeriodMs(rate);
+      }
    }
 
 }
-
@@ -0,0 +1,177 @@
+///////////////////////////////////////////////////////////////////////////////
+//FILE:          DatasetSubset.java
+//PROJECT:       Micro-Manager 
+//SUBSYSTEM:     Duplicator plugin
+//-----------------------------------------------------------------------------
+//
+// COPYRIGHT:    Regents of the University of California 2024
+//
+// LICENSE:      This file is distributed under the BSD license.
+//               License text is included with the source distribution.
+//
+//               This file is distributed in the hope that it will be useful,
+//               but WITHOUT ANY WARRANTY; without even the implied warranty
+//               of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//               IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//               CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//               INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+package org.micromanager.duplicator;
+
+import java.awt.Rectangle;
+import java.lang.reflect.Array;
+import java.util.ArrayList;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Map;
+import org.micromanager.data.Coords;
+import org.micromanager.data.Image;
+import org.micromanager.data.internal.DefaultImage;
+
+/**
+ * Describes which part of a dataset to copy: a range of indices along some
+ * axes, a subset of the channels, and a rectangle of each image.
+ *
+ * <p>The selection is compiled once into arrays, so that deciding whether an
+ * image is part of the subset, and where it goes, takes one pass over the
+ * restricted axes. Immutable and thread safe.
+ */
+public final class DatasetSubset {
+   private final String[] axes_;
+   private final int[] mins_;
+   private final int[] maxes_;
+   // New channel index for each old channel index, -1 if not copied; null
+   // if all channels are copied
+   private final int[] channelMap_;
+   private final Rectangle crop_;
+
+   private DatasetSubset(String[] axes, int[] mins, int[] maxes, int[] channelMap,
+                         Rectangle crop) {
+      axes_ = axes;
+      mins_ = mins;
+      maxes_ = maxes;
+      channelMap_ = channelMap;
+      crop_ = crop;
+   }
+
+   /**
+    * Compiles a subset.
+    *
+    * @param mins lowest index to copy, per axis; axes without an entry are
+    *             copied entirely. The channel axis is selected with channels.
+    * @param maxes highest index to copy, for each axis in mins
+    * @param channels for each channel, in index order, whether to copy it;
+    *                 null or empty to copy all channels
+    * @param crop part of each image to copy, or null to copy whole images
+    * @return the subset
+    */
+   public static DatasetSubset create(Map<String, Integer> mins,
+                                      Map<String, Integer> maxes,
+                                      LinkedHashMap<String, Boolean> channels,
+                                      Rectangle crop) {
+      List<String> axes = new ArrayList<>();
+      for (String axis : mins.keySet()) {
+         if (!Coords.CHANNEL.equals(axis) && maxes.containsKey(axis)) {
+            axes.add(axis);
+         }
+      }
+      int[] minArray = new int[axes.size()];
+      int[] maxArray = new int[axes.size()];
+      for (int i = 0; i < axes.size(); i++) {
+         minArray[i] = mins.get(axes.get(i));
+         maxArray[i] = maxes.get(axes.get(i));
+      }
+      int[] channelMap = null;
+      if (channels != null && !channels.isEmpty()) {
+         channelMap = new int[channels.size()];
+         int newIndex = 0;
+         int oldIndex = 0;
+         for (Boolean selected : channels.values()) {
+            channelMap[oldIndex++] = selected ? newIndex++ : -1;
+         }
+      }
+      return new DatasetSubset(axes.toArray(new String[0]), minArray, maxArray,
+            channelMap, crop == null ? null : new Rectangle(crop));
+   }
+
+   /**
+    * Returns the coords of an image in the copy.
+    *
+    * @param coords coords of the image in the original dataset
+    * @return coords in the copy, or null if the image is not part of the subset
+    */
+   public Coords map(Coords coords) {
+      Coords.CoordsBuilder builder = null;
+      for (int i = 0; i < axes_.length; i++) {
+         int index = coords.getIndex(axes_[i]);
+         if (index < mins_[i] || index > maxes_[i]) {
+            return null;
+         }
+         if (mins_[i] != 0) {
+            if (builder == null) {
+               builder = coords.copyBuilder();
+            }
+            builder.index(axes_[i], index - mins_[i]);
+         }
+      }
+      if (channelMap_ != null && coords.hasAxis(Coords.CHANNEL)) {
+         int channel = coords.getChannel();
+         if (channel >= channelMap_.length || channelMap_[channel] < 0) {
+            return null;
+         }
+         if (channelMap_[channel] != channel) {
+            if (builder == null) {
+               builder = coords.copyBuilder();
+            }
+            builder.channel(channelMap_[channel]);
+         }
+      }
+      return builder == null ? coords : builder.build();
+   }
+
+   /**
+    * Returns the part of an image that is copied, at its new coords. Without
+    * a crop, the result shares the pixels of the original.
+    *
+    * @param image image in the original dataset
+    * @param coords coords of the image in the copy, as returned by map()
+    * @return the image for the copy
+    */
+   public Image apply(Image image, Coords coords) {
+      if (crop_ == null || (crop_.x <= 0 && crop_.y <= 0
+            && crop_.x + crop_.width >= image.getWidth()
+            && crop_.y + crop_.height >= image.getHeight())) {
+         return image.copyAtCoords(coords);
+      }
+      Rectangle r = crop_.intersection(
+            new Rectangle(0, 0, image.getWidth(), image.getHeight()));
+      if (r.isEmpty()) {
+         throw new IllegalArgumentException("Crop " + crop_ + " is outside of the image");
+      }
+      Object pixels = image.getRawPixels();
+      // RGB images have one byte per component in a byte array
+      int elementsPerPixel = pixels instanceof byte[] ? image.getBytesPerPixel() : 1;
+      Object cropped = Array.newInstance(pixels.getClass().getComponentType(),
+            r.width * r.height * elementsPerPixel);
+      int rowLength = r.width * elementsPerPixel;
+      for (int y = 0; y < r.height; y++) {
+         System.arraycopy(pixels, ((r.y + y) * image.getWidth() + r.x) * elementsPerPixel,
+               cropped, y * rowLength, rowLength);
+      }
+      return new DefaultImage(cropped, r.width, r.height, image.getBytesPerPixel(),
+            image.getNumComponents(), coords, image.getMetadata());
+   }
+
+   /**
+    * Returns the size of the images in the copy.
+    *
+    * @param width width of the original images
+    * @param height height of the original images
+    * @return size after cropping
+    */
+   public Rectangle getCroppedBounds(int width, int height) {
+      Rectangle bounds = new Rectangle(0, 0, width, height);
+      return crop_ == null ? bounds : crop_.intersection(bounds);
+   }
+}
@@ -21,25 +21,26 @@
 
 package org.micromanager.duplicator;
 
+import com.google.common.eventbus.Subscribe;
 import ij.gui.Roi;
-import ij.process.ImageProcessor;
 import java.awt.Component;
+import java.awt.Rectangle;
 import java.io.IOException;
 import java.util.ArrayList;
-import java.util.Collections;
-import java.util.Comparator;
 import java.util.LinkedHashMap;
 import java.util.List;
 import java.util.Map;
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.TimeUnit;
 import javax.swing.JOptionPane;
 import javax.swing.SwingWorker;
 import org.micromanager.Studio;
 import org.micromanager.data.Coords;
 import org.micromanager.data.DataProvider;
+import org.micromanager.data.DataProviderHasNewSummaryMetadataEvent;
 import org.micromanager.data.Datastore;
 import org.micromanager.data.DatastoreFrozenException;
 import org.micromanager.data.DatastoreRewriteException;
-import org.micromanager.data.Image;
 import org.micromanager.data.SummaryMetadata;
 import org.micromanager.display.ChannelDisplaySettings;
 import org.micromanager.display.DataViewer;
@@ -54,6 +55,9 @@ import org.micromanager.display.internal.displaywindow.DisplayController;
  * @author nico
  */
 public class DuplicatorExecutor extends SwingWorker<Void, Void> {
+   // Images read ahead of the copy, to keep reading and writing busy
+   private static final long IN_FLIGHT_BYTES = 256L * 1024 * 1024;
+
    private final Studio studio_;
    private final DisplayWindow theWindow_;
    private final String newName_;
@@ -185,26 +189,22 @@ public class DuplicatorExecutor extends SwingWorker<Void, Void> {
          newDisplaySettingsBuilder.channels(channelDisplaySettings);
       }
       newSizeCoordsBuilder.channel(channelNames.size());
-      float  nrToBeCopied = 1;
-      if (channels_ != null && channels_.size() > 0) {
-         nrToBeCopied *= channels_.size();
-      }
       for (String axis : oldStore.getAxes()) {
          if (mins_.containsKey(axis)) {
             int min = mins_.get(axis);
             int max = maxes_.get(axis);
             newSizeCoordsBuilder.index(axis, max - min);
-            nrToBeCopied *= (max - min + 1);
          }
       }
 
+      final DatasetSubset subset = DatasetSubset.create(mins_, maxes_, channels_,
+            roi == null ? null : roi.getBounds());
       Integer width = oldMetadata.getImageWidth();
-      if (roi != null) {
-         width = roi.getBounds().width;
-      }
       Integer height = oldMetadata.getImageHeight();
-      if (roi != null) {
-         height = roi.getBounds().height;
+      if (roi != null && width != null && height != null) {
+         Rectangle bounds = subset.getCroppedBounds(width, height);
+         width = bounds.width;
+         height = bounds.height;
       }
 
       CloseViewerListener closeListener = null;
@@ -221,22 +221,26 @@ public class DuplicatorExecutor extends SwingWorker<Void, Void> {
                  .intendedDimensions(newSizeCoordsBuilder.build())
                  .build();
 
-         newStore.setSummaryMetadata(metadata);
          // The implementations of the store set SummaryMetadata on another thread.
-         // This can lead to disasters, so we have to poll to make sure SummaryMetadata is
-         // there.   Copied from DefaultDataSaver.
-         long startTime = System.currentTimeMillis();
-         boolean timeOut = false;
-         while (!timeOut && newStore.getSummaryMetadata() == null) {
-            if (System.currentTimeMillis() - startTime > 10000) {
-               timeOut = true;
-            }
-            try {
-               Thread.sleep(100);
-            } catch (InterruptedException e) {
-               timeOut = true;
-               studio_.logs().logError(e);
+         // Wait for the event that signals that the storage has it; our
+         // subscriber runs after the storage's own, higher priority one.
+         final CountDownLatch summaryMetadataSet = new CountDownLatch(1);
+         Object summaryMetadataListener = new Object() {
+            @Subscribe
+            public void onNewSummaryMetadata(DataProviderHasNewSummaryMetadataEvent e) {
+               summaryMetadataSet.countDown();
             }
+         };
+         newStore.registerForEvents(summaryMetadataListener);
+         boolean timeOut;
+         try {
+            newStore.setSummaryMetadata(metadata);
+            timeOut = !summaryMetadataSet.await(10, TimeUnit.SECONDS);
+         } catch (InterruptedException e) {
+            timeOut = true;
+            studio_.logs().logError(e);
+         } finally {
+            newStore.unregisterForEvents(summaryMetadataListener);
          }
          if (timeOut) {
             studio_.logs().showError("Failed to save data");
@@ -249,104 +253,23 @@ public class DuplicatorExecutor extends SwingWorker<Void, Void> {
          closeListener = new CloseViewerListener(copyDisplay);
          copyDisplay.addListener(closeListener, 1);
 
-         Iterable<Coords> unorderedImageCoords = oldStore.getUnorderedImageCoords();
-         List<Coords> orderedImageCoords = new ArrayList<>();
-         for (Coords c : unorderedImageCoords) {
-            orderedImageCoords.add(c);
-         }
-         final List<String> axisOrder = oldStore.getSummaryMetadata().getOrderedAxes();
-         Collections.reverse(axisOrder);
-
-         Collections.sort(orderedImageCoords, new Comparator<Coords>() {
-            @Override
-            public int compare(Coords o1, Coords o2) {
-               for (String axis : axisOrder) {
-                  if (o1.getIndex(axis)  < o2.getIndex(axis)) {
-                     return -1;
-                  }  else if (o1.getIndex(axis) > o2.getIndex(axis)) {
-                     return 1;
-                  }
-               }
-               return 0;
+         final SubsetCopier copier = new SubsetCopier(oldStore, newStore, subset,
+               Math.min(4, Runtime.getRuntime().availableProcessors()), IN_FLIGHT_BYTES);
+         final int nrToBeCopied = Math.max(1, copier.countImages());
+         final CloseViewerListener listener = closeListener;
+         copier.copy(copied -> {
+            if (listener.isCancelled()) {
+               return false;
             }
+            setProgress(Math.min(100, (int) (copied * 100L / nrToBeCopied)));
+            return true;
          });
-
-         int nrCopied = 0;
-         for (Coords oldCoord : orderedImageCoords) {
-            List<String> oldAxes = oldStore.getAxes();
-            boolean copy = !oldAxes.contains(Coords.CHANNEL);
-            for (String axis : oldStore.getAxes()) {
-               if (axis.equals(Coords.CHANNEL)) {
-                  int index = 0;
-                  for (Map.Entry<String, Boolean> channel : channels_.entrySet()) {
-                     if (channel.getValue() && oldCoord.getIndex(axis) == index) {
-                        copy = true;
-                        continue;
-                     }
-                     index++;
-                  }
-               }
-            }
-            for (String axis : oldStore.getAxes()) {
-               if (copy && mins_.containsKey(axis) && maxes_.containsKey(axis)) {
-                  if (oldCoord.getIndex(axis) < (mins_.get(axis))) {
-                     copy = false;
-                  }
-                  if (oldCoord.getIndex(axis) > maxes_.get(axis)) {
-                     copy = false;
-                  }
-               }
-            }
-            if (copy) {
-               Coords.CoordsBuilder newCoordBuilder = oldCoord.copyBuilder();
-               for (String axis : oldCoord.getAxes()) {
-                  if (axis.equals(Coords.CHANNEL)) {
-                     if (channels_ != null && channels_.size() > 0) {
-                        int chIndex = oldCoord.getIndex(axis);
-                        if (chIndex < oldMetadata.getChannelNameList().size()) {
-                           String channelName = oldMetadata.getChannelNameList().get(chIndex);
-                           if (channelNames.contains(channelName)) {
-                              int newIndex = channelNames.indexOf(channelName);
-                              newCoordBuilder.index(axis, newIndex);
-                           }
-                        }
-                     }
-                  }
-                  if (mins_.containsKey(axis)) {
-                     newCoordBuilder.index(axis, oldCoord.getIndex(axis) - mins_.get(axis));
-                  }
-               }
-               Image img = oldStore.getImage(oldCoord);
-               Coords newCoords = newCoordBuilder.build();
-               Image newImgShallow = img.copyAtCoords(newCoords);
-               if (roi != null) {
-                  ImageProcessor ip = studio_.data().ij().createProcessor(img);
-                  if (ip != null) {
-                     ip.setRoi(roi);
-                     ImageProcessor copyIp = ip.crop();
-                     newImgShallow = studio_.data().createImage(copyIp.getPixels(), 
-                             copyIp.getWidth(), copyIp.getHeight(), 
-                             img.getBytesPerPixel(), img.getNumComponents(), 
-                             newCoords, newImgShallow.getMetadata());
-                  } else {
-                     throw new DuplicatorException(
-                           "Unsupported pixel type.  Can only copy 8 or 16 bit images.");
-                  }
-               }
-               if (closeListener.isCancelled()) {
-                  newStore.freeze();
-                  return null;
-               }
-               newStore.putImage(newImgShallow);
-               nrCopied++;
-               try {
-                  setProgress((int) ((nrCopied / nrToBeCopied) * 100.0));
-               } catch (IllegalArgumentException iae) {
-                  System.out.println("Value was: " + (int) (nrCopied / nrToBeCopied * 100.0));
-               }
-               
-            }
+         if (closeListener.isCancelled()) {
+            newStore.freeze();
+            return null;
          }
+      } catch (InterruptedException ie) {
+         studio_.logs().logError(ie, "Duplication was interrupted");
       } catch (DatastoreFrozenException ex) {
          studio_.logs().showError("Can not add data to frozen datastore");
       } catch (DatastoreRewriteException ex) {
@@ -357,7 +280,9 @@ public class DuplicatorExecutor extends SwingWorker<Void, Void> {
          studio_.logs().showError(ioe, "IOException in Duplicator plugin");
       }
 
-      closeListener.finishDuplication();
+      if (closeListener != null) {
+         closeListener.finishDuplication();
+      }
       try {
          newStore.freeze();
       } catch (IOException ioe) {
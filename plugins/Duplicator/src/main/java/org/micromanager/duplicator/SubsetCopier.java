@@ -0,0 +1,173 @@
+///////////////////////////////////////////////////////////////////////////////
+//FILE:          SubsetCopier.java
+//PROJECT:       Micro-Manager 
+//SUBSYSTEM:     Duplicator plugin
+//-----------------------------------------------------------------------------
+//
+// COPYRIGHT:    Regents of the University of California 2024
+//
+// LICENSE:      This file is distributed under the BSD license.
+//               License text is included with the source distribution.
+//
+//               This file is distributed in the hope that it will be useful,
+//               but WITHOUT ANY WARRANTY; without even the implied warranty
+//               of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//               IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//               CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//               INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+package org.micromanager.duplicator;
+
+import java.io.IOException;
+import java.util.ArrayDeque;
+import java.util.Iterator;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.Future;
+import org.micromanager.data.Coords;
+import org.micromanager.data.DataProvider;
+import org.micromanager.data.Datastore;
+import org.micromanager.data.Image;
+
+/**
+ * Copies a {@link DatasetSubset} of one dataset into another.
+ *
+ * <p>Coords are taken from the source as they come, in storage order, and
+ * never collected in a list. Images are read and cropped on a small pool of
+ * threads, while the calling thread adds them to the target in the order of
+ * the coords. The number of images read but not yet added is limited by a
+ * number of bytes, so that memory use does not depend on the dataset size.
+ */
+final class SubsetCopier {
+
+   /**
+    * Receives progress, and can cancel the copy.
+    */
+   interface Progress {
+      /**
+       * Called on the copying thread after each image was added.
+       *
+       * @param copied number of images added so far
+       * @return false to stop copying
+       */
+      boolean imageCopied(int copied);
+   }
+
+   private final DataProvider source_;
+   private final Datastore target_;
+   private final DatasetSubset subset_;
+   private final int nrThreads_;
+   private final long inFlightBytes_;
+
+   /**
+    * @param source dataset to copy from
+    * @param target dataset to copy to; its summary metadata must be set
+    * @param subset part of the source to copy
+    * @param nrThreads number of threads reading from the source
+    * @param inFlightBytes maximum number of bytes of images read, but not
+    *                      yet added to the target. At least one image is
+    *                      always in flight.
+    */
+   SubsetCopier(DataProvider source, Datastore target, DatasetSubset subset,
+                int nrThreads, long inFlightBytes) {
+      source_ = source;
+      target_ = target;
+      subset_ = subset;
+      nrThreads_ = Math.max(1, nrThreads);
+      inFlightBytes_ = inFlightBytes;
+   }
+
+   /**
+    * Returns the number of images that copy() will add, without reading any
+    * of them.
+    */
+   int countImages() {
+      int count = 0;
+      for (Coords coords : source_.getUnorderedImageCoords()) {
+         if (subset_.map(coords) != null) {
+            count++;
+         }
+      }
+      return count;
+   }
+
+   /**
+    * Copies the images. Does not freeze the target.
+    *
+    * @param progress receives progress, or null
+    * @return number of images copied
+    * @throws IOException if reading or writing an image failed
+    * @throws InterruptedException if the calling thread was interrupted
+    */
+   int copy(Progress progress) throws IOException, InterruptedException {
+      ExecutorService readers = Executors.newFixedThreadPool(nrThreads_, r -> {
+         Thread thread = new Thread(r, "Duplicator reader");
+         thread.setDaemon(true);
+         return thread;
+      });
+      ArrayDeque<Future<Image>> inFlight = new ArrayDeque<>();
+      int copied = 0;
+      try {
+         Iterator<Coords> coordsIterator = source_.getUnorderedImageCoords().iterator();
+         // Unknown until the first image was read; one image at a time till then
+         int maxInFlight = 1;
+         boolean sized = false;
+         while (coordsIterator.hasNext() || !inFlight.isEmpty()) {
+            while (inFlight.size() < maxInFlight && coordsIterator.hasNext()) {
+               final Coords oldCoords = coordsIterator.next();
+               final Coords newCoords = subset_.map(oldCoords);
+               if (newCoords != null) {
+                  inFlight.addLast(readers.submit(() -> read(oldCoords, newCoords)));
+               }
+            }
+            if (inFlight.isEmpty()) {
+               continue;
+            }
+            Image image = take(inFlight.removeFirst());
+            if (!sized) {
+               long imageBytes = Math.max(1L, (long) image.getWidth() * image.getHeight()
+                     * image.getBytesPerPixel());
+               maxInFlight = (int) Math.max(1,
+                     Math.min(Integer.MAX_VALUE, inFlightBytes_ / imageBytes));
+               sized = true;
+            }
+            target_.putImage(image);
+            copied++;
+            if (progress != null && !progress.imageCopied(copied)) {
+               break;
+            }
+         }
+      } finally {
+         for (Future<Image> future : inFlight) {
+            future.cancel(true);
+         }
+         readers.shutdownNow();
+      }
+      return copied;
+   }
+
+   private Image read(Coords oldCoords, Coords newCoords) throws IOException {
+      Image image = source_.getImage(oldCoords);
+      if (image == null) {
+         throw new IOException("Image at " + oldCoords + " could not be read");
+      }
+      return subset_.apply(image, newCoords);
+   }
+
+   private static Image take(Future<Image> future) throws IOException, InterruptedException {
+      try {
+         return future.get();
+      } catch (ExecutionException e) {
+         Throwable cause = e.getCause();
+         if (cause instanceof IOException) {
+            throw (IOException) cause;
+         }
+         if (cause instanceof RuntimeException) {
+            throw (RuntimeException) cause;
+         }
+         throw new IOException(cause);
+      }
+   }
+}
@@ -0,0 +1,244 @@
+package org.micromanager.duplicator;
+
+import com.google.common.eventbus.Subscribe;
+import java.awt.Rectangle;
+import java.io.File;
+import java.io.IOException;
+import java.nio.file.Files;
+import java.util.HashMap;
+import java.util.LinkedHashMap;
+import java.util.Map;
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.TimeUnit;
+import org.junit.Assert;
+import org.junit.Test;
+import org.micromanager.data.Coordinates;
+import org.micromanager.data.Coords;
+import org.micromanager.data.DataProviderHasNewSummaryMetadataEvent;
+import org.micromanager.data.Image;
+import org.micromanager.data.internal.DefaultDatastore;
+import org.micromanager.data.internal.DefaultImage;
+import org.micromanager.data.internal.DefaultSummaryMetadata;
+import org.micromanager.data.internal.StorageRAM;
+import org.micromanager.data.internal.StorageSinglePlaneTiffSeries;
+
+public class DatasetSubsetTest {
+   private static final int WIDTH = 32;
+   private static final int HEIGHT = 24;
+   private static final int NR_T = 4;
+   private static final int NR_Z = 5;
+   private static final int NR_C = 3;
+
+   /**
+    * Pixel value that identifies the image and the position within it.
+    */
+   private static int value(int t, int z, int c, int x, int y) {
+      return ((t * NR_Z + z) * NR_C + c) * 1000 + y * WIDTH + x;
+   }
+
+   private static Image createImage(int t, int z, int c) {
+      short[] pixels = new short[WIDTH * HEIGHT];
+      for (int y = 0; y < HEIGHT; y++) {
+         for (int x = 0; x < WIDTH; x++) {
+            pixels[y * WIDTH + x] = (short) value(t, z, c, x, y);
+         }
+      }
+      return new DefaultImage(pixels, WIDTH, HEIGHT, 2, 1,
+            Coordinates.builder().t(t).z(z).c(c).build(), null);
+   }
+
+   private static void setSummaryMetadata(DefaultDatastore store, int width, int height,
+                                          int nrT, int nrZ, int nrC) throws IOException {
+      final CountDownLatch set = new CountDownLatch(1);
+      Object listener = new Object() {
+         @Subscribe
+         public void onNewSummaryMetadata(DataProviderHasNewSummaryMetadataEvent e) {
+            set.countDown();
+         }
+      };
+      store.registerForEvents(listener);
+      store.setSummaryMetadata(new DefaultSummaryMetadata.Builder()
+            .axisOrder(Coords.T, Coords.Z, Coords.C)
+            .imageWidth(width)
+            .imageHeight(height)
+            .intendedDimensions(Coordinates.builder().t(nrT).z(nrZ).c(nrC).build())
+            .build());
+      try {
+         Assert.assertTrue(set.await(10, TimeUnit.SECONDS));
+      } catch (InterruptedException e) {
+         throw new IOException(e);
+      }
+      store.unregisterForEvents(listener);
+   }
+
+   // No Studio, so these stores are never closed
+
+   private static DefaultDatastore createRamStore() {
+      DefaultDatastore store = new DefaultDatastore(null);
+      store.setStorage(new StorageRAM(store));
+      return store;
+   }
+
+   private static DefaultDatastore createTiffStore(File dir) throws IOException {
+      DefaultDatastore store = new DefaultDatastore(null);
+      store.setStorage(new StorageSinglePlaneTiffSeries(store, dir.getAbsolutePath(), true));
+      return store;
+   }
+
+   private static DefaultDatastore fillSource(DefaultDatastore store) throws IOException {
+      setSummaryMetadata(store, WIDTH, HEIGHT, NR_T, NR_Z, NR_C);
+      for (int t = 0; t < NR_T; t++) {
+         for (int z = 0; z < NR_Z; z++) {
+            for (int c = 0; c < NR_C; c++) {
+               store.putImage(createImage(t, z, c));
+            }
+         }
+      }
+      return store;
+   }
+
+   /**
+    * Times 1 and 2, slices 2 to 4, and the first and last channel.
+    */
+   private static DatasetSubset createSubset(Rectangle crop) {
+      Map<String, Integer> mins = new HashMap<>();
+      Map<String, Integer> maxes = new HashMap<>();
+      mins.put(Coords.T, 1);
+      maxes.put(Coords.T, 2);
+      mins.put(Coords.Z, 2);
+      maxes.put(Coords.Z, 4);
+      LinkedHashMap<String, Boolean> channels = new LinkedHashMap<>();
+      channels.put("DAPI", true);
+      channels.put("FITC", false);
+      channels.put("Cy5", true);
+      return DatasetSubset.create(mins, maxes, channels, crop);
+   }
+
+   /**
+    * Checks that target holds exactly the subset of createSubset(crop).
+    */
+   private static void checkCopy(DefaultDatastore target, Rectangle crop) throws IOException {
+      Assert.assertEquals(2 * 3 * 2, target.getNumImages());
+      int[] oldChannels = {0, 2};
+      for (int t = 0; t < 2; t++) {
+         for (int z = 0; z < 3; z++) {
+            for (int c = 0; c < 2; c++) {
+               Image image = target.getImage(Coordinates.builder().t(t).z(z).c(c).build());
+               Assert.assertNotNull(image);
+               Assert.assertEquals(crop.width, image.getWidth());
+               Assert.assertEquals(crop.height, image.getHeight());
+               short[] pixels = (short[]) image.getRawPixels();
+               for (int y = 0; y < crop.height; y++) {
+                  for (int x = 0; x < crop.width; x++) {
+                     Assert.assertEquals(value(t + 1, z + 2, oldChannels[c],
+                                 x + crop.x, y + crop.y),
+                           pixels[y * crop.width + x] & 0xffff);
+                  }
+               }
+            }
+         }
+      }
+   }
+
+   @Test
+   public void mapsCoordsAndRejectsUnselected() {
+      DatasetSubset subset = createSubset(null);
+      Assert.assertEquals(Coordinates.builder().t(0).z(0).c(1).build(),
+            subset.map(Coordinates.builder().t(1).z(2).c(2).build()));
+      Assert.assertNull(subset.map(Coordinates.builder().t(1).z(2).c(1).build()));
+      Assert.assertNull(subset.map(Coordinates.builder().t(0).z(2).c(0).build()));
+      Assert.assertNull(subset.map(Coordinates.builder().t(1).z(5).c(0).build()));
+      Assert.assertNull(subset.map(Coordinates.builder().t(1).z(2).c(3).build()));
+   }
+
+   @Test
+   public void axisSubsetSharesPixels() throws Exception {
+      DefaultDatastore source = fillSource(createRamStore());
+      DefaultDatastore target = createRamStore();
+      setSummaryMetadata(target, WIDTH, HEIGHT, 2, 3, 2);
+      SubsetCopier copier = new SubsetCopier(source, target, createSubset(null), 4,
+            1024 * 1024);
+      Assert.assertEquals(12, copier.countImages());
+      Assert.assertEquals(12, copier.copy(null));
+      checkCopy(target, new Rectangle(0, 0, WIDTH, HEIGHT));
+      Image copy = target.getImage(Coordinates.builder().t(1).z(2).c(1).build());
+      Image original = source.getImage(Coordinates.builder().t(2).z(4).c(2).build());
+      Assert.assertSame(original.getRawPixels(), copy.getRawPixels());
+   }
+
+   @Test
+   public void roiCropWithOneImageInFlight() throws Exception {
+      Rectangle crop = new Rectangle(5, 3, 10, 7);
+      DefaultDatastore source = fillSource(createRamStore());
+      DefaultDatastore target = createRamStore();
+      setSummaryMetadata(target, crop.width, crop.height, 2, 3, 2);
+      new SubsetCopier(source, target, createSubset(crop), 3, 1).copy(null);
+      checkCopy(target, crop);
+   }
+
+   @Test
+   public void roiCropIsClippedToImage() {
+      DatasetSubset subset = DatasetSubset.create(new HashMap<>(), new HashMap<>(), null,
+            new Rectangle(WIDTH - 4, -2, 10, 5));
+      Rectangle bounds = subset.getCroppedBounds(WIDTH, HEIGHT);
+      Assert.assertEquals(new Rectangle(WIDTH - 4, 0, 4, 3), bounds);
+      Coords coords = Coordinates.builder().t(1).z(1).c(1).build();
+      Image image = subset.apply(createImage(1, 1, 1), coords);
+      Assert.assertEquals(4, image.getWidth());
+      Assert.assertEquals(3, image.getHeight());
+      Assert.assertEquals(value(1, 1, 1, WIDTH - 1, 2),
+            ((short[]) image.getRawPixels())[2 * 4 + 3] & 0xffff);
+   }
+
+   @Test
+   public void rgbCropKeepsComponents() {
+      byte[] pixels = new byte[WIDTH * HEIGHT * 4];
+      for (int i = 0; i < pixels.length; i++) {
+         pixels[i] = (byte) i;
+      }
+      Image rgb = new DefaultImage(pixels, WIDTH, HEIGHT, 4, 3,
+            Coordinates.builder().t(0).build(), null);
+      Image cropped = DatasetSubset.create(new HashMap<>(), new HashMap<>(), null,
+            new Rectangle(2, 1, 3, 2)).apply(rgb, rgb.getCoords());
+      byte[] croppedPixels = (byte[]) cropped.getRawPixels();
+      Assert.assertEquals(3 * 2 * 4, croppedPixels.length);
+      for (int y = 0; y < 2; y++) {
+         for (int i = 0; i < 3 * 4; i++) {
+            Assert.assertEquals(pixels[((y + 1) * WIDTH + 2) * 4 + i],
+                  croppedPixels[y * 3 * 4 + i]);
+         }
+      }
+   }
+
+   @Test
+   public void tiffToTiffWithCrop() throws Exception {
+      File dir = Files.createTempDirectory("DatasetSubsetTest").toFile();
+      Rectangle crop = new Rectangle(1, 2, 17, 11);
+      DefaultDatastore source = fillSource(createTiffStore(new File(dir, "source")));
+      DefaultDatastore target = createTiffStore(new File(dir, "target"));
+      setSummaryMetadata(target, crop.width, crop.height, 2, 3, 2);
+      new SubsetCopier(source, target, createSubset(crop), 4, 1024 * 1024).copy(null);
+      checkCopy(target, crop);
+   }
+
+   @Test
+   public void ramToTiffAndBack() throws Exception {
+      File dir = Files.createTempDirectory("DatasetSubsetTest").toFile();
+      DefaultDatastore source = fillSource(createRamStore());
+      DefaultDatastore target = createTiffStore(new File(dir, "target"));
+      setSummaryMetadata(target, WIDTH, HEIGHT, 2, 3, 2);
+      new SubsetCopier(source, target, createSubset(null), 2, 1024 * 1024).copy(null);
+      checkCopy(target, new Rectangle(0, 0, WIDTH, HEIGHT));
+   }
+
+   @Test
+   public void progressCanCancel() throws Exception {
+      DefaultDatastore source = fillSource(createRamStore());
+      DefaultDatastore target = createRamStore();
+      setSummaryMetadata(target, WIDTH, HEIGHT, 2, 3, 2);
+      int copied = new SubsetCopier(source, target, createSubset(null), 2, 1024 * 1024)
+            .copy(n -> n < 5);
+      Assert.assertEquals(5, copied);
+      Assert.assertEquals(5, target.getNumImages());
+   }
+}
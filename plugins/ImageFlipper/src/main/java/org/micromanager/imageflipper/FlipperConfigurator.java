@@ -49,6 +49,8 @@ public class FlipperConfigurator extends JFrame implements ProcessorConfigurator
    private static final String DEFAULT_CAMERA = "Default camera for image flipper";
    private static final String DEFAULT_MIRRORED = "Whether or not to mirror the image flipper";
    private static final String DEFAULT_ROTATION = "How much to rotate the image flipper";
+   private static final String DEFAULT_METADATA_ONLY =
+         "Whether the image flipper only records the orientation";
    private static final String R0 = "0" + "\u00B0"; // U+00B0 DEGREE SIGN
    private static final String R90 = "90" + "\u00B0"; // U+00B0 DEGREE SIGN
    private static final String R180 = "180" + "\u00B0"; // U+00B0 DEGREE SIGN
@@ -73,6 +75,7 @@ public class FlipperConfigurator extends JFrame implements ProcessorConfigurator
    private javax.swing.JLabel exampleImageTarget_;
    private javax.swing.JLabel jLabel1;
    private javax.swing.JCheckBox mirrorCheckBox_;
+   private javax.swing.JCheckBox metadataOnlyCheckBox_;
    private javax.swing.JComboBox rotateComboBox_;
 
    public FlipperConfigurator(Studio studio, PropertyMap settings) {
@@ -87,7 +90,11 @@ public class FlipperConfigurator extends JFrame implements ProcessorConfigurator
       final Integer rotation = settings.getInteger("rotation",
             defaults_.getInteger(DEFAULT_ROTATION, FlipperProcessor.R0));
 
+      final boolean metadataOnly = settings.getBoolean("metadataOnly",
+            defaults_.getBoolean(DEFAULT_METADATA_ONLY, false));
+
       mirrorCheckBox_.setSelected(shouldMirror);
+      metadataOnlyCheckBox_.setSelected(metadataOnly);
       rotateComboBox_.removeAllItems();
       for (String item : RS) {
          rotateComboBox_.addItem(item);
@@ -139,6 +146,7 @@ public class FlipperConfigurator extends JFrame implements ProcessorConfigurator
    private void initComponents() {
 
       mirrorCheckBox_ = new javax.swing.JCheckBox();
+      metadataOnlyCheckBox_ = new javax.swing.JCheckBox();
       exampleImageSource_ = new javax.swing.JLabel();
       exampleImageTarget_ = new javax.swing.JLabel();
       cameraComboBox_ = new javax.swing.JComboBox();
@@ -159,6 +167,16 @@ public class FlipperConfigurator extends JFrame implements ProcessorConfigurator
          }
       });
 
+      metadataOnlyCheckBox_.setText("Metadata only");
+      metadataOnlyCheckBox_.setToolTipText(
+            "Do not change the pixels, only record the orientation in the image metadata");
+      metadataOnlyCheckBox_.addActionListener(new java.awt.event.ActionListener() {
+         @Override
+         public void actionPerformed(java.awt.event.ActionEvent evt) {
+            metadataOnlyCheckBoxActionPerformed(evt);
+         }
+      });
+
       exampleImageSource_.setIcon(EXAMPLE_ICON);
 
       exampleImageTarget_.setIcon(EXAMPLE_ICON);
@@ -215,7 +233,10 @@ public class FlipperConfigurator extends JFrame implements ProcessorConfigurator
                                           .addGap(38, 38, 38))
                                     .addGroup(layout.createSequentialGroup()
                                           .addComponent(mirrorCheckBox_)
-                                          .addContainerGap(121, Short.MAX_VALUE))))
+                                          .addPreferredGap(
+                            javax.swing.LayoutStyle.ComponentPlacement.RELATED)
+                                          .addComponent(metadataOnlyCheckBox_)
+                                          .addContainerGap(20, Short.MAX_VALUE))))
       );
       layout.setVerticalGroup(
             layout.createParallelGroup(javax.swing.GroupLayout.Alignment.LEADING)
@@ -234,7 +255,10 @@ public class FlipperConfigurator extends JFrame implements ProcessorConfigurator
                                           javax.swing.GroupLayout.DEFAULT_SIZE, 54,
                                           Short.MAX_VALUE))
                               .addPreferredGap(javax.swing.LayoutStyle.ComponentPlacement.UNRELATED)
-                              .addComponent(mirrorCheckBox_)
+                              .addGroup(layout.createParallelGroup(
+                                          javax.swing.GroupLayout.Alignment.BASELINE)
+                                    .addComponent(mirrorCheckBox_)
+                                    .addComponent(metadataOnlyCheckBox_))
                               .addPreferredGap(javax.swing.LayoutStyle.ComponentPlacement.RELATED)
                               .addGroup(layout.createParallelGroup(
                                           javax.swing.GroupLayout.Alignment.BASELINE)
@@ -260,6 +284,12 @@ public class FlipperConfigurator extends JFrame implements ProcessorConfigurator
       studio_.data().notifyPipelineChanged();
    }
 
+   private void metadataOnlyCheckBoxActionPerformed(
+         java.awt.event.ActionEvent evt) {
+      defaults_.putBoolean(DEFAULT_METADATA_ONLY, metadataOnlyCheckBox_.isSelected());
+      studio_.data().notifyPipelineChanged();
+   }
+
    private void rotateComboBoxActionPerformed(
          java.awt.event.ActionEvent evt) {
       processExample();
@@ -315,6 +345,10 @@ public class FlipperConfigurator extends JFrame implements ProcessorConfigurator
       return mirrorCheckBox_.isSelected();
    }
 
+   public final boolean getMetadataOnly() {
+      return metadataOnlyCheckBox_.isSelected();
+   }
+
    private void processExample() {
       ByteProcessor proc = new ByteProcessor(
             IconLoader.loadFromResource(EXAMPLE_ICON_PATH));
@@ -335,6 +369,7 @@ public class FlipperConfigurator extends JFrame implements ProcessorConfigurator
       builder.putString("camera", getCamera());
       builder.putInteger("rotation", getRotate());
       builder.putBoolean("shouldMirror", getMirror());
+      builder.putBoolean("metadataOnly", getMetadataOnly());
       return builder.build();
    }
 }
\ No newline at end of file
@@ -38,6 +38,7 @@ public class FlipperFactory implements ProcessorFactory {
    public Processor createProcessor() {
       return new FlipperProcessor(studio_, settings_.getString("camera", ""),
             settings_.getInteger("rotation", 0),
-            settings_.getBoolean("shouldMirror", false));
+            settings_.getBoolean("shouldMirror", false),
+            settings_.getBoolean("metadataOnly", false));
    }
 }
@@ -0,0 +1,236 @@
+///////////////////////////////////////////////////////////////////////////////
+//PROJECT:       Micro-Manager
+//SUBSYSTEM:     mmstudio
+//-----------------------------------------------------------------------------
+//
+// COPYRIGHT:    University of California, San Francisco, 2024
+//
+// LICENSE:      This file is distributed under the BSD license.
+//               License text is included with the source distribution.
+//
+//               This file is distributed in the hope that it will be useful,
+//               but WITHOUT ANY WARRANTY; without even the implied warranty
+//               of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//               IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//               CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//               INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+//
+
+
+package org.micromanager.imageflipper;
+
+import java.util.stream.IntStream;
+
+/**
+ * Mirrors and rotates pixel arrays in a single pass.
+ *
+ * <p>Each of the eight combinations of mirroring and rotation by a multiple
+ * of 90 degrees maps an output pixel to a source pixel with a linear function
+ * of its coordinates. The output is written in square tiles, so that the
+ * (strided) reads from the source stay within a small part of the image and
+ * remain in cache. Rows of tiles are independent and can be processed in
+ * parallel.
+ *
+ * <p>The result is the same as mirroring horizontally and then rotating
+ * clockwise by the given angle, as ImageJ's flipHorizontal() and
+ * rotateRight() do.
+ */
+public final class FlipperKernel {
+   // Edge length, in pixels, of the square tiles that the output is written in
+   static final int TILE_SIZE = 64;
+   // Images with fewer pixels are never split over several threads
+   private static final int PARALLEL_MIN_PIXELS = 1 << 20;
+
+   private FlipperKernel() {
+   }
+
+   /**
+    * Width of the transformed image.
+    *
+    * @param width width of the source image
+    * @param height height of the source image
+    * @param rotation one of FlipperProcessor.R0, R90, R180, R270
+    * @return width after rotation
+    */
+   public static int outputWidth(int width, int height, int rotation) {
+      return isQuarterTurn(rotation) ? height : width;
+   }
+
+   /**
+    * Height of the transformed image.
+    *
+    * @param width width of the source image
+    * @param height height of the source image
+    * @param rotation one of FlipperProcessor.R0, R90, R180, R270
+    * @return height after rotation
+    */
+   public static int outputHeight(int width, int height, int rotation) {
+      return isQuarterTurn(rotation) ? width : height;
+   }
+
+   private static boolean isQuarterTurn(int rotation) {
+      return rotation == FlipperProcessor.R90 || rotation == FlipperProcessor.R270;
+   }
+
+   /**
+    * Returns the index of the source pixel that ends up at (x, y) in the
+    * output. Only valid for coordinates within the output, but the function
+    * is linear, so it can be used to compute steps.
+    */
+   private static int sourceIndex(int x, int y, int width, int height,
+                                  boolean mirror, int rotation) {
+      int sx;
+      int sy;
+      switch (rotation) {
+         case FlipperProcessor.R0:
+            sx = x;
+            sy = y;
+            break;
+         case FlipperProcessor.R90:
+            sx = y;
+            sy = height - 1 - x;
+            break;
+         case FlipperProcessor.R180:
+            sx = width - 1 - x;
+            sy = height - 1 - y;
+            break;
+         case FlipperProcessor.R270:
+            sx = width - 1 - y;
+            sy = x;
+            break;
+         default:
+            throw new IllegalArgumentException(
+                  "Invalid rotation " + rotation + "; must be a multiple of 90 degrees");
+      }
+      if (mirror) {
+         sx = width - 1 - sx;
+      }
+      return sy * width + sx;
+   }
+
+   /**
+    * Mirrors and then rotates the pixels of an image.
+    *
+    * @param src source pixels, a byte[], short[] or int[] array
+    * @param dst destination, an array of the same type and size as src, which
+    *            must not be the same array
+    * @param width width of the source image, in pixels
+    * @param height height of the source image, in pixels
+    * @param elementsPerPixel number of array elements per pixel: 1, or 4 for
+    *                         RGB pixels stored in a byte[]
+    * @param mirror whether to mirror horizontally
+    * @param rotation clockwise rotation: one of FlipperProcessor.R0, R90, R180, R270
+    * @param parallel whether large images may be processed on several threads
+    */
+   public static void transform(Object src, Object dst, int width, int height,
+                                int elementsPerPixel, boolean mirror, int rotation,
+                                boolean parallel) {
+      if (src == dst) {
+         throw new IllegalArgumentException("Cannot transform in place");
+      }
+      if (elementsPerPixel != 1 && !(elementsPerPixel == 4 && src instanceof byte[])) {
+         throw new IllegalArgumentException("Unsupported pixel layout");
+      }
+      final int outWidth = outputWidth(width, height, rotation);
+      final int outHeight = outputHeight(width, height, rotation);
+      final int origin = sourceIndex(0, 0, width, height, mirror, rotation);
+      final int stepX = sourceIndex(1, 0, width, height, mirror, rotation) - origin;
+      final int stepY = sourceIndex(0, 1, width, height, mirror, rotation) - origin;
+
+      if (!mirror && rotation == FlipperProcessor.R0) {
+         System.arraycopy(src, 0, dst, 0, width * height * elementsPerPixel);
+         return;
+      }
+
+      final TileRowKernel kernel;
+      if (src instanceof byte[] && elementsPerPixel == 4) {
+         final byte[] s = (byte[]) src;
+         final byte[] d = (byte[]) dst;
+         kernel = (y0, y1) -> {
+            for (int x0 = 0; x0 < outWidth; x0 += TILE_SIZE) {
+               final int x1 = Math.min(outWidth, x0 + TILE_SIZE);
+               for (int y = y0; y < y1; y++) {
+                  int di = 4 * (y * outWidth + x0);
+                  int si = 4 * (origin + y * stepY + x0 * stepX);
+                  final int step = 4 * stepX;
+                  for (int x = x0; x < x1; x++) {
+                     d[di] = s[si];
+                     d[di + 1] = s[si + 1];
+                     d[di + 2] = s[si + 2];
+                     d[di + 3] = s[si + 3];
+                     di += 4;
+                     si += step;
+                  }
+               }
+            }
+         };
+      } else if (src instanceof byte[]) {
+         final byte[] s = (byte[]) src;
+         final byte[] d = (byte[]) dst;
+         kernel = (y0, y1) -> {
+            for (int x0 = 0; x0 < outWidth; x0 += TILE_SIZE) {
+               final int x1 = Math.min(outWidth, x0 + TILE_SIZE);
+               for (int y = y0; y < y1; y++) {
+                  int di = y * outWidth + x0;
+                  int si = origin + y * stepY + x0 * stepX;
+                  for (int x = x0; x < x1; x++) {
+                     d[di++] = s[si];
+                     si += stepX;
+                  }
+               }
+            }
+         };
+      } else if (src instanceof short[]) {
+         final short[] s = (short[]) src;
+         final short[] d = (short[]) dst;
+         kernel = (y0, y1) -> {
+            for (int x0 = 0; x0 < outWidth; x0 += TILE_SIZE) {
+               final int x1 = Math.min(outWidth, x0 + TILE_SIZE);
+               for (int y = y0; y < y1; y++) {
+                  int di = y * outWidth + x0;
+                  int si = origin + y * stepY + x0 * stepX;
+                  for (int x = x0; x < x1; x++) {
+                     d[di++] = s[si];
+                     si += stepX;
+                  }
+               }
+            }
+         };
+      } else if (src instanceof int[]) {
+         final int[] s = (int[]) src;
+         final int[] d = (int[]) dst;
+         kernel = (y0, y1) -> {
+            for (int x0 = 0; x0 < outWidth; x0 += TILE_SIZE) {
+               final int x1 = Math.min(outWidth, x0 + TILE_SIZE);
+               for (int y = y0; y < y1; y++) {
+                  int di = y * outWidth + x0;
+                  int si = origin + y * stepY + x0 * stepX;
+                  for (int x = x0; x < x1; x++) {
+                     d[di++] = s[si];
+                     si += stepX;
+                  }
+               }
+            }
+         };
+      } else {
+         throw new IllegalArgumentException("Unsupported pixel data type");
+      }
+
+      final int tileRows = (outHeight + TILE_SIZE - 1) / TILE_SIZE;
+      IntStream rows = IntStream.range(0, tileRows);
+      if (parallel && (long) width * height >= PARALLEL_MIN_PIXELS) {
+         rows = rows.parallel();
+      }
+      rows.forEach(row -> kernel.run(row * TILE_SIZE,
+            Math.min(outHeight, (row + 1) * TILE_SIZE)));
+   }
+
+   /**
+    * Transforms the output rows [y0, y1), one tile at a time.
+    */
+   @FunctionalInterface
+   private interface TileRowKernel {
+      void run(int y0, int y1);
+   }
+}
@@ -20,7 +20,6 @@
 
 package org.micromanager.imageflipper;
 
-import ij.process.ImageProcessor;
 import org.micromanager.PropertyMap;
 import org.micromanager.PropertyMaps;
 import org.micromanager.Studio;
@@ -42,9 +41,27 @@ public class FlipperProcessor implements Processor {
    String camera_;
    boolean isMirrored_;
    int rotation_;
+   boolean metadataOnly_;
 
    public FlipperProcessor(Studio studio, String camera, int rotation,
                            boolean isMirrored) {
+      this(studio, camera, rotation, isMirrored, false);
+   }
+
+   /**
+    * Creates a processor that mirrors and/or rotates images.
+    *
+    * @param studio       Studio instance
+    * @param camera       only images from this camera are transformed; all
+    *                     images are transformed when empty
+    * @param rotation     Degrees to rotate by (R0, R90, R180, R270)
+    * @param isMirrored   Whether or not to mirror the image
+    * @param metadataOnly When true, pixels are passed on unmodified and only
+    *                     the requested orientation is recorded in the
+    *                     metadata, for consumers that apply it themselves
+    */
+   public FlipperProcessor(Studio studio, String camera, int rotation,
+                           boolean isMirrored, boolean metadataOnly) {
       studio_ = studio;
       camera_ = camera;
       if (rotation != R0 && rotation != R90 && rotation != R180
@@ -55,6 +72,7 @@ public class FlipperProcessor implements Processor {
       }
       rotation_ = rotation;
       isMirrored_ = isMirrored;
+      metadataOnly_ = metadataOnly;
    }
 
    /**
@@ -72,6 +90,10 @@ public class FlipperProcessor implements Processor {
             return;
          }
       }
+      if (metadataOnly_) {
+         context.outputImage(annotateImage(image, isMirrored_, rotation_));
+         return;
+      }
       context.outputImage(
             transformImage(studio_, image, isMirrored_, rotation_));
    }
@@ -88,22 +110,47 @@ public class FlipperProcessor implements Processor {
     */
    public static Image transformImage(Studio studio, Image image,
                                       boolean isMirrored, int rotation) {
+      final int width = image.getWidth();
+      final int height = image.getHeight();
+      final Object src = image.getRawPixels();
+      final Object dst;
+      if (src instanceof byte[]) {
+         dst = new byte[((byte[]) src).length];
+      } else if (src instanceof short[]) {
+         dst = new short[((short[]) src).length];
+      } else if (src instanceof int[]) {
+         dst = new int[((int[]) src).length];
+      } else {
+         throw new UnsupportedOperationException("Unsupported pixel type");
+      }
+      FlipperKernel.transform(src, dst, width, height,
+            src instanceof byte[] ? image.getBytesPerPixel() : 1,
+            isMirrored, rotation, true);
+      return studio.data().createImage(dst,
+            FlipperKernel.outputWidth(width, height, rotation),
+            FlipperKernel.outputHeight(width, height, rotation),
+            image.getBytesPerPixel(), image.getNumComponents(),
+            image.getCoords(),
+            createMetadata(image, isMirrored, rotation, true));
+   }
 
-      ImageProcessor proc = studio.data().ij().createProcessor(image);
+   /**
+    * Records the orientation in the metadata of an image without touching
+    * its pixels. The returned image shares the pixel buffer of the input.
+    *
+    * @param image      Image to be annotated.
+    * @param isMirrored Whether or not the image should be mirrored.
+    * @param rotation   Degrees the image should be rotated by
+    * @return - Image with the same pixels and updated metadata
+    */
+   public static Image annotateImage(Image image, boolean isMirrored,
+                                     int rotation) {
+      return image.copyWithMetadata(
+            createMetadata(image, isMirrored, rotation, false));
+   }
 
-      if (isMirrored) {
-         proc.flipHorizontal();
-      }
-      if (rotation == R90) {
-         proc = proc.rotateRight();
-      }
-      if (rotation == R180) {
-         proc = proc.rotateRight();
-         proc = proc.rotateRight();
-      }
-      if (rotation == R270) {
-         proc = proc.rotateLeft();
-      }
+   private static Metadata createMetadata(Image image, boolean isMirrored,
+                                          int rotation, boolean applied) {
       // Insert some metadata to indicate what we did to the image.
       PropertyMap.Builder builder;
       PropertyMap userData = image.getMetadata().getUserData();
@@ -114,10 +161,8 @@ public class FlipperProcessor implements Processor {
       }
       builder.putInteger("ImageFlipper-Rotation", rotation);
       builder.putString("ImageFlipper-Mirror", isMirrored ? "On" : "Off");
-      Metadata newMetadata =
-            image.getMetadata().copyBuilderPreservingUUID().userData(builder.build()).build();
-      Image result = studio.data().ij().createImage(proc, image.getCoords(),
-            newMetadata);
-      return result;
+      builder.putString("ImageFlipper-Applied", applied ? "Yes" : "No");
+      return image.getMetadata().copyBuilderPreservingUUID()
+            .userData(builder.build()).build();
    }
 }
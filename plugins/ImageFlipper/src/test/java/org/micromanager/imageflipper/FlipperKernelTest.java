@@ -0,0 +1,201 @@
+package org.micromanager.imageflipper;
+
+import ij.process.ByteProcessor;
+import ij.process.ColorProcessor;
+import ij.process.ImageProcessor;
+import ij.process.ShortProcessor;
+import java.util.Random;
+import org.junit.Assert;
+import org.junit.Ignore;
+import org.junit.Test;
+
+public class FlipperKernelTest {
+   private static final int[] ROTATIONS = {FlipperProcessor.R0, FlipperProcessor.R90,
+         FlipperProcessor.R180, FlipperProcessor.R270};
+   // Sizes smaller than, equal to, and not a multiple of, the tile size
+   private static final int[][] SIZES = {{1, 1}, {1, 7}, {7, 1}, {3, 5},
+         {64, 64}, {65, 63}, {130, 67}, {200, 129}};
+
+   /**
+    * The transformation as it was done before, with ImageJ.
+    */
+   private static ImageProcessor reference(ImageProcessor proc, boolean mirror,
+                                           int rotation) {
+      proc = proc.duplicate();
+      if (mirror) {
+         proc.flipHorizontal();
+      }
+      if (rotation == FlipperProcessor.R90) {
+         proc = proc.rotateRight();
+      }
+      if (rotation == FlipperProcessor.R180) {
+         proc = proc.rotateRight();
+         proc = proc.rotateRight();
+      }
+      if (rotation == FlipperProcessor.R270) {
+         proc = proc.rotateLeft();
+      }
+      return proc;
+   }
+
+   private static String describe(int width, int height, boolean mirror, int rotation) {
+      return width + "x" + height + (mirror ? " mirrored" : "") + " rotated " + rotation;
+   }
+
+   @Test
+   public void eightBitMatchesImageJ() {
+      Random rng = new Random(1);
+      for (int[] size : SIZES) {
+         byte[] src = new byte[size[0] * size[1]];
+         rng.nextBytes(src);
+         ByteProcessor proc = new ByteProcessor(size[0], size[1], src.clone());
+         for (boolean mirror : new boolean[] {false, true}) {
+            for (int rotation : ROTATIONS) {
+               ImageProcessor expected = reference(proc, mirror, rotation);
+               byte[] dst = new byte[src.length];
+               FlipperKernel.transform(src, dst, size[0], size[1], 1, mirror, rotation,
+                     false);
+               String what = describe(size[0], size[1], mirror, rotation);
+               Assert.assertEquals(what, expected.getWidth(),
+                     FlipperKernel.outputWidth(size[0], size[1], rotation));
+               Assert.assertEquals(what, expected.getHeight(),
+                     FlipperKernel.outputHeight(size[0], size[1], rotation));
+               Assert.assertArrayEquals(what, (byte[]) expected.getPixels(), dst);
+            }
+         }
+      }
+   }
+
+   @Test
+   public void sixteenBitMatchesImageJ() {
+      Random rng = new Random(2);
+      for (int[] size : SIZES) {
+         short[] src = new short[size[0] * size[1]];
+         for (int i = 0; i < src.length; i++) {
+            src[i] = (short) rng.nextInt();
+         }
+         ShortProcessor proc = new ShortProcessor(size[0], size[1], src.clone(), null);
+         for (boolean mirror : new boolean[] {false, true}) {
+            for (int rotation : ROTATIONS) {
+               short[] dst = new short[src.length];
+               FlipperKernel.transform(src, dst, size[0], size[1], 1, mirror, rotation,
+                     false);
+               Assert.assertArrayEquals(describe(size[0], size[1], mirror, rotation),
+                     (short[]) reference(proc, mirror, rotation).getPixels(), dst);
+            }
+         }
+      }
+   }
+
+   @Test
+   public void rgbMatchesImageJ() {
+      Random rng = new Random(3);
+      for (int[] size : SIZES) {
+         int[] packed = new int[size[0] * size[1]];
+         byte[] src = new byte[4 * packed.length];
+         for (int i = 0; i < packed.length; i++) {
+            packed[i] = rng.nextInt();
+            for (int b = 0; b < 4; b++) {
+               src[4 * i + b] = (byte) (packed[i] >> (8 * b));
+            }
+         }
+         ColorProcessor proc = new ColorProcessor(size[0], size[1], packed.clone());
+         for (boolean mirror : new boolean[] {false, true}) {
+            for (int rotation : ROTATIONS) {
+               String what = describe(size[0], size[1], mirror, rotation);
+               int[] expected = (int[]) reference(proc, mirror, rotation).getPixels();
+
+               byte[] dst = new byte[src.length];
+               FlipperKernel.transform(src, dst, size[0], size[1], 4, mirror, rotation,
+                     false);
+               for (int i = 0; i < expected.length; i++) {
+                  for (int b = 0; b < 4; b++) {
+                     Assert.assertEquals(what, (byte) (expected[i] >> (8 * b)),
+                           dst[4 * i + b]);
+                  }
+               }
+
+               int[] dstPacked = new int[packed.length];
+               FlipperKernel.transform(packed, dstPacked, size[0], size[1], 1, mirror,
+                     rotation, false);
+               Assert.assertArrayEquals(what, expected, dstPacked);
+            }
+         }
+      }
+   }
+
+   @Test
+   public void parallelMatchesSerial() {
+      final int width = 1536;
+      final int height = 1031;
+      short[] src = new short[width * height];
+      for (int i = 0; i < src.length; i++) {
+         src[i] = (short) (i * 31);
+      }
+      for (boolean mirror : new boolean[] {false, true}) {
+         for (int rotation : ROTATIONS) {
+            short[] serial = new short[src.length];
+            short[] parallel = new short[src.length];
+            FlipperKernel.transform(src, serial, width, height, 1, mirror, rotation, false);
+            FlipperKernel.transform(src, parallel, width, height, 1, mirror, rotation, true);
+            Assert.assertArrayEquals(describe(width, height, mirror, rotation),
+                  serial, parallel);
+         }
+      }
+   }
+
+   @Test(expected = IllegalArgumentException.class)
+   public void rejectsInvalidRotation() {
+      FlipperKernel.transform(new byte[4], new byte[4], 2, 2, 1, false, 45, false);
+   }
+
+   private static final int BENCHMARK_SIZE = 2048;
+   private static final int BENCHMARK_FRAMES = 25;
+
+   private static ShortProcessor benchmarkFrame() {
+      short[] src = new short[BENCHMARK_SIZE * BENCHMARK_SIZE];
+      for (int i = 0; i < src.length; i++) {
+         src[i] = (short) i;
+      }
+      return new ShortProcessor(BENCHMARK_SIZE, BENCHMARK_SIZE, src, null);
+   }
+
+   private static void benchmarkKernel(boolean parallel) {
+      ShortProcessor proc = benchmarkFrame();
+      short[] src = (short[]) proc.getPixels();
+      short[] dst = new short[src.length];
+      for (int i = 0; i < BENCHMARK_FRAMES; i++) {
+         FlipperKernel.transform(src, dst, BENCHMARK_SIZE, BENCHMARK_SIZE, 1, true,
+               FlipperProcessor.R270, parallel);
+      }
+      Assert.assertArrayEquals((short[]) reference(proc, true, FlipperProcessor.R270)
+            .getPixels(), dst);
+   }
+
+   // Benchmarks: mirroring and rotating by 270 degrees 25 16-bit sCMOS-sized
+   // frames, with ImageJ and with the kernel. Not part of the default run;
+   // compare the times reported by JUnit.
+
+   @Ignore("Benchmark, run manually")
+   @Test
+   public void benchmarkImageJ() {
+      ShortProcessor proc = benchmarkFrame();
+      ImageProcessor result = null;
+      for (int i = 0; i < BENCHMARK_FRAMES; i++) {
+         result = reference(proc, true, FlipperProcessor.R270);
+      }
+      Assert.assertEquals(BENCHMARK_SIZE, result.getWidth());
+   }
+
+   @Ignore("Benchmark, run manually")
+   @Test
+   public void benchmarkSerialKernel() {
+      benchmarkKernel(false);
+   }
+
+   @Ignore("Benchmark, run manually")
+   @Test
+   public void benchmarkParallelKernel() {
+      benchmarkKernel(true);
+   }
+}
@@ -0,0 +1,153 @@
+/*
+ * CameraSettingsTransaction.java
+ *
+ * Copyright UCSF, 2024
+ *
+ */
+
+package org.micromanager.multicamera;
+
+import java.util.ArrayList;
+import java.util.List;
+import mmcorej.CMMCore;
+import mmcorej.StrVector;
+
+/**
+ * Applies property values to several cameras as a unit: all values are
+ * validated before any of them is set, and when setting a value fails, the
+ * values that were already set are restored. This keeps the cameras behind
+ * a Multi Camera device at the same settings.
+ */
+final class CameraSettingsTransaction {
+
+   private static final class Change {
+      private final String camera_;
+      private final String property_;
+      private final String value_;
+      private final boolean optional_;
+
+      private Change(String camera, String property, String value, boolean optional) {
+         camera_ = camera;
+         property_ = property;
+         value_ = value;
+         optional_ = optional;
+      }
+   }
+
+   private final CMMCore core_;
+   private final List<Change> changes_ = new ArrayList<>();
+
+   CameraSettingsTransaction(CMMCore core) {
+      core_ = core;
+   }
+
+   /**
+    * Adds a value to set.
+    */
+   CameraSettingsTransaction set(String camera, String property, String value) {
+      changes_.add(new Change(camera, property, value, false));
+      return this;
+   }
+
+   /**
+    * Adds a value to set on all given cameras.
+    */
+   CameraSettingsTransaction setAll(List<String> cameras, String property, String value) {
+      for (String camera : cameras) {
+         set(camera, property, value);
+      }
+      return this;
+   }
+
+   /**
+    * Adds a value to set on all given cameras that have the property.
+    */
+   CameraSettingsTransaction setAllIfPresent(List<String> cameras, String property,
+                                             String value) {
+      for (String camera : cameras) {
+         changes_.add(new Change(camera, property, value, true));
+      }
+      return this;
+   }
+
+   /**
+    * Validates all values, and sets them if they are all valid.
+    *
+    * @throws IllegalArgumentException if a value is invalid; nothing was set
+    * @throws Exception if setting a value failed; the values set before were
+    *                   restored as far as possible
+    */
+   void apply() throws Exception {
+      List<Change> changes = new ArrayList<>();
+      List<String> problems = new ArrayList<>();
+      for (Change change : changes_) {
+         if (!core_.hasProperty(change.camera_, change.property_)) {
+            if (!change.optional_) {
+               problems.add(change.camera_ + " has no property " + change.property_);
+            }
+            continue;
+         }
+         String problem = validate(change);
+         if (problem != null) {
+            problems.add(problem);
+         } else {
+            changes.add(change);
+         }
+      }
+      if (!problems.isEmpty()) {
+         throw new IllegalArgumentException("Camera settings not applied: "
+               + String.join("; ", problems));
+      }
+
+      List<Change> undo = new ArrayList<>();
+      try {
+         for (Change change : changes) {
+            String previous = core_.getProperty(change.camera_, change.property_);
+            if (previous.equals(change.value_)) {
+               continue;
+            }
+            core_.setProperty(change.camera_, change.property_, change.value_);
+            undo.add(new Change(change.camera_, change.property_, previous, false));
+         }
+      } catch (Exception e) {
+         for (int i = undo.size() - 1; i >= 0; i--) {
+            Change change = undo.get(i);
+            try {
+               core_.setProperty(change.camera_, change.property_, change.value_);
+            } catch (Exception ignored) {
+               // Report the original error
+            }
+         }
+         throw e;
+      }
+   }
+
+   private String validate(Change change) throws Exception {
+      String what = change.camera_ + "-" + change.property_;
+      if (core_.isPropertyReadOnly(change.camera_, change.property_)) {
+         return what + " is read-only";
+      }
+      StrVector allowed = core_.getAllowedPropertyValues(change.camera_, change.property_);
+      if (allowed.size() > 0) {
+         for (int i = 0; i < allowed.size(); i++) {
+            if (allowed.get(i).equals(change.value_)) {
+               return null;
+            }
+         }
+         return change.value_ + " is not allowed for " + what;
+      }
+      if (core_.hasPropertyLimits(change.camera_, change.property_)) {
+         double value;
+         try {
+            value = Double.parseDouble(change.value_);
+         } catch (NumberFormatException e) {
+            return change.value_ + " is not a number, for " + what;
+         }
+         if (value < core_.getPropertyLowerLimit(change.camera_, change.property_)
+               || value > core_.getPropertyUpperLimit(change.camera_, change.property_)) {
+            return change.value_ + " is out of range for " + what;
+         }
+      }
+      return null;
+   }
+}
@@ -0,0 +1,311 @@
+/*
+ * FrameSynchronizer.java
+ *
+ * Copyright UCSF, 2024
+ *
+ */
+
+package org.micromanager.multicamera;
+
+import java.util.ArrayDeque;
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Map;
+
+/**
+ * Pairs the frames of several cameras into synchronized tuples, based on
+ * their timestamps, and keeps statistics on skew and lost frames.
+ *
+ * <p>Frames of each camera are queued until a frame of every other camera
+ * arrived. The oldest frames of all cameras form a tuple when their
+ * timestamps lie within the tolerance. A frame that is older than the
+ * oldest queued frame of another camera by more than the tolerance can no
+ * longer be paired, and is counted as unpaired. Gaps in the frame counter of
+ * a camera are counted as dropped frames.
+ *
+ * <p>All methods are thread safe.
+ */
+public final class FrameSynchronizer {
+
+   // Frames kept per camera while waiting for the other cameras
+   static final int MAX_PENDING = 64;
+
+   /**
+    * Frames of all cameras taken at the same time.
+    */
+   public static final class Tuple {
+      private final Map<String, Long> frameNumbers_;
+      private final double timestampMs_;
+      private final double skewMs_;
+
+      private Tuple(Map<String, Long> frameNumbers, double timestampMs, double skewMs) {
+         frameNumbers_ = Collections.unmodifiableMap(frameNumbers);
+         timestampMs_ = timestampMs;
+         skewMs_ = skewMs;
+      }
+
+      /**
+       * Frame number of each camera, in camera order.
+       */
+      public Map<String, Long> getFrameNumbers() {
+         return frameNumbers_;
+      }
+
+      /**
+       * Timestamp of the earliest frame.
+       */
+      public double getTimestampMs() {
+         return timestampMs_;
+      }
+
+      /**
+       * Difference between the latest and the earliest timestamp.
+       */
+      public double getSkewMs() {
+         return skewMs_;
+      }
+   }
+
+   /**
+    * Counts of a single camera.
+    */
+   public static final class CameraStatistics {
+      private final long frames_;
+      private final long lastFrameNumber_;
+      private final double lastTimestampMs_;
+      private final long dropped_;
+      private final long unpaired_;
+
+      private CameraStatistics(long frames, long lastFrameNumber, double lastTimestampMs,
+                               long dropped, long unpaired) {
+         frames_ = frames;
+         lastFrameNumber_ = lastFrameNumber;
+         lastTimestampMs_ = lastTimestampMs;
+         dropped_ = dropped;
+         unpaired_ = unpaired;
+      }
+
+      /**
+       * Number of frames received.
+       */
+      public long getFrames() {
+         return frames_;
+      }
+
+      /**
+       * Frame number of the last frame received, or -1.
+       */
+      public long getLastFrameNumber() {
+         return lastFrameNumber_;
+      }
+
+      public double getLastTimestampMs() {
+         return lastTimestampMs_;
+      }
+
+      /**
+       * Number of frames missing from the frame counter sequence.
+       */
+      public long getDropped() {
+         return dropped_;
+      }
+
+      /**
+       * Number of frames received that are not part of a tuple.
+       */
+      public long getUnpaired() {
+         return unpaired_;
+      }
+   }
+
+   /**
+    * Immutable snapshot of the state of a synchronizer.
+    */
+   public static final class Statistics {
+      private final Map<String, CameraStatistics> cameras_;
+      private final long tuples_;
+      private final double lastSkewMs_;
+      private final double maxSkewMs_;
+      private final double meanSkewMs_;
+
+      private Statistics(Map<String, CameraStatistics> cameras, long tuples,
+                         double lastSkewMs, double maxSkewMs, double meanSkewMs) {
+         cameras_ = Collections.unmodifiableMap(cameras);
+         tuples_ = tuples;
+         lastSkewMs_ = lastSkewMs;
+         maxSkewMs_ = maxSkewMs;
+         meanSkewMs_ = meanSkewMs;
+      }
+
+      public Map<String, CameraStatistics> getCameras() {
+         return cameras_;
+      }
+
+      public long getTuples() {
+         return tuples_;
+      }
+
+      public double getLastSkewMs() {
+         return lastSkewMs_;
+      }
+
+      public double getMaxSkewMs() {
+         return maxSkewMs_;
+      }
+
+      public double getMeanSkewMs() {
+         return meanSkewMs_;
+      }
+
+      /**
+       * Sum of dropped and unpaired frames over all cameras.
+       */
+      public long getLostFrames() {
+         long lost = 0;
+         for (CameraStatistics camera : cameras_.values()) {
+            lost += camera.getDropped() + camera.getUnpaired();
+         }
+         return lost;
+      }
+   }
+
+   private static final class Frame {
+      private final long frameNumber_;
+      private final double timestampMs_;
+
+      private Frame(long frameNumber, double timestampMs) {
+         frameNumber_ = frameNumber;
+         timestampMs_ = timestampMs;
+      }
+   }
+
+   private static final class Camera {
+      private final ArrayDeque<Frame> pending_ = new ArrayDeque<>();
+      private long frames_ = 0;
+      private long lastFrameNumber_ = -1;
+      private double lastTimestampMs_ = Double.NaN;
+      private long dropped_ = 0;
+      private long unpaired_ = 0;
+   }
+
+   private final double toleranceMs_;
+   // Guarded by this
+   private final Map<String, Camera> cameras_ = new LinkedHashMap<>();
+   private long tuples_ = 0;
+   private double lastSkewMs_ = Double.NaN;
+   private double maxSkewMs_ = 0.0;
+   private double sumSkewMs_ = 0.0;
+
+   /**
+    * @param cameras labels of the cameras to synchronize
+    * @param toleranceMs largest difference in timestamps between frames of
+    *                    the same tuple
+    */
+   public FrameSynchronizer(List<String> cameras, double toleranceMs) {
+      if (cameras.isEmpty()) {
+         throw new IllegalArgumentException("No cameras to synchronize");
+      }
+      toleranceMs_ = toleranceMs;
+      for (String camera : cameras) {
+         cameras_.put(camera, new Camera());
+      }
+   }
+
+   public double getToleranceMs() {
+      return toleranceMs_;
+   }
+
+   /**
+    * Returns whether frames of the given camera are synchronized.
+    */
+   public synchronized boolean hasCamera(String camera) {
+      return cameras_.containsKey(camera);
+   }
+
+   /**
+    * Adds a frame, and returns the tuples it completed.
+    *
+    * @param camera label of the camera
+    * @param frameNumber value of the frame counter of the camera, or a
+    *                    negative number when unknown
+    * @param timestampMs time at which the frame was taken
+    * @return tuples completed by this frame, oldest first; often empty
+    * @throws IllegalArgumentException if the camera is not synchronized
+    */
+   public synchronized List<Tuple> addFrame(String camera, long frameNumber,
+                                            double timestampMs) {
+      Camera cam = cameras_.get(camera);
+      if (cam == null) {
+         throw new IllegalArgumentException("Unknown camera: " + camera);
+      }
+      cam.frames_++;
+      if (frameNumber >= 0) {
+         if (cam.lastFrameNumber_ >= 0 && frameNumber > cam.lastFrameNumber_ + 1) {
+            cam.dropped_ += frameNumber - cam.lastFrameNumber_ - 1;
+         }
+         cam.lastFrameNumber_ = frameNumber;
+      }
+      cam.lastTimestampMs_ = timestampMs;
+      cam.pending_.addLast(new Frame(frameNumber, timestampMs));
+      if (cam.pending_.size() > MAX_PENDING) {
+         // Another camera stopped delivering frames
+         cam.pending_.removeFirst();
+         cam.unpaired_++;
+      }
+      return pair();
+   }
+
+   private List<Tuple> pair() {
+      List<Tuple> result = new ArrayList<>(1);
+      while (true) {
+         double earliest = Double.POSITIVE_INFINITY;
+         double latest = Double.NEGATIVE_INFINITY;
+         for (Camera camera : cameras_.values()) {
+            Frame head = camera.pending_.peekFirst();
+            if (head == null) {
+               return result;
+            }
+            earliest = Math.min(earliest, head.timestampMs_);
+            latest = Math.max(latest, head.timestampMs_);
+         }
+         if (latest - earliest <= toleranceMs_) {
+            Map<String, Long> frameNumbers = new LinkedHashMap<>();
+            for (Map.Entry<String, Camera> entry : cameras_.entrySet()) {
+               frameNumbers.put(entry.getKey(),
+                     entry.getValue().pending_.removeFirst().frameNumber_);
+            }
+            double skew = latest - earliest;
+            tuples_++;
+            lastSkewMs_ = skew;
+            maxSkewMs_ = Math.max(maxSkewMs_, skew);
+            sumSkewMs_ += skew;
+            result.add(new Tuple(frameNumbers, earliest, skew));
+            continue;
+         }
+         // Frames too old to be paired with the oldest frame of the camera
+         // that is furthest ahead lost their partners
+         for (Camera camera : cameras_.values()) {
+            if (camera.pending_.peekFirst().timestampMs_ < latest - toleranceMs_) {
+               camera.pending_.removeFirst();
+               camera.unpaired_++;
+            }
+         }
+      }
+   }
+
+   /**
+    * Returns the current counts.
+    */
+   public synchronized Statistics getStatistics() {
+      Map<String, CameraStatistics> cameras = new LinkedHashMap<>();
+      for (Map.Entry<String, Camera> entry : cameras_.entrySet()) {
+         Camera cam = entry.getValue();
+         cameras.put(entry.getKey(), new CameraStatistics(cam.frames_,
+               cam.lastFrameNumber_, cam.lastTimestampMs_, cam.dropped_, cam.unpaired_));
+      }
+      return new Statistics(cameras, tuples_, lastSkewMs_, maxSkewMs_,
+            tuples_ == 0 ? Double.NaN : sumSkewMs_ / tuples_);
+   }
+}
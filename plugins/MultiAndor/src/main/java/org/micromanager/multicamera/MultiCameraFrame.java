@@ -12,10 +12,14 @@
 package org.micromanager.multicamera;
 
 import com.google.common.eventbus.Subscribe;
+import java.awt.BorderLayout;
+import java.awt.Color;
 import java.awt.Toolkit;
 import java.awt.event.ItemEvent;
 import java.text.ParseException;
 import java.util.ArrayList;
+import java.util.Map;
+import javax.swing.BorderFactory;
 import javax.swing.DefaultComboBoxModel;
 import javax.swing.GroupLayout;
 import javax.swing.JButton;
@@ -23,15 +27,22 @@ import javax.swing.JCheckBox;
 import javax.swing.JComboBox;
 import javax.swing.JFrame;
 import javax.swing.JLabel;
+import javax.swing.JPanel;
 import javax.swing.JSlider;
 import javax.swing.JTextField;
 import javax.swing.LayoutStyle;
 import javax.swing.SwingUtilities;
+import javax.swing.Timer;
 import javax.swing.WindowConstants;
 import mmcorej.CMMCore;
 import mmcorej.DeviceType;
 import mmcorej.StrVector;
 import org.micromanager.Studio;
+import org.micromanager.acquisition.AcquisitionEndedEvent;
+import org.micromanager.acquisition.AcquisitionStartedEvent;
+import org.micromanager.data.DataProvider;
+import org.micromanager.data.DataProviderHasNewImageEvent;
+import org.micromanager.data.Metadata;
 import org.micromanager.events.PropertiesChangedEvent;
 import org.micromanager.events.PropertyChangedEvent;
 import org.micromanager.internal.utils.NumberUtils;
@@ -78,6 +89,14 @@ public class MultiCameraFrame extends JFrame {
    private static final String PHYSCAM2 = "Physical Camera 2";
    private static final String PHYSCAM3 = "Physical Camera 3";
    private static final String PHYSCAM4 = "Physical Camera 4";
+   private static final String SYNC_IDLE = "Frame sync: no sequence running";
+   // Smallest difference in timestamps accepted between synchronized frames
+   private static final double MIN_SYNC_TOLERANCE_MS = 1.0;
+   private final JLabel syncLabel_ = new JLabel(SYNC_IDLE);
+   private final Timer syncTimer_ = new Timer(500, e -> showSyncStatistics());
+   private volatile FrameSynchronizer synchronizer_;
+   // Accessed on the EDT only
+   private DataProvider syncedProvider_;
 
    /**
     * Creates new form MultiCameraFrame
@@ -113,6 +132,15 @@ public class MultiCameraFrame extends JFrame {
 
       initComponents();
 
+      // Frame synchronization status, below the generated form
+      JPanel contentPane = new JPanel(new BorderLayout());
+      contentPane.add(getContentPane(), BorderLayout.CENTER);
+      syncLabel_.setFont(new java.awt.Font("Lucida Grande", 0, 10)); // NOI18N
+      syncLabel_.setBorder(BorderFactory.createEmptyBorder(0, 10, 5, 10));
+      contentPane.add(syncLabel_, BorderLayout.SOUTH);
+      setContentPane(contentPane);
+      pack();
+
       super.setIconImage(Toolkit.getDefaultToolkit().getImage(
             getClass().getResource("/org/micromanager/icons/microscope.gif")));
       super.setLocation(100, 100);
@@ -559,9 +587,9 @@ public class MultiCameraFrame extends JFrame {
       gui_.live().setSuspended(true);
       int val = emGainSlider.getValue();
       try {
-         for (String camera : camerasInUse_) {
-            setPropertyIfPossible(camera, EMGAIN, NumberUtils.intToCoreString(val));
-         }
+         new CameraSettingsTransaction(core_)
+               .setAllIfPresent(camerasInUse_, EMGAIN, NumberUtils.intToCoreString(val))
+               .apply();
          gui_.app().refreshGUI();
       } catch (Exception ex) {
          gui_.logs().showError(ex, MultiCameraFrame.class.getName() + " encountered an error.");
@@ -633,9 +661,9 @@ public class MultiCameraFrame extends JFrame {
          command = "On";
       }
       try {
-         for (String camera : camerasInUse_) {
-            setPropertyIfPossible(camera, EMSWITCH, command);
-         }
+         new CameraSettingsTransaction(core_)
+               .setAllIfPresent(camerasInUse_, EMSWITCH, command)
+               .apply();
       } catch (Exception ex) {
          gui_.logs().showError(ex, MultiCameraFrame.class.getName() + " encountered an error.");
       } finally {
@@ -723,19 +751,18 @@ public class MultiCameraFrame extends JFrame {
       gui_.live().setSuspended(true);
       String mode = item.toString();
       try {
-         for (String camera : camerasInUse_) {
-            if (mode.equals(MODEEM14)) {
-               core_.setProperty(camera, ADCONVERTER, AD14BIT);
-               core_.setProperty(camera, MODE, EMMODE);
-            } else if (mode.equals(MODEEM16)) {
-               core_.setProperty(camera, ADCONVERTER, AD16BIT);
-               core_.setProperty(camera, MODE, EMMODE);
-            } else if (mode.equals(MODECONV16)) {
-               core_.setProperty(camera, ADCONVERTER, AD16BIT);
-               core_.setProperty(camera, MODE, NORMALMODE);
-            }
-
+         CameraSettingsTransaction settings = new CameraSettingsTransaction(core_);
+         if (mode.equals(MODEEM14)) {
+            settings.setAll(camerasInUse_, ADCONVERTER, AD14BIT);
+            settings.setAll(camerasInUse_, MODE, EMMODE);
+         } else if (mode.equals(MODEEM16)) {
+            settings.setAll(camerasInUse_, ADCONVERTER, AD16BIT);
+            settings.setAll(camerasInUse_, MODE, EMMODE);
+         } else if (mode.equals(MODECONV16)) {
+            settings.setAll(camerasInUse_, ADCONVERTER, AD16BIT);
+            settings.setAll(camerasInUse_, MODE, NORMALMODE);
          }
+         settings.apply();
 
          updateItems(gainComboBox, AMPGAIN);
          updateItems(speedComboBox, SPEED);
@@ -933,9 +960,10 @@ public class MultiCameraFrame extends JFrame {
          return;
       }
       try {
-         for (String camera : camerasInUse_) {
-            core_.setProperty(camera, property, val);
-         }
+         new CameraSettingsTransaction(core_).setAll(camerasInUse_, property, val).apply();
+      } catch (IllegalArgumentException ex) {
+         gui_.logs().showError(ex.getMessage());
+         getComboSelection(comboBox, property);
       } catch (Exception ex) {
          gui_.logs().showError(ex, MultiCameraFrame.class.getName() + " encountered an error.");
       } finally {
@@ -993,14 +1021,104 @@ public class MultiCameraFrame extends JFrame {
       }
    }
 
-   private void setPropertyIfPossible(String device, String property, String value) {
-      try {
-         if (core_.hasProperty(device, property)) {
-            core_.setProperty(device, property, value);
+   @Subscribe
+   public void onAcquisitionStarted(final AcquisitionStartedEvent event) {
+      SwingUtilities.invokeLater(() -> startFrameSync(event.getDatastore()));
+   }
+
+   @Subscribe
+   public void onAcquisitionEnded(final AcquisitionEndedEvent event) {
+      SwingUtilities.invokeLater(() -> {
+         if (event.getStore() == syncedProvider_) {
+            stopFrameSync();
          }
+      });
+   }
+
+   /**
+    * Called on the thread that adds images to a synchronized data provider.
+    */
+   @Subscribe
+   public void onNewImage(DataProviderHasNewImageEvent event) {
+      FrameSynchronizer synchronizer = synchronizer_;
+      if (synchronizer == null) {
+         return;
+      }
+      Metadata metadata = event.getImage().getMetadata();
+      String camera = metadata.getCamera();
+      if (camera == null || !synchronizer.hasCamera(camera) || !metadata.hasElapsedTimeMs()) {
+         return;
+      }
+      Long frameNumber = metadata.getImageNumber();
+      synchronizer.addFrame(camera, frameNumber == null ? -1 : frameNumber,
+            metadata.getElapsedTimeMs(0.0));
+   }
+
+   /**
+    * Starts pairing the frames of the cameras in use, as they are added to
+    * the given data provider. Frames are paired when they are no further
+    * apart than half the exposure time.
+    *
+    * <p>Only used for acquisitions: live mode skips frames on purpose, which
+    * would be counted as dropped.
+    */
+   private void startFrameSync(DataProvider provider) {
+      stopFrameSync();
+      if (camerasInUse_.size() < 2) {
+         return;
+      }
+      double toleranceMs = MIN_SYNC_TOLERANCE_MS;
+      try {
+         toleranceMs = Math.max(toleranceMs, core_.getExposure() / 2);
       } catch (Exception ex) {
          gui_.logs().logError(ex);
       }
+      synchronizer_ = new FrameSynchronizer(new ArrayList<>(camerasInUse_), toleranceMs);
+      syncedProvider_ = provider;
+      provider.registerForEvents(this);
+      syncTimer_.start();
+   }
+
+   /**
+    * Stops pairing frames; the last statistics remain on display.
+    */
+   private void stopFrameSync() {
+      if (syncedProvider_ != null) {
+         syncedProvider_.unregisterForEvents(this);
+         syncedProvider_ = null;
+      }
+      syncTimer_.stop();
+      showSyncStatistics();
+   }
+
+   private void showSyncStatistics() {
+      FrameSynchronizer synchronizer = synchronizer_;
+      if (synchronizer == null) {
+         syncLabel_.setText(SYNC_IDLE);
+         return;
+      }
+      FrameSynchronizer.Statistics stats = synchronizer.getStatistics();
+      StringBuilder text = new StringBuilder("Synced frames: ").append(stats.getTuples());
+      if (stats.getTuples() > 0) {
+         text.append(String.format(", skew %.1f ms (max %.1f)",
+               stats.getLastSkewMs(), stats.getMaxSkewMs()));
+      }
+      text.append(", lost:");
+      StringBuilder details = new StringBuilder("<html>");
+      for (Map.Entry<String, FrameSynchronizer.CameraStatistics> entry
+            : stats.getCameras().entrySet()) {
+         FrameSynchronizer.CameraStatistics camera = entry.getValue();
+         text.append(" ").append(camera.getDropped() + camera.getUnpaired());
+         details.append(entry.getKey()).append(": ").append(camera.getFrames())
+               .append(" frames, last #").append(camera.getLastFrameNumber())
+               .append(", ").append(camera.getDropped()).append(" dropped, ")
+               .append(camera.getUnpaired()).append(" unpaired<br>");
+      }
+      details.append(String.format("Tolerance %.1f ms, mean skew %.2f ms</html>",
+            synchronizer.getToleranceMs(), stats.getMeanSkewMs()));
+      syncLabel_.setText(text.toString());
+      syncLabel_.setToolTipText(details.toString());
+      syncLabel_.setForeground(stats.getLostFrames() > 0 ? Color.RED : Color.BLACK);
    }
 
 
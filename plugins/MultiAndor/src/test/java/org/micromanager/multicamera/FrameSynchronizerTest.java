@@ -0,0 +1,100 @@
+package org.micromanager.multicamera;
+
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.Collections;
+import java.util.List;
+import java.util.Random;
+import org.junit.Assert;
+import org.junit.Test;
+
+public class FrameSynchronizerTest {
+   private static final double INTERVAL_MS = 20.0;
+   private static final double TOLERANCE_MS = 5.0;
+
+   @Test
+   public void interleavedStreamsArePaired() {
+      FrameSynchronizer sync = new FrameSynchronizer(Arrays.asList("A", "B", "C"),
+            TOLERANCE_MS);
+      Random random = new Random(42);
+      List<FrameSynchronizer.Tuple> tuples = new ArrayList<>();
+      for (int i = 0; i < 100; i++) {
+         // Cameras deliver in a varying order, with up to 2 ms jitter
+         List<String> order = new ArrayList<>(Arrays.asList("A", "B", "C"));
+         Collections.shuffle(order, random);
+         for (String camera : order) {
+            tuples.addAll(sync.addFrame(camera, i, i * INTERVAL_MS + 2 * random.nextDouble()));
+         }
+      }
+      Assert.assertEquals(100, tuples.size());
+      for (int i = 0; i < tuples.size(); i++) {
+         FrameSynchronizer.Tuple tuple = tuples.get(i);
+         Assert.assertEquals(Arrays.asList((long) i, (long) i, (long) i),
+               new ArrayList<>(tuple.getFrameNumbers().values()));
+         Assert.assertTrue(tuple.getSkewMs() <= 2.0);
+      }
+      FrameSynchronizer.Statistics stats = sync.getStatistics();
+      Assert.assertEquals(100, stats.getTuples());
+      Assert.assertEquals(0, stats.getLostFrames());
+      Assert.assertTrue(stats.getMaxSkewMs() <= 2.0);
+      Assert.assertEquals(99, stats.getCameras().get("B").getLastFrameNumber());
+   }
+
+   @Test
+   public void droppedFramesAreDetected() {
+      FrameSynchronizer sync = new FrameSynchronizer(Arrays.asList("A", "B"), TOLERANCE_MS);
+      int tuples = 0;
+      for (int i = 0; i < 20; i++) {
+         tuples += sync.addFrame("A", i, i * INTERVAL_MS).size();
+         // B loses frames 5 and 6
+         if (i != 5 && i != 6) {
+            tuples += sync.addFrame("B", i, i * INTERVAL_MS + 1.0).size();
+         }
+      }
+      Assert.assertEquals(18, tuples);
+      FrameSynchronizer.Statistics stats = sync.getStatistics();
+      Assert.assertEquals(2, stats.getCameras().get("B").getDropped());
+      Assert.assertEquals(0, stats.getCameras().get("B").getUnpaired());
+      // Frames of A that lost their partner
+      Assert.assertEquals(2, stats.getCameras().get("A").getUnpaired());
+      Assert.assertEquals(0, stats.getCameras().get("A").getDropped());
+      Assert.assertEquals(1.0, stats.getMeanSkewMs(), 1e-9);
+   }
+
+   @Test
+   public void framesOutOfToleranceAreNotPaired() {
+      FrameSynchronizer sync = new FrameSynchronizer(Arrays.asList("A", "B"), TOLERANCE_MS);
+      for (int i = 0; i < 10; i++) {
+         // B is misaligned by half a frame interval
+         sync.addFrame("A", -1, i * INTERVAL_MS);
+         sync.addFrame("B", -1, i * INTERVAL_MS + INTERVAL_MS / 2);
+      }
+      FrameSynchronizer.Statistics stats = sync.getStatistics();
+      Assert.assertEquals(0, stats.getTuples());
+      Assert.assertEquals(10, stats.getCameras().get("A").getUnpaired());
+      Assert.assertEquals(9, stats.getCameras().get("B").getUnpaired());
+      Assert.assertEquals(-1, stats.getCameras().get("A").getLastFrameNumber());
+      Assert.assertEquals(0, stats.getCameras().get("A").getDropped());
+   }
+
+   @Test
+   public void stalledCameraDoesNotGrowQueues() {
+      FrameSynchronizer sync = new FrameSynchronizer(Arrays.asList("A", "B"), TOLERANCE_MS);
+      int frames = FrameSynchronizer.MAX_PENDING + 10;
+      for (int i = 0; i < frames; i++) {
+         Assert.assertTrue(sync.addFrame("A", i, i * INTERVAL_MS).isEmpty());
+      }
+      Assert.assertEquals(10, sync.getStatistics().getCameras().get("A").getUnpaired());
+      // B catches up with its latest frame
+      double last = (frames - 1) * INTERVAL_MS;
+      List<FrameSynchronizer.Tuple> tuples = sync.addFrame("B", frames - 1, last);
+      Assert.assertEquals(1, tuples.size());
+      Assert.assertEquals(last, tuples.get(0).getTimestampMs(), 1e-9);
+      Assert.assertEquals(frames - 1, sync.getStatistics().getCameras().get("A").getUnpaired());
+   }
+
+   @Test(expected = IllegalArgumentException.class)
+   public void unknownCameraIsRejected() {
+      new FrameSynchronizer(Arrays.asList("A", "B"), TOLERANCE_MS).addFrame("C", 0, 0.0);
+   }
+}
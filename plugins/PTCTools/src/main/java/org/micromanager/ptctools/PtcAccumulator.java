@@ -0,0 +1,236 @@
+///////////////////////////////////////////////////////////////////////////////
+//FILE:          PtcAccumulator.java
+//PROJECT:       Micro-Manager
+//SUBSYSTEM:     mmstudio
+//-----------------------------------------------------------------------------
+//
+// COPYRIGHT:    University of California, San Francisco, 2024
+//
+// LICENSE:      This file is distributed under the BSD license.
+//               License text is included with the source distribution.
+//
+//               This file is distributed in the hope that it will be useful,
+//               but WITHOUT ANY WARRANTY; without even the implied warranty
+//               of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//               IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//               CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//               INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+package org.micromanager.ptctools;
+
+import java.util.stream.IntStream;
+
+/**
+ * Per-pixel statistics of a series of frames taken at the same exposure,
+ * updated as frames arrive, so that the frames themselves need not be kept.
+ *
+ * <p>Mean and variance use Welford's update. Consecutive frames are also
+ * taken in pairs, and the variance of their difference is accumulated: half
+ * of it is the temporal variance without the contribution of slow drift of
+ * the light source. Frames are processed in bands of rows, in parallel for
+ * large frames.
+ *
+ * <p>Not thread safe; frames are to be added from a single thread.
+ */
+public final class PtcAccumulator {
+   // Rows per band; also the unit of parallel work
+   private static final int BAND_ROWS = 64;
+   // Frames with fewer pixels are processed on the calling thread
+   private static final int PARALLEL_PIXELS = 1 << 18;
+
+   private final int width_;
+   private final int height_;
+   private final double[] mean_;
+   private final double[] m2_;
+   private final double[] diffMean_;
+   private final double[] diffM2_;
+   // First frame of the pair currently being collected
+   private final int[] previous_;
+   private int frames_ = 0;
+   private int pairs_ = 0;
+   // Welford accumulators of the average intensity of each frame
+   private double frameMeanMean_ = 0.0;
+   private double frameMeanM2_ = 0.0;
+
+   public PtcAccumulator(int width, int height) {
+      if (width <= 0 || height <= 0) {
+         throw new IllegalArgumentException("Invalid frame size " + width + "x" + height);
+      }
+      width_ = width;
+      height_ = height;
+      int nrPixels = width * height;
+      mean_ = new double[nrPixels];
+      m2_ = new double[nrPixels];
+      diffMean_ = new double[nrPixels];
+      diffM2_ = new double[nrPixels];
+      previous_ = new int[nrPixels];
+   }
+
+   public int getWidth() {
+      return width_;
+   }
+
+   public int getHeight() {
+      return height_;
+   }
+
+   public int getFrameCount() {
+      return frames_;
+   }
+
+   /**
+    * Adds a frame to the statistics.
+    *
+    * @param pixels unsigned 8-bit (byte[]) or 16-bit (short[]) pixels
+    * @throws IllegalArgumentException if the pixel type or number of pixels
+    *                                  is not supported
+    */
+   public void addFrame(final Object pixels) {
+      int length;
+      if (pixels instanceof short[]) {
+         length = ((short[]) pixels).length;
+      } else if (pixels instanceof byte[]) {
+         length = ((byte[]) pixels).length;
+      } else {
+         throw new IllegalArgumentException("Only 8 and 16 bit images are supported");
+      }
+      if (length != mean_.length) {
+         throw new IllegalArgumentException("Expected " + mean_.length
+               + " pixels of 8 or 16 bits, got " + length + " elements");
+      }
+      final int n = frames_ + 1;
+      final boolean closesPair = frames_ % 2 == 1;
+      final int nrPairs = pairs_ + 1;
+      final int bands = (height_ + BAND_ROWS - 1) / BAND_ROWS;
+      final double[] bandSums = new double[bands];
+      IntStream indices = IntStream.range(0, bands);
+      if (mean_.length >= PARALLEL_PIXELS) {
+         indices = indices.parallel();
+      }
+      indices.forEach(b -> bandSums[b] = addBand(pixels, b, n, closesPair, nrPairs));
+
+      double sum = 0.0;
+      for (double bandSum : bandSums) {
+         sum += bandSum;
+      }
+      double frameMean = sum / mean_.length;
+      double delta = frameMean - frameMeanMean_;
+      frameMeanMean_ += delta / n;
+      frameMeanM2_ += delta * (frameMean - frameMeanMean_);
+
+      frames_ = n;
+      if (closesPair) {
+         pairs_ = nrPairs;
+      }
+   }
+
+   /**
+    * Updates the accumulators of one band of rows.
+    *
+    * @return sum of the pixel values in the band
+    */
+   private double addBand(Object pixels, int band, int n, boolean closesPair, int nrPairs) {
+      final short[] shorts = pixels instanceof short[] ? (short[]) pixels : null;
+      final byte[] bytes = shorts == null ? (byte[]) pixels : null;
+      final int start = band * BAND_ROWS * width_;
+      final int end = Math.min(height_, (band + 1) * BAND_ROWS) * width_;
+      final double invN = 1.0 / n;
+      final double invPairs = 1.0 / nrPairs;
+      double sum = 0.0;
+      for (int i = start; i < end; i++) {
+         int value = shorts != null ? shorts[i] & 0xffff : bytes[i] & 0xff;
+         sum += value;
+         double delta = value - mean_[i];
+         mean_[i] += delta * invN;
+         m2_[i] += delta * (value - mean_[i]);
+         if (closesPair) {
+            double diff = previous_[i] - value;
+            double diffDelta = diff - diffMean_[i];
+            diffMean_[i] += diffDelta * invPairs;
+            diffM2_[i] += diffDelta * (diff - diffMean_[i]);
+         } else {
+            previous_[i] = value;
+         }
+      }
+      return sum;
+   }
+
+   /**
+    * Returns the mean of each pixel.
+    */
+   public float[] getMean() {
+      float[] result = new float[mean_.length];
+      for (int i = 0; i < result.length; i++) {
+         result[i] = (float) mean_[i];
+      }
+      return result;
+   }
+
+   /**
+    * Returns the sample standard deviation of each pixel, including drift of
+    * the light source.
+    */
+   public float[] getStdDev() {
+      float[] result = new float[m2_.length];
+      if (frames_ > 1) {
+         for (int i = 0; i < result.length; i++) {
+            result[i] = (float) Math.sqrt(m2_[i] / (frames_ - 1));
+         }
+      }
+      return result;
+   }
+
+   /**
+    * Returns the temporal variance of each pixel, estimated from the
+    * differences between pairs of consecutive frames when there are at least
+    * two pairs, and from all frames otherwise.
+    */
+   public double[] getTemporalVariance() {
+      double[] result = new double[mean_.length];
+      if (pairs_ > 1) {
+         for (int i = 0; i < result.length; i++) {
+            result[i] = diffM2_[i] / (pairs_ - 1) / 2.0;
+         }
+      } else if (frames_ > 1) {
+         for (int i = 0; i < result.length; i++) {
+            result[i] = m2_[i] / (frames_ - 1);
+         }
+      }
+      return result;
+   }
+
+   /**
+    * Returns the mean of each pixel, in double precision.
+    */
+   double[] getMeanDouble() {
+      return mean_.clone();
+   }
+
+   /**
+    * Returns the average over all pixels of the mean.
+    */
+   public double getAverageSignal() {
+      return frameMeanMean_;
+   }
+
+   /**
+    * Returns the average over all pixels of the temporal variance. As it is
+    * computed per pixel, it does not include fixed-pattern noise.
+    */
+   public double getAverageTemporalVariance() {
+      double sum = 0.0;
+      for (double variance : getTemporalVariance()) {
+         sum += variance;
+      }
+      return sum / mean_.length;
+   }
+
+   /**
+    * Returns the standard deviation of the average intensity of the frames,
+    * a measure of the stability of the light source.
+    */
+   public double getFrameMeanStdDev() {
+      return frames_ > 1 ? Math.sqrt(frameMeanM2_ / (frames_ - 1)) : 0.0;
+   }
+}
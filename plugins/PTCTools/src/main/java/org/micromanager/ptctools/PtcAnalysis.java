@@ -0,0 +1,271 @@
+///////////////////////////////////////////////////////////////////////////////
+//FILE:          PtcAnalysis.java
+//PROJECT:       Micro-Manager
+//SUBSYSTEM:     mmstudio
+//-----------------------------------------------------------------------------
+//
+// COPYRIGHT:    University of California, San Francisco, 2024
+//
+// LICENSE:      This file is distributed under the BSD license.
+//               License text is included with the source distribution.
+//
+//               This file is distributed in the hope that it will be useful,
+//               but WITHOUT ANY WARRANTY; without even the implied warranty
+//               of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//               IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//               CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//               INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+package org.micromanager.ptctools;
+
+import java.util.ArrayList;
+import java.util.List;
+
+/**
+ * Photon transfer analysis of a dark series and a series of exposures with
+ * light, each summarized by a {@link PtcAccumulator}.
+ *
+ * <p>Shot noise makes the temporal variance (in DN²) of a pixel grow linearly
+ * with its signal above the dark offset, with a slope of 1 / gain, where the
+ * gain is in electrons per DN. Per-pixel slopes are fitted through the origin
+ * as exposures are added, keeping only two sums per pixel. The average
+ * signal and variance of each exposure are kept for the overall fit.
+ *
+ * <p>Pixels with a mean at or above the saturation level are left out of
+ * the fits.
+ */
+public final class PtcAnalysis {
+
+   /**
+    * Result of the overall photon transfer fit.
+    */
+   public static final class Fit {
+      private final double slope_;
+      private final double intercept_;
+      private final double rSquared_;
+      private final int nrPoints_;
+      private final double offset_;
+      private final double readNoise_;
+
+      private Fit(double slope, double intercept, double rSquared, int nrPoints,
+                  double offset, double readNoise) {
+         slope_ = slope;
+         intercept_ = intercept;
+         rSquared_ = rSquared;
+         nrPoints_ = nrPoints;
+         offset_ = offset;
+         readNoise_ = readNoise;
+      }
+
+      /**
+       * Slope of variance versus signal above offset, in DN per electron.
+       */
+      public double getSlope() {
+         return slope_;
+      }
+
+      /**
+       * Variance at zero signal according to the fit, in DN².
+       */
+      public double getIntercept() {
+         return intercept_;
+      }
+
+      public double getRSquared() {
+         return rSquared_;
+      }
+
+      public int getNrPoints() {
+         return nrPoints_;
+      }
+
+      /**
+       * Conversion gain in electrons per DN.
+       */
+      public double getGain() {
+         return 1.0 / slope_;
+      }
+
+      /**
+       * Average dark signal, in DN.
+       */
+      public double getOffset() {
+         return offset_;
+      }
+
+      /**
+       * Read noise measured in the dark series, in DN.
+       */
+      public double getReadNoiseDN() {
+         return readNoise_;
+      }
+
+      /**
+       * Read noise measured in the dark series, in electrons.
+       */
+      public double getReadNoiseElectrons() {
+         return readNoise_ * getGain();
+      }
+   }
+
+   private final int width_;
+   private final int height_;
+   private final double saturation_;
+   private double[] offset_;
+   private double[] readVariance_;
+   private double darkSignal_;
+   private double darkVariance_;
+   // Per pixel sums of signal² and signal * variance, for the fit through
+   // the origin
+   private final double[] sxx_;
+   private final double[] sxy_;
+   private final List<double[]> points_ = new ArrayList<>();
+
+   /**
+    * @param width width of the frames
+    * @param height height of the frames
+    * @param saturation pixel value (DN) from which pixels are considered
+    *                   saturated
+    */
+   public PtcAnalysis(int width, int height, double saturation) {
+      width_ = width;
+      height_ = height;
+      saturation_ = saturation;
+      sxx_ = new double[width * height];
+      sxy_ = new double[width * height];
+   }
+
+   /**
+    * Sets the statistics of frames taken without light. Must be called
+    * before adding exposures.
+    */
+   public void setDark(PtcAccumulator dark) {
+      checkSize(dark);
+      offset_ = dark.getMeanDouble();
+      readVariance_ = dark.getTemporalVariance();
+      darkSignal_ = dark.getAverageSignal();
+      darkVariance_ = dark.getAverageTemporalVariance();
+   }
+
+   /**
+    * Adds the statistics of frames taken with light at one exposure time.
+    *
+    * @param exposureMs exposure time, only kept for reporting
+    * @param light statistics of the frames
+    */
+   public void addExposure(double exposureMs, PtcAccumulator light) {
+      checkSize(light);
+      if (offset_ == null) {
+         throw new IllegalStateException("Dark statistics must be set first");
+      }
+      double[] mean = light.getMeanDouble();
+      double[] variance = light.getTemporalVariance();
+      for (int i = 0; i < mean.length; i++) {
+         if (mean[i] >= saturation_) {
+            continue;
+         }
+         double x = mean[i] - offset_[i];
+         double y = variance[i] - readVariance_[i];
+         sxx_[i] += x * x;
+         sxy_[i] += x * y;
+      }
+      points_.add(new double[] {exposureMs, light.getAverageSignal() - darkSignal_,
+            light.getAverageTemporalVariance()});
+   }
+
+   private void checkSize(PtcAccumulator accumulator) {
+      if (accumulator.getWidth() != width_ || accumulator.getHeight() != height_) {
+         throw new IllegalArgumentException("Frame size differs from "
+               + width_ + "x" + height_);
+      }
+   }
+
+   /**
+    * Returns, for each exposure added so far, the exposure time, the average
+    * signal above the dark offset, and the average temporal variance.
+    */
+   public List<double[]> getPoints() {
+      return new ArrayList<>(points_);
+   }
+
+   /**
+    * Returns the gain (electrons per DN) of each pixel, or NaN for pixels
+    * without usable exposures.
+    */
+   public float[] getGainMap() {
+      float[] result = new float[sxx_.length];
+      for (int i = 0; i < result.length; i++) {
+         result[i] = sxy_[i] > 0.0 ? (float) (sxx_[i] / sxy_[i]) : Float.NaN;
+      }
+      return result;
+   }
+
+   /**
+    * Returns the dark offset (DN) of each pixel.
+    */
+   public float[] getOffsetMap() {
+      float[] result = new float[sxx_.length];
+      for (int i = 0; i < result.length; i++) {
+         result[i] = (float) offset_[i];
+      }
+      return result;
+   }
+
+   /**
+    * Returns the read noise of each pixel, in electrons, or NaN for pixels
+    * without a gain.
+    */
+   public float[] getReadNoiseMap() {
+      float[] gain = getGainMap();
+      float[] result = new float[gain.length];
+      for (int i = 0; i < result.length; i++) {
+         result[i] = (float) (Math.sqrt(readVariance_[i]) * gain[i]);
+      }
+      return result;
+   }
+
+   /**
+    * Fits a line through the average variance versus the average signal
+    * of all exposures whose average is below saturation.
+    *
+    * @return the fit, or null with fewer than two usable exposures
+    */
+   public Fit fit() {
+      double limit = saturation_ - darkSignal_;
+      int n = 0;
+      double sx = 0.0;
+      double sy = 0.0;
+      for (double[] point : points_) {
+         if (point[1] < limit) {
+            n++;
+            sx += point[1];
+            sy += point[2];
+         }
+      }
+      if (n < 2) {
+         return null;
+      }
+      double mx = sx / n;
+      double my = sy / n;
+      double sxx = 0.0;
+      double sxy = 0.0;
+      double syy = 0.0;
+      for (double[] point : points_) {
+         if (point[1] < limit) {
+            double dx = point[1] - mx;
+            double dy = point[2] - my;
+            sxx += dx * dx;
+            sxy += dx * dy;
+            syy += dy * dy;
+         }
+      }
+      if (sxx == 0.0) {
+         return null;
+      }
+      double slope = sxy / sxx;
+      double rSquared = syy == 0.0 ? 1.0 : sxy * sxy / (sxx * syy);
+      return new Fit(slope, my - slope * mx, rSquared, n, darkSignal_,
+            Math.sqrt(darkVariance_));
+   }
+}
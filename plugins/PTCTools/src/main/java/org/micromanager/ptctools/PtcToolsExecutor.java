@@ -23,22 +23,16 @@
 package org.micromanager.ptctools;
 
 import ij.CompositeImage;
+import ij.IJ;
 import ij.ImagePlus;
 import ij.ImageStack;
 import ij.measure.ResultsTable;
-import ij.plugin.ZProjector;
 import ij.process.FloatProcessor;
-import ij.process.ImageProcessor;
-import ij.process.ImageStatistics;
-import ij.process.ShortProcessor;
 import java.awt.Toolkit;
 import java.awt.event.ActionEvent;
-import java.io.IOException;
 import java.lang.reflect.InvocationTargetException;
 import java.text.ParseException;
-import java.text.SimpleDateFormat;
 import java.util.ArrayList;
-import java.util.Date;
 import java.util.List;
 import javax.swing.JButton;
 import javax.swing.JFrame;
@@ -49,20 +43,20 @@ import mmcorej.TaggedImage;
 import net.miginfocom.swing.MigLayout;
 import org.micromanager.PropertyMap;
 import org.micromanager.Studio;
-import org.micromanager.data.Coordinates;
-import org.micromanager.data.Coords;
-import org.micromanager.data.Datastore;
-import org.micromanager.data.Image;
-import org.micromanager.data.SummaryMetadata;
 import org.micromanager.internal.utils.NumberUtils;
 import org.micromanager.internal.utils.ReportingUtils;
 import org.micromanager.internal.utils.WindowPositioning;
 
 public class PtcToolsExecutor extends Thread {
+   // Fraction of the full scale of the camera from which pixels are
+   // considered saturated, and left out of the photon transfer fit
+   private static final double SATURATION_FRACTION = 0.9;
+
    private final Studio studio_;
    private final PropertyMap settings_;
    private final List<ExpMeanStdDev> expMeanStdDev_;
    private ImageStack stack_;
+   private PtcAnalysis analysis_;
 
    /**
     * Simple class to hold Avg. Intensity and StdDev of Avg. intensities
@@ -106,20 +100,11 @@ public class PtcToolsExecutor extends Thread {
          rt.setPrecision(4);
 
          // Stack that holds the resulting images
-         stack_ = new ImageStack((int) core.getImageWidth(),
-               (int) core.getImageHeight());
-
-         // temporary store to hold images while calculating mean and stdDev
-         Datastore store = studio_.data().createRAMDatastore();
-         final SummaryMetadata.Builder smb = studio_.data().summaryMetadataBuilder();
-         final Coords.Builder cb = Coordinates.builder();
-         Coords coords = cb.c(1).p(1).t(nrFrames).z(1).build();
-         try {
-            store.setSummaryMetadata(smb.intendedDimensions(coords).startDate(
-                  new SimpleDateFormat("yyyy.MM.dd.HH.mm.ss").format(new Date())).build());
-         } catch (IOException ex) {
-            // should never happen with a RAMDatastore...
-         }
+         final int width = (int) core.getImageWidth();
+         final int height = (int) core.getImageHeight();
+         stack_ = new ImageStack(width, height);
+         analysis_ = new PtcAnalysis(width, height,
+               SATURATION_FRACTION * ((1L << core.getImageBitDepth()) - 1));
 
          double exposure;
          try {
@@ -130,29 +115,17 @@ public class PtcToolsExecutor extends Thread {
             return;
          }
 
+         final PtcAccumulator dark;
          try {
-            runSequence(core, store, nrFrames, exposure);
+            dark = runSequence(core, nrFrames, exposure);
          } catch (Exception ex) {
             studio_.logs().showError(ex, "Error while acquiring images");
             return;
          }
 
-         // TODO: make sure that we have 16-bit (short) images
-         try {
-            calculateAndAddToStack(stack_, store);
-            ExpMeanStdDev cemsd = calcExpMeanStdDev(store);
-            expMeanStdDev_.add(cemsd);
-            rt.incrementCounter();
-            rt.addValue("Exposure", 0.0);
-            rt.addValue("Mean", cemsd.mean_);
-            rt.addValue("Std.Dev", cemsd.stdDev_);
-
-            store.freeze();
-            store.close();
-         } catch (IOException ex) {
-            studio_.logs().showError(ex, "Error while calculating mean and stdDev");
-            return;
-         }
+         addToStack(stack_, dark);
+         analysis_.setDark(dark);
+         addResults(rt, 0.0, dark);
 
          PtcSequenceRunner sr = new LightSequence();
          showDialog("Now switch on the light, and make sure it can reach the"
@@ -200,37 +173,24 @@ public class PtcToolsExecutor extends Thread {
 
             exposures[i] = Math.exp(minExpLog + i * expLogStep);
 
-            Datastore store = studio_.data().createRAMDatastore();
+            final PtcAccumulator light;
             try {
-               runSequence(core, store, nrFrames, exposures[i]);
+               light = runSequence(core, nrFrames, exposures[i]);
             } catch (Exception ex) {
                studio_.logs().showError(ex, "Error while acquiring images");
                return;
             }
 
-            // TODO: make sure that we have 16-bit (short) images
+            double realExposure;
             try {
-               calculateAndAddToStack(stack_, store);
-               ExpMeanStdDev cemsd = calcExpMeanStdDev(store);
-               double realExposure;
-               try {
-                  realExposure = core.getExposure();
-               } catch (Exception e) {
-                  ReportingUtils.showError(e);
-                  return;
-               }
-               expMeanStdDev_.add(cemsd);
-               rt.incrementCounter();
-               rt.addValue("Exposure", realExposure);
-               rt.addValue("Mean", cemsd.mean_);
-               rt.addValue("Std.Dev", cemsd.stdDev_);
-               store.close();
-            } catch (IOException ex) {
-               studio_.logs().showError(ex, "Error while calculating mean and stdDev");
+               realExposure = core.getExposure();
+            } catch (Exception e) {
+               ReportingUtils.showError(e);
                return;
             }
-            System.gc();
-
+            addToStack(stack_, light);
+            analysis_.addExposure(realExposure, light);
+            addResults(rt, realExposure, light);
          }
 
          rt.show("Results");
@@ -239,6 +199,7 @@ public class PtcToolsExecutor extends Thread {
          imp.setDimensions(2, 1, stack_.getSize() / 2);
          CompositeImage comp = new CompositeImage(imp, CompositeImage.COLOR);
          comp.show();
+         showAnalysis(analysis_);
       }
    }
 
@@ -280,69 +241,70 @@ public class PtcToolsExecutor extends Thread {
       dialog.setVisible(true);
    }
 
-   private void runSequence(CMMCore core, Datastore store, int nrFrames,
-                            double exposure) throws Exception {
-      final Coords.Builder cb = Coordinates.builder().c(1).p(1).t(1).z(1);
+   private PtcAccumulator runSequence(CMMCore core, int nrFrames,
+                                      double exposure) throws Exception {
+      PtcAccumulator accumulator = new PtcAccumulator((int) core.getImageWidth(),
+            (int) core.getImageHeight());
       core.setExposure(exposure);
       core.startSequenceAcquisition(nrFrames, 0.0, true);
-      int frCounter = 0;
+      // Frames are added to the statistics as they arrive, and not kept
       // TODO: this can hang
-      while (core.isSequenceRunning() || core.getRemainingImageCount() > 0) {
-         if (core.getRemainingImageCount() > 0) {
-            TaggedImage nextImage = core.popNextTaggedImage();
-            if (nextImage != null) {
-               Image img = studio_.data().convertTaggedImage(nextImage);
-               store.putImage(img.copyAtCoords(cb.t(frCounter).build()));
-               frCounter++;
+      try {
+         while (core.isSequenceRunning() || core.getRemainingImageCount() > 0) {
+            if (core.getRemainingImageCount() > 0) {
+               TaggedImage nextImage = core.popNextTaggedImage();
+               if (nextImage != null) {
+                  accumulator.addFrame(nextImage.pix);
+               }
             }
          }
+      } catch (IllegalArgumentException iae) {
+         core.stopSequenceAcquisition();
+         throw iae;
       }
-      store.freeze();
+      return accumulator;
    }
 
-   private void calculateAndAddToStack(ImageStack stack, Datastore store)
-         throws IOException, OutOfMemoryError {
-      final Coords.Builder cb = Coordinates.builder().c(1).p(1).t(1).z(1);
-      int nrFrames = store.getNextIndex(Coords.T);
-      ImageStack tmpStack = new ImageStack(stack.getWidth(), stack.getHeight());
-      List<ShortProcessor> lc = new ArrayList<>(nrFrames);
-      for (int i = 0; i < nrFrames; i++) {
-         ShortProcessor tmpShortProc = new ShortProcessor(stack.getWidth(),
-               stack.getHeight());
-         tmpShortProc.setPixels(store.getImage(cb.t(i).build()).getRawPixels());
-         tmpStack.addSlice(tmpShortProc);
-      }
-      ZProjector zProj = new ZProjector(new ImagePlus("tmp", tmpStack));
-      zProj.setMethod(ZProjector.AVG_METHOD);
-      zProj.doProjection();
-      ImagePlus meanP = zProj.getProjection();
-      FloatProcessor mean = (FloatProcessor) meanP.getProcessor().convertToFloat();
-      zProj.setMethod(ZProjector.SD_METHOD);
-      zProj.doProjection();
-      ImagePlus stdDevP = zProj.getProjection();
-      FloatProcessor stdDev = (FloatProcessor) stdDevP.getProcessor().convertToFloat();
-
-      stack.addSlice(mean);
-      stack.addSlice(stdDev);
+   private void addToStack(ImageStack stack, PtcAccumulator accumulator) {
+      stack.addSlice(new FloatProcessor(stack.getWidth(), stack.getHeight(),
+            accumulator.getMean()));
+      stack.addSlice(new FloatProcessor(stack.getWidth(), stack.getHeight(),
+            accumulator.getStdDev()));
    }
 
+   private void addResults(ResultsTable rt, double exposure, PtcAccumulator accumulator) {
+      ExpMeanStdDev cemsd = new ExpMeanStdDev();
+      cemsd.mean_ = accumulator.getAverageSignal();
+      cemsd.stdDev_ = accumulator.getFrameMeanStdDev();
+      expMeanStdDev_.add(cemsd);
+      rt.incrementCounter();
+      rt.addValue("Exposure", exposure);
+      rt.addValue("Mean", cemsd.mean_);
+      rt.addValue("Std.Dev", cemsd.stdDev_);
+      rt.addValue("Temporal Var.", accumulator.getAverageTemporalVariance());
+   }
 
-   private ExpMeanStdDev calcExpMeanStdDev(Datastore store) throws IOException {
-      ExpMeanStdDev result = new ExpMeanStdDev();
-      final Coords.Builder cb = Coordinates.builder().c(1).p(1).t(1).z(1);
-      final int nrFrames = store.getNextIndex(Coords.T);
-      double[] means = new double[nrFrames];
-      for (int i = 0; i < nrFrames; i++) {
-         Image image = store.getImage(cb.t(i).build());
-         ImageProcessor proc = studio_.data().ij().createProcessor(image);
-         ImageStatistics stats = ImageStatistics.getStatistics(proc,
-               ImageStatistics.MEAN, null);
-         means[i] = stats.mean;
+   private void showAnalysis(PtcAnalysis analysis) {
+      ImageStack maps = new ImageStack(stack_.getWidth(), stack_.getHeight());
+      maps.addSlice("Gain (e-/DN)", new FloatProcessor(stack_.getWidth(),
+            stack_.getHeight(), analysis.getGainMap()));
+      maps.addSlice("Offset (DN)", new FloatProcessor(stack_.getWidth(),
+            stack_.getHeight(), analysis.getOffsetMap()));
+      maps.addSlice("Read noise (e-)", new FloatProcessor(stack_.getWidth(),
+            stack_.getHeight(), analysis.getReadNoiseMap()));
+      new ImagePlus("PTCTools maps", maps).show();
+
+      PtcAnalysis.Fit fit = analysis.fit();
+      if (fit == null) {
+         IJ.log("PTC: not enough unsaturated exposures for a fit");
+         return;
       }
-      result.mean_ = avg(means);
-      result.stdDev_ = stdDev(means, result.mean_);
-
-      return result;
+      IJ.log(String.format("PTC fit of %d exposures (R\u00b2 = %.4f):", fit.getNrPoints(),
+            fit.getRSquared()));
+      IJ.log(String.format("  Gain: %.4f e-/DN", fit.getGain()));
+      IJ.log(String.format("  Offset: %.2f DN", fit.getOffset()));
+      IJ.log(String.format("  Read noise: %.3f DN, %.3f e-", fit.getReadNoiseDN(),
+            fit.getReadNoiseElectrons()));
    }
 
    public static double avg(double[] numbers) {
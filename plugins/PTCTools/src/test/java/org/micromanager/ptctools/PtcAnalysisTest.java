@@ -0,0 +1,172 @@
+package org.micromanager.ptctools;
+
+import java.util.Arrays;
+import java.util.Random;
+import org.junit.Assert;
+import org.junit.Test;
+
+public class PtcAnalysisTest {
+   private static final int WIDTH = 40;
+   private static final int HEIGHT = 30;
+   private static final int NR_FRAMES = 60;
+   // Electrons per DN
+   private static final double GAIN = 2.0;
+   private static final double OFFSET = 100.0;
+   private static final double READ_NOISE_DN = 1.5;
+
+   /**
+    * Camera that converts Poisson distributed photo-electrons into DN, adds
+    * Gaussian read noise and a per-pixel offset (fixed pattern), and
+    * quantizes to 16 bits.
+    */
+   private static final class SyntheticCamera {
+      private final Random random_;
+      private final double[] offsets_ = new double[WIDTH * HEIGHT];
+
+      SyntheticCamera(long seed) {
+         random_ = new Random(seed);
+         for (int i = 0; i < offsets_.length; i++) {
+            offsets_[i] = OFFSET + 5.0 * random_.nextGaussian();
+         }
+      }
+
+      short[] snap(double electrons) {
+         short[] pixels = new short[WIDTH * HEIGHT];
+         for (int i = 0; i < pixels.length; i++) {
+            double value = offsets_[i] + poisson(electrons) / GAIN
+                  + READ_NOISE_DN * random_.nextGaussian();
+            pixels[i] = (short) Math.max(0, Math.min(65535, Math.round(value)));
+         }
+         return pixels;
+      }
+
+      private double poisson(double mean) {
+         if (mean == 0.0) {
+            return 0.0;
+         }
+         if (mean > 30.0) {
+            return Math.max(0.0, Math.round(mean + Math.sqrt(mean) * random_.nextGaussian()));
+         }
+         double limit = Math.exp(-mean);
+         double product = random_.nextDouble();
+         int k = 0;
+         while (product > limit) {
+            product *= random_.nextDouble();
+            k++;
+         }
+         return k;
+      }
+
+      PtcAccumulator series(double electrons) {
+         PtcAccumulator accumulator = new PtcAccumulator(WIDTH, HEIGHT);
+         for (int f = 0; f < NR_FRAMES; f++) {
+            accumulator.addFrame(snap(electrons));
+         }
+         return accumulator;
+      }
+   }
+
+   private static double median(float[] values) {
+      float[] sorted = values.clone();
+      Arrays.sort(sorted);
+      return sorted[sorted.length / 2];
+   }
+
+   @Test
+   public void welfordMatchesTwoPass() {
+      Random random = new Random(3);
+      int nrFrames = 11;
+      // Large enough to be processed in parallel bands
+      int width = 700;
+      int height = 400;
+      short[][] frames = new short[nrFrames][width * height];
+      PtcAccumulator accumulator = new PtcAccumulator(width, height);
+      for (short[] frame : frames) {
+         for (int i = 0; i < frame.length; i++) {
+            frame[i] = (short) (40000 + random.nextInt(2000));
+         }
+         accumulator.addFrame(frame);
+      }
+      float[] mean = accumulator.getMean();
+      float[] stdDev = accumulator.getStdDev();
+      for (int i = 0; i < width * height; i += 997) {
+         double sum = 0.0;
+         for (short[] frame : frames) {
+            sum += frame[i] & 0xffff;
+         }
+         double m = sum / nrFrames;
+         double ss = 0.0;
+         for (short[] frame : frames) {
+            ss += ((frame[i] & 0xffff) - m) * ((frame[i] & 0xffff) - m);
+         }
+         Assert.assertEquals(m, mean[i], 1e-2);
+         Assert.assertEquals(Math.sqrt(ss / (nrFrames - 1)), stdDev[i], 1e-2);
+      }
+   }
+
+   @Test
+   public void pairDifferencesRemoveDrift() {
+      PtcAccumulator accumulator = new PtcAccumulator(WIDTH, HEIGHT);
+      Random random = new Random(5);
+      for (int f = 0; f < NR_FRAMES; f++) {
+         byte[] frame = new byte[WIDTH * HEIGHT];
+         for (int i = 0; i < frame.length; i++) {
+            // slow ramp of the light source plus unit variance noise
+            frame[i] = (byte) Math.round(50 + f + random.nextGaussian());
+         }
+         accumulator.addFrame(frame);
+      }
+      Assert.assertEquals(1.0 + 1.0 / 12, accumulator.getAverageTemporalVariance(), 0.1);
+      // The plain standard deviation is dominated by the ramp
+      Assert.assertTrue(accumulator.getStdDev()[0] > 10.0);
+   }
+
+   @Test
+   public void recoversKnownGainOffsetAndReadNoise() {
+      SyntheticCamera camera = new SyntheticCamera(42);
+      PtcAnalysis analysis = new PtcAnalysis(WIDTH, HEIGHT, 0.9 * 65535);
+      analysis.setDark(camera.series(0.0));
+      for (double electrons : new double[] {20, 50, 100, 200, 500, 1000, 2000, 5000}) {
+         analysis.addExposure(electrons, camera.series(electrons));
+      }
+
+      PtcAnalysis.Fit fit = analysis.fit();
+      Assert.assertNotNull(fit);
+      Assert.assertEquals(8, fit.getNrPoints());
+      Assert.assertEquals(GAIN, fit.getGain(), 0.05 * GAIN);
+      Assert.assertEquals(OFFSET, fit.getOffset(), 1.0);
+      // Quantization adds 1/12 DN² to the read noise variance
+      double readNoise = Math.sqrt(READ_NOISE_DN * READ_NOISE_DN + 1.0 / 12);
+      Assert.assertEquals(readNoise, fit.getReadNoiseDN(), 0.05 * readNoise);
+      Assert.assertEquals(readNoise * GAIN, fit.getReadNoiseElectrons(), 0.1 * readNoise * GAIN);
+      Assert.assertTrue(fit.getRSquared() > 0.99);
+
+      Assert.assertEquals(GAIN, median(analysis.getGainMap()), 0.05 * GAIN);
+      Assert.assertEquals(readNoise * GAIN, median(analysis.getReadNoiseMap()),
+            0.1 * readNoise * GAIN);
+      float[] offsets = analysis.getOffsetMap();
+      for (int i = 0; i < offsets.length; i++) {
+         Assert.assertEquals(camera.offsets_[i], offsets[i], 1.0);
+      }
+   }
+
+   @Test
+   public void saturatedExposuresAreIgnored() {
+      SyntheticCamera camera = new SyntheticCamera(7);
+      PtcAnalysis analysis = new PtcAnalysis(WIDTH, HEIGHT, 1000);
+      analysis.setDark(camera.series(0.0));
+      for (double electrons : new double[] {100, 400, 1000, 4000}) {
+         analysis.addExposure(electrons, camera.series(electrons));
+      }
+      PtcAnalysis.Fit fit = analysis.fit();
+      Assert.assertNotNull(fit);
+      // 4000 e- is 2100 DN, above the saturation level
+      Assert.assertEquals(3, fit.getNrPoints());
+      Assert.assertEquals(GAIN, fit.getGain(), 0.1 * GAIN);
+   }
+
+   @Test(expected = IllegalArgumentException.class)
+   public void rejectsWrongFrameSize() {
+      new PtcAccumulator(WIDTH, HEIGHT).addFrame(new short[WIDTH]);
+   }
+}
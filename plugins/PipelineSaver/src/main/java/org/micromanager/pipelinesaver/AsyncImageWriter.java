@@ -0,0 +1,392 @@
+///////////////////////////////////////////////////////////////////////////////
+//PROJECT:       Micro-Manager
+//SUBSYSTEM:     mmstudio
+//-----------------------------------------------------------------------------
+//
+// COPYRIGHT:    University of California, San Francisco, 2024
+//
+// LICENSE:      This file is distributed under the BSD license.
+//               License text is included with the source distribution.
+//
+//               This file is distributed in the hope that it will be useful,
+//               but WITHOUT ANY WARRANTY; without even the implied warranty
+//               of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//               IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//               CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//               INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+//
+
+
+package org.micromanager.pipelinesaver;
+
+import java.io.IOException;
+import java.util.ArrayDeque;
+import java.util.concurrent.TimeUnit;
+import org.micromanager.data.Image;
+
+/**
+ * Writes images on a dedicated thread, so that the processing pipeline does
+ * not wait for the disk.
+ *
+ * <p>Images waiting to be written are held in a queue whose size is limited
+ * to a number of bytes. What happens to an image that does not fit is set by
+ * the {@link OverflowPolicy}. A single image larger than the budget is
+ * accepted when the queue is empty.
+ *
+ * <p>Images are written in the order in which they were added.
+ */
+public final class AsyncImageWriter {
+
+   /**
+    * Destination of the images.
+    */
+   public interface Sink {
+      /**
+       * Writes an image. Called on the writer thread only.
+       */
+      void putImage(Image image) throws IOException;
+
+      /**
+       * Called on the writer thread once all images have been written.
+       */
+      void close() throws IOException;
+   }
+
+   /**
+    * What to do with an image when the queue is full.
+    */
+   public enum OverflowPolicy {
+      /** Wait until there is room in the queue. */
+      BLOCK("Wait"),
+      /** Do not save the image, and count it as dropped. */
+      DROP("Drop images"),
+      /** Save the image to the spill destination instead. */
+      SPILL("Save to spill path");
+
+      private final String description_;
+
+      OverflowPolicy(String description) {
+         description_ = description;
+      }
+
+      @Override
+      public String toString() {
+         return description_;
+      }
+
+      /**
+       * Returns the policy with the given name, or BLOCK when not recognized.
+       */
+      public static OverflowPolicy fromName(String name) {
+         for (OverflowPolicy policy : values()) {
+            if (policy.name().equals(name)) {
+               return policy;
+            }
+         }
+         return BLOCK;
+      }
+   }
+
+   /**
+    * Immutable snapshot of the state of a writer.
+    */
+   public static final class Statistics {
+      private final int queuedImages_;
+      private final long queuedBytes_;
+      private final long writtenImages_;
+      private final long writtenBytes_;
+      private final long writeNanos_;
+      private final long droppedImages_;
+      private final long droppedBytes_;
+      private final long spilledImages_;
+      private final long failedImages_;
+
+      private Statistics(int queuedImages, long queuedBytes,
+            long writtenImages, long writtenBytes, long writeNanos,
+            long droppedImages, long droppedBytes, long spilledImages,
+            long failedImages) {
+         queuedImages_ = queuedImages;
+         queuedBytes_ = queuedBytes;
+         writtenImages_ = writtenImages;
+         writtenBytes_ = writtenBytes;
+         writeNanos_ = writeNanos;
+         droppedImages_ = droppedImages;
+         droppedBytes_ = droppedBytes;
+         spilledImages_ = spilledImages;
+         failedImages_ = failedImages;
+      }
+
+      public int getQueuedImages() {
+         return queuedImages_;
+      }
+
+      public long getQueuedBytes() {
+         return queuedBytes_;
+      }
+
+      public long getWrittenImages() {
+         return writtenImages_;
+      }
+
+      public long getWrittenBytes() {
+         return writtenBytes_;
+      }
+
+      public long getDroppedImages() {
+         return droppedImages_;
+      }
+
+      public long getDroppedBytes() {
+         return droppedBytes_;
+      }
+
+      /**
+       * Number of images handed to the spill writer because the queue was full.
+       */
+      public long getSpilledImages() {
+         return spilledImages_;
+      }
+
+      /**
+       * Number of images for which the sink threw an exception.
+       */
+      public long getFailedImages() {
+         return failedImages_;
+      }
+
+      /**
+       * Bytes written per second of time spent writing, or 0 before the
+       * first write.
+       */
+      public double getWriteBytesPerSecond() {
+         return writeNanos_ == 0 ? 0.0 : writtenBytes_ * 1e9 / writeNanos_;
+      }
+   }
+
+   private final Sink sink_;
+   private final long budgetBytes_;
+   private final OverflowPolicy policy_;
+   private final AsyncImageWriter spill_;
+   private final Thread thread_;
+
+   // All fields below are guarded by this
+   private final ArrayDeque<Image> queue_ = new ArrayDeque<>();
+   private long queuedBytes_ = 0;
+   private boolean writing_ = false;
+   private boolean closed_ = false;
+   private long writtenImages_ = 0;
+   private long writtenBytes_ = 0;
+   private long writeNanos_ = 0;
+   private long droppedImages_ = 0;
+   private long droppedBytes_ = 0;
+   private long spilledImages_ = 0;
+   private long failedImages_ = 0;
+   private Exception lastError_ = null;
+
+   /**
+    * Creates a writer and starts its thread.
+    *
+    * @param name name of the writer thread
+    * @param sink destination of the images
+    * @param budgetBytes maximum number of bytes of queued images
+    * @param policy what to do when the queue is full
+    * @param spill destination of the images that do not fit in the queue;
+    *              only used, and required, with the SPILL policy. Images are
+    *              written to it by a second writer, which waits when full.
+    */
+   public AsyncImageWriter(String name, Sink sink, long budgetBytes,
+                           OverflowPolicy policy, Sink spill) {
+      if (budgetBytes <= 0) {
+         throw new IllegalArgumentException("Queue budget must be positive");
+      }
+      if (policy == OverflowPolicy.SPILL && spill == null) {
+         throw new IllegalArgumentException("Spill policy requires a spill destination");
+      }
+      sink_ = sink;
+      budgetBytes_ = budgetBytes;
+      policy_ = policy;
+      spill_ = policy == OverflowPolicy.SPILL
+            ? new AsyncImageWriter(name + " (spill)", spill, budgetBytes,
+                  OverflowPolicy.BLOCK, null)
+            : null;
+      thread_ = new Thread(this::run, name);
+      thread_.setDaemon(true);
+      thread_.start();
+   }
+
+   /**
+    * Returns the number of bytes an image takes in the queue.
+    */
+   static long sizeOf(Image image) {
+      return (long) image.getWidth() * image.getHeight() * image.getBytesPerPixel();
+   }
+
+   /**
+    * Queues an image for writing. Only blocks when the queue is full and the
+    * policy is BLOCK (or SPILL, and the spill queue is full as well).
+    *
+    * @param image image to write
+    * @return false if the image was dropped
+    * @throws IllegalStateException if the writer was closed
+    */
+   public boolean putImage(Image image) throws InterruptedException {
+      final long size = sizeOf(image);
+      synchronized (this) {
+         if (closed_) {
+            throw new IllegalStateException("Writer is closed");
+         }
+         while (!fits(size)) {
+            if (policy_ == OverflowPolicy.DROP) {
+               droppedImages_++;
+               droppedBytes_ += size;
+               return false;
+            }
+            if (policy_ == OverflowPolicy.SPILL) {
+               spilledImages_++;
+               break;
+            }
+            wait();
+            if (closed_) {
+               throw new IllegalStateException("Writer is closed");
+            }
+         }
+         if (fits(size)) {
+            queue_.addLast(image);
+            queuedBytes_ += size;
+            notifyAll();
+            return true;
+         }
+      }
+      // Outside of the lock, as this may wait for the spill writer
+      spill_.putImage(image);
+      return true;
+   }
+
+   private boolean fits(long size) {
+      return queue_.isEmpty() || queuedBytes_ + size <= budgetBytes_;
+   }
+
+   /**
+    * Returns the current state of the writer; for the SPILL policy, the
+    * queued, written and failed counts include the spill writer.
+    */
+   public Statistics getStatistics() {
+      Statistics spill = spill_ == null ? null : spill_.getStatistics();
+      synchronized (this) {
+         if (spill == null) {
+            return new Statistics(queue_.size(), queuedBytes_, writtenImages_,
+                  writtenBytes_, writeNanos_, droppedImages_, droppedBytes_,
+                  spilledImages_, failedImages_);
+         }
+         return new Statistics(queue_.size() + spill.queuedImages_,
+               queuedBytes_ + spill.queuedBytes_,
+               writtenImages_ + spill.writtenImages_,
+               writtenBytes_ + spill.writtenBytes_,
+               writeNanos_ + spill.writeNanos_,
+               droppedImages_, droppedBytes_, spilledImages_,
+               failedImages_ + spill.failedImages_);
+      }
+   }
+
+   /**
+    * Returns, and forgets, the last exception thrown by the sink.
+    *
+    * @return the exception, or null if all writes succeeded since the last call
+    */
+   public synchronized Exception takeLastError() {
+      Exception result = lastError_;
+      lastError_ = null;
+      if (result == null && spill_ != null) {
+         result = spill_.takeLastError();
+      }
+      return result;
+   }
+
+   /**
+    * Waits until all images that were queued so far have been written.
+    */
+   public void flush() throws InterruptedException {
+      synchronized (this) {
+         while (!queue_.isEmpty() || writing_) {
+            wait();
+         }
+      }
+      if (spill_ != null) {
+         spill_.flush();
+      }
+   }
+
+   /**
+    * Stops accepting images, writes all queued images, and closes the sink.
+    * Returns when the sink has been closed or the timeout expired.
+    *
+    * @param timeout maximum time to wait
+    * @param unit unit of timeout
+    * @return true if all images were written and the sink closed in time
+    */
+   public boolean close(long timeout, TimeUnit unit) throws InterruptedException {
+      synchronized (this) {
+         closed_ = true;
+         notifyAll();
+      }
+      long deadline = System.nanoTime() + unit.toNanos(timeout);
+      boolean done = true;
+      if (spill_ != null) {
+         done = spill_.close(timeout, unit);
+      }
+      long remainingMs = TimeUnit.NANOSECONDS.toMillis(deadline - System.nanoTime());
+      thread_.join(Math.max(1, remainingMs));
+      return done && !thread_.isAlive();
+   }
+
+   private void run() {
+      while (true) {
+         Image image;
+         synchronized (this) {
+            while (queue_.isEmpty() && !closed_) {
+               try {
+                  wait();
+               } catch (InterruptedException e) {
+                  // Keep going; images are only discarded by draining the queue
+               }
+            }
+            if (queue_.isEmpty()) {
+               break;
+            }
+            image = queue_.peekFirst();
+            writing_ = true;
+         }
+         long start = System.nanoTime();
+         Exception error = null;
+         try {
+            sink_.putImage(image);
+         } catch (IOException | RuntimeException e) {
+            error = e;
+         }
+         long elapsed = System.nanoTime() - start;
+         synchronized (this) {
+            queue_.removeFirst();
+            long size = sizeOf(image);
+            queuedBytes_ -= size;
+            writing_ = false;
+            if (error == null) {
+               writtenImages_++;
+               writtenBytes_ += size;
+               writeNanos_ += elapsed;
+            } else {
+               failedImages_++;
+               lastError_ = error;
+            }
+            notifyAll();
+         }
+      }
+      try {
+         sink_.close();
+      } catch (IOException | RuntimeException e) {
+         synchronized (this) {
+            lastError_ = e;
+         }
+      }
+   }
+}
@@ -30,6 +30,8 @@ import javax.swing.JComboBox;
 import javax.swing.JFrame;
 import javax.swing.JLabel;
 import javax.swing.JPanel;
+import javax.swing.JSpinner;
+import javax.swing.SpinnerNumberModel;
 import javax.swing.JTextField;
 import net.miginfocom.swing.MigLayout;
 import org.micromanager.PropertyMap;
@@ -45,12 +47,21 @@ public class SaverConfigurator extends JFrame implements ProcessorConfigurator {
    private static final String SHOULD_DISPLAY_PIPELINE_DATA =
          "whether or not to display mid-pipeline datasets";
    private static final String SAVE_PATH = "default save path for saving mid-pipeline datasets";
+   private static final String OVERFLOW_POLICY =
+         "what to do when mid-pipeline images can not be saved in time";
+   private static final String QUEUE_MB = "size of the queue for saving mid-pipeline datasets";
+   private static final String SPILL_PATH =
+         "path for mid-pipeline images that can not be saved in time";
 
    private final Studio studio_;
    private final JCheckBox shouldDisplay_;
    private final JComboBox saveFormat_;
    private JTextField savePath_;
    private final JButton browseButton_;
+   private final JComboBox overflowPolicy_;
+   private final JSpinner queueMB_;
+   private final JTextField spillPath_;
+   private final JButton spillBrowseButton_;
 
    public SaverConfigurator(PropertyMap settings, Studio studio) {
       studio_ = studio;
@@ -61,7 +72,8 @@ public class SaverConfigurator extends JFrame implements ProcessorConfigurator {
 
       panel.add(new JLabel("Save format: "), "split 2");
       String[] formats = new String[] {SaverPlugin.RAM,
-            SaverPlugin.MULTIPAGE_TIFF, SaverPlugin.SINGLEPLANE_TIFF_SERIES};
+            SaverPlugin.MULTIPAGE_TIFF, SaverPlugin.SINGLEPLANE_TIFF_SERIES,
+            SaverPlugin.ND_TIFF};
       saveFormat_ = new JComboBox(formats);
       saveFormat_.setSelectedItem(
             settings.getString("format", getPreferredSaveFormat()));
@@ -96,6 +108,41 @@ public class SaverConfigurator extends JFrame implements ProcessorConfigurator {
          }
       });
       panel.add(browseButton_, "wrap");
+
+      panel.add(new JLabel("Write queue (MB): "), "split 2");
+      queueMB_ = new JSpinner(new SpinnerNumberModel(
+            settings.getInteger("queueMB", getQueueMB()), 1, 65536, 64));
+      panel.add(queueMB_, "wrap");
+
+      panel.add(new JLabel("When the queue is full: "), "split 2");
+      overflowPolicy_ = new JComboBox(AsyncImageWriter.OverflowPolicy.values());
+      overflowPolicy_.setSelectedItem(AsyncImageWriter.OverflowPolicy.fromName(
+            settings.getString("overflowPolicy", getOverflowPolicy())));
+      overflowPolicy_.addActionListener(new ActionListener() {
+         @Override
+         public void actionPerformed(ActionEvent e) {
+            updateControls();
+         }
+      });
+      panel.add(overflowPolicy_, "wrap");
+
+      panel.add(new JLabel("Spill path: "), "wrap");
+      spillPath_ = new JTextField(30);
+      spillPath_.setText(settings.getString("spillPath", getSpillPath()));
+      panel.add(spillPath_, "split 2, span");
+      spillBrowseButton_ = new JButton("...");
+      spillBrowseButton_.addActionListener(new ActionListener() {
+         @Override
+         public void actionPerformed(ActionEvent e) {
+            File path = FileDialogs.openDir(SaverConfigurator.this,
+                     "Please choose a directory for images that can not be saved in time",
+                     FileDialogs.MM_DATA_SET);
+            if (path != null) {
+               spillPath_.setText(path.getAbsolutePath());
+            }
+         }
+      });
+      panel.add(spillBrowseButton_, "wrap");
       super.add(panel);
       updateControls();
 
@@ -115,6 +162,12 @@ public class SaverConfigurator extends JFrame implements ProcessorConfigurator {
       shouldDisplay_.setEnabled(!isRAM);
       savePath_.setEnabled(!isRAM);
       browseButton_.setEnabled(!isRAM);
+      queueMB_.setEnabled(!isRAM);
+      overflowPolicy_.setEnabled(!isRAM);
+      boolean isSpill = !isRAM && overflowPolicy_.getSelectedItem()
+            == AsyncImageWriter.OverflowPolicy.SPILL;
+      spillPath_.setEnabled(isSpill);
+      spillBrowseButton_.setEnabled(isSpill);
    }
 
    @Override
@@ -130,10 +183,19 @@ public class SaverConfigurator extends JFrame implements ProcessorConfigurator {
       setPreferredSaveFormat(format);
       setShouldDisplay(shouldDisplay_.isSelected());
       setSavePath(savePath_.getText());
+      String policy = ((AsyncImageWriter.OverflowPolicy)
+            overflowPolicy_.getSelectedItem()).name();
+      int queueMB = (Integer) queueMB_.getValue();
+      setOverflowPolicy(policy);
+      setQueueMB(queueMB);
+      setSpillPath(spillPath_.getText());
       PropertyMap.Builder builder = PropertyMaps.builder();
       builder.putString("format", format);
       builder.putBoolean("shouldDisplay", shouldDisplay_.isSelected());
       builder.putString("savePath", savePath_.getText());
+      builder.putString("overflowPolicy", policy);
+      builder.putInteger("queueMB", queueMB);
+      builder.putString("spillPath", spillPath_.getText());
       return builder.build();
    }
 
@@ -171,4 +233,34 @@ public class SaverConfigurator extends JFrame implements ProcessorConfigurator {
       studio_.profile().getSettings(SaverConfigurator.class).putString(
             SAVE_PATH, path);
    }
+
+   private String getOverflowPolicy() {
+      return studio_.profile().getSettings(SaverConfigurator.class).getString(
+            OVERFLOW_POLICY, AsyncImageWriter.OverflowPolicy.BLOCK.name());
+   }
+
+   private void setOverflowPolicy(String policy) {
+      studio_.profile().getSettings(SaverConfigurator.class).putString(
+            OVERFLOW_POLICY, policy);
+   }
+
+   private int getQueueMB() {
+      return studio_.profile().getSettings(SaverConfigurator.class).getInteger(
+            QUEUE_MB, SaverPlugin.DEFAULT_QUEUE_MB);
+   }
+
+   private void setQueueMB(int queueMB) {
+      studio_.profile().getSettings(SaverConfigurator.class).putInteger(
+            QUEUE_MB, queueMB);
+   }
+
+   private String getSpillPath() {
+      return studio_.profile().getSettings(SaverConfigurator.class).getString(
+            SPILL_PATH, "");
+   }
+
+   private void setSpillPath(String path) {
+      studio_.profile().getSettings(SaverConfigurator.class).putString(
+            SPILL_PATH, path);
+   }
 }
@@ -39,6 +39,10 @@ public class SaverFactory implements ProcessorFactory {
       return new SaverProcessor(studio_,
             settings_.getString("format", SaverPlugin.MULTIPAGE_TIFF),
             settings_.getString("savePath", null),
-            settings_.getBoolean("shouldDisplay", true));
+            settings_.getBoolean("shouldDisplay", true),
+            AsyncImageWriter.OverflowPolicy.fromName(
+                  settings_.getString("overflowPolicy", null)),
+            settings_.getInteger("queueMB", SaverPlugin.DEFAULT_QUEUE_MB),
+            settings_.getString("spillPath", null));
    }
 }
@@ -38,6 +38,9 @@ public class SaverPlugin implements ProcessorPlugin, SciJavaPlugin {
    public static String SINGLEPLANE_TIFF_SERIES = "Separate Image Files";
    public static String MULTIPAGE_TIFF = "Image Stack File";
    public static String RAM = "RAM only";
+   public static String ND_TIFF = "NDTiff";
+   // Default size of the write queue, in megabytes
+   public static final int DEFAULT_QUEUE_MB = 512;
 
    @Override
    public void setContext(Studio studio) {
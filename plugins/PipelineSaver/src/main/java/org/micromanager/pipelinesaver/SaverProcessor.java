@@ -22,84 +22,239 @@ package org.micromanager.pipelinesaver;
 
 import java.io.File;
 import java.io.IOException;
+import java.util.concurrent.TimeUnit;
+import org.micromanager.PropertyMap;
+import org.micromanager.PropertyMaps;
 import org.micromanager.Studio;
 import org.micromanager.data.Datastore;
 import org.micromanager.data.DatastoreFrozenException;
 import org.micromanager.data.DatastoreRewriteException;
 import org.micromanager.data.Image;
+import org.micromanager.data.Metadata;
 import org.micromanager.data.Processor;
 import org.micromanager.data.ProcessorContext;
 
+/**
+ * Saves the images passing through the pipeline, and passes them on.
+ *
+ * <p>Images are written by an {@link AsyncImageWriter}, so a slow disk only
+ * holds up the pipeline once the write queue is full, and then only with the
+ * BLOCK overflow policy. The state of the writer is added to the user data of
+ * each outgoing image.
+ */
 public class SaverProcessor implements Processor {
+   // User data keys that report the state of the writer downstream
+   public static final String QUEUED_IMAGES_KEY = "PipelineSaver-QueuedImages";
+   public static final String QUEUED_BYTES_KEY = "PipelineSaver-QueuedBytes";
+   public static final String WRITE_MB_PER_S_KEY = "PipelineSaver-WriteMBPerSecond";
+   public static final String DROPPED_IMAGES_KEY = "PipelineSaver-DroppedImages";
+   public static final String SPILLED_IMAGES_KEY = "PipelineSaver-SpilledImages";
+
+   // How long cleanup waits for queued images to be written
+   private static final long CLOSE_TIMEOUT_MINUTES = 10;
+
    private Studio studio_;
-   private Datastore store_;
+   private volatile Datastore store_;
    private final String format_;
    private final String savePath_;
+   private final AsyncImageWriter writer_;
 
    public SaverProcessor(Studio studio, String format, String savePath,
                          boolean shouldDisplay) {
+      this(studio, format, savePath, shouldDisplay,
+            AsyncImageWriter.OverflowPolicy.BLOCK, SaverPlugin.DEFAULT_QUEUE_MB, null);
+   }
+
+   /**
+    * Creates a saver.
+    *
+    * @param studio        Studio instance
+    * @param format        one of the formats defined in SaverPlugin
+    * @param savePath      directory to save to
+    * @param shouldDisplay whether to show the saved data
+    * @param policy        what to do when images arrive faster than they can
+    *                      be written
+    * @param queueMB       size of the write queue, in megabytes
+    * @param spillPath     directory to save images that do not fit in the
+    *                      queue to; only used with the SPILL policy
+    */
+   public SaverProcessor(Studio studio, String format, String savePath,
+                         boolean shouldDisplay, AsyncImageWriter.OverflowPolicy policy,
+                         int queueMB, String spillPath) {
       studio_ = studio;
       format_ = format;
       // Update save path to account for duplicates -- append a numerical
       // suffix that's max of all suffices + 1.
       savePath_ = findUniqueSavePath(savePath);
+      store_ = createStore(savePath_);
+
+      studio_.displays().manage(store_);
+
+      if (shouldDisplay) {
+         studio_.displays().createDisplay(store_);
+      }
+
+      if (format_.equals(SaverPlugin.RAM) || spillPath == null || spillPath.isEmpty()) {
+         // There is no second disk to spill to
+         if (policy == AsyncImageWriter.OverflowPolicy.SPILL) {
+            policy = AsyncImageWriter.OverflowPolicy.BLOCK;
+         }
+      }
+      AsyncImageWriter.Sink spill = null;
+      if (policy == AsyncImageWriter.OverflowPolicy.SPILL) {
+         spill = new SpillSink(spillPath);
+      }
+      writer_ = new AsyncImageWriter("Pipeline saver " + savePath_, new StoreSink(),
+            Math.max(1, queueMB) * 1024L * 1024L, policy, spill);
+   }
+
+   private Datastore createStore(String path) {
       try {
-         if (format.equals(SaverPlugin.MULTIPAGE_TIFF)) {
+         if (format_.equals(SaverPlugin.MULTIPAGE_TIFF)) {
             // TODO: hardcoded whether or not to split positions.
-            store_ = studio_.data().createMultipageTIFFDatastore(savePath_,
+            return studio_.data().createMultipageTIFFDatastore(path,
                   true, true);
-         } else if (format.equals(SaverPlugin.SINGLEPLANE_TIFF_SERIES)) {
-            store_ = studio.data().createSinglePlaneTIFFSeriesDatastore(savePath_);
-         } else if (format.equals(SaverPlugin.RAM)) {
-            store_ = studio.data().createRewritableRAMDatastore();
+         } else if (format_.equals(SaverPlugin.SINGLEPLANE_TIFF_SERIES)) {
+            return studio_.data().createSinglePlaneTIFFSeriesDatastore(path);
+         } else if (format_.equals(SaverPlugin.ND_TIFF)) {
+            return studio_.data().createNDTIFFDatastore(path);
+         } else if (format_.equals(SaverPlugin.RAM)) {
+            return studio_.data().createRewritableRAMDatastore();
          } else {
-            studio_.logs().logError("Unrecognized save format " + format);
+            studio_.logs().logError("Unrecognized save format " + format_);
          }
       } catch (IOException e) {
-         studio_.logs().showError(e, "Error creating datastore at " + savePath_);
+         studio_.logs().showError(e, "Error creating datastore at " + path);
       }
+      return null;
+   }
 
-      studio_.displays().manage(store_);
+   /**
+    * Writes to the main datastore, on the writer thread.
+    */
+   private class StoreSink implements AsyncImageWriter.Sink {
+      @Override
+      public void putImage(Image image) throws IOException {
+         try {
+            store_.putImage(image);
+         } catch (DatastoreFrozenException e) {
+            // Weird that we can not query the store if it is frozen but have to rely
+            // on an exception...
+            if (!format_.equals(SaverPlugin.RAM)) {
+               throw e;
+            }
+            Datastore store = studio_.data().createRewritableRAMDatastore();
+            studio_.displays().manage(store);
+            studio_.displays().createDisplay(store);
+            store_ = store;
+            store.putImage(image);
+         }
+      }
 
-      if (shouldDisplay) {
-         studio_.displays().createDisplay(store_);
+      @Override
+      public void close() throws IOException {
+         store_.freeze();
+      }
+   }
+
+   /**
+    * Writes the images that did not fit in the queue to a second datastore,
+    * which is only created when the first such image arrives.
+    */
+   private class SpillSink implements AsyncImageWriter.Sink {
+      private final String path_;
+      private Datastore spillStore_;
+      private String uniquePath_;
+
+      SpillSink(String path) {
+         path_ = path;
+      }
+
+      @Override
+      public void putImage(Image image) throws IOException {
+         if (spillStore_ == null) {
+            uniquePath_ = findUniqueSavePath(
+                  new File(path_, new File(savePath_).getName()).getPath());
+            spillStore_ = createStore(uniquePath_);
+            if (spillStore_ == null) {
+               throw new IOException("Unable to create spill datastore at " + uniquePath_);
+            }
+            studio_.logs().logMessage("Saving images that can not be written in time to "
+                  + uniquePath_);
+         }
+         spillStore_.putImage(image);
+      }
+
+      @Override
+      public void close() throws IOException {
+         if (spillStore_ != null) {
+            spillStore_.freeze();
+            spillStore_.setSavePath(uniquePath_);
+            spillStore_.close();
+         }
       }
    }
 
    @Override
    public void processImage(Image image, ProcessorContext context) {
       try {
-         store_.putImage(image);
-      } catch (DatastoreFrozenException e) {
-         // Weird that we can not query the store if it is frozen but have to rely
-         // on an exception...
-         if (format_.equals(SaverPlugin.RAM)) {
-            store_ = studio_.data().createRewritableRAMDatastore();
-            studio_.displays().manage(store_);
-            studio_.displays().createDisplay(store_);
-            try {
-               store_.putImage(image);
-            } catch (IOException ioe) {
-               studio_.logs().logError(ioe, "Unable to show Data: IoException");
-            }
-         } else {
-            studio_.logs().logError(e, "Unable to save data: datastore is frozen");
-         }
-      } catch (DatastoreRewriteException e) {
-         studio_.logs()
-               .logError(e, "Unable to save data: image already exists at " + image.getCoords());
-      } catch (IOException e) {
-         studio_.logs().logError(e, "Unable to save data: IOException");
+         writer_.putImage(image);
+      } catch (InterruptedException e) {
+         Thread.currentThread().interrupt();
+         studio_.logs().logError(e, "Interrupted while waiting to save image at "
+               + image.getCoords());
+      }
+      logWriteError();
+      context.outputImage(annotate(image, writer_.getStatistics()));
+   }
+
+   private void logWriteError() {
+      Exception error = writer_.takeLastError();
+      if (error instanceof DatastoreRewriteException) {
+         studio_.logs().logError(error, "Unable to save data: image already exists");
+      } else if (error instanceof DatastoreFrozenException) {
+         studio_.logs().logError(error, "Unable to save data: datastore is frozen");
+      } else if (error != null) {
+         studio_.logs().logError(error, "Unable to save data");
       }
-      context.outputImage(image);
+   }
+
+   /**
+    * Adds the state of the writer to the user data of an image.
+    */
+   private static Image annotate(Image image, AsyncImageWriter.Statistics stats) {
+      PropertyMap userData = image.getMetadata().getUserData();
+      PropertyMap.Builder builder = userData != null
+            ? userData.copyBuilder() : PropertyMaps.builder();
+      builder.putInteger(QUEUED_IMAGES_KEY, stats.getQueuedImages());
+      builder.putLong(QUEUED_BYTES_KEY, stats.getQueuedBytes());
+      builder.putDouble(WRITE_MB_PER_S_KEY, stats.getWriteBytesPerSecond() / 1e6);
+      builder.putLong(DROPPED_IMAGES_KEY, stats.getDroppedImages());
+      builder.putLong(SPILLED_IMAGES_KEY, stats.getSpilledImages());
+      Metadata metadata = image.getMetadata().copyBuilderPreservingUUID()
+            .userData(builder.build()).build();
+      return image.copyWithMetadata(metadata);
    }
 
    @Override
    public void cleanup(ProcessorContext context) {
+      // Wait for all queued images to be written; this also freezes the store
       try {
-         store_.freeze();
-      } catch (IOException ioe) {
-         studio_.logs().logError(ioe, "SaverProcessor ran into trouble");
+         if (!writer_.close(CLOSE_TIMEOUT_MINUTES, TimeUnit.MINUTES)) {
+            studio_.logs().logError("Pipeline saver did not finish writing to "
+                  + savePath_ + " within " + CLOSE_TIMEOUT_MINUTES + " minutes");
+         }
+      } catch (InterruptedException e) {
+         Thread.currentThread().interrupt();
+         studio_.logs().logError(e, "Interrupted while finishing saving to " + savePath_);
+      }
+      logWriteError();
+      AsyncImageWriter.Statistics stats = writer_.getStatistics();
+      if (stats.getDroppedImages() > 0 || stats.getFailedImages() > 0) {
+         studio_.logs().logError("Pipeline saver could not save "
+               + stats.getDroppedImages() + " image(s) (" + stats.getDroppedBytes()
+               + " bytes) in time, and failed to save " + stats.getFailedImages()
+               + " image(s)");
       }
       if (!format_.equals(SaverPlugin.RAM)) {
          store_.setSavePath(savePath_);
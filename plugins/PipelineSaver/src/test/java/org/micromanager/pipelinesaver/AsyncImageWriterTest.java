@@ -0,0 +1,259 @@
+package org.micromanager.pipelinesaver;
+
+import java.io.ByteArrayOutputStream;
+import java.io.FilterOutputStream;
+import java.io.IOException;
+import java.io.OutputStream;
+import java.util.ArrayList;
+import java.util.List;
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.TimeUnit;
+import org.junit.Assert;
+import org.junit.Test;
+import org.micromanager.data.Coordinates;
+import org.micromanager.data.Image;
+import org.micromanager.data.internal.DefaultImage;
+
+public class AsyncImageWriterTest {
+   private static final int WIDTH = 128;
+   private static final int HEIGHT = 128;
+   private static final long IMAGE_BYTES = WIDTH * HEIGHT * 2;
+
+   /**
+    * Output stream that writes no faster than a given bandwidth.
+    */
+   private static final class ThrottledOutputStream extends FilterOutputStream {
+      private final long nanosPerByte_;
+
+      ThrottledOutputStream(OutputStream out, long bytesPerSecond) {
+         super(out);
+         nanosPerByte_ = 1000000000L / bytesPerSecond;
+      }
+
+      @Override
+      public void write(byte[] b, int off, int len) throws IOException {
+         long end = System.nanoTime() + len * nanosPerByte_;
+         while (System.nanoTime() < end) {
+            try {
+               Thread.sleep(1);
+            } catch (InterruptedException e) {
+               throw new IOException(e);
+            }
+         }
+         out.write(b, off, len);
+      }
+   }
+
+   /**
+    * Writes the raw pixels of each image to a stream, and remembers the
+    * order of the images.
+    */
+   private static final class StreamSink implements AsyncImageWriter.Sink {
+      private final OutputStream out_;
+      private final List<Integer> written_ = new ArrayList<>();
+      private volatile boolean closed_ = false;
+
+      StreamSink(OutputStream out) {
+         out_ = out;
+      }
+
+      @Override
+      public void putImage(Image image) throws IOException {
+         out_.write(image.getByteArray());
+         synchronized (written_) {
+            written_.add(image.getCoords().getT());
+         }
+      }
+
+      @Override
+      public void close() throws IOException {
+         out_.close();
+         closed_ = true;
+      }
+
+      List<Integer> getWritten() {
+         synchronized (written_) {
+            return new ArrayList<>(written_);
+         }
+      }
+   }
+
+   /**
+    * Sink that holds up the first write until released, like a disk that
+    * stalls.
+    */
+   private static final class StalledSink implements AsyncImageWriter.Sink {
+      private final StreamSink sink_ = new StreamSink(new ByteArrayOutputStream());
+      private final CountDownLatch writing_ = new CountDownLatch(1);
+      private final CountDownLatch release_ = new CountDownLatch(1);
+
+      @Override
+      public void putImage(Image image) throws IOException {
+         writing_.countDown();
+         try {
+            release_.await();
+         } catch (InterruptedException e) {
+            throw new IOException(e);
+         }
+         sink_.putImage(image);
+      }
+
+      @Override
+      public void close() throws IOException {
+         sink_.close();
+      }
+
+      void awaitWriting() throws InterruptedException {
+         Assert.assertTrue(writing_.await(10, TimeUnit.SECONDS));
+      }
+
+      void release() {
+         release_.countDown();
+      }
+   }
+
+   private static Image createImage(int t) {
+      return new DefaultImage(new short[WIDTH * HEIGHT], WIDTH, HEIGHT, 2, 1,
+            Coordinates.builder().t(t).build(), null);
+   }
+
+   /**
+    * With the BLOCK policy every image is written, in order, while the queue
+    * never holds more than its budget.
+    */
+   @Test
+   public void blockingWritesAllImagesInOrder() throws Exception {
+      ByteArrayOutputStream bytes = new ByteArrayOutputStream();
+      // 20 images per second
+      StreamSink sink = new StreamSink(
+            new ThrottledOutputStream(bytes, 20 * IMAGE_BYTES));
+      final long budget = 4 * IMAGE_BYTES;
+      AsyncImageWriter writer = new AsyncImageWriter("test", sink, budget,
+            AsyncImageWriter.OverflowPolicy.BLOCK, null);
+      final int nrImages = 20;
+      for (int t = 0; t < nrImages; t++) {
+         Assert.assertTrue(writer.putImage(createImage(t)));
+         Assert.assertTrue(writer.getStatistics().getQueuedBytes() <= budget);
+      }
+      Assert.assertTrue(writer.close(30, TimeUnit.SECONDS));
+      Assert.assertTrue(sink.closed_);
+      List<Integer> written = sink.getWritten();
+      Assert.assertEquals(nrImages, written.size());
+      for (int t = 0; t < nrImages; t++) {
+         Assert.assertEquals(t, (int) written.get(t));
+      }
+      Assert.assertEquals(nrImages * IMAGE_BYTES, bytes.size());
+      AsyncImageWriter.Statistics stats = writer.getStatistics();
+      Assert.assertEquals(nrImages, stats.getWrittenImages());
+      Assert.assertEquals(0, stats.getQueuedImages());
+      Assert.assertTrue(stats.getWriteBytesPerSecond() > 0);
+      Assert.assertTrue(stats.getWriteBytesPerSecond() < 40 * IMAGE_BYTES);
+   }
+
+   /**
+    * A disk stall does not hold up the caller while the queue has room.
+    * Were the caller held up, the test would time out.
+    */
+   @Test(timeout = 30000)
+   public void stallIsAbsorbedByQueue() throws Exception {
+      StalledSink sink = new StalledSink();
+      AsyncImageWriter writer = new AsyncImageWriter("test", sink, 50 * IMAGE_BYTES,
+            AsyncImageWriter.OverflowPolicy.BLOCK, null);
+      for (int t = 0; t < 20; t++) {
+         Assert.assertTrue(writer.putImage(createImage(t)));
+      }
+      sink.awaitWriting();
+      // The caller returned while the first image is still being written
+      AsyncImageWriter.Statistics stats = writer.getStatistics();
+      Assert.assertEquals(0, stats.getWrittenImages());
+      Assert.assertEquals(20, stats.getQueuedImages());
+      sink.release();
+      Assert.assertTrue(writer.close(30, TimeUnit.SECONDS));
+      Assert.assertEquals(20, sink.sink_.getWritten().size());
+   }
+
+   /**
+    * With the DROP policy the caller never waits, and every image is
+    * either written or counted as dropped.
+    */
+   @Test(timeout = 30000)
+   public void droppingAccountsForEveryImage() throws Exception {
+      StalledSink sink = new StalledSink();
+      AsyncImageWriter writer = new AsyncImageWriter("test", sink, 2 * IMAGE_BYTES,
+            AsyncImageWriter.OverflowPolicy.DROP, null);
+      final int nrImages = 100;
+      Assert.assertTrue(writer.putImage(createImage(0)));
+      sink.awaitWriting();
+      int accepted = 1;
+      // The queue is full while the writer is stalled, so this does not wait
+      for (int t = 1; t < nrImages; t++) {
+         if (writer.putImage(createImage(t))) {
+            accepted++;
+         }
+      }
+      AsyncImageWriter.Statistics stats = writer.getStatistics();
+      Assert.assertEquals(0, stats.getWrittenImages());
+      Assert.assertEquals(accepted, stats.getQueuedImages());
+      Assert.assertEquals(nrImages - accepted, stats.getDroppedImages());
+      sink.release();
+      Assert.assertTrue(writer.close(30, TimeUnit.SECONDS));
+      stats = writer.getStatistics();
+      Assert.assertTrue(stats.getDroppedImages() > 0);
+      Assert.assertEquals(nrImages - accepted, stats.getDroppedImages());
+      Assert.assertEquals(stats.getDroppedImages() * IMAGE_BYTES, stats.getDroppedBytes());
+      Assert.assertEquals(accepted, stats.getWrittenImages());
+      Assert.assertEquals(accepted, sink.sink_.getWritten().size());
+   }
+
+   /**
+    * With the SPILL policy, images that do not fit go to the second sink,
+    * and between the two every image is written.
+    */
+   @Test
+   public void spillingWritesEveryImageSomewhere() throws Exception {
+      StreamSink sink = new StreamSink(new ThrottledOutputStream(
+            new ByteArrayOutputStream(), 20 * IMAGE_BYTES));
+      StreamSink spill = new StreamSink(new ByteArrayOutputStream());
+      AsyncImageWriter writer = new AsyncImageWriter("test", sink, 2 * IMAGE_BYTES,
+            AsyncImageWriter.OverflowPolicy.SPILL, spill);
+      final int nrImages = 50;
+      for (int t = 0; t < nrImages; t++) {
+         Assert.assertTrue(writer.putImage(createImage(t)));
+      }
+      Assert.assertTrue(writer.close(30, TimeUnit.SECONDS));
+      Assert.assertTrue(spill.closed_);
+      AsyncImageWriter.Statistics stats = writer.getStatistics();
+      Assert.assertTrue(stats.getSpilledImages() > 0);
+      Assert.assertEquals(stats.getSpilledImages(), spill.getWritten().size());
+      Assert.assertEquals(nrImages, sink.getWritten().size() + spill.getWritten().size());
+      Assert.assertEquals(nrImages, stats.getWrittenImages());
+   }
+
+   /**
+    * Write errors are counted and reported, and do not stop the writer.
+    */
+   @Test
+   public void failuresAreReported() throws Exception {
+      AsyncImageWriter writer = new AsyncImageWriter("test", new AsyncImageWriter.Sink() {
+         @Override
+         public void putImage(Image image) throws IOException {
+            if (image.getCoords().getT() % 2 == 0) {
+               throw new IOException("Disk full");
+            }
+         }
+
+         @Override
+         public void close() {
+         }
+      }, 10 * IMAGE_BYTES, AsyncImageWriter.OverflowPolicy.BLOCK, null);
+      for (int t = 0; t < 10; t++) {
+         writer.putImage(createImage(t));
+      }
+      writer.flush();
+      Assert.assertEquals(5, writer.getStatistics().getFailedImages());
+      Assert.assertEquals(5, writer.getStatistics().getWrittenImages());
+      Assert.assertTrue(writer.takeLastError() instanceof IOException);
+      Assert.assertNull(writer.takeLastError());
+      Assert.assertTrue(writer.close(30, TimeUnit.SECONDS));
+   }
+}
@@ -23,18 +23,26 @@ package org.micromanager.sharpnessinspector;
 
 import ij.process.ImageProcessor;
 import java.awt.Rectangle;
+import java.util.EnumMap;
+import java.util.EnumSet;
+import java.util.Set;
 import org.micromanager.data.Image;
 import org.micromanager.imageprocessing.ImgSharpnessAnalysis;
+import org.micromanager.imageprocessing.SharpnessMetrics;
 import org.micromanager.internal.MMStudio;
 
 /**
+ * Evaluates the sharpness of images.
+ *
+ * <p>Methods that SharpnessMetrics implements are computed directly on the
+ * pixel buffer of the image; the others go through an ImageJ processor.
  *
  * @author Nick Anthony
  */
 public class SharpnessEvaluator {
    private final ImgSharpnessAnalysis anl = new ImgSharpnessAnalysis();
    // In my experience Redondo works much better than other methods.
-   private ImgSharpnessAnalysis.Method method_ = ImgSharpnessAnalysis.Method.Redondo;
+   private volatile ImgSharpnessAnalysis.Method method_ = ImgSharpnessAnalysis.Method.Redondo;
 
    public void setMethod(ImgSharpnessAnalysis.Method method) {
       method_ = method;
@@ -46,11 +54,48 @@ public class SharpnessEvaluator {
    }
     
    public double evaluate(Image img, Rectangle r) {
+      SharpnessMetrics.Metric metric = SharpnessMetrics.Metric.forMethod(method_);
+      if (metric != null && img.getNumComponents() == 1) {
+         return evaluate(img, r, EnumSet.of(metric)).get(metric);
+      }
       ImageProcessor proc = MMStudio.getInstance().data().getImageJConverter().createProcessor(img);
       proc.setRoi(r);
       proc = proc.crop();
       return anl.compute(proc);
    }
+
+   /**
+    * Computes several metrics in a single pass over the pixels.
+    *
+    * @param img grayscale image
+    * @param r region to evaluate, or null for the whole image
+    * @param metrics metrics to compute
+    * @return the value of each metric
+    */
+   public EnumMap<SharpnessMetrics.Metric, Double> evaluate(Image img, Rectangle r,
+         Set<SharpnessMetrics.Metric> metrics) {
+      return SharpnessMetrics.compute(img.getRawPixels(), img.getWidth(), img.getHeight(),
+            r, metrics, anl.getFFTLowerCutoff(), anl.getFFTUpperCutoff());
+   }
+
+   /**
+    * Returns the metric used for heat maps: the current method when
+    * SharpnessMetrics implements it, and Brenner otherwise.
+    */
+   public SharpnessMetrics.Metric getHeatMapMetric() {
+      SharpnessMetrics.Metric metric = SharpnessMetrics.Metric.forMethod(method_);
+      return metric == null ? SharpnessMetrics.Metric.Brenner : metric;
+   }
+
+   /**
+    * Computes the sharpness of each tile of a grayscale image.
+    *
+    * @see SharpnessMetrics#heatMap
+    */
+   public double[] evaluateHeatMap(Image img, int tileSize) {
+      return SharpnessMetrics.heatMap(img.getRawPixels(), img.getWidth(), img.getHeight(),
+            tileSize, getHeatMapMetric());
+   }
     
    /* Before using the ImgSharpnessAnalysis we used to do it ourselves here
     private double evaluateGradient(Image img, Rectangle r) {
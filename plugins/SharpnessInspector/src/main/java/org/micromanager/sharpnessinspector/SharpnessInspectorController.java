@@ -26,12 +26,17 @@ import com.google.common.eventbus.Subscribe;
 import ij.gui.Roi;
 import java.awt.Rectangle;
 import java.awt.event.ActionEvent;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.LinkedBlockingQueue;
+import java.util.concurrent.ThreadPoolExecutor;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicReference;
 import javax.swing.JPanel;
+import javax.swing.SwingUtilities;
 import javax.swing.SwingWorker;
 import org.micromanager.Studio;
 import org.micromanager.data.DataProviderHasNewImageEvent;
 import org.micromanager.data.Image;
-import org.micromanager.data.internal.DefaultImage;
 import org.micromanager.display.DataViewer;
 import org.micromanager.display.DisplayWindow;
 import org.micromanager.display.inspector.AbstractInspectorPanelController;
@@ -39,6 +44,8 @@ import org.micromanager.display.inspector.internal.panels.intensity.ImageStatsPu
 import org.micromanager.events.StagePositionChangedEvent;
 import org.micromanager.imageprocessing.ImgSharpnessAnalysis;
 import org.micromanager.internal.utils.MustCallOnEDT;
+import org.micromanager.imageprocessing.SharpnessMetrics;
+import org.micromanager.sharpnessinspector.ui.SharpnessHeatMapOverlay;
 import org.micromanager.sharpnessinspector.ui.SharpnessInspectorPanel;
 
 /**
@@ -54,6 +61,31 @@ public class SharpnessInspectorController extends AbstractInspectorPanelControll
    private final Studio studio_;
    private boolean autoImageEvaluation_ = false;
    private final SharpnessEvaluator eval_ = new SharpnessEvaluator();
+   private static final int HEAT_MAP_TILE_SIZE = 64;
+   private final SharpnessHeatMapOverlay heatMapOverlay_ = new SharpnessHeatMapOverlay();
+   private volatile boolean heatMap_ = false;
+   // Images are evaluated in the background, one at a time. Images that
+   // arrive while one is being evaluated replace each other, so that only
+   // the latest one is evaluated next.
+   private final AtomicReference<Evaluation> pending_ = new AtomicReference<>();
+   private final ExecutorService evaluator_ = new ThreadPoolExecutor(0, 1,
+         10, TimeUnit.SECONDS, new LinkedBlockingQueue<>(), (r) -> {
+            Thread thread = new Thread(r, "Sharpness evaluation");
+            thread.setDaemon(true);
+            return thread;
+         });
+
+   private static final class Evaluation {
+      private final Image image_;
+      private final Rectangle roi_;
+      private final boolean heatMap_;
+
+      Evaluation(Image image, Rectangle roi, boolean heatMap) {
+         image_ = image;
+         roi_ = roi;
+         heatMap_ = heatMap;
+      }
+   }
     
    private SharpnessInspectorController(Studio studio) {
       studio_ = studio;
@@ -65,6 +97,10 @@ public class SharpnessInspectorController extends AbstractInspectorPanelControll
          eval_.setMethod((ImgSharpnessAnalysis.Method) evt.getNewValue());
       });
         
+      panel_.addPropertyChangeListener("heatMap", (evt) -> {
+         setHeatMapVisible((Boolean) evt.getNewValue());
+      });
+
       panel_.addScanRequestedListener((evt) -> {
          SwingWorker worker = new SwingWorker() {
                @Override
@@ -103,6 +139,9 @@ public class SharpnessInspectorController extends AbstractInspectorPanelControll
       viewer_ = viewer;
       viewer.registerForEvents(this);
       viewer.getDataProvider().registerForEvents(this);
+      if (heatMap_ && viewer_ instanceof DisplayWindow) {
+         ((DisplayWindow) viewer_).addOverlay(heatMapOverlay_);
+      }
    }
 
    @Override
@@ -113,9 +152,26 @@ public class SharpnessInspectorController extends AbstractInspectorPanelControll
       }
       viewer_.getDataProvider().unregisterForEvents(this);
       viewer_.unregisterForEvents(this);
+      if (viewer_ instanceof DisplayWindow) {
+         ((DisplayWindow) viewer_).removeOverlay(heatMapOverlay_);
+      }
+      heatMapOverlay_.clear();
       viewer_ = null;
    }
 
+   @MustCallOnEDT
+   private void setHeatMapVisible(boolean visible) {
+      heatMap_ = visible;
+      if (viewer_ instanceof DisplayWindow) {
+         if (visible) {
+            ((DisplayWindow) viewer_).addOverlay(heatMapOverlay_);
+         } else {
+            ((DisplayWindow) viewer_).removeOverlay(heatMapOverlay_);
+            heatMapOverlay_.clear();
+         }
+      }
+   }
+
    @Override
    public boolean isVerticallyResizableByUser() {
       return true;
@@ -140,7 +196,7 @@ public class SharpnessInspectorController extends AbstractInspectorPanelControll
       if (!this.autoImageEvaluation_) {
          return;
       }
-      final DefaultImage img = (DefaultImage) evt.getImage();
+      final Image img = evt.getImage();
       Roi roi;
       try {
          roi = ((DisplayWindow) viewer_).getImagePlus().getRoi();
@@ -149,18 +205,53 @@ public class SharpnessInspectorController extends AbstractInspectorPanelControll
       } catch (RuntimeException rte) {
          return;
       }
+      Rectangle r = null;
       if (roi == null || !roi.isArea()) {
          this.panel_.setRoiSelected(false);
+      } else {
+         this.panel_.setRoiSelected(true);
+         r = roi.getBounds();
+         if (r.width < 5 || r.height < 5) {
+            //Rectangle must be larger than the kernel used to calculate gradient which is 1x3
+            r = null;
+         }
+      }
+      final boolean heatMap = heatMap_ && img.getNumComponents() == 1;
+      if (r == null && !heatMap) {
          return;
       }
-      this.panel_.setRoiSelected(true);
-      Rectangle r = roi.getBounds();
-      if (r.width < 5 || r.height < 5) {
-         return; //Rectangle must be larger than the kernel used to calculate gradient which is 1x3
+      if (pending_.getAndSet(new Evaluation(img, r, heatMap)) == null) {
+         evaluator_.submit(this::evaluatePending);
+      }
+   }
+
+   private void evaluatePending() {
+      Evaluation evaluation = pending_.getAndSet(null);
+      if (evaluation == null) {
+         return;
+      }
+      final Image img = evaluation.image_;
+      try {
+         if (evaluation.roi_ != null) {
+            final double grad = eval_.evaluate(img, evaluation.roi_);
+            final double z = img.getMetadata().getZPositionUm();
+            final long time = System.currentTimeMillis();
+            SwingUtilities.invokeLater(() -> panel_.setValue(z, time, grad));
+         }
+         if (evaluation.heatMap_ && heatMap_) {
+            final double[] values = eval_.evaluateHeatMap(img, HEAT_MAP_TILE_SIZE);
+            final int columns = SharpnessMetrics.heatMapColumns(img.getWidth(),
+                  HEAT_MAP_TILE_SIZE);
+            final int rows = SharpnessMetrics.heatMapRows(img.getHeight(), HEAT_MAP_TILE_SIZE);
+            SwingUtilities.invokeLater(() -> {
+               if (heatMap_) {
+                  heatMapOverlay_.setHeatMap(values, columns, rows, HEAT_MAP_TILE_SIZE);
+               }
+            });
+         }
+      } catch (RuntimeException e) {
+         studio_.logs().logError(e, "Failed to evaluate image sharpness");
       }
-      double grad = eval_.evaluate(img, r);
-      double z = img.getMetadata().getZPositionUm();
-      this.panel_.setValue(z, System.currentTimeMillis(), grad);
    }
 
    //TODO Many z stages don't fire this. use polling instead
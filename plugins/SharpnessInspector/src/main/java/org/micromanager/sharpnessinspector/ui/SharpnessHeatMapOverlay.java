@@ -0,0 +1,129 @@
+///////////////////////////////////////////////////////////////////////////////
+//PROJECT:       Micro-Manager
+//SUBSYSTEM:     mmstudio
+//-----------------------------------------------------------------------------
+//
+// COPYRIGHT:    University of California, San Francisco, 2024
+//
+// LICENSE:      This file is distributed under the BSD license.
+//               License text is included with the source distribution.
+//
+//               This file is distributed in the hope that it will be useful,
+//               but WITHOUT ANY WARRANTY; without even the implied warranty
+//               of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//
+//               IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//               CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//               INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+//
+
+
+package org.micromanager.sharpnessinspector.ui;
+
+import java.awt.Color;
+import java.awt.Graphics2D;
+import java.awt.Rectangle;
+import java.awt.geom.Rectangle2D;
+import java.util.List;
+import org.micromanager.data.Image;
+import org.micromanager.display.DisplaySettings;
+import org.micromanager.display.overlay.AbstractOverlay;
+
+/**
+ * Shades the image according to the sharpness of each tile, from blue (least
+ * sharp tile in the image) to red (sharpest tile).
+ */
+public final class SharpnessHeatMapOverlay extends AbstractOverlay {
+   private static final int ALPHA = 90;
+
+   /**
+    * Immutable heat map values, so that painting never sees a partial update.
+    */
+   private static final class HeatMap {
+      private final double[] values_;
+      private final int columns_;
+      private final int rows_;
+      private final int tileSize_;
+      private final double min_;
+      private final double max_;
+
+      HeatMap(double[] values, int columns, int rows, int tileSize) {
+         values_ = values;
+         columns_ = columns;
+         rows_ = rows;
+         tileSize_ = tileSize;
+         double min = Double.POSITIVE_INFINITY;
+         double max = Double.NEGATIVE_INFINITY;
+         for (double v : values) {
+            min = Math.min(min, v);
+            max = Math.max(max, v);
+         }
+         min_ = min;
+         max_ = max;
+      }
+   }
+
+   private volatile HeatMap heatMap_;
+
+   @Override
+   public String getTitle() {
+      return "Sharpness Heat Map";
+   }
+
+   /**
+    * Sets the values to show.
+    *
+    * @param values sharpness of each tile, row by row
+    * @param columns number of tiles in a row
+    * @param rows number of rows of tiles
+    * @param tileSize edge length of the tiles, in image pixels
+    */
+   public void setHeatMap(double[] values, int columns, int rows, int tileSize) {
+      heatMap_ = new HeatMap(values.clone(), columns, rows, tileSize);
+      fireOverlayConfigurationChanged();
+   }
+
+   public void clear() {
+      heatMap_ = null;
+      fireOverlayConfigurationChanged();
+   }
+
+   @Override
+   public void paintOverlay(Graphics2D g, Rectangle screenRect,
+                            DisplaySettings displaySettings,
+                            List<Image> images, Image primaryImage,
+                            Rectangle2D.Float imageViewPort) {
+      final HeatMap map = heatMap_;
+      if (map == null || map.values_.length == 0) {
+         return;
+      }
+      final double zoom = screenRect.width / imageViewPort.width;
+      final double range = map.max_ > map.min_ ? map.max_ - map.min_ : 1.0;
+      Graphics2D g2 = (Graphics2D) g.create();
+      for (int row = 0; row < map.rows_; row++) {
+         for (int col = 0; col < map.columns_; col++) {
+            float f = (float) ((map.values_[row * map.columns_ + col] - map.min_) / range);
+            // Hue from blue (2/3) to red (0)
+            Color c = Color.getHSBColor((1.0f - f) * 2.0f / 3.0f, 1.0f, 1.0f);
+            g2.setColor(new Color(c.getRed(), c.getGreen(), c.getBlue(), ALPHA));
+            double x = (col * map.tileSize_ - imageViewPort.x) * zoom;
+            double y = (row * map.tileSize_ - imageViewPort.y) * zoom;
+            // Tiles at the right and bottom edges may be cut off by the image
+            double width = map.tileSize_;
+            double height = map.tileSize_;
+            if (primaryImage != null) {
+               width = Math.min(width, primaryImage.getWidth() - col * map.tileSize_);
+               height = Math.min(height, primaryImage.getHeight() - row * map.tileSize_);
+            }
+            width *= zoom;
+            height *= zoom;
+            if (x + width < 0 || y + height < 0 || x > screenRect.width
+                  || y > screenRect.height) {
+               continue;
+            }
+            g2.fill(new Rectangle2D.Double(x, y, width, height));
+         }
+      }
+      g2.dispose();
+   }
+}
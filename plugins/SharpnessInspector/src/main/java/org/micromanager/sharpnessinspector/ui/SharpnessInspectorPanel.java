@@ -29,6 +29,7 @@ import java.util.ArrayList;
 import java.util.List;
 import javax.swing.DefaultComboBoxModel;
 import javax.swing.JButton;
+import javax.swing.JCheckBox;
 import javax.swing.JComboBox;
 import javax.swing.JDialog;
 import javax.swing.JFormattedTextField;
@@ -97,6 +98,7 @@ public class SharpnessInspectorPanel extends JPanel {
         
    private final JButton resetButton = new JButton("Reset Plot");
    private final JButton scanButton = new JButton("Scan...");
+   private final JCheckBox heatMapBox = new JCheckBox("Heat map");
 
    private final List<SharpnessInspectorController.RequestScanListener> scanRequestedListeners
            = new ArrayList<>();
@@ -166,6 +168,11 @@ public class SharpnessInspectorPanel extends JPanel {
                  (ImgSharpnessAnalysis.Method) evaluationMode.getSelectedItem());
       });
         
+      heatMapBox.setToolTipText("Show the sharpness of each part of the image");
+      heatMapBox.addActionListener((evt) -> {
+         this.pcs.firePropertyChange("heatMap", null, heatMapBox.isSelected());
+      });
+
       JButton infoButton = new JButton("?");
       infoButton.addActionListener((evt) -> {
          JOptionPane.showMessageDialog(infoButton,
@@ -182,6 +189,7 @@ public class SharpnessInspectorPanel extends JPanel {
       super.add(plotModeBox, "wrap");
       super.add(new JLabel("Method:"));
       super.add(evaluationMode);
+      super.add(heatMapBox);
       super.add(infoButton);
    }
 
@@ -43,40 +43,94 @@ import org.micromanager.plugins.snaponmove.MonitoredValue.MonitoredXYValue;
  *
  * <p>Instances specify the item to be monitored and when to consider its value
  * to have changed.
+ *
+ * <p>A value is considered changed once its distance from the reference
+ * value reaches the threshold, and stays changed until the distance falls
+ * below the threshold reduced by the hysteresis (a fraction of the
+ * threshold). This keeps a stage that jitters around the threshold from
+ * toggling between changed and unchanged.
  */
 abstract class ChangeCriterion {
+   static final double DEFAULT_HYSTERESIS = 0.5;
+
    private final boolean requiresPolling_;
+   private final double hysteresis_;
 
-   protected ChangeCriterion(boolean requiresPolling) {
+   protected ChangeCriterion(boolean requiresPolling, double hysteresis) {
       requiresPolling_ = requiresPolling;
+      hysteresis_ = Math.max(0.0, Math.min(1.0, hysteresis));
    }
 
    static ChangeCriterion createZDistanceCriterion(String stageLabel, double threshold,
                                                    boolean requiresPolling) {
-      return new ZDistanceCriterion(stageLabel, threshold, requiresPolling);
+      return createZDistanceCriterion(stageLabel, threshold, requiresPolling,
+            DEFAULT_HYSTERESIS);
+   }
+
+   static ChangeCriterion createZDistanceCriterion(String stageLabel, double threshold,
+                                                   boolean requiresPolling, double hysteresis) {
+      return new ZDistanceCriterion(stageLabel, threshold, requiresPolling, hysteresis);
    }
 
    static ChangeCriterion createXYDistanceCriterion(String stageLabel, double threshold,
                                                     boolean requiresPolling) {
-      return new XYDistanceCriterion(stageLabel, threshold, requiresPolling);
+      return createXYDistanceCriterion(stageLabel, threshold, requiresPolling,
+            DEFAULT_HYSTERESIS);
+   }
+
+   static ChangeCriterion createXYDistanceCriterion(String stageLabel, double threshold,
+                                                    boolean requiresPolling, double hysteresis) {
+      return new XYDistanceCriterion(stageLabel, threshold, requiresPolling, hysteresis);
    }
 
+   /**
+    * Whether the item must always be polled. Otherwise, it is polled only
+    * until its device is found to send position change notifications.
+    */
    boolean requiresPolling() {
       return requiresPolling_;
    }
 
+   /**
+    * Hysteresis, as a fraction of the threshold.
+    */
+   double getHysteresis() {
+      return hysteresis_;
+   }
+
    abstract MonitoredItem getMonitoredItem();
 
-   abstract boolean testForChange(MonitoredValue oldValue, MonitoredValue newValue);
+   /**
+    * Threshold, in the unit of distance().
+    */
+   abstract double getThreshold();
+
+   /**
+    * Distance between two values of the monitored item.
+    */
+   abstract double distance(MonitoredValue oldValue, MonitoredValue newValue);
+
+   boolean testForChange(MonitoredValue oldValue, MonitoredValue newValue) {
+      return distance(oldValue, newValue) >= getThreshold();
+   }
+
+   /**
+    * Whether a value that was considered changed still is.
+    */
+   boolean testStillChanged(MonitoredValue oldValue, MonitoredValue newValue) {
+      return distance(oldValue, newValue) >= getThreshold() * (1.0 - hysteresis_);
+   }
 
    private static final String SER_CLASS = "Class";
    private static final String SER_REQUIRES_POLLING = "Requires poling";
    private static final String SER_MONITORED_ITEM = "Monitored item";
    private static final String SER_THRESHOLD = "Threshold";
+   private static final String SER_HYSTERESIS = "Hysteresis";
 
    void serialize(PropertyMap.Builder pmb) {
       pmb.putString(SER_CLASS, this.getClass().getSimpleName());
       pmb.putBoolean(SER_REQUIRES_POLLING, requiresPolling_);
+      pmb.putDouble(SER_HYSTERESIS, hysteresis_);
    }
 
    static ChangeCriterion deserialize(PropertyMap pm) {
@@ -96,14 +150,16 @@ abstract class ChangeCriterion {
          }
          return createZDistanceCriterion(item.getDeviceLabel(),
                pm.getDouble(SER_THRESHOLD, 0.1),
-               pm.getBoolean(SER_REQUIRES_POLLING, false));
+               pm.getBoolean(SER_REQUIRES_POLLING, false),
+               pm.getDouble(SER_HYSTERESIS, DEFAULT_HYSTERESIS));
       } else if (theClass.equals("XYDistanceCriterion")) {
          if (!(item instanceof XYMonitoredItem)) {
             return null;
          }
          return createXYDistanceCriterion(item.getDeviceLabel(),
                pm.getDouble(SER_THRESHOLD, 0.1),
-               pm.getBoolean(SER_REQUIRES_POLLING, false));
+               pm.getBoolean(SER_REQUIRES_POLLING, false),
+               pm.getDouble(SER_HYSTERESIS, DEFAULT_HYSTERESIS));
       }
       return null;
    }
@@ -116,8 +172,9 @@ abstract class ChangeCriterion {
       private final MonitoredItem item_;
       private final double threshold_;
 
-      private ZDistanceCriterion(String stageLabel, double threshold, boolean requiresPolling) {
-         super(requiresPolling);
+      private ZDistanceCriterion(String stageLabel, double threshold, boolean requiresPolling,
+                                 double hysteresis) {
+         super(requiresPolling, hysteresis);
          item_ = MonitoredItem.createZItem(stageLabel);
          threshold_ = threshold;
       }
@@ -138,7 +195,12 @@ abstract class ChangeCriterion {
       }
 
       @Override
-      boolean testForChange(MonitoredValue oldValue, MonitoredValue newValue) {
+      double getThreshold() {
+         return threshold_;
+      }
+
+      @Override
+      double distance(MonitoredValue oldValue, MonitoredValue newValue) {
          if (oldValue == null || newValue == null) {
             throw new NullPointerException(); // Programming error
          }
@@ -146,7 +208,7 @@ abstract class ChangeCriterion {
                && newValue instanceof MonitoredFloatValue) {
             double diff = ((MonitoredFloatValue) newValue).getValue()
                   - ((MonitoredFloatValue) oldValue).getValue();
-            return Math.abs(diff) >= threshold_;
+            return Math.abs(diff);
          } else {
             throw new IllegalArgumentException(); // Programming error
          }
@@ -164,8 +226,9 @@ abstract class ChangeCriterion {
       private final MonitoredItem item_;
       private final double threshold_;
 
-      private XYDistanceCriterion(String stageLabel, double threshold, boolean requiresPolling) {
-         super(requiresPolling);
+      private XYDistanceCriterion(String stageLabel, double threshold, boolean requiresPolling,
+                                  double hysteresis) {
+         super(requiresPolling, hysteresis);
          item_ = MonitoredItem.createXYItem(stageLabel);
          threshold_ = threshold;
       }
@@ -186,7 +249,12 @@ abstract class ChangeCriterion {
       }
 
       @Override
-      boolean testForChange(MonitoredValue oldValue, MonitoredValue newValue) {
+      double getThreshold() {
+         return threshold_;
+      }
+
+      @Override
+      double distance(MonitoredValue oldValue, MonitoredValue newValue) {
          if (oldValue == null || newValue == null) {
             throw new NullPointerException(); // Programming error
          }
@@ -196,8 +264,7 @@ abstract class ChangeCriterion {
             double y0 = ((MonitoredXYValue) oldValue).getY();
             double x1 = ((MonitoredXYValue) newValue).getX();
             double y1 = ((MonitoredXYValue) newValue).getY();
-            double dist = Math.sqrt((x1 - x0) * (x1 - x0) + (y1 - y0) * (y1 - y0));
-            return dist >= threshold_;
+            return Math.sqrt((x1 - x0) * (x1 - x0) + (y1 - y0) * (y1 - y0));
          } else {
             throw new IllegalArgumentException(); // Programming error
          }
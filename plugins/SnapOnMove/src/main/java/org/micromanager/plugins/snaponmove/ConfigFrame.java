@@ -78,7 +78,7 @@ final class ConfigFrame extends JFrame {
       setTitle("Snap-on-Move");
       setDefaultCloseOperation(WindowConstants.DISPOSE_ON_CLOSE);
       setLayout(new MigLayout("fill",
-            "[]rel[]rel[grow, fill]rel[]", "[]rel[]unrel[]unrel[]rel[grow, fill]"));
+            "[]rel[]rel[grow, fill]rel[]", "[]rel[]unrel[]unrel[]rel[]rel[]rel[grow, fill]"));
 
       add(new JLabel("Snap-on-Move: "));
 
@@ -142,6 +142,48 @@ final class ConfigFrame extends JFrame {
       add(intervalField, "split 2");
       add(new JLabel(" ms"), "wrap");
 
+      add(new JLabel("Settle Time: "));
+
+      final JTextField settleTimeField =
+            new JTextField(Long.toString(controller.getSettleTimeMs()));
+      settleTimeField.setColumns(5);
+      settleTimeField.addActionListener(e -> {
+         long settleMs = controller.getSettleTimeMs();
+         try {
+            settleMs = Math.round(Double.parseDouble(settleTimeField.getText()));
+         } catch (NumberFormatException nfe) {
+            System.out.println("Caught NumberFormatException");
+         }
+         if (settleMs >= 0) {
+            controller.setSettleTimeMs(settleMs);
+         }
+         settleTimeField.setText(Long.toString(controller.getSettleTimeMs()));
+         settleTimeField.transferFocusUpCycle();
+      });
+      add(settleTimeField, "split 2");
+      add(new JLabel(" ms"), "wrap");
+
+      add(new JLabel("Settle Speed: "));
+
+      final JTextField settleSpeedField =
+            new JTextField(Double.toString(controller.getSettleSpeedUmPerS()));
+      settleSpeedField.setColumns(5);
+      settleSpeedField.addActionListener(e -> {
+         double speed = controller.getSettleSpeedUmPerS();
+         try {
+            speed = Double.parseDouble(settleSpeedField.getText());
+         } catch (NumberFormatException nfe) {
+            System.out.println("Caught NumberFormatException");
+         }
+         if (speed >= 0.0) {
+            controller.setSettleSpeedUmPerS(speed);
+         }
+         settleSpeedField.setText(Double.toString(controller.getSettleSpeedUmPerS()));
+         settleSpeedField.transferFocusUpCycle();
+      });
+      add(settleSpeedField, "split 2");
+      add(new JLabel(" um/s"), "wrap");
+
       criteriaTable_ = new JTable(new CriteriaTableModel(controller));
       criteriaTable_.setSelectionMode(ListSelectionModel.SINGLE_SELECTION);
       criteriaTable_.getSelectionModel().addListSelectionListener(
@@ -83,6 +83,7 @@ final class CriterionDialog extends JDialog {
    private final JTextField focusThreshField_;
    private final JTextField xyThreshField_;
    private final JCheckBox shouldPollCheckBox_;
+   private final JTextField hysteresisField_;
 
    CriterionDialog(final MainController controller, final Frame owner) {
       this(controller, null, owner);
@@ -113,7 +114,7 @@ final class CriterionDialog extends JDialog {
       setTitle("Edit Movement Detection Criterion");
       setLayout(new MigLayout("fill",
             "[fill, grow]",
-            "[]rel[]rel[]unrel[]"));
+            "[]rel[]rel[]rel[]unrel[]"));
 
       // Radio buttons for section titles
       final ButtonGroup radioGroup = new ButtonGroup();
@@ -200,8 +201,20 @@ final class CriterionDialog extends JDialog {
       add(xyPanel_, "grow, wrap");
       sectionPanels_.add(xyPanel_);
 
-      shouldPollCheckBox_ = new JCheckBox("Poll this device");
-      add(shouldPollCheckBox_);
+      shouldPollCheckBox_ = new JCheckBox("Always poll this device");
+      shouldPollCheckBox_.setToolTipText("Devices that do not send position "
+            + "change notifications are polled automatically");
+      add(shouldPollCheckBox_, "wrap");
+
+      add(new JLabel("Hysteresis: "), "split 3");
+      hysteresisField_ = new JTextField(Long.toString(
+            Math.round(ChangeCriterion.DEFAULT_HYSTERESIS * 100)));
+      hysteresisField_.setColumns(4);
+      hysteresisField_.setToolTipText("Once moved beyond the threshold, the device "
+            + "must come back this far (in percent of the threshold) to count as "
+            + "not moved");
+      add(hysteresisField_);
+      add(new JLabel(" % of threshold"), "wrap");
 
       final JButton cancelButton = new JButton("Cancel");
       cancelButton.addActionListener(new ActionListener() {
@@ -266,6 +279,7 @@ final class CriterionDialog extends JDialog {
          xyThreshField_.setText(Double.toString(xyThreshUm_));
       }
       shouldPollCheckBox_.setSelected(criterion.requiresPolling());
+      hysteresisField_.setText(Long.toString(Math.round(criterion.getHysteresis() * 100)));
    }
 
    private void handleCancel() {
@@ -274,16 +288,22 @@ final class CriterionDialog extends JDialog {
 
    private void handleOK() {
       boolean shouldPoll = shouldPollCheckBox_.isSelected();
+      double hysteresis = ChangeCriterion.DEFAULT_HYSTERESIS;
+      try {
+         hysteresis = Double.parseDouble(hysteresisField_.getText()) / 100.0;
+      } catch (NumberFormatException nfe) {
+         System.out.println("NumberFormatException");
+      }
       if (focusRadio_.isSelected()) {
          result_ = ChangeCriterion.createZDistanceCriterion(
                (String) focusDeviceCombo_.getSelectedItem(),
                Double.parseDouble(focusThreshField_.getText()),
-               shouldPoll);
+               shouldPoll, hysteresis);
       } else if (xyRadio_.isSelected()) {
          result_ = ChangeCriterion.createXYDistanceCriterion(
                (String) xyDeviceCombo_.getSelectedItem(),
                Double.parseDouble(xyThreshField_.getText()),
-               shouldPoll);
+               shouldPoll, hysteresis);
       }
       setVisible(false);
    }
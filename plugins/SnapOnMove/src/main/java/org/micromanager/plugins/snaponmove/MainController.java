@@ -39,7 +39,6 @@ import java.util.AbstractMap;
 import java.util.ArrayList;
 import java.util.Calendar;
 import java.util.Collection;
-import java.util.HashMap;
 import java.util.List;
 import java.util.Map;
 import java.util.concurrent.LinkedBlockingQueue;
@@ -64,13 +63,16 @@ import org.micromanager.propertymap.MutablePropertyMapView;
  * <p>Starts and stops a thread to monitor changes (movements) and trigger
  * snaps.
  *
- * <p>Monitored items (typically stage positions) can be updated either by
- * notifications from the Core, or by polling.
+ * <p>Monitored items (typically stage positions) are updated by
+ * notifications from the Core, and polled when their device does not send
+ * notifications. When to snap is decided by a {@link MovementTracker}.
  */
 class MainController {
    private final Studio studio_;
 
    private long pollingIntervalMs_;
+   private long settleTimeMs_;
+   private double settleSpeedUmPerS_;
 
    // Criteria for monitoring and change detection.
    // Although we frequently search for matching MonitoredItem, we just
@@ -78,19 +80,7 @@ class MainController {
    // is important.
    private final List<ChangeCriterion> changeCriteria_ = new ArrayList<>();
 
-   // The most recent known values. For asynchronously notified items, the last
-   // notified value. For polled items, the last polled value.
-   // Synchronized by its own monitor, since it is accessed from notification
-   // handlers.
-   private final Map<MonitoredItem, MonitoredValue> latestValues_ = new HashMap<>();
-
-   // Values at the time of the last snap, for use as a basis for detecting
-   // movement. Only accessed from monitoring thread while monitoring thread
-   // is running.
-   private final Map<MonitoredItem, MonitoredValue> lastSnapValues_ = new HashMap<>();
-
-   // Use string elements (stage device name) for prototype; should change to
-   // objects
+   // Notified values, to be handed to the monitoring thread
    private final LinkedBlockingQueue<Map.Entry<MonitoredItem, MonitoredValue>>
          eventQueue_ = new LinkedBlockingQueue<>();
 
@@ -112,8 +102,15 @@ class MainController {
 
    private static final String WARNING_TITLE = "Snap-on-Live Error";
 
+   // Longest wait for notifications, when nothing needs to be polled
+   private static final long MAX_WAIT_MS = 1000;
+
    private static final String PROFILE_KEY_POLLING_INTERVAL_MS =
          "Polling interval in milliseconds";
+   private static final String PROFILE_KEY_SETTLE_TIME_MS =
+         "Settle time in milliseconds";
+   private static final String PROFILE_KEY_SETTLE_SPEED =
+         "Settle speed in micrometers per second";
    private static final String PROFILE_KEY_CHANGE_CRITERIA =
          "Criteria for movement detection";
    private static final String USE_SNAP = "Use snap";
@@ -124,6 +121,10 @@ class MainController {
 
       pollingIntervalMs_ = studio_.profile().getSettings(this.getClass())
                   .getLong(PROFILE_KEY_POLLING_INTERVAL_MS, 100L);
+      settleTimeMs_ = studio_.profile().getSettings(this.getClass())
+                  .getLong(PROFILE_KEY_SETTLE_TIME_MS, 50L);
+      settleSpeedUmPerS_ = studio_.profile().getSettings(this.getClass())
+                  .getDouble(PROFILE_KEY_SETTLE_SPEED, 5.0);
       useSnap_ = studio_.profile().getSettings(this.getClass()).getBoolean(USE_SNAP, true);
       useTestAcq_ = studio_.profile().getSettings(this.getClass()).getBoolean(USE_TEST_ACQ, false);
 
@@ -154,6 +155,7 @@ class MainController {
 
    synchronized void setPollingIntervalMs(long intervalMs) {
       pollingIntervalMs_ = intervalMs;
+      restartIfEnabled();
 
       studio_.profile().getSettings(this.getClass()).putLong(
             PROFILE_KEY_POLLING_INTERVAL_MS, intervalMs);
@@ -163,6 +165,40 @@ class MainController {
       return pollingIntervalMs_;
    }
 
+   synchronized void setSettleTimeMs(long settleTimeMs) {
+      settleTimeMs_ = settleTimeMs;
+      restartIfEnabled();
+
+      studio_.profile().getSettings(this.getClass()).putLong(
+            PROFILE_KEY_SETTLE_TIME_MS, settleTimeMs);
+   }
+
+   synchronized long getSettleTimeMs() {
+      return settleTimeMs_;
+   }
+
+   synchronized void setSettleSpeedUmPerS(double speed) {
+      settleSpeedUmPerS_ = speed;
+      restartIfEnabled();
+
+      studio_.profile().getSettings(this.getClass()).putDouble(
+            PROFILE_KEY_SETTLE_SPEED, speed);
+   }
+
+   synchronized double getSettleSpeedUmPerS() {
+      return settleSpeedUmPerS_;
+   }
+
+   /**
+    * Makes the monitor thread pick up changed settings.
+    */
+   private void restartIfEnabled() {
+      if (isEnabled()) {
+         setEnabled(false);
+         setEnabled(true);
+      }
+   }
+
    synchronized void setChangeCriteria(Collection<ChangeCriterion> criteria) {
       final boolean wasEnabled = isEnabled();
       setEnabled(false);
@@ -227,10 +263,14 @@ class MainController {
          return;
       }
       if (f) {
+         // Settings are only read here, as the monitor thread must not take
+         // our lock: it is held while waiting for the thread to end
+         final MovementTracker tracker = new MovementTracker(changeCriteria_,
+               pollingIntervalMs_, settleTimeMs_, settleSpeedUmPerS_);
          monitorThread_ = new Thread("SnapOnMove Monitor Thread") {
             @Override
             public void run() {
-               monitorLoop();
+               monitorLoop(tracker);
             }
          };
          monitorThread_.start();
@@ -242,10 +282,6 @@ class MainController {
             Thread.currentThread().interrupt();
          }
          eventQueue_.clear();
-         synchronized (latestValues_) {
-            latestValues_.clear();
-         }
-         lastSnapValues_.clear();
          monitorThread_ = null;
       }
    }
@@ -270,16 +306,13 @@ class MainController {
       }
    }
 
-   private void monitorLoop() {
+   private void monitorLoop(MovementTracker tracker) {
       try {
-         initializeMonitoredValues();
+         initializeMonitoredValues(tracker);
          statusAlert_ = studio_.alerts().postUpdatableAlert("Snap-on-Move",
                String.format("Monitoring %d item(s)...", changeCriteria_.size()));
          for (; ; ) {
-            lastSnapValues_.clear();
-            synchronized (latestValues_) {
-               lastSnapValues_.putAll(latestValues_);
-            }
+            tracker.snapTaken(System.currentTimeMillis());
 
             boolean skipSnap = false;
             synchronized (pausedLock_) {
@@ -290,7 +323,7 @@ class MainController {
             if (!skipSnap) {
                doSnap();
             }
-            waitForChange();
+            waitForChange(tracker);
          }
       } catch (InterruptedException shouldExit) {
          if (statusAlert_ != null) {
@@ -301,96 +334,48 @@ class MainController {
    }
 
    /**
-    * Wait for at least the polling interval, or until a change is detected.
+    * Wait until a change is detected, and all monitored items have settled.
     *
-    * <p>Ensures that latestValues_ reflect just-polled values, which can be
-    * considered the "current" values for an immediately following snap.
+    * <p>Handles notifications as they arrive, and polls the items and
+    * queries the busy state of the devices when the tracker asks for it.
     *
     * @throws InterruptedException if current thread is interrupted
     */
-   private void waitForChange() throws InterruptedException {
-      if (Thread.interrupted()) {
-         throw new InterruptedException();
-      }
-      Thread.sleep(getPollingIntervalMs());
-      long pollingDeadlineMs = 0; // The first poll should happen immediately
+   private void waitForChange(MovementTracker tracker) throws InterruptedException {
       for (; ; ) {
-         if (waitForEvents(pollingDeadlineMs)) {
-            // We have detected a change based on an event.
-            // Bring the polled items up to date:
-            pollDevices();
-            return;
-         }
-         // Polling deadline passed without any change detected by events.
-         // See if any of the polled items have changed:
-         if (pollDevices()) {
-            return;
+         if (Thread.interrupted()) {
+            throw new InterruptedException();
          }
-         pollingDeadlineMs = System.currentTimeMillis() + getPollingIntervalMs();
-      }
-   }
-
-   /**
-    * Wait for queued events until a specified deadline.
-    *
-    * <p>Always checks the event queue at least once.
-    *
-    * @param deadlineMs deadline to be compared with System.currentTimeMillis().
-    * @return true if an event meeting criteria was received; false if the
-    *         deadline passed without such an event.
-    */
-   private boolean waitForEvents(long deadlineMs) throws InterruptedException {
-      long remainingMs = Math.max(0, deadlineMs - System.currentTimeMillis());
-      do {
-         final Map<MonitoredItem, MonitoredValue> events =
-               new HashMap<>();
-
+         long nowMs = System.currentTimeMillis();
+         long waitMs = Math.min(MAX_WAIT_MS, tracker.getNextCheckMs(nowMs) - nowMs);
          Map.Entry<MonitoredItem, MonitoredValue> event =
-               eventQueue_.poll(remainingMs, TimeUnit.MILLISECONDS);
-         if (event == null) { // Reached timeout
-            return false;
-         }
-         // Drain the queue, keeping only the most recent event for each item
+               eventQueue_.poll(waitMs, TimeUnit.MILLISECONDS);
          while (event != null) {
-            events.put(event.getKey(), event.getValue());
+            tracker.onNotification(event.getKey(), event.getValue(),
+                  System.currentTimeMillis());
             event = eventQueue_.poll();
          }
-
-         // Check each event to see if a change criterion is met
-         for (Map.Entry<MonitoredItem, MonitoredValue> e : events.entrySet()) {
-            MonitoredItem item = e.getKey();
-            MonitoredValue value = e.getValue();
-            if (value != null) {
-               for (ChangeCriterion cc : changeCriteria_) {
-                  if (cc.getMonitoredItem().equals(item)) {
-                     if (cc.testForChange(lastSnapValues_.get(item), value)) {
-                        return true;
-                     }
-                  }
-               }
-            }
+         pollDevices(tracker);
+         queryBusy(tracker);
+         if (tracker.isSnapDue(System.currentTimeMillis())) {
+            return;
          }
-
-         remainingMs = deadlineMs - System.currentTimeMillis();
-      } while (remainingMs > 0);
-      return false;
+      }
    }
 
-   private boolean pollDevices() throws InterruptedException {
+   private void pollDevices(MovementTracker tracker) throws InterruptedException {
+      List<MonitoredItem> items = tracker.getItemsToPoll(System.currentTimeMillis());
+      if (items.isEmpty()) {
+         return;
+      }
       CMMCore core = getCore();
       if (core == null) {
          studio_.alerts().postAlert(WARNING_TITLE, WarningAlertTag.class,
                "Cannot access devices");
-         return false;
+         return;
       }
 
-      boolean changeDetected = false;
-      for (ChangeCriterion cc : changeCriteria_) {
-         if (!cc.requiresPolling()) {
-            continue;
-         }
-
-         MonitoredItem item = cc.getMonitoredItem();
+      for (MonitoredItem item : items) {
          MonitoredValue value = null;
          try {
             value = item.poll(core);
@@ -398,25 +383,33 @@ class MainController {
             studio_.alerts().postAlert(WARNING_TITLE, WarningAlertTag.class,
                   "Device error: " + err.getMessage());
          }
-         if (value != null) {
-            synchronized (latestValues_) {
-               latestValues_.put(item, value);
-            }
-            if (cc.testForChange(lastSnapValues_.get(item), value)) {
-               changeDetected = true;
-            }
-         }
+         tracker.onPoll(item, value, System.currentTimeMillis());
          if (Thread.interrupted()) {
             throw new InterruptedException();
          }
       }
-      return changeDetected;
+   }
+
+   private void queryBusy(MovementTracker tracker) {
+      List<MonitoredItem> items = tracker.getSettlingItems(System.currentTimeMillis());
+      CMMCore core = getCore();
+      if (items.isEmpty() || core == null) {
+         return;
+      }
+      for (MonitoredItem item : items) {
+         try {
+            tracker.onBusy(item, core.deviceBusy(item.getDeviceLabel()),
+                  System.currentTimeMillis());
+         } catch (Exception e) {
+            // Not all devices can tell; rely on the settle time
+         }
+      }
    }
 
    /**
     * Retrieve the initial values for all monitored items.
     */
-   private void initializeMonitoredValues() {
+   private void initializeMonitoredValues(MovementTracker tracker) {
       CMMCore core = getCore();
       if (core == null) {
          studio_.alerts().postAlert(WARNING_TITLE, WarningAlertTag.class,
@@ -424,8 +417,7 @@ class MainController {
          return;
       }
 
-      for (ChangeCriterion cc : changeCriteria_) {
-         MonitoredItem item = cc.getMonitoredItem();
+      for (MonitoredItem item : tracker.getItems()) {
          MonitoredValue value = null;
          try {
             value = item.poll(core);
@@ -433,11 +425,7 @@ class MainController {
             studio_.alerts().postAlert(WARNING_TITLE, WarningAlertTag.class,
                   "Device error: " + err.getMessage());
          }
-         if (value != null) {
-            synchronized (latestValues_) {
-               latestValues_.put(item, value);
-            }
-         }
+         tracker.initialize(item, value, System.currentTimeMillis());
       }
    }
 
@@ -456,9 +444,6 @@ class MainController {
 
       MonitoredValue value = MonitoredValue.createFloatValue(e.getPos());
       try {
-         synchronized (latestValues_) {
-            latestValues_.put(item, value);
-         }
          eventQueue_.put(new AbstractMap.SimpleEntry<>(item, value));
       } catch (InterruptedException unexpected) {
          Thread.currentThread().interrupt();
@@ -480,9 +465,6 @@ class MainController {
 
       MonitoredValue value = MonitoredValue.createXYValue(e.getXPos(), e.getYPos());
       try {
-         synchronized (latestValues_) {
-            latestValues_.put(item, value);
-         }
          eventQueue_.put(new AbstractMap.SimpleEntry<>(item, value));
       } catch (InterruptedException unexpected) {
          Thread.currentThread().interrupt();
@@ -0,0 +1,350 @@
+// Snap-on-Move Preview for Micro-Manager
+//
+// Copyright (C) 2024 University of California, San Francisco
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+package org.micromanager.plugins.snaponmove;
+
+import java.util.ArrayList;
+import java.util.LinkedHashMap;
+import java.util.List;
+import java.util.Map;
+
+/**
+ * Decides when to snap, given the values of the monitored items as they are
+ * notified by the Core or polled.
+ *
+ * <p>A snap is due when at least one criterion detects a change from the
+ * values at the last snap, and all items have settled. An item has settled
+ * when it has not moved faster than the settle speed for the settle time, or
+ * when its device reports that it is no longer busy (only trusted for devices
+ * that were seen busy at least once, as many devices never report busy).
+ * Repeated notifications during a single move therefore result in a single
+ * snap, taken when the move has ended.
+ *
+ * <p>Items are polled until their device has sent a notification, after
+ * which notifications are relied upon, unless their criterion requires
+ * polling. The polling interval of an item doubles, up to a limit, while it
+ * does not move, and returns to the base interval when it does.
+ *
+ * <p>Not thread safe; used by the monitoring thread only. Times are in
+ * milliseconds, on any monotonic clock.
+ */
+final class MovementTracker {
+   // Maximum polling interval of idle items, as a multiple of the base
+   static final int MAX_POLLING_BACKOFF = 4;
+
+   private static final class ItemState {
+      final MonitoredItem item_;
+      final List<ChangeCriterion> criteria_ = new ArrayList<>();
+      boolean alwaysPoll_;
+      boolean notifies_;
+      boolean busyReliable_;
+      MonitoredValue snapValue_;
+      MonitoredValue latestValue_;
+      long latestSampleMs_;
+      // Time of the last sample that showed movement, or -1
+      long lastMotionMs_ = -1;
+      // Whether the device reported not busy after the last movement
+      boolean reportedIdle_;
+      long pollingIntervalMs_;
+      long nextPollMs_;
+
+      ItemState(MonitoredItem item, long basePollingMs) {
+         item_ = item;
+         // Until initialized, poll at the base rate
+         pollingIntervalMs_ = basePollingMs;
+         nextPollMs_ = basePollingMs;
+      }
+   }
+
+   private final long basePollingMs_;
+   private final long settleMs_;
+   private final double settleSpeedPerMs_;
+   private final Map<MonitoredItem, ItemState> items_ = new LinkedHashMap<>();
+   // Change state of each criterion, with hysteresis
+   private final Map<ChangeCriterion, Boolean> changed_ = new LinkedHashMap<>();
+
+   /**
+    * @param criteria criteria for detecting changes
+    * @param basePollingMs polling interval of items that move
+    * @param settleMs time an item must stay slower than the settle speed to
+    *                 be considered settled
+    * @param settleSpeedUmPerS speed (distance per second, in the unit of the
+    *                          criteria) below which an item is not moving
+    */
+   MovementTracker(List<ChangeCriterion> criteria, long basePollingMs, long settleMs,
+                   double settleSpeedUmPerS) {
+      basePollingMs_ = Math.max(1, basePollingMs);
+      settleMs_ = Math.max(0, settleMs);
+      settleSpeedPerMs_ = Math.max(0.0, settleSpeedUmPerS) / 1000.0;
+      for (ChangeCriterion cc : criteria) {
+         ItemState state = items_.get(cc.getMonitoredItem());
+         if (state == null) {
+            state = new ItemState(cc.getMonitoredItem(), basePollingMs_);
+            items_.put(cc.getMonitoredItem(), state);
+         }
+         state.criteria_.add(cc);
+         state.alwaysPoll_ |= cc.requiresPolling();
+         changed_.put(cc, false);
+      }
+   }
+
+   List<MonitoredItem> getItems() {
+      return new ArrayList<>(items_.keySet());
+   }
+
+   /**
+    * Sets the initial value of an item, which also serves as the reference
+    * for detecting changes until the first snap.
+    */
+   void initialize(MonitoredItem item, MonitoredValue value, long nowMs) {
+      ItemState state = items_.get(item);
+      if (state == null || value == null) {
+         return;
+      }
+      state.snapValue_ = value;
+      state.latestValue_ = value;
+      state.latestSampleMs_ = nowMs;
+      state.pollingIntervalMs_ = basePollingMs_;
+      state.nextPollMs_ = nowMs + basePollingMs_;
+   }
+
+   /**
+    * Handles a position change notification.
+    *
+    * @return false if the item is not monitored
+    */
+   boolean onNotification(MonitoredItem item, MonitoredValue value, long nowMs) {
+      ItemState state = items_.get(item);
+      if (state == null || value == null) {
+         return false;
+      }
+      state.notifies_ = true;
+      update(state, value, nowMs, true);
+      return true;
+   }
+
+   /**
+    * Handles a polled value.
+    *
+    * @param value the value, or null if the device could not be read; the
+    *              item is then polled again after backing off
+    */
+   void onPoll(MonitoredItem item, MonitoredValue value, long nowMs) {
+      ItemState state = items_.get(item);
+      if (state == null) {
+         return;
+      }
+      boolean moved = value != null && update(state, value, nowMs, false);
+      if (moved) {
+         state.pollingIntervalMs_ = basePollingMs_;
+      } else {
+         state.pollingIntervalMs_ = Math.max(basePollingMs_,
+               Math.min(basePollingMs_ * MAX_POLLING_BACKOFF,
+                     state.pollingIntervalMs_ * 2));
+      }
+      if (isSettling(state, nowMs)) {
+         // Keep sampling at the base rate to see the move end
+         state.pollingIntervalMs_ = basePollingMs_;
+      }
+      state.nextPollMs_ = nowMs + state.pollingIntervalMs_;
+   }
+
+   /**
+    * Handles the busy state of the device of an item.
+    */
+   void onBusy(MonitoredItem item, boolean busy, long nowMs) {
+      ItemState state = items_.get(item);
+      if (state == null) {
+         return;
+      }
+      if (busy) {
+         state.busyReliable_ = true;
+         state.reportedIdle_ = false;
+      } else {
+         state.reportedIdle_ = true;
+      }
+   }
+
+   /**
+    * Updates the state of an item with a new value.
+    *
+    * @param notified whether the value comes from a notification. As
+    *                 notifications only arrive when the item moves, the
+    *                 time since the previous value may have been spent
+    *                 standing still; the speed is then computed over at
+    *                 most the settle time.
+    * @return whether the item moved faster than the settle speed
+    */
+   private boolean update(ItemState state, MonitoredValue value, long nowMs,
+                          boolean notified) {
+      boolean moved = false;
+      if (state.latestValue_ == null) {
+         state.snapValue_ = value;
+      } else {
+         ChangeCriterion cc = state.criteria_.get(0);
+         double distance = cc.distance(state.latestValue_, value);
+         long dt = nowMs - state.latestSampleMs_;
+         if (notified) {
+            dt = Math.min(dt, Math.max(1, settleMs_));
+         }
+         moved = distance > 0.0
+               && (dt <= 0 || distance / dt > settleSpeedPerMs_);
+      }
+      state.latestValue_ = value;
+      state.latestSampleMs_ = nowMs;
+      if (moved) {
+         state.lastMotionMs_ = nowMs;
+         state.reportedIdle_ = false;
+      }
+      for (ChangeCriterion cc : state.criteria_) {
+         boolean wasChanged = changed_.get(cc);
+         changed_.put(cc, wasChanged
+               ? cc.testStillChanged(state.snapValue_, value)
+               : cc.testForChange(state.snapValue_, value));
+      }
+      return moved;
+   }
+
+   /**
+    * Whether an item moved recently, and has not been seen to settle.
+    */
+   private boolean isSettling(ItemState state, long nowMs) {
+      if (state.lastMotionMs_ < 0) {
+         return false;
+      }
+      if (state.busyReliable_ && state.reportedIdle_) {
+         return false;
+      }
+      if (nowMs - state.lastMotionMs_ < settleMs_) {
+         return true;
+      }
+      // A polled item must be sampled at least once after it stopped
+      return !state.notifies_ && state.latestSampleMs_ <= state.lastMotionMs_;
+   }
+
+   private boolean isPolled(ItemState state) {
+      return state.alwaysPoll_ || !state.notifies_;
+   }
+
+   /**
+    * Returns the items that should be polled now.
+    */
+   List<MonitoredItem> getItemsToPoll(long nowMs) {
+      List<MonitoredItem> result = new ArrayList<>();
+      for (ItemState state : items_.values()) {
+         if (isPolled(state) && nowMs >= state.nextPollMs_) {
+            result.add(state.item_);
+         }
+      }
+      return result;
+   }
+
+   /**
+    * Returns the items whose devices should be asked whether they are busy.
+    */
+   List<MonitoredItem> getSettlingItems(long nowMs) {
+      List<MonitoredItem> result = new ArrayList<>();
+      for (ItemState state : items_.values()) {
+         if (isSettling(state, nowMs)) {
+            result.add(state.item_);
+         }
+      }
+      return result;
+   }
+
+   /**
+    * Whether a change was detected and all items have settled.
+    */
+   boolean isSnapDue(long nowMs) {
+      if (!changed_.containsValue(true)) {
+         return false;
+      }
+      for (ItemState state : items_.values()) {
+         if (isSettling(state, nowMs)) {
+            return false;
+         }
+      }
+      return true;
+   }
+
+   /**
+    * Makes the latest values the reference for detecting changes.
+    */
+   void snapTaken(long nowMs) {
+      for (ItemState state : items_.values()) {
+         state.snapValue_ = state.latestValue_;
+      }
+      for (ChangeCriterion cc : changed_.keySet()) {
+         changed_.put(cc, false);
+      }
+   }
+
+   /**
+    * Returns the time at which the state should be checked again, in the
+    * absence of notifications: the next poll, or the end of the settle
+    * time of a moving item.
+    *
+    * @param nowMs current time
+    * @return time of the next check, at most the base polling interval
+    *         from now while items are settling, and never before now
+    */
+   long getNextCheckMs(long nowMs) {
+      long next = Long.MAX_VALUE;
+      for (ItemState state : items_.values()) {
+         if (isPolled(state)) {
+            next = Math.min(next, state.nextPollMs_);
+         }
+         if (isSettling(state, nowMs)) {
+            next = Math.min(next, nowMs + basePollingMs_);
+            long settledMs = state.lastMotionMs_ + settleMs_;
+            if (settledMs > nowMs) {
+               next = Math.min(next, settledMs);
+            }
+         }
+      }
+      return Math.max(nowMs, next);
+   }
+
+   /**
+    * Current polling interval of an item.
+    */
+   long getPollingIntervalMs(MonitoredItem item) {
+      ItemState state = items_.get(item);
+      return state == null ? 0 : state.pollingIntervalMs_;
+   }
+
+   /**
+    * Whether the item is currently polled.
+    */
+   boolean isPolled(MonitoredItem item) {
+      ItemState state = items_.get(item);
+      return state != null && isPolled(state);
+   }
+}
@@ -0,0 +1,239 @@
+package org.micromanager.plugins.snaponmove;
+
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.List;
+import org.junit.Assert;
+import org.junit.Test;
+
+public class MovementTrackerTest {
+   private static final String STAGE = "Z";
+   private static final MonitoredItem ITEM = MonitoredItem.createZItem(STAGE);
+   private static final long POLL_MS = 20;
+   private static final long SETTLE_MS = 50;
+   private static final double SETTLE_SPEED = 5.0;
+
+   /**
+    * Focus drive that moves at constant speed between positions.
+    */
+   private static final class SimulatedStage {
+      private final List<double[]> moves_ = new ArrayList<>();
+      private final long notificationIntervalMs_;
+
+      /**
+       * @param notificationIntervalMs interval between position change
+       *                               notifications during moves, or 0 for a
+       *                               device without notifications
+       */
+      SimulatedStage(long notificationIntervalMs) {
+         notificationIntervalMs_ = notificationIntervalMs;
+      }
+
+      /**
+       * Adds a move, to start once the previous one has ended.
+       */
+      SimulatedStage moveTo(double target, long startMs, double speedUmPerMs) {
+         double from = position(startMs);
+         long endMs = startMs + Math.round(Math.abs(target - from) / speedUmPerMs);
+         moves_.add(new double[] {startMs, endMs, from, target});
+         return this;
+      }
+
+      double position(long t) {
+         double position = 0.0;
+         for (double[] move : moves_) {
+            if (t >= move[1]) {
+               position = move[3];
+            } else if (t > move[0]) {
+               position = move[2] + (move[3] - move[2]) * (t - move[0]) / (move[1] - move[0]);
+            }
+         }
+         return position;
+      }
+
+      boolean isMoving(long t) {
+         for (double[] move : moves_) {
+            if (t >= move[0] && t < move[1]) {
+               return true;
+            }
+         }
+         return false;
+      }
+
+      boolean notifies(long t) {
+         if (notificationIntervalMs_ == 0) {
+            return false;
+         }
+         for (double[] move : moves_) {
+            if (t == (long) move[1] || (t >= move[0] && t < move[1]
+                  && (t - (long) move[0]) % notificationIntervalMs_ == 0)) {
+               return true;
+            }
+         }
+         return false;
+      }
+
+      MonitoredValue value(long t) {
+         return MonitoredValue.createFloatValue(position(t));
+      }
+   }
+
+   /**
+    * Drives a tracker the way MainController does, one millisecond at a time.
+    */
+   private static final class Harness {
+      final MovementTracker tracker_;
+      final SimulatedStage stage_;
+      final boolean reportsBusy_;
+      final List<Long> snaps_ = new ArrayList<>();
+      int polls_ = 0;
+      long now_ = 0;
+
+      Harness(ChangeCriterion criterion, SimulatedStage stage, boolean reportsBusy) {
+         tracker_ = new MovementTracker(Collections.singletonList(criterion), POLL_MS,
+               SETTLE_MS, SETTLE_SPEED);
+         stage_ = stage;
+         reportsBusy_ = reportsBusy;
+         tracker_.initialize(ITEM, stage.value(0), 0);
+      }
+
+      Harness run(long untilMs) {
+         for (; now_ < untilMs; now_++) {
+            if (stage_.notifies(now_)) {
+               tracker_.onNotification(ITEM, stage_.value(now_), now_);
+            }
+            if (tracker_.getItemsToPoll(now_).contains(ITEM)) {
+               polls_++;
+               tracker_.onPoll(ITEM, stage_.value(now_), now_);
+            }
+            if (reportsBusy_ && tracker_.getSettlingItems(now_).contains(ITEM)) {
+               tracker_.onBusy(ITEM, stage_.isMoving(now_), now_);
+            }
+            if (tracker_.isSnapDue(now_)) {
+               snaps_.add(now_);
+               tracker_.snapTaken(now_);
+            }
+         }
+         return this;
+      }
+   }
+
+   private static ChangeCriterion criterion(boolean alwaysPoll) {
+      return ChangeCriterion.createZDistanceCriterion(STAGE, 1.0, alwaysPoll);
+   }
+
+   @Test
+   public void notifiedMoveSnapsOnceAfterSettling() {
+      // 0 to 50 um between 100 and 200 ms, notifying every 20 ms
+      SimulatedStage stage = new SimulatedStage(20).moveTo(50.0, 100, 0.5);
+      Harness harness = new Harness(criterion(false), stage, false).run(1000);
+      Assert.assertEquals(1, harness.snaps_.size());
+      long latency = harness.snaps_.get(0) - 200;
+      Assert.assertTrue("latency " + latency, latency >= SETTLE_MS && latency <= SETTLE_MS + 1);
+      // Polling stopped once notifications arrived
+      Assert.assertFalse(harness.tracker_.isPolled(ITEM));
+   }
+
+   @Test
+   public void polledMoveSnapsOnceAfterSettling() {
+      SimulatedStage stage = new SimulatedStage(0).moveTo(50.0, 100, 0.5);
+      Harness harness = new Harness(criterion(false), stage, false).run(1000);
+      Assert.assertEquals(1, harness.snaps_.size());
+      long latency = harness.snaps_.get(0) - 200;
+      Assert.assertTrue("latency " + latency,
+            latency >= 0 && latency <= SETTLE_MS + 2 * POLL_MS);
+      Assert.assertTrue(harness.tracker_.isPolled(ITEM));
+   }
+
+   @Test
+   public void busyStateShortensSettling() {
+      SimulatedStage stage = new SimulatedStage(0).moveTo(50.0, 100, 0.5);
+      Harness harness = new Harness(criterion(false), stage, true).run(1000);
+      Assert.assertEquals(1, harness.snaps_.size());
+      long latency = harness.snaps_.get(0) - 200;
+      Assert.assertTrue("latency " + latency, latency >= 0 && latency <= POLL_MS);
+   }
+
+   @Test
+   public void repeatedNotificationsAreDeduplicated() {
+      // Notifications every millisecond, for two consecutive moves
+      SimulatedStage stage = new SimulatedStage(1)
+            .moveTo(20.0, 100, 0.1)
+            .moveTo(40.0, 300, 0.1);
+      Harness harness = new Harness(criterion(false), stage, false).run(1000);
+      Assert.assertEquals(Collections.singletonList(500L + SETTLE_MS), harness.snaps_);
+   }
+
+   @Test
+   public void movesBelowThresholdDoNotSnap() {
+      SimulatedStage stage = new SimulatedStage(10)
+            .moveTo(0.6, 100, 0.01)
+            .moveTo(0.2, 300, 0.01)
+            .moveTo(0.9, 500, 0.01);
+      Harness harness = new Harness(criterion(false), stage, false).run(1000);
+      Assert.assertTrue(harness.snaps_.isEmpty());
+   }
+
+   @Test
+   public void hysteresisKeepsOrCancelsPendingChange() {
+      // Crosses the threshold, and comes back within the hysteresis band
+      // before settling: still counts as moved
+      SimulatedStage stayed = new SimulatedStage(10)
+            .moveTo(1.2, 100, 0.1)
+            .moveTo(0.7, 112, 0.1);
+      Assert.assertEquals(1,
+            new Harness(criterion(false), stayed, false).run(1000).snaps_.size());
+
+      // Comes back below the hysteresis band: no snap needed
+      SimulatedStage returned = new SimulatedStage(10)
+            .moveTo(1.2, 100, 0.1)
+            .moveTo(0.3, 112, 0.1);
+      Assert.assertTrue(
+            new Harness(criterion(false), returned, false).run(1000).snaps_.isEmpty());
+   }
+
+   @Test
+   public void idlePollingBacksOff() {
+      SimulatedStage stage = new SimulatedStage(0).moveTo(50.0, 2000, 0.5);
+      Harness harness = new Harness(criterion(false), stage, false).run(1000);
+      Assert.assertEquals(POLL_MS * MovementTracker.MAX_POLLING_BACKOFF,
+            harness.tracker_.getPollingIntervalMs(ITEM));
+      // About one poll per backed off interval
+      Assert.assertTrue(harness.polls_ < 1000 / (POLL_MS * 3));
+      harness.run(2100);
+      Assert.assertEquals(POLL_MS, harness.tracker_.getPollingIntervalMs(ITEM));
+   }
+
+   @Test
+   public void failedReadsAreRetriedAtThePollingInterval() {
+      MovementTracker tracker = new MovementTracker(
+            Collections.singletonList(criterion(false)), POLL_MS, SETTLE_MS, SETTLE_SPEED);
+      // The first read failed
+      tracker.initialize(ITEM, null, 0);
+      SimulatedStage stage = new SimulatedStage(0).moveTo(50.0, 500, 0.5);
+      int polls = 0;
+      int snaps = 0;
+      for (long now = 0; now < 1000; now++) {
+         if (tracker.getItemsToPoll(now).contains(ITEM)) {
+            polls++;
+            // Reads fail until 300 ms
+            tracker.onPoll(ITEM, now < 300 ? null : stage.value(now), now);
+         }
+         Assert.assertTrue("at " + now, tracker.getNextCheckMs(now) > now);
+         if (tracker.isSnapDue(now)) {
+            snaps++;
+            tracker.snapTaken(now);
+         }
+      }
+      Assert.assertTrue("polls " + polls, polls <= 1000 / POLL_MS);
+      Assert.assertEquals(1, snaps);
+   }
+
+   @Test
+   public void alwaysPolledItemKeepsPolling() {
+      SimulatedStage stage = new SimulatedStage(20).moveTo(50.0, 100, 0.5);
+      Harness harness = new Harness(criterion(true), stage, false).run(1000);
+      Assert.assertTrue(harness.tracker_.isPolled(ITEM));
+      Assert.assertEquals(1, harness.snaps_.size());
+   }
+}
@@ -0,0 +1,432 @@
+///////////////////////////////////////////////////////////////////////////////
+//FILE:          ExposureEstimator.java
+//PROJECT:       PMQI_WhiteBalance
+//-----------------------------------------------------------------------------
+//COPYRIGHT:     QImaging, Surrey, BC, 2015
+//LICENSE:       This file is distributed under the BSD license.
+//               License text is included with the source distribution.
+//               This file is distributed in the hope that it will be useful,
+//               but WITHOUT ANY WARRANTY; without even the implied warranty
+//               of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//               IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+//               CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+//               INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES.
+
+package org.micromanager.pmqi;
+
+import java.util.ArrayList;
+import java.util.List;
+
+/**
+ * Finds the exposure time at which the mean of a raw (color filter array)
+ * image falls within a target range.
+ *
+ * <p>Rather than rescaling the exposure one snap at a time, the camera is
+ * modeled as mean = bias + rate * exposure. The model is fitted to the two
+ * usable snaps closest to the target, and the next exposure is predicted
+ * from it. For a linear camera this takes a short and a long probe, and one
+ * snap at the predicted exposure, which is also the image used for the
+ * white balance.
+ *
+ * <p>Each snap is measured on a subsampled grid of 2x2 color filter cells,
+ * so that all colors are sampled evenly. A coarse histogram of the samples
+ * gives the fraction of saturated pixels; snaps with too many saturated
+ * pixels are not used for the fit, as clipping makes their mean too low.
+ */
+public final class ExposureEstimator {
+
+   /**
+    * Source of images.
+    */
+   public interface Camera {
+      /**
+       * Snaps an image.
+       *
+       * @param exposureMs exposure time, in whole milliseconds
+       * @return raw pixels, short[] or byte[], of width * height pixels
+       */
+      Object snap(double exposureMs) throws Exception;
+   }
+
+   /**
+    * How the search ended.
+    */
+   public enum Outcome {
+      /** The mean of the last snap is within the target range. */
+      CONVERGED,
+      /** The shortest exposure already saturates. */
+      SATURATED_FROM_START,
+      /** No signal above the bias at the long probe exposure. */
+      TOO_DARK,
+      /** The target needs an exposure below the minimum. */
+      EXPOSURE_TOO_SHORT,
+      /** The target needs an exposure above the maximum. */
+      EXPOSURE_TOO_LONG,
+      /** The snap budget was used up before reaching the target. */
+      NOT_CONVERGED
+   }
+
+   /**
+    * Statistics of a subsampled image.
+    */
+   public static final class Sample {
+      private final double exposure_;
+      private final double mean_;
+      private final double saturatedFraction_;
+
+      Sample(double exposure, double mean, double saturatedFraction) {
+         exposure_ = exposure;
+         mean_ = mean;
+         saturatedFraction_ = saturatedFraction;
+      }
+
+      public double getExposure() {
+         return exposure_;
+      }
+
+      public double getMean() {
+         return mean_;
+      }
+
+      /**
+       * Fraction of the sampled pixels in the top histogram bin.
+       */
+      public double getSaturatedFraction() {
+         return saturatedFraction_;
+      }
+   }
+
+   /**
+    * Outcome of a search, with the last snap.
+    */
+   public static final class Result {
+      private final Outcome outcome_;
+      private final double exposure_;
+      private final List<Sample> samples_;
+      private final Object pixels_;
+
+      private Result(Outcome outcome, double exposure, List<Sample> samples, Object pixels) {
+         outcome_ = outcome;
+         exposure_ = exposure;
+         samples_ = samples;
+         pixels_ = pixels;
+      }
+
+      public Outcome getOutcome() {
+         return outcome_;
+      }
+
+      /**
+       * The exposure found, or for failures the last exposure tried or
+       * predicted.
+       */
+      public double getExposure() {
+         return exposure_;
+      }
+
+      /**
+       * Mean of the last snap, or 0 if nothing was snapped.
+       */
+      public double getMean() {
+         return samples_.isEmpty() ? 0.0 : samples_.get(samples_.size() - 1).getMean();
+      }
+
+      public int getNrSnaps() {
+         return samples_.size();
+      }
+
+      public List<Sample> getSamples() {
+         return samples_;
+      }
+
+      /**
+       * Pixels of the last snap; when converged, taken at the exposure found.
+       */
+      public Object getPixels() {
+         return pixels_;
+      }
+   }
+
+   public static final double SHORT_PROBE_MS = 1.0;
+   public static final double LONG_PROBE_MS = 100.0;
+   public static final int DEFAULT_MAX_SNAPS = 3;
+   // Snaps with more saturated pixels are not used to fit the model
+   public static final double SATURATED_FRACTION_LIMIT = 0.01;
+   private static final int HISTOGRAM_BINS = 256;
+   // Roughly the number of pixels measured per snap
+   private static final int MAX_SAMPLES = 1 << 16;
+
+   private final int width_;
+   private final int height_;
+   private final int bitDepth_;
+   private final double meanMin_;
+   private final double meanMax_;
+   private final double nominalBias_;
+   private double minExposure_ = SHORT_PROBE_MS;
+   private double maxExposure_ = 2000.0;
+   private int maxSnaps_ = DEFAULT_MAX_SNAPS;
+
+   /**
+    * @param width image width
+    * @param height image height
+    * @param bitDepth bit depth of the camera
+    * @param meanMin lower end of the target range of the image mean
+    * @param meanMax upper end of the target range of the image mean
+    * @param nominalBias typical bias (offset) of the camera, used when only
+    *                    one snap can be fitted, and as the darkest mean at
+    *                    which there is any signal
+    */
+   public ExposureEstimator(int width, int height, int bitDepth,
+                            double meanMin, double meanMax, double nominalBias) {
+      if (meanMin >= meanMax) {
+         throw new IllegalArgumentException("Target range is empty");
+      }
+      width_ = width;
+      height_ = height;
+      bitDepth_ = bitDepth;
+      meanMin_ = meanMin;
+      meanMax_ = meanMax;
+      nominalBias_ = nominalBias;
+   }
+
+   /**
+    * Sets the range of exposures that may be used to reach the target.
+    * The short probe is always taken.
+    */
+   public void setExposureLimits(double minExposure, double maxExposure) {
+      minExposure_ = minExposure;
+      maxExposure_ = maxExposure;
+   }
+
+   public void setMaxSnaps(int maxSnaps) {
+      maxSnaps_ = Math.max(2, maxSnaps);
+   }
+
+   /**
+    * Runs the search.
+    *
+    * @param camera source of images
+    * @return the outcome; never null
+    * @throws Exception when the camera fails
+    */
+   public Result run(Camera camera) throws Exception {
+      List<Sample> samples = new ArrayList<>();
+      double target = 0.5 * (meanMin_ + meanMax_);
+      // Shortest exposure known to saturate
+      double saturatedExposure = Double.POSITIVE_INFINITY;
+
+      double exposure = SHORT_PROBE_MS;
+      while (true) {
+         Object pixels = camera.snap(exposure);
+         Sample sample = measure(pixels, width_, height_, bitDepth_, exposure);
+         samples.add(sample);
+         boolean saturated = sample.getSaturatedFraction() > SATURATED_FRACTION_LIMIT;
+         if (!saturated && sample.getMean() >= meanMin_ && sample.getMean() <= meanMax_) {
+            return new Result(Outcome.CONVERGED, exposure, samples, pixels);
+         }
+         if (saturated) {
+            if (samples.size() == 1) {
+               return new Result(Outcome.SATURATED_FROM_START, exposure, samples, pixels);
+            }
+            saturatedExposure = Math.min(saturatedExposure, exposure);
+         }
+         if (samples.size() == 2 && !saturated && sample.getMean() < nominalBias_) {
+            return new Result(Outcome.TOO_DARK, exposure, samples, pixels);
+         }
+
+         double next;
+         if (samples.size() == 1) {
+            next = LONG_PROBE_MS;
+         } else {
+            next = predict(samples, target);
+            if (Double.isNaN(next)) {
+               return new Result(Outcome.TOO_DARK, exposure, samples, pixels);
+            }
+            // Stay below an exposure that saturated; the model may be off
+            // there if the camera is not quite linear
+            if (next >= saturatedExposure) {
+               next = 0.5 * (saturatedExposure + highestUsableExposure(samples));
+            }
+            next = Math.round(next);
+            if (next > maxExposure_) {
+               return new Result(Outcome.EXPOSURE_TOO_LONG, next, samples, pixels);
+            }
+            if (next < minExposure_) {
+               return new Result(Outcome.EXPOSURE_TOO_SHORT, next, samples, pixels);
+            }
+         }
+         if (samples.size() >= maxSnaps_ || wasTried(samples, next)) {
+            return new Result(Outcome.NOT_CONVERGED, exposure, samples, pixels);
+         }
+         exposure = next;
+      }
+   }
+
+   /**
+    * Predicts the exposure that gives the target mean, from the two
+    * unsaturated snaps with means closest to the target. With a single
+    * such snap, the nominal bias is used as the mean at zero exposure.
+    *
+    * @return the exposure, or NaN if the signal does not increase with the
+    *         exposure
+    */
+   private double predict(List<Sample> samples, double target) {
+      List<Sample> usable = new ArrayList<>();
+      for (Sample s : samples) {
+         if (s.getSaturatedFraction() <= SATURATED_FRACTION_LIMIT) {
+            usable.add(s);
+         }
+      }
+      usable.sort((a, b) -> Double.compare(
+            Math.abs(a.getMean() - target), Math.abs(b.getMean() - target)));
+      Sample first = usable.isEmpty() ? null : usable.get(0);
+      Sample second = null;
+      for (Sample s : usable) {
+         if (s.getExposure() != first.getExposure()) {
+            second = s;
+            break;
+         }
+      }
+      if (first == null) {
+         // Only the short probe could be usable, and it saturated
+         return Double.NaN;
+      }
+      double e0 = second == null ? 0.0 : second.getExposure();
+      double m0 = second == null ? nominalBias_ : second.getMean();
+      double rate = (first.getMean() - m0) / (first.getExposure() - e0);
+      if (!(rate > 0.0)) {
+         return Double.NaN;
+      }
+      double bias = first.getMean() - rate * first.getExposure();
+      return (target - bias) / rate;
+   }
+
+   private static double highestUsableExposure(List<Sample> samples) {
+      double highest = 0.0;
+      for (Sample s : samples) {
+         if (s.getSaturatedFraction() <= SATURATED_FRACTION_LIMIT) {
+            highest = Math.max(highest, s.getExposure());
+         }
+      }
+      return highest;
+   }
+
+   private static boolean wasTried(List<Sample> samples, double exposure) {
+      for (Sample s : samples) {
+         if (s.getExposure() == exposure) {
+            return true;
+         }
+      }
+      return false;
+   }
+
+   /**
+    * Measures the mean and saturated fraction of an image on a grid of 2x2
+    * cells, spaced so that about {@link #MAX_SAMPLES} pixels are read.
+    *
+    * @param pixels short[] or byte[] pixels
+    * @param width image width
+    * @param height image height
+    * @param bitDepth bit depth; values at or above 2^bitDepth count as saturated
+    * @param exposure exposure the image was taken at, recorded in the sample
+    */
+   static Sample measure(Object pixels, int width, int height, int bitDepth, double exposure) {
+      int cellsX = width / 2;
+      int cellsY = height / 2;
+      int step = 1;
+      while ((long) (cellsX / step) * (cellsY / step) * 4 > MAX_SAMPLES) {
+         step++;
+      }
+      // Histogram bins are 2^shift values wide
+      int shift = Math.max(0, bitDepth - 8);
+      int[] histogram = new int[HISTOGRAM_BINS];
+      long sum = 0;
+      short[] shorts = pixels instanceof short[] ? (short[]) pixels : null;
+      byte[] bytes = shorts == null ? (byte[]) pixels : null;
+      for (int cy = 0; cy < cellsY; cy += step) {
+         for (int cx = 0; cx < cellsX; cx += step) {
+            int i = 2 * cy * width + 2 * cx;
+            if (shorts != null) {
+               int v0 = shorts[i] & 0xffff;
+               int v1 = shorts[i + 1] & 0xffff;
+               int v2 = shorts[i + width] & 0xffff;
+               int v3 = shorts[i + width + 1] & 0xffff;
+               sum += v0 + v1 + v2 + v3;
+               histogram[Math.min(HISTOGRAM_BINS - 1, v0 >> shift)]++;
+               histogram[Math.min(HISTOGRAM_BINS - 1, v1 >> shift)]++;
+               histogram[Math.min(HISTOGRAM_BINS - 1, v2 >> shift)]++;
+               histogram[Math.min(HISTOGRAM_BINS - 1, v3 >> shift)]++;
+            } else {
+               int v0 = bytes[i] & 0xff;
+               int v1 = bytes[i + 1] & 0xff;
+               int v2 = bytes[i + width] & 0xff;
+               int v3 = bytes[i + width + 1] & 0xff;
+               sum += v0 + v1 + v2 + v3;
+               histogram[Math.min(HISTOGRAM_BINS - 1, v0 >> shift)]++;
+               histogram[Math.min(HISTOGRAM_BINS - 1, v1 >> shift)]++;
+               histogram[Math.min(HISTOGRAM_BINS - 1, v2 >> shift)]++;
+               histogram[Math.min(HISTOGRAM_BINS - 1, v3 >> shift)]++;
+            }
+         }
+      }
+      long n = 0;
+      for (int count : histogram) {
+         n += count;
+      }
+      if (n == 0) {
+         return new Sample(exposure, 0.0, 0.0);
+      }
+      return new Sample(exposure, (double) sum / n, (double) histogram[HISTOGRAM_BINS - 1] / n);
+   }
+
+   /**
+    * Computes, in one pass over a raw image, the mean of each of the four
+    * sites of the 2x2 color filter cell.
+    *
+    * @param pixels short[] or byte[] pixels
+    * @param width image width
+    * @param height image height
+    * @return means of the sites at (0, 0), (1, 0), (0, 1) and (1, 1)
+    */
+   static double[] siteMeans(Object pixels, int width, int height) {
+      long[] sums = new long[4];
+      short[] shorts = pixels instanceof short[] ? (short[]) pixels : null;
+      byte[] bytes = shorts == null ? (byte[]) pixels : null;
+      for (int y = 0; y < height; y++) {
+         int row = y * width;
+         long even = 0;
+         long odd = 0;
+         int x = 0;
+         if (shorts != null) {
+            for (; x + 1 < width; x += 2) {
+               even += shorts[row + x] & 0xffff;
+               odd += shorts[row + x + 1] & 0xffff;
+            }
+            if (x < width) {
+               even += shorts[row + x] & 0xffff;
+            }
+         } else {
+            for (; x + 1 < width; x += 2) {
+               even += bytes[row + x] & 0xff;
+               odd += bytes[row + x + 1] & 0xff;
+            }
+            if (x < width) {
+               even += bytes[row + x] & 0xff;
+            }
+         }
+         sums[2 * (y & 1)] += even;
+         sums[2 * (y & 1) + 1] += odd;
+      }
+      long evenColumns = (width + 1) / 2;
+      long oddColumns = width / 2;
+      long evenRows = (height + 1) / 2;
+      long oddRows = height / 2;
+      long[] counts = {evenColumns * evenRows, oddColumns * evenRows,
+            evenColumns * oddRows, oddColumns * oddRows};
+      double[] means = new double[4];
+      for (int s = 0; s < 4; s++) {
+         means[s] = counts[s] == 0 ? 0.0 : (double) sums[s] / counts[s];
+      }
+      return means;
+   }
+}
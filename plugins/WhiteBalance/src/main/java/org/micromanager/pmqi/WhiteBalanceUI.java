@@ -16,9 +16,6 @@
 package org.micromanager.pmqi;
 
 import com.google.common.eventbus.Subscribe;
-import ij.process.ByteProcessor;
-import ij.process.ImageProcessor;
-import ij.process.ShortProcessor;
 import java.math.BigDecimal;
 import java.math.RoundingMode;
 import java.util.logging.Level;
@@ -57,7 +54,8 @@ public class WhiteBalanceUI extends JFrame {
    private static final int WB_SUCCESS = 8;
    private static final int MIN_EXPOSURE = 2;
    private static final int MAX_EXPOSURE = 2000;
-   private static final int WB_EXP_ITERATIONS_MAX = 20;
+   // Three for a linear camera; the others refine the fit for other cameras
+   private static final int WB_EXP_SNAPS_MAX = 5;
    private static final double WB_SUCCESS_SNAP_FACTOR = 1.75;
    private static final int CFA_RGGB = 0;
    private static final int CFA_BGGR = 1;
@@ -76,8 +74,6 @@ public class WhiteBalanceUI extends JFrame {
    private static final int DEPTH12BIT_MEAN_MAX = 2300;
    private static final int DEPTH10BIT_MEAN_MIN = 420;
    private static final int DEPTH10BIT_MEAN_MAX = 600;
-   private static final int EXP_1MS = 1;
-   private static final int EXP_100MS = 100;
    private static final int ADU_BIAS_16BIT = 500;
    private static final int ADU_BIAS_LESS16BIT = 150;
 
@@ -95,8 +91,9 @@ public class WhiteBalanceUI extends JFrame {
    private String cameraModel;
    private boolean isColorCamera;
 
-   private ShortProcessor capturedImageShort;
-   private ByteProcessor capturedImageByte;
+   // Raw pixels, and their mean, of the last image snapped
+   private Object capturedPixels;
+   private double capturedMean;
    private double rMean;
    private double gMean;
    private double bMean;
@@ -628,128 +625,76 @@ public class WhiteBalanceUI extends JFrame {
    }
 
    private double findExposureForWB() {
-      double exposure = 5.0;
-      int iterations = 0;
-      double meanAt1ms;
-      double meanAt100ms;
-      double maxADUval = Math.pow(2, cameraBitDepth);
+      ExposureEstimator estimator = new ExposureEstimator(
+            (int) core_.getImageWidth(), (int) core_.getImageHeight(), cameraBitDepth,
+            wbMeanMin, wbMeanMax,
+            cameraBitDepth == DEPTH16BIT ? ADU_BIAS_16BIT : ADU_BIAS_LESS16BIT);
+      estimator.setExposureLimits(MIN_EXPOSURE, MAX_EXPOSURE);
+      estimator.setMaxSnaps(WB_EXP_SNAPS_MAX);
+      ExposureEstimator.Result result;
       try {
-
-         //first check if the image is not saturated by doing a short exposure
-         snapImage(EXP_1MS);
-         meanAt1ms = capturedImageShort.getStatistics().mean;
-         if (meanAt1ms > (maxADUval - maxADUval / 7.0)) {
-            wbResult = WB_FAILED_SATURATED_FROM_START;
-            lblMean.setText(String.valueOf(
-                  new BigDecimal(meanAt1ms).setScale(1, BigDecimal.ROUND_HALF_EVEN)));
-            lblMean.paintImmediately(lblMean.getVisibleRect());
-            JOptionPane.showMessageDialog(this,
-                  "Image too bright, please, decrease light levels and try again.",
-                  "White Balance Failure", JOptionPane.ERROR_MESSAGE);
-            return EXP_1MS;
-         }
-
-         //then with a longer exposure check if the image is not too dark
-         snapImage(EXP_100MS);
-         meanAt100ms = capturedImageShort.getStatistics().mean;
-         if ((meanAt100ms < ADU_BIAS_16BIT && cameraBitDepth == DEPTH16BIT)
-               || (meanAt100ms < ADU_BIAS_LESS16BIT && cameraBitDepth < DEPTH16BIT)) {
-            wbResult = WB_FAILED_TOO_DARK_FROM_START;
-            lblMean.setText(String.valueOf(
-                  new BigDecimal(meanAt100ms).setScale(1, BigDecimal.ROUND_HALF_EVEN)));
-            lblMean.paintImmediately(lblMean.getVisibleRect());
-            JOptionPane.showMessageDialog(this,
-                  "Image too dark, please, increase light levels and try again.",
-                  "White Balance Failure", JOptionPane.ERROR_MESSAGE);
-            return EXP_100MS;
-         }
-
-         //start searching for exposre time with mean around the middle of the camera ADU range
-         //later this value will be used for grabbing an image and calculating white balanc scales
-         snapImage(exposure);
-         exposure = exposure * wbMeanMin / capturedImageShort.getStatistics().mean;
-
-         //keep snapping images and adjusting exposure time until desired mean value is reached
-         while (iterations < WB_EXP_ITERATIONS_MAX && exposure < MAX_EXPOSURE) {
+         result = estimator.run(exposure -> {
             snapImage(exposure);
-
             lblWBExposure.setText(
                   String.valueOf(new BigDecimal(exposure).setScale(0, RoundingMode.HALF_EVEN))
                         + " ms");
             lblWBExposure.paintImmediately(lblWBExposure.getVisibleRect());
-            iterations++;
-
-            if (capturedImageShort.getStatistics().mean < wbMeanMin) {
-               exposure = exposure * wbMeanMin / capturedImageShort.getStatistics().mean;
-            } else if (capturedImageShort.getStatistics().mean > wbMeanMax) {
-               exposure = exposure * wbMeanMin / capturedImageShort.getStatistics().mean;
-            } else if (capturedImageShort.getStatistics().mean > wbMeanMin
-                  && capturedImageShort.getStatistics().mean < wbMeanMax) {
-               break;
-            }
-            lblMean.setText(String.valueOf(
-                  new BigDecimal(capturedImageShort.getStatistics().mean).setScale(1,
-                        BigDecimal.ROUND_HALF_EVEN)));
-            lblMean.paintImmediately(lblMean.getVisibleRect());
-         }
+            return capturedPixels;
+         });
       } catch (Exception ex) {
          wbResult = WB_FAILED_EXCEPTION;
-         lblMean.setText(String.valueOf(
-               new BigDecimal(capturedImageShort.getStatistics().mean).setScale(1,
-                     BigDecimal.ROUND_HALF_EVEN)));
-         lblMean.paintImmediately(lblMean.getVisibleRect());
+         showMean();
          JOptionPane.showMessageDialog(this, "Acquisition error occurred", "White Balance Failure",
                JOptionPane.ERROR_MESSAGE);
-         return exposure;
+         return 0.0;
       }
+      capturedMean = result.getMean();
+      showMean();
 
       //check if the exposure search did not end due to algorithm failure - too many iterations,
       //image too dark, image too bright etc.
-      if (iterations >= WB_EXP_ITERATIONS_MAX && exposure >= MAX_EXPOSURE) {
-         wbResult = WB_FAILED_TOO_MANY_ITERATIONS_TOO_DARK;
-         lblMean.setText(String.valueOf(
-               new BigDecimal(capturedImageShort.getStatistics().mean).setScale(1,
-                     BigDecimal.ROUND_HALF_EVEN)));
-         lblMean.paintImmediately(lblMean.getVisibleRect());
-         JOptionPane.showMessageDialog(this,
-               "Exceeded number of allowed iterations, image too dark.", "White Balance Failure",
-               JOptionPane.ERROR_MESSAGE);
-         return exposure;
-      } else if (iterations >= WB_EXP_ITERATIONS_MAX && exposure < MIN_EXPOSURE) {
-         wbResult = WB_FAILED_TOO_MANY_ITERATIONS_TOO_BRIGHT;
-         lblMean.setText(String.valueOf(
-               new BigDecimal(capturedImageShort.getStatistics().mean).setScale(1,
-                     BigDecimal.ROUND_HALF_EVEN)));
-         lblMean.paintImmediately(lblMean.getVisibleRect());
-         JOptionPane.showMessageDialog(this,
-               "Exceeded number of allowed iterations, image too bright.", "White Balance Failure",
-               JOptionPane.ERROR_MESSAGE);
-         return exposure;
-      } else if (iterations >= WB_EXP_ITERATIONS_MAX) {
-         wbResult = WB_FAILED_TOO_MANY_ITERATIONS;
-         lblMean.setText(String.valueOf(
-               new BigDecimal(capturedImageShort.getStatistics().mean).setScale(1,
-                     BigDecimal.ROUND_HALF_EVEN)));
-         lblMean.paintImmediately(lblMean.getVisibleRect());
-         JOptionPane.showMessageDialog(this,
-               "Exceeded number of allowed iterations, adjust your light level and try again",
-               "White Balance Failure", JOptionPane.ERROR_MESSAGE);
-         return exposure;
-      } else if (exposure > MAX_EXPOSURE) {
-         wbResult = WB_FAILED_EXP_TOO_LONG;
-         lblMean.setText(String.valueOf(
-               new BigDecimal(capturedImageShort.getStatistics().mean).setScale(1,
-                     BigDecimal.ROUND_HALF_EVEN)));
-         lblMean.paintImmediately(lblMean.getVisibleRect());
-         JOptionPane.showMessageDialog(this,
-               "Light level seems to be too low, adjust your light level and try again",
-               "White Balance Failure", JOptionPane.ERROR_MESSAGE);
-         return exposure;
-      } else {
-         wbResult = WB_SUCCESS;
+      switch (result.getOutcome()) {
+         case CONVERGED:
+            wbResult = WB_SUCCESS;
+            break;
+         case SATURATED_FROM_START:
+            wbResult = WB_FAILED_SATURATED_FROM_START;
+            JOptionPane.showMessageDialog(this,
+                  "Image too bright, please, decrease light levels and try again.",
+                  "White Balance Failure", JOptionPane.ERROR_MESSAGE);
+            break;
+         case TOO_DARK:
+            wbResult = WB_FAILED_TOO_DARK_FROM_START;
+            JOptionPane.showMessageDialog(this,
+                  "Image too dark, please, increase light levels and try again.",
+                  "White Balance Failure", JOptionPane.ERROR_MESSAGE);
+            break;
+         case EXPOSURE_TOO_SHORT:
+            wbResult = WB_FAILED_EXP_TOO_SHORT;
+            JOptionPane.showMessageDialog(this,
+                  "Light level seems to be too high, adjust your light level and try again",
+                  "White Balance Failure", JOptionPane.ERROR_MESSAGE);
+            break;
+         case EXPOSURE_TOO_LONG:
+            wbResult = WB_FAILED_EXP_TOO_LONG;
+            JOptionPane.showMessageDialog(this,
+                  "Light level seems to be too low, adjust your light level and try again",
+                  "White Balance Failure", JOptionPane.ERROR_MESSAGE);
+            break;
+         default:
+            wbResult = WB_FAILED_TOO_MANY_ITERATIONS;
+            JOptionPane.showMessageDialog(this,
+                  "Exceeded number of allowed iterations, adjust your light level and try again",
+                  "White Balance Failure", JOptionPane.ERROR_MESSAGE);
+            break;
       }
+      return result.getExposure();
+   }
 
-      return exposure;
+   private void showMean() {
+      lblMean.setText(String.valueOf(
+            new BigDecimal(capturedMean).setScale(1, RoundingMode.HALF_EVEN)));
+      lblMean.paintImmediately(lblMean.getVisibleRect());
    }
 
    //snap a single image
@@ -757,136 +702,50 @@ public class WhiteBalanceUI extends JFrame {
       try {
          core_.setExposure(Math.round(exposure));
          core_.snapImage();
-         Object newImage = core_.getImage();
-         capturedImageShort =
-               new ShortProcessor((int) core_.getImageWidth(), (int) core_.getImageHeight(),
-                     (short[]) newImage, null);
+         capturedPixels = core_.getImage();
       } catch (Exception ex) {
          Logger.getLogger(WhiteBalanceUI.class.getName()).log(Level.SEVERE, null, ex);
          throw new Exception("Acquisition failed");
       }
    }
 
-   //use Nearest Neighbor replication algorithm to debayer the image and obtain
-   //red, blue and green interpolated pixels and their mean values
-   private void debayerImage(ShortProcessor imgToProcess) {
-      ImageProcessor r = new ShortProcessor(capturedImageShort.getWidth(), getHeight());
-      ImageProcessor g = new ShortProcessor(capturedImageShort.getWidth(), getHeight());
-      ImageProcessor b = new ShortProcessor(capturedImageShort.getWidth(), getHeight());
-      ImageProcessor ip = imgToProcess;
-
-      int height = (int) capturedImageShort.getHeight();
-      int width = (int) capturedImageShort.getWidth();
-      int one;
-
-      if (cfaPattern == CFA_GRBG || cfaPattern == CFA_GBRG) {
-         for (int y = 1; y < height; y += 2) {
-            for (int x = 0; x < width; x += 2) {
-               one = ip.getPixel(x, y);
-               b.putPixel(x, y, one);
-               b.putPixel(x + 1, y, one);
-               b.putPixel(x, y + 1, one);
-               b.putPixel(x + 1, y + 1, one);
-            }
-         }
-
-         for (int y = 0; y < height; y += 2) {
-            for (int x = 1; x < width; x += 2) {
-               one = ip.getPixel(x, y);
-               r.putPixel(x, y, one);
-               r.putPixel(x + 1, y, one);
-               r.putPixel(x, y + 1, one);
-               r.putPixel(x + 1, y + 1, one);
-            }
-         }
-
-         for (int y = 0; y < height; y += 2) {
-            for (int x = 0; x < width; x += 2) {
-               one = ip.getPixel(x, y);
-               g.putPixel(x, y, one);
-               g.putPixel(x + 1, y, one);
-            }
-         }
-
-         for (int y = 1; y < height; y += 2) {
-            for (int x = 1; x < width; x += 2) {
-               one = ip.getPixel(x, y);
-               g.putPixel(x, y, one);
-               g.putPixel(x + 1, y, one);
-            }
-         }
-
-         if (cfaPattern == CFA_GRBG) {
-            rMean = b.getStatistics().mean;
-            gMean = g.getStatistics().mean;
-            bMean = r.getStatistics().mean;
-         } else if (cfaPattern == CFA_GBRG) {
-            rMean = r.getStatistics().mean;
-            gMean = g.getStatistics().mean;
-            bMean = b.getStatistics().mean;
-         }
-
-         lblRedMean.setText(
-               String.valueOf(new BigDecimal(rMean).setScale(1, RoundingMode.HALF_EVEN)));
-         lblGreenMean.setText(
-               String.valueOf(new BigDecimal(gMean).setScale(1, RoundingMode.HALF_EVEN)));
-         lblBlueMean.setText(
-               String.valueOf(new BigDecimal(bMean).setScale(1, RoundingMode.HALF_EVEN)));
-
-      } else if (cfaPattern == CFA_RGGB || cfaPattern == CFA_BGGR) {
-         for (int y = 0; y < height; y += 2) {
-            for (int x = 0; x < width; x += 2) {
-               one = ip.getPixel(x, y);
-               b.putPixel(x, y, one);
-               b.putPixel(x + 1, y, one);
-               b.putPixel(x, y + 1, one);
-               b.putPixel(x + 1, y + 1, one);
-            }
-         }
-
-         for (int y = 1; y < height; y += 2) {
-            for (int x = 1; x < width; x += 2) {
-               one = ip.getPixel(x, y);
-               r.putPixel(x, y, one);
-               r.putPixel(x + 1, y, one);
-               r.putPixel(x, y + 1, one);
-               r.putPixel(x + 1, y + 1, one);
-            }
-         }
-
-         for (int y = 0; y < height; y += 2) {
-            for (int x = 1; x < width; x += 2) {
-               one = ip.getPixel(x, y);
-               g.putPixel(x, y, one);
-               g.putPixel(x + 1, y, one);
-            }
-         }
-
-         for (int y = 1; y < height; y += 2) {
-            for (int x = 0; x < width; x += 2) {
-               one = ip.getPixel(x, y);
-               g.putPixel(x, y, one);
-               g.putPixel(x + 1, y, one);
-            }
-         }
-         if (cfaPattern == CFA_RGGB) {
-            rMean = b.getStatistics().mean;
-            gMean = g.getStatistics().mean;
-            bMean = r.getStatistics().mean;
-         } else if (cfaPattern == CFA_BGGR) {
-            rMean = r.getStatistics().mean;
-            gMean = g.getStatistics().mean;
-            bMean = b.getStatistics().mean;
-         }
-
-         //display mean values of each red, green and blue channel
-         lblRedMean.setText(
-               String.valueOf(new BigDecimal(rMean).setScale(1, RoundingMode.HALF_EVEN)));
-         lblGreenMean.setText(
-               String.valueOf(new BigDecimal(gMean).setScale(1, RoundingMode.HALF_EVEN)));
-         lblBlueMean.setText(
-               String.valueOf(new BigDecimal(bMean).setScale(1, RoundingMode.HALF_EVEN)));
+   //obtain the red, green and blue means from the raw image in a single pass;
+   //the mean of a channel equals that of its sites in the color filter array
+   private void computeChannelMeans(Object pixels) {
+      double[] sites = ExposureEstimator.siteMeans(pixels,
+            (int) core_.getImageWidth(), (int) core_.getImageHeight());
+      // sites are (0, 0), (1, 0), (0, 1) and (1, 1) of each 2x2 cell
+      switch (cfaPattern) {
+         case CFA_GRBG:
+            rMean = sites[2];
+            gMean = 0.5 * (sites[0] + sites[3]);
+            bMean = sites[1];
+            break;
+         case CFA_GBRG:
+            rMean = sites[1];
+            gMean = 0.5 * (sites[0] + sites[3]);
+            bMean = sites[2];
+            break;
+         case CFA_BGGR:
+            rMean = sites[3];
+            gMean = 0.5 * (sites[1] + sites[2]);
+            bMean = sites[0];
+            break;
+         case CFA_RGGB:
+         default:
+            rMean = sites[0];
+            gMean = 0.5 * (sites[1] + sites[2]);
+            bMean = sites[3];
+            break;
       }
+
+      //display mean values of each red, green and blue channel
+      lblRedMean.setText(
+            String.valueOf(new BigDecimal(rMean).setScale(1, RoundingMode.HALF_EVEN)));
+      lblGreenMean.setText(
+            String.valueOf(new BigDecimal(gMean).setScale(1, RoundingMode.HALF_EVEN)));
+      lblBlueMean.setText(
+            String.valueOf(new BigDecimal(bMean).setScale(1, RoundingMode.HALF_EVEN)));
    }
 
    //calculate the RGB scales based on red, green and blue channels' means
@@ -984,17 +843,13 @@ public class WhiteBalanceUI extends JFrame {
       lblWBExposure.setText(
             String.valueOf(new BigDecimal(wbExposure).setScale(0, RoundingMode.HALF_EVEN)) + " ms");
 
-      lblMean.setText(String.valueOf(
-            new BigDecimal(capturedImageShort.getStatistics().mean).setScale(1,
-                  BigDecimal.ROUND_HALF_EVEN)));
-      lblMean.paintImmediately(lblMean.getVisibleRect());
+      showMean();
 
-      //if the correct exposure time has been found snap an image in MM and
-      //calculate the RGB scales to balance the image
+      //if the correct exposure time has been found, calculate the RGB scales
+      //from the image the search ended with, which was taken at that exposure
       try {
          if (wbResult == WB_SUCCESS) {
-            snapImage(wbExposure);
-            debayerImage(capturedImageShort);
+            computeChannelMeans(capturedPixels);
             getScales();
             core_.setProperty(cameraLabel, RED_SCALE_LABEL, redScale);
             core_.setProperty(cameraLabel, GREEN_SCALE_LABEL, greenScale);
@@ -0,0 +1,154 @@
+package org.micromanager.pmqi;
+
+import java.util.Random;
+import org.junit.Assert;
+import org.junit.Test;
+
+public class ExposureEstimatorTest {
+   private static final int WIDTH = 640;
+   private static final int HEIGHT = 480;
+   private static final double MEAN_MIN = 27000;
+   private static final double MEAN_MAX = 33000;
+   private static final double NOMINAL_BIAS = 500;
+
+   /**
+    * Camera with an RGGB color filter array. The signal of a site is
+    * bias + rate * exposure^linearity, plus Gaussian noise, clipped at the
+    * full scale of the bit depth.
+    */
+   private static final class SimulatedCamera implements ExposureEstimator.Camera {
+      private final double bias_;
+      // Rates of the red, green and blue sites, in DN per ms
+      private final double[] rates_;
+      private final double linearity_;
+      private final int fullScale_;
+      private final Random random_ = new Random(1);
+      private int snaps_ = 0;
+
+      SimulatedCamera(double bias, double[] rates, double linearity, int bitDepth) {
+         bias_ = bias;
+         rates_ = rates;
+         linearity_ = linearity;
+         fullScale_ = (1 << bitDepth) - 1;
+      }
+
+      @Override
+      public Object snap(double exposureMs) {
+         snaps_++;
+         Assert.assertEquals(Math.rint(exposureMs), exposureMs, 0.0);
+         short[] pixels = new short[WIDTH * HEIGHT];
+         double t = Math.pow(exposureMs, linearity_);
+         for (int y = 0; y < HEIGHT; y++) {
+            for (int x = 0; x < WIDTH; x++) {
+               int site = (x & 1) + 2 * (y & 1);
+               double rate = site == 0 ? rates_[0] : site == 3 ? rates_[2] : rates_[1];
+               double v = bias_ + rate * t + 20.0 * random_.nextGaussian();
+               pixels[y * WIDTH + x] =
+                     (short) Math.max(0, Math.min(fullScale_, Math.round(v)));
+            }
+         }
+         return pixels;
+      }
+
+      int getSnaps() {
+         return snaps_;
+      }
+   }
+
+   private static ExposureEstimator createEstimator() {
+      ExposureEstimator estimator = new ExposureEstimator(WIDTH, HEIGHT, 16,
+            MEAN_MIN, MEAN_MAX, NOMINAL_BIAS);
+      estimator.setExposureLimits(2, 2000);
+      return estimator;
+   }
+
+   private static void checkConverged(ExposureEstimator.Result result) {
+      Assert.assertEquals(ExposureEstimator.Outcome.CONVERGED, result.getOutcome());
+      Assert.assertTrue(result.getMean() >= MEAN_MIN && result.getMean() <= MEAN_MAX);
+      // The pixels returned are those of the converged snap
+      double mean = ExposureEstimator.measure(result.getPixels(), WIDTH, HEIGHT, 16,
+            result.getExposure()).getMean();
+      Assert.assertEquals(result.getMean(), mean, 1e-9);
+   }
+
+   @Test
+   public void linearCameraConvergesInThreeSnaps() throws Exception {
+      for (double bias : new double[] {100, 500, 2000}) {
+         for (double green : new double[] {40, 120, 300, 600}) {
+            SimulatedCamera camera = new SimulatedCamera(bias,
+                  new double[] {0.7 * green, green, 0.4 * green}, 1.0, 16);
+            ExposureEstimator.Result result = createEstimator().run(camera);
+            checkConverged(result);
+            Assert.assertTrue("bias " + bias + ", rate " + green, camera.getSnaps() <= 3);
+            Assert.assertEquals(camera.getSnaps(), result.getNrSnaps());
+         }
+      }
+   }
+
+   @Test
+   public void nonLinearCameraConverges() throws Exception {
+      for (double linearity : new double[] {0.85, 1.15}) {
+         SimulatedCamera camera = new SimulatedCamera(500,
+               new double[] {80, 100, 60}, linearity, 16);
+         ExposureEstimator estimator = createEstimator();
+         estimator.setMaxSnaps(5);
+         checkConverged(estimator.run(camera));
+      }
+   }
+
+   @Test
+   public void saturatedLongProbeIsNotFitted() throws Exception {
+      // Saturates well before the 100 ms probe
+      SimulatedCamera camera = new SimulatedCamera(500,
+            new double[] {4000, 5000, 3000}, 1.0, 16);
+      ExposureEstimator estimator = createEstimator();
+      estimator.setMaxSnaps(5);
+      ExposureEstimator.Result result = estimator.run(camera);
+      checkConverged(result);
+      Assert.assertTrue(result.getSamples().get(1).getSaturatedFraction()
+            > ExposureEstimator.SATURATED_FRACTION_LIMIT);
+   }
+
+   @Test
+   public void failures() throws Exception {
+      SimulatedCamera bright = new SimulatedCamera(500,
+            new double[] {80000, 90000, 70000}, 1.0, 16);
+      ExposureEstimator.Result result = createEstimator().run(bright);
+      Assert.assertEquals(ExposureEstimator.Outcome.SATURATED_FROM_START, result.getOutcome());
+      Assert.assertEquals(1, bright.getSnaps());
+
+      SimulatedCamera dark = new SimulatedCamera(300, new double[] {0, 0, 0}, 1.0, 16);
+      result = createEstimator().run(dark);
+      Assert.assertEquals(ExposureEstimator.Outcome.TOO_DARK, result.getOutcome());
+      Assert.assertEquals(2, dark.getSnaps());
+
+      SimulatedCamera dim = new SimulatedCamera(500, new double[] {4, 5, 3}, 1.0, 16);
+      result = createEstimator().run(dim);
+      Assert.assertEquals(ExposureEstimator.Outcome.EXPOSURE_TOO_LONG, result.getOutcome());
+      Assert.assertTrue(result.getExposure() > 2000);
+      Assert.assertEquals(2, dim.getSnaps());
+   }
+
+   @Test
+   public void measureSamplesAllSites() {
+      int width = 2001;
+      int height = 1001;
+      short[] pixels = new short[width * height];
+      for (int y = 0; y < height; y++) {
+         for (int x = 0; x < width; x++) {
+            int site = (x & 1) + 2 * (y & 1);
+            pixels[y * width + x] = (short) (site == 3 ? 65535 : 1000 * (site + 1));
+         }
+      }
+      ExposureEstimator.Sample sample = ExposureEstimator.measure(pixels, width, height, 16, 1);
+      Assert.assertEquals((1000 + 2000 + 3000 + 65535) / 4.0, sample.getMean(), 1e-9);
+      Assert.assertEquals(0.25, sample.getSaturatedFraction(), 1e-9);
+
+      double[] means = ExposureEstimator.siteMeans(pixels, width, height);
+      Assert.assertArrayEquals(new double[] {1000, 2000, 3000, 65535}, means, 1e-9);
+
+      byte[] bytes = new byte[] {10, 20, 30, (byte) 200, (byte) 250, 60};
+      Assert.assertArrayEquals(new double[] {20, 20, 130, 250},
+            ExposureEstimator.siteMeans(bytes, 3, 2), 1e-9);
+   }
+}
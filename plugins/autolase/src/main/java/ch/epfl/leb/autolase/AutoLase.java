@@ -34,6 +34,9 @@ public enum AutoLase {
 
    boolean logFileIsStarted = false;
 
+   private static final String SEQUENCE_DRAIN = "SequenceDrain";
+   boolean sequenceDrain = false;
+
    /**
     * Set the laser power to the minimum allowed power.
     */
@@ -89,7 +92,11 @@ public enum AutoLase {
 
       // Prepare density monitor
       if (densityThread == null) {
-         densityThread = new DensityThread(new MMCamera(core));
+         sequenceDrain = gui.profile().getSettings(AutoLase.class)
+               .getBoolean(SEQUENCE_DRAIN, false);
+         MMCamera camera = new MMCamera(core);
+         camera.setSequenceDrain(sequenceDrain);
+         densityThread = new DensityThread(camera);
       }
    }
 
@@ -194,6 +201,29 @@ public enum AutoLase {
       // TODO Prebleacing
    }
 
+   /**
+    * Process every frame acquired during a sequence instead of only the
+    * latest one. The frames are popped from the circular buffer, so only
+    * enable this when nothing else consumes it. The choice is stored in the
+    * user profile.
+    *
+    * @param drain true to pop every frame from the circular buffer
+    */
+   public void setSequenceDrain(boolean drain) {
+      log("Setting sequence drain to " + drain);
+      sequenceDrain = drain;
+      if (gui != null) {
+         gui.profile().getSettings(AutoLase.class).putBoolean(SEQUENCE_DRAIN, drain);
+      }
+      if (densityThread != null && densityThread.getCamera() instanceof MMCamera) {
+         ((MMCamera) densityThread.getCamera()).setSequenceDrain(drain);
+      }
+   }
+
+   public boolean isSequenceDrain() {
+      return sequenceDrain;
+   }
+
    /**
     * Change the camera to the specified one.
     *
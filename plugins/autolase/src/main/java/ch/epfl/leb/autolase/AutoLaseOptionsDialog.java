@@ -27,6 +27,7 @@ public class AutoLaseOptionsDialog extends javax.swing.JDialog {
       jtfMinStep.setText(String.valueOf(lc.minStep));
       jtfMinVoltage.setText(String.valueOf(lc.minValue));
       jtfStartVoltage.setText(String.valueOf(lc.startValue));
+      jcbSequenceDrain.setSelected(AutoLase.INSTANCE.isSequenceDrain());
 
    }
 
@@ -70,6 +71,7 @@ public class AutoLaseOptionsDialog extends javax.swing.JDialog {
       jLabel8 = new javax.swing.JLabel();
       jtfFifoNumel = new javax.swing.JTextField();
       jLabel9 = new javax.swing.JLabel();
+      jcbSequenceDrain = new javax.swing.JCheckBox();
 
       setDefaultCloseOperation(javax.swing.WindowConstants.DISPOSE_ON_CLOSE);
 
@@ -212,6 +214,10 @@ public class AutoLaseOptionsDialog extends javax.swing.JDialog {
       jLabel9.setForeground(new java.awt.Color(255, 0, 0));
       jLabel9.setText("NOT WORKING YET!");
 
+      jcbSequenceDrain.setText("Process every frame");
+      jcbSequenceDrain.setToolTipText("Take every frame of a sequence from the circular "
+            + "buffer. Only use when nothing else (acquisition, live mode) reads the buffer.");
+
       javax.swing.GroupLayout jPanel2Layout = new javax.swing.GroupLayout(jPanel2);
       jPanel2.setLayout(jPanel2Layout);
       jPanel2Layout.setHorizontalGroup(
@@ -234,7 +240,10 @@ public class AutoLaseOptionsDialog extends javax.swing.JDialog {
                               .addGroup(jPanel2Layout.createSequentialGroup()
                                     .addGap(36, 36, 36)
                                     .addComponent(jLabel9)
-                                    .addGap(0, 43, Short.MAX_VALUE)))
+                                    .addGap(0, 43, Short.MAX_VALUE))
+                              .addGroup(jPanel2Layout.createSequentialGroup()
+                                    .addContainerGap()
+                                    .addComponent(jcbSequenceDrain)))
                         .addContainerGap())
       );
       jPanel2Layout.setVerticalGroup(
@@ -256,7 +265,9 @@ public class AutoLaseOptionsDialog extends javax.swing.JDialog {
                                     javax.swing.GroupLayout.PREFERRED_SIZE))
                         .addPreferredGap(javax.swing.LayoutStyle.ComponentPlacement.UNRELATED)
                         .addComponent(jLabel9)
-                        .addContainerGap(123, Short.MAX_VALUE))
+                        .addPreferredGap(javax.swing.LayoutStyle.ComponentPlacement.UNRELATED)
+                        .addComponent(jcbSequenceDrain)
+                        .addContainerGap(96, Short.MAX_VALUE))
       );
 
       jTabbedPane1.addTab("Density monitor", jPanel2);
@@ -306,6 +317,7 @@ public class AutoLaseOptionsDialog extends javax.swing.JDialog {
          lc.minStep = Double.valueOf(jtfMinStep.getText());
          lc.minValue = Double.valueOf(jtfMinVoltage.getText());
          lc.startValue = Double.valueOf(jtfStartVoltage.getText());
+         AutoLase.INSTANCE.setSequenceDrain(jcbSequenceDrain.isSelected());
       } catch (NumberFormatException e) {
          JOptionPane.showMessageDialog(this,
                "Make sure Vmin, Vmax, Vstart and min step are numbers");
@@ -386,6 +398,7 @@ public class AutoLaseOptionsDialog extends javax.swing.JDialog {
    private javax.swing.JTabbedPane jTabbedPane1;
    private javax.swing.JButton jbCancel;
    private javax.swing.JButton jbOK;
+   private javax.swing.JCheckBox jcbSequenceDrain;
    private javax.swing.JTextField jtfDeviceName;
    private javax.swing.JTextField jtfFifoNumel;
    private javax.swing.JTextField jtfMaxVoltage;
@@ -41,4 +41,35 @@ public interface Camera {
     * @return
     */
    public boolean isAcquiring();
+
+   /**
+    * Returns true if the camera can hand out every frame of a running
+    * sequence acquisition through {@link #pollSequenceImage()}, instead of
+    * only the latest one.
+    *
+    * @return true if sequence drain mode is available
+    */
+   default boolean supportsSequenceDrain() {
+      return false;
+   }
+
+   /**
+    * Returns the number of sequence frames that have not been handed out
+    * by {@link #pollSequenceImage()} yet.
+    *
+    * @return number of pending frames
+    */
+   default int getRemainingImageCount() {
+      return 0;
+   }
+
+   /**
+    * Returns the oldest sequence frame that has not been handed out yet.
+    *
+    * @return next frame, or null if there is none
+    * @throws Exception can happen.
+    */
+   default short[] pollSequenceImage() throws Exception {
+      return null;
+   }
 }
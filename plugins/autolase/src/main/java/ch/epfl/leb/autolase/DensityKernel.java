@@ -0,0 +1,188 @@
+package ch.epfl.leb.autolase;
+
+import java.util.concurrent.RecursiveAction;
+
+/**
+ * Fused density kernel used by the DensityThread. A single pass over the
+ * image thresholds each pixel, updates the "on time" accumulator and keeps
+ * track of the running maximum.
+ *
+ * <p>The accumulator is double-buffered: every frame reads the previous map
+ * and writes the next one, after which the two buffers are swapped. The map
+ * returned by {@link #getDensityMap()} is therefore never written to while the
+ * following frame is processed, and can be handed to monitors without copying.
+ *
+ * <p>Large images can optionally be split into row bands that are processed
+ * in parallel. No memory is allocated per frame once the buffers have been
+ * sized for the current image.
+ *
+ * @author Thomas Pengo
+ */
+public class DensityKernel {
+   /**
+    * Images with fewer pixels than this are always processed serially, the
+    * overhead of forking outweighs the gain.
+    */
+   public static final int MIN_PARALLEL_PIXELS = 128 * 128;
+
+   private final int parallelism;
+
+   private float[] previous = null;
+   private float[] current = null;
+   private int width = 0;
+   private int height = 0;
+
+   private BandTask[] bands = new BandTask[0];
+
+   /**
+    * Creates a serial kernel.
+    */
+   public DensityKernel() {
+      this(1);
+   }
+
+   /**
+    * Creates a kernel that splits the image into (at most) the given number of
+    * row bands.
+    *
+    * @param parallelism number of row bands, 1 for serial processing
+    */
+   public DensityKernel(int parallelism) {
+      this.parallelism = Math.max(1, parallelism);
+   }
+
+   /**
+    * Discards the accumulated state. The next frame starts a new map.
+    */
+   public void reset() {
+      previous = null;
+      current = null;
+      width = 0;
+      height = 0;
+   }
+
+   /**
+    * Processes one frame.
+    *
+    * <p>For every pixel: A_i = (I_i &gt; t) (increment + A_i-1), where the
+    * pixel values are interpreted as unsigned 16-bit integers.
+    *
+    * @param image     pixels of the new frame, row major
+    * @param width     width of the frame
+    * @param height    height of the frame
+    * @param threshold pixels above this value are considered "on"
+    * @param increment time (ms) to add to every pixel that is on
+    * @return maximum of the updated accumulator
+    */
+   public float process(short[] image, int width, int height, int threshold,
+         float increment) {
+      if (image.length < width * height) {
+         throw new IllegalArgumentException("Image is smaller than "
+               + width + "x" + height);
+      }
+      if (previous == null || width != this.width || height != this.height) {
+         // Reset accumulator if image size has changed
+         previous = new float[width * height];
+         current = new float[width * height];
+         this.width = width;
+         this.height = height;
+         prepareBands();
+      }
+
+      float max;
+      if (bands.length <= 1) {
+         max = accumulate(image, previous, current, 0, width * height,
+               threshold, increment);
+      } else {
+         for (BandTask band : bands) {
+            band.reinitialize();
+            band.image = image;
+            band.threshold = threshold;
+            band.increment = increment;
+         }
+         // fork all but the first band, do the first band on this thread
+         for (int i = 1; i < bands.length; i++) {
+            bands[i].fork();
+         }
+         bands[0].invoke();
+         max = bands[0].max;
+         for (int i = 1; i < bands.length; i++) {
+            bands[i].join();
+            max = Math.max(max, bands[i].max);
+         }
+         for (BandTask band : bands) {
+            band.image = null;
+         }
+      }
+
+      float[] tmp = previous;
+      previous = current;
+      current = tmp;
+      return max;
+   }
+
+   /**
+    * Returns the latest density map. The array is owned by the kernel: it is
+    * valid until the frame after next has been processed.
+    *
+    * @return latest density map, or null if no frame has been processed yet
+    */
+   public float[] getDensityMap() {
+      return previous;
+   }
+
+   public int getWidth() {
+      return width;
+   }
+
+   public int getHeight() {
+      return height;
+   }
+
+   private void prepareBands() {
+      int numBands = width * height < MIN_PARALLEL_PIXELS ? 1
+            : Math.min(parallelism, height);
+      bands = new BandTask[numBands];
+      int rowsPerBand = height / numBands;
+      int extraRows = height % numBands;
+      int row = 0;
+      for (int i = 0; i < numBands; i++) {
+         int rows = rowsPerBand + (i < extraRows ? 1 : 0);
+         bands[i] = new BandTask(row * width, (row + rows) * width);
+         row += rows;
+      }
+   }
+
+   private static float accumulate(short[] image, float[] in, float[] out,
+         int from, int to, int threshold, float increment) {
+      float max = 0;
+      for (int i = from; i < to; i++) {
+         float a = (image[i] & 0xffff) > threshold ? in[i] + increment : 0.0f;
+         out[i] = a;
+         if (a > max) {
+            max = a;
+         }
+      }
+      return max;
+   }
+
+   private final class BandTask extends RecursiveAction {
+      private final int from;
+      private final int to;
+      private short[] image;
+      private int threshold;
+      private float increment;
+      private float max;
+
+      private BandTask(int from, int to) {
+         this.from = from;
+         this.to = to;
+      }
+
+      @Override
+      protected void compute() {
+         max = accumulate(image, previous, current, from, to, threshold,
+               increment);
+      }
+   }
+}
@@ -3,6 +3,9 @@ package ch.epfl.leb.autolase;
 /**
  * An interface for the density listeners.
  *
+ * <p>The density array is owned by the DensityThread and is reused for later
+ * frames; implementations must copy it if they need it after returning.
+ *
  * @author Thomas Pengo
  */
 interface DensityMapMonitor {
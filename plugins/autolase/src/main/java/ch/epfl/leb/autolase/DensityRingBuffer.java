@@ -0,0 +1,74 @@
+package ch.epfl.leb.autolase;
+
+/**
+ * Fixed size ring buffer of primitive doubles that keeps a running sum, used
+ * for the moving average of the density. Adding a value never allocates.
+ *
+ * @author Thomas Pengo
+ */
+public class DensityRingBuffer {
+   private final double[] values;
+   private int start = 0;
+   private int size = 0;
+   private double sum = 0;
+
+   /**
+    * Creates an empty ring buffer.
+    *
+    * @param capacity maximum number of values kept
+    */
+   public DensityRingBuffer(int capacity) {
+      if (capacity < 1) {
+         throw new IllegalArgumentException("Capacity must be at least 1");
+      }
+      values = new double[capacity];
+   }
+
+   /**
+    * Adds a value, evicting the oldest one when the buffer is full.
+    *
+    * @param value value to add
+    */
+   public void add(double value) {
+      if (size == values.length) {
+         sum -= values[start];
+         values[start] = value;
+         start = (start + 1) % values.length;
+         if (start == 0) {
+            // Recompute once per revolution so rounding errors cannot build up
+            sum = 0;
+            for (double v : values) {
+               sum += v;
+            }
+            return;
+         }
+      } else {
+         values[(start + size) % values.length] = value;
+         size++;
+      }
+      sum += value;
+   }
+
+   /**
+    * Returns the mean of the values currently in the buffer.
+    *
+    * @return mean, or 0 when the buffer is empty
+    */
+   public double mean() {
+      return size == 0 ? 0 : sum / size;
+   }
+
+   public int size() {
+      return size;
+   }
+
+   public int capacity() {
+      return values.length;
+   }
+
+   public void clear() {
+      start = 0;
+      size = 0;
+      sum = 0;
+   }
+}
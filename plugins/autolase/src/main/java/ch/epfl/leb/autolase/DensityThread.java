@@ -1,10 +1,9 @@
 package ch.epfl.leb.autolase;
 
-import java.util.ArrayDeque;
 import java.util.ArrayList;
 import java.util.Collections;
 import java.util.List;
-import java.util.Queue;
+import java.util.concurrent.CopyOnWriteArrayList;
 import java.util.logging.Level;
 import java.util.logging.Logger;
 
@@ -14,6 +13,11 @@ import java.util.logging.Logger;
  * to the maximum time a certain pixel is "on", or above a certain threshold.
  * The density is calculated as a moving average (default 1s).
  *
+ * <p>If the camera supports sequence drain mode, every frame acquired since the
+ * previous tick is processed, otherwise only the latest one. The density maps
+ * handed to DensityMapMonitors are owned by this thread and must be copied by
+ * monitors that want to keep them.
+ *
  * <p>The code only works for 2 bytes per pixel cameras for now.
  *
  * @author Thomas Pengo
@@ -34,7 +38,12 @@ public class DensityThread implements Runnable {
    long timeInterval = DEFAULT_WAIT_TIME;
    int fifoNumElems = NUM_ELEMS;
 
-   Queue<Double> densityFifo = new ArrayDeque<Double>(fifoNumElems);
+   DensityRingBuffer densityFifo = new DensityRingBuffer(fifoNumElems);
+
+   DensityKernel kernel = new DensityKernel(
+         Runtime.getRuntime().availableProcessors());
+   double tickDensity = 0;
+   volatile boolean resetKernel = false;
 
    List<DensityMonitor> monitors =
          Collections.synchronizedList(new ArrayList<DensityMonitor>());
@@ -53,7 +62,8 @@ public class DensityThread implements Runnable {
       monitors.clear();
    }
 
-   List<DensityMapMonitor> mapMonitors = new ArrayList<DensityMapMonitor>();
+   List<DensityMapMonitor> mapMonitors =
+         new CopyOnWriteArrayList<DensityMapMonitor>();
 
    public void addDensityMapMonitor(DensityMapMonitor m) {
       if (!mapMonitors.contains(m)) {
@@ -79,6 +89,7 @@ public class DensityThread implements Runnable {
 
    public void setCamera(Camera camera) {
       this.camera = camera;
+      resetKernel = true;
    }
 
    public Camera getCamera() {
@@ -107,9 +118,6 @@ public class DensityThread implements Runnable {
 
    @Override
    public void run() {
-      // Current image
-      float[] accumulator = null;
-
       // Start timer
       long lastTime = System.currentTimeMillis();
 
@@ -121,72 +129,32 @@ public class DensityThread implements Runnable {
 
          // Check if we're in sequence acquisition
          if (running && camera.isAcquiring()) {
-            // Get the current image
             try {
-               short[] image = camera.getNewImage();
-
-               // Reset accumulator if image size has changed
-               if (image != null && accumulator != null
-                     && (image.length != accumulator.length)) {
-                  accumulator = null;
+               if (resetKernel) {
+                  resetKernel = false;
+                  kernel.reset();
                }
-
-               // Threshold the image
-               boolean[] curMask = new boolean[image.length];
-               for (int i = 0; i < curMask.length; i++) {
-                  curMask[i] = image[i] > threshold;
-               }
-
-               // Calculate accumulator
-               if (accumulator == null) {
-                  // A_0 = I_0 > t;
-                  accumulator = new float[image.length];
-                  for (int i = 0; i < accumulator.length; i++) {
-                     if (curMask[i]) {
-                        accumulator[i] = timeInterval;
-                     }
+               long now = System.currentTimeMillis();
+               boolean updated = camera.supportsSequenceDrain()
+                     ? processSequenceImages(now - lastTime)
+                     : processImage(camera.getNewImage(), timeInterval);
+               lastTime = now;
+
+               if (updated) {
+                  // Moving average estimate
+                  densityFifo.add(tickDensity);
+                  currentDensity = densityFifo.mean();
+
+                  for (DensityMonitor m : monitors) {
+                     m.densityChanged(currentDensity);
                   }
-               } else {
-                  // A_i = (I_i > t) (1 + A_i-1)
-                  for (int i = 0; i < accumulator.length; i++) {
-                     if (!curMask[i]) {
-                        accumulator[i] = 0;
-                     } else {
-                        accumulator[i] += timeInterval;
-                     }
-                  }
-               }
 
-               // Density measure: max(A_i)
-               double curd = 0;
-               for (int i = 0; i < image.length; i++) {
-                  if (accumulator[i] > curd) {
-                     curd = accumulator[i];
+                  float[] map = kernel.getDensityMap();
+                  for (DensityMapMonitor m : mapMonitors) {
+                     m.densityMapChanged(kernel.getWidth(), kernel.getHeight(), map);
                   }
                }
 
-               // Moving average estimate
-               if (densityFifo.size() == fifoNumElems) {
-                  densityFifo.remove();
-               }
-               densityFifo.offer(curd);
-
-               double meanDensity = 0;
-               for (Double d : densityFifo) {
-                  meanDensity += d;
-               }
-               meanDensity /= densityFifo.size();
-
-               currentDensity = meanDensity;
-
-               for (DensityMonitor m : monitors) {
-                  m.densityChanged(currentDensity);
-               }
-
-               for (DensityMapMonitor m : mapMonitors) {
-                  m.densityMapChanged(camera.getWidth(), camera.getHeight(), accumulator);
-               }
-
             } catch (Exception ex) {
                Logger.getLogger(DensityThread.class.getName()).log(Level.SEVERE, null, ex);
             }
@@ -203,4 +171,41 @@ public class DensityThread implements Runnable {
 
       stopping = false;
    }
+
+   /**
+    * Drains all frames the camera acquired since the last tick. The elapsed
+    * time is spread evenly over the drained frames, and the density of the
+    * tick is the maximum over all of them, so that short bursts of activation
+    * between two ticks are not missed.
+    */
+   private boolean processSequenceImages(long elapsed) throws Exception {
+      int pending = camera.getRemainingImageCount();
+      if (pending <= 0) {
+         return false;
+      }
+      float increment = (float) Math.max(elapsed, 1) / pending;
+      float max = 0;
+      int processed = 0;
+      for (int i = 0; i < pending; i++) {
+         short[] image = camera.pollSequenceImage();
+         if (image == null) {
+            break;
+         }
+         max = Math.max(max, kernel.process(image, camera.getWidth(),
+               camera.getHeight(), threshold, increment));
+         processed++;
+      }
+      tickDensity = max;
+      return processed > 0;
+   }
+
+   private boolean processImage(short[] image, float increment) {
+      if (image == null) {
+         return false;
+      }
+      // Density measure: max(A_i)
+      tickDensity = kernel.process(image, camera.getWidth(), camera.getHeight(),
+            threshold, increment);
+      return true;
+   }
 }
@@ -10,6 +10,7 @@ import mmcorej.CMMCore;
 public class MMCamera implements Camera {
 
    CMMCore core;
+   volatile boolean sequenceDrain = false;
 
    /**
     * Creates a new camera which wraps around the default MicroManager class.
@@ -20,6 +21,18 @@ public class MMCamera implements Camera {
       this.core = core;
    }
 
+   /**
+    * Enables or disables sequence drain mode. When enabled, frames are popped
+    * from the core's circular buffer so that none is missed. Only enable this
+    * when nothing else (acquisition engine, live mode) consumes the circular
+    * buffer, since popped frames are no longer available to anyone else.
+    *
+    * @param sequenceDrain true to pop every frame from the circular buffer
+    */
+   public void setSequenceDrain(boolean sequenceDrain) {
+      this.sequenceDrain = sequenceDrain;
+   }
+
    /**
     * Returns the latest image from the camera in form of an array of shorts.
     *
@@ -49,4 +62,22 @@ public class MMCamera implements Camera {
    public boolean isAcquiring() {
       return core.isSequenceRunning();
    }
+
+   @Override
+   public boolean supportsSequenceDrain() {
+      return sequenceDrain;
+   }
+
+   @Override
+   public int getRemainingImageCount() {
+      return sequenceDrain ? core.getRemainingImageCount() : 0;
+   }
+
+   @Override
+   public short[] pollSequenceImage() throws Exception {
+      if (!sequenceDrain || core.getRemainingImageCount() == 0) {
+         return null;
+      }
+      return (short[]) core.popNextImage();
+   }
 }
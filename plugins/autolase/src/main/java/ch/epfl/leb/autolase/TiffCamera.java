@@ -11,6 +11,13 @@ import ij.io.Opener;
 import java.io.IOException;
 
 /**
+ * Camera that plays back the frames of a stack.
+ *
+ * <p>In replay mode the stack is treated as a recorded sequence acquisition:
+ * frames become available through {@link #advance(int)} and are handed out
+ * once each, in order, through the sequence drain interface. This makes it
+ * possible to drive the DensityThread deterministically from a known stack.
+ *
  * @author pengo
  */
 public class TiffCamera implements Camera {
@@ -18,6 +25,11 @@ public class TiffCamera implements Camera {
    ImageStack stack;
    ImagePlus win;
 
+   int slice = 1;
+   boolean replay = false;
+   int acquired = 0;
+   int replayed = 0;
+
    public TiffCamera(java.io.File path) throws IOException {
       win = new Opener().openTiff(path.getParent(), path.getName());
       stack = win.getImageStack();
@@ -25,15 +37,48 @@ public class TiffCamera implements Camera {
       win.show();
    }
 
+   /**
+    * Creates a camera playing back the given stack, without showing it.
+    *
+    * @param stack frames to play back
+    */
+   public TiffCamera(ImageStack stack) {
+      this.stack = stack;
+   }
+
+   /**
+    * Enables or disables replay mode, and rewinds the replay.
+    *
+    * @param replay true to hand out the frames through sequence drain
+    */
+   public synchronized void setReplay(boolean replay) {
+      this.replay = replay;
+      acquired = 0;
+      replayed = 0;
+   }
+
+   /**
+    * Simulates the acquisition of more frames in replay mode. The number of
+    * acquired frames never exceeds the stack size.
+    *
+    * @param frames number of frames that were acquired
+    */
+   public synchronized void advance(int frames) {
+      acquired = Math.min(stack.getSize(), acquired + frames);
+   }
+
    @Override
    public short[] getNewImage() throws Exception {
-      if (win.getSlice() < stack.getSize()) {
-         win.setSlice(win.getSlice() + 1);
+      if (slice < stack.getSize()) {
+         slice++;
       } else {
-         win.setSlice(1);
+         slice = 1;
+      }
+      if (win != null) {
+         win.setSlice(slice);
       }
 
-      return (short[]) stack.getPixels(win.getSlice());
+      return (short[]) stack.getPixels(slice);
    }
 
    @Override
@@ -48,10 +93,10 @@ public class TiffCamera implements Camera {
 
    @Override
    public int getBytesPerPixel() {
-      if (stack.getPixels(win.getSlice()) instanceof short[]) {
+      if (stack.getPixels(slice) instanceof short[]) {
          return 2;
       }
-      if (stack.getPixels(win.getSlice()) instanceof char[]) {
+      if (stack.getPixels(slice) instanceof byte[]) {
          return 1;
       } else {
          return 4;
@@ -63,4 +108,23 @@ public class TiffCamera implements Camera {
       return true;
    }
 
+   @Override
+   public boolean supportsSequenceDrain() {
+      return replay;
+   }
+
+   @Override
+   public synchronized int getRemainingImageCount() {
+      return replay ? acquired - replayed : 0;
+   }
+
+   @Override
+   public synchronized short[] pollSequenceImage() throws Exception {
+      if (!replay || replayed >= acquired) {
+         return null;
+      }
+      replayed++;
+      return (short[]) stack.getPixels(replayed);
+   }
+
 }
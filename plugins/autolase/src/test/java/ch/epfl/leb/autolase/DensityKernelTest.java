@@ -0,0 +1,153 @@
+package ch.epfl.leb.autolase;
+
+import ij.ImageStack;
+import ij.process.ShortProcessor;
+import java.util.Random;
+import org.junit.Test;
+import static org.junit.Assert.*;
+
+/**
+ * Tests for the fused density kernel, the moving average and the replay of a
+ * stack through the DensityThread.
+ */
+public class DensityKernelTest {
+   private static final int WIDTH = 256;
+   private static final int HEIGHT = 200;
+   private static final int THRESHOLD = 500;
+
+   private static short[] randomImage(Random random) {
+      short[] image = new short[WIDTH * HEIGHT];
+      for (int i = 0; i < image.length; i++) {
+         // mostly dark, some bright, a few above 32767
+         int r = random.nextInt(100);
+         image[i] = (short) (r < 70 ? random.nextInt(THRESHOLD)
+               : r < 98 ? THRESHOLD + random.nextInt(20000)
+               : 40000 + random.nextInt(20000));
+      }
+      return image;
+   }
+
+   // The original three pass implementation, with unsigned pixel values
+   private static float reference(short[] image, float[] accumulator,
+         float increment) {
+      boolean[] mask = new boolean[image.length];
+      for (int i = 0; i < mask.length; i++) {
+         mask[i] = (image[i] & 0xffff) > THRESHOLD;
+      }
+      for (int i = 0; i < accumulator.length; i++) {
+         if (!mask[i]) {
+            accumulator[i] = 0;
+         } else {
+            accumulator[i] += increment;
+         }
+      }
+      float max = 0;
+      for (float a : accumulator) {
+         max = Math.max(max, a);
+      }
+      return max;
+   }
+
+   private static void checkAgainstReference(DensityKernel kernel) {
+      Random random = new Random(42);
+      float[] expected = new float[WIDTH * HEIGHT];
+      for (int frame = 0; frame < 20; frame++) {
+         short[] image = randomImage(random);
+         float increment = 10 + frame;
+         float expectedMax = reference(image, expected, increment);
+         float max = kernel.process(image, WIDTH, HEIGHT, THRESHOLD, increment);
+         assertEquals(expectedMax, max, 0.0f);
+         assertArrayEquals(expected, kernel.getDensityMap(), 0.0f);
+      }
+   }
+
+   @Test
+   public void testSerialMatchesReference() {
+      checkAgainstReference(new DensityKernel());
+   }
+
+   @Test
+   public void testParallelMatchesReference() {
+      checkAgainstReference(new DensityKernel(7));
+   }
+
+   @Test
+   public void testSizeChangeResets() {
+      DensityKernel kernel = new DensityKernel();
+      short[] on = new short[WIDTH * HEIGHT];
+      java.util.Arrays.fill(on, (short) 1000);
+      kernel.process(on, WIDTH, HEIGHT, THRESHOLD, 5);
+      kernel.process(on, WIDTH, HEIGHT, THRESHOLD, 5);
+      assertEquals(10, kernel.getDensityMap()[0], 0.0f);
+      kernel.process(on, HEIGHT, WIDTH, THRESHOLD, 5);
+      assertEquals(5, kernel.getDensityMap()[0], 0.0f);
+   }
+
+   @Test
+   public void testRingBufferMean() {
+      DensityRingBuffer buffer = new DensityRingBuffer(4);
+      assertEquals(0, buffer.mean(), 0.0);
+      buffer.add(1);
+      buffer.add(2);
+      assertEquals(1.5, buffer.mean(), 1e-12);
+      for (int i = 3; i <= 10; i++) {
+         buffer.add(i);
+      }
+      assertEquals(4, buffer.size());
+      assertEquals((7 + 8 + 9 + 10) / 4.0, buffer.mean(), 1e-12);
+   }
+
+   @Test
+   public void testReplayDrainsEveryFrame() throws Exception {
+      final int frames = 30;
+      ImageStack stack = new ImageStack(WIDTH, HEIGHT);
+      for (int f = 0; f < frames; f++) {
+         short[] pixels = new short[WIDTH * HEIGHT];
+         // A single frame burst, which only shows up when every frame is processed
+         pixels[1] = (short) (f == frames / 2 ? 1000 : 0);
+         stack.addSlice(new ShortProcessor(WIDTH, HEIGHT, pixels, null));
+      }
+      final TiffCamera camera = new TiffCamera(stack);
+      camera.setReplay(true);
+
+      DensityThread densityThread = new DensityThread(camera);
+      densityThread.setTimeInterval(5);
+      final float[] lastMap = new float[WIDTH * HEIGHT];
+      densityThread.addDensityMapMonitor(new DensityMapMonitor() {
+         @Override
+         public void densityMapChanged(int width, int height, float[] density) {
+            System.arraycopy(density, 0, lastMap, 0, lastMap.length);
+         }
+      });
+      final double[] maxDensity = new double[1];
+      densityThread.addDensityMonitor(new DensityMonitor() {
+         @Override
+         public void densityChanged(double density) {
+            maxDensity[0] = Math.max(maxDensity[0], density);
+         }
+      });
+      Thread thread = new Thread(densityThread);
+      thread.start();
+      try {
+         for (int f = 0; f < frames; f += 7) {
+            camera.advance(7);
+            Thread.sleep(10);
+         }
+         long deadline = System.currentTimeMillis() + 5000;
+         while (camera.getRemainingImageCount() > 0
+               && System.currentTimeMillis() < deadline) {
+            Thread.sleep(5);
+         }
+      } finally {
+         // Lets the last tick finish notifying the monitors
+         densityThread.stop();
+         thread.join(5000);
+      }
+      assertFalse(thread.isAlive());
+      assertEquals(0, camera.getRemainingImageCount());
+      // The burst raised the density reported by the thread ...
+      assertTrue(maxDensity[0] > 0);
+      // ... and was cleared by the frames that followed it
+      assertEquals(0, lastMap[1], 0.0f);
+   }
+}
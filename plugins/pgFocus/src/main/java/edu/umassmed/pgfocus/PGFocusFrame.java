@@ -11,6 +11,15 @@ import java.awt.Insets;
 import java.awt.event.ActionEvent;
 import java.awt.event.ActionListener;
 import java.text.DecimalFormat;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.Date;
+import java.util.List;
+import java.util.Map;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.atomic.AtomicBoolean;
 import java.util.logging.Level;
 import java.util.logging.Logger;
 import java.util.prefs.Preferences;
@@ -26,7 +35,7 @@ import javax.swing.JTabbedPane;
 import javax.swing.JTextField;
 import javax.swing.JToggleButton;
 import javax.swing.SwingConstants;
-import javax.swing.Timer;
+import javax.swing.SwingUtilities;
 import mmcorej.CMMCore;
 import mmcorej.DeviceType;
 import org.jfree.chart.ChartFactory;
@@ -45,6 +54,7 @@ import org.jfree.data.time.TimeSeriesCollection;
 import org.jfree.data.xy.XYDataset;
 import org.jfree.data.xy.XYSeries;
 import org.jfree.data.xy.XYSeriesCollection;
+import org.micromanager.PropertyPoller;
 import org.micromanager.Studio;
 import org.micromanager.internal.utils.ReportingUtils;
 
@@ -92,6 +102,16 @@ public class PGFocusFrame extends JFrame {
 
    private String savedCalibrationCurve = "";
 
+   // The lock state is not a property, it is read here instead of on the
+   // property poller thread
+   private final ExecutorService focusLockExecutor_ =
+         Executors.newSingleThreadExecutor(runnable -> {
+            Thread thread = new Thread(runnable, "pgFocus lock state");
+            thread.setDaemon(true);
+            return thread;
+         });
+   private final AtomicBoolean focusLockPending_ = new AtomicBoolean(false);
+
    /**
     * Creates pgFocus.
     */
@@ -141,22 +161,67 @@ public class PGFocusFrame extends JFrame {
    }
 
 
-   class PGFocusPanel extends JPanel implements ActionListener {
+   /**
+    * Reads a set of pgFocus properties in the background at a given period,
+    * using the shared property poller. Only to be used on the Event Dispatch
+    * Thread.
+    */
+   class PropertyPoll {
+      private final String[] properties_;
+      private final PropertyPoller.Listener listener_;
+      private final List<PropertyPoller.Subscription> subscriptions_ = new ArrayList<>();
+      private int periodMs_;
+
+      PropertyPoll(int periodMs, PropertyPoller.Listener listener, String... properties) {
+         periodMs_ = periodMs;
+         listener_ = listener;
+         properties_ = properties;
+      }
+
+      boolean isRunning() {
+         return !subscriptions_.isEmpty();
+      }
+
+      void start() {
+         if (isRunning()) {
+            return;
+         }
+         for (String property : properties_) {
+            subscriptions_.add(
+                  gui_.propertyPoller().subscribe(pgFocus_, property, periodMs_, listener_));
+         }
+      }
+
+      void stop() {
+         for (PropertyPoller.Subscription subscription : subscriptions_) {
+            subscription.cancel();
+         }
+         subscriptions_.clear();
+      }
+
+      void setDelay(int periodMs) {
+         periodMs_ = periodMs;
+         for (PropertyPoller.Subscription subscription : subscriptions_) {
+            subscription.setPeriodMs(periodMs);
+         }
+      }
+   }
+
+   class PGFocusPanel extends JPanel {
       private static final long serialVersionUID = 1L;
       CMMCore core_;
       int waitTime = getIntProperty("Wait ms after Message");
-      /**
-       * Timer to refresh graph after every 1 second.
-       */
-      Timer timer = new Timer(waitTime, this);
-
-      public void actionPerformed(ActionEvent actionevent) {
-         updateGraph();
-      }
 
       public static final int SUBPLOT_COUNT = 4;
+      private final List<String> seriesProperties = Arrays.asList(
+            "Offset", "Standard Deviation nM", "Output nM", "Input nM");
+      /**
+       * Reads the graphed values every "Wait ms after Message".
+       */
+      final PropertyPoll poll = new PropertyPoll(waitTime, this::onValue,
+            "Offset", "Standard Deviation nM", "Output nM", "Input nM",
+            "Wait ms after Message");
       private TimeSeriesCollection[] datasets;
-      private double[] lastValue;
 
       public PGFocusPanel(CMMCore core) {
 
@@ -166,9 +231,6 @@ public class PGFocusFrame extends JFrame {
 
          core_ = core;
 
-         timer.setInitialDelay(1000);
-
-         lastValue = new double[SUBPLOT_COUNT];
          CombinedDomainXYPlot combineddomainxyplot = new CombinedDomainXYPlot(new DateAxis("Time"));
 
          datasets = new TimeSeriesCollection[4];
@@ -224,32 +286,41 @@ public class PGFocusFrame extends JFrame {
          chartpanel.setPreferredSize(new Dimension(800, 500));
          chartpanel.setBorder(BorderFactory.createEmptyBorder(5, 5, 5, 5));
 
-         timer.start();
+         poll.start();
 
       }
 
-      private void updateGraph() {
-         // adjust timer delay
-         int waitTime = getIntProperty("Wait ms after Message");
-         timer.setDelay(waitTime);
-
-         focusLockButton();
-
-         lastValue[0] = getFloatProperty("Offset");
-
-         lastValue[1] = getFloatProperty("Standard Deviation nM");
-
-         lastValue[2] = getFloatProperty("Output nM");
-
-         lastValue[3] = getFloatProperty("Input nM");
-
-         for (int i = 0; i < SUBPLOT_COUNT; i++) {
-            datasets[i].getSeries(0).add(new Millisecond(), lastValue[i]);
+      /**
+       * Called on the property poller thread with each new value.
+       */
+      private void onValue(PropertyPoller.Value value) {
+         if (value.getProperty().equals("Wait ms after Message")) {
+            // adjust polling period
+            final int waitTime = parseInt(value);
+            if (waitTime > 0) {
+               SwingUtilities.invokeLater(() -> poll.setDelay(waitTime));
+            }
+            return;
          }
+         final int series = seriesProperties.indexOf(value.getProperty());
+         if (series == 0) {
+            updateFocusLockButton();
+         }
+         final float floatVal;
+         try {
+            floatVal = parseFloat(value);
+         } catch (Exception ex) {
+            ReportingUtils.logError(
+                  "pgFocus: Error reading values from pgFocus: " + value.getProperty());
+            return;
+         }
+         final Millisecond time = new Millisecond(new Date(value.getTimeMs()));
+         SwingUtilities.invokeLater(() ->
+               datasets[series].getSeries(0).addOrUpdate(time, floatVal));
       }
    }
 
-   class LightPanel extends JPanel implements ActionListener {
+   class LightPanel extends JPanel {
 
       private static final long serialVersionUID = 1L;
 
@@ -263,14 +334,10 @@ public class PGFocusFrame extends JFrame {
       int waitTime = getIntProperty("Wait ms after Light");
 
       /**
-       * Timer to refresh graph after every 1 second.
+       * Reads the light profile every "Wait ms after Light".
        */
-      final Timer timer = new Timer(waitTime, this);
-
-      public void actionPerformed(ActionEvent actionevent) {
-         updateGraph();
-      }
-
+      final PropertyPoll poll = new PropertyPoll(waitTime, this::onValue,
+            "Light Profile", "Wait ms after Light");
 
       public LightPanel(CMMCore core) {
 
@@ -279,8 +346,6 @@ public class PGFocusFrame extends JFrame {
 
          core_ = core;
 
-         timer.setInitialDelay(5000);
-
          lightProfile = new XYSeries(title);
 
          lightProfileSet = new XYSeriesCollection(lightProfile);
@@ -320,18 +385,31 @@ public class PGFocusFrame extends JFrame {
          lightPanel.setPreferredSize(new Dimension(800, 50));
          lightPanel.setBorder(BorderFactory.createEmptyBorder(5, 5, 5, 5));
 
-         timer.start();
+         poll.start();
 
       }
 
-      private void updateGraph() {
-
-         // adjust timer delay
-         int waitTime = getIntProperty("Wait ms after Light");
-         timer.setDelay(waitTime);
+      /**
+       * Called on the property poller thread with each new value.
+       */
+      private void onValue(PropertyPoller.Value value) {
+         if (value.getProperty().equals("Wait ms after Light")) {
+            // adjust polling period
+            final int waitTime = parseInt(value);
+            if (waitTime > 0) {
+               SwingUtilities.invokeLater(() -> poll.setDelay(waitTime));
+            }
+            return;
+         }
+         final String light = value.getValue();
+         if (light == null) {
+            ReportingUtils.logError("pgFocus: Error reading the light profile from pgFocus");
+            return;
+         }
+         SwingUtilities.invokeLater(() -> updateGraph(light));
+      }
 
-         // get light profile
-         String light = getStringProperty("Light Profile");
+      private void updateGraph(String light) {
 
          String[] lightSplit = light.split(",");
 
@@ -348,7 +426,7 @@ public class PGFocusFrame extends JFrame {
 
    }
 
-   class CalibratePanel extends JPanel implements ActionListener {
+   class CalibratePanel extends JPanel {
 
       private static final long serialVersionUID = 1L;
 
@@ -359,21 +437,20 @@ public class PGFocusFrame extends JFrame {
 
       CMMCore core_;
 
+      // Latest values of the polled properties
+      private final Map<String, String> latest = new ConcurrentHashMap<>();
+
       /**
-       * Timer to refresh graph after every 1 second.
+       * Reads the calibration results every 2 seconds while calibrating. The
+       * results are checked after each round of reads, which ends with the Slope.
        */
-      private Timer timer = new Timer(2000, this);
-
-      public void actionPerformed(ActionEvent actionevent) {
-         updateGraph();
-      }
-
+      private final PropertyPoll poll = new PropertyPoll(2000, this::onValue,
+            "Focus Mode", "Calibration curve", "Residuals", "Intercept", "Slope");
 
       public CalibratePanel(CMMCore core) {
          super(new BorderLayout());
          String title = "Calibration Profile";
          core_ = core;
-         timer.setInitialDelay(2000);
          calibrateProfile = new XYSeries(title);
          calibrateProfileSet = new XYSeriesCollection(calibrateProfile);
          JFreeChart calibrateChart = ChartFactory.createXYLineChart(
@@ -410,13 +487,11 @@ public class PGFocusFrame extends JFrame {
          calibratePanel.setPreferredSize(new Dimension(800, 50));
          calibratePanel.setBorder(BorderFactory.createEmptyBorder(5, 5, 5, 5));
 
-         updateValues();
+         updateValues(getStringProperty("Calibration curve"), getStringProperty("Focus Mode"));
 
       }
 
-      private boolean updateValues() {
-         String curve = getStringProperty("Calibration curve");
-
+      private boolean updateValues(String curve, String focusMode) {
          try {
             if (curve.length() > 0) {
 
@@ -424,7 +499,7 @@ public class PGFocusFrame extends JFrame {
                   return false;
                }
 
-               if (getStringProperty("Focus Mode").equals("Calibration")) {
+               if ("Calibration".equals(focusMode)) {
                   return false;
                }
 
@@ -455,17 +530,35 @@ public class PGFocusFrame extends JFrame {
          return true;
       }
 
-      private void updateGraph() {
+      /**
+       * Called on the property poller thread with each new value.
+       */
+      private void onValue(PropertyPoller.Value value) {
+         if (value.getValue() == null) {
+            ReportingUtils.logError(
+                  "pgFocus: Error reading values from pgFocus: " + value.getProperty());
+            return;
+         }
+         latest.put(value.getProperty(), value.getValue());
+         if (value.getProperty().equals("Slope")) {
+            SwingUtilities.invokeLater(this::updateGraph);
+         }
+      }
 
-         if (updateValues()) {
-            timer.stop();
+      private void updateGraph() {
+         // a round may have been read before the poll was stopped
+         if (!poll.isRunning()) {
+            return;
+         }
+         if (updateValues(latest.get("Calibration curve"), latest.get("Focus Mode"))) {
+            poll.stop();
             btnCalibrateButton.setText("Calibrate");
             btnCalibrateButton.repaint();
-            lblOnResiduals.setText(getStringProperty("Residuals"));
+            lblOnResiduals.setText(latest.get("Residuals"));
             lblOnResiduals.repaint();
-            lblOnIntercept.setText(getStringProperty("Intercept"));
+            lblOnIntercept.setText(latest.get("Intercept"));
             lblOnIntercept.repaint();
-            lblOnSlope.setText(getStringProperty("Slope"));
+            lblOnSlope.setText(latest.get("Slope"));
             lblOnSlope.repaint();
          }
 
@@ -667,11 +760,11 @@ public class PGFocusFrame extends JFrame {
          public void actionPerformed(ActionEvent arg0) {
             tfOnWaitAfterMessage.setEnabled(chbUpdateRealTime.isSelected());
             if (chbUpdateRealTime.isSelected()) {
-               if (!pgFocusPanel_.timer.isRunning()) {
-                  pgFocusPanel_.timer.start();
+               if (!pgFocusPanel_.poll.isRunning()) {
+                  pgFocusPanel_.poll.start();
                }
-            } else if (pgFocusPanel_.timer.isRunning()) {
-               pgFocusPanel_.timer.stop();
+            } else if (pgFocusPanel_.poll.isRunning()) {
+               pgFocusPanel_.poll.stop();
             }
          }
       });
@@ -697,7 +790,7 @@ public class PGFocusFrame extends JFrame {
       tfOnWaitAfterMessage.addActionListener(new ActionListener() {
          public void actionPerformed(ActionEvent arg0) {
             setStringProperty("Wait ms after Message", tfOnWaitAfterMessage.getText());
-            pgFocusPanel_.timer.setDelay(Integer.parseInt(tfOnWaitAfterMessage.getText()));
+            pgFocusPanel_.poll.setDelay(Integer.parseInt(tfOnWaitAfterMessage.getText()));
          }
       });
       tfOnWaitAfterMessage.setColumns(5);
@@ -739,11 +832,11 @@ public class PGFocusFrame extends JFrame {
          public void actionPerformed(ActionEvent arg0) {
             tfOnWaitAfterLight.setEnabled(chbUpdateLight.isSelected());
             if (chbUpdateLight.isSelected()) {
-               if (!lightPanel_.timer.isRunning()) {
-                  lightPanel_.timer.start();
+               if (!lightPanel_.poll.isRunning()) {
+                  lightPanel_.poll.start();
                }
-            } else if (lightPanel_.timer.isRunning()) {
-               lightPanel_.timer.stop();
+            } else if (lightPanel_.poll.isRunning()) {
+               lightPanel_.poll.stop();
             }
          }
       });
@@ -768,7 +861,7 @@ public class PGFocusFrame extends JFrame {
       tfOnWaitAfterLight.addActionListener(new ActionListener() {
          public void actionPerformed(ActionEvent arg0) {
             setStringProperty("Wait ms after Light", tfOnWaitAfterLight.getText());
-            lightPanel_.timer.setDelay(Integer.parseInt(tfOnWaitAfterLight.getText()));
+            lightPanel_.poll.setDelay(Integer.parseInt(tfOnWaitAfterLight.getText()));
          }
       });
       tfOnWaitAfterLight.setColumns(5);
@@ -925,7 +1018,8 @@ public class PGFocusFrame extends JFrame {
                try {
                   setStringProperty("Focus Mode", "Calibration");
                   btnCalibrateButton.setText("Processing");
-                  calibratePanel_.timer.start();
+                  calibratePanel_.latest.clear();
+                  calibratePanel_.poll.start();
                } catch (Exception e) {
                   // TODO Auto-generated catch block
                   e.printStackTrace();
@@ -943,24 +1037,47 @@ public class PGFocusFrame extends JFrame {
    public void focusLockButton() {
 
       try {
-         if (core_.isContinuousFocusEnabled() == true) {
-            if (tglbtnLockButton.getText().compareTo("Locked") != 0) {
-               tglbtnLockButton.setText("Locked");
-               tglbtnLockButton.setSelected(true);
-               tglbtnLockButton.repaint();
-            }
-         } else {
-            if (tglbtnLockButton.getText().compareTo("Unlocked") != 0) {
-               tglbtnLockButton.setText("Unlocked");
-               tglbtnLockButton.setSelected(false);
-               tglbtnLockButton.repaint();
-            }
-         }
+         showFocusLock(core_.isContinuousFocusEnabled());
       } catch (Exception e) {
          e.printStackTrace();
       }
    }
 
+   /**
+    * Reads the focus lock state in the background, unless a read is already
+    * pending, and shows it on the Event Dispatch Thread.
+    */
+   void updateFocusLockButton() {
+      if (!focusLockPending_.compareAndSet(false, true)) {
+         return;
+      }
+      focusLockExecutor_.execute(() -> {
+         focusLockPending_.set(false);
+         try {
+            final boolean locked = core_.isContinuousFocusEnabled();
+            SwingUtilities.invokeLater(() -> showFocusLock(locked));
+         } catch (Exception e) {
+            e.printStackTrace();
+         }
+      });
+   }
+
+   void showFocusLock(boolean locked) {
+      if (locked) {
+         if (tglbtnLockButton.getText().compareTo("Locked") != 0) {
+            tglbtnLockButton.setText("Locked");
+            tglbtnLockButton.setSelected(true);
+            tglbtnLockButton.repaint();
+         }
+      } else {
+         if (tglbtnLockButton.getText().compareTo("Unlocked") != 0) {
+            tglbtnLockButton.setText("Unlocked");
+            tglbtnLockButton.setSelected(false);
+            tglbtnLockButton.repaint();
+         }
+      }
+   }
+
    public void safePrefs() {
 
       prefs_.putInt(FRAMEXPOS, this.getX());
@@ -1001,26 +1118,30 @@ public class PGFocusFrame extends JFrame {
       return (0);
    }
 
-   float getFloatProperty(String property) {
-      try {
-
-         String val;
-
-         val = core_.getProperty(pgFocus_, property);
-         if (val.equals("NA")) {
-            return 0;
-         }
-
-         float floatVal = Float.parseFloat(val);
-
-         return (floatVal);
+   /**
+    * Parses a polled value; "NA" is read as 0.
+    *
+    * @throws Exception if the value could not be read or parsed
+    */
+   static float parseFloat(PropertyPoller.Value value) throws Exception {
+      if (value.getValue() == null) {
+         throw value.getError();
+      }
+      if (value.getValue().equals("NA")) {
+         return 0;
+      }
+      return Float.parseFloat(value.getValue());
+   }
 
+   /**
+    * Parses a polled integer value, returning 0 if it could not be read.
+    */
+   static int parseInt(PropertyPoller.Value value) {
+      try {
+         return Math.round(parseFloat(value));
       } catch (Exception ex) {
-         ReportingUtils.showError(
-               "pgFocus::getFloatValue() Error reading values from pgFocus: " + property);
+         return 0;
       }
-
-      return (0);
    }
 
    String getStringProperty(String property) {